@@ -497,6 +497,317 @@ int ompi_comm_create ( ompi_communicator_t *comm, ompi_group_t *group,
     return ompi_comm_create_w_info (comm, group, NULL, newcomm);
 }
 
+/**********************************************************************/
+/**********************************************************************/
+/**********************************************************************/
+/*
+ * Cache of split communicators. A split with the ompi_comm_split_cache
+ * info key keeps a reference on the new communicator in its parent.
+ * Once the user frees it, the communicator stays dormant with its group,
+ * CID and collective modules, and an identical split of the same parent
+ * (same color or split type and same key on every process) hands it
+ * back instead of allocating a CID and selecting the collectives again.
+ * The info of the split is part of the match, since it sets assertions
+ * such as mpi_assert_allow_overtaking that cannot be undone on a live
+ * communicator. The processes agree on the reuse with one allreduce
+ * over the parent, a process without a match makes all of them miss.
+ *
+ * Every split with the info key takes the next sequence number of the
+ * parent, so that the processes can check they reuse the communicator
+ * of the same earlier split. The info key must therefore be set on all
+ * the processes of the parent or on none of them.
+ */
+
+typedef struct ompi_comm_split_cache_item_t {
+    opal_list_item_t super;
+    bool by_type;
+    /* color, or split type */
+    int split;
+    int key;
+    int seq;
+    /* info given to the split, and the info and assertions of the
+     * communicator when it was created */
+    opal_info_t *info;
+    opal_info_t *comm_info;
+    uint32_t assertions;
+    uint32_t flags;
+    ompi_communicator_t *comm;
+} ompi_comm_split_cache_item_t;
+
+static void ompi_comm_split_cache_item_destruct (ompi_comm_split_cache_item_t *item)
+{
+    if (NULL != item->info) {
+        OBJ_RELEASE(item->info);
+    }
+    if (NULL != item->comm_info) {
+        OBJ_RELEASE(item->comm_info);
+    }
+}
+
+static OBJ_CLASS_INSTANCE(ompi_comm_split_cache_item_t, opal_list_item_t, NULL,
+                          ompi_comm_split_cache_item_destruct);
+
+/* flags in which a dormant communicator differs from a new one */
+#define OMPI_COMM_SPLIT_CACHE_FLAGS (OMPI_COMM_ISFREED | OMPI_COMM_NAMEISSET | OMPI_COMM_SPLIT_CACHED)
+
+struct ompi_comm_split_cache_t {
+    opal_list_t items;
+    int next_seq;
+};
+
+static bool ompi_comm_split_cache_requested (ompi_communicator_t *comm, opal_info_t *info)
+{
+    bool value = false;
+    int flag = 0;
+
+    if (0 >= ompi_comm_split_cache_size || NULL == info || OMPI_COMM_IS_INTER(comm)) {
+        return false;
+    }
+
+    opal_info_get_bool (info, "ompi_comm_split_cache", &value, &flag);
+    return flag && value;
+}
+
+/* a dormant communicator is freed and only referenced by the cache */
+static bool ompi_comm_split_cache_dormant (ompi_communicator_t *comm)
+{
+    return OMPI_COMM_IS_FREED(comm) && 1 == comm->super.s_base.obj_reference_count;
+}
+
+/* same keys with the same values, looked up in the cached copy b */
+static bool ompi_comm_split_cache_info_equal (opal_info_t *a, opal_info_t *b)
+{
+    opal_info_entry_t *entry;
+    opal_cstring_t *value;
+    bool equal;
+    int flag;
+
+    if (opal_list_get_size (&a->super) != opal_list_get_size (&b->super)) {
+        return false;
+    }
+
+    OPAL_LIST_FOREACH(entry, &a->super, opal_info_entry_t) {
+        opal_info_get (b, entry->ie_key->string, &value, &flag);
+        if (!flag) {
+            return false;
+        }
+        equal = 0 == strcmp (entry->ie_value->string, value->string);
+        OBJ_RELEASE(value);
+        if (!equal) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* copy an info with the reference counts of its keys, which decide what
+ * MPI_Comm_get_info returns */
+static int ompi_comm_split_cache_info_copy (opal_info_t *src, opal_info_t *dst)
+{
+    opal_info_entry_t *entry, *copy;
+
+    OPAL_LIST_FOREACH(entry, &src->super, opal_info_entry_t) {
+        copy = OBJ_NEW(opal_info_entry_t);
+        if (NULL == copy) {
+            return OMPI_ERR_OUT_OF_RESOURCE;
+        }
+        copy->ie_key = entry->ie_key;
+        OBJ_RETAIN(copy->ie_key);
+        copy->ie_value = entry->ie_value;
+        OBJ_RETAIN(copy->ie_value);
+        copy->ie_referenced = entry->ie_referenced;
+        copy->ie_internal = entry->ie_internal;
+        opal_list_append (&dst->super, &copy->super);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+/* a communicator whose assertions changed after the split, for instance
+ * with MPI_Comm_set_info, is not the one a new split would create */
+static bool ompi_comm_split_cache_match (ompi_comm_split_cache_item_t *item, bool by_type,
+                                         int split, int key, opal_info_t *info)
+{
+    ompi_communicator_t *comm = item->comm;
+
+    return item->by_type == by_type && item->split == split && item->key == key &&
+        ompi_comm_split_cache_dormant (comm) && item->assertions == comm->c_assertions &&
+        item->flags == (comm->c_flags & ~OMPI_COMM_SPLIT_CACHE_FLAGS) &&
+        ompi_comm_split_cache_info_equal (info, item->info);
+}
+
+/*
+ * Take the next sequence number of the parent and return the most recent
+ * dormant communicator of an identical split, if any.
+ */
+static ompi_comm_split_cache_item_t *ompi_comm_split_cache_find (ompi_communicator_t *comm, bool by_type,
+                                                                 int split, int key, opal_info_t *info,
+                                                                 int *seq)
+{
+    struct ompi_comm_split_cache_t *cache = comm->c_split_cache;
+    ompi_comm_split_cache_item_t *item;
+
+    if (NULL == cache) {
+        cache = (struct ompi_comm_split_cache_t *) malloc (sizeof (*cache));
+        if (NULL == cache) {
+            *seq = -1;
+            return NULL;
+        }
+        OBJ_CONSTRUCT(&cache->items, opal_list_t);
+        cache->next_seq = 0;
+        comm->c_split_cache = cache;
+    }
+
+    *seq = cache->next_seq++;
+
+    OPAL_LIST_FOREACH_REV(item, &cache->items, ompi_comm_split_cache_item_t) {
+        if (ompi_comm_split_cache_match (item, by_type, split, key, info)) {
+            return item;
+        }
+    }
+
+    return NULL;
+}
+
+/* reuse only if every process found the communicator of the same split */
+static int ompi_comm_split_cache_agree (ompi_communicator_t *comm, ompi_comm_split_cache_item_t **item)
+{
+    int tmp[2], rc;
+
+    tmp[0] = NULL != *item ? (*item)->seq : -1;
+    tmp[1] = -tmp[0];
+    rc = comm->c_coll->coll_allreduce (MPI_IN_PLACE, tmp, 2, MPI_INT, MPI_MAX, comm,
+                                       comm->c_coll->coll_allreduce_module);
+    if (OMPI_SUCCESS != rc || tmp[0] != -tmp[1] || tmp[0] < 0) {
+        *item = NULL;
+    }
+
+    return rc;
+}
+
+/*
+ * Hand back a dormant communicator, reset to what a new split of the
+ * parent with the same info would produce.
+ */
+static int ompi_comm_split_cache_reuse (ompi_communicator_t *comm, ompi_comm_split_cache_item_t *item,
+                                        ompi_communicator_t **newcomm)
+{
+    ompi_communicator_t *newcomp = item->comm;
+
+    /* ompi_comm_free() released the attributes and the info. The info
+     * of the split, with the defaults of the subscribed keys, set the
+     * assertions the communicator still has. */
+    if (NULL != newcomp->super.s_info) {
+        OBJ_RELEASE(newcomp->super.s_info);
+    }
+    newcomp->super.s_info = OBJ_NEW(opal_info_t);
+    if (NULL == newcomp->super.s_info ||
+        OMPI_SUCCESS != ompi_comm_split_cache_info_copy (item->comm_info, newcomp->super.s_info)) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    OBJ_RETAIN(newcomp);
+    newcomp->c_flags &= ~(OMPI_COMM_ISFREED | OMPI_COMM_NAMEISSET);
+
+    OBJ_RELEASE(newcomp->error_handler);
+    newcomp->error_handler = comm->error_handler;
+    newcomp->errhandler_type = comm->errhandler_type;
+    OBJ_RETAIN(newcomp->error_handler);
+
+    /* Set name for debugging purposes */
+    if (item->by_type) {
+        snprintf(newcomp->c_name, MPI_MAX_OBJECT_NAME, "MPI COMM %s SPLIT_TYPE FROM %s",
+                 ompi_comm_print_cid (newcomp), ompi_comm_print_cid (comm));
+    } else {
+        snprintf(newcomp->c_name, MPI_MAX_OBJECT_NAME, "MPI COMM %s SPLIT FROM %s",
+                 ompi_comm_print_cid (newcomp), ompi_comm_print_cid (comm));
+    }
+
+    OPAL_OUTPUT_VERBOSE((10, ompi_comm_output, "reusing cached communicator %s split from %s",
+                         ompi_comm_print_cid (newcomp), ompi_comm_print_cid (comm)));
+
+    *newcomm = newcomp;
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Keep a new communicator in the cache of its parent. A full cache makes
+ * room by releasing its oldest dormant communicator.
+ */
+static void ompi_comm_split_cache_insert (ompi_communicator_t *comm, bool by_type, int split, int key,
+                                          opal_info_t *info, int seq, ompi_communicator_t *newcomm)
+{
+    struct ompi_comm_split_cache_t *cache = comm->c_split_cache;
+    ompi_comm_split_cache_item_t *item, *victim = NULL;
+
+    if (NULL == cache || 0 > seq || OMPI_COMM_IS_INTER(newcomm) || OMPI_COMM_IS_EXTRA_RETAIN(newcomm)) {
+        return;
+    }
+
+    if ((int) opal_list_get_size (&cache->items) >= ompi_comm_split_cache_size) {
+        OPAL_LIST_FOREACH(item, &cache->items, ompi_comm_split_cache_item_t) {
+            if (ompi_comm_split_cache_dormant (item->comm)) {
+                victim = item;
+                break;
+            }
+        }
+        if (NULL == victim) {
+            return;
+        }
+        opal_list_remove_item (&cache->items, &victim->super);
+        OBJ_RELEASE(victim->comm);
+        OBJ_RELEASE(victim);
+    }
+
+    item = OBJ_NEW(ompi_comm_split_cache_item_t);
+    if (NULL == item) {
+        return;
+    }
+    item->by_type = by_type;
+    item->split = split;
+    item->key = key;
+    item->seq = seq;
+    item->info = OBJ_NEW(opal_info_t);
+    item->comm_info = OBJ_NEW(opal_info_t);
+    if (NULL == item->info || NULL == item->comm_info) {
+        OBJ_RELEASE(item);
+        return;
+    }
+    if (OMPI_SUCCESS != opal_info_dup (info, &item->info) ||
+        (NULL != newcomm->super.s_info &&
+         OMPI_SUCCESS != ompi_comm_split_cache_info_copy (newcomm->super.s_info, item->comm_info))) {
+        OBJ_RELEASE(item);
+        return;
+    }
+    item->assertions = newcomm->c_assertions;
+    item->flags = newcomm->c_flags & ~OMPI_COMM_SPLIT_CACHE_FLAGS;
+    item->comm = newcomm;
+    OBJ_RETAIN(newcomm);
+    newcomm->c_flags |= OMPI_COMM_SPLIT_CACHED;
+    opal_list_append (&cache->items, &item->super);
+}
+
+void ompi_comm_split_cache_flush (ompi_communicator_t *comm)
+{
+    struct ompi_comm_split_cache_t *cache = comm->c_split_cache;
+    ompi_comm_split_cache_item_t *item;
+
+    if (NULL == cache) {
+        return;
+    }
+    comm->c_split_cache = NULL;
+
+    while (NULL != (item = (ompi_comm_split_cache_item_t *) opal_list_remove_first (&cache->items))) {
+        /* a communicator still in use is released normally when freed */
+        item->comm->c_flags &= ~OMPI_COMM_SPLIT_CACHED;
+        OBJ_RELEASE(item->comm);
+        OBJ_RELEASE(item);
+    }
+    OBJ_DESTRUCT(&cache->items);
+    free (cache);
+}
+
 /**********************************************************************/
 /**********************************************************************/
 /**********************************************************************/
@@ -518,9 +829,26 @@ int ompi_comm_split_with_info( ompi_communicator_t* comm, int color, int key,
     ompi_communicator_t *newcomp = NULL;
     int *lranks=NULL, *rranks=NULL;
     ompi_group_t * local_group=NULL, *remote_group=NULL;
+    ompi_comm_split_cache_item_t *cached = NULL;
+    bool use_cache;
+    int seq = -1;
 
     ompi_comm_allgatherfct *allgatherfct=NULL;
 
+    /* Step 0: reuse a dormant communicator of an identical split */
+    /* --------------------------------------------------------- */
+    use_cache = !pass_on_topo && ompi_comm_split_cache_requested (comm, info);
+    if ( use_cache ) {
+        cached = ompi_comm_split_cache_find (comm, false, color, key, info, &seq);
+        rc = ompi_comm_split_cache_agree (comm, &cached);
+        if ( OMPI_SUCCESS != rc ) {
+            return rc;
+        }
+        if ( NULL != cached ) {
+            return ompi_comm_split_cache_reuse (comm, cached, newcomm);
+        }
+    }
+
     /* Step 1: determine all the information for the local group */
     /* --------------------------------------------------------- */
 
@@ -738,6 +1066,10 @@ int ompi_comm_split_with_info( ompi_communicator_t* comm, int color, int key,
         ompi_comm_free ( &newcomp );
     }
 
+    if ( use_cache && OMPI_SUCCESS == rc && NULL != newcomp && MPI_COMM_NULL != newcomp ) {
+        ompi_comm_split_cache_insert (comm, false, color, key, info, seq, newcomp);
+    }
+
     *newcomm = newcomp;
     return rc;
 }
@@ -1177,8 +1509,11 @@ int ompi_comm_split_type (ompi_communicator_t *comm, int split_type, int key,
 {
     bool need_split = false, no_reorder = false, no_undefined = false;
     int inter;
-    int global_split_type, global_orig_split_type, ok[2], tmp[6];
+    int global_split_type, global_orig_split_type, ok[2], tmp[8];
     int rc;
+    ompi_comm_split_cache_item_t *cached = NULL;
+    bool use_cache;
+    int seq = -1;
     int orig_split_type = split_type;
     int flag;
     opal_cstring_t *value = NULL;
@@ -1240,13 +1575,25 @@ int ompi_comm_split_type (ompi_communicator_t *comm, int split_type, int key,
      */
     tmp[4] = split_type;
     tmp[5] = -split_type;
+    /* The same reduction tells whether every rank has a dormant communicator
+     * of an identical split, see ompi_comm_split_cache_agree() */
+    use_cache = ompi_comm_split_cache_requested (comm, info);
+    if (use_cache) {
+        cached = ompi_comm_split_cache_find (comm, true, split_type, key, info, &seq);
+    }
+    tmp[6] = NULL != cached ? cached->seq : -1;
+    tmp[7] = -tmp[6];
 
-    rc = comm->c_coll->coll_allreduce (MPI_IN_PLACE, &tmp, 6, MPI_INT, MPI_MAX, comm,
+    rc = comm->c_coll->coll_allreduce (MPI_IN_PLACE, &tmp, 8, MPI_INT, MPI_MAX, comm,
                                       comm->c_coll->coll_allreduce_module);
     if (OPAL_UNLIKELY(OMPI_SUCCESS != rc)) {
         return rc;
     }
 
+    if (NULL != cached && tmp[6] == -tmp[7]) {
+        return ompi_comm_split_cache_reuse (comm, cached, newcomm);
+    }
+
     global_orig_split_type = tmp[0];
     global_split_type = tmp[4];
 
@@ -1302,14 +1649,20 @@ int ompi_comm_split_type (ompi_communicator_t *comm, int split_type, int key,
 
     if (MPI_COMM_TYPE_HW_UNGUIDED == global_orig_split_type) {
         /* Handle MPI_COMM_TYPE_HW_UNGUIDED communicator split. */
-        return ompi_comm_split_unguided( comm, split_type,
-                                         key, need_split, no_reorder,
-                                         no_undefined, info, newcomm );
+        rc = ompi_comm_split_unguided( comm, split_type,
+                                       key, need_split, no_reorder,
+                                       no_undefined, info, newcomm );
     } else {
-        return ompi_comm_split_type_core( comm, global_split_type, split_type,
-                                          key, need_split, no_reorder,
-                                          no_undefined, info, newcomm);
+        rc = ompi_comm_split_type_core( comm, global_split_type, split_type,
+                                        key, need_split, no_reorder,
+                                        no_undefined, info, newcomm);
+    }
+
+    if (use_cache && OMPI_SUCCESS == rc && MPI_COMM_NULL != *newcomm) {
+        ompi_comm_split_cache_insert (comm, true, split_type, key, info, seq, *newcomm);
     }
+
+    return rc;
 }
 
 /**********************************************************************/
@@ -2216,6 +2569,12 @@ int ompi_comm_free( ompi_communicator_t **comm )
         OBJ_RELEASE((*comm)->super.s_info);
     }
 
+    /* A cached split keeps its group, CID and collectives in the cache of
+       its parent until an identical split reuses it */
+    if ( OMPI_COMM_IS_SPLIT_CACHED(*comm) ) {
+        (*comm)->c_flags |= OMPI_COMM_ISFREED;
+    }
+
     /* Release the communicator */
     if ( OMPI_COMM_IS_DYNAMIC (*comm) ) {
         ompi_comm_num_dyncomm --;
@@ -339,6 +339,17 @@ static int ompi_comm_finalize (void)
     /* disconnect all dynamic communicators */
     ompi_dpm_dyn_finalize();
 
+    /* Release the cached splits first: the loop below releases the
+       remaining communicators in CID order, which may reach a cached
+       communicator before its parent */
+    max = ompi_comm_get_num_communicators();
+    for ( i=0; i<max; i++ ) {
+        comm = ompi_comm_lookup(i);
+        if ( NULL != comm ) {
+            ompi_comm_split_cache_flush(comm);
+        }
+    }
+
     if (ompi_comm_intrinsic_init) {
         /* tear down MPI-3 predefined communicators (not initialized unless using MPI_Init) */
         OBJ_DESTRUCT( &ompi_mpi_comm_self );
@@ -449,6 +460,7 @@ static void ompi_comm_construct(ompi_communicator_t* comm)
     comm->c_pml_comm     = NULL;
     comm->bsend_buffer   = NULL;
     comm->c_topo         = NULL;
+    comm->c_split_cache  = NULL;
     comm->c_coll         = NULL;
     comm->c_nbc_tag      = MCA_COLL_BASE_TAG_NONBLOCKING_BASE;
     comm->instance       = NULL;
@@ -496,6 +508,11 @@ static void ompi_comm_destruct(ompi_communicator_t* comm)
        MPI_COMM_DISCONNECT).  See the lengthy comment in
        communicator/comm.c in ompi_comm_free() for the reasons why. */
 
+    /* Release the communicators cached by splits of this one */
+    if (NULL != comm->c_split_cache) {
+        ompi_comm_split_cache_flush(comm);
+    }
+
     /* Release the collective module */
 
     if ( NULL != comm->c_coll ) {
@@ -72,6 +72,7 @@ OMPI_DECLSPEC OBJ_CLASS_DECLARATION(ompi_communicator_t);
 #define OMPI_COMM_EXTRA_RETAIN 0x00004000
 #define OMPI_COMM_MAPBY_NODE   0x00008000
 #define OMPI_COMM_GLOBAL_INDEX 0x00010000
+#define OMPI_COMM_SPLIT_CACHED 0x00020000
 
 /* some utility #defines */
 #define OMPI_COMM_IS_INTER(comm) ((comm)->c_flags & OMPI_COMM_INTER)
@@ -92,6 +93,7 @@ OMPI_DECLSPEC OBJ_CLASS_DECLARATION(ompi_communicator_t);
                                  OMPI_COMM_IS_DIST_GRAPH((comm)))
 #define OMPI_COMM_IS_MAPBY_NODE(comm) ((comm)->c_flags & OMPI_COMM_MAPBY_NODE)
 #define OMPI_COMM_IS_GLOBAL_INDEX(comm) ((comm)->c_flags & OMPI_COMM_GLOBAL_INDEX)
+#define OMPI_COMM_IS_SPLIT_CACHED(comm) ((comm)->c_flags & OMPI_COMM_SPLIT_CACHED)
 
 #define OMPI_COMM_SET_DYNAMIC(comm) ((comm)->c_flags |= OMPI_COMM_DYNAMIC)
 #define OMPI_COMM_SET_INVALID(comm) ((comm)->c_flags |= OMPI_COMM_INVALID)
@@ -320,6 +322,10 @@ struct ompi_communicator_t {
        if this is not a cart, graph or dist graph communicator) */
     struct mca_topo_base_module_t* c_topo;
 
+    /* Communicators split from this one with the ompi_comm_split_cache
+       info key, kept for reuse once they are freed (NULL if none) */
+    struct ompi_comm_split_cache_t *c_split_cache;
+
 #ifdef OMPI_WANT_PERUSE
     /*
      * Place holder for the PERUSE events.
@@ -993,6 +999,14 @@ OMPI_DECLSPEC int ompi_comm_split_type(ompi_communicator_t *comm,
                                        struct opal_info_t *info,
                                        ompi_communicator_t** newcomm);
 
+/**
+ * Release the communicators cached by the splits of a communicator.
+ * Called when the communicator is destroyed and at finalize.
+ *
+ * @param comm: parent communicator
+ */
+void ompi_comm_split_cache_flush(ompi_communicator_t *comm);
+
 /**
  * dup a communicator. Parameter are identical to the MPI-counterpart
  * of the function. It has been extracted, since we need to be able
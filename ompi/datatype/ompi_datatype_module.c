@@ -424,6 +424,9 @@ opal_pointer_array_t ompi_datatype_f_to_c_table = {{0}};
         /* transfer the ptypes */                                                    \
         (PDST)->super.ptypes = (PSRC)->super.ptypes;                                 \
         (PSRC)->super.ptypes = NULL;                                                 \
+        /* and the compiled pack plan */                                             \
+        (PDST)->super.plan = (PSRC)->super.plan;                                     \
+        (PSRC)->super.plan = NULL;                                                   \
     } while(0)
 
 #define DECLARE_MPI2_COMPOSED_STRUCT_DDT( PDATA, MPIDDT, MPIDDTNAME, type1, type2, MPIType1, MPIType2, FLAGS) \
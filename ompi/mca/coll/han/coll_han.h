@@ -273,6 +273,8 @@ typedef struct mca_coll_han_component_t {
      * (but disables topological optimisations)
      */
     bool han_reproducible;
+    /* provide persistent allreduce plans (MPI_Allreduce_init) */
+    bool han_persistent_plans;
     bool use_simple_algorithm[COLLCOUNT];
     int use_algorithm[COLLCOUNT];
     int use_algorithm_param[COLLCOUNT]; // MCA parmeter id for algo, to know if user provided
@@ -296,6 +298,11 @@ typedef struct mca_coll_han_component_t {
     opal_free_list_t pack_buffers;
     int64_t han_packbuf_max_count;
     int64_t han_packbuf_bytes;
+
+    /* started persistent plans, driven by mca_coll_han_plan_progress */
+    opal_list_t active_plans;
+    opal_mutex_t plan_lock;
+    opal_atomic_int32_t plan_progress_registered;
 } mca_coll_han_component_t;
 
 /*
@@ -311,6 +318,7 @@ typedef struct mca_coll_han_single_collective_fallback_s
         mca_coll_base_module_allgather_fn_t allgather;
         mca_coll_base_module_allgatherv_fn_t allgatherv;
         mca_coll_base_module_allreduce_fn_t allreduce;
+        mca_coll_base_module_allreduce_init_fn_t allreduce_init;
         mca_coll_base_module_barrier_fn_t barrier;
         mca_coll_base_module_bcast_fn_t bcast;
         mca_coll_base_module_gather_fn_t gather;
@@ -334,6 +342,7 @@ typedef struct mca_coll_han_collectives_fallback_s
     mca_coll_han_single_collective_fallback_t allgather;
     mca_coll_han_single_collective_fallback_t allgatherv;
     mca_coll_han_single_collective_fallback_t allreduce;
+    mca_coll_han_single_collective_fallback_t allreduce_init;
     mca_coll_han_single_collective_fallback_t barrier;
     mca_coll_han_single_collective_fallback_t bcast;
     mca_coll_han_single_collective_fallback_t reduce;
@@ -408,6 +417,9 @@ OBJ_CLASS_DECLARATION(mca_coll_han_module_t);
 #define previous_allreduce          fallback.allreduce.allreduce
 #define previous_allreduce_module   fallback.allreduce.module
 
+#define previous_allreduce_init         fallback.allreduce_init.allreduce_init
+#define previous_allreduce_init_module  fallback.allreduce_init.module
+
 #define previous_barrier            fallback.barrier.barrier
 #define previous_barrier_module     fallback.barrier.module
 
@@ -452,6 +464,7 @@ OBJ_CLASS_DECLARATION(mca_coll_han_module_t);
         HAN_UNINSTALL_COLL_API(COMM, HANM, gatherv);                   \
         HAN_UNINSTALL_COLL_API(COMM, HANM, reduce);                    \
         HAN_UNINSTALL_COLL_API(COMM, HANM, allreduce);                 \
+        HAN_UNINSTALL_COLL_API(COMM, HANM, allreduce_init);            \
         HAN_UNINSTALL_COLL_API(COMM, HANM, allgather);                 \
         HAN_UNINSTALL_COLL_API(COMM, HANM, allgatherv);                \
         HAN_UNINSTALL_COLL_API(COMM, HANM, alltoall);                  \
@@ -530,6 +543,17 @@ mca_coll_han_allgatherv_intra_dynamic(ALLGATHERV_BASE_ARGS,
 int
 mca_coll_han_allreduce_intra_dynamic(ALLREDUCE_BASE_ARGS,
                                      mca_coll_base_module_t *module);
+void
+mca_coll_han_allreduce_intra_select(size_t count,
+                                    struct ompi_datatype_t *dtype,
+                                    struct ompi_communicator_t *comm,
+                                    mca_coll_han_module_t *han_module,
+                                    mca_coll_base_module_allreduce_fn_t *allreduce_fn,
+                                    mca_coll_base_module_t **sub_module);
+int
+mca_coll_han_allreduce_intra_init(ALLREDUCE_INIT_ARGS);
+int
+mca_coll_han_plan_progress(void);
 int
 mca_coll_han_barrier_intra_dynamic(BARRIER_BASE_ARGS,
                                  mca_coll_base_module_t *module);
@@ -177,6 +177,7 @@ static size_t ddt_unpack_datatype(opal_datatype_t* type, uint8_t* buf)
     type->desc = type->opt_desc;
     buf += nbytes_copy;
     type->ptypes = NULL;
+    type->plan = NULL;
     return length;
 }
 
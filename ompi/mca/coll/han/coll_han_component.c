@@ -26,6 +26,7 @@
 
 #include "opal/util/show_help.h"
 #include "opal/util/argv.h"
+#include "opal/runtime/opal_progress.h"
 #include "ompi/constants.h"
 #include "ompi/mca/coll/coll.h"
 #include "coll_han.h"
@@ -139,6 +140,10 @@ static int han_open(void)
         printf("han: initializing free list got %d\n",ret);
     }
 
+    OBJ_CONSTRUCT(&mca_coll_han_component.active_plans, opal_list_t);
+    OBJ_CONSTRUCT(&mca_coll_han_component.plan_lock, opal_mutex_t);
+    mca_coll_han_component.plan_progress_registered = 0;
+
     return mca_coll_han_init_dynamic_rules();
 }
 
@@ -147,6 +152,12 @@ static int han_open(void)
  */
 static int han_close(void)
 {
+    if (mca_coll_han_component.plan_progress_registered) {
+        opal_progress_unregister(mca_coll_han_plan_progress);
+    }
+    OBJ_DESTRUCT(&mca_coll_han_component.active_plans);
+    OBJ_DESTRUCT(&mca_coll_han_component.plan_lock);
+
     mca_coll_han_free_dynamic_rules();
     mca_coll_han_free_algorithms();
 
@@ -460,6 +471,19 @@ static int han_register(void)
                                            OPAL_INFO_LVL_3,
                                            MCA_BASE_VAR_SCOPE_ALL, &cs->han_reproducible);
 
+    cs->han_persistent_plans = false;
+    (void) mca_base_component_var_register(c, "persistent_plans",
+                                           "Provide MPI_Allreduce_init. The han selection is resolved "
+                                           "once when the request is created; the hierarchical "
+                                           "algorithms become a chain of persistent reduce, allreduce "
+                                           "and bcast requests on the sub-communicators, run by the "
+                                           "progress engine, and the other selections use the "
+                                           "persistent collective of the selected component. "
+                                           "Fall back on the next component when disabled (default false)",
+                                           MCA_BASE_VAR_TYPE_BOOL, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                           OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_ALL, &cs->han_persistent_plans);
+
     cs->han_packbuf_bytes = 128*1024;
     (void) mca_base_component_var_register(c, "packbuf_bytes",
                                            "The number of bytes in each HAN packbuf.",
@@ -603,29 +603,24 @@ mca_coll_han_allgatherv_intra_dynamic(const void *sbuf, size_t scount,
  * Allreduce selector:
  * On a sub-communicator, checks the stored rules to find the module to use
  * On the global communicator, calls the han collective implementation, or
- * calls the correct module if fallback mechanism is activated
+ * calls the correct module if fallback mechanism is activated.
+ * The selection is split from the call so that persistent plans can
+ * resolve it once.
  */
-int
-mca_coll_han_allreduce_intra_dynamic(const void *sbuf,
-                                     void *rbuf,
-                                     size_t count,
-                                     struct ompi_datatype_t *dtype,
-                                     struct ompi_op_t *op,
-                                     struct ompi_communicator_t *comm,
-                                     mca_coll_base_module_t *module)
+void
+mca_coll_han_allreduce_intra_select(size_t count,
+                                    struct ompi_datatype_t *dtype,
+                                    struct ompi_communicator_t *comm,
+                                    mca_coll_han_module_t *han_module,
+                                    mca_coll_base_module_allreduce_fn_t *allreduce_fn,
+                                    mca_coll_base_module_t **sub_module_out)
 {
-    mca_coll_han_module_t *han_module = (mca_coll_han_module_t*) module;
     TOPO_LVL_T topo_lvl = han_module->topologic_level;
     mca_coll_base_module_allreduce_fn_t allreduce;
     mca_coll_base_module_t *sub_module;
     size_t dtype_size;
     int rank, verbosity = 0;
 
-    if (!han_module->enabled) {
-        return han_module->previous_allreduce(sbuf, rbuf, count, dtype, op, comm,
-                                              han_module->previous_allreduce_module);
-    }
-
     /* Compute configuration information for dynamic rules */
     ompi_datatype_type_size(dtype, &dtype_size);
     dtype_size = dtype_size * count;
@@ -681,7 +676,7 @@ mca_coll_han_allreduce_intra_dynamic(const void *sbuf,
                              "Falling back to another component\n"));
         allreduce = han_module->previous_allreduce;
         sub_module = han_module->previous_allreduce_module;
-    } else if (GLOBAL_COMMUNICATOR == topo_lvl && sub_module == module) {
+    } else if (GLOBAL_COMMUNICATOR == topo_lvl && sub_module == &han_module->super) {
         /* Reproducibility: fallback on reproducible algorithm */
         if (mca_coll_han_component.han_reproducible) {
             allreduce = mca_coll_han_allreduce_reproducible;
@@ -713,6 +708,31 @@ mca_coll_han_allreduce_intra_dynamic(const void *sbuf,
          */
         allreduce = sub_module->coll_allreduce;
     }
+
+    *allreduce_fn = allreduce;
+    *sub_module_out = sub_module;
+}
+
+int
+mca_coll_han_allreduce_intra_dynamic(const void *sbuf,
+                                     void *rbuf,
+                                     size_t count,
+                                     struct ompi_datatype_t *dtype,
+                                     struct ompi_op_t *op,
+                                     struct ompi_communicator_t *comm,
+                                     mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t*) module;
+    mca_coll_base_module_allreduce_fn_t allreduce;
+    mca_coll_base_module_t *sub_module;
+
+    if (!han_module->enabled) {
+        return han_module->previous_allreduce(sbuf, rbuf, count, dtype, op, comm,
+                                              han_module->previous_allreduce_module);
+    }
+
+    mca_coll_han_allreduce_intra_select(count, dtype, comm, han_module,
+                                        &allreduce, &sub_module);
     return allreduce(sbuf, rbuf, count, dtype,
                      op, comm, sub_module);
 }
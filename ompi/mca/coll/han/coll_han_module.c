@@ -53,6 +53,7 @@ static void han_module_clear(mca_coll_han_module_t *han_module)
     CLEAN_PREV_COLL(han_module, allgather);
     CLEAN_PREV_COLL(han_module, allgatherv);
     CLEAN_PREV_COLL(han_module, allreduce);
+    CLEAN_PREV_COLL(han_module, allreduce_init);
     CLEAN_PREV_COLL(han_module, barrier);
     CLEAN_PREV_COLL(han_module, bcast);
     CLEAN_PREV_COLL(han_module, reduce);
@@ -251,6 +252,9 @@ mca_coll_han_comm_query(struct ompi_communicator_t * comm, int *priority)
     han_module->super.coll_gatherv    = mca_coll_han_gatherv_intra_dynamic;
     han_module->super.coll_bcast      = mca_coll_han_bcast_intra_dynamic;
     han_module->super.coll_allreduce  = mca_coll_han_allreduce_intra_dynamic;
+    if (mca_coll_han_component.han_persistent_plans) {
+        han_module->super.coll_allreduce_init = mca_coll_han_allreduce_intra_init;
+    }
     han_module->super.coll_allgather  = mca_coll_han_allgather_intra_dynamic;
     if (GLOBAL_COMMUNICATOR == han_module->topologic_level) {
         /* We are on the global communicator, return topological algorithms */
@@ -305,6 +309,7 @@ mca_coll_han_module_enable(mca_coll_base_module_t * module,
     HAN_INSTALL_COLL_API(comm, han_module, allgather);
     HAN_INSTALL_COLL_API(comm, han_module, allgatherv);
     HAN_INSTALL_COLL_API(comm, han_module, allreduce);
+    HAN_INSTALL_COLL_API(comm, han_module, allreduce_init);
     HAN_INSTALL_COLL_API(comm, han_module, barrier);
     HAN_INSTALL_COLL_API(comm, han_module, bcast);
     HAN_INSTALL_COLL_API(comm, han_module, gather);
@@ -334,6 +339,7 @@ mca_coll_han_module_disable(mca_coll_base_module_t * module,
     HAN_UNINSTALL_COLL_API(comm, han_module, allgather);
     HAN_UNINSTALL_COLL_API(comm, han_module, allgatherv);
     HAN_UNINSTALL_COLL_API(comm, han_module, allreduce);
+    HAN_UNINSTALL_COLL_API(comm, han_module, allreduce_init);
     HAN_UNINSTALL_COLL_API(comm, han_module, barrier);
     HAN_UNINSTALL_COLL_API(comm, han_module, bcast);
     HAN_UNINSTALL_COLL_API(comm, han_module, gather);
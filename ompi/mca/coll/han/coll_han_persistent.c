@@ -0,0 +1,324 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ * Persistent allreduce plans. MPI_Allreduce_init resolves the han
+ * selection (dynamic rules, algorithm choice, reproducibility and
+ * fallbacks) once.
+ *
+ * When the selection is one of the hierarchical algorithms, the plan is
+ * the same three steps as mca_coll_han_allreduce_intra_simple, each one a
+ * persistent request created on a sub-communicator: a reduce on the node,
+ * an allreduce between the node leaders and a bcast on the node. MPI_Start
+ * starts the first one and mca_coll_han_plan_progress starts each of the
+ * following ones once the previous one completed, so the plan never blocks.
+ *
+ * When the selection is the collective of another module, the persistent
+ * collective of that module is used, and the other selections
+ * (reproducible or fallback) go to the previous component.
+ */
+
+#include "coll_han.h"
+#include "ompi/mca/coll/base/coll_base_util.h"
+#include "opal/runtime/opal_progress.h"
+
+#define MCA_COLL_HAN_PLAN_MAX_STAGES 3
+
+typedef struct mca_coll_han_plan_t {
+    ompi_coll_base_nbc_request_t super;
+
+    /* persistent requests on the sub-communicators, started in order */
+    ompi_request_t *stages[MCA_COLL_HAN_PLAN_MAX_STAGES];
+    int nstages;
+    /* stage in flight */
+    int stage;
+} mca_coll_han_plan_t;
+
+/* return if invoked recursively */
+static bool mca_coll_han_plan_in_progress = false;
+
+static int mca_coll_han_plan_stage_start(mca_coll_han_plan_t *plan)
+{
+    ompi_request_t *stage = plan->stages[plan->stage];
+
+    return stage->req_start(1, &plan->stages[plan->stage]);
+}
+
+/* start the stages whose predecessor completed. Return true once the
+ * last stage completed or a stage failed. */
+static bool mca_coll_han_plan_advance(mca_coll_han_plan_t *plan)
+{
+    while (REQUEST_COMPLETE(plan->stages[plan->stage])) {
+        int ret = plan->stages[plan->stage]->req_status.MPI_ERROR;
+
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != ret)) {
+            plan->super.super.req_status.MPI_ERROR = ret;
+            return true;
+        }
+        if (++plan->stage == plan->nstages) {
+            return true;
+        }
+
+        ret = mca_coll_han_plan_stage_start(plan);
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != ret)) {
+            plan->super.super.req_status.MPI_ERROR = ret;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int mca_coll_han_plan_progress(void)
+{
+    mca_coll_han_plan_t *plan, *next;
+    int completed = 0;
+
+    if (0 == opal_list_get_size(&mca_coll_han_component.active_plans)) {
+        /* no started plan -- nothing to do. do not grab a lock */
+        return 0;
+    }
+
+    OPAL_THREAD_LOCK(&mca_coll_han_component.plan_lock);
+    if (!mca_coll_han_plan_in_progress) {
+        mca_coll_han_plan_in_progress = true;
+
+        OPAL_LIST_FOREACH_SAFE(plan, next, &mca_coll_han_component.active_plans,
+                               mca_coll_han_plan_t) {
+            OPAL_THREAD_UNLOCK(&mca_coll_han_component.plan_lock);
+            if (mca_coll_han_plan_advance(plan)) {
+                OPAL_THREAD_LOCK(&mca_coll_han_component.plan_lock);
+                opal_list_remove_item(&mca_coll_han_component.active_plans,
+                                      &plan->super.super.super.super);
+                OPAL_THREAD_UNLOCK(&mca_coll_han_component.plan_lock);
+
+                ompi_request_complete(&plan->super.super, true);
+                ++completed;
+            }
+            OPAL_THREAD_LOCK(&mca_coll_han_component.plan_lock);
+        }
+        mca_coll_han_plan_in_progress = false;
+    }
+    OPAL_THREAD_UNLOCK(&mca_coll_han_component.plan_lock);
+
+    return completed;
+}
+
+static int mca_coll_han_plan_start(size_t count, ompi_request_t **requests)
+{
+    for (size_t i = 0; i < count; ++i) {
+        mca_coll_han_plan_t *plan = (mca_coll_han_plan_t *) requests[i];
+        int ret;
+
+        plan->super.super.req_state = OMPI_REQUEST_ACTIVE;
+        plan->super.super.req_complete = REQUEST_PENDING;
+        plan->super.super.req_status.MPI_ERROR = OMPI_SUCCESS;
+        plan->stage = 0;
+
+        ret = mca_coll_han_plan_stage_start(plan);
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != ret)) {
+            /* nothing is in flight: report the error on this plan and on
+             * the ones that were not started */
+            for (size_t j = i; j < count; ++j) {
+                requests[j]->req_state = OMPI_REQUEST_ACTIVE;
+                requests[j]->req_status.MPI_ERROR = ret;
+                ompi_request_complete(requests[j], true);
+            }
+            return ret;
+        }
+
+        if (mca_coll_han_plan_advance(plan)) {
+            ompi_request_complete(&plan->super.super, true);
+            continue;
+        }
+
+        OPAL_THREAD_LOCK(&mca_coll_han_component.plan_lock);
+        opal_list_append(&mca_coll_han_component.active_plans, &plan->super.super.super.super);
+        OPAL_THREAD_UNLOCK(&mca_coll_han_component.plan_lock);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+static int mca_coll_han_plan_cancel(struct ompi_request_t *request, int complete)
+{
+    return MPI_ERR_REQUEST;
+}
+
+static int mca_coll_han_plan_free(struct ompi_request_t **request)
+{
+    mca_coll_han_plan_t *plan = (mca_coll_han_plan_t *) *request;
+
+    if (!REQUEST_COMPLETE(&plan->super.super)) {
+        return MPI_ERR_REQUEST;
+    }
+
+    OMPI_REQUEST_FINI(&plan->super.super);
+    OBJ_RELEASE(plan);
+    *request = MPI_REQUEST_NULL;
+
+    return OMPI_SUCCESS;
+}
+
+static void mca_coll_han_plan_construct(mca_coll_han_plan_t *plan)
+{
+    plan->super.super.req_type = OMPI_REQUEST_COLL;
+    plan->super.super.req_start = mca_coll_han_plan_start;
+    plan->super.super.req_free = mca_coll_han_plan_free;
+    plan->super.super.req_cancel = mca_coll_han_plan_cancel;
+    plan->nstages = 0;
+    plan->stage = 0;
+}
+
+static void mca_coll_han_plan_destruct(mca_coll_han_plan_t *plan)
+{
+    for (int i = 0; i < plan->nstages; ++i) {
+        ompi_request_free(&plan->stages[i]);
+    }
+}
+
+static OBJ_CLASS_INSTANCE(mca_coll_han_plan_t, ompi_coll_base_nbc_request_t,
+                          mca_coll_han_plan_construct, mca_coll_han_plan_destruct);
+
+/* the steps of mca_coll_han_allreduce_intra_simple, as persistent requests */
+static int mca_coll_han_plan_allreduce_stages(mca_coll_han_plan_t *plan, const void *sbuf, void *rbuf,
+                                              size_t count, struct ompi_datatype_t *dtype,
+                                              struct ompi_op_t *op, ompi_info_t *info,
+                                              mca_coll_han_module_t *han_module)
+{
+    ompi_communicator_t *low_comm = han_module->sub_comm[INTRA_NODE];
+    ompi_communicator_t *up_comm = han_module->sub_comm[INTER_NODE];
+    int root_low_rank = 0, low_rank = ompi_comm_rank(low_comm);
+    const void *low_sbuf = sbuf;
+    void *low_rbuf = rbuf;
+    int ret;
+
+    /* Low_comm reduce */
+    if (MPI_IN_PLACE == sbuf && low_rank != root_low_rank) {
+        low_sbuf = rbuf;
+        low_rbuf = NULL;
+    }
+    ret = low_comm->c_coll->coll_reduce_init(low_sbuf, low_rbuf, count, dtype, op, root_low_rank,
+                                             low_comm, info, &plan->stages[plan->nstages],
+                                             low_comm->c_coll->coll_reduce_init_module);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    ++plan->nstages;
+
+    /* Local roots perform a allreduce on the upper comm */
+    if (low_rank == root_low_rank) {
+        ret = up_comm->c_coll->coll_allreduce_init(MPI_IN_PLACE, rbuf, count, dtype, op, up_comm,
+                                                   info, &plan->stages[plan->nstages],
+                                                   up_comm->c_coll->coll_allreduce_init_module);
+        if (OMPI_SUCCESS != ret) {
+            return ret;
+        }
+        ++plan->nstages;
+    }
+
+    /* Low_comm bcast */
+    ret = low_comm->c_coll->coll_bcast_init(rbuf, count, dtype, root_low_rank, low_comm, info,
+                                            &plan->stages[plan->nstages],
+                                            low_comm->c_coll->coll_bcast_init_module);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    ++plan->nstages;
+
+    return OMPI_SUCCESS;
+}
+
+int
+mca_coll_han_allreduce_intra_init(const void *sbuf,
+                                  void *rbuf,
+                                  size_t count,
+                                  struct ompi_datatype_t *dtype,
+                                  struct ompi_op_t *op,
+                                  struct ompi_communicator_t *comm,
+                                  ompi_info_t *info,
+                                  ompi_request_t **request,
+                                  mca_coll_base_module_t *module)
+{
+    mca_coll_han_module_t *han_module = (mca_coll_han_module_t*) module;
+    mca_coll_base_module_allreduce_fn_t allreduce;
+    mca_coll_base_module_t *sub_module;
+    mca_coll_han_plan_t *plan;
+    int32_t registered = 0;
+    int ret;
+
+    if (!han_module->enabled) {
+        return han_module->previous_allreduce_init(sbuf, rbuf, count, dtype, op, comm, info,
+                                                   request, han_module->previous_allreduce_init_module);
+    }
+
+    mca_coll_han_allreduce_intra_select(count, dtype, comm, han_module,
+                                        &allreduce, &sub_module);
+
+    if (allreduce != mca_coll_han_allreduce_intra_simple &&
+        allreduce != mca_coll_han_allreduce_intra) {
+        if (NULL != sub_module && sub_module != module &&
+            allreduce == sub_module->coll_allreduce &&
+            NULL != sub_module->coll_allreduce_init) {
+            /* the dynamic rules picked another module */
+            return sub_module->coll_allreduce_init(sbuf, rbuf, count, dtype, op, comm, info,
+                                                   request, sub_module);
+        }
+        /* han does not handle this configuration, let the next component
+         * provide the persistent request */
+        return han_module->previous_allreduce_init(sbuf, rbuf, count, dtype, op, comm, info,
+                                                   request, han_module->previous_allreduce_init_module);
+    }
+
+    if (!ompi_op_is_commute(op)) {
+        OPAL_OUTPUT_VERBOSE((30, mca_coll_han_component.han_output,
+                             "han cannot handle allreduce with this operation. Fall back on another component\n"));
+        return han_module->previous_allreduce_init(sbuf, rbuf, count, dtype, op, comm, info,
+                                                   request, han_module->previous_allreduce_init_module);
+    }
+
+    /* Create the subcommunicators */
+    if (OMPI_SUCCESS != mca_coll_han_comm_create_new(comm, han_module)) {
+        OPAL_OUTPUT_VERBOSE((30, mca_coll_han_component.han_output,
+                             "han cannot handle allreduce with this communicator. Drop HAN support in this communicator and fall back on another component\n"));
+        /* HAN cannot work with this communicator so fallback on all collectives */
+        HAN_LOAD_FALLBACK_COLLECTIVES(comm, han_module);
+        return han_module->previous_allreduce_init(sbuf, rbuf, count, dtype, op, comm, info,
+                                                   request, han_module->previous_allreduce_init_module);
+    }
+
+    plan = OBJ_NEW(mca_coll_han_plan_t);
+    if (NULL == plan) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    OMPI_REQUEST_INIT(&plan->super.super, true);
+    plan->super.super.req_mpi_object.comm = comm;
+    plan->super.super.req_status._cancelled = 0;
+
+    ret = mca_coll_han_plan_allreduce_stages(plan, sbuf, rbuf, count, dtype, op, info, han_module);
+    if (OMPI_SUCCESS != ret) {
+        OBJ_RELEASE(plan);
+        return ret;
+    }
+
+    if (OPAL_ATOMIC_COMPARE_EXCHANGE_STRONG_32(&mca_coll_han_component.plan_progress_registered,
+                                               &registered, 1)) {
+        opal_progress_register(mca_coll_han_plan_progress);
+    }
+
+    OPAL_OUTPUT_VERBOSE((30, mca_coll_han_component.han_output,
+                         "coll:han:allreduce_intra_init: plan of %d stages on communicator (%s/%s)\n",
+                         plan->nstages, ompi_comm_print_cid(comm), comm->c_name));
+
+    *request = &plan->super.super;
+    return OMPI_SUCCESS;
+}
@@ -29,6 +29,7 @@
 
 #include "ompi/mca/coll/coll.h"
 #include "ompi/mca/coll/base/coll_base_util.h"
+#include "opal/class/opal_hash_table.h"
 #include "opal/sys/atomic.h"
 
 BEGIN_C_DECLS
@@ -38,20 +39,6 @@ BEGIN_C_DECLS
 /* the debug level */
 #define NBC_DLEVEL 0
 
-/* enable schedule caching - undef NBC_CACHE_SCHEDULE to deactivate it */
-/* TODO: this whole schedule cache stuff does not work with the tmbuf
- * :-( - first, the tmpbuf must not be freed if a schedule using it is
- * still in the cache and second, the tmpbuf used by the schedule must
- * be attached to the handle that uses this schedule !!!!
- * I.E., THIS IS EXPERIMENTAL AND MIGHT NOT WORK */
-/* It also leaks memory because the schedule is never cleaned up when
-   the communicator is destroyed, so don't use it for now */
-#ifdef NBC_CACHE_SCHEDULE
-#undef NBC_CACHE_SCHEDULE
-#endif
-#define NBC_SCHED_DICT_UPPER 1024 /* max. number of dict entries */
-#define NBC_SCHED_DICT_LOWER 512  /* number of dict entries after wipe, if SCHED_DICT_UPPER is reached */
-
 /********************* end of LibNBC tuning parameters ************************/
 
 /* Function return codes  */
@@ -77,6 +64,7 @@ extern int libnbc_ibcast_knomial_radix;
 extern int libnbc_iexscan_algorithm;
 extern int libnbc_ireduce_algorithm;
 extern int libnbc_iscan_algorithm;
+extern int libnbc_schedule_cache_size;
 
 struct ompi_coll_libnbc_component_t {
     mca_coll_base_component_3_0_0_t super;
@@ -94,14 +82,9 @@ struct ompi_coll_libnbc_module_t {
     mca_coll_base_module_t super;
     opal_mutex_t mutex;
     bool comm_registered;
-#ifdef NBC_CACHE_SCHEDULE
-  void *NBC_Dict[NBC_NUM_COLL]; /* this should point to a struct
-                                      hb_tree, but since this is a
-                                      public header-file, this would be
-                                      an include mess :-(. So let's void
-                                      it ...*/
-  int NBC_Dict_size[NBC_NUM_COLL];
-#endif
+    int sched_cache_size;             /* max. number of cached schedules, 0 if disabled */
+    opal_hash_table_t sched_cache;    /* cached schedules, keyed by the call arguments */
+    opal_list_t sched_cache_lru;      /* cached schedules, least recently used first */
 };
 typedef struct ompi_coll_libnbc_module_t ompi_coll_libnbc_module_t;
 OBJ_CLASS_DECLARATION(ompi_coll_libnbc_module_t);
@@ -130,6 +113,7 @@ struct ompi_coll_libnbc_request_t {
     NBC_Comminfo *comminfo;
     NBC_Schedule *schedule;
     void *tmpbuf; /* temporary buffer e.g. used for Reduce */
+    struct NBC_Sched_cache_entry *sched_entry; /* cache entry owning schedule and tmpbuf (if any) */
     /* TODO: we should make a handle pointer to a state later (that the user
      * can move request handles) */
 };
@@ -102,6 +102,8 @@ static mca_base_var_enum_value_t iscan_algorithms[] = {
     {0, NULL}
 };
 
+int libnbc_schedule_cache_size = 0;         /* max. number of cached schedules per communicator */
+
 static int libnbc_open(void);
 static int libnbc_close(void);
 static int libnbc_register(void);
@@ -284,6 +286,22 @@ libnbc_register(void)
                                     &libnbc_iscan_algorithm);
     OBJ_RELEASE(new_enum);
 
+    /* Nonblocking collectives that are called over and over with the same
+     * arguments can reuse their schedule (and temporary buffer) instead of
+     * building it again on every call. Only non-persistent operations are
+     * cached; persistent ones keep their schedule anyway. */
+    libnbc_schedule_cache_size = 0;
+    (void) mca_base_component_var_register(&mca_coll_libnbc_component.super.collm_version,
+                                           "schedule_cache_size",
+                                           "Maximum number of nonblocking collective schedules cached per communicator "
+                                           "and reused by calls with identical arguments (0 disables the cache). "
+                                           "Cached schedules keep their temporary buffers and any derived datatype or "
+                                           "user-defined op they use alive until they are evicted or the communicator is freed.",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &libnbc_schedule_cache_size);
+
     return OMPI_SUCCESS;
 }
 
@@ -610,13 +628,20 @@ static void
 libnbc_module_construct(ompi_coll_libnbc_module_t *module)
 {
     OBJ_CONSTRUCT(&module->mutex, opal_mutex_t);
+    OBJ_CONSTRUCT(&module->sched_cache, opal_hash_table_t);
+    OBJ_CONSTRUCT(&module->sched_cache_lru, opal_list_t);
     module->comm_registered = false;
+    module->sched_cache_size = 0;
 }
 
 
 static void
 libnbc_module_destruct(ompi_coll_libnbc_module_t *module)
 {
+    /* release the schedules cached on this communicator */
+    NBC_Sched_cache_fini(module);
+    OBJ_DESTRUCT(&module->sched_cache_lru);
+    OBJ_DESTRUCT(&module->sched_cache);
     OBJ_DESTRUCT(&module->mutex);
 
     /* if we ever were used for a collective op, do the progress cleanup. */
@@ -707,6 +732,7 @@ request_construct(ompi_coll_libnbc_request_t *request)
     request->super.super.req_start = request_start;
     request->super.super.req_free = request_free;
     request->super.super.req_cancel = request_cancel;
+    request->sched_entry = NULL;
 }
 
 
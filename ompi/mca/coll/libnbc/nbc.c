@@ -305,10 +305,20 @@ static inline void NBC_Free (NBC_Handle* handle) {
     handle->schedule = NULL;
   }
 
-  /* if the nbc_I<collective> attached some data */
-  /* problems with schedule cache here, see comment (TODO) in
-   * nbc_internal.h */
-  if (NULL != handle->tmpbuf) {
+  if (NULL != handle->sched_entry) {
+    /* the tmpbuf belongs to the cached schedule. hand it back for the
+     * next request with the same arguments */
+    NBC_Sched_cache_entry *entry = handle->sched_entry;
+
+    handle->sched_entry = NULL;
+    handle->tmpbuf = NULL;
+    if (NULL != entry->tmpbuf) {
+      opal_atomic_wmb ();
+      entry->in_use = false;
+    }
+    OBJ_RELEASE(entry);
+  } else if (NULL != handle->tmpbuf) {
+    /* if the nbc_I<collective> attached some data */
     free((void*)handle->tmpbuf);
     handle->tmpbuf = NULL;
   }
@@ -611,52 +621,16 @@ void NBC_Return_handle(ompi_coll_libnbc_request_t *request) {
 }
 
 int  NBC_Init_comm(MPI_Comm comm, NBC_Comminfo *comminfo) {
+  int ret;
 
-#ifdef NBC_CACHE_SCHEDULE
-  /* initialize the NBC_ALLTOALL SchedCache tree */
-  comminfo->NBC_Dict[NBC_ALLTOALL] = hb_tree_new((dict_cmp_func)NBC_Alltoall_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_ALLTOALL] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_ALLTOALL]);
-  comminfo->NBC_Dict_size[NBC_ALLTOALL] = 0;
-  /* initialize the NBC_ALLGATHER SchedCache tree */
-  comminfo->NBC_Dict[NBC_ALLGATHER] = hb_tree_new((dict_cmp_func)NBC_Allgather_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_ALLGATHER] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_ALLGATHER]);
-  comminfo->NBC_Dict_size[NBC_ALLGATHER] = 0;
-  /* initialize the NBC_ALLREDUCE SchedCache tree */
-  comminfo->NBC_Dict[NBC_ALLREDUCE] = hb_tree_new((dict_cmp_func)NBC_Allreduce_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_ALLREDUCE] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_ALLREDUCE]);
-  comminfo->NBC_Dict_size[NBC_ALLREDUCE] = 0;
-  /* initialize the NBC_BARRIER SchedCache tree - is not needed -
-   * schedule is hung off directly */
-  comminfo->NBC_Dict_size[NBC_BARRIER] = 0;
-  /* initialize the NBC_BCAST SchedCache tree */
-  comminfo->NBC_Dict[NBC_BCAST] = hb_tree_new((dict_cmp_func)NBC_Bcast_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_BCAST] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_BCAST]);
-  comminfo->NBC_Dict_size[NBC_BCAST] = 0;
-  /* initialize the NBC_GATHER SchedCache tree */
-  comminfo->NBC_Dict[NBC_GATHER] = hb_tree_new((dict_cmp_func)NBC_Gather_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_GATHER] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_GATHER]);
-  comminfo->NBC_Dict_size[NBC_GATHER] = 0;
-  /* initialize the NBC_REDUCE SchedCache tree */
-  comminfo->NBC_Dict[NBC_REDUCE] = hb_tree_new((dict_cmp_func)NBC_Reduce_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_REDUCE] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_REDUCE]);
-  comminfo->NBC_Dict_size[NBC_REDUCE] = 0;
-  /* initialize the NBC_SCAN SchedCache tree */
-  comminfo->NBC_Dict[NBC_SCAN] = hb_tree_new((dict_cmp_func)NBC_Scan_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_SCAN] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_SCAN]);
-  comminfo->NBC_Dict_size[NBC_SCAN] = 0;
-  /* initialize the NBC_SCATTER SchedCache tree */
-  comminfo->NBC_Dict[NBC_SCATTER] = hb_tree_new((dict_cmp_func)NBC_Scatter_args_compare, NBC_SchedCache_args_delete_key_dummy, NBC_SchedCache_args_delete);
-  if(comminfo->NBC_Dict[NBC_SCATTER] == NULL) { printf("Error in hb_tree_new()\n"); return OMPI_ERROR;; }
-  NBC_DEBUG(1, "added tree at address %lu\n", (unsigned long)comminfo->NBC_Dict[NBC_SCATTER]);
-  comminfo->NBC_Dict_size[NBC_SCATTER] = 0;
-#endif
+  comminfo->sched_cache_size = libnbc_schedule_cache_size;
+  if (comminfo->sched_cache_size > 0) {
+    ret = opal_hash_table_init (&comminfo->sched_cache, comminfo->sched_cache_size);
+    if (OPAL_SUCCESS != ret) {
+      NBC_Error ("Error in opal_hash_table_init() (%i)", ret);
+      return ret;
+    }
+  }
 
   return OMPI_SUCCESS;
 }
@@ -716,6 +690,7 @@ int NBC_Schedule_request(NBC_Schedule *schedule, ompi_communicator_t *comm,
   handle->req_array = NULL;
   handle->comm = comm;
   handle->schedule = NULL;
+  handle->sched_entry = NULL;
   handle->row_offset = 0;
   handle->nbc_complete = persistent ? true : false;
 
@@ -754,15 +729,187 @@ int NBC_Schedule_request(NBC_Schedule *schedule, ompi_communicator_t *comm,
   return OMPI_SUCCESS;
 }
 
-#ifdef NBC_CACHE_SCHEDULE
-void NBC_SchedCache_args_delete_key_dummy(void *k) {
-    /* do nothing because the key and the data element are identical :-)
-     * both (the single one :) is freed in NBC_<COLLOP>_args_delete() */
+static void nbc_sched_cache_entry_constructor (NBC_Sched_cache_entry *entry) {
+  entry->schedule = NULL;
+  entry->tmpbuf = NULL;
+  entry->in_use = false;
 }
 
-void NBC_SchedCache_args_delete(void *entry) {
-  struct NBC_dummyarg *tmp = (struct NBC_dummyarg*)entry;
-  OBJ_RELEASE(tmp->schedule);
-  free(entry);
+static void nbc_sched_cache_entry_destructor (NBC_Sched_cache_entry *entry) {
+  if (NULL != entry->schedule) {
+    OBJ_RELEASE(entry->schedule);
+  }
+
+  free (entry->tmpbuf);
+
+  /* the schedule refers to the datatypes and the op by handle. they were
+   * retained when the entry was created so that their addresses cannot be
+   * reused by different objects while the entry is alive */
+  if (NULL != entry->key.sendtype && !ompi_datatype_is_predefined (entry->key.sendtype)) {
+    OBJ_RELEASE(entry->key.sendtype);
+  }
+  if (NULL != entry->key.recvtype && !ompi_datatype_is_predefined (entry->key.recvtype)) {
+    OBJ_RELEASE(entry->key.recvtype);
+  }
+  if (NULL != entry->key.op && !ompi_op_is_intrinsic (entry->key.op)) {
+    OBJ_RELEASE(entry->key.op);
+  }
+}
+
+OBJ_CLASS_INSTANCE(NBC_Sched_cache_entry, opal_list_item_t, nbc_sched_cache_entry_constructor,
+                   nbc_sched_cache_entry_destructor);
+
+/* drop the cache's reference on an entry. must be called with the module
+ * mutex held */
+static void nbc_sched_cache_remove (ompi_coll_libnbc_module_t *module, NBC_Sched_cache_entry *entry) {
+  opal_hash_table_remove_value_ptr (&module->sched_cache, &entry->key, sizeof (entry->key));
+  opal_list_remove_item (&module->sched_cache_lru, &entry->super);
+  OBJ_RELEASE(entry);
+}
+
+/* try to serve a nonblocking collective from the schedule cache. returns
+ * OMPI_ERR_NOT_FOUND if the caller has to build the schedule itself */
+int NBC_Sched_cache_request (ompi_coll_libnbc_module_t *module, const NBC_Sched_cache_key *key,
+                             bool persistent, ompi_communicator_t *comm, ompi_request_t **request) {
+  NBC_Sched_cache_entry *entry = NULL;
+  int ret;
+
+  /* persistent requests keep their schedule for their whole lifetime
+   * anyway */
+  if (persistent || 0 >= module->sched_cache_size) {
+    return OMPI_ERR_NOT_FOUND;
+  }
+
+  OPAL_THREAD_LOCK(&module->mutex);
+  ret = opal_hash_table_get_value_ptr (&module->sched_cache, key, sizeof (*key), (void **) &entry);
+  if (OPAL_SUCCESS != ret) {
+    OPAL_THREAD_UNLOCK(&module->mutex);
+    return OMPI_ERR_NOT_FOUND;
+  }
+
+  if (NULL != entry->tmpbuf) {
+    if (entry->in_use) {
+      /* another request with the same arguments is still running on the
+       * tmpbuf of this schedule */
+      OPAL_THREAD_UNLOCK(&module->mutex);
+      return OMPI_ERR_NOT_FOUND;
+    }
+    entry->in_use = true;
+  }
+
+  /* move the entry to the most recently used end */
+  opal_list_remove_item (&module->sched_cache_lru, &entry->super);
+  opal_list_append (&module->sched_cache_lru, &entry->super);
+  OBJ_RETAIN(entry);
+  OPAL_THREAD_UNLOCK(&module->mutex);
+
+  OBJ_RETAIN(entry->schedule);
+  ret = NBC_Schedule_request (entry->schedule, comm, module, persistent, request, entry->tmpbuf);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != ret)) {
+    OBJ_RELEASE(entry->schedule);
+    entry->in_use = false;
+    OBJ_RELEASE(entry);
+    return ret;
+  }
+
+  ((NBC_Handle *) *request)->sched_entry = entry;
+
+  return OMPI_SUCCESS;
+}
+
+/* create the request for a freshly built schedule and add the schedule to
+ * the cache (unless key is NULL). on error the caller still owns schedule
+ * and tmpbuf, exactly as with NBC_Schedule_request */
+int NBC_Schedule_request_cached (NBC_Schedule *schedule, ompi_communicator_t *comm,
+                                 ompi_coll_libnbc_module_t *module, bool persistent,
+                                 ompi_request_t **request, void *tmpbuf, const NBC_Sched_cache_key *key) {
+  NBC_Sched_cache_entry *entry, *lru;
+  void *value;
+  int ret;
+
+  ret = NBC_Schedule_request (schedule, comm, module, persistent, request, tmpbuf);
+  if (OMPI_SUCCESS != ret || persistent || NULL == key || 0 >= module->sched_cache_size ||
+      &ompi_request_empty == *request) {
+    /* schedules without any operation are not worth caching */
+    return ret;
+  }
+
+  OPAL_THREAD_LOCK(&module->mutex);
+  if (OPAL_SUCCESS == opal_hash_table_get_value_ptr (&module->sched_cache, key, sizeof (*key), &value)) {
+    /* the cached schedule was busy */
+    OPAL_THREAD_UNLOCK(&module->mutex);
+    return OMPI_SUCCESS;
+  }
+
+  if (opal_hash_table_get_size (&module->sched_cache) >= (size_t) module->sched_cache_size) {
+    /* evict the least recently used schedule that is not running */
+    OPAL_LIST_FOREACH(lru, &module->sched_cache_lru, NBC_Sched_cache_entry) {
+      if (!lru->in_use) {
+        nbc_sched_cache_remove (module, lru);
+        break;
+      }
+    }
+
+    if (opal_hash_table_get_size (&module->sched_cache) >= (size_t) module->sched_cache_size) {
+      OPAL_THREAD_UNLOCK(&module->mutex);
+      return OMPI_SUCCESS;
+    }
+  }
+
+  entry = OBJ_NEW(NBC_Sched_cache_entry);
+  if (OPAL_UNLIKELY(NULL == entry)) {
+    OPAL_THREAD_UNLOCK(&module->mutex);
+    return OMPI_SUCCESS;
+  }
+
+  entry->key = *key;
+  if (NULL != key->sendtype && !ompi_datatype_is_predefined (key->sendtype)) {
+    OBJ_RETAIN(key->sendtype);
+  }
+  if (NULL != key->recvtype && !ompi_datatype_is_predefined (key->recvtype)) {
+    OBJ_RETAIN(key->recvtype);
+  }
+  if (NULL != key->op && !ompi_op_is_intrinsic (key->op)) {
+    OBJ_RETAIN(key->op);
+  }
+
+  OBJ_RETAIN(schedule);
+  entry->schedule = schedule;
+  entry->tmpbuf = tmpbuf;
+  /* the request we just created runs on the tmpbuf */
+  entry->in_use = (NULL != tmpbuf);
+
+  ret = opal_hash_table_set_value_ptr (&module->sched_cache, &entry->key, sizeof (entry->key), entry);
+  if (OPAL_UNLIKELY(OPAL_SUCCESS != ret)) {
+    /* the request keeps ownership of the tmpbuf */
+    entry->tmpbuf = NULL;
+    OPAL_THREAD_UNLOCK(&module->mutex);
+    OBJ_RELEASE(entry);
+    return OMPI_SUCCESS;
+  }
+  opal_list_append (&module->sched_cache_lru, &entry->super);
+
+  /* one reference for the cache, one for the request */
+  OBJ_RETAIN(entry);
+  ((NBC_Handle *) *request)->sched_entry = entry;
+  OPAL_THREAD_UNLOCK(&module->mutex);
+
+  return OMPI_SUCCESS;
+}
+
+/* release all cached schedules of a module. requests that still run a
+ * cached schedule keep their entry alive until they are freed */
+void NBC_Sched_cache_fini (ompi_coll_libnbc_module_t *module) {
+  NBC_Sched_cache_entry *entry;
+
+  if (0 >= module->sched_cache_size) {
+    return;
+  }
+
+  OPAL_THREAD_LOCK(&module->mutex);
+  while (!opal_list_is_empty (&module->sched_cache_lru)) {
+    entry = (NBC_Sched_cache_entry *) opal_list_get_first (&module->sched_cache_lru);
+    nbc_sched_cache_remove (module, entry);
+  }
+  OPAL_THREAD_UNLOCK(&module->mutex);
 }
-#endif
@@ -27,70 +27,62 @@ static int nbc_barrier_init(struct ompi_communicator_t *comm, ompi_request_t **
 {
   int rank, p, maxround, res, recvpeer, sendpeer;
   NBC_Schedule *schedule;
+  NBC_Sched_cache_key key;
   ompi_coll_libnbc_module_t *libnbc_module = (ompi_coll_libnbc_module_t*) module;
 
   rank = ompi_comm_rank (comm);
   p = ompi_comm_size (comm);
 
-#ifdef NBC_CACHE_SCHEDULE
-  /* there only one argument set per communicator -> hang it directly at
-   * the tree-position, NBC_Dict_size[...] is 0 for not initialized and
-   * 1 for initialized. NBC_Dict[...] is a pointer to the schedule in
-   * this case */
-  if (libnbc_module->NBC_Dict_size[NBC_BARRIER] == 0) {
-    /* we did not init it yet */
-#endif
-    schedule = OBJ_NEW(NBC_Schedule);
-    if (OPAL_UNLIKELY(NULL == schedule)) {
-      return OMPI_ERR_OUT_OF_RESOURCE;
-    }
-
-    maxround = ceil_of_log2(p) -1;
+  /* there is only one argument set per communicator */
+  NBC_Sched_cache_key_init (&key, NBC_BARRIER, 0, 0, NULL, 0, NULL, NULL, 0, NULL, NULL);
+  res = NBC_Sched_cache_request (libnbc_module, &key, persistent, comm, request);
+  if (OMPI_ERR_NOT_FOUND != res) {
+    return res;
+  }
 
-    for (int round = 0 ; round <= maxround ; ++round) {
-      sendpeer = (rank + (1 << round)) % p;
-      /* add p because modulo does not work with negative values */
-      recvpeer = ((rank - (1 << round)) + p) % p;
+  schedule = OBJ_NEW(NBC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
 
-      /* send msg to sendpeer */
-      res = NBC_Sched_send (NULL, false, 0, MPI_BYTE, sendpeer, schedule, false);
-      if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-        OBJ_RELEASE(schedule);
-        return res;
-      }
+  maxround = ceil_of_log2(p) -1;
 
-      /* recv msg from recvpeer */
-      res = NBC_Sched_recv (NULL, false, 0, MPI_BYTE, recvpeer, schedule, false);
-      if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-        OBJ_RELEASE(schedule);
-        return res;
-      }
+  for (int round = 0 ; round <= maxround ; ++round) {
+    sendpeer = (rank + (1 << round)) % p;
+    /* add p because modulo does not work with negative values */
+    recvpeer = ((rank - (1 << round)) + p) % p;
 
-      /* end communication round */
-      if (round < maxround) {
-        res = NBC_Sched_barrier (schedule);
-        if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-          OBJ_RELEASE(schedule);
-          return res;
-        }
-      }
+    /* send msg to sendpeer */
+    res = NBC_Sched_send (NULL, false, 0, MPI_BYTE, sendpeer, schedule, false);
+    if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+      OBJ_RELEASE(schedule);
+      return res;
     }
 
-    res = NBC_Sched_commit (schedule);
+    /* recv msg from recvpeer */
+    res = NBC_Sched_recv (NULL, false, 0, MPI_BYTE, recvpeer, schedule, false);
     if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
       OBJ_RELEASE(schedule);
       return res;
     }
 
-#ifdef NBC_CACHE_SCHEDULE
-    /* add it */
-    libnbc_module->NBC_Dict[NBC_BARRIER] = (hb_tree *) schedule;
-    libnbc_module->NBC_Dict_size[NBC_BARRIER] = 1;
+    /* end communication round */
+    if (round < maxround) {
+      res = NBC_Sched_barrier (schedule);
+      if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+        OBJ_RELEASE(schedule);
+        return res;
+      }
+    }
+  }
+
+  res = NBC_Sched_commit (schedule);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    OBJ_RELEASE(schedule);
+    return res;
   }
-  OBJ_RETAIN(schedule);
-#endif
 
-  res = NBC_Schedule_request(schedule, comm, libnbc_module, persistent, request, NULL);
+  res = NBC_Schedule_request_cached(schedule, comm, libnbc_module, persistent, request, NULL, &key);
   if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
     OBJ_RELEASE(schedule);
     return res;
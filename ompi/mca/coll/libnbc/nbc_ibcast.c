@@ -29,24 +29,6 @@ static inline int bcast_sched_chain(int rank, int p, int root, NBC_Schedule *sch
 static inline int bcast_sched_knomial(int rank, int comm_size, int root, NBC_Schedule *schedule, void *buf,
                                       size_t count, MPI_Datatype datatype, int knomial_radix);
 
-#ifdef NBC_CACHE_SCHEDULE
-/* tree comparison function for schedule cache */
-int NBC_Bcast_args_compare(NBC_Bcast_args *a, NBC_Bcast_args *b, void *param) {
-  if ((a->buffer == b->buffer) &&
-      (a->count == b->count) &&
-      (a->datatype == b->datatype) &&
-      (a->root == b->root) ) {
-    return 0;
-  }
-
-  if( a->buffer < b->buffer ) {
-    return -1;
-  }
-
-  return 1;
-}
-#endif
-
 static int nbc_bcast_init(void *buffer, size_t count, MPI_Datatype datatype, int root,
                           struct ompi_communicator_t *comm, ompi_request_t ** request,
                           mca_coll_base_module_t *module, bool persistent)
@@ -54,9 +36,7 @@ static int nbc_bcast_init(void *buffer, size_t count, MPI_Datatype datatype, int
   int rank, p, res, segsize;
   size_t size;
   NBC_Schedule *schedule;
-#ifdef NBC_CACHE_SCHEDULE
-  NBC_Bcast_args *args, *found, search;
-#endif
+  NBC_Sched_cache_key key;
   enum { NBC_BCAST_LINEAR, NBC_BCAST_BINOMIAL, NBC_BCAST_CHAIN, NBC_BCAST_KNOMIAL } alg;
   ompi_coll_libnbc_module_t *libnbc_module = (ompi_coll_libnbc_module_t*) module;
 
@@ -112,77 +92,46 @@ static int nbc_bcast_init(void *buffer, size_t count, MPI_Datatype datatype, int
     }
   }
 
-#ifdef NBC_CACHE_SCHEDULE
-  /* search schedule in communicator specific tree */
-  search.buffer = buffer;
-  search.count = count;
-  search.datatype = datatype;
-  search.root = root;
-  found = (NBC_Bcast_args *) hb_tree_search ((hb_tree *) libnbc_module->NBC_Dict[NBC_BCAST], &search);
-  if (NULL == found) {
-#endif
-    schedule = OBJ_NEW(NBC_Schedule);
-    if (OPAL_UNLIKELY(NULL == schedule)) {
-      return OMPI_ERR_OUT_OF_RESOURCE;
-    }
+  /* reuse the schedule of an earlier call with the same arguments */
+  NBC_Sched_cache_key_init (&key, NBC_BCAST, alg, root, NULL, 0, NULL,
+                            buffer, count, datatype, NULL);
+  res = NBC_Sched_cache_request (libnbc_module, &key, persistent, comm, request);
+  if (OMPI_ERR_NOT_FOUND != res) {
+    return res;
+  }
 
-    switch(alg) {
-      case NBC_BCAST_LINEAR:
-        res = bcast_sched_linear(rank, p, root, schedule, buffer, count, datatype);
-        break;
-      case NBC_BCAST_BINOMIAL:
-        res = bcast_sched_binomial(rank, p, root, schedule, buffer, count, datatype);
-        break;
-      case NBC_BCAST_CHAIN:
-        res = bcast_sched_chain(rank, p, root, schedule, buffer, count, datatype, segsize, size);
-        break;
-      case NBC_BCAST_KNOMIAL:
-        res = bcast_sched_knomial(rank, p, root, schedule, buffer, count, datatype, libnbc_ibcast_knomial_radix);
-        break;
-    }
+  schedule = OBJ_NEW(NBC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
 
-    if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-      OBJ_RELEASE(schedule);
-      return res;
-    }
+  switch(alg) {
+    case NBC_BCAST_LINEAR:
+      res = bcast_sched_linear(rank, p, root, schedule, buffer, count, datatype);
+      break;
+    case NBC_BCAST_BINOMIAL:
+      res = bcast_sched_binomial(rank, p, root, schedule, buffer, count, datatype);
+      break;
+    case NBC_BCAST_CHAIN:
+      res = bcast_sched_chain(rank, p, root, schedule, buffer, count, datatype, segsize, size);
+      break;
+    case NBC_BCAST_KNOMIAL:
+      res = bcast_sched_knomial(rank, p, root, schedule, buffer, count, datatype, libnbc_ibcast_knomial_radix);
+      break;
+  }
 
-    res = NBC_Sched_commit (schedule);
-    if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-      OBJ_RELEASE(schedule);
-      return res;
-    }
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    OBJ_RELEASE(schedule);
+    return res;
+  }
 
-#ifdef NBC_CACHE_SCHEDULE
-    /* save schedule to tree */
-    args = (NBC_Bcast_args *) malloc (sizeof (args));
-    if (NULL != args) {
-      args->buffer = buffer;
-      args->count = count;
-      args->datatype = datatype;
-      args->root = root;
-      args->schedule = schedule;
-      res = hb_tree_insert ((hb_tree *) libnbc_module->NBC_Dict[NBC_BCAST], args, args, 0);
-      if (0 == res) {
-        OBJ_RETAIN (schedule);
-
-        /* increase number of elements for A2A */
-        if (++libnbc_module->NBC_Dict_size[NBC_BCAST] > NBC_SCHED_DICT_UPPER) {
-          NBC_SchedCache_dictwipe ((hb_tree *) libnbc_module->NBC_Dict[NBC_BCAST],
-                                   &libnbc_module->NBC_Dict_size[NBC_BCAST]);
-        }
-      } else {
-        NBC_Error("error in dict_insert() (%i)", res);
-        free (args);
-      }
-    }
-  } else {
-    /* found schedule */
-    schedule = found->schedule;
-    OBJ_RETAIN(schedule);
+  res = NBC_Sched_commit (schedule);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    OBJ_RELEASE(schedule);
+    return res;
   }
-#endif
 
-  res = NBC_Schedule_request(schedule, comm, libnbc_module, persistent, request, NULL);
+  res = NBC_Schedule_request_cached(schedule, comm, libnbc_module, persistent, request, NULL, &key);
   if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
     OBJ_RELEASE(schedule);
     return res;
@@ -44,7 +44,6 @@
 #include <assert.h>
 #include <math.h>
 #include <string.h>
-#include "libdict/dict.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -167,106 +166,60 @@ int NBC_Sched_unpack (void *inbuf, char tmpinbuf, size_t count, MPI_Datatype dat
 int NBC_Sched_barrier (NBC_Schedule *schedule);
 int NBC_Sched_commit (NBC_Schedule *schedule);
 
-#ifdef NBC_CACHE_SCHEDULE
-/* this is a dummy structure which is used to get the schedule out of
- * the collop specific structure. The schedule pointer HAS to be at the
- * first position and should NOT BE REORDERED by the compiler (C
- * guarantees that */
-struct NBC_dummyarg {
-  NBC_Schedule *schedule;
-};
-
+/* the arguments of a collective call that determine its schedule. Keys
+ * are compared bytewise, so they must be set with NBC_Sched_cache_key_init */
 typedef struct {
-  NBC_Schedule *schedule;
-  void *sendbuf;
-  size_t sendcount;
-  MPI_Datatype sendtype;
-  void* recvbuf;
-  size_t recvcount;
-  MPI_Datatype recvtype;
-} NBC_Alltoall_args;
-int NBC_Alltoall_args_compare(NBC_Alltoall_args *a, NBC_Alltoall_args *b, void *param);
-
-typedef struct {
-  NBC_Schedule *schedule;
-  void *sendbuf;
-  size_t sendcount;
-  MPI_Datatype sendtype;
-  void* recvbuf;
-  size_t recvcount;
-  MPI_Datatype recvtype;
-} NBC_Allgather_args;
-int NBC_Allgather_args_compare(NBC_Allgather_args *a, NBC_Allgather_args *b, void *param);
-
-typedef struct {
-  NBC_Schedule *schedule;
-  void *sendbuf;
-  void* recvbuf;
-  size_t count;
-  MPI_Datatype datatype;
-  MPI_Op op;
-} NBC_Allreduce_args;
-int NBC_Allreduce_args_compare(NBC_Allreduce_args *a, NBC_Allreduce_args *b, void *param);
-
-typedef struct {
-  NBC_Schedule *schedule;
-  void *buffer;
-  size_t count;
-  MPI_Datatype datatype;
+  int coll;
+  int alg;
   int root;
-} NBC_Bcast_args;
-int NBC_Bcast_args_compare(NBC_Bcast_args *a, NBC_Bcast_args *b, void *param);
-
-typedef struct {
-  NBC_Schedule *schedule;
-  void *sendbuf;
+  const void *sendbuf;
   size_t sendcount;
   MPI_Datatype sendtype;
-  void* recvbuf;
+  void *recvbuf;
   size_t recvcount;
   MPI_Datatype recvtype;
-  int root;
-} NBC_Gather_args;
-int NBC_Gather_args_compare(NBC_Gather_args *a, NBC_Gather_args *b, void *param);
-
-typedef struct {
-  NBC_Schedule *schedule;
-  void *sendbuf;
-  void* recvbuf;
-  size_t count;
-  MPI_Datatype datatype;
-  MPI_Op op;
-  int root;
-} NBC_Reduce_args;
-int NBC_Reduce_args_compare(NBC_Reduce_args *a, NBC_Reduce_args *b, void *param);
-
-typedef struct {
-  NBC_Schedule *schedule;
-  void *sendbuf;
-  void* recvbuf;
-  size_t count;
-  MPI_Datatype datatype;
   MPI_Op op;
-} NBC_Scan_args;
-int NBC_Scan_args_compare(NBC_Scan_args *a, NBC_Scan_args *b, void *param);
-
-typedef struct {
+} NBC_Sched_cache_key;
+
+/* a cached schedule. The entry owns the tmpbuf the schedule was built
+ * against, so a schedule that refers to tmpbuf can only be handed to
+ * one request at a time (in_use). Schedules without tmpbuf are shared
+ * freely. Requests running a cached schedule hold a reference on the
+ * entry, so it outlives eviction and the destruction of the module. */
+struct NBC_Sched_cache_entry {
+  opal_list_item_t super;
+  NBC_Sched_cache_key key;
   NBC_Schedule *schedule;
-  void *sendbuf;
-  size_t sendcount;
-  MPI_Datatype sendtype;
-  void* recvbuf;
-  size_t recvcount;
-  MPI_Datatype recvtype;
-  int root;
-} NBC_Scatter_args;
-int NBC_Scatter_args_compare(NBC_Scatter_args *a, NBC_Scatter_args *b, void *param);
-
-/* Schedule cache structures/functions */
-void NBC_SchedCache_args_delete(void *entry);
-void NBC_SchedCache_args_delete_key_dummy(void *k);
+  void *tmpbuf;
+  volatile bool in_use;
+};
+typedef struct NBC_Sched_cache_entry NBC_Sched_cache_entry;
+OBJ_CLASS_DECLARATION(NBC_Sched_cache_entry);
+
+static inline void NBC_Sched_cache_key_init (NBC_Sched_cache_key *key, int coll, int alg, int root,
+                                             const void *sendbuf, size_t sendcount, MPI_Datatype sendtype,
+                                             void *recvbuf, size_t recvcount, MPI_Datatype recvtype,
+                                             MPI_Op op) {
+  /* clear the padding as well */
+  memset (key, 0, sizeof (*key));
+  key->coll = coll;
+  key->alg = alg;
+  key->root = root;
+  key->sendbuf = sendbuf;
+  key->sendcount = sendcount;
+  key->sendtype = sendtype;
+  key->recvbuf = recvbuf;
+  key->recvcount = recvcount;
+  key->recvtype = recvtype;
+  key->op = op;
+}
 
-#endif
+int NBC_Sched_cache_request (ompi_coll_libnbc_module_t *module, const NBC_Sched_cache_key *key,
+                             bool persistent, ompi_communicator_t *comm, ompi_request_t **request);
+int NBC_Schedule_request_cached (NBC_Schedule *schedule, ompi_communicator_t *comm,
+                                 ompi_coll_libnbc_module_t *module, bool persistent,
+                                 ompi_request_t **request, void *tmpbuf, const NBC_Sched_cache_key *key);
+void NBC_Sched_cache_fini (ompi_coll_libnbc_module_t *module);
 
 
 int NBC_Start(NBC_Handle *handle);
@@ -565,18 +518,6 @@ static inline int NBC_Unpack(void *src, size_t srccount, MPI_Datatype srctype, v
   return OMPI_SUCCESS;
 }
 
-/* deletes elements from dict_in until low watermark is reached */
-static inline void NBC_SchedCache_dictwipe(hb_tree *dict_in, int *size) {
-  hb_itor *itor;
-
-  itor = ompi_coll_libnbc_hb_itor_new(dict_in);
-  for (; ompi_coll_libnbc_hb_itor_valid(itor) && (*size>NBC_SCHED_DICT_LOWER); ompi_coll_libnbc_hb_itor_next(itor)) {
-    ompi_coll_libnbc_hb_tree_remove(dict_in, ompi_coll_libnbc_hb_itor_key(itor), 0);
-    *size = *size-1;
-  }
-  ompi_coll_libnbc_hb_itor_destroy(itor);
-}
-
 #define NBC_IN_PLACE(sendbuf, recvbuf, inplace) \
 { \
   inplace = 0; \
@@ -23,27 +23,6 @@
  */
 #include "nbc_internal.h"
 
-#ifdef NBC_CACHE_SCHEDULE
-/* tree comparison function for schedule cache */
-int NBC_Scatter_args_compare(NBC_Scatter_args *a, NBC_Scatter_args *b, void *param) {
-    if ((a->sendbuf == b->sendbuf) &&
-        (a->sendcount == b->sendcount) &&
-        (a->sendtype == b->sendtype) &&
-        (a->recvbuf == b->recvbuf) &&
-        (a->recvcount == b->recvcount) &&
-        (a->recvtype == b->recvtype) &&
-        (a->root == b->root)) {
-        return 0;
-    }
-
-    if (a->sendbuf < b->sendbuf) {
-        return -1;
-    }
-
-    return 1;
-}
-#endif
-
 /* simple linear MPI_Iscatter */
 static int nbc_scatter_init (const void* sendbuf, size_t sendcount, MPI_Datatype sendtype,
                              void* recvbuf, size_t recvcount, MPI_Datatype recvtype, int root,
@@ -53,9 +32,9 @@ static int nbc_scatter_init (const void* sendbuf, size_t sendcount, MPI_Datatype
   MPI_Aint sndext = 0;
   NBC_Schedule *schedule;
   char *sbuf, inplace = 0;
+  NBC_Sched_cache_key key;
   ompi_coll_libnbc_module_t *libnbc_module = (ompi_coll_libnbc_module_t*) module;
 
-
   rank = ompi_comm_rank (comm);
   if (root == rank) {
     NBC_IN_PLACE(sendbuf, recvbuf, inplace);
@@ -70,96 +49,61 @@ static int nbc_scatter_init (const void* sendbuf, size_t sendcount, MPI_Datatype
     }
   }
 
-#ifdef NBC_CACHE_SCHEDULE
-  NBC_Scatter_args *args, *found, search;
-
-  /* search schedule in communicator specific tree */
-  search.sendbuf=sendbuf;
-  search.sendcount=sendcount;
-  search.sendtype=sendtype;
-  search.recvbuf=recvbuf;
-  search.recvcount=recvcount;
-  search.recvtype=recvtype;
-  search.root=root;
-  found = (NBC_Scatter_args *) hb_tree_search ((hb_tree *) libnbc_module->NBC_Dict[NBC_SCATTER], &search);
-  if (NULL == found) {
-#endif
-    schedule = OBJ_NEW(NBC_Schedule);
-    if (OPAL_UNLIKELY(NULL == schedule)) {
-      return OMPI_ERR_OUT_OF_RESOURCE;
-    }
+  /* reuse the schedule of an earlier call with the same arguments. the
+   * send arguments are only significant at the root, the receive
+   * arguments are ignored by an in place root */
+  NBC_Sched_cache_key_init (&key, NBC_SCATTER, 0, root, (rank == root) ? sendbuf : NULL,
+                            (rank == root) ? sendcount : 0, (rank == root) ? sendtype : NULL,
+                            recvbuf, inplace ? 0 : recvcount, inplace ? NULL : recvtype, NULL);
+  res = NBC_Sched_cache_request (libnbc_module, &key, persistent, comm, request);
+  if (OMPI_ERR_NOT_FOUND != res) {
+    return res;
+  }
 
-    /* receive from root */
-    if (rank != root) {
-      /* recv msg from root */
-      res = NBC_Sched_recv (recvbuf, false, recvcount, recvtype, root, schedule, false);
-      if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-        OBJ_RELEASE(schedule);
-        return res;
-      }
-    } else {
-      for (int i = 0 ; i < p ; ++i) {
-        sbuf = (char *) sendbuf + (MPI_Aint) sndext * i * sendcount;
-        if (i == root) {
-          if (!inplace) {
-            /* if I am the root - just copy the message */
-            res = NBC_Sched_copy (sbuf, false, sendcount, sendtype,
-                                  recvbuf, false, recvcount, recvtype, schedule, false);
-            if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-              OBJ_RELEASE(schedule);
-              return res;
-            }
-          }
-        } else {
-          /* root sends the right buffer to the right receiver */
-          res = NBC_Sched_send (sbuf, false, sendcount, sendtype, i, schedule, false);
-          if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
-            OBJ_RELEASE(schedule);
-            return res;
-          }
-        }
-      }
-    }
+  schedule = OBJ_NEW(NBC_Schedule);
+  if (OPAL_UNLIKELY(NULL == schedule)) {
+    return OMPI_ERR_OUT_OF_RESOURCE;
+  }
 
-    res = NBC_Sched_commit (schedule);
+  /* receive from root */
+  if (rank != root) {
+    /* recv msg from root */
+    res = NBC_Sched_recv (recvbuf, false, recvcount, recvtype, root, schedule, false);
     if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
       OBJ_RELEASE(schedule);
       return res;
     }
-#ifdef NBC_CACHE_SCHEDULE
-    /* save schedule to tree */
-    args = (NBC_Scatter_args *) malloc (sizeof (args));
-    if (NULL != args) {
-      args->sendbuf = sendbuf;
-      args->sendcount = sendcount;
-      args->sendtype = sendtype;
-      args->recvbuf = recvbuf;
-      args->recvcount = recvcount;
-      args->recvtype = recvtype;
-      args->root = root;
-      args->schedule = schedule;
-      res = hb_tree_insert ((hb_tree *) libnbc_module->NBC_Dict[NBC_SCATTER], args, args, 0);
-      if (0 == res) {
-        OBJ_RETAIN(schedule);
-
-        /* increase number of elements for A2A */
-        if (++libnbc_module->NBC_Dict_size[NBC_SCATTER] > NBC_SCHED_DICT_UPPER) {
-          NBC_SchedCache_dictwipe ((hb_tree *) libnbc_module->NBC_Dict[NBC_SCATTER],
-                                   &libnbc_module->NBC_Dict_size[NBC_SCATTER]);
+  } else {
+    for (int i = 0 ; i < p ; ++i) {
+      sbuf = (char *) sendbuf + (MPI_Aint) sndext * i * sendcount;
+      if (i == root) {
+        if (!inplace) {
+          /* if I am the root - just copy the message */
+          res = NBC_Sched_copy (sbuf, false, sendcount, sendtype,
+                                recvbuf, false, recvcount, recvtype, schedule, false);
+          if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+            OBJ_RELEASE(schedule);
+            return res;
+          }
         }
       } else {
-        NBC_Error("error in dict_insert() (%i)", res);
-        free (args);
+        /* root sends the right buffer to the right receiver */
+        res = NBC_Sched_send (sbuf, false, sendcount, sendtype, i, schedule, false);
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+          OBJ_RELEASE(schedule);
+          return res;
+        }
       }
     }
-  } else {
-    /* found schedule */
-    schedule = found->schedule;
-    OBJ_RETAIN(schedule);
   }
-#endif
 
-  res = NBC_Schedule_request(schedule, comm, libnbc_module, persistent, request, NULL);
+  res = NBC_Sched_commit (schedule);
+  if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
+    OBJ_RELEASE(schedule);
+    return res;
+  }
+
+  res = NBC_Schedule_request_cached(schedule, comm, libnbc_module, persistent, request, NULL, &key);
   if (OPAL_UNLIKELY(OMPI_SUCCESS != res)) {
     OBJ_RELEASE(schedule);
     return res;
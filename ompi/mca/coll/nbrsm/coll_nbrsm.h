@@ -0,0 +1,384 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file
+ *
+ * Neighborhood collectives on distributed graph communicators that move
+ * the blocks of on-node neighbours with a single copy through the smsc
+ * framework. Off-node neighbours use the PML, with the same tags as
+ * coll/basic, so that ranks which did not select this component still
+ * match.
+ *
+ * For an on-node edge the sender posts the address of its block, the
+ * receiver copies (or maps) it directly into its receive buffer and
+ * acknowledges, and the sender waits for the acknowledgement before
+ * returning. A sender whose block is not contiguous posts a NULL address
+ * and sends the block through the PML instead.
+ *
+ * With coll_nbrsm_aggregate the off-node blocks are combined instead:
+ * every rank hands them to the leader of its node, the leader sends one
+ * message to the leader of each destination node, and that leader
+ * scatters the blocks to their receivers. This needs the component on
+ * every rank of the communicator.
+ */
+
+#ifndef MCA_COLL_NBRSM_EXPORT_H
+#define MCA_COLL_NBRSM_EXPORT_H
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+
+#include "opal/class/opal_list.h"
+#include "opal/class/opal_object.h"
+#include "opal/mca/mca.h"
+#include "opal/mca/smsc/smsc.h"
+#include "opal/mca/threads/mutex.h"
+
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/mca/coll/base/base.h"
+#include "ompi/mca/coll/base/coll_tags.h"
+#include "ompi/proc/proc.h"
+
+BEGIN_C_DECLS
+
+/* control messages of the on-node protocol; the persistent plans use
+ * tags of their own, taken in turn from the rest of the neighbour range */
+#define MCA_COLL_NBRSM_TAG_ADDR   (MCA_COLL_BASE_TAG_NEIGHBOR_BASE)
+#define MCA_COLL_NBRSM_TAG_DONE   (MCA_COLL_BASE_TAG_NEIGHBOR_BASE - 1)
+#define MCA_COLL_NBRSM_TAG_BLOCK  (MCA_COLL_BASE_TAG_NEIGHBOR_BASE - 2)
+#define MCA_COLL_NBRSM_TAG_PLAN_BASE  (MCA_COLL_BASE_TAG_NEIGHBOR_BASE - 3)
+
+/* Types */
+
+/** one edge of the distributed graph, in the order of the topology */
+typedef struct mca_coll_nbrsm_edge_t {
+    int peer;
+    /** reached through smsc */
+    bool local;
+    /** on another node, exchanged through the node leaders */
+    bool aggregated;
+    struct mca_smsc_endpoint_t *endpoint;
+} mca_coll_nbrsm_edge_t;
+
+/** the block sent to or received from one edge */
+typedef struct mca_coll_nbrsm_block_t {
+    char *buf;
+    size_t count;
+    struct ompi_datatype_t *dtype;
+    size_t bytes;
+    /** first byte of the block when it is contiguous */
+    char *data;
+    bool contiguous;
+    bool single_copy;
+    bool aggregated;
+
+    /* receive blocks of persistent plans keep the mapping of the sender's
+     * block across starts */
+    void *remote;
+    void *mapped;
+    void *reg;
+} mca_coll_nbrsm_block_t;
+
+/** header of an aggregated block in the node buffers */
+typedef struct mca_coll_nbrsm_aggr_hdr_t {
+    /* ranks in the communicator */
+    int32_t src;
+    int32_t dst;
+    /** the block is the seq-th one from src to dst, in edge order */
+    int32_t seq;
+    int32_t pad;
+    uint64_t bytes;
+} mca_coll_nbrsm_aggr_hdr_t;
+
+typedef struct mca_coll_nbrsm_aggr_key_t {
+    int peer;
+    int index;
+} mca_coll_nbrsm_aggr_key_t;
+
+/** node level state of the aggregation, built with the topology */
+typedef struct mca_coll_nbrsm_aggr_t {
+    /** the ranks of the communicator on this node, the leader is rank 0 */
+    struct ompi_communicator_t *node_comm;
+    /** one rank per node, the rank is the node index; NULL off the leaders */
+    struct ompi_communicator_t *leader_comm;
+    int nnodes;
+    /** some rank of this node has an off-node edge; the node sits the
+     *  exchange out otherwise */
+    bool active;
+    /** node index of every rank of the communicator */
+    int *node_of;
+    /** rank in node_comm of every rank of the communicator, -1 off-node */
+    int *local_rank;
+
+    /* nodes exchanged with, on the leaders only */
+    int nsend_nodes;
+    int *send_nodes;
+    int nrecv_nodes;
+    int *recv_nodes;
+
+    /** sequence number of every out-edge */
+    int *out_seq;
+    /** in-edges sorted by peer, then by edge order */
+    mca_coll_nbrsm_aggr_key_t *in_keys;
+} mca_coll_nbrsm_aggr_t;
+
+/** buffers of the aggregation, kept by a schedule across exchanges */
+typedef struct mca_coll_nbrsm_aggr_bufs_t {
+    /* grown as needed, with their sizes */
+    char *packed;
+    size_t packed_size;
+    char *gathered;
+    size_t gathered_size;
+    char *outgoing;
+    size_t outgoing_size;
+    char *incoming;
+    size_t incoming_size;
+    char *scattered;
+    size_t scattered_size;
+
+    /* layout of the node buffers on the leader (node_comm size) */
+    uint64_t *local_sizes;
+    size_t *counts;
+    ptrdiff_t *displs;
+    /* layout of the leader messages (one per node) */
+    size_t *node_counts;
+    ptrdiff_t *node_displs;
+    uint64_t *node_sizes;
+    ompi_request_t **reqs;
+} mca_coll_nbrsm_aggr_bufs_t;
+
+/** everything one exchange needs, built per call or once per plan */
+typedef struct mca_coll_nbrsm_sched_t {
+    int indegree;
+    int outdegree;
+    const mca_coll_nbrsm_edge_t *in;
+    const mca_coll_nbrsm_edge_t *out;
+    mca_coll_nbrsm_block_t *recvs;
+    mca_coll_nbrsm_block_t *sends;
+    /** addresses received from in-edges, then posted to out-edges */
+    uint64_t *addrs;
+    ompi_request_t **reqs;
+    /** tag of the blocks sent through the PML */
+    int tag;
+    /* tags of the on-node protocol */
+    int addr_tag;
+    int done_tag;
+    int block_tag;
+    bool keep_mappings;
+    /** set when the off-node blocks go through the node leaders */
+    mca_coll_nbrsm_aggr_t *aggr;
+    mca_coll_nbrsm_aggr_bufs_t aggr_bufs;
+
+    /* progress of a posted exchange */
+    int nreqs;
+    int ndone;
+    /** next in-edge to take the address of */
+    int next_in;
+    int error;
+} mca_coll_nbrsm_sched_t;
+
+/* Module */
+
+typedef struct mca_coll_nbrsm_module_t {
+    mca_coll_base_module_t super;
+
+    /* topology, resolved at the first neighbour collective */
+    bool topo_ready;
+    int indegree;
+    int outdegree;
+    mca_coll_nbrsm_edge_t *in;
+    mca_coll_nbrsm_edge_t *out;
+    mca_coll_nbrsm_aggr_t *aggr;
+    /** first control tag of the next persistent plan */
+    int plan_tag;
+
+    /** schedule reused by the blocking collectives */
+    mca_coll_nbrsm_sched_t sched;
+
+    /* the collectives of the component below, for the cartesian and
+     * graph topologies and for the persistent requests when plans are
+     * disabled or the off-node blocks are aggregated */
+    mca_coll_base_module_allgather_fn_t previous_neighbor_allgather;
+    mca_coll_base_module_t *previous_neighbor_allgather_module;
+    mca_coll_base_module_allgatherv_fn_t previous_neighbor_allgatherv;
+    mca_coll_base_module_t *previous_neighbor_allgatherv_module;
+    mca_coll_base_module_alltoall_fn_t previous_neighbor_alltoall;
+    mca_coll_base_module_t *previous_neighbor_alltoall_module;
+    mca_coll_base_module_alltoallv_fn_t previous_neighbor_alltoallv;
+    mca_coll_base_module_t *previous_neighbor_alltoallv_module;
+    mca_coll_base_module_neighbor_alltoallw_fn_t previous_neighbor_alltoallw;
+    mca_coll_base_module_t *previous_neighbor_alltoallw_module;
+
+    mca_coll_base_module_allgather_init_fn_t previous_neighbor_allgather_init;
+    mca_coll_base_module_t *previous_neighbor_allgather_init_module;
+    mca_coll_base_module_allgatherv_init_fn_t previous_neighbor_allgatherv_init;
+    mca_coll_base_module_t *previous_neighbor_allgatherv_init_module;
+    mca_coll_base_module_alltoall_init_fn_t previous_neighbor_alltoall_init;
+    mca_coll_base_module_t *previous_neighbor_alltoall_init_module;
+    mca_coll_base_module_alltoallv_init_fn_t previous_neighbor_alltoallv_init;
+    mca_coll_base_module_t *previous_neighbor_alltoallv_init_module;
+    mca_coll_base_module_neighbor_alltoallw_init_fn_t previous_neighbor_alltoallw_init;
+    mca_coll_base_module_t *previous_neighbor_alltoallw_init_module;
+} mca_coll_nbrsm_module_t;
+
+OBJ_CLASS_DECLARATION(mca_coll_nbrsm_module_t);
+
+/* Component */
+
+typedef struct mca_coll_nbrsm_component_t {
+    mca_coll_base_component_3_0_0_t super;
+
+    /** Priority of this component */
+    int priority;
+
+    /** blocks smaller than this go through the PML even on-node */
+    size_t min_size;
+
+    /** provide MPI_Neighbor_*_init plans */
+    bool persistent_plans;
+
+    /** combine the off-node blocks of a node at its leader */
+    bool aggregate;
+
+    /* started persistent plans, driven by mca_coll_nbrsm_plan_progress */
+    opal_list_t active_plans;
+    opal_mutex_t plan_lock;
+    opal_atomic_int32_t plan_progress_registered;
+} mca_coll_nbrsm_component_t;
+
+/* Globally exported variables */
+
+OMPI_DECLSPEC extern mca_coll_nbrsm_component_t mca_coll_nbrsm_component;
+
+/* API functions */
+
+int mca_coll_nbrsm_init_query(bool enable_progress_threads,
+                              bool enable_mpi_threads);
+mca_coll_base_module_t *
+mca_coll_nbrsm_comm_query(struct ompi_communicator_t *comm, int *priority);
+
+int mca_coll_nbrsm_topo_init(mca_coll_nbrsm_module_t *module,
+                             struct ompi_communicator_t *comm);
+
+/* aggregation through the node leaders */
+
+int mca_coll_nbrsm_aggr_init(mca_coll_nbrsm_module_t *module, struct ompi_communicator_t *comm);
+void mca_coll_nbrsm_aggr_free(mca_coll_nbrsm_aggr_t *aggr);
+int mca_coll_nbrsm_aggr_exchange(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm);
+void mca_coll_nbrsm_aggr_bufs_free(mca_coll_nbrsm_aggr_bufs_t *bufs);
+
+/* schedules */
+
+int mca_coll_nbrsm_sched_alloc(mca_coll_nbrsm_sched_t *sched, mca_coll_nbrsm_module_t *module);
+void mca_coll_nbrsm_sched_free(mca_coll_nbrsm_sched_t *sched);
+void mca_coll_nbrsm_sched_set_block(mca_coll_nbrsm_block_t *block, const mca_coll_nbrsm_edge_t *edge,
+                                    const void *buf, size_t count, struct ompi_datatype_t *dtype);
+int mca_coll_nbrsm_sched_run(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm);
+int mca_coll_nbrsm_sched_post(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm);
+bool mca_coll_nbrsm_sched_test(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm);
+
+void mca_coll_nbrsm_sched_allgather(mca_coll_nbrsm_sched_t *sched, const void *sbuf, size_t scount,
+                                    struct ompi_datatype_t *sdtype, void *rbuf, size_t rcount,
+                                    struct ompi_datatype_t *rdtype);
+void mca_coll_nbrsm_sched_allgatherv(mca_coll_nbrsm_sched_t *sched, const void *sbuf, size_t scount,
+                                     struct ompi_datatype_t *sdtype, void *rbuf,
+                                     ompi_count_array_t rcounts, ompi_disp_array_t displs,
+                                     struct ompi_datatype_t *rdtype);
+void mca_coll_nbrsm_sched_alltoall(mca_coll_nbrsm_sched_t *sched, const void *sbuf, size_t scount,
+                                   struct ompi_datatype_t *sdtype, void *rbuf, size_t rcount,
+                                   struct ompi_datatype_t *rdtype);
+void mca_coll_nbrsm_sched_alltoallv(mca_coll_nbrsm_sched_t *sched, const void *sbuf,
+                                    ompi_count_array_t scounts, ompi_disp_array_t sdispls,
+                                    struct ompi_datatype_t *sdtype, void *rbuf,
+                                    ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                    struct ompi_datatype_t *rdtype);
+void mca_coll_nbrsm_sched_alltoallw(mca_coll_nbrsm_sched_t *sched, const void *sbuf,
+                                    ompi_count_array_t scounts, ompi_disp_array_t sdispls,
+                                    struct ompi_datatype_t *const *sdtypes, void *rbuf,
+                                    ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                    struct ompi_datatype_t *const *rdtypes);
+
+/* blocking collectives */
+
+int mca_coll_nbrsm_neighbor_allgather(const void *sbuf, size_t scount,
+                                      struct ompi_datatype_t *sdtype, void *rbuf,
+                                      size_t rcount, struct ompi_datatype_t *rdtype,
+                                      struct ompi_communicator_t *comm,
+                                      mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_allgatherv(const void *sbuf, size_t scount,
+                                       struct ompi_datatype_t *sdtype, void *rbuf,
+                                       ompi_count_array_t rcounts, ompi_disp_array_t displs,
+                                       struct ompi_datatype_t *rdtype,
+                                       struct ompi_communicator_t *comm,
+                                       mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_alltoall(const void *sbuf, size_t scount,
+                                     struct ompi_datatype_t *sdtype, void *rbuf,
+                                     size_t rcount, struct ompi_datatype_t *rdtype,
+                                     struct ompi_communicator_t *comm,
+                                     mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_alltoallv(const void *sbuf, ompi_count_array_t scounts,
+                                      ompi_disp_array_t sdispls, struct ompi_datatype_t *sdtype,
+                                      void *rbuf, ompi_count_array_t rcounts,
+                                      ompi_disp_array_t rdispls, struct ompi_datatype_t *rdtype,
+                                      struct ompi_communicator_t *comm,
+                                      mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_alltoallw(const void *sbuf, ompi_count_array_t scounts,
+                                      ompi_disp_array_t sdispls,
+                                      struct ompi_datatype_t *const *sdtypes, void *rbuf,
+                                      ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                      struct ompi_datatype_t *const *rdtypes,
+                                      struct ompi_communicator_t *comm,
+                                      mca_coll_base_module_t *module);
+
+/* persistent collectives */
+
+int mca_coll_nbrsm_neighbor_allgather_init(const void *sbuf, size_t scount,
+                                           struct ompi_datatype_t *sdtype, void *rbuf,
+                                           size_t rcount, struct ompi_datatype_t *rdtype,
+                                           struct ompi_communicator_t *comm,
+                                           struct ompi_info_t *info, ompi_request_t **request,
+                                           mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_allgatherv_init(const void *sbuf, size_t scount,
+                                            struct ompi_datatype_t *sdtype, void *rbuf,
+                                            ompi_count_array_t rcounts, ompi_disp_array_t displs,
+                                            struct ompi_datatype_t *rdtype,
+                                            struct ompi_communicator_t *comm,
+                                            struct ompi_info_t *info, ompi_request_t **request,
+                                            mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_alltoall_init(const void *sbuf, size_t scount,
+                                          struct ompi_datatype_t *sdtype, void *rbuf,
+                                          size_t rcount, struct ompi_datatype_t *rdtype,
+                                          struct ompi_communicator_t *comm,
+                                          struct ompi_info_t *info, ompi_request_t **request,
+                                          mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_alltoallv_init(const void *sbuf, ompi_count_array_t scounts,
+                                           ompi_disp_array_t sdispls,
+                                           struct ompi_datatype_t *sdtype, void *rbuf,
+                                           ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                           struct ompi_datatype_t *rdtype,
+                                           struct ompi_communicator_t *comm,
+                                           struct ompi_info_t *info, ompi_request_t **request,
+                                           mca_coll_base_module_t *module);
+int mca_coll_nbrsm_neighbor_alltoallw_init(const void *sbuf, ompi_count_array_t scounts,
+                                           ompi_disp_array_t sdispls,
+                                           struct ompi_datatype_t *const *sdtypes, void *rbuf,
+                                           ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                           struct ompi_datatype_t *const *rdtypes,
+                                           struct ompi_communicator_t *comm,
+                                           struct ompi_info_t *info, ompi_request_t **request,
+                                           mca_coll_base_module_t *module);
+int mca_coll_nbrsm_plan_progress(void);
+
+END_C_DECLS
+
+#endif /* MCA_COLL_NBRSM_EXPORT_H */
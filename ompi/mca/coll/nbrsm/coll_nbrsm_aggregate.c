@@ -0,0 +1,620 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Message combining for the off-node blocks of a neighborhood
+ * collective. A rank with many neighbours on another node would send
+ * them one small message each; instead every rank packs its off-node
+ * blocks behind a header naming the receiver, and the exchange runs in
+ * three steps:
+ *
+ *   1. the ranks of a node gather their packed blocks at the leader of
+ *      the node (rank 0 of node_comm),
+ *   2. the leader sorts them by destination node and sends one message
+ *      to the leader of every node its ranks have neighbours on,
+ *   3. the receiving leader sorts what it got by receiver and scatters
+ *      it to the ranks of its node, which unpack the blocks into their
+ *      receive buffers.
+ *
+ * Which nodes exchange messages only depends on the topology, so it is
+ * computed once; every leader then sends a size and a (possibly empty)
+ * buffer to each of them at every call; a node without off-node edges
+ * skips the exchange altogether. Within a pair of ranks the blocks are
+ * told apart by their order, as the PML would match them. The buffers
+ * are kept by the schedule from one call to the next.
+ */
+
+#include "ompi_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpi.h"
+
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/pml/pml.h"
+#include "ompi/mca/coll/base/coll_base_functions.h"
+#include "ompi/request/request.h"
+#include "coll_nbrsm.h"
+
+#define NBRSM_AGGR_ALIGN(bytes) (((bytes) + 7) & ~((size_t) 7))
+#define NBRSM_AGGR_RECORD_SIZE(bytes) (sizeof(mca_coll_nbrsm_aggr_hdr_t) + NBRSM_AGGR_ALIGN(bytes))
+
+/* the sub-communicators must not be released before the parent, as in coll/han */
+#define NBRSM_AGGR_EXTRA_RETAIN(COMM, PARENT_COMM)          \
+    do {                                                    \
+        if (OMPI_COMM_CID_IS_LOWER(COMM, PARENT_COMM)) {    \
+            OMPI_COMM_SET_EXTRA_RETAIN(COMM);               \
+            OBJ_RETAIN(COMM);                               \
+        }                                                   \
+    } while (0)
+
+static int mca_coll_nbrsm_aggr_key_cmp(const void *a, const void *b)
+{
+    const mca_coll_nbrsm_aggr_key_t *ka = (const mca_coll_nbrsm_aggr_key_t *) a;
+    const mca_coll_nbrsm_aggr_key_t *kb = (const mca_coll_nbrsm_aggr_key_t *) b;
+
+    if (ka->peer != kb->peer) {
+        return ka->peer < kb->peer ? -1 : 1;
+    }
+    return ka->index < kb->index ? -1 : (ka->index > kb->index);
+}
+
+/* the edges sorted by peer, then in edge order */
+static mca_coll_nbrsm_aggr_key_t *mca_coll_nbrsm_aggr_keys(const mca_coll_nbrsm_edge_t *edges,
+                                                           int degree)
+{
+    mca_coll_nbrsm_aggr_key_t *keys;
+
+    keys = (mca_coll_nbrsm_aggr_key_t *) malloc((degree + 1) * sizeof(mca_coll_nbrsm_aggr_key_t));
+    if (NULL == keys) {
+        return NULL;
+    }
+    for (int i = 0 ; i < degree ; ++i) {
+        keys[i].peer = edges[i].peer;
+        keys[i].index = i;
+    }
+    qsort(keys, degree, sizeof(mca_coll_nbrsm_aggr_key_t), mca_coll_nbrsm_aggr_key_cmp);
+
+    return keys;
+}
+
+/* the nodes flagged in flags[0..nnodes) */
+static int mca_coll_nbrsm_aggr_node_list(const int *flags, int nnodes, int **nodes)
+{
+    int n = 0;
+
+    *nodes = (int *) malloc((nnodes + 1) * sizeof(int));
+    if (NULL == *nodes) {
+        return -1;
+    }
+    for (int i = 0 ; i < nnodes ; ++i) {
+        if (flags[i]) {
+            (*nodes)[n++] = i;
+        }
+    }
+
+    return n;
+}
+
+void mca_coll_nbrsm_aggr_free(mca_coll_nbrsm_aggr_t *aggr)
+{
+    if (NULL != aggr->leader_comm) {
+        ompi_comm_free(&aggr->leader_comm);
+    }
+    if (NULL != aggr->node_comm) {
+        ompi_comm_free(&aggr->node_comm);
+    }
+    free(aggr->node_of);
+    free(aggr->local_rank);
+    free(aggr->send_nodes);
+    free(aggr->recv_nodes);
+    free(aggr->out_seq);
+    free(aggr->in_keys);
+    free(aggr);
+}
+
+/*
+ * Build the node and leader communicators and everything that only
+ * depends on the topology. Collective over the communicator.
+ */
+int mca_coll_nbrsm_aggr_init(mca_coll_nbrsm_module_t *module, struct ompi_communicator_t *comm)
+{
+    const int rank = ompi_comm_rank(comm), size = ompi_comm_size(comm);
+    mca_coll_nbrsm_aggr_t *aggr;
+    mca_coll_nbrsm_aggr_key_t *out_keys = NULL;
+    int node_info[2], node_rank, node_size, *members = NULL, *flags = NULL;
+    int ret;
+
+    aggr = (mca_coll_nbrsm_aggr_t *) calloc(1, sizeof(mca_coll_nbrsm_aggr_t));
+    if (NULL == aggr) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    ret = ompi_comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, NULL, &aggr->node_comm);
+    if (OMPI_SUCCESS != ret) {
+        aggr->node_comm = NULL;
+        goto out;
+    }
+    node_rank = ompi_comm_rank(aggr->node_comm);
+    node_size = ompi_comm_size(aggr->node_comm);
+
+    ret = ompi_comm_split(comm, 0 == node_rank ? 0 : MPI_UNDEFINED, rank, &aggr->leader_comm, false);
+    if (OMPI_SUCCESS != ret || MPI_COMM_NULL == aggr->leader_comm) {
+        aggr->leader_comm = NULL;
+        if (OMPI_SUCCESS != ret) {
+            goto out;
+        }
+    }
+
+    /* the node index is the rank of the leader among the leaders */
+    if (NULL != aggr->leader_comm) {
+        node_info[0] = ompi_comm_rank(aggr->leader_comm);
+        node_info[1] = ompi_comm_size(aggr->leader_comm);
+    }
+    ret = aggr->node_comm->c_coll->coll_bcast(node_info, 2, MPI_INT, 0, aggr->node_comm,
+                                              aggr->node_comm->c_coll->coll_bcast_module);
+    if (OMPI_SUCCESS != ret) {
+        goto out;
+    }
+    aggr->nnodes = node_info[1];
+
+    aggr->node_of = (int *) malloc(size * sizeof(int));
+    aggr->local_rank = (int *) malloc(size * sizeof(int));
+    members = (int *) malloc(node_size * sizeof(int));
+    flags = (int *) calloc(2 * aggr->nnodes, sizeof(int));
+    if (NULL == aggr->node_of || NULL == aggr->local_rank || NULL == members || NULL == flags) {
+        ret = OMPI_ERR_OUT_OF_RESOURCE;
+        goto out;
+    }
+
+    ret = comm->c_coll->coll_allgather(node_info, 1, MPI_INT, aggr->node_of, 1, MPI_INT, comm,
+                                       comm->c_coll->coll_allgather_module);
+    if (OMPI_SUCCESS != ret) {
+        goto out;
+    }
+    ret = aggr->node_comm->c_coll->coll_allgather(&rank, 1, MPI_INT, members, 1, MPI_INT,
+                                                  aggr->node_comm,
+                                                  aggr->node_comm->c_coll->coll_allgather_module);
+    if (OMPI_SUCCESS != ret) {
+        goto out;
+    }
+    for (int i = 0 ; i < size ; ++i) {
+        aggr->local_rank[i] = -1;
+    }
+    for (int i = 0 ; i < node_size ; ++i) {
+        aggr->local_rank[members[i]] = i;
+    }
+
+    /* the k-th block from a rank to a peer is the k-th edge to that peer
+     * on one side and the k-th edge from that rank on the other */
+    aggr->out_seq = (int *) malloc((module->outdegree + 1) * sizeof(int));
+    out_keys = mca_coll_nbrsm_aggr_keys(module->out, module->outdegree);
+    aggr->in_keys = mca_coll_nbrsm_aggr_keys(module->in, module->indegree);
+    if (NULL == aggr->out_seq || NULL == out_keys || NULL == aggr->in_keys) {
+        ret = OMPI_ERR_OUT_OF_RESOURCE;
+        goto out;
+    }
+    for (int i = 0, seq = 0 ; i < module->outdegree ; ++i) {
+        seq = (0 < i && out_keys[i].peer == out_keys[i - 1].peer) ? seq + 1 : 0;
+        aggr->out_seq[out_keys[i].index] = seq;
+    }
+
+    /* the leader exchanges with the union of the nodes of its ranks */
+    for (int i = 0 ; i < module->outdegree ; ++i) {
+        if (module->out[i].aggregated) {
+            flags[aggr->node_of[module->out[i].peer]] = 1;
+        }
+    }
+    for (int i = 0 ; i < module->indegree ; ++i) {
+        if (module->in[i].aggregated) {
+            flags[aggr->nnodes + aggr->node_of[module->in[i].peer]] = 1;
+        }
+    }
+    ret = aggr->node_comm->c_coll->coll_allreduce(MPI_IN_PLACE, flags, 2 * aggr->nnodes, MPI_INT,
+                                                  MPI_MAX, aggr->node_comm,
+                                                  aggr->node_comm->c_coll->coll_allreduce_module);
+    if (OMPI_SUCCESS != ret) {
+        goto out;
+    }
+    /* the edges are symmetric: no other node exchanges with a node without off-node edges */
+    for (int i = 0 ; i < 2 * aggr->nnodes ; ++i) {
+        aggr->active |= 0 != flags[i];
+    }
+    if (NULL != aggr->leader_comm) {
+        aggr->nsend_nodes = mca_coll_nbrsm_aggr_node_list(flags, aggr->nnodes, &aggr->send_nodes);
+        aggr->nrecv_nodes = mca_coll_nbrsm_aggr_node_list(flags + aggr->nnodes, aggr->nnodes,
+                                                          &aggr->recv_nodes);
+        if (aggr->nsend_nodes < 0 || aggr->nrecv_nodes < 0) {
+            ret = OMPI_ERR_OUT_OF_RESOURCE;
+            goto out;
+        }
+    }
+
+    NBRSM_AGGR_EXTRA_RETAIN(aggr->node_comm, comm);
+    if (NULL != aggr->leader_comm) {
+        NBRSM_AGGR_EXTRA_RETAIN(aggr->leader_comm, comm);
+    }
+
+ out:
+    free(members);
+    free(flags);
+    free(out_keys);
+    if (OMPI_SUCCESS != ret) {
+        mca_coll_nbrsm_aggr_free(aggr);
+        return ret;
+    }
+
+    module->aggr = aggr;
+    return OMPI_SUCCESS;
+}
+
+/* grow a buffer kept by the schedule to at least bytes */
+static int mca_coll_nbrsm_aggr_reserve(char **buf, size_t *size, size_t bytes)
+{
+    char *tmp;
+
+    if (bytes <= *size) {
+        return OMPI_SUCCESS;
+    }
+    tmp = (char *) realloc(*buf, bytes);
+    if (NULL == tmp) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    *buf = tmp;
+    *size = bytes;
+
+    return OMPI_SUCCESS;
+}
+
+void mca_coll_nbrsm_aggr_bufs_free(mca_coll_nbrsm_aggr_bufs_t *bufs)
+{
+    free(bufs->packed);
+    free(bufs->gathered);
+    free(bufs->outgoing);
+    free(bufs->incoming);
+    free(bufs->scattered);
+    free(bufs->local_sizes);
+    free(bufs->counts);
+    free(bufs->displs);
+    free(bufs->node_counts);
+    free(bufs->node_displs);
+    free(bufs->node_sizes);
+    free(bufs->reqs);
+    memset(bufs, 0, sizeof(*bufs));
+}
+
+/* the arrays sized by the node and the number of nodes, on the leaders */
+static int mca_coll_nbrsm_aggr_bufs_init(mca_coll_nbrsm_aggr_bufs_t *bufs,
+                                         mca_coll_nbrsm_aggr_t *aggr)
+{
+    const int node_size = ompi_comm_size(aggr->node_comm);
+    const int npeers = aggr->nsend_nodes + aggr->nrecv_nodes;
+
+    if (NULL != bufs->counts) {
+        return OMPI_SUCCESS;
+    }
+
+    bufs->local_sizes = (uint64_t *) malloc(node_size * sizeof(uint64_t));
+    bufs->counts = (size_t *) malloc(node_size * sizeof(size_t));
+    bufs->displs = (ptrdiff_t *) malloc(node_size * sizeof(ptrdiff_t));
+    bufs->node_counts = (size_t *) malloc(aggr->nnodes * sizeof(size_t));
+    bufs->node_displs = (ptrdiff_t *) malloc(aggr->nnodes * sizeof(ptrdiff_t));
+    bufs->node_sizes = (uint64_t *) malloc((npeers + 1) * sizeof(uint64_t));
+    bufs->reqs = (ompi_request_t **) malloc(2 * (npeers + 1) * sizeof(ompi_request_t *));
+    if (NULL == bufs->local_sizes || NULL == bufs->counts || NULL == bufs->displs
+        || NULL == bufs->node_counts || NULL == bufs->node_displs || NULL == bufs->node_sizes
+        || NULL == bufs->reqs) {
+        mca_coll_nbrsm_aggr_bufs_free(bufs);
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Sort the records of a buffer into buckets, bucket_of[] mapping the
+ * receiver of a record to its bucket, writing them to sorted (bytes
+ * long). counts and displs receive the layout of the sorted buffer.
+ */
+static void mca_coll_nbrsm_aggr_sort(const char *records, size_t bytes, const int *bucket_of,
+                                     int nbuckets, char *sorted, size_t *counts, ptrdiff_t *displs)
+{
+    const mca_coll_nbrsm_aggr_hdr_t *hdr;
+    size_t offset, record_size;
+    ptrdiff_t displ = 0;
+
+    for (int i = 0 ; i < nbuckets ; ++i) {
+        counts[i] = 0;
+    }
+    for (offset = 0 ; offset < bytes ; offset += record_size) {
+        hdr = (const mca_coll_nbrsm_aggr_hdr_t *) (records + offset);
+        record_size = NBRSM_AGGR_RECORD_SIZE(hdr->bytes);
+        counts[bucket_of[hdr->dst]] += record_size;
+    }
+    for (int i = 0 ; i < nbuckets ; ++i) {
+        displs[i] = displ;
+        displ += counts[i];
+        counts[i] = 0;
+    }
+
+    /* counts grow back to their value while the records are copied */
+    for (offset = 0 ; offset < bytes ; offset += record_size) {
+        int bucket;
+
+        hdr = (const mca_coll_nbrsm_aggr_hdr_t *) (records + offset);
+        bucket = bucket_of[hdr->dst];
+        record_size = NBRSM_AGGR_RECORD_SIZE(hdr->bytes);
+        memcpy(sorted + displs[bucket] + counts[bucket], hdr, record_size);
+        counts[bucket] += record_size;
+    }
+}
+
+/*
+ * The leaders send the records of their node to the leaders of the
+ * destination nodes, and receive the records for their own node in
+ * bufs->incoming.
+ */
+static int mca_coll_nbrsm_aggr_leaders(mca_coll_nbrsm_aggr_t *aggr,
+                                       mca_coll_nbrsm_aggr_bufs_t *bufs, const char *records,
+                                       size_t bytes, size_t *incoming_bytes)
+{
+    struct ompi_communicator_t *leader_comm = aggr->leader_comm;
+    const int nsend = aggr->nsend_nodes, nrecv = aggr->nrecv_nodes;
+    size_t *counts = bufs->node_counts, total = 0;
+    ptrdiff_t *displs = bufs->node_displs;
+    uint64_t *sizes = bufs->node_sizes;
+    ompi_request_t **reqs = bufs->reqs;
+    int ret, nreqs = 0;
+
+    *incoming_bytes = 0;
+
+    ret = mca_coll_nbrsm_aggr_reserve(&bufs->outgoing, &bufs->outgoing_size, bytes);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    mca_coll_nbrsm_aggr_sort(records, bytes, aggr->node_of, aggr->nnodes, bufs->outgoing, counts,
+                             displs);
+
+    /* sizes first, sent even when empty so the receiver knows what to expect */
+    for (int i = 0 ; i < nrecv ; ++i) {
+        ret = MCA_PML_CALL(irecv(sizes + nsend + i, 1, MPI_UINT64_T, aggr->recv_nodes[i],
+                                 MCA_COLL_NBRSM_TAG_ADDR, leader_comm, reqs + nreqs++));
+        if (OMPI_SUCCESS != ret) {
+            goto out;
+        }
+    }
+    for (int i = 0 ; i < nsend ; ++i) {
+        sizes[i] = counts[aggr->send_nodes[i]];
+        ret = MCA_PML_CALL(isend(sizes + i, 1, MPI_UINT64_T, aggr->send_nodes[i],
+                                 MCA_COLL_NBRSM_TAG_ADDR, MCA_PML_BASE_SEND_STANDARD, leader_comm,
+                                 reqs + nreqs++));
+        if (OMPI_SUCCESS != ret) {
+            goto out;
+        }
+    }
+    ret = ompi_request_wait_all(nreqs, reqs, MPI_STATUSES_IGNORE);
+    if (OMPI_SUCCESS != ret) {
+        goto out;
+    }
+    nreqs = 0;
+
+    for (int i = 0 ; i < nrecv ; ++i) {
+        total += sizes[nsend + i];
+    }
+    ret = mca_coll_nbrsm_aggr_reserve(&bufs->incoming, &bufs->incoming_size, total);
+    if (OMPI_SUCCESS != ret) {
+        goto out;
+    }
+    *incoming_bytes = total;
+
+    /* then one message per node pair */
+    total = 0;
+    for (int i = 0 ; i < nrecv ; ++i) {
+        if (0 < sizes[nsend + i]) {
+            ret = MCA_PML_CALL(irecv(bufs->incoming + total, sizes[nsend + i], MPI_BYTE,
+                                     aggr->recv_nodes[i], MCA_COLL_NBRSM_TAG_BLOCK, leader_comm,
+                                     reqs + nreqs++));
+            if (OMPI_SUCCESS != ret) {
+                goto out;
+            }
+            total += sizes[nsend + i];
+        }
+    }
+    for (int i = 0 ; i < nsend ; ++i) {
+        const int node = aggr->send_nodes[i];
+
+        if (0 < counts[node]) {
+            ret = MCA_PML_CALL(isend(bufs->outgoing + displs[node], counts[node], MPI_BYTE, node,
+                                     MCA_COLL_NBRSM_TAG_BLOCK, MCA_PML_BASE_SEND_STANDARD,
+                                     leader_comm, reqs + nreqs++));
+            if (OMPI_SUCCESS != ret) {
+                goto out;
+            }
+        }
+    }
+    ret = ompi_request_wait_all(nreqs, reqs, MPI_STATUSES_IGNORE);
+    if (OMPI_SUCCESS == ret) {
+        nreqs = 0;
+    }
+
+ out:
+    ompi_coll_base_free_reqs(reqs, nreqs);
+    if (OMPI_SUCCESS != ret) {
+        *incoming_bytes = 0;
+    }
+    return ret;
+}
+
+static int mca_coll_nbrsm_aggr_unpack(mca_coll_nbrsm_sched_t *sched, const char *records,
+                                      size_t bytes)
+{
+    const mca_coll_nbrsm_aggr_key_t *keys = sched->aggr->in_keys;
+    size_t offset, record_size;
+
+    for (offset = 0 ; offset < bytes ; offset += record_size) {
+        const mca_coll_nbrsm_aggr_hdr_t *hdr = (const mca_coll_nbrsm_aggr_hdr_t *) (records + offset);
+        mca_coll_nbrsm_block_t *block;
+        int lo = 0, hi = sched->indegree, idx;
+
+        record_size = NBRSM_AGGR_RECORD_SIZE(hdr->bytes);
+
+        /* first in-edge from the sender, then the seq-th one after it */
+        while (lo < hi) {
+            const int mid = lo + (hi - lo) / 2;
+
+            if (keys[mid].peer < hdr->src) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        idx = lo + hdr->seq;
+        if (idx >= sched->indegree || keys[idx].peer != hdr->src) {
+            return OMPI_ERROR;
+        }
+
+        block = sched->recvs + keys[idx].index;
+        if (!block->aggregated || block->bytes != hdr->bytes) {
+            return MPI_ERR_TRUNCATE;
+        }
+        if (MPI_SUCCESS != ompi_datatype_sndrcv(hdr + 1, (int32_t) block->bytes, MPI_PACKED,
+                                                block->buf, (int32_t) block->count, block->dtype)) {
+            return OMPI_ERROR;
+        }
+    }
+
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Exchange the aggregated blocks of a schedule. Collective over the node,
+ * and over the leaders on the leaders; only called on the nodes with
+ * off-node edges.
+ */
+int mca_coll_nbrsm_aggr_exchange(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm)
+{
+    mca_coll_nbrsm_aggr_t *aggr = sched->aggr;
+    mca_coll_nbrsm_aggr_bufs_t *bufs = &sched->aggr_bufs;
+    struct ompi_communicator_t *node_comm = aggr->node_comm;
+    const int rank = ompi_comm_rank(comm), node_size = ompi_comm_size(node_comm);
+    const bool leader = NULL != aggr->leader_comm;
+    size_t gathered_bytes = 0, incoming_bytes = 0;
+    uint64_t my_bytes = 0;
+    ompi_count_array_t count_array;
+    ompi_disp_array_t disp_array;
+    char *p;
+    int ret;
+
+    if (leader) {
+        ret = mca_coll_nbrsm_aggr_bufs_init(bufs, aggr);
+        if (OMPI_SUCCESS != ret) {
+            return ret;
+        }
+    }
+
+    /* pack the off-node blocks behind their headers */
+    for (int i = 0 ; i < sched->outdegree ; ++i) {
+        if (sched->sends[i].aggregated) {
+            my_bytes += NBRSM_AGGR_RECORD_SIZE(sched->sends[i].bytes);
+        }
+    }
+    ret = mca_coll_nbrsm_aggr_reserve(&bufs->packed, &bufs->packed_size, my_bytes);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    p = bufs->packed;
+    for (int i = 0 ; i < sched->outdegree ; ++i) {
+        const mca_coll_nbrsm_block_t *block = sched->sends + i;
+        mca_coll_nbrsm_aggr_hdr_t hdr;
+
+        if (!block->aggregated) {
+            continue;
+        }
+        hdr.src = rank;
+        hdr.dst = sched->out[i].peer;
+        hdr.seq = aggr->out_seq[i];
+        hdr.pad = 0;
+        hdr.bytes = block->bytes;
+        memcpy(p, &hdr, sizeof(hdr));
+        if (MPI_SUCCESS != ompi_datatype_sndrcv(block->buf, (int32_t) block->count, block->dtype,
+                                                p + sizeof(hdr), (int32_t) block->bytes,
+                                                MPI_PACKED)) {
+            return OMPI_ERROR;
+        }
+        p += NBRSM_AGGR_RECORD_SIZE(block->bytes);
+    }
+
+    /* step 1: gather at the leader */
+    ret = node_comm->c_coll->coll_gather(&my_bytes, 1, MPI_UINT64_T, bufs->local_sizes, 1,
+                                         MPI_UINT64_T, 0, node_comm,
+                                         node_comm->c_coll->coll_gather_module);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (leader) {
+        for (int i = 0 ; i < node_size ; ++i) {
+            bufs->counts[i] = bufs->local_sizes[i];
+            bufs->displs[i] = gathered_bytes;
+            gathered_bytes += bufs->local_sizes[i];
+        }
+        ret = mca_coll_nbrsm_aggr_reserve(&bufs->gathered, &bufs->gathered_size, gathered_bytes);
+        if (OMPI_SUCCESS != ret) {
+            return ret;
+        }
+    }
+    ompi_count_array_init_c(&count_array, bufs->counts);
+    ompi_disp_array_init_c(&disp_array, bufs->displs);
+    ret = node_comm->c_coll->coll_gatherv(bufs->packed, my_bytes, MPI_BYTE, bufs->gathered,
+                                          count_array, disp_array, MPI_BYTE, 0, node_comm,
+                                          node_comm->c_coll->coll_gatherv_module);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    /* step 2: one message per pair of nodes, then sort by receiver */
+    if (leader) {
+        ret = mca_coll_nbrsm_aggr_leaders(aggr, bufs, bufs->gathered, gathered_bytes,
+                                          &incoming_bytes);
+        if (OMPI_SUCCESS == ret) {
+            ret = mca_coll_nbrsm_aggr_reserve(&bufs->gathered, &bufs->gathered_size,
+                                              incoming_bytes);
+        }
+        if (OMPI_SUCCESS != ret) {
+            return ret;
+        }
+        mca_coll_nbrsm_aggr_sort(bufs->incoming, incoming_bytes, aggr->local_rank, node_size,
+                                 bufs->gathered, bufs->counts, bufs->displs);
+        for (int i = 0 ; i < node_size ; ++i) {
+            bufs->local_sizes[i] = bufs->counts[i];
+        }
+    }
+
+    /* step 3: scatter to the receivers */
+    ret = node_comm->c_coll->coll_scatter(bufs->local_sizes, 1, MPI_UINT64_T, &my_bytes, 1,
+                                          MPI_UINT64_T, 0, node_comm,
+                                          node_comm->c_coll->coll_scatter_module);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    ret = mca_coll_nbrsm_aggr_reserve(&bufs->scattered, &bufs->scattered_size, my_bytes);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    ret = node_comm->c_coll->coll_scatterv(bufs->gathered, count_array, disp_array, MPI_BYTE,
+                                           bufs->scattered, my_bytes, MPI_BYTE, 0, node_comm,
+                                           node_comm->c_coll->coll_scatterv_module);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    return mca_coll_nbrsm_aggr_unpack(sched, bufs->scattered, my_bytes);
+}
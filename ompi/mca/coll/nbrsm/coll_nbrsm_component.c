@@ -0,0 +1,136 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "opal/runtime/opal_progress.h"
+#include "opal/util/output.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "coll_nbrsm.h"
+
+/*
+ * Public string showing the coll ompi_nbrsm component version number
+ */
+const char *mca_coll_nbrsm_component_version_string =
+    "Open MPI shared memory neighborhood collective MCA component version " OMPI_VERSION;
+
+/*
+ * Local functions
+ */
+static int nbrsm_register(void);
+static int nbrsm_open(void);
+static int nbrsm_close(void);
+
+/*
+ * Instantiate the public struct with all of our public information
+ * and pointers to our public functions in it
+ */
+
+mca_coll_nbrsm_component_t mca_coll_nbrsm_component = {
+    {
+        /* First, the mca_component_t struct containing meta information
+         * about the component itself */
+
+        .collm_version = {
+            MCA_COLL_BASE_VERSION_3_0_0,
+
+            /* Component name and version */
+            .mca_component_name = "nbrsm",
+            MCA_BASE_MAKE_VERSION(component, OMPI_MAJOR_VERSION, OMPI_MINOR_VERSION,
+                                  OMPI_RELEASE_VERSION),
+
+            /* Component open and close functions */
+            .mca_open_component = nbrsm_open,
+            .mca_close_component = nbrsm_close,
+            .mca_register_component_params = nbrsm_register
+        },
+        .collm_data = {
+            /* The component is checkpoint ready */
+            MCA_BASE_METADATA_PARAM_CHECKPOINT
+        },
+
+        /* Initialization / querying functions */
+
+        .collm_init_query = mca_coll_nbrsm_init_query,
+        .collm_comm_query = mca_coll_nbrsm_comm_query
+    },
+};
+MCA_BASE_COMPONENT_INIT(ompi, coll, nbrsm)
+
+
+static int nbrsm_register(void)
+{
+    mca_base_component_t *c = &mca_coll_nbrsm_component.super.collm_version;
+
+    mca_coll_nbrsm_component.priority = 0;
+    (void) mca_base_component_var_register(c, "priority",
+                                           "Priority of the nbrsm coll component; it only provides the "
+                                           "neighborhood collectives, so it must be above basic (10) to be used",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_coll_nbrsm_component.priority);
+
+    mca_coll_nbrsm_component.min_size = 4096;
+    (void) mca_base_component_var_register(c, "min_size",
+                                           "Blocks of at least this many bytes exchanged with a neighbour "
+                                           "on the same node are copied directly from the sender's buffer; "
+                                           "smaller blocks go through the PML",
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                           OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_coll_nbrsm_component.min_size);
+
+    mca_coll_nbrsm_component.persistent_plans = false;
+    (void) mca_base_component_var_register(c, "persistent_plans",
+                                           "Provide MPI_Neighbor_*_init on distributed graph communicators. "
+                                           "The exchange schedule is built once and the peers' buffers stay "
+                                           "mapped between starts. Plans of communicators whose off-node "
+                                           "blocks are aggregated are left to the next component",
+                                           MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                           OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_coll_nbrsm_component.persistent_plans);
+
+    mca_coll_nbrsm_component.aggregate = false;
+    (void) mca_base_component_var_register(c, "aggregate",
+                                           "Combine the blocks sent to neighbours on other nodes: every rank "
+                                           "hands them to the leader of its node, which sends one message per "
+                                           "destination node. All the ranks of the communicator must use this "
+                                           "component, and the first neighborhood collective of a communicator "
+                                           "creates node and leader communicators",
+                                           MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                           OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_coll_nbrsm_component.aggregate);
+
+    return OMPI_SUCCESS;
+}
+
+static int nbrsm_open(void)
+{
+    OBJ_CONSTRUCT(&mca_coll_nbrsm_component.active_plans, opal_list_t);
+    OBJ_CONSTRUCT(&mca_coll_nbrsm_component.plan_lock, opal_mutex_t);
+    mca_coll_nbrsm_component.plan_progress_registered = 0;
+
+    return OMPI_SUCCESS;
+}
+
+static int nbrsm_close(void)
+{
+    if (mca_coll_nbrsm_component.plan_progress_registered) {
+        opal_progress_unregister(mca_coll_nbrsm_plan_progress);
+    }
+    OBJ_DESTRUCT(&mca_coll_nbrsm_component.active_plans);
+    OBJ_DESTRUCT(&mca_coll_nbrsm_component.plan_lock);
+
+    return OMPI_SUCCESS;
+}
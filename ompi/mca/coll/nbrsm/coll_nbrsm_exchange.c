@@ -0,0 +1,494 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * The exchange shared by all the neighborhood collectives. A schedule
+ * lists the block of every edge; the collectives only differ in how they
+ * lay the blocks out in the user buffers.
+ *
+ * An on-node block (mca_coll_nbrsm_block_t.single_copy) goes through
+ * three messages:
+ *
+ *   sender                              receiver
+ *     ADDR (address of the block)  ->
+ *                                       copy from the sender's buffer
+ *                                  <-   DONE (empty)
+ *
+ * Both ends decide single_copy from the locality of the edge and the size
+ * of the block, which agree because the type signatures of a neighborhood
+ * collective must match. A sender with a non-contiguous block posts a
+ * NULL address and sends the block with the BLOCK tag; the receiver
+ * handles the in-edges in order, so blocks from the same peer still match
+ * in order.
+ *
+ * Aggregated blocks (coll_nbrsm_aggregate) skip the PML entirely; they
+ * are combined per node in coll_nbrsm_aggregate.c between posting the
+ * addresses and copying the on-node blocks, so that no rank waits on a
+ * neighbour that is still in the node level collectives.
+ */
+
+#include "ompi_config.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpi.h"
+
+#include "opal/mca/rcache/rcache.h"
+
+#include "ompi/constants.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/mca/pml/pml.h"
+#include "ompi/mca/coll/base/coll_base_functions.h"
+#include "ompi/request/request.h"
+#include "coll_nbrsm.h"
+
+int mca_coll_nbrsm_sched_alloc(mca_coll_nbrsm_sched_t *sched, mca_coll_nbrsm_module_t *module)
+{
+    const int nedges = module->indegree + module->outdegree;
+
+    memset(sched, 0, sizeof(*sched));
+    sched->indegree = module->indegree;
+    sched->outdegree = module->outdegree;
+    sched->in = module->in;
+    sched->out = module->out;
+    sched->aggr = module->aggr;
+    sched->addr_tag = MCA_COLL_NBRSM_TAG_ADDR;
+    sched->done_tag = MCA_COLL_NBRSM_TAG_DONE;
+    sched->block_tag = MCA_COLL_NBRSM_TAG_BLOCK;
+    if (0 == nedges) {
+        return OMPI_SUCCESS;
+    }
+
+    sched->recvs = (mca_coll_nbrsm_block_t *) calloc(nedges, sizeof(mca_coll_nbrsm_block_t));
+    sched->addrs = (uint64_t *) calloc(nedges, sizeof(uint64_t));
+    /* every edge posts at most two messages */
+    sched->reqs = (ompi_request_t **) calloc(2 * nedges, sizeof(ompi_request_t *));
+    if (NULL == sched->recvs || NULL == sched->addrs || NULL == sched->reqs) {
+        mca_coll_nbrsm_sched_free(sched);
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    sched->sends = sched->recvs + sched->indegree;
+
+    return OMPI_SUCCESS;
+}
+
+void mca_coll_nbrsm_sched_free(mca_coll_nbrsm_sched_t *sched)
+{
+    for (int i = 0 ; NULL != sched->recvs && i < sched->indegree ; ++i) {
+        if (NULL != sched->recvs[i].reg) {
+            MCA_SMSC_CALL(unmap_peer_region, sched->recvs[i].reg);
+        }
+    }
+
+    free(sched->recvs);
+    free(sched->addrs);
+    free(sched->reqs);
+    mca_coll_nbrsm_aggr_bufs_free(&sched->aggr_bufs);
+    memset(sched, 0, sizeof(*sched));
+}
+
+void mca_coll_nbrsm_sched_set_block(mca_coll_nbrsm_block_t *block, const mca_coll_nbrsm_edge_t *edge,
+                                    const void *buf, size_t count, struct ompi_datatype_t *dtype)
+{
+    ptrdiff_t true_lb, true_extent;
+    size_t size;
+
+    block->buf = (char *) buf;
+    block->count = count;
+    block->dtype = dtype;
+    ompi_datatype_type_size(dtype, &size);
+    block->bytes = size * count;
+
+    /* blocks larger than an int would not fit the unpacking below */
+    block->single_copy = edge->local && 0 < block->bytes && block->bytes <= INT_MAX &&
+                         block->bytes >= mca_coll_nbrsm_component.min_size;
+    /* the same bound for the packing of the aggregated blocks */
+    block->aggregated = edge->aggregated && 0 < block->bytes && block->bytes <= INT_MAX;
+    block->contiguous = false;
+    block->data = NULL;
+    if (block->single_copy) {
+        block->contiguous = ompi_datatype_is_contiguous_memory_layout(dtype, (int32_t) count);
+        ompi_datatype_get_true_extent(dtype, &true_lb, &true_extent);
+        block->data = block->buf + true_lb;
+    }
+}
+
+/* the packed form of a block is its bytes in order */
+static int mca_coll_nbrsm_unpack(mca_coll_nbrsm_block_t *block, const void *packed)
+{
+    return ompi_datatype_sndrcv(packed, (int32_t) block->bytes, MPI_PACKED,
+                                block->buf, (int32_t) block->count, block->dtype);
+}
+
+static int mca_coll_nbrsm_copy_in(mca_coll_nbrsm_sched_t *sched, const mca_coll_nbrsm_edge_t *edge,
+                                  mca_coll_nbrsm_block_t *block, void *remote)
+{
+    void *local, *reg;
+    int ret = OMPI_SUCCESS;
+
+    if (!mca_smsc_base_has_feature(MCA_SMSC_FEATURE_CAN_MAP)) {
+        char *tmp;
+
+        if (block->contiguous) {
+            return MCA_SMSC_CALL(copy_from, edge->endpoint, block->data, remote, block->bytes, NULL);
+        }
+
+        tmp = (char *) malloc(block->bytes);
+        if (NULL == tmp) {
+            return OMPI_ERR_OUT_OF_RESOURCE;
+        }
+        ret = MCA_SMSC_CALL(copy_from, edge->endpoint, tmp, remote, block->bytes, NULL);
+        if (OPAL_SUCCESS == ret) {
+            ret = mca_coll_nbrsm_unpack(block, tmp);
+        }
+        free(tmp);
+        return ret;
+    }
+
+    if (NULL != block->reg && block->remote == remote) {
+        /* persistent plan, the sender's block is already mapped */
+        local = block->mapped;
+        reg = block->reg;
+    } else {
+        if (NULL != block->reg) {
+            MCA_SMSC_CALL(unmap_peer_region, block->reg);
+            block->reg = NULL;
+        }
+        reg = MCA_SMSC_CALL(map_peer_region, edge->endpoint, MCA_RCACHE_FLAGS_PERSIST, remote,
+                            block->bytes, &local);
+        if (NULL == reg) {
+            return OMPI_ERROR;
+        }
+        if (sched->keep_mappings) {
+            block->remote = remote;
+            block->mapped = local;
+            block->reg = reg;
+        }
+    }
+
+    if (block->contiguous) {
+        memcpy(block->data, local, block->bytes);
+    } else {
+        ret = mca_coll_nbrsm_unpack(block, local);
+    }
+
+    if (!sched->keep_mappings) {
+        MCA_SMSC_CALL(unmap_peer_region, reg);
+    }
+
+    return ret;
+}
+
+/* post the receives, the addresses and the blocks that do not wait for
+ * an address; the first request of in-edge i is reqs[i] */
+int mca_coll_nbrsm_sched_post(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm)
+{
+    ompi_request_t **reqs = sched->reqs;
+    uint64_t *in_addrs = sched->addrs, *out_addrs = sched->addrs + sched->indegree;
+    int ret = OMPI_SUCCESS, i;
+
+    sched->nreqs = sched->ndone = sched->next_in = 0;
+    sched->error = OMPI_SUCCESS;
+
+    for (i = 0 ; i < sched->indegree ; ++i) {
+        mca_coll_nbrsm_block_t *block = sched->recvs + i;
+
+        if (block->aggregated) {
+            reqs[i] = MPI_REQUEST_NULL;
+            continue;
+        }
+        if (block->single_copy) {
+            ret = MCA_PML_CALL(irecv(in_addrs + i, 1, MPI_UINT64_T, sched->in[i].peer,
+                                     sched->addr_tag, comm, reqs + i));
+        } else {
+            ret = MCA_PML_CALL(irecv(block->buf, block->count, block->dtype, sched->in[i].peer,
+                                     sched->tag, comm, reqs + i));
+        }
+        if (OMPI_SUCCESS != ret) {
+            ompi_coll_base_free_reqs(reqs, i);
+            return ret;
+        }
+    }
+    sched->nreqs = sched->indegree;
+
+    for (i = 0 ; i < sched->outdegree ; ++i) {
+        mca_coll_nbrsm_block_t *block = sched->sends + i;
+        const int peer = sched->out[i].peer;
+
+        if (block->aggregated) {
+            continue;
+        }
+        if (!block->single_copy) {
+            /* remove cast from const when the pml layer is updated to take a const for the send buffer */
+            ret = MCA_PML_CALL(isend(block->buf, block->count, block->dtype, peer, sched->tag,
+                                     MCA_PML_BASE_SEND_STANDARD, comm, reqs + sched->nreqs++));
+            if (OMPI_SUCCESS != ret) {
+                goto err;
+            }
+            continue;
+        }
+
+        out_addrs[i] = block->contiguous ? (uint64_t) (uintptr_t) block->data : 0;
+        if (block->contiguous) {
+            ret = MCA_PML_CALL(irecv(NULL, 0, MPI_BYTE, peer, sched->done_tag, comm,
+                                     reqs + sched->nreqs++));
+            if (OMPI_SUCCESS != ret) {
+                goto err;
+            }
+        }
+        ret = MCA_PML_CALL(isend(out_addrs + i, 1, MPI_UINT64_T, peer, sched->addr_tag,
+                                 MCA_PML_BASE_SEND_STANDARD, comm, reqs + sched->nreqs++));
+        if (OMPI_SUCCESS != ret) {
+            goto err;
+        }
+        if (!block->contiguous) {
+            ret = MCA_PML_CALL(isend(block->buf, block->count, block->dtype, peer,
+                                     sched->block_tag, MCA_PML_BASE_SEND_STANDARD, comm,
+                                     reqs + sched->nreqs++));
+            if (OMPI_SUCCESS != ret) {
+                goto err;
+            }
+        }
+    }
+
+    return OMPI_SUCCESS;
+
+ err:
+    ompi_coll_base_free_reqs(reqs, sched->nreqs);
+    sched->nreqs = 0;
+    return ret;
+}
+
+/* the address of in-edge i arrived: copy the block and acknowledge, or
+ * receive it through the PML when the sender posted no address */
+static int mca_coll_nbrsm_sched_take(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm,
+                                     int i)
+{
+    mca_coll_nbrsm_block_t *block = sched->recvs + i;
+    const int peer = sched->in[i].peer;
+    int ret;
+
+    if (0 == sched->addrs[i]) {
+        return MCA_PML_CALL(irecv(block->buf, block->count, block->dtype, peer, sched->block_tag,
+                                  comm, sched->reqs + sched->nreqs++));
+    }
+
+    ret = mca_coll_nbrsm_copy_in(sched, sched->in + i, block, (void *) (uintptr_t) sched->addrs[i]);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    return MCA_PML_CALL(isend(NULL, 0, MPI_BYTE, peer, sched->done_tag, MCA_PML_BASE_SEND_STANDARD,
+                              comm, sched->reqs + sched->nreqs++));
+}
+
+int mca_coll_nbrsm_sched_run(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm)
+{
+    ompi_request_t **reqs = sched->reqs;
+    int ret, i;
+
+    /* a rank without edges still takes part in the aggregation of its node */
+    if (0 == sched->indegree + sched->outdegree
+        && (NULL == sched->aggr || !sched->aggr->active)) {
+        return OMPI_SUCCESS;
+    }
+
+    ret = mca_coll_nbrsm_sched_post(sched, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    if (NULL != sched->aggr && sched->aggr->active) {
+        ret = mca_coll_nbrsm_aggr_exchange(sched, comm);
+        if (OMPI_SUCCESS != ret) {
+            goto err;
+        }
+    }
+
+    /* all the addresses are posted, copy the on-node blocks in edge order */
+    for (i = 0 ; i < sched->indegree ; ++i) {
+        if (!sched->recvs[i].single_copy) {
+            continue;
+        }
+
+        ret = ompi_request_wait(reqs + i, MPI_STATUS_IGNORE);
+        if (OMPI_SUCCESS != ret) {
+            goto err;
+        }
+        ret = mca_coll_nbrsm_sched_take(sched, comm, i);
+        if (OMPI_SUCCESS != ret) {
+            goto err;
+        }
+    }
+
+    ret = ompi_request_wait_all(sched->nreqs, reqs, MPI_STATUSES_IGNORE);
+    if (OMPI_SUCCESS == ret) {
+        return OMPI_SUCCESS;
+    }
+
+ err:
+    ompi_coll_base_free_reqs(reqs, sched->nreqs);
+    return ret;
+}
+
+/*
+ * The steps of mca_coll_nbrsm_sched_run that would wait, for the
+ * persistent plans: take the addresses that arrived, in edge order, then
+ * check the remaining requests. Return true once the exchange is over,
+ * with its status in sched->error. Schedules with aggregated blocks are
+ * not handled here.
+ */
+bool mca_coll_nbrsm_sched_test(mca_coll_nbrsm_sched_t *sched, struct ompi_communicator_t *comm)
+{
+    ompi_request_t **reqs = sched->reqs;
+
+    for ( ; sched->next_in < sched->indegree ; ++sched->next_in) {
+        const int i = sched->next_in;
+
+        if (!sched->recvs[i].single_copy) {
+            continue;
+        }
+        if (!REQUEST_COMPLETE(reqs[i])) {
+            return false;
+        }
+
+        sched->error = reqs[i]->req_status.MPI_ERROR;
+        ompi_request_free(reqs + i);
+        if (OMPI_SUCCESS == sched->error) {
+            sched->error = mca_coll_nbrsm_sched_take(sched, comm, i);
+        }
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != sched->error)) {
+            /* as in mca_coll_nbrsm_sched_run, the peers are not waited for */
+            ompi_coll_base_free_reqs(reqs, sched->nreqs);
+            return true;
+        }
+    }
+
+    for ( ; sched->ndone < sched->nreqs ; ++sched->ndone) {
+        if (!REQUEST_COMPLETE(reqs[sched->ndone])) {
+            return false;
+        }
+    }
+
+    for (int i = 0 ; i < sched->nreqs ; ++i) {
+        if (MPI_REQUEST_NULL == reqs[i]) {
+            continue;
+        }
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != reqs[i]->req_status.MPI_ERROR)
+            && OMPI_SUCCESS == sched->error) {
+            sched->error = reqs[i]->req_status.MPI_ERROR;
+        }
+        ompi_request_free(reqs + i);
+    }
+
+    return true;
+}
+
+/*
+ * Block layouts of the collectives
+ */
+
+void mca_coll_nbrsm_sched_allgather(mca_coll_nbrsm_sched_t *sched, const void *sbuf, size_t scount,
+                                    struct ompi_datatype_t *sdtype, void *rbuf, size_t rcount,
+                                    struct ompi_datatype_t *rdtype)
+{
+    ptrdiff_t lb, rdextent;
+
+    ompi_datatype_get_extent(rdtype, &lb, &rdextent);
+    sched->tag = MCA_COLL_BASE_TAG_ALLGATHER;
+    for (int i = 0 ; i < sched->indegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->recvs + i, sched->in + i,
+                                       (char *) rbuf + (ptrdiff_t) i * rcount * rdextent, rcount, rdtype);
+    }
+    for (int i = 0 ; i < sched->outdegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->sends + i, sched->out + i, sbuf, scount, sdtype);
+    }
+}
+
+void mca_coll_nbrsm_sched_allgatherv(mca_coll_nbrsm_sched_t *sched, const void *sbuf, size_t scount,
+                                     struct ompi_datatype_t *sdtype, void *rbuf,
+                                     ompi_count_array_t rcounts, ompi_disp_array_t displs,
+                                     struct ompi_datatype_t *rdtype)
+{
+    ptrdiff_t lb, rdextent;
+
+    ompi_datatype_get_extent(rdtype, &lb, &rdextent);
+    sched->tag = MCA_COLL_BASE_TAG_ALLGATHER;
+    for (int i = 0 ; i < sched->indegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->recvs + i, sched->in + i,
+                                       (char *) rbuf + ompi_disp_array_get(displs, i) * rdextent,
+                                       ompi_count_array_get(rcounts, i), rdtype);
+    }
+    for (int i = 0 ; i < sched->outdegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->sends + i, sched->out + i, sbuf, scount, sdtype);
+    }
+}
+
+void mca_coll_nbrsm_sched_alltoall(mca_coll_nbrsm_sched_t *sched, const void *sbuf, size_t scount,
+                                   struct ompi_datatype_t *sdtype, void *rbuf, size_t rcount,
+                                   struct ompi_datatype_t *rdtype)
+{
+    ptrdiff_t lb, rdextent, sdextent;
+
+    ompi_datatype_get_extent(rdtype, &lb, &rdextent);
+    ompi_datatype_get_extent(sdtype, &lb, &sdextent);
+    sched->tag = MCA_COLL_BASE_TAG_ALLTOALL;
+    for (int i = 0 ; i < sched->indegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->recvs + i, sched->in + i,
+                                       (char *) rbuf + (ptrdiff_t) i * rcount * rdextent, rcount, rdtype);
+    }
+    for (int i = 0 ; i < sched->outdegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->sends + i, sched->out + i,
+                                       (const char *) sbuf + (ptrdiff_t) i * scount * sdextent, scount, sdtype);
+    }
+}
+
+void mca_coll_nbrsm_sched_alltoallv(mca_coll_nbrsm_sched_t *sched, const void *sbuf,
+                                    ompi_count_array_t scounts, ompi_disp_array_t sdispls,
+                                    struct ompi_datatype_t *sdtype, void *rbuf,
+                                    ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                    struct ompi_datatype_t *rdtype)
+{
+    ptrdiff_t lb, rdextent, sdextent;
+
+    ompi_datatype_get_extent(rdtype, &lb, &rdextent);
+    ompi_datatype_get_extent(sdtype, &lb, &sdextent);
+    sched->tag = MCA_COLL_BASE_TAG_ALLTOALL;
+    for (int i = 0 ; i < sched->indegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->recvs + i, sched->in + i,
+                                       (char *) rbuf + ompi_disp_array_get(rdispls, i) * rdextent,
+                                       ompi_count_array_get(rcounts, i), rdtype);
+    }
+    for (int i = 0 ; i < sched->outdegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->sends + i, sched->out + i,
+                                       (const char *) sbuf + ompi_disp_array_get(sdispls, i) * sdextent,
+                                       ompi_count_array_get(scounts, i), sdtype);
+    }
+}
+
+/* the displacements of alltoallw are in bytes */
+void mca_coll_nbrsm_sched_alltoallw(mca_coll_nbrsm_sched_t *sched, const void *sbuf,
+                                    ompi_count_array_t scounts, ompi_disp_array_t sdispls,
+                                    struct ompi_datatype_t *const *sdtypes, void *rbuf,
+                                    ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                    struct ompi_datatype_t *const *rdtypes)
+{
+    sched->tag = MCA_COLL_BASE_TAG_ALLTOALL;
+    for (int i = 0 ; i < sched->indegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->recvs + i, sched->in + i,
+                                       (char *) rbuf + ompi_disp_array_get(rdispls, i),
+                                       ompi_count_array_get(rcounts, i), rdtypes[i]);
+    }
+    for (int i = 0 ; i < sched->outdegree ; ++i) {
+        mca_coll_nbrsm_sched_set_block(sched->sends + i, sched->out + i,
+                                       (const char *) sbuf + ompi_disp_array_get(sdispls, i),
+                                       ompi_count_array_get(scounts, i), sdtypes[i]);
+    }
+}
@@ -0,0 +1,316 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpi.h"
+
+#include "opal/util/output.h"
+#include "opal/mca/threads/mutex.h"
+
+#include "ompi/constants.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/group/group.h"
+#include "ompi/mca/coll/coll.h"
+#include "ompi/mca/coll/base/base.h"
+#include "ompi/mca/topo/topo.h"
+#include "coll_nbrsm.h"
+
+static opal_mutex_t mca_coll_nbrsm_lock = OPAL_MUTEX_STATIC_INIT;
+
+static int
+mca_coll_nbrsm_module_enable(mca_coll_base_module_t *module,
+                             struct ompi_communicator_t *comm);
+static int
+mca_coll_nbrsm_module_disable(mca_coll_base_module_t *module,
+                              struct ompi_communicator_t *comm);
+
+static void mca_coll_nbrsm_module_construct(mca_coll_nbrsm_module_t *module)
+{
+    module->topo_ready = false;
+    module->indegree = module->outdegree = 0;
+    module->in = module->out = NULL;
+    module->aggr = NULL;
+    module->plan_tag = MCA_COLL_NBRSM_TAG_PLAN_BASE;
+    memset(&module->sched, 0, sizeof(module->sched));
+}
+
+static void mca_coll_nbrsm_module_destruct(mca_coll_nbrsm_module_t *module)
+{
+    mca_coll_nbrsm_sched_free(&module->sched);
+    if (NULL != module->aggr) {
+        mca_coll_nbrsm_aggr_free(module->aggr);
+    }
+    free(module->in);
+    free(module->out);
+}
+
+OBJ_CLASS_INSTANCE(mca_coll_nbrsm_module_t, mca_coll_base_module_t,
+                   mca_coll_nbrsm_module_construct,
+                   mca_coll_nbrsm_module_destruct);
+
+
+static bool mca_coll_nbrsm_single_copy_available(void)
+{
+    return NULL != mca_smsc && !mca_smsc_base_has_feature(MCA_SMSC_FEATURE_REQUIRE_REGISTRATION);
+}
+
+/*
+ * Initial query function that is invoked during MPI_INIT, allowing
+ * this component to disqualify itself if it doesn't support the
+ * required level of thread support.
+ */
+int mca_coll_nbrsm_init_query(bool enable_progress_threads,
+                              bool enable_mpi_threads)
+{
+    /* Nothing to do */
+    return OMPI_SUCCESS;
+}
+
+
+/*
+ * Invoked when there's a new communicator that has been created.  The
+ * topology is not attached yet (the coll selection happens when the
+ * communicator is duplicated), so every intra-communicator with another
+ * process on this node gets a module and the neighborhood collectives
+ * check the topology when they are called.
+ */
+mca_coll_base_module_t *
+mca_coll_nbrsm_comm_query(struct ompi_communicator_t *comm,
+                          int *priority)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module;
+
+    if ((*priority = mca_coll_nbrsm_component.priority) < 0) {
+        return NULL;
+    }
+
+    if (OMPI_COMM_IS_INTER(comm) || 1 == ompi_comm_size(comm)) {
+        return NULL;
+    }
+
+    /* when aggregating every rank has to take part, with or without single
+     * copy on its node */
+    if (!mca_coll_nbrsm_component.aggregate && !mca_coll_nbrsm_single_copy_available()) {
+        opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                            "coll:nbrsm:comm_query (%s/%s): no smsc module without registration; "
+                            "disqualifying myself", ompi_comm_print_cid(comm), comm->c_name);
+        return NULL;
+    }
+
+    /* a process alone on its node only has off-node edges, which coll/basic
+     * exchanges with the same tags */
+    if (!mca_coll_nbrsm_component.aggregate &&
+        ompi_group_count_local_peers(comm->c_local_group) < 2) {
+        opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                            "coll:nbrsm:comm_query (%s/%s): no other process on this node; "
+                            "disqualifying myself", ompi_comm_print_cid(comm), comm->c_name);
+        return NULL;
+    }
+
+    nbrsm_module = OBJ_NEW(mca_coll_nbrsm_module_t);
+    if (NULL == nbrsm_module) {
+        return NULL;
+    }
+
+    nbrsm_module->super.coll_module_enable = mca_coll_nbrsm_module_enable;
+    nbrsm_module->super.coll_module_disable = mca_coll_nbrsm_module_disable;
+
+    nbrsm_module->super.coll_neighbor_allgather = mca_coll_nbrsm_neighbor_allgather;
+    nbrsm_module->super.coll_neighbor_allgatherv = mca_coll_nbrsm_neighbor_allgatherv;
+    nbrsm_module->super.coll_neighbor_alltoall = mca_coll_nbrsm_neighbor_alltoall;
+    nbrsm_module->super.coll_neighbor_alltoallv = mca_coll_nbrsm_neighbor_alltoallv;
+    nbrsm_module->super.coll_neighbor_alltoallw = mca_coll_nbrsm_neighbor_alltoallw;
+    if (mca_coll_nbrsm_component.persistent_plans) {
+        nbrsm_module->super.coll_neighbor_allgather_init = mca_coll_nbrsm_neighbor_allgather_init;
+        nbrsm_module->super.coll_neighbor_allgatherv_init = mca_coll_nbrsm_neighbor_allgatherv_init;
+        nbrsm_module->super.coll_neighbor_alltoall_init = mca_coll_nbrsm_neighbor_alltoall_init;
+        nbrsm_module->super.coll_neighbor_alltoallv_init = mca_coll_nbrsm_neighbor_alltoallv_init;
+        nbrsm_module->super.coll_neighbor_alltoallw_init = mca_coll_nbrsm_neighbor_alltoallw_init;
+    }
+
+    opal_output_verbose(10, ompi_coll_base_framework.framework_output,
+                        "coll:nbrsm:comm_query (%s/%s): pick me! pick me!",
+                        ompi_comm_print_cid(comm), comm->c_name);
+    return &(nbrsm_module->super);
+}
+
+/* only take over the collectives that have a fallback below us */
+#define NBRSM_INSTALL_COLL_API(__comm, __module, __api)                                    \
+    do {                                                                                   \
+        if (NULL != __module->super.coll_##__api) {                                        \
+            if (NULL == __comm->c_coll->coll_##__api ||                                    \
+                NULL == __comm->c_coll->coll_##__api##_module) {                           \
+                opal_output_verbose(10, ompi_coll_base_framework.framework_output,         \
+                                    "coll:nbrsm:module_enable (%s/%s): no underlying "     \
+                                    #__api, ompi_comm_print_cid(__comm), __comm->c_name); \
+            } else {                                                                       \
+                MCA_COLL_SAVE_API(__comm, __api, __module->previous_##__api,               \
+                                  __module->previous_##__api##_module, "nbrsm");           \
+                MCA_COLL_INSTALL_API(__comm, __api, __module->super.coll_##__api,          \
+                                     &__module->super, "nbrsm");                           \
+            }                                                                              \
+        }                                                                                  \
+    } while (0)
+
+#define NBRSM_UNINSTALL_COLL_API(__comm, __module, __api)                                  \
+    do {                                                                                   \
+        if (__comm->c_coll->coll_##__api##_module == &__module->super) {                   \
+            MCA_COLL_INSTALL_API(__comm, __api, __module->previous_##__api,                \
+                                 __module->previous_##__api##_module, "nbrsm");            \
+        }                                                                                  \
+    } while (0)
+
+/*
+ * Init module on the communicator
+ */
+static int
+mca_coll_nbrsm_module_enable(mca_coll_base_module_t *module,
+                             struct ompi_communicator_t *comm)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_allgather);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_allgatherv);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoall);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallv);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallw);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_allgather_init);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_allgatherv_init);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoall_init);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallv_init);
+    NBRSM_INSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallw_init);
+
+    return OMPI_SUCCESS;
+}
+
+static int
+mca_coll_nbrsm_module_disable(mca_coll_base_module_t *module,
+                              struct ompi_communicator_t *comm)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_allgather);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_allgatherv);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoall);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallv);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallw);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_allgather_init);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_allgatherv_init);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoall_init);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallv_init);
+    NBRSM_UNINSTALL_COLL_API(comm, nbrsm_module, neighbor_alltoallw_init);
+
+    return OMPI_SUCCESS;
+}
+
+/* the smsc endpoint is cached on the proc, as coll/han does */
+static struct mca_smsc_endpoint_t *mca_coll_nbrsm_get_endpoint(struct ompi_proc_t *proc)
+{
+    if (NULL == proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_SMSC]) {
+        OPAL_THREAD_LOCK(&mca_coll_nbrsm_lock);
+        if (NULL == proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_SMSC]) {
+            proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_SMSC] = MCA_SMSC_CALL(get_endpoint, &proc->super);
+        }
+        OPAL_THREAD_UNLOCK(&mca_coll_nbrsm_lock);
+    }
+
+    return (struct mca_smsc_endpoint_t *) proc->proc_endpoints[OMPI_PROC_ENDPOINT_TAG_SMSC];
+}
+
+static int mca_coll_nbrsm_edges_init(mca_coll_nbrsm_edge_t **edges, const int *peers, int degree,
+                                     struct ompi_communicator_t *comm)
+{
+    const int rank = ompi_comm_rank(comm);
+    const bool single_copy = mca_coll_nbrsm_single_copy_available();
+
+    *edges = NULL;
+    if (0 == degree) {
+        return OMPI_SUCCESS;
+    }
+
+    *edges = (mca_coll_nbrsm_edge_t *) malloc(degree * sizeof(mca_coll_nbrsm_edge_t));
+    if (NULL == *edges) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    for (int i = 0 ; i < degree ; ++i) {
+        mca_coll_nbrsm_edge_t *edge = *edges + i;
+        struct ompi_proc_t *proc = ompi_comm_peer_lookup(comm, peers[i]);
+        const bool on_node = OPAL_PROC_ON_LOCAL_NODE(proc->super.proc_flags);
+
+        edge->peer = peers[i];
+        edge->endpoint = NULL;
+        /* both ends of an edge must make the same choice, and a self edge
+         * is left to the PML */
+        edge->local = single_copy && (peers[i] != rank) && on_node;
+        edge->aggregated = mca_coll_nbrsm_component.aggregate && !on_node;
+        if (edge->local) {
+            edge->endpoint = mca_coll_nbrsm_get_endpoint(proc);
+            if (NULL == edge->endpoint) {
+                /* the peer would still expect the on-node protocol */
+                opal_output_verbose(1, ompi_coll_base_framework.framework_output,
+                                    "coll:nbrsm: no smsc endpoint for rank %d of %s",
+                                    peers[i], comm->c_name);
+                free(*edges);
+                *edges = NULL;
+                return OMPI_ERROR;
+            }
+        }
+    }
+
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Resolve the edges of the distributed graph once. The topology of a
+ * communicator never changes, so the result is kept until the module is
+ * destroyed. With aggregation this is collective over the communicator.
+ */
+int mca_coll_nbrsm_topo_init(mca_coll_nbrsm_module_t *module,
+                             struct ompi_communicator_t *comm)
+{
+    const mca_topo_base_comm_dist_graph_2_2_0_t *dist_graph = comm->c_topo->mtc.dist_graph;
+    int ret;
+
+    if (module->topo_ready) {
+        return OMPI_SUCCESS;
+    }
+
+    ret = mca_coll_nbrsm_edges_init(&module->in, dist_graph->in, dist_graph->indegree, comm);
+    if (OMPI_SUCCESS == ret) {
+        ret = mca_coll_nbrsm_edges_init(&module->out, dist_graph->out, dist_graph->outdegree, comm);
+    }
+    if (OMPI_SUCCESS == ret) {
+        module->indegree = dist_graph->indegree;
+        module->outdegree = dist_graph->outdegree;
+        if (mca_coll_nbrsm_component.aggregate) {
+            ret = mca_coll_nbrsm_aggr_init(module, comm);
+        }
+    }
+    if (OMPI_SUCCESS == ret) {
+        ret = mca_coll_nbrsm_sched_alloc(&module->sched, module);
+    }
+    if (OMPI_SUCCESS != ret) {
+        if (NULL != module->aggr) {
+            mca_coll_nbrsm_aggr_free(module->aggr);
+            module->aggr = NULL;
+        }
+        free(module->in);
+        free(module->out);
+        module->in = module->out = NULL;
+        return ret;
+    }
+
+    module->topo_ready = true;
+    return OMPI_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Blocking neighborhood collectives. Distributed graph communicators
+ * reuse the schedule of the module, everything else goes to the
+ * component below.
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "coll_nbrsm.h"
+
+int mca_coll_nbrsm_neighbor_allgather(const void *sbuf, size_t scount,
+                                      struct ompi_datatype_t *sdtype, void *rbuf,
+                                      size_t rcount, struct ompi_datatype_t *rdtype,
+                                      struct ompi_communicator_t *comm,
+                                      mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    int ret;
+
+    if (!OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        return nbrsm_module->previous_neighbor_allgather(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm,
+                                                         nbrsm_module->previous_neighbor_allgather_module);
+    }
+
+    ret = mca_coll_nbrsm_topo_init(nbrsm_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_allgather(&nbrsm_module->sched, sbuf, scount, sdtype, rbuf, rcount, rdtype);
+    return mca_coll_nbrsm_sched_run(&nbrsm_module->sched, comm);
+}
+
+int mca_coll_nbrsm_neighbor_allgatherv(const void *sbuf, size_t scount,
+                                       struct ompi_datatype_t *sdtype, void *rbuf,
+                                       ompi_count_array_t rcounts, ompi_disp_array_t displs,
+                                       struct ompi_datatype_t *rdtype,
+                                       struct ompi_communicator_t *comm,
+                                       mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    int ret;
+
+    if (!OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        return nbrsm_module->previous_neighbor_allgatherv(sbuf, scount, sdtype, rbuf, rcounts, displs,
+                                                          rdtype, comm,
+                                                          nbrsm_module->previous_neighbor_allgatherv_module);
+    }
+
+    ret = mca_coll_nbrsm_topo_init(nbrsm_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_allgatherv(&nbrsm_module->sched, sbuf, scount, sdtype, rbuf, rcounts, displs,
+                                    rdtype);
+    return mca_coll_nbrsm_sched_run(&nbrsm_module->sched, comm);
+}
+
+int mca_coll_nbrsm_neighbor_alltoall(const void *sbuf, size_t scount,
+                                     struct ompi_datatype_t *sdtype, void *rbuf,
+                                     size_t rcount, struct ompi_datatype_t *rdtype,
+                                     struct ompi_communicator_t *comm,
+                                     mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    int ret;
+
+    if (!OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        return nbrsm_module->previous_neighbor_alltoall(sbuf, scount, sdtype, rbuf, rcount, rdtype, comm,
+                                                        nbrsm_module->previous_neighbor_alltoall_module);
+    }
+
+    ret = mca_coll_nbrsm_topo_init(nbrsm_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_alltoall(&nbrsm_module->sched, sbuf, scount, sdtype, rbuf, rcount, rdtype);
+    return mca_coll_nbrsm_sched_run(&nbrsm_module->sched, comm);
+}
+
+int mca_coll_nbrsm_neighbor_alltoallv(const void *sbuf, ompi_count_array_t scounts,
+                                      ompi_disp_array_t sdispls, struct ompi_datatype_t *sdtype,
+                                      void *rbuf, ompi_count_array_t rcounts,
+                                      ompi_disp_array_t rdispls, struct ompi_datatype_t *rdtype,
+                                      struct ompi_communicator_t *comm,
+                                      mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    int ret;
+
+    if (!OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        return nbrsm_module->previous_neighbor_alltoallv(sbuf, scounts, sdispls, sdtype, rbuf, rcounts,
+                                                         rdispls, rdtype, comm,
+                                                         nbrsm_module->previous_neighbor_alltoallv_module);
+    }
+
+    ret = mca_coll_nbrsm_topo_init(nbrsm_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_alltoallv(&nbrsm_module->sched, sbuf, scounts, sdispls, sdtype, rbuf, rcounts,
+                                   rdispls, rdtype);
+    return mca_coll_nbrsm_sched_run(&nbrsm_module->sched, comm);
+}
+
+int mca_coll_nbrsm_neighbor_alltoallw(const void *sbuf, ompi_count_array_t scounts,
+                                      ompi_disp_array_t sdispls,
+                                      struct ompi_datatype_t *const *sdtypes, void *rbuf,
+                                      ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                      struct ompi_datatype_t *const *rdtypes,
+                                      struct ompi_communicator_t *comm,
+                                      mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    int ret;
+
+    if (!OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        return nbrsm_module->previous_neighbor_alltoallw(sbuf, scounts, sdispls, sdtypes, rbuf, rcounts,
+                                                         rdispls, rdtypes, comm,
+                                                         nbrsm_module->previous_neighbor_alltoallw_module);
+    }
+
+    ret = mca_coll_nbrsm_topo_init(nbrsm_module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_alltoallw(&nbrsm_module->sched, sbuf, scounts, sdispls, sdtypes, rbuf, rcounts,
+                                   rdispls, rdtypes);
+    return mca_coll_nbrsm_sched_run(&nbrsm_module->sched, comm);
+}
@@ -0,0 +1,397 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Persistent neighborhood collective plans.
+ *
+ * MPI_Neighbor_*_init builds the schedule of the exchange once: the
+ * blocks of every edge, their sizes and contiguity, and which ones are
+ * copied through smsc. The receivers keep the mapping of their on-node
+ * senders' blocks after the first start, so later starts only exchange
+ * the control messages and copy.
+ *
+ * MPI_Start posts the receives and the addresses; the copies, the
+ * acknowledgements and the completion happen in
+ * mca_coll_nbrsm_plan_progress, so a plan never blocks. Every plan has
+ * control tags of its own, as plans started together may take the
+ * addresses of their in-edges in any order; they are reused after about
+ * 340 plans on the same communicator. The aggregation of the off-node
+ * blocks goes through blocking collectives on the node, so when it is
+ * active the plans are left to the component below.
+ */
+
+#include "ompi_config.h"
+
+#include <string.h>
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/request/request.h"
+#include "ompi/mca/coll/base/coll_base_util.h"
+#include "opal/runtime/opal_progress.h"
+#include "coll_nbrsm.h"
+
+typedef struct mca_coll_nbrsm_plan_t {
+    ompi_coll_base_nbc_request_t super;
+
+    struct ompi_communicator_t *comm;
+    mca_coll_nbrsm_sched_t sched;
+} mca_coll_nbrsm_plan_t;
+
+/* return if invoked recursively */
+static bool mca_coll_nbrsm_plan_in_progress = false;
+
+/* return true once the exchange is over */
+static bool mca_coll_nbrsm_plan_advance(mca_coll_nbrsm_plan_t *plan)
+{
+    if (!mca_coll_nbrsm_sched_test(&plan->sched, plan->comm)) {
+        return false;
+    }
+
+    plan->super.super.req_status.MPI_ERROR = plan->sched.error;
+    return true;
+}
+
+int mca_coll_nbrsm_plan_progress(void)
+{
+    mca_coll_nbrsm_plan_t *plan, *next;
+    int completed = 0;
+
+    if (0 == opal_list_get_size(&mca_coll_nbrsm_component.active_plans)) {
+        /* no started plan -- nothing to do. do not grab a lock */
+        return 0;
+    }
+
+    OPAL_THREAD_LOCK(&mca_coll_nbrsm_component.plan_lock);
+    if (!mca_coll_nbrsm_plan_in_progress) {
+        mca_coll_nbrsm_plan_in_progress = true;
+
+        OPAL_LIST_FOREACH_SAFE(plan, next, &mca_coll_nbrsm_component.active_plans,
+                               mca_coll_nbrsm_plan_t) {
+            OPAL_THREAD_UNLOCK(&mca_coll_nbrsm_component.plan_lock);
+            if (mca_coll_nbrsm_plan_advance(plan)) {
+                OPAL_THREAD_LOCK(&mca_coll_nbrsm_component.plan_lock);
+                opal_list_remove_item(&mca_coll_nbrsm_component.active_plans,
+                                      &plan->super.super.super.super);
+                OPAL_THREAD_UNLOCK(&mca_coll_nbrsm_component.plan_lock);
+
+                ompi_request_complete(&plan->super.super, true);
+                ++completed;
+            }
+            OPAL_THREAD_LOCK(&mca_coll_nbrsm_component.plan_lock);
+        }
+        mca_coll_nbrsm_plan_in_progress = false;
+    }
+    OPAL_THREAD_UNLOCK(&mca_coll_nbrsm_component.plan_lock);
+
+    return completed;
+}
+
+static int mca_coll_nbrsm_plan_start(size_t count, ompi_request_t **requests)
+{
+    for (size_t i = 0 ; i < count ; ++i) {
+        mca_coll_nbrsm_plan_t *plan = (mca_coll_nbrsm_plan_t *) requests[i];
+        int ret;
+
+        plan->super.super.req_state = OMPI_REQUEST_ACTIVE;
+        plan->super.super.req_complete = REQUEST_PENDING;
+        plan->super.super.req_status.MPI_ERROR = OMPI_SUCCESS;
+
+        ret = mca_coll_nbrsm_sched_post(&plan->sched, plan->comm);
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != ret)) {
+            /* nothing is in flight: report the error on this plan and on
+             * the ones that were not started */
+            for (size_t j = i ; j < count ; ++j) {
+                requests[j]->req_state = OMPI_REQUEST_ACTIVE;
+                requests[j]->req_status.MPI_ERROR = ret;
+                ompi_request_complete(requests[j], true);
+            }
+            return ret;
+        }
+
+        if (mca_coll_nbrsm_plan_advance(plan)) {
+            ompi_request_complete(&plan->super.super, true);
+            continue;
+        }
+
+        OPAL_THREAD_LOCK(&mca_coll_nbrsm_component.plan_lock);
+        opal_list_append(&mca_coll_nbrsm_component.active_plans, &plan->super.super.super.super);
+        OPAL_THREAD_UNLOCK(&mca_coll_nbrsm_component.plan_lock);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+static int mca_coll_nbrsm_plan_cancel(struct ompi_request_t *request, int complete)
+{
+    return MPI_ERR_REQUEST;
+}
+
+static int mca_coll_nbrsm_plan_free(struct ompi_request_t **request)
+{
+    mca_coll_nbrsm_plan_t *plan = (mca_coll_nbrsm_plan_t *) *request;
+
+    if (!REQUEST_COMPLETE(&plan->super.super)) {
+        return MPI_ERR_REQUEST;
+    }
+
+    OMPI_REQUEST_FINI(&plan->super.super);
+    OBJ_RELEASE(plan);
+    *request = MPI_REQUEST_NULL;
+
+    return OMPI_SUCCESS;
+}
+
+static void mca_coll_nbrsm_plan_construct(mca_coll_nbrsm_plan_t *plan)
+{
+    plan->super.super.req_type = OMPI_REQUEST_COLL;
+    plan->super.super.req_start = mca_coll_nbrsm_plan_start;
+    plan->super.super.req_free = mca_coll_nbrsm_plan_free;
+    plan->super.super.req_cancel = mca_coll_nbrsm_plan_cancel;
+    memset(&plan->sched, 0, sizeof(plan->sched));
+}
+
+static void mca_coll_nbrsm_plan_destruct(mca_coll_nbrsm_plan_t *plan)
+{
+    const int nedges = plan->sched.indegree + plan->sched.outdegree;
+
+    /* the sends follow the receives in the same array */
+    for (int i = 0 ; NULL != plan->sched.recvs && i < nedges ; ++i) {
+        if (!ompi_datatype_is_predefined(plan->sched.recvs[i].dtype)) {
+            OBJ_RELEASE(plan->sched.recvs[i].dtype);
+        }
+    }
+    mca_coll_nbrsm_sched_free(&plan->sched);
+}
+
+static OBJ_CLASS_INSTANCE(mca_coll_nbrsm_plan_t, ompi_coll_base_nbc_request_t,
+                          mca_coll_nbrsm_plan_construct, mca_coll_nbrsm_plan_destruct);
+
+/* OMPI_ERR_NOT_SUPPORTED when the plan is left to the component below */
+static int mca_coll_nbrsm_plan_new(mca_coll_nbrsm_module_t *module, struct ompi_communicator_t *comm,
+                                   mca_coll_nbrsm_plan_t **plan_out)
+{
+    mca_coll_nbrsm_plan_t *plan;
+    int ret;
+
+    ret = mca_coll_nbrsm_topo_init(module, comm);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    if (NULL != module->aggr && module->aggr->active) {
+        return OMPI_ERR_NOT_SUPPORTED;
+    }
+
+    plan = OBJ_NEW(mca_coll_nbrsm_plan_t);
+    if (NULL == plan) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    OMPI_REQUEST_INIT(&plan->super.super, true);
+    plan->super.super.req_mpi_object.comm = comm;
+    plan->super.super.req_status._cancelled = 0;
+    plan->comm = comm;
+
+    ret = mca_coll_nbrsm_sched_alloc(&plan->sched, module);
+    if (OMPI_SUCCESS != ret) {
+        OBJ_RELEASE(plan);
+        return ret;
+    }
+    plan->sched.keep_mappings = true;
+
+    /* The off-node blocks take one tag of the nonblocking range, like
+     * the component below, so they match the ranks that leave their plans
+     * to it. The control messages only go to the ranks of this node, which
+     * all create the same plans: they take the next tags of a fixed range. */
+    plan->sched.tag = ompi_coll_base_nbc_reserve_tags(comm, 1);
+    if (module->plan_tag - 2 < MCA_COLL_BASE_TAG_NEIGHBOR_END) {
+        module->plan_tag = MCA_COLL_NBRSM_TAG_PLAN_BASE;
+    }
+    plan->sched.addr_tag = module->plan_tag;
+    plan->sched.done_tag = module->plan_tag - 1;
+    plan->sched.block_tag = module->plan_tag - 2;
+    module->plan_tag -= 3;
+
+    *plan_out = plan;
+    return OMPI_SUCCESS;
+}
+
+/* the user may free the datatypes before the plan */
+static int mca_coll_nbrsm_plan_ready(mca_coll_nbrsm_plan_t *plan, ompi_request_t **request)
+{
+    const int nedges = plan->sched.indegree + plan->sched.outdegree;
+    int32_t registered = 0;
+
+    for (int i = 0 ; i < nedges ; ++i) {
+        if (!ompi_datatype_is_predefined(plan->sched.recvs[i].dtype)) {
+            OBJ_RETAIN(plan->sched.recvs[i].dtype);
+        }
+    }
+
+    OPAL_OUTPUT_VERBOSE((30, ompi_coll_base_framework.framework_output,
+                         "coll:nbrsm: plan with %d in-edges and %d out-edges on communicator (%s/%s)",
+                         plan->sched.indegree, plan->sched.outdegree,
+                         ompi_comm_print_cid(plan->comm), plan->comm->c_name));
+
+    if (OPAL_ATOMIC_COMPARE_EXCHANGE_STRONG_32(&mca_coll_nbrsm_component.plan_progress_registered,
+                                               &registered, 1)) {
+        opal_progress_register(mca_coll_nbrsm_plan_progress);
+    }
+
+    *request = &plan->super.super;
+    return OMPI_SUCCESS;
+}
+
+int mca_coll_nbrsm_neighbor_allgather_init(const void *sbuf, size_t scount,
+                                           struct ompi_datatype_t *sdtype, void *rbuf,
+                                           size_t rcount, struct ompi_datatype_t *rdtype,
+                                           struct ompi_communicator_t *comm,
+                                           struct ompi_info_t *info, ompi_request_t **request,
+                                           mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    mca_coll_nbrsm_plan_t *plan;
+    int ret;
+
+    ret = OMPI_ERR_NOT_SUPPORTED;
+    if (OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        ret = mca_coll_nbrsm_plan_new(nbrsm_module, comm, &plan);
+    }
+    if (OMPI_ERR_NOT_SUPPORTED == ret) {
+        return nbrsm_module->previous_neighbor_allgather_init(sbuf, scount, sdtype, rbuf, rcount, rdtype,
+                                                              comm, info, request,
+                                                              nbrsm_module->previous_neighbor_allgather_init_module);
+    }
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_allgather(&plan->sched, sbuf, scount, sdtype, rbuf, rcount, rdtype);
+    return mca_coll_nbrsm_plan_ready(plan, request);
+}
+
+int mca_coll_nbrsm_neighbor_allgatherv_init(const void *sbuf, size_t scount,
+                                            struct ompi_datatype_t *sdtype, void *rbuf,
+                                            ompi_count_array_t rcounts, ompi_disp_array_t displs,
+                                            struct ompi_datatype_t *rdtype,
+                                            struct ompi_communicator_t *comm,
+                                            struct ompi_info_t *info, ompi_request_t **request,
+                                            mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    mca_coll_nbrsm_plan_t *plan;
+    int ret;
+
+    ret = OMPI_ERR_NOT_SUPPORTED;
+    if (OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        ret = mca_coll_nbrsm_plan_new(nbrsm_module, comm, &plan);
+    }
+    if (OMPI_ERR_NOT_SUPPORTED == ret) {
+        return nbrsm_module->previous_neighbor_allgatherv_init(sbuf, scount, sdtype, rbuf, rcounts, displs,
+                                                               rdtype, comm, info, request,
+                                                               nbrsm_module->previous_neighbor_allgatherv_init_module);
+    }
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_allgatherv(&plan->sched, sbuf, scount, sdtype, rbuf, rcounts, displs, rdtype);
+    return mca_coll_nbrsm_plan_ready(plan, request);
+}
+
+int mca_coll_nbrsm_neighbor_alltoall_init(const void *sbuf, size_t scount,
+                                          struct ompi_datatype_t *sdtype, void *rbuf,
+                                          size_t rcount, struct ompi_datatype_t *rdtype,
+                                          struct ompi_communicator_t *comm,
+                                          struct ompi_info_t *info, ompi_request_t **request,
+                                          mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    mca_coll_nbrsm_plan_t *plan;
+    int ret;
+
+    ret = OMPI_ERR_NOT_SUPPORTED;
+    if (OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        ret = mca_coll_nbrsm_plan_new(nbrsm_module, comm, &plan);
+    }
+    if (OMPI_ERR_NOT_SUPPORTED == ret) {
+        return nbrsm_module->previous_neighbor_alltoall_init(sbuf, scount, sdtype, rbuf, rcount, rdtype,
+                                                             comm, info, request,
+                                                             nbrsm_module->previous_neighbor_alltoall_init_module);
+    }
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_alltoall(&plan->sched, sbuf, scount, sdtype, rbuf, rcount, rdtype);
+    return mca_coll_nbrsm_plan_ready(plan, request);
+}
+
+int mca_coll_nbrsm_neighbor_alltoallv_init(const void *sbuf, ompi_count_array_t scounts,
+                                           ompi_disp_array_t sdispls,
+                                           struct ompi_datatype_t *sdtype, void *rbuf,
+                                           ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                           struct ompi_datatype_t *rdtype,
+                                           struct ompi_communicator_t *comm,
+                                           struct ompi_info_t *info, ompi_request_t **request,
+                                           mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    mca_coll_nbrsm_plan_t *plan;
+    int ret;
+
+    ret = OMPI_ERR_NOT_SUPPORTED;
+    if (OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        ret = mca_coll_nbrsm_plan_new(nbrsm_module, comm, &plan);
+    }
+    if (OMPI_ERR_NOT_SUPPORTED == ret) {
+        return nbrsm_module->previous_neighbor_alltoallv_init(sbuf, scounts, sdispls, sdtype, rbuf, rcounts,
+                                                              rdispls, rdtype, comm, info, request,
+                                                              nbrsm_module->previous_neighbor_alltoallv_init_module);
+    }
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_alltoallv(&plan->sched, sbuf, scounts, sdispls, sdtype, rbuf, rcounts, rdispls,
+                                   rdtype);
+    return mca_coll_nbrsm_plan_ready(plan, request);
+}
+
+int mca_coll_nbrsm_neighbor_alltoallw_init(const void *sbuf, ompi_count_array_t scounts,
+                                           ompi_disp_array_t sdispls,
+                                           struct ompi_datatype_t *const *sdtypes, void *rbuf,
+                                           ompi_count_array_t rcounts, ompi_disp_array_t rdispls,
+                                           struct ompi_datatype_t *const *rdtypes,
+                                           struct ompi_communicator_t *comm,
+                                           struct ompi_info_t *info, ompi_request_t **request,
+                                           mca_coll_base_module_t *module)
+{
+    mca_coll_nbrsm_module_t *nbrsm_module = (mca_coll_nbrsm_module_t *) module;
+    mca_coll_nbrsm_plan_t *plan;
+    int ret;
+
+    ret = OMPI_ERR_NOT_SUPPORTED;
+    if (OMPI_COMM_IS_DIST_GRAPH(comm)) {
+        ret = mca_coll_nbrsm_plan_new(nbrsm_module, comm, &plan);
+    }
+    if (OMPI_ERR_NOT_SUPPORTED == ret) {
+        return nbrsm_module->previous_neighbor_alltoallw_init(sbuf, scounts, sdispls, sdtypes, rbuf, rcounts,
+                                                              rdispls, rdtypes, comm, info, request,
+                                                              nbrsm_module->previous_neighbor_alltoallw_init_module);
+    }
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    mca_coll_nbrsm_sched_alltoallw(&plan->sched, sbuf, scounts, sdispls, sdtypes, rbuf, rcounts, rdispls,
+                                   rdtypes);
+    return mca_coll_nbrsm_plan_ready(plan, request);
+}
@@ -47,6 +47,7 @@ extern int   ompi_coll_tuned_scatter_intermediate_msg;
 extern int   ompi_coll_tuned_scatter_large_msg;
 extern int   ompi_coll_tuned_scatter_min_procs;
 extern int   ompi_coll_tuned_scatter_blocking_send_ratio;
+extern bool  ompi_coll_tuned_persistent_plans;
 
 /* forced algorithm choices */
 /* this structure is for storing the indexes to the forced algorithm mca params... */
@@ -73,6 +74,24 @@ struct coll_tuned_force_algorithm_params_t {
 };
 typedef struct coll_tuned_force_algorithm_params_t coll_tuned_force_algorithm_params_t;
 
+/* algorithm and parameters resolved by a decision function, without running
+ * the collective (used to freeze the choice in persistent plans) */
+struct coll_tuned_decision_t {
+    int  algorithm;
+    int  faninout;
+    int  segsize;
+    int  max_requests;
+};
+typedef struct coll_tuned_decision_t coll_tuned_decision_t;
+
+#define COLL_TUNED_SET_DECISION(DECISION, ALG, FANINOUT, SEGSIZE, MAX_REQUESTS) \
+    do {                                                                \
+        (DECISION)->algorithm = (ALG);                                  \
+        (DECISION)->faninout = (FANINOUT);                              \
+        (DECISION)->segsize = (SEGSIZE);                                \
+        (DECISION)->max_requests = (MAX_REQUESTS);                      \
+    } while (0)
+
 /* the indices to the MCA params so that modules can look them up at open / comm create time  */
 extern coll_tuned_force_algorithm_mca_param_indices_t ompi_coll_tuned_forced_params[COLLCOUNT];
 /* the actual max algorithm values (readonly), loaded at component open */
@@ -115,6 +134,12 @@ int ompi_coll_tuned_allgatherv_intra_check_forced_init(coll_tuned_force_algorith
 int ompi_coll_tuned_allreduce_intra_dec_fixed(ALLREDUCE_ARGS);
 int ompi_coll_tuned_allreduce_intra_dec_dynamic(ALLREDUCE_ARGS);
 int ompi_coll_tuned_allreduce_intra_do_this(ALLREDUCE_ARGS, int algorithm, int faninout, int segsize);
+void ompi_coll_tuned_allreduce_intra_decide_fixed(size_t count, struct ompi_datatype_t *dtype, struct ompi_op_t *op,
+                                                  struct ompi_communicator_t *comm, coll_tuned_decision_t *decision);
+void ompi_coll_tuned_allreduce_intra_decide_dynamic(size_t count, struct ompi_datatype_t *dtype, struct ompi_op_t *op,
+                                                    struct ompi_communicator_t *comm, mca_coll_base_module_t *module,
+                                                    coll_tuned_decision_t *decision);
+int ompi_coll_tuned_allreduce_intra_init(ALLREDUCE_INIT_ARGS);
 int ompi_coll_tuned_allreduce_intra_check_forced_init (coll_tuned_force_algorithm_mca_param_indices_t *mca_param_indices);
 
 /* AlltoAll */
@@ -140,6 +165,14 @@ int ompi_coll_tuned_bcast_intra_dec_fixed(BCAST_ARGS);
 int ompi_coll_tuned_bcast_intra_disjoint_dec_fixed(BCAST_ARGS);
 int ompi_coll_tuned_bcast_intra_dec_dynamic(BCAST_ARGS);
 int ompi_coll_tuned_bcast_intra_do_this(BCAST_ARGS, int algorithm, int faninout, int segsize);
+void ompi_coll_tuned_bcast_intra_decide_fixed(size_t count, struct ompi_datatype_t *datatype, int root,
+                                              struct ompi_communicator_t *comm, coll_tuned_decision_t *decision);
+void ompi_coll_tuned_bcast_intra_disjoint_decide_fixed(size_t count, struct ompi_datatype_t *datatype, int root,
+                                                       struct ompi_communicator_t *comm, coll_tuned_decision_t *decision);
+void ompi_coll_tuned_bcast_intra_decide_dynamic(size_t count, struct ompi_datatype_t *datatype, int root,
+                                                struct ompi_communicator_t *comm, mca_coll_base_module_t *module,
+                                                coll_tuned_decision_t *decision);
+int ompi_coll_tuned_bcast_intra_init(BCAST_INIT_ARGS);
 int ompi_coll_tuned_bcast_intra_check_forced_init (coll_tuned_force_algorithm_mca_param_indices_t *mca_param_indices);
 
 /* Gather */
@@ -152,6 +185,12 @@ int ompi_coll_tuned_gather_intra_check_forced_init (coll_tuned_force_algorithm_m
 int ompi_coll_tuned_reduce_intra_dec_fixed(REDUCE_ARGS);
 int ompi_coll_tuned_reduce_intra_dec_dynamic(REDUCE_ARGS);
 int ompi_coll_tuned_reduce_intra_do_this(REDUCE_ARGS, int algorithm, int faninout, int segsize, int max_oustanding_reqs);
+void ompi_coll_tuned_reduce_intra_decide_fixed(size_t count, struct ompi_datatype_t *datatype, struct ompi_op_t *op,
+                                               int root, struct ompi_communicator_t *comm, coll_tuned_decision_t *decision);
+void ompi_coll_tuned_reduce_intra_decide_dynamic(size_t count, struct ompi_datatype_t *datatype, struct ompi_op_t *op,
+                                                 int root, struct ompi_communicator_t *comm, mca_coll_base_module_t *module,
+                                                 coll_tuned_decision_t *decision);
+int ompi_coll_tuned_reduce_intra_init(REDUCE_INIT_ARGS);
 int ompi_coll_tuned_reduce_intra_check_forced_init (coll_tuned_force_algorithm_mca_param_indices_t *mca_param_indices);
 
 /* Reduce_scatter */
@@ -197,6 +236,12 @@ struct mca_coll_tuned_component_t {
 
 	/* cached decision table stuff (moved from MCW module) */
 	ompi_coll_alg_rule_t *all_base_rules;
+
+	/* persistent plans with a round in flight, driven by ompi_coll_tuned_plan_progress */
+	opal_list_t active_plans;
+	opal_mutex_t plan_lock;
+	/* set once the progress function of the plans is registered */
+	opal_atomic_int32_t plan_progress_registered;
 };
 /**
  * Convenience typedef
@@ -217,10 +262,22 @@ struct mca_coll_tuned_module_t {
 
     /* the communicator rules for each MPI collective for ONLY my comsize */
     ompi_coll_com_rule_t *com_rules[COLLCOUNT];
+
+    /* persistent collectives of the previous component, used for the
+     * algorithms the plans cannot schedule */
+    mca_coll_base_module_allreduce_init_fn_t previous_allreduce_init;
+    mca_coll_base_module_t *previous_allreduce_init_module;
+    mca_coll_base_module_bcast_init_fn_t previous_bcast_init;
+    mca_coll_base_module_t *previous_bcast_init_module;
+    mca_coll_base_module_reduce_init_fn_t previous_reduce_init;
+    mca_coll_base_module_t *previous_reduce_init_module;
 };
 typedef struct mca_coll_tuned_module_t mca_coll_tuned_module_t;
 OBJ_CLASS_DECLARATION(mca_coll_tuned_module_t);
 
+/* progress the started persistent plans */
+int ompi_coll_tuned_plan_progress(void);
+
 int coll_tuned_alg_from_str(int collective_id, const char *alg_name, int *alg_index);
 int coll_tuned_alg_to_str(int collective_id, int alg_value, char **alg_string);
 int coll_tuned_alg_register_options(int collective_id, mca_base_var_enum_t *options);
@@ -35,6 +35,7 @@
 
 #include "ompi_config.h"
 #include "opal/util/output.h"
+#include "opal/runtime/opal_progress.h"
 #include "coll_tuned.h"
 
 #include "mpi.h"
@@ -71,6 +72,9 @@ int   ompi_coll_tuned_scatter_large_msg = 0;
 int   ompi_coll_tuned_scatter_min_procs = 0;
 int   ompi_coll_tuned_scatter_blocking_send_ratio = 0;
 
+/* persistent collective plans are opt-in */
+bool  ompi_coll_tuned_persistent_plans = false;
+
 static int deprecated_mca_params = -1;
 
 /* forced algorithm variables */
@@ -196,6 +200,15 @@ static int tuned_register(void)
                                            MCA_BASE_VAR_SCOPE_ALL,
                                            &ompi_coll_tuned_dynamic_rules_filename);
 
+    ompi_coll_tuned_persistent_plans = false;
+    (void) mca_base_component_var_register(&mca_coll_tuned_component.super.collm_version,
+                                           "persistent_plans",
+                                           "Provide MPI_Allreduce_init, MPI_Bcast_init and MPI_Reduce_init. The algorithm decision is resolved once when the request is created and turned into a non-blocking schedule with its temporary buffers; MPI_Start posts the first round and the progress engine runs the others. Algorithms without a schedule are handed to the next component",
+                                           MCA_BASE_VAR_TYPE_BOOL, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                           OPAL_INFO_LVL_6,
+                                           MCA_BASE_VAR_SCOPE_ALL,
+                                           &ompi_coll_tuned_persistent_plans);
+
     ompi_coll_tuned_verbose = 0;
     (void) mca_base_component_var_register(&mca_coll_tuned_component.super.collm_version,
                                            "verbose",
@@ -228,6 +241,10 @@ static int tuned_open(void)
 {
     int rc;
 
+    OBJ_CONSTRUCT(&mca_coll_tuned_component.active_plans, opal_list_t);
+    OBJ_CONSTRUCT(&mca_coll_tuned_component.plan_lock, opal_mutex_t);
+    mca_coll_tuned_component.plan_progress_registered = 0;
+
     if (ompi_coll_tuned_verbose) {
         ompi_coll_tuned_stream = opal_output_open(NULL);
         opal_output_set_verbosity(ompi_coll_tuned_stream, ompi_coll_tuned_verbose);
@@ -290,6 +307,12 @@ static int tuned_close(void)
         }
     }
 
+    if (mca_coll_tuned_component.plan_progress_registered) {
+        opal_progress_unregister(ompi_coll_tuned_plan_progress);
+    }
+    OBJ_DESTRUCT(&mca_coll_tuned_component.active_plans);
+    OBJ_DESTRUCT(&mca_coll_tuned_component.plan_lock);
+
     return OMPI_SUCCESS;
 }
 
@@ -302,6 +325,12 @@ mca_coll_tuned_module_construct(mca_coll_tuned_module_t *module)
         tuned_module->user_forced[i].algorithm = 0;
         tuned_module->com_rules[i] = NULL;
     }
+    tuned_module->previous_allreduce_init = NULL;
+    tuned_module->previous_allreduce_init_module = NULL;
+    tuned_module->previous_bcast_init = NULL;
+    tuned_module->previous_bcast_init_module = NULL;
+    tuned_module->previous_reduce_init = NULL;
+    tuned_module->previous_reduce_init_module = NULL;
 }
 
 int coll_tuned_alg_from_str(int collective_id, const char *alg_name, int *alg_value) {
@@ -58,17 +58,33 @@ ompi_coll_tuned_allreduce_intra_dec_dynamic (const void *sbuf, void *rbuf, size_
                                              struct ompi_communicator_t *comm,
                                              mca_coll_base_module_t *module)
 {
-    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t*) module;
+    coll_tuned_decision_t decision;
 
     OPAL_OUTPUT_VERBOSE((COLL_TUNED_TRACING_VERBOSE, ompi_coll_tuned_stream,
         "ompi_coll_tuned_allreduce_intra_dec_dynamic"));
 
+    ompi_coll_tuned_allreduce_intra_decide_dynamic (count, dtype, op, comm, module, &decision);
+    return ompi_coll_tuned_allreduce_intra_do_this (sbuf, rbuf, count, dtype, op,
+                                                    comm, module, decision.algorithm,
+                                                    decision.faninout, decision.segsize);
+}
+
+void
+ompi_coll_tuned_allreduce_intra_decide_dynamic (size_t count,
+                                                struct ompi_datatype_t *dtype,
+                                                struct ompi_op_t *op,
+                                                struct ompi_communicator_t *comm,
+                                                mca_coll_base_module_t *module,
+                                                coll_tuned_decision_t *decision)
+{
+    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t*) module;
+
     /* Check first if an algorithm is set explicitly for this collective */
     if (tuned_module->user_forced[ALLREDUCE].algorithm) {
-        return ompi_coll_tuned_allreduce_intra_do_this(sbuf, rbuf, count, dtype, op, comm, module,
-                                                       tuned_module->user_forced[ALLREDUCE].algorithm,
-                                                       tuned_module->user_forced[ALLREDUCE].tree_fanout,
-                                                       tuned_module->user_forced[ALLREDUCE].segsize);
+        COLL_TUNED_SET_DECISION(decision, tuned_module->user_forced[ALLREDUCE].algorithm,
+                                tuned_module->user_forced[ALLREDUCE].tree_fanout,
+                                tuned_module->user_forced[ALLREDUCE].segsize, 0);
+        return;
     }
 
     /* check to see if we have some filebased rules */
@@ -85,14 +101,12 @@ ompi_coll_tuned_allreduce_intra_dec_dynamic (const void *sbuf, void *rbuf, size_
 
         if (alg) {
             /* we have found a valid choice from the file based rules for this message size */
-            return ompi_coll_tuned_allreduce_intra_do_this (sbuf, rbuf, count, dtype, op,
-                                                            comm, module,
-                                                            alg, faninout, segsize);
+            COLL_TUNED_SET_DECISION(decision, alg, faninout, segsize, 0);
+            return;
         } /* found a method */
     } /*end if any com rules to check */
 
-    return ompi_coll_tuned_allreduce_intra_dec_fixed (sbuf, rbuf, count, dtype, op,
-                                                      comm, module);
+    ompi_coll_tuned_allreduce_intra_decide_fixed (count, dtype, op, comm, decision);
 }
 
 /*
@@ -259,18 +273,31 @@ int ompi_coll_tuned_bcast_intra_dec_dynamic(void *buf, size_t count,
                                             struct ompi_communicator_t *comm,
                                             mca_coll_base_module_t *module)
 {
-    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t*) module;
+    coll_tuned_decision_t decision;
 
     OPAL_OUTPUT_VERBOSE((COLL_TUNED_TRACING_VERBOSE, ompi_coll_tuned_stream,
         "coll:tuned:bcast_intra_dec_dynamic"));
 
+    ompi_coll_tuned_bcast_intra_decide_dynamic (count, dtype, root, comm, module, &decision);
+    return ompi_coll_tuned_bcast_intra_do_this (buf, count, dtype, root,
+                                                comm, module, decision.algorithm,
+                                                decision.faninout, decision.segsize);
+}
+
+void ompi_coll_tuned_bcast_intra_decide_dynamic(size_t count,
+                                                struct ompi_datatype_t *dtype, int root,
+                                                struct ompi_communicator_t *comm,
+                                                mca_coll_base_module_t *module,
+                                                coll_tuned_decision_t *decision)
+{
+    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t*) module;
+
     /* Check first if an algorithm is set explicitly for this collective */
     if (tuned_module->user_forced[BCAST].algorithm) {
-        return ompi_coll_tuned_bcast_intra_do_this(buf, count, dtype,
-                                                   root, comm, module,
-                                                   tuned_module->user_forced[BCAST].algorithm,
-                                                   tuned_module->user_forced[BCAST].chain_fanout,
-                                                   tuned_module->user_forced[BCAST].segsize);
+        COLL_TUNED_SET_DECISION(decision, tuned_module->user_forced[BCAST].algorithm,
+                                tuned_module->user_forced[BCAST].chain_fanout,
+                                tuned_module->user_forced[BCAST].segsize, 0);
+        return;
     }
 
     /* check to see if we have some filebased rules */
@@ -287,15 +314,12 @@ int ompi_coll_tuned_bcast_intra_dec_dynamic(void *buf, size_t count,
 
         if (alg) {
             /* we have found a valid choice from the file based rules for this message size */
-            return ompi_coll_tuned_bcast_intra_do_this (buf, count, dtype, root,
-                                                        comm, module,
-                                                        alg, faninout, segsize);
+            COLL_TUNED_SET_DECISION(decision, alg, faninout, segsize, 0);
+            return;
         } /* found a method */
     } /*end if any com rules to check */
 
-
-    return ompi_coll_tuned_bcast_intra_dec_fixed (buf, count, dtype, root,
-                                                  comm, module);
+    ompi_coll_tuned_bcast_intra_decide_fixed (count, dtype, root, comm, decision);
 }
 
 /*
@@ -312,19 +336,33 @@ int ompi_coll_tuned_reduce_intra_dec_dynamic( const void *sbuf, void *rbuf,
                                               struct ompi_communicator_t* comm,
                                               mca_coll_base_module_t *module)
 {
-    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t*) module;
+    coll_tuned_decision_t decision;
 
     OPAL_OUTPUT_VERBOSE((COLL_TUNED_TRACING_VERBOSE, ompi_coll_tuned_stream,
         "coll:tuned:reduce_intra_dec_dynamic"));
 
+    ompi_coll_tuned_reduce_intra_decide_dynamic (count, dtype, op, root, comm, module, &decision);
+    return  ompi_coll_tuned_reduce_intra_do_this (sbuf, rbuf, count, dtype,
+                                                  op, root, comm, module,
+                                                  decision.algorithm, decision.faninout,
+                                                  decision.segsize, decision.max_requests);
+}
+
+void ompi_coll_tuned_reduce_intra_decide_dynamic( size_t count, struct ompi_datatype_t* dtype,
+                                                  struct ompi_op_t* op, int root,
+                                                  struct ompi_communicator_t* comm,
+                                                  mca_coll_base_module_t *module,
+                                                  coll_tuned_decision_t *decision)
+{
+    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t*) module;
+
     /* Check first if an algorithm is set explicitly for this collective */
     if (tuned_module->user_forced[REDUCE].algorithm) {
-        return ompi_coll_tuned_reduce_intra_do_this(sbuf, rbuf, count, dtype,
-                                                    op, root, comm, module,
-                                                    tuned_module->user_forced[REDUCE].algorithm,
-                                                    tuned_module->user_forced[REDUCE].chain_fanout,
-                                                    tuned_module->user_forced[REDUCE].segsize,
-                                                    tuned_module->user_forced[REDUCE].max_requests);
+        COLL_TUNED_SET_DECISION(decision, tuned_module->user_forced[REDUCE].algorithm,
+                                tuned_module->user_forced[REDUCE].chain_fanout,
+                                tuned_module->user_forced[REDUCE].segsize,
+                                tuned_module->user_forced[REDUCE].max_requests);
+        return;
     }
 
     /* check to see if we have some filebased rules */
@@ -342,15 +380,12 @@ int ompi_coll_tuned_reduce_intra_dec_dynamic( const void *sbuf, void *rbuf,
 
         if (alg) {
             /* we have found a valid choice from the file based rules for this message size */
-            return  ompi_coll_tuned_reduce_intra_do_this (sbuf, rbuf, count, dtype,
-                                                          op, root, comm, module,
-                                                          alg, faninout,
-                                                          segsize, max_requests);
+            COLL_TUNED_SET_DECISION(decision, alg, faninout, segsize, max_requests);
+            return;
         } /* found a method */
     } /*end if any com rules to check */
 
-    return ompi_coll_tuned_reduce_intra_dec_fixed (sbuf, rbuf, count, dtype,
-                                                   op, root, comm, module);
+    ompi_coll_tuned_reduce_intra_decide_fixed (count, dtype, op, root, comm, decision);
 }
 
 /*
@@ -57,6 +57,27 @@ ompi_coll_tuned_allreduce_intra_dec_fixed(const void *sbuf, void *rbuf, size_t c
                                           struct ompi_op_t *op,
                                           struct ompi_communicator_t *comm,
                                           mca_coll_base_module_t *module)
+{
+    coll_tuned_decision_t decision;
+
+    ompi_coll_tuned_allreduce_intra_decide_fixed(count, dtype, op, comm, &decision);
+    return ompi_coll_tuned_allreduce_intra_do_this (sbuf, rbuf, count, dtype, op,
+                                                    comm, module, decision.algorithm,
+                                                    decision.faninout, decision.segsize);
+}
+
+/*
+ *  allreduce_intra_decide
+ *
+ *  Function:   - selects the allreduce algorithm without running it
+ *  Accepts:    - the message description of MPI_Allreduce()
+ */
+void
+ompi_coll_tuned_allreduce_intra_decide_fixed(size_t count,
+                                             struct ompi_datatype_t *dtype,
+                                             struct ompi_op_t *op,
+                                             struct ompi_communicator_t *comm,
+                                             coll_tuned_decision_t *decision)
 {
     size_t dsize, total_dsize;
     int communicator_size, alg;
@@ -214,8 +235,7 @@ ompi_coll_tuned_allreduce_intra_dec_fixed(const void *sbuf, void *rbuf, size_t c
         }
     }
 
-    return ompi_coll_tuned_allreduce_intra_do_this (sbuf, rbuf, count, dtype, op,
-                                                    comm, module, alg, 0, 0);
+    COLL_TUNED_SET_DECISION(decision, alg, 0, 0, 0);
 }
 
 /*
@@ -516,6 +536,25 @@ int ompi_coll_tuned_bcast_intra_dec_fixed(void *buff, size_t count,
                                           struct ompi_datatype_t *datatype, int root,
                                           struct ompi_communicator_t *comm,
                                           mca_coll_base_module_t *module)
+{
+    coll_tuned_decision_t decision;
+
+    ompi_coll_tuned_bcast_intra_decide_fixed(count, datatype, root, comm, &decision);
+    return ompi_coll_tuned_bcast_intra_do_this (buff, count, datatype, root,
+                                                comm, module, decision.algorithm,
+                                                decision.faninout, decision.segsize);
+}
+
+/*
+ *	bcast_intra_decide
+ *
+ *	Function:	- selects the broadcast algorithm without running it
+ *	Accepts:	- the message description of MPI_Bcast()
+ */
+void ompi_coll_tuned_bcast_intra_decide_fixed(size_t count,
+                                              struct ompi_datatype_t *datatype, int root,
+                                              struct ompi_communicator_t *comm,
+                                              coll_tuned_decision_t *decision)
 {
     size_t total_dsize, dsize;
     int communicator_size, alg;
@@ -649,9 +688,7 @@ int ompi_coll_tuned_bcast_intra_dec_fixed(void *buff, size_t count,
         }
     }
 
-    return ompi_coll_tuned_bcast_intra_do_this (buff, count, datatype, root,
-                                                comm, module,
-                                                alg, 0, 0);
+    COLL_TUNED_SET_DECISION(decision, alg, 0, 0, 0);
 }
 
 
@@ -666,6 +703,19 @@ int ompi_coll_tuned_bcast_intra_disjoint_dec_fixed(void *buff, size_t count,
                                                    struct ompi_datatype_t *datatype, int root,
                                                    struct ompi_communicator_t *comm,
                                                    mca_coll_base_module_t *module)
+{
+    coll_tuned_decision_t decision;
+
+    ompi_coll_tuned_bcast_intra_disjoint_decide_fixed(count, datatype, root, comm, &decision);
+    return ompi_coll_tuned_bcast_intra_do_this (buff, count, datatype, root,
+                                                comm, module, decision.algorithm,
+                                                decision.faninout, decision.segsize);
+}
+
+void ompi_coll_tuned_bcast_intra_disjoint_decide_fixed(size_t count,
+                                                       struct ompi_datatype_t *datatype, int root,
+                                                       struct ompi_communicator_t *comm,
+                                                       coll_tuned_decision_t *decision)
 {
     size_t total_dsize, dsize;
     int communicator_size, alg;
@@ -721,9 +771,7 @@ int ompi_coll_tuned_bcast_intra_disjoint_dec_fixed(void *buff, size_t count,
         }
     }
 
-    return ompi_coll_tuned_bcast_intra_do_this (buff, count, datatype, root,
-                                                comm, module,
-                                                alg, 0, 0);
+    COLL_TUNED_SET_DECISION(decision, alg, 0, 0, 0);
 }
 
 
@@ -740,6 +788,26 @@ int ompi_coll_tuned_reduce_intra_dec_fixed( const void *sendbuf, void *recvbuf,
                                             struct ompi_op_t* op, int root,
                                             struct ompi_communicator_t* comm,
                                             mca_coll_base_module_t *module)
+{
+    coll_tuned_decision_t decision;
+
+    ompi_coll_tuned_reduce_intra_decide_fixed(count, datatype, op, root, comm, &decision);
+    return  ompi_coll_tuned_reduce_intra_do_this (sendbuf, recvbuf, count, datatype,
+                                                  op, root, comm, module,
+                                                  decision.algorithm, decision.faninout,
+                                                  decision.segsize, decision.max_requests);
+}
+
+/*
+ *	reduce_intra_decide
+ *
+ *	Function:	- selects the reduce algorithm without running it
+ *	Accepts:	- the message description of MPI_Reduce()
+ */
+void ompi_coll_tuned_reduce_intra_decide_fixed( size_t count, struct ompi_datatype_t* datatype,
+                                                struct ompi_op_t* op, int root,
+                                                struct ompi_communicator_t* comm,
+                                                coll_tuned_decision_t *decision)
 {
     int communicator_size, alg;
     size_t total_dsize, dsize;
@@ -886,9 +954,7 @@ int ompi_coll_tuned_reduce_intra_dec_fixed( const void *sendbuf, void *recvbuf,
     }
 
     int faninout = 2;
-    return  ompi_coll_tuned_reduce_intra_do_this (sendbuf, recvbuf, count, datatype,
-                                                  op, root, comm, module,
-                                                  alg, faninout, 0, 0);
+    COLL_TUNED_SET_DECISION(decision, alg, faninout, 0, 0);
 }
 
 /*
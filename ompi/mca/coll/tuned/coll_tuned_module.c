@@ -120,6 +120,12 @@ ompi_coll_tuned_comm_query(struct ompi_communicator_t *comm, int *priority)
     tuned_module->super.coll_reduce_scatter_block = ompi_coll_tuned_reduce_scatter_block_intra_dec_fixed;
     tuned_module->super.coll_scatter    = ompi_coll_tuned_scatter_intra_dec_fixed;
 
+    if (ompi_coll_tuned_persistent_plans) {
+        tuned_module->super.coll_allreduce_init = ompi_coll_tuned_allreduce_intra_init;
+        tuned_module->super.coll_bcast_init     = ompi_coll_tuned_bcast_intra_init;
+        tuned_module->super.coll_reduce_init    = ompi_coll_tuned_reduce_intra_init;
+    }
+
     return &(tuned_module->super);
 }
 
@@ -285,6 +291,18 @@ tuned_module_enable( mca_coll_base_module_t *module,
     TUNED_INSTALL_COLL_API(comm, tuned_module, scan);
     TUNED_INSTALL_COLL_API(comm, tuned_module, scatter);
     TUNED_INSTALL_COLL_API(comm, tuned_module, scatterv);
+    if (ompi_coll_tuned_persistent_plans) {
+        /* the plans hand the algorithms they cannot schedule to the previous component */
+        MCA_COLL_SAVE_API(comm, allreduce_init, tuned_module->previous_allreduce_init,
+                          tuned_module->previous_allreduce_init_module, "tuned");
+        MCA_COLL_SAVE_API(comm, bcast_init, tuned_module->previous_bcast_init,
+                          tuned_module->previous_bcast_init_module, "tuned");
+        MCA_COLL_SAVE_API(comm, reduce_init, tuned_module->previous_reduce_init,
+                          tuned_module->previous_reduce_init_module, "tuned");
+    }
+    TUNED_INSTALL_COLL_API(comm, tuned_module, allreduce_init);
+    TUNED_INSTALL_COLL_API(comm, tuned_module, bcast_init);
+    TUNED_INSTALL_COLL_API(comm, tuned_module, reduce_init);
 
     /* general n fan out tree */
     data->cached_ntree = NULL;
@@ -333,6 +351,9 @@ tuned_module_disable(mca_coll_base_module_t *module,
     TUNED_UNINSTALL_COLL_API(comm, tuned_module, scan);
     TUNED_UNINSTALL_COLL_API(comm, tuned_module, scatter);
     TUNED_UNINSTALL_COLL_API(comm, tuned_module, scatterv);
+    TUNED_UNINSTALL_COLL_API(comm, tuned_module, allreduce_init);
+    TUNED_UNINSTALL_COLL_API(comm, tuned_module, bcast_init);
+    TUNED_UNINSTALL_COLL_API(comm, tuned_module, reduce_init);
 
     return OMPI_SUCCESS;
 }
@@ -0,0 +1,1036 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Persistent collective plans.
+ *
+ * A plan is built once by MPI_<Coll>_init: the decision function (fixed,
+ * forced or file based, the same one the blocking collective would use)
+ * is resolved, and the chosen algorithm is unrolled for this rank into a
+ * schedule of rounds. A round is a list of actions: local copies and
+ * reductions, run in order when the round starts, and sends and receives,
+ * posted when the round starts. The next round starts once all the
+ * requests of the previous one completed, so data received in a round is
+ * only used by the following ones. The scratch buffers and every buffer
+ * address are resolved when the schedule is built.
+ *
+ * MPI_Start only runs the first round; the following ones are started by
+ * ompi_coll_tuned_plan_progress from the progress engine, so a started
+ * plan never blocks and completes in MPI_Wait or MPI_Test like any other
+ * non-blocking request.
+ *
+ * The recursive doubling and ring allreduce, the linear and tree based
+ * (chain, pipeline, binary and binomial) bcast, and the linear and, for
+ * commutative operations, tree based reduce are scheduled. Any other
+ * decision is handed to the persistent collective of the previous
+ * component.
+ */
+
+#include "ompi_config.h"
+
+#include "mpi.h"
+#include "opal/align.h"
+#include "ompi/constants.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/communicator/communicator.h"
+#include "ompi/request/request.h"
+#include "ompi/op/op.h"
+#include "ompi/mca/pml/pml.h"
+#include "ompi/mca/coll/base/coll_base_functions.h"
+#include "ompi/mca/coll/base/coll_base_topo.h"
+#include "ompi/mca/coll/base/coll_base_util.h"
+#include "opal/runtime/opal_progress.h"
+#include "opal/util/bit_ops.h"
+#include "coll_tuned.h"
+
+/* alignment of the buffers carved out of the scratch area */
+#define MCA_COLL_TUNED_PLAN_ALIGN 16
+
+enum {
+    MCA_COLL_TUNED_PLAN_SEND,
+    MCA_COLL_TUNED_PLAN_RECV,
+    MCA_COLL_TUNED_PLAN_OP,     /* buf = src (op) buf */
+    MCA_COLL_TUNED_PLAN_COPY,   /* buf = src */
+};
+
+typedef struct mca_coll_tuned_plan_action_t {
+    int type;
+    int peer;
+    size_t count;
+    char *buf;
+    char *src;
+} mca_coll_tuned_plan_action_t;
+
+typedef struct mca_coll_tuned_plan_t mca_coll_tuned_plan_t;
+
+struct mca_coll_tuned_plan_t {
+    ompi_coll_base_nbc_request_t super;
+
+    struct ompi_datatype_t *dtype;
+    struct ompi_op_t *op;
+    struct ompi_communicator_t *comm;
+    int tag;
+    coll_tuned_decision_t decision;
+
+    /** the schedule: round r is actions[rounds[r - 1]] .. actions[rounds[r] - 1] */
+    mca_coll_tuned_plan_action_t *actions;
+    int nactions;
+    int max_actions;
+    int *rounds;
+    int nrounds;
+    int max_rounds;
+    /** first error met while building the schedule */
+    int build_error;
+
+    /** temporary buffers of the schedule (NULL if it needs none) */
+    char *scratch;
+
+    /* state of the started instance */
+    int round;
+    ompi_request_t **reqs;
+    int nreqs;
+    /** requests of the current round already found complete */
+    int ndone;
+    int error;
+};
+
+static void mca_coll_tuned_plan_construct (mca_coll_tuned_plan_t *plan);
+static void mca_coll_tuned_plan_destruct (mca_coll_tuned_plan_t *plan);
+
+static OBJ_CLASS_INSTANCE(mca_coll_tuned_plan_t, ompi_coll_base_nbc_request_t,
+                          mca_coll_tuned_plan_construct, mca_coll_tuned_plan_destruct);
+
+/* return if invoked recursively */
+static bool mca_coll_tuned_plan_in_progress = false;
+
+/*
+ * Execution
+ */
+
+/* run the local actions of the current round and post its communications */
+static void mca_coll_tuned_plan_round_start (mca_coll_tuned_plan_t *plan)
+{
+    int first = (0 == plan->round) ? 0 : plan->rounds[plan->round - 1];
+    int ret = OMPI_SUCCESS;
+
+    plan->nreqs = 0;
+    plan->ndone = 0;
+
+    for (int i = first ; i < plan->rounds[plan->round] ; ++i) {
+        mca_coll_tuned_plan_action_t *action = plan->actions + i;
+
+        switch (action->type) {
+        case MCA_COLL_TUNED_PLAN_SEND:
+            ret = MCA_PML_CALL(isend(action->buf, action->count, plan->dtype, action->peer,
+                                     plan->tag, MCA_PML_BASE_SEND_STANDARD, plan->comm,
+                                     plan->reqs + plan->nreqs));
+            if (OMPI_SUCCESS == ret) {
+                ++plan->nreqs;
+            }
+            break;
+        case MCA_COLL_TUNED_PLAN_RECV:
+            ret = MCA_PML_CALL(irecv(action->buf, action->count, plan->dtype, action->peer,
+                                     plan->tag, plan->comm, plan->reqs + plan->nreqs));
+            if (OMPI_SUCCESS == ret) {
+                ++plan->nreqs;
+            }
+            break;
+        case MCA_COLL_TUNED_PLAN_OP:
+            ompi_op_reduce (plan->op, action->src, action->buf, action->count, plan->dtype);
+            break;
+        case MCA_COLL_TUNED_PLAN_COPY:
+            ret = ompi_datatype_copy_content_same_ddt (plan->dtype, action->count, action->buf,
+                                                       action->src);
+            break;
+        }
+
+        if (OPAL_UNLIKELY(OMPI_SUCCESS != ret)) {
+            /* stop here, the requests already posted are waited for */
+            plan->error = ret;
+            break;
+        }
+    }
+}
+
+/* check the requests of the current round and start the next rounds while
+ * they can. Return true once the schedule is over. */
+static bool mca_coll_tuned_plan_advance (mca_coll_tuned_plan_t *plan)
+{
+    for (;;) {
+        for ( ; plan->ndone < plan->nreqs ; ++plan->ndone) {
+            if (!REQUEST_COMPLETE(plan->reqs[plan->ndone])) {
+                return false;
+            }
+        }
+
+        for (int i = 0 ; i < plan->nreqs ; ++i) {
+            int ret = plan->reqs[i]->req_status.MPI_ERROR;
+
+            if (OPAL_UNLIKELY(OMPI_SUCCESS != ret) && OMPI_SUCCESS == plan->error) {
+                plan->error = ret;
+            }
+            ompi_request_free (plan->reqs + i);
+        }
+        plan->nreqs = plan->ndone = 0;
+
+        if (OMPI_SUCCESS != plan->error || ++plan->round == plan->nrounds) {
+            return true;
+        }
+        mca_coll_tuned_plan_round_start (plan);
+    }
+}
+
+static void mca_coll_tuned_plan_complete (mca_coll_tuned_plan_t *plan)
+{
+    plan->super.super.req_status.MPI_ERROR = plan->error;
+    ompi_request_complete (&plan->super.super, true);
+}
+
+int ompi_coll_tuned_plan_progress (void)
+{
+    mca_coll_tuned_plan_t *plan, *next;
+    int completed = 0;
+
+    if (0 == opal_list_get_size (&mca_coll_tuned_component.active_plans)) {
+        /* no started plan -- nothing to do. do not grab a lock */
+        return 0;
+    }
+
+    OPAL_THREAD_LOCK(&mca_coll_tuned_component.plan_lock);
+    if (!mca_coll_tuned_plan_in_progress) {
+        mca_coll_tuned_plan_in_progress = true;
+
+        OPAL_LIST_FOREACH_SAFE(plan, next, &mca_coll_tuned_component.active_plans,
+                               mca_coll_tuned_plan_t) {
+            OPAL_THREAD_UNLOCK(&mca_coll_tuned_component.plan_lock);
+            if (mca_coll_tuned_plan_advance (plan)) {
+                OPAL_THREAD_LOCK(&mca_coll_tuned_component.plan_lock);
+                opal_list_remove_item (&mca_coll_tuned_component.active_plans,
+                                       &plan->super.super.super.super);
+                OPAL_THREAD_UNLOCK(&mca_coll_tuned_component.plan_lock);
+
+                mca_coll_tuned_plan_complete (plan);
+                ++completed;
+            }
+            OPAL_THREAD_LOCK(&mca_coll_tuned_component.plan_lock);
+        }
+        mca_coll_tuned_plan_in_progress = false;
+    }
+    OPAL_THREAD_UNLOCK(&mca_coll_tuned_component.plan_lock);
+
+    return completed;
+}
+
+static int mca_coll_tuned_plan_start (size_t count, ompi_request_t **requests)
+{
+    for (size_t i = 0 ; i < count ; ++i) {
+        mca_coll_tuned_plan_t *plan = (mca_coll_tuned_plan_t *) requests[i];
+
+        plan->super.super.req_state = OMPI_REQUEST_ACTIVE;
+        plan->super.super.req_complete = REQUEST_PENDING;
+        plan->super.super.req_status.MPI_ERROR = OMPI_SUCCESS;
+        plan->error = OMPI_SUCCESS;
+        plan->round = 0;
+        plan->nreqs = plan->ndone = 0;
+
+        if (0 == plan->nrounds) {
+            mca_coll_tuned_plan_complete (plan);
+            continue;
+        }
+
+        /* errors of the first round are reported by the request, like the
+         * errors of the following ones */
+        mca_coll_tuned_plan_round_start (plan);
+        if (mca_coll_tuned_plan_advance (plan)) {
+            mca_coll_tuned_plan_complete (plan);
+            continue;
+        }
+
+        OPAL_THREAD_LOCK(&mca_coll_tuned_component.plan_lock);
+        opal_list_append (&mca_coll_tuned_component.active_plans, &plan->super.super.super.super);
+        OPAL_THREAD_UNLOCK(&mca_coll_tuned_component.plan_lock);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+static int mca_coll_tuned_plan_cancel (struct ompi_request_t *request, int complete)
+{
+    return MPI_ERR_REQUEST;
+}
+
+static int mca_coll_tuned_plan_free (struct ompi_request_t **request)
+{
+    mca_coll_tuned_plan_t *plan = (mca_coll_tuned_plan_t *) *request;
+
+    if (!REQUEST_COMPLETE(&plan->super.super)) {
+        return MPI_ERR_REQUEST;
+    }
+
+    OMPI_REQUEST_FINI(&plan->super.super);
+    OBJ_RELEASE(plan);
+    *request = MPI_REQUEST_NULL;
+
+    return OMPI_SUCCESS;
+}
+
+static void mca_coll_tuned_plan_construct (mca_coll_tuned_plan_t *plan)
+{
+    plan->super.super.req_type = OMPI_REQUEST_COLL;
+    plan->super.super.req_start = mca_coll_tuned_plan_start;
+    plan->super.super.req_free = mca_coll_tuned_plan_free;
+    plan->super.super.req_cancel = mca_coll_tuned_plan_cancel;
+    plan->actions = NULL;
+    plan->nactions = plan->max_actions = 0;
+    plan->rounds = NULL;
+    plan->nrounds = plan->max_rounds = 0;
+    plan->build_error = OMPI_SUCCESS;
+    plan->scratch = NULL;
+    plan->reqs = NULL;
+    plan->nreqs = plan->ndone = 0;
+}
+
+static void mca_coll_tuned_plan_destruct (mca_coll_tuned_plan_t *plan)
+{
+    free (plan->actions);
+    free (plan->rounds);
+    free (plan->scratch);
+    free (plan->reqs);
+}
+
+/*
+ * Schedule construction
+ */
+
+static mca_coll_tuned_plan_t *
+mca_coll_tuned_plan_new (struct ompi_datatype_t *dtype, struct ompi_op_t *op,
+                         struct ompi_communicator_t *comm)
+{
+    mca_coll_tuned_plan_t *plan = OBJ_NEW(mca_coll_tuned_plan_t);
+    int32_t registered = 0;
+
+    if (NULL == plan) {
+        return NULL;
+    }
+
+    OMPI_REQUEST_INIT(&plan->super.super, true);
+    plan->super.super.req_mpi_object.comm = comm;
+    plan->super.super.req_status._cancelled = 0;
+    plan->dtype = dtype;
+    plan->op = op;
+    plan->comm = comm;
+    /* the init calls are collective, so every rank reserves the same tag */
+    plan->tag = ompi_coll_base_nbc_reserve_tags (comm, 1);
+
+    if (OPAL_ATOMIC_COMPARE_EXCHANGE_STRONG_32(&mca_coll_tuned_component.plan_progress_registered,
+                                               &registered, 1)) {
+        opal_progress_register (ompi_coll_tuned_plan_progress);
+    }
+
+    return plan;
+}
+
+static int mca_coll_tuned_plan_alloc_scratch (mca_coll_tuned_plan_t *plan, size_t size)
+{
+    if (0 == size) {
+        return OMPI_SUCCESS;
+    }
+
+    plan->scratch = (char *) malloc (size);
+    return (NULL == plan->scratch) ? OMPI_ERR_OUT_OF_RESOURCE : OMPI_SUCCESS;
+}
+
+static void mca_coll_tuned_plan_push (mca_coll_tuned_plan_t *plan, int type, int peer,
+                                      size_t count, char *buf, char *src)
+{
+    if (OMPI_SUCCESS != plan->build_error) {
+        return;
+    }
+
+    if (plan->nactions == plan->max_actions) {
+        int max_actions = plan->max_actions ? 2 * plan->max_actions : 16;
+        void *tmp = realloc (plan->actions, max_actions * sizeof (plan->actions[0]));
+
+        if (NULL == tmp) {
+            plan->build_error = OMPI_ERR_OUT_OF_RESOURCE;
+            return;
+        }
+        plan->actions = (mca_coll_tuned_plan_action_t *) tmp;
+        plan->max_actions = max_actions;
+    }
+
+    plan->actions[plan->nactions++] = (mca_coll_tuned_plan_action_t) {
+        .type = type, .peer = peer, .count = count, .buf = buf, .src = src,
+    };
+}
+
+static inline void mca_coll_tuned_plan_send (mca_coll_tuned_plan_t *plan, char *buf, size_t count, int peer)
+{
+    mca_coll_tuned_plan_push (plan, MCA_COLL_TUNED_PLAN_SEND, peer, count, buf, NULL);
+}
+
+static inline void mca_coll_tuned_plan_recv (mca_coll_tuned_plan_t *plan, char *buf, size_t count, int peer)
+{
+    mca_coll_tuned_plan_push (plan, MCA_COLL_TUNED_PLAN_RECV, peer, count, buf, NULL);
+}
+
+static inline void mca_coll_tuned_plan_op (mca_coll_tuned_plan_t *plan, char *src, char *buf, size_t count)
+{
+    mca_coll_tuned_plan_push (plan, MCA_COLL_TUNED_PLAN_OP, -1, count, buf, src);
+}
+
+static inline void mca_coll_tuned_plan_copy (mca_coll_tuned_plan_t *plan, char *src, char *buf, size_t count)
+{
+    mca_coll_tuned_plan_push (plan, MCA_COLL_TUNED_PLAN_COPY, -1, count, buf, src);
+}
+
+/* end the current round: the following actions wait for its requests */
+static void mca_coll_tuned_plan_round (mca_coll_tuned_plan_t *plan)
+{
+    int first = (0 == plan->nrounds) ? 0 : plan->rounds[plan->nrounds - 1];
+
+    if (OMPI_SUCCESS != plan->build_error || first == plan->nactions) {
+        return;
+    }
+
+    if (plan->nrounds == plan->max_rounds) {
+        int max_rounds = plan->max_rounds ? 2 * plan->max_rounds : 8;
+        void *tmp = realloc (plan->rounds, max_rounds * sizeof (plan->rounds[0]));
+
+        if (NULL == tmp) {
+            plan->build_error = OMPI_ERR_OUT_OF_RESOURCE;
+            return;
+        }
+        plan->rounds = (int *) tmp;
+        plan->max_rounds = max_rounds;
+    }
+
+    plan->rounds[plan->nrounds++] = plan->nactions;
+}
+
+/* close the schedule and size the request array for its largest round */
+static int mca_coll_tuned_plan_finalize (mca_coll_tuned_plan_t *plan)
+{
+    int max_reqs = 0;
+
+    mca_coll_tuned_plan_round (plan);
+    if (OMPI_SUCCESS != plan->build_error) {
+        return plan->build_error;
+    }
+
+    for (int r = 0, first = 0 ; r < plan->nrounds ; first = plan->rounds[r++]) {
+        int nreqs = 0;
+
+        for (int i = first ; i < plan->rounds[r] ; ++i) {
+            if (MCA_COLL_TUNED_PLAN_SEND == plan->actions[i].type ||
+                MCA_COLL_TUNED_PLAN_RECV == plan->actions[i].type) {
+                ++nreqs;
+            }
+        }
+        max_reqs = (nreqs > max_reqs) ? nreqs : max_reqs;
+    }
+
+    if (0 == max_reqs) {
+        return OMPI_SUCCESS;
+    }
+
+    plan->reqs = (ompi_request_t **) calloc (max_reqs, sizeof (plan->reqs[0]));
+    return (NULL == plan->reqs) ? OMPI_ERR_OUT_OF_RESOURCE : OMPI_SUCCESS;
+}
+
+/* segment count of the tree based algorithms, as computed by coll/base */
+static size_t mca_coll_tuned_plan_segcount (struct ompi_datatype_t *dtype, size_t count, int segsize)
+{
+    size_t segcount = count, typelng;
+
+    ompi_datatype_type_size (dtype, &typelng);
+    COLL_BASE_COMPUTED_SEGCOUNT( segsize, typelng, segcount );
+
+    return segcount;
+}
+
+/*
+ * Allreduce
+ */
+
+/* ompi_coll_base_allreduce_intra_recursivedoubling_scratch, unrolled */
+static int mca_coll_tuned_plan_allreduce_recursivedoubling (mca_coll_tuned_plan_t *plan, const void *sbuf,
+                                                            void *rbuf, size_t count)
+{
+    int rank = ompi_comm_rank (plan->comm), size = ompi_comm_size (plan->comm);
+    int adjsize, extra_ranks, newrank, newremote, remote, distance, ret;
+    char *tmpsend, *tmprecv, *tmpswap, *inplacebuf;
+    ptrdiff_t gap = 0;
+
+    if (1 == size) {
+        if (MPI_IN_PLACE != sbuf) {
+            mca_coll_tuned_plan_copy (plan, (char *) sbuf, (char *) rbuf, count);
+        }
+        return OMPI_SUCCESS;
+    }
+
+    ret = mca_coll_tuned_plan_alloc_scratch (plan, opal_datatype_span (&plan->dtype->super, count, &gap));
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    inplacebuf = plan->scratch - gap;
+
+    mca_coll_tuned_plan_copy (plan, (char *) (MPI_IN_PLACE == sbuf ? rbuf : sbuf), inplacebuf, count);
+    tmpsend = inplacebuf;
+    tmprecv = (char *) rbuf;
+
+    adjsize = opal_next_poweroftwo (size) >> 1;
+    extra_ranks = size - adjsize;
+
+    if (rank < 2 * extra_ranks) {
+        if (0 == (rank % 2)) {
+            mca_coll_tuned_plan_send (plan, tmpsend, count, rank + 1);
+            newrank = -1;
+        } else {
+            mca_coll_tuned_plan_recv (plan, tmprecv, count, rank - 1);
+            mca_coll_tuned_plan_round (plan);
+            mca_coll_tuned_plan_op (plan, tmprecv, tmpsend, count);
+            newrank = rank >> 1;
+        }
+    } else {
+        newrank = rank - extra_ranks;
+    }
+
+    for (distance = 0x1 ; newrank >= 0 && distance < adjsize ; distance <<= 1) {
+        newremote = newrank ^ distance;
+        remote = (newremote < extra_ranks) ? (newremote * 2 + 1) : (newremote + extra_ranks);
+
+        mca_coll_tuned_plan_send (plan, tmpsend, count, remote);
+        mca_coll_tuned_plan_recv (plan, tmprecv, count, remote);
+        mca_coll_tuned_plan_round (plan);
+
+        /* result = value (op) result, in rank order */
+        if (rank < remote) {
+            mca_coll_tuned_plan_op (plan, tmpsend, tmprecv, count);
+            tmpswap = tmprecv;
+            tmprecv = tmpsend;
+            tmpsend = tmpswap;
+        } else {
+            mca_coll_tuned_plan_op (plan, tmprecv, tmpsend, count);
+        }
+    }
+
+    if (rank < 2 * extra_ranks) {
+        if (0 == (rank % 2)) {
+            mca_coll_tuned_plan_recv (plan, (char *) rbuf, count, rank + 1);
+            tmpsend = (char *) rbuf;
+        } else {
+            mca_coll_tuned_plan_send (plan, tmpsend, count, rank - 1);
+        }
+    }
+
+    if (tmpsend != (char *) rbuf) {
+        mca_coll_tuned_plan_copy (plan, tmpsend, (char *) rbuf, count);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+/* offset (in elements) and count of a block of the ring algorithm */
+static inline ptrdiff_t mca_coll_tuned_plan_ring_block (int block, int split_rank, size_t early_segcount,
+                                                        size_t late_segcount, size_t *block_count)
+{
+    if (block < split_rank) {
+        *block_count = early_segcount;
+        return (ptrdiff_t) block * (ptrdiff_t) early_segcount;
+    }
+
+    *block_count = late_segcount;
+    return (ptrdiff_t) block * (ptrdiff_t) late_segcount + split_rank;
+}
+
+/* ompi_coll_base_allreduce_intra_ring_scratch, unrolled */
+static int mca_coll_tuned_plan_allreduce_ring (mca_coll_tuned_plan_t *plan, const void *sbuf,
+                                               void *rbuf, size_t count)
+{
+    int rank = ompi_comm_rank (plan->comm), size = ompi_comm_size (plan->comm);
+    int send_to, recv_from, split_rank, block, ret;
+    size_t early_segcount, late_segcount, block_count;
+    ptrdiff_t lb, extent, gap = 0;
+    char *inbuf, *tmpsend, *tmprecv;
+
+    if (1 == size || count < (size_t) size) {
+        return mca_coll_tuned_plan_allreduce_recursivedoubling (plan, sbuf, rbuf, count);
+    }
+
+    ompi_datatype_get_extent (plan->dtype, &lb, &extent);
+    COLL_BASE_COMPUTE_BLOCKCOUNT( count, size, split_rank, early_segcount, late_segcount );
+
+    /* a received block is reduced before the next one is posted, a single
+     * incoming block buffer is enough */
+    ret = mca_coll_tuned_plan_alloc_scratch (plan, opal_datatype_span (&plan->dtype->super,
+                                                                       early_segcount, &gap));
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    inbuf = plan->scratch - gap;
+
+    if (MPI_IN_PLACE != sbuf) {
+        mca_coll_tuned_plan_copy (plan, (char *) sbuf, (char *) rbuf, count);
+    }
+
+    send_to = (rank + 1) % size;
+    recv_from = (rank + size - 1) % size;
+
+    /* reduce-scatter: send my block, then for every step reduce the
+     * received block into rbuf and pass it along */
+    mca_coll_tuned_plan_recv (plan, inbuf, early_segcount, recv_from);
+    tmpsend = (char *) rbuf + mca_coll_tuned_plan_ring_block (rank, split_rank, early_segcount,
+                                                              late_segcount, &block_count) * extent;
+    mca_coll_tuned_plan_send (plan, tmpsend, block_count, send_to);
+    mca_coll_tuned_plan_round (plan);
+
+    for (int k = 2 ; k < size ; ++k) {
+        block = (rank + size - k + 1) % size;
+        tmprecv = (char *) rbuf + mca_coll_tuned_plan_ring_block (block, split_rank, early_segcount,
+                                                                  late_segcount, &block_count) * extent;
+        mca_coll_tuned_plan_op (plan, inbuf, tmprecv, block_count);
+        mca_coll_tuned_plan_send (plan, tmprecv, block_count, send_to);
+        mca_coll_tuned_plan_recv (plan, inbuf, early_segcount, recv_from);
+        mca_coll_tuned_plan_round (plan);
+    }
+
+    block = (rank + 1) % size;
+    tmprecv = (char *) rbuf + mca_coll_tuned_plan_ring_block (block, split_rank, early_segcount,
+                                                              late_segcount, &block_count) * extent;
+    mca_coll_tuned_plan_op (plan, inbuf, tmprecv, block_count);
+
+    /* allgather of the reduced blocks */
+    for (int k = 0 ; k < size - 1 ; ++k) {
+        block = (rank + 1 + size - k) % size;
+        tmpsend = (char *) rbuf + mca_coll_tuned_plan_ring_block (block, split_rank, early_segcount,
+                                                                  late_segcount, &block_count) * extent;
+        mca_coll_tuned_plan_send (plan, tmpsend, block_count, send_to);
+        block = (rank + size - k) % size;
+        tmprecv = (char *) rbuf + mca_coll_tuned_plan_ring_block (block, split_rank, early_segcount,
+                                                                  late_segcount, &block_count) * extent;
+        mca_coll_tuned_plan_recv (plan, tmprecv, early_segcount, recv_from);
+        mca_coll_tuned_plan_round (plan);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+int ompi_coll_tuned_allreduce_intra_init (const void *sbuf, void *rbuf, size_t count,
+                                          struct ompi_datatype_t *dtype, struct ompi_op_t *op,
+                                          struct ompi_communicator_t *comm, ompi_info_t *info,
+                                          ompi_request_t **request, mca_coll_base_module_t *module)
+{
+    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t *) module;
+    coll_tuned_decision_t decision;
+    mca_coll_tuned_plan_t *plan;
+    int ret;
+
+    if (module->coll_allreduce == ompi_coll_tuned_allreduce_intra_dec_dynamic) {
+        ompi_coll_tuned_allreduce_intra_decide_dynamic (count, dtype, op, comm, module, &decision);
+    } else {
+        ompi_coll_tuned_allreduce_intra_decide_fixed (count, dtype, op, comm, &decision);
+    }
+
+    /* the ring reduces the blocks out of rank order */
+    if (4 == decision.algorithm && !ompi_op_is_commute (op)) {
+        decision.algorithm = 3;
+    }
+    if (3 != decision.algorithm && 4 != decision.algorithm) {
+        if (NULL != tuned_module->previous_allreduce_init) {
+            return tuned_module->previous_allreduce_init (sbuf, rbuf, count, dtype, op, comm, info, request,
+                                                          tuned_module->previous_allreduce_init_module);
+        }
+        decision.algorithm = 3;
+    }
+
+    plan = mca_coll_tuned_plan_new (dtype, op, comm);
+    if (NULL == plan) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    plan->decision = decision;
+
+    if (0 == count) {
+        ret = OMPI_SUCCESS;
+    } else if (3 == decision.algorithm) {
+        ret = mca_coll_tuned_plan_allreduce_recursivedoubling (plan, sbuf, rbuf, count);
+    } else {
+        ret = mca_coll_tuned_plan_allreduce_ring (plan, sbuf, rbuf, count);
+    }
+    if (OMPI_SUCCESS == ret) {
+        ret = mca_coll_tuned_plan_finalize (plan);
+    }
+    if (OMPI_SUCCESS != ret) {
+        OBJ_RELEASE(plan);
+        return ret;
+    }
+
+    OPAL_OUTPUT_VERBOSE((COLL_TUNED_TRACING_VERBOSE, ompi_coll_tuned_stream,
+                         "coll:tuned:allreduce_intra_init algorithm %d rounds %d",
+                         decision.algorithm, plan->nrounds));
+
+    *request = &plan->super.super;
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Bcast
+ */
+
+/* ompi_coll_base_bcast_intra_generic, unrolled: an inner node receives a
+ * segment while it forwards the previous one to its children */
+static void mca_coll_tuned_plan_bcast_tree (mca_coll_tuned_plan_t *plan, char *buf, size_t count,
+                                            int root, size_t segcount, ompi_coll_tree_t *tree)
+{
+    int rank = ompi_comm_rank (plan->comm);
+    size_t num_segments = (count + segcount - 1) / segcount;
+    ptrdiff_t lb, extent;
+
+    ompi_datatype_get_extent (plan->dtype, &lb, &extent);
+
+#define SEGMENT(seg) (buf + (ptrdiff_t) (seg) * (ptrdiff_t) segcount * extent)
+#define SEGCOUNT(seg) (((seg) == num_segments - 1) ? count - (seg) * segcount : segcount)
+
+    if (rank == root) {
+        for (size_t seg = 0 ; seg < num_segments ; ++seg) {
+            for (int i = 0 ; i < tree->tree_nextsize ; ++i) {
+                mca_coll_tuned_plan_send (plan, SEGMENT(seg), SEGCOUNT(seg), tree->tree_next[i]);
+            }
+            mca_coll_tuned_plan_round (plan);
+        }
+    } else if (0 == tree->tree_nextsize) {
+        /* leaves post all their receives at once */
+        for (size_t seg = 0 ; seg < num_segments ; ++seg) {
+            mca_coll_tuned_plan_recv (plan, SEGMENT(seg), SEGCOUNT(seg), tree->tree_prev);
+        }
+    } else {
+        for (size_t seg = 0 ; seg <= num_segments ; ++seg) {
+            if (seg > 0) {
+                for (int i = 0 ; i < tree->tree_nextsize ; ++i) {
+                    mca_coll_tuned_plan_send (plan, SEGMENT(seg - 1), SEGCOUNT(seg - 1), tree->tree_next[i]);
+                }
+            }
+            if (seg < num_segments) {
+                mca_coll_tuned_plan_recv (plan, SEGMENT(seg), SEGCOUNT(seg), tree->tree_prev);
+            }
+            mca_coll_tuned_plan_round (plan);
+        }
+    }
+
+#undef SEGMENT
+#undef SEGCOUNT
+}
+
+int ompi_coll_tuned_bcast_intra_init (void *buff, size_t count, struct ompi_datatype_t *datatype,
+                                      int root, struct ompi_communicator_t *comm, ompi_info_t *info,
+                                      ompi_request_t **request, mca_coll_base_module_t *module)
+{
+    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t *) module;
+    int rank = ompi_comm_rank (comm), size = ompi_comm_size (comm), ret;
+    ompi_coll_tree_t *tree = NULL;
+    coll_tuned_decision_t decision;
+    mca_coll_tuned_plan_t *plan;
+    size_t segcount;
+
+    if (module->coll_bcast == ompi_coll_tuned_bcast_intra_dec_dynamic) {
+        ompi_coll_tuned_bcast_intra_decide_dynamic (count, datatype, root, comm, module, &decision);
+    } else if (module->coll_bcast == ompi_coll_tuned_bcast_intra_disjoint_dec_fixed) {
+        ompi_coll_tuned_bcast_intra_disjoint_decide_fixed (count, datatype, root, comm, &decision);
+    } else {
+        ompi_coll_tuned_bcast_intra_decide_fixed (count, datatype, root, comm, &decision);
+    }
+
+    if (1 != decision.algorithm && 2 != decision.algorithm && 3 != decision.algorithm &&
+        5 != decision.algorithm && 6 != decision.algorithm) {
+        if (NULL != tuned_module->previous_bcast_init) {
+            return tuned_module->previous_bcast_init (buff, count, datatype, root, comm, info, request,
+                                                      tuned_module->previous_bcast_init_module);
+        }
+        decision.algorithm = 6;
+    }
+
+    plan = mca_coll_tuned_plan_new (datatype, NULL, comm);
+    if (NULL == plan) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    plan->decision = decision;
+
+    /* same topologies as the coll/base wrappers of the generic algorithm */
+    switch (decision.algorithm) {
+    case (2):  /* chain */
+        tree = ompi_coll_base_topo_build_chain (decision.faninout, comm, root);
+        break;
+    case (3):  /* pipeline */
+        tree = ompi_coll_base_topo_build_chain (1, comm, root);
+        break;
+    case (5):  /* binary tree */
+        tree = ompi_coll_base_topo_build_tree (2, comm, root);
+        break;
+    case (6):  /* binomial */
+        tree = ompi_coll_base_topo_build_bmtree (comm, root);
+        break;
+    }
+    segcount = mca_coll_tuned_plan_segcount (datatype, count, decision.segsize);
+
+    if (0 == count || 1 == size) {
+        /* nothing to move */
+    } else if (1 == decision.algorithm) {  /* linear */
+        if (rank == root) {
+            for (int peer = 0 ; peer < size ; ++peer) {
+                if (peer != root) {
+                    mca_coll_tuned_plan_send (plan, (char *) buff, count, peer);
+                }
+            }
+        } else {
+            mca_coll_tuned_plan_recv (plan, (char *) buff, count, root);
+        }
+    } else if (NULL != tree) {
+        mca_coll_tuned_plan_bcast_tree (plan, (char *) buff, count, root, segcount, tree);
+    } else {
+        plan->build_error = OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    if (NULL != tree) {
+        ompi_coll_base_topo_destroy_tree (&tree);
+    }
+
+    ret = mca_coll_tuned_plan_finalize (plan);
+    if (OMPI_SUCCESS != ret) {
+        OBJ_RELEASE(plan);
+        return ret;
+    }
+
+    OPAL_OUTPUT_VERBOSE((COLL_TUNED_TRACING_VERBOSE, ompi_coll_tuned_stream,
+                         "coll:tuned:bcast_intra_init algorithm %d root %d segcount %zu rounds %d",
+                         decision.algorithm, root, segcount, plan->nrounds));
+
+    *request = &plan->super.super;
+    return OMPI_SUCCESS;
+}
+
+/*
+ * Reduce
+ */
+
+/* ompi_coll_base_reduce_intra_basic_linear, unrolled: the root reduces the
+ * contributions from the last rank down to rank 0, so the operation does
+ * not need to be commutative. A contribution is received while the
+ * previous one is reduced. */
+static int mca_coll_tuned_plan_reduce_linear (mca_coll_tuned_plan_t *plan, const void *sbuf, void *rbuf,
+                                              size_t count, int root)
+{
+    int rank = ompi_comm_rank (plan->comm), size = ompi_comm_size (plan->comm), ret;
+    char *local = (char *) sbuf, *inbuf[2], *pending = NULL;
+    ptrdiff_t span, gap = 0, stride;
+
+    if (rank != root) {
+        mca_coll_tuned_plan_send (plan, (char *) sbuf, count, root);
+        return OMPI_SUCCESS;
+    }
+
+    span = opal_datatype_span (&plan->dtype->super, count, &gap);
+    stride = OPAL_ALIGN(span, MCA_COLL_TUNED_PLAN_ALIGN, ptrdiff_t);
+    ret = mca_coll_tuned_plan_alloc_scratch (plan, 3 * stride);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+    inbuf[0] = plan->scratch - gap;
+    inbuf[1] = plan->scratch + stride - gap;
+
+    if (MPI_IN_PLACE == sbuf) {
+        /* rbuf receives the other contributions, keep ours aside */
+        local = plan->scratch + 2 * stride - gap;
+        mca_coll_tuned_plan_copy (plan, (char *) rbuf, local, count);
+    }
+
+    if (size - 1 == root) {
+        mca_coll_tuned_plan_copy (plan, local, (char *) rbuf, count);
+    } else {
+        mca_coll_tuned_plan_recv (plan, (char *) rbuf, count, size - 1);
+    }
+
+    for (int i = size - 2, k = 0 ; i >= 0 ; --i) {
+        mca_coll_tuned_plan_round (plan);
+        if (NULL != pending) {
+            mca_coll_tuned_plan_op (plan, pending, (char *) rbuf, count);
+            pending = NULL;
+        }
+        if (i == root) {
+            mca_coll_tuned_plan_op (plan, local, (char *) rbuf, count);
+        } else {
+            mca_coll_tuned_plan_recv (plan, inbuf[k], count, i);
+            pending = inbuf[k];
+            k ^= 1;
+        }
+    }
+    if (NULL != pending) {
+        mca_coll_tuned_plan_round (plan);
+        mca_coll_tuned_plan_op (plan, pending, (char *) rbuf, count);
+    }
+
+    return OMPI_SUCCESS;
+}
+
+/* ompi_coll_base_reduce_generic for commutative operations, unrolled: an
+ * inner node receives a segment from its children while it reduces and
+ * forwards the previous one */
+static int mca_coll_tuned_plan_reduce_tree (mca_coll_tuned_plan_t *plan, const void *sbuf, void *rbuf,
+                                            size_t count, int root, size_t segcount, ompi_coll_tree_t *tree)
+{
+    int rank = ompi_comm_rank (plan->comm), nchildren = tree->tree_nextsize, ret;
+    size_t num_segments = (count + segcount - 1) / segcount;
+    char *local = (char *) sbuf, *accum = (char *) rbuf;
+    ptrdiff_t lb, extent, span, seg_span, gap = 0, seg_gap = 0, stride, seg_stride;
+    int nbufs = (num_segments > 1) ? 2 : 1;
+
+    ompi_datatype_get_extent (plan->dtype, &lb, &extent);
+
+#define SEGMENT(base, seg) ((base) + (ptrdiff_t) (seg) * (ptrdiff_t) segcount * extent)
+#define SEGCOUNT(seg) (((seg) == num_segments - 1) ? count - (seg) * segcount : segcount)
+#define INBUF(child, seg) (plan->scratch + stride + ((child) * nbufs + (seg) % nbufs) * seg_stride - seg_gap)
+
+    if (0 == nchildren) {
+        if (rank == root) {
+            if (MPI_IN_PLACE != sbuf) {
+                mca_coll_tuned_plan_copy (plan, (char *) sbuf, (char *) rbuf, count);
+            }
+            return OMPI_SUCCESS;
+        }
+        for (size_t seg = 0 ; seg < num_segments ; ++seg) {
+            mca_coll_tuned_plan_send (plan, SEGMENT(local, seg), SEGCOUNT(seg), tree->tree_prev);
+            mca_coll_tuned_plan_round (plan);
+        }
+        return OMPI_SUCCESS;
+    }
+
+    /* the inner nodes accumulate in scratch, the root in rbuf */
+    span = opal_datatype_span (&plan->dtype->super, count, &gap);
+    seg_span = opal_datatype_span (&plan->dtype->super, segcount, &seg_gap);
+    stride = (rank == root) ? 0 : OPAL_ALIGN(span, MCA_COLL_TUNED_PLAN_ALIGN, ptrdiff_t);
+    seg_stride = OPAL_ALIGN(seg_span, MCA_COLL_TUNED_PLAN_ALIGN, ptrdiff_t);
+    ret = mca_coll_tuned_plan_alloc_scratch (plan, stride + (size_t) nchildren * nbufs * seg_stride);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    if (rank == root) {
+        if (MPI_IN_PLACE == sbuf) {
+            local = (char *) rbuf;
+        }
+    } else {
+        accum = plan->scratch - gap;
+    }
+    if (local != accum) {
+        mca_coll_tuned_plan_copy (plan, local, accum, count);
+    }
+
+    for (size_t seg = 0 ; seg <= num_segments ; ++seg) {
+        if (seg > 0) {
+            for (int i = 0 ; i < nchildren ; ++i) {
+                mca_coll_tuned_plan_op (plan, INBUF(i, seg - 1), SEGMENT(accum, seg - 1), SEGCOUNT(seg - 1));
+            }
+            if (rank != root) {
+                mca_coll_tuned_plan_send (plan, SEGMENT(accum, seg - 1), SEGCOUNT(seg - 1), tree->tree_prev);
+            }
+        }
+        if (seg < num_segments) {
+            for (int i = 0 ; i < nchildren ; ++i) {
+                mca_coll_tuned_plan_recv (plan, INBUF(i, seg), SEGCOUNT(seg), tree->tree_next[i]);
+            }
+        }
+        mca_coll_tuned_plan_round (plan);
+    }
+
+#undef SEGMENT
+#undef SEGCOUNT
+#undef INBUF
+
+    return OMPI_SUCCESS;
+}
+
+int ompi_coll_tuned_reduce_intra_init (const void *sbuf, void *rbuf, size_t count,
+                                       struct ompi_datatype_t *dtype, struct ompi_op_t *op,
+                                       int root, struct ompi_communicator_t *comm, ompi_info_t *info,
+                                       ompi_request_t **request, mca_coll_base_module_t *module)
+{
+    mca_coll_tuned_module_t *tuned_module = (mca_coll_tuned_module_t *) module;
+    ompi_coll_tree_t *tree = NULL;
+    coll_tuned_decision_t decision;
+    mca_coll_tuned_plan_t *plan;
+    size_t segcount;
+    int ret;
+
+    if (module->coll_reduce == ompi_coll_tuned_reduce_intra_dec_dynamic) {
+        ompi_coll_tuned_reduce_intra_decide_dynamic (count, dtype, op, root, comm, module, &decision);
+    } else {
+        ompi_coll_tuned_reduce_intra_decide_fixed (count, dtype, op, root, comm, &decision);
+    }
+
+    /* the trees are only scheduled for commutative operations */
+    if (1 != decision.algorithm &&
+        (decision.algorithm < 2 || decision.algorithm > 5 || !ompi_op_is_commute (op))) {
+        if (NULL != tuned_module->previous_reduce_init) {
+            return tuned_module->previous_reduce_init (sbuf, rbuf, count, dtype, op, root, comm, info,
+                                                       request, tuned_module->previous_reduce_init_module);
+        }
+        decision.algorithm = 1;
+    }
+
+    plan = mca_coll_tuned_plan_new (dtype, op, comm);
+    if (NULL == plan) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    plan->decision = decision;
+
+    /* same topologies as the coll/base wrappers of the generic algorithm */
+    switch (decision.algorithm) {
+    case (2):  /* chain */
+        tree = ompi_coll_base_topo_build_chain (decision.faninout, comm, root);
+        break;
+    case (3):  /* pipeline */
+        tree = ompi_coll_base_topo_build_chain (1, comm, root);
+        break;
+    case (4):  /* binary */
+        tree = ompi_coll_base_topo_build_tree (2, comm, root);
+        break;
+    case (5):  /* binomial */
+        tree = ompi_coll_base_topo_build_in_order_bmtree (comm, root);
+        break;
+    }
+    segcount = mca_coll_tuned_plan_segcount (dtype, count, decision.segsize);
+
+    if (0 == count) {
+        ret = OMPI_SUCCESS;
+    } else if (1 == decision.algorithm) {
+        ret = mca_coll_tuned_plan_reduce_linear (plan, sbuf, rbuf, count, root);
+    } else if (NULL != tree) {
+        ret = mca_coll_tuned_plan_reduce_tree (plan, sbuf, rbuf, count, root, segcount, tree);
+    } else {
+        ret = OMPI_ERR_OUT_OF_RESOURCE;
+    }
+
+    if (NULL != tree) {
+        ompi_coll_base_topo_destroy_tree (&tree);
+    }
+
+    if (OMPI_SUCCESS == ret) {
+        ret = mca_coll_tuned_plan_finalize (plan);
+    }
+    if (OMPI_SUCCESS != ret) {
+        OBJ_RELEASE(plan);
+        return ret;
+    }
+
+    OPAL_OUTPUT_VERBOSE((COLL_TUNED_TRACING_VERBOSE, ompi_coll_tuned_stream,
+                         "coll:tuned:reduce_intra_init algorithm %d root %d segcount %zu rounds %d",
+                         decision.algorithm, root, segcount, plan->nrounds));
+
+    *request = &plan->super.super;
+    return OMPI_SUCCESS;
+}
@@ -16,6 +16,7 @@
 #include "ompi/mca/coll/coll.h"
 
 #include "opal/class/opal_hash_table.h"
+#include "opal/mca/hwloc/base/base.h"
 #include "opal/mca/rcache/rcache.h"
 #include "opal/mca/shmem/base/base.h"
 #include "opal/mca/smsc/smsc.h"
@@ -38,6 +39,7 @@ static int xhc_print_op_hierarchy_dot(xhc_module_t *module,
     ompi_communicator_t *comm, XHC_COLLTYPE_T colltype);
 
 static mca_smsc_endpoint_t *xhc_smsc_ep(xhc_peer_info_t *peer_info);
+static size_t xhc_detect_cache_size(void);
 
 // ------------------------------------------------
 
@@ -69,6 +71,13 @@ int mca_coll_xhc_lazy_init(xhc_module_t *module, ompi_communicator_t *comm) {
 
     peer_info[rank].locality |= ((1 << XHC_LOC_EXT_BITS) - 1) << XHC_LOC_EXT_START;
 
+    /* The pipelined reduction's chunk size depends on the cache size; all
+     * members must agree on it, so use the smallest one on the node. */
+    if(mca_coll_xhc_component.reduce_pipeline
+            && 0 == mca_coll_xhc_component.reduce_pipeline_cache_size) {
+        mca_coll_xhc_component.reduce_pipeline_cache_size = xhc_detect_cache_size();
+    }
+
     // ---
 
     OBJ_CONSTRUCT(&module->hierarchy_cache, opal_hash_table_t);
@@ -479,8 +488,30 @@ int mca_coll_xhc_read_op_config(xhc_module_t *module,
 
 // ------------------------------------------------
 
+static size_t xhc_detect_cache_size(void) {
+    size_t size = 0;
+
+    if(OPAL_SUCCESS == opal_hwloc_base_get_topology()) {
+        for(unsigned i = 0;; i++) {
+            hwloc_obj_t obj = opal_hwloc_base_get_obj_by_type(opal_hwloc_topology,
+                HWLOC_OBJ_L2CACHE, 2, i, OPAL_HWLOC_LOGICAL);
+            if(NULL == obj) {break;}
+
+            if(obj->attr && obj->attr->cache.size > 0
+                    && (0 == size || obj->attr->cache.size < size)) {
+                size = obj->attr->cache.size;
+            }
+        }
+    }
+
+    // No info from hwloc; assume a common L2 size
+    return (size > 0 ? size : XHC_PIPELINE_DEFAULT_CACHE_SIZE);
+}
+
+// ------------------------------------------------
+
 static int xhc_print_config_info(xhc_module_t *module, ompi_communicator_t *comm) {
-    char *drval_str, *lb_policy_str, *un_min_str;
+    char *drval_str, *lb_policy_str, *un_min_str, *pipeline_str;
     int err;
 
     switch(mca_coll_xhc_component.dynamic_reduce) {
@@ -514,18 +545,27 @@ static int xhc_print_config_info(xhc_module_t *module, ompi_communicator_t *comm
         mca_coll_xhc_component.uniform_chunks_min);
     if(err < 0) {return OMPI_ERR_OUT_OF_RESOURCE;}
 
+    err = opal_asprintf(&pipeline_str, " (depth %u, cache %zu bytes)",
+        mca_coll_xhc_component.reduce_pipeline_depth,
+        mca_coll_xhc_component.reduce_pipeline_cache_size);
+    if(err < 0) {free(un_min_str); return OMPI_ERR_OUT_OF_RESOURCE;}
+
     printf("------------------------------------------------\n"
         "OMPI coll/xhc @ %s, priority %d\n"
         "  dynamic leader '%s', dynamic reduce '%s'\n"
         "  reduce load balance '%s'\n"
-        "  allreduce uniform chunks '%s'%s\n",
+        "  allreduce uniform chunks '%s'%s\n"
+        "  allreduce pipeline '%s'%s\n",
         comm->c_name, mca_coll_xhc_component.priority,
         (mca_coll_xhc_component.dynamic_leader ? "ON" : "OFF"),
         drval_str, lb_policy_str,
         (mca_coll_xhc_component.uniform_chunks ? "ON" : "OFF"),
-        (mca_coll_xhc_component.uniform_chunks ? un_min_str : ""));
+        (mca_coll_xhc_component.uniform_chunks ? un_min_str : ""),
+        (mca_coll_xhc_component.reduce_pipeline ? "ON" : "OFF"),
+        (mca_coll_xhc_component.reduce_pipeline ? pipeline_str : ""));
 
     free(un_min_str);
+    free(pipeline_str);
 
     for(int t = 0; t < XHC_COLLCOUNT; t++) {
         xhc_op_config_t *config = &module->op_config[t];
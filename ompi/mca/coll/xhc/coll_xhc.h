@@ -78,6 +78,9 @@
 // Chunk size can't be set lower than this
 #define XHC_MIN_CHUNK_SIZE 64
 
+// Fallback for the pipelined reduction, when hwloc can't tell the L2 size
+#define XHC_PIPELINE_DEFAULT_CACHE_SIZE (1 << 20)
+
 // Call opal_progress every this many ticks when busy-waiting
 #define XHC_OPAL_PROGRESS_CYCLE 10000
 
@@ -218,6 +221,14 @@ struct mca_coll_xhc_component_t {
     bool uniform_chunks;
     size_t uniform_chunks_min;
 
+    bool reduce_pipeline;
+    uint reduce_pipeline_depth;
+    size_t reduce_pipeline_cache_size;
+
+    /* Chunk size chosen by the pipelined (all)reduce for the bottom
+     * level, in its latest invocation (exposed as a pvar) */
+    size_t reduce_pipeline_chunk;
+
     struct xhc_op_mca_t {
         char *hierarchy;
         char *chunk_size;
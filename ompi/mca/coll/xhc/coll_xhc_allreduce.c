@@ -35,6 +35,31 @@ static inline char *CICO_BUFFER(xhc_comm_t *xc, int member) {
 
 // -----------------------------
 
+/* Chunk size for a level in pipelined mode. The reduction on every level
+ * already proceeds chunk by chunk, as soon as the chunk's contributions are
+ * ready. Here the chunk is made small enough for each worker to go through
+ * at least `depth` of them, so that a level reduces chunk N while chunk N+1
+ * is still being produced by the level below, and for the operands of a
+ * step (own data, peer data, result) plus the next chunk in flight to fit
+ * in cache. All members of a level must arrive at the same value, as the
+ * reduce areas depend on it; the inputs are identical for all of them. */
+static size_t xhc_reduce_pipeline_chunk(xhc_comm_t *xc, size_t bytes_total) {
+    size_t depth = opal_max(mca_coll_xhc_component.reduce_pipeline_depth, 1U);
+    size_t cache = mca_coll_xhc_component.reduce_pipeline_cache_size;
+
+    size_t chunk = bytes_total / (xc->size * depth);
+
+    if(cache > 0) {
+        chunk = opal_min(chunk, cache / 4);
+    }
+
+    // Keep chunk boundaries on cache line boundaries (when possible)
+    chunk -= chunk % XHC_MIN_CHUNK_SIZE;
+
+    return opal_max(chunk, opal_max(XHC_MIN_CHUNK_SIZE,
+        mca_coll_xhc_component.uniform_chunks_min));
+}
+
 /* Calculate/generate the reduce sets/areas. A reduce set defines a
  * range/area of data to be reduced, and its settings. We require
  * multiple areas, because there might be different circumstances:
@@ -53,7 +78,8 @@ static inline char *CICO_BUFFER(xhc_comm_t *xc, int member) {
  * See also the comments in the reduce area struct definition for the different
  * fields, and the comments in the definition of xhc_reduce_load_balance_enum_t. */
 static void init_reduce_areas(xhc_comm_t *comms, size_t allreduce_count,
-        size_t dtype_size, xhc_reduce_load_balance_enum_t lb_policy) {
+        size_t dtype_size, xhc_reduce_load_balance_enum_t lb_policy,
+        bool pipeline) {
 
     bool uniform_chunks = mca_coll_xhc_component.uniform_chunks;
 
@@ -87,6 +113,17 @@ static void init_reduce_areas(xhc_comm_t *comms, size_t allreduce_count,
         size_t min_elems = mca_coll_xhc_component.uniform_chunks_min / dtype_size;
         size_t max_elems = xc->chunk_size / dtype_size;
 
+        if(pipeline) {
+            size_t chunk = xhc_reduce_pipeline_chunk(xc,
+                allreduce_count * dtype_size);
+
+            if(xc == comms) {
+                mca_coll_xhc_component.reduce_pipeline_chunk = chunk;
+            }
+
+            max_elems = opal_max(chunk / dtype_size, 1);
+        }
+
         int area_id = 0;
         size_t el_idx = 0;
 
@@ -207,7 +244,7 @@ static void init_reduce_areas(xhc_comm_t *comms, size_t allreduce_count,
 
 static void xhc_allreduce_init_local(xhc_comm_t *comms,
         size_t allreduce_count, size_t dtype_size, XHC_COLLTYPE_T colltype,
-        xhc_reduce_load_balance_enum_t lb_policy, xf_sig_t seq) {
+        xhc_reduce_load_balance_enum_t lb_policy, bool pipeline, xf_sig_t seq) {
 
     for(xhc_comm_t *xc = comms; xc; xc = xc->up) {
         // Non-leader by default
@@ -248,7 +285,7 @@ static void xhc_allreduce_init_local(xhc_comm_t *comms,
         xc->do_all_work = false;
     }
 
-    init_reduce_areas(comms, allreduce_count, dtype_size, lb_policy);
+    init_reduce_areas(comms, allreduce_count, dtype_size, lb_policy, pipeline);
 
     for(xhc_comm_t *xc = comms; xc; xc = xc->up) {
         size_t init_count = (xc->n_reduce_areas > 0 ?
@@ -959,6 +996,7 @@ int mca_coll_xhc_allreduce_internal(const void *sbuf, void *rbuf, size_t count,
     bytes_total = count * dtype_size;
 
     xhc_copy_method_t method;
+    bool pipeline;
 
     bool out_of_order_reduce = false;
     xhc_reduce_load_balance_enum_t lb_policy;
@@ -1000,6 +1038,11 @@ int mca_coll_xhc_allreduce_internal(const void *sbuf, void *rbuf, size_t count,
     if(XHC_COPY_IMM == method) {lb_policy = XHC_REDUCE_LB_LEADER_ASSIST_ALL;}
     else {lb_policy = mca_coll_xhc_component.reduce_load_balance;}
 
+    /* Pipelining matters for large messages; it's also only
+     * applicable to single-copy, as CICO publishes fixed chunks. */
+    pipeline = (mca_coll_xhc_component.reduce_pipeline
+        && XHC_COPY_SMSC == method);
+
     /* We require a buffer to store intermediate data. In cases like MPI_Ruduce,
      * non-root ranks don't normally have an rbuf, so allocate an internal one.
      * TODO: Strictly speaking, the members that won't do reductions, shouldn't
@@ -1024,7 +1067,8 @@ int mca_coll_xhc_allreduce_internal(const void *sbuf, void *rbuf, size_t count,
 
     xf_sig_t seq = ++op_data->seq;
 
-    xhc_allreduce_init_local(comms, count, dtype_size, colltype, lb_policy, seq);
+    xhc_allreduce_init_local(comms, count, dtype_size,
+        colltype, lb_policy, pipeline, seq);
     xhc_allreduce_init_comm(comms, rank, seq);
 
     // My conscience is clear!
@@ -17,6 +17,7 @@
 #include "ompi/mca/coll/base/coll_base_util.h"
 
 #include "opal/include/opal/align.h"
+#include "opal/mca/base/mca_base_pvar.h"
 #include "opal/mca/shmem/base/base.h"
 #include "opal/util/show_help.h"
 
@@ -110,6 +111,11 @@ mca_coll_xhc_component_t mca_coll_xhc_component = {
     .uniform_chunks = true,
     .uniform_chunks_min = 4096,
 
+    .reduce_pipeline = false,
+    .reduce_pipeline_depth = 8,
+    .reduce_pipeline_cache_size = 0,
+    .reduce_pipeline_chunk = 0,
+
     .op_mca = {{0}},
     .op_mca_global = {0}
 };
@@ -350,6 +356,37 @@ static int xhc_register(void) {
         NULL, 0, 0, OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY,
         &mca_coll_xhc_component.uniform_chunks_min);
 
+    /* (All)reduce pipeline */
+    // -----------------------------
+
+    mca_base_component_var_register(&mca_coll_xhc_component.super.collm_version,
+        "reduce_pipeline", "Derive the chunk size of each level in large "
+        "(all)reductions from the message size and the cache size, so that "
+        "every level reduces a chunk while the next ones are still arriving.",
+        MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0, OPAL_INFO_LVL_5,
+        MCA_BASE_VAR_SCOPE_READONLY, &mca_coll_xhc_component.reduce_pipeline);
+
+    mca_base_component_var_register(&mca_coll_xhc_component.super.collm_version,
+        "reduce_pipeline_depth", "Minimum number of chunks that each member "
+        "reduces in a level, when \"reduce pipeline\" is enabled.",
+        MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0, 0, OPAL_INFO_LVL_5,
+        MCA_BASE_VAR_SCOPE_READONLY, &mca_coll_xhc_component.reduce_pipeline_depth);
+
+    mca_base_component_var_register(&mca_coll_xhc_component.super.collm_version,
+        "reduce_pipeline_cache_size", "Cache size that bounds the chunk size, "
+        "when \"reduce pipeline\" is enabled (0 = smallest L2 cache on the "
+        "node, as reported by hwloc).", MCA_BASE_VAR_TYPE_SIZE_T,
+        NULL, 0, 0, OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_READONLY,
+        &mca_coll_xhc_component.reduce_pipeline_cache_size);
+
+    mca_base_component_pvar_register(&mca_coll_xhc_component.super.collm_version,
+        "reduce_pipeline_chunk", "Chunk size (bytes) chosen for the bottom "
+        "level in the latest pipelined (all)reduction.", OPAL_INFO_LVL_5,
+        MCA_BASE_PVAR_CLASS_SIZE, MCA_BASE_VAR_TYPE_UNSIGNED_LONG, NULL,
+        MCA_BASE_VAR_BIND_NO_OBJECT, MCA_BASE_PVAR_FLAG_READONLY
+        | MCA_BASE_PVAR_FLAG_CONTINUOUS, NULL, NULL, NULL,
+        (void *) &mca_coll_xhc_component.reduce_pipeline_chunk);
+
     /* Apply the op mca defaults. Gotta do it here rather than in-line in
      * the registration loops below, as some iterations are skipped, for the
      * variables that are not applicable (e.g. chunk size in Barrier). */
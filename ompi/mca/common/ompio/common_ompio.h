@@ -86,6 +86,7 @@
 #define SIMPLE                          5
 #define NO_REFINEMENT                   6
 #define SIMPLE_PLUS                     7
+#define TOPOLOGY                        8
 
 #define OMPIO_LOCK_ENTIRE_REGION  10
 #define OMPIO_LOCK_SELECTIVE      11
@@ -195,6 +196,8 @@ struct ompio_file_t {
        Note: Neither f_sharedfp nor f_sharedfp_component seemed appropriate for this.
     */
     void                  *f_sharedfp_data;
+    /* Place for the selected fbtl module to hang per-file data */
+    void                  *f_fbtl_data;
 
     /* File View parameters */
     struct ompio_fview_t   f_fview;
@@ -37,7 +37,9 @@
 #include "opal/datatype/opal_datatype.h"
 #include "ompi/datatype/ompi_datatype.h"
 #include "ompi/info/info.h"
+#include "ompi/proc/proc.h"
 #include "ompi/request/request.h"
+#include "opal/mca/hwloc/base/base.h"
 
 #include <math.h>
 #include <unistd.h>
@@ -54,15 +56,15 @@
 ** 2. fview_based_grouping: analysis the fileview to detect regular patterns
 ** 3. cart_based_grouping: uses a cartesian communicator to derive certain (probable) properties
 **    of the access pattern
+** 4. topology_grouping: spreads the aggregators across nodes and NUMA domains based on
+**    the data volume of the processes located there
 */
 
 static double cost_calc (int P, int P_agg, size_t Data_proc, size_t coll_buffer, int dim );
 #define DIM1 1
 #define DIM2 2
 
-int mca_common_ompio_simple_grouping(ompio_file_t *fh,
-                                     int *num_groups_out,
-                                     mca_common_ompio_contg *contg_groups)
+int mca_common_ompio_cost_based_num_groups(ompio_file_t *fh)
 {
     int num_groups=1;
 
@@ -184,10 +186,17 @@ int mca_common_ompio_simple_grouping(ompio_file_t *fh,
     if ( 1 >= num_groups ) {
 	num_groups = 1;
     }
-    
-    *num_groups_out = num_groups;
 
-    return mca_common_ompio_forced_grouping ( fh, num_groups, contg_groups);
+    return num_groups;
+}
+
+int mca_common_ompio_simple_grouping(ompio_file_t *fh,
+                                     int *num_groups_out,
+                                     mca_common_ompio_contg *contg_groups)
+{
+    *num_groups_out = mca_common_ompio_cost_based_num_groups (fh);
+
+    return mca_common_ompio_forced_grouping ( fh, *num_groups_out, contg_groups);
 }
 
 int  mca_common_ompio_forced_grouping ( ompio_file_t *fh,
@@ -225,6 +234,284 @@ int  mca_common_ompio_forced_grouping ( ompio_file_t *fh,
     return OMPI_SUCCESS;
 }
 
+/*
+** Topology-aware grouping. The aggregators are first distributed across
+** the nodes, then across the NUMA domains of each node, in proportion to
+** the data volume of the processes located there. Every process is grouped
+** with an aggregator of its own NUMA domain if it has one, else with an
+** aggregator of its own node, so the shuffle phase uses the shared-memory
+** path. Only nodes without an aggregator (fewer aggregators than nodes)
+** send their data to an aggregator on another node.
+*/
+#define TOPO_NODE    0
+#define TOPO_NUMA    1
+#define TOPO_VOLUME  2
+#define TOPO_FIELDS  3
+
+/* Distribute count items across nbins bins (bins[i], or i if bins is NULL)
+** using the highest averages method, never exceeding cap[] for a bin. If
+** there are enough items, every bin receives at least one. */
+static void topology_apportion (int nbins, const int *bins, int count,
+                                const OMPI_MPI_OFFSET_TYPE *weight,
+                                const int *cap, int *share)
+{
+    int i, b, best;
+    double quot, best_quot;
+
+    for ( i=0; i<nbins; i++ ) {
+        b = (NULL == bins) ? i : bins[i];
+        share[b] = 0;
+        if ( count >= nbins ) {
+            share[b] = 1;
+        }
+    }
+    if ( count >= nbins ) {
+        count -= nbins;
+    }
+
+    for ( ; count > 0; count-- ) {
+        best = -1;
+        best_quot = -1.0;
+        for ( i=0; i<nbins; i++ ) {
+            b = (NULL == bins) ? i : bins[i];
+            if ( share[b] >= cap[b] ) {
+                continue;
+            }
+            quot = ((double) weight[b] + 1.0) / (double) (share[b] + 1);
+            if ( quot > best_quot ) {
+                best_quot = quot;
+                best = b;
+            }
+        }
+        if ( -1 == best ) {
+            break;
+        }
+        share[best]++;
+    }
+}
+
+int mca_common_ompio_topology_grouping(ompio_file_t *fh,
+                                       int num_groups,
+                                       mca_common_ompio_contg *contg_groups)
+{
+    int i, j, k, p, n, d, r, g, s;
+    int nnodes=0, nnuma=0, nodes_with_aggr=0;
+    int node_leader, numa_leader;
+    int ret = OMPI_SUCCESS;
+    OMPI_MPI_OFFSET_TYPE topo[TOPO_FIELDS];
+    OMPI_MPI_OFFSET_TYPE *all_topo=NULL, *node_vol, *numa_vol;
+    int *scratch=NULL;
+    int *node_idx, *numa_idx, *node_ranks, *numa_ranks, *node_share, *numa_share;
+    int *numa_node, *numa_order, *numa_start, *rank_order, *rank_start, *node_first_group;
+    ompi_proc_t *proc;
+    char msg[128];
+
+    if ( num_groups > fh->f_size ) {
+        num_groups = fh->f_size;
+    }
+    if ( 1 > num_groups ) {
+        num_groups = 1;
+    }
+
+    /* Identify the node and the NUMA domain of this process by the lowest
+    ** rank sharing it. Peers which have not been added yet are not local. */
+    node_leader = fh->f_rank;
+    numa_leader = fh->f_rank;
+    for ( i=fh->f_rank-1; i>=0; i-- ) {
+        proc = ompi_group_peer_lookup_existing (fh->f_comm->c_local_group, i);
+        if ( NULL == proc || !OPAL_PROC_ON_LOCAL_NODE(proc->super.proc_flags) ) {
+            continue;
+        }
+        node_leader = i;
+        if ( OPAL_PROC_ON_LOCAL_NUMA(proc->super.proc_flags) ) {
+            numa_leader = i;
+        }
+    }
+    topo[TOPO_NODE]   = node_leader;
+    topo[TOPO_NUMA]   = numa_leader;
+    topo[TOPO_VOLUME] = (OMPI_MPI_OFFSET_TYPE) fh->f_fview.f_view_size;
+
+    all_topo = (OMPI_MPI_OFFSET_TYPE *) malloc ((TOPO_FIELDS + 2) * fh->f_size * sizeof(OMPI_MPI_OFFSET_TYPE));
+    scratch  = (int *) malloc (12 * (fh->f_size + 1) * sizeof(int));
+    if ( NULL == all_topo || NULL == scratch ) {
+        opal_output (1, "OUT OF MEMORY\n");
+        ret = OMPI_ERR_OUT_OF_RESOURCE;
+        goto exit;
+    }
+    node_vol         = all_topo + TOPO_FIELDS * fh->f_size;
+    numa_vol         = node_vol + fh->f_size;
+    node_idx         = scratch;
+    numa_idx         = node_idx   + fh->f_size + 1;
+    node_ranks       = numa_idx   + fh->f_size + 1;
+    numa_ranks       = node_ranks + fh->f_size + 1;
+    node_share       = numa_ranks + fh->f_size + 1;
+    numa_share       = node_share + fh->f_size + 1;
+    numa_node        = numa_share + fh->f_size + 1;
+    numa_order       = numa_node  + fh->f_size + 1;
+    numa_start       = numa_order + fh->f_size + 1;
+    rank_order       = numa_start + fh->f_size + 1;
+    rank_start       = rank_order + fh->f_size + 1;
+    node_first_group = rank_start + fh->f_size + 1;
+
+    ret = fh->f_comm->c_coll->coll_allgather (topo,
+                                             TOPO_FIELDS,
+                                             OMPI_OFFSET_DATATYPE,
+                                             all_topo,
+                                             TOPO_FIELDS,
+                                             OMPI_OFFSET_DATATYPE,
+                                             fh->f_comm,
+                                             fh->f_comm->c_coll->coll_allgather_module);
+    if ( OMPI_SUCCESS != ret ) {
+        goto exit;
+    }
+
+    /* Number the nodes and NUMA domains in the order of their leaders. A
+    ** leader that does not consider itself a leader (inconsistent locality
+    ** information) is ignored, the process then forms a domain of its own. */
+    for ( r=0; r<fh->f_size; r++ ) {
+        node_leader = (int) all_topo[TOPO_FIELDS*r + TOPO_NODE];
+        numa_leader = (int) all_topo[TOPO_FIELDS*r + TOPO_NUMA];
+
+        if ( node_leader < r && node_leader == all_topo[TOPO_FIELDS*node_leader + TOPO_NODE] ) {
+            n = node_idx[node_leader];
+        }
+        else {
+            n = nnodes++;
+            node_ranks[n] = 0;
+            node_vol[n]   = 0;
+            numa_leader   = r;
+        }
+        node_idx[r] = n;
+        node_ranks[n]++;
+        node_vol[n] += all_topo[TOPO_FIELDS*r + TOPO_VOLUME];
+
+        if ( numa_leader < r && numa_leader == all_topo[TOPO_FIELDS*numa_leader + TOPO_NUMA] &&
+             node_idx[numa_leader] == n ) {
+            d = numa_idx[numa_leader];
+        }
+        else {
+            d = nnuma++;
+            numa_ranks[d] = 0;
+            numa_vol[d]   = 0;
+            numa_node[d]  = n;
+        }
+        numa_idx[r] = d;
+        numa_ranks[d]++;
+        numa_vol[d] += all_topo[TOPO_FIELDS*r + TOPO_VOLUME];
+    }
+
+    /* Sort the NUMA domains by node and the ranks by NUMA domain. Both
+    ** keep the original order within a node or domain. */
+    for ( n=0; n<=nnodes; n++ ) {
+        numa_start[n] = 0;
+    }
+    for ( d=0; d<nnuma; d++ ) {
+        numa_start[numa_node[d]+1]++;
+    }
+    for ( n=0; n<nnodes; n++ ) {
+        numa_start[n+1] += numa_start[n];
+        node_first_group[n] = numa_start[n];
+    }
+    for ( d=0; d<nnuma; d++ ) {
+        numa_order[node_first_group[numa_node[d]]++] = d;
+    }
+
+    rank_start[0] = 0;
+    for ( d=0; d<nnuma; d++ ) {
+        rank_start[d+1] = rank_start[d] + numa_ranks[d];
+        numa_share[d] = rank_start[d];
+    }
+    for ( r=0; r<fh->f_size; r++ ) {
+        rank_order[numa_share[numa_idx[r]]++] = r;
+    }
+
+    /* Distribute the aggregators across nodes, then across the NUMA
+    ** domains of every node. */
+    topology_apportion (nnodes, NULL, num_groups, node_vol, node_ranks, node_share);
+    for ( n=0; n<nnodes; n++ ) {
+        topology_apportion (numa_start[n+1] - numa_start[n], numa_order + numa_start[n],
+                            node_share[n], numa_vol, numa_ranks, numa_share);
+    }
+
+    /* Split the processes of a NUMA domain into numa_share[d] groups of
+    ** contiguous ranks with about the same data volume. The first process of
+    ** a group is its aggregator. */
+    p = 0;
+    for ( n=0; n<nnodes; n++ ) {
+        node_first_group[n] = p;
+        if ( 0 < node_share[n] ) {
+            nodes_with_aggr++;
+        }
+        for ( k=numa_start[n]; k<numa_start[n+1]; k++ ) {
+            OMPI_MPI_OFFSET_TYPE acc = 0, vol = numa_vol[numa_order[k]];
+            d = numa_order[k];
+            s = numa_share[d];
+            j = rank_start[d];
+
+            for ( g=0; g<s; g++, p++ ) {
+                double target = (double) (g+1) / (double) s;
+                contg_groups[p].procs_per_contg_group = 0;
+                contg_groups[p].contg_chunk_size = 0;
+                do {
+                    r = rank_order[j++];
+                    contg_groups[p].procs_in_contg_group[contg_groups[p].procs_per_contg_group++] = r;
+                    contg_groups[p].contg_chunk_size += all_topo[TOPO_FIELDS*r + TOPO_VOLUME];
+                    acc += (0 < vol) ? all_topo[TOPO_FIELDS*r + TOPO_VOLUME] : 1;
+                } while ( j < rank_start[d+1] && (rank_start[d+1] - j) > (s - g - 1) &&
+                          (g == s - 1 || (double) acc < target * (double) ((0 < vol) ? vol : numa_ranks[d])) );
+            }
+        }
+    }
+    node_first_group[nnodes] = p;
+
+    /* Processes of NUMA domains without an aggregator join the group with
+    ** the smallest volume on their node. A node without any aggregator is
+    ** assigned as a whole to the group with the smallest volume overall. */
+    for ( n=0; n<nnodes; n++ ) {
+        int first = node_first_group[n], last = node_first_group[n+1];
+
+        if ( first == last ) {
+            for ( g=0, i=1; i<p; i++ ) {
+                if ( contg_groups[i].contg_chunk_size < contg_groups[g].contg_chunk_size ) {
+                    g = i;
+                }
+            }
+            first = g;
+            last  = g + 1;
+        }
+        for ( k=numa_start[n]; k<numa_start[n+1]; k++ ) {
+            d = numa_order[k];
+            if ( 0 < numa_share[d] ) {
+                continue;
+            }
+            for ( j=rank_start[d]; j<rank_start[d+1]; j++ ) {
+                r = rank_order[j];
+                for ( g=first, i=first+1; i<last; i++ ) {
+                    if ( contg_groups[i].contg_chunk_size < contg_groups[g].contg_chunk_size ) {
+                        g = i;
+                    }
+                }
+                contg_groups[g].procs_in_contg_group[contg_groups[g].procs_per_contg_group++] = r;
+                contg_groups[g].contg_chunk_size += all_topo[TOPO_FIELDS*r + TOPO_VOLUME];
+            }
+        }
+    }
+
+    snprintf (msg, sizeof(msg), "%d aggregators on %d of %d nodes, %d NUMA domains",
+              p, nodes_with_aggr, nnodes, nnuma);
+    OMPIO_MCA_PRINT_INFO(fh, "grouping_option", "topology", msg);
+
+exit:
+    if ( NULL != all_topo ) {
+        free (all_topo);
+    }
+    if ( NULL != scratch ) {
+        free (scratch);
+    }
+
+    return ret;
+}
+
 int mca_common_ompio_fview_based_grouping(ompio_file_t *fh,
                      		          int *num_groups,
 				          mca_common_ompio_contg *contg_groups)
@@ -514,7 +801,8 @@ int mca_common_ompio_set_aggregator_props (struct ompio_file_t *fh,
     if ( (-1 == num_aggregators) && 
          ((SIMPLE        != OMPIO_MCA_GET(fh, grouping_option) &&
            NO_REFINEMENT != OMPIO_MCA_GET(fh, grouping_option) &&
-           SIMPLE_PLUS   != OMPIO_MCA_GET(fh, grouping_option) ))) {
+           SIMPLE_PLUS   != OMPIO_MCA_GET(fh, grouping_option) &&
+           TOPOLOGY      != OMPIO_MCA_GET(fh, grouping_option) ))) {
         ret = mca_common_ompio_create_groups(fh,bytes_per_proc);
     }
     else {
@@ -56,12 +56,17 @@ int  mca_common_ompio_forced_grouping ( ompio_file_t *fh,
                                         int num_groups,
                                         mca_common_ompio_contg *contg_groups);
 
+int mca_common_ompio_topology_grouping(ompio_file_t *fh, int num_groups,
+                                       mca_common_ompio_contg *contg_groups);
+
 int mca_common_ompio_cart_based_grouping(ompio_file_t *ompio_fh, int *num_groups,
                                          mca_common_ompio_contg *contg_groups);
 
 int mca_common_ompio_fview_based_grouping(ompio_file_t *fh, int *num_groups,
                                           mca_common_ompio_contg *contg_groups);
 
+int mca_common_ompio_cost_based_num_groups(ompio_file_t *fh);
+
 int mca_common_ompio_simple_grouping(ompio_file_t *fh, int *num_groups,
                                      mca_common_ompio_contg *contg_groups);
 
@@ -250,10 +250,27 @@ int mca_common_ompio_set_view (ompio_file_t *fh,
         if ( num_groups > fh->f_size ) {
             num_groups = fh->f_size;
         }
-        mca_common_ompio_forced_grouping ( fh, num_groups, contg_groups);
+        if ( TOPOLOGY == OMPIO_MCA_GET(fh, grouping_option) ) {
+            ret = mca_common_ompio_topology_grouping ( fh, num_groups, contg_groups);
+            if ( OMPI_SUCCESS != ret ) {
+                opal_output(1, "mca_common_ompio_set_view: mca_common_ompio_topology_grouping failed\n");
+                goto exit;
+            }
+        }
+        else {
+            mca_common_ompio_forced_grouping ( fh, num_groups, contg_groups);
+        }
     }
     else {
-        if ( SIMPLE != OMPIO_MCA_GET(fh, grouping_option) && 
+        if ( TOPOLOGY == OMPIO_MCA_GET(fh, grouping_option) ) {
+            num_groups = mca_common_ompio_cost_based_num_groups (fh);
+            ret = mca_common_ompio_topology_grouping ( fh, num_groups, contg_groups);
+            if ( OMPI_SUCCESS != ret ) {
+                opal_output(1, "mca_common_ompio_set_view: mca_common_ompio_topology_grouping failed\n");
+                goto exit;
+            }
+        }
+        else if ( SIMPLE != OMPIO_MCA_GET(fh, grouping_option) && 
              SIMPLE_PLUS != OMPIO_MCA_GET(fh, grouping_option) ) {
             ret = mca_common_ompio_fview_based_grouping(fh,
                                                         &num_groups,
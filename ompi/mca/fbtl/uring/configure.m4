@@ -0,0 +1,28 @@
+# -*- shell-script -*-
+#
+# $COPYRIGHT$
+#
+# Additional copyrights may follow
+#
+# $HEADER$
+#
+
+# MCA_fbtl_uring_CONFIG(action-if-can-compile,
+#                       [action-if-cant-compile])
+# ------------------------------------------------
+AC_DEFUN([MCA_ompi_fbtl_uring_CONFIG],[
+    AC_CONFIG_FILES([ompi/mca/fbtl/uring/Makefile])
+
+    OMPI_CHECK_LIBURING([fbtl_uring],
+                        [fbtl_uring_happy="yes"],
+                        [fbtl_uring_happy="no"])
+
+    AS_IF([test "$fbtl_uring_happy" = "yes"],
+          [$1],
+          [$2])
+
+    # substitute in the things needed to build uring
+    AC_SUBST([fbtl_uring_CPPFLAGS])
+    AC_SUBST([fbtl_uring_LDFLAGS])
+    AC_SUBST([fbtl_uring_LIBS])
+])dnl
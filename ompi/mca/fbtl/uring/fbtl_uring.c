@@ -0,0 +1,496 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+#include "mpi.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "opal/mca/threads/mutex.h"
+#include "ompi/constants.h"
+#include "ompi/mca/fbtl/fbtl.h"
+#include "ompi/mca/fbtl/uring/fbtl_uring.h"
+
+static bool mca_fbtl_uring_check_atomicity (ompio_file_t *file);
+
+/*
+ * *******************************************************************
+ * ************************ actions structure ************************
+ * *******************************************************************
+ */
+static mca_fbtl_base_module_1_0_0_t uring =  {
+    mca_fbtl_uring_module_init,     /* initialise after being selected */
+    mca_fbtl_uring_module_finalize, /* close a module on a communicator */
+    mca_fbtl_uring_preadv,          /* blocking read */
+    mca_fbtl_uring_ipreadv,         /* non-blocking read*/
+    mca_fbtl_uring_pwritev,         /* blocking write */
+    mca_fbtl_uring_ipwritev,        /* non-blocking write */
+    mca_fbtl_uring_progress,        /* module specific progress */
+    mca_fbtl_uring_request_free,    /* free module specific data items on the request */
+    mca_fbtl_uring_check_atomicity  /* check whether atomicity is supported on this fs */
+};
+/*
+ * *******************************************************************
+ * ************************* structure ends **************************
+ * *******************************************************************
+ */
+
+int mca_fbtl_uring_component_init_query(bool enable_progress_threads,
+                                        bool enable_mpi_threads)
+{
+    struct io_uring ring;
+
+    /* io_uring might be compiled out of the kernel or blocked by a
+     * seccomp filter even though liburing was found at build time */
+    if (0 > io_uring_queue_init(1, &ring, 0)) {
+        return OMPI_ERR_NOT_AVAILABLE;
+    }
+    io_uring_queue_exit(&ring);
+
+    return OMPI_SUCCESS;
+}
+
+struct mca_fbtl_base_module_1_0_0_t *
+mca_fbtl_uring_component_file_query (ompio_file_t *fh, int *priority)
+{
+   *priority = mca_fbtl_uring_priority;
+
+   return &uring;
+}
+
+int mca_fbtl_uring_component_file_unquery (ompio_file_t *file)
+{
+   /* This function might be needed for some purposes later. for now it
+    * does not have anything to do since there are no steps which need
+    * to be undone if this module is not selected */
+
+   return OMPI_SUCCESS;
+}
+
+int mca_fbtl_uring_module_init (ompio_file_t *file)
+{
+    /* the file is not open yet, the ring is set up on first use */
+    file->f_fbtl_data = NULL;
+
+    return OMPI_SUCCESS;
+}
+
+int mca_fbtl_uring_module_finalize (ompio_file_t *file)
+{
+    mca_fbtl_uring_file_t *ufile = (mca_fbtl_uring_file_t *) file->f_fbtl_data;
+
+    if (NULL != ufile) {
+        io_uring_queue_exit(&ufile->ring);
+        OBJ_DESTRUCT(&ufile->lock);
+        free(ufile);
+        file->f_fbtl_data = NULL;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+static mca_fbtl_uring_file_t *mca_fbtl_uring_file_get (ompio_file_t *fh)
+{
+    mca_fbtl_uring_file_t *ufile = (mca_fbtl_uring_file_t *) fh->f_fbtl_data;
+    int ret;
+
+    if (NULL == ufile) {
+        ufile = (mca_fbtl_uring_file_t *) calloc(1, sizeof(mca_fbtl_uring_file_t));
+        if (NULL == ufile) {
+            return NULL;
+        }
+        ret = io_uring_queue_init(mca_fbtl_uring_queue_depth, &ufile->ring, 0);
+        if (0 > ret) {
+            opal_output(1, "mca_fbtl_uring: error in io_uring_queue_init(): %s", strerror(-ret));
+            free(ufile);
+            return NULL;
+        }
+        OBJ_CONSTRUCT(&ufile->lock, opal_mutex_t);
+        ufile->ring_fd = -1;
+        fh->f_fbtl_data = ufile;
+    }
+
+    /* saves the kernel a file table lookup and reference per SQE */
+    if (ufile->ring_fd != fh->fd) {
+        if (ufile->ring_fixed) {
+            (void) io_uring_unregister_files(&ufile->ring);
+        }
+        ufile->ring_fd = fh->fd;
+        ufile->ring_fixed = mca_fbtl_uring_fixed_files &&
+            0 == io_uring_register_files(&ufile->ring, &fh->fd, 1);
+    }
+
+    return ufile;
+}
+
+static void mca_fbtl_uring_unlock (mca_fbtl_uring_request_data_t *data)
+{
+    if (data->urd_locked) {
+        data->urd_lock.l_type = F_UNLCK;
+        fcntl(data->urd_fh->fd, F_SETLK, &data->urd_lock);
+        data->urd_locked = false;
+    }
+}
+
+/* Lock the whole region of the request, where the posix fbtl would lock
+ * it. Locks are held by the process until the request completes. */
+static int mca_fbtl_uring_lock (mca_fbtl_uring_request_data_t *data, off_t start, off_t end)
+{
+    ompio_file_t *fh = data->urd_fh;
+    int ret;
+
+    if (!fh->f_atomicity &&
+        ((fh->f_flags & OMPIO_LOCK_NEVER) || (fh->f_flags & OMPIO_LOCK_NOT_THIS_OP))) {
+        return OMPI_SUCCESS;
+    }
+
+    data->urd_lock.l_type   = (FBTL_URING_READ == data->urd_req_type) ? F_RDLCK : F_WRLCK;
+    data->urd_lock.l_whence = SEEK_SET;
+    data->urd_lock.l_pid    = 0;
+    if (fh->f_flags & OMPIO_LOCK_ENTIRE_FILE) {
+        data->urd_lock.l_start = 0;
+        data->urd_lock.l_len   = 0;
+    } else {
+        data->urd_lock.l_start = start;
+        data->urd_lock.l_len   = end - start;
+    }
+
+    do {
+        ret = fcntl(fh->fd, F_SETLKW, &data->urd_lock);
+    } while (-1 == ret && EINTR == errno);
+
+    if (-1 == ret) {
+        opal_output(1, "mca_fbtl_uring: error in fcntl(): %s", strerror(errno));
+        return OMPI_ERROR;
+    }
+    data->urd_locked = true;
+
+    return OMPI_SUCCESS;
+}
+
+int mca_fbtl_uring_request_data_create (ompio_file_t *fh, int io_op,
+                                        mca_fbtl_uring_request_data_t **data_out)
+{
+    mca_fbtl_uring_request_data_t *data;
+    mca_fbtl_uring_op_t *op = NULL;
+    off_t start, end, offset;
+    int i, ret;
+
+    if (NULL == mca_fbtl_uring_file_get(fh)) {
+        return OMPI_ERROR;
+    }
+
+    data = (mca_fbtl_uring_request_data_t *) calloc(1, sizeof(mca_fbtl_uring_request_data_t));
+    if (NULL == data) {
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    data->urd_iovecs = (struct iovec *) malloc((fh->f_num_of_io_entries + 1) * sizeof(struct iovec));
+    data->urd_ops = (mca_fbtl_uring_op_t *) malloc((fh->f_num_of_io_entries + 1) *
+                                                   sizeof(mca_fbtl_uring_op_t));
+    if (NULL == data->urd_iovecs || NULL == data->urd_ops) {
+        mca_fbtl_uring_request_data_release(data);
+        return OMPI_ERR_OUT_OF_RESOURCE;
+    }
+    data->urd_req_type = io_op;
+    data->urd_fh = fh;
+
+    /* Aggregate the io entries that are contiguous in the file into a
+     * single vectored operation. */
+    start = end = 0;
+    for (i = 0 ; i < fh->f_num_of_io_entries ; i++) {
+        offset = (off_t) fh->f_io_array[i].offset;
+        data->urd_iovecs[i].iov_base = fh->f_io_array[i].memory_address;
+        data->urd_iovecs[i].iov_len  = fh->f_io_array[i].length;
+
+        if (NULL == op || offset != op->op_offset + (off_t) op->op_length ||
+            op->op_iovcnt >= mca_fbtl_uring_iov_max) {
+            op = data->urd_ops + data->urd_op_count++;
+            op->op_data   = data;
+            op->op_iov    = data->urd_iovecs + i;
+            op->op_iovcnt = 0;
+            op->op_offset = offset;
+            op->op_length = 0;
+        }
+        op->op_iovcnt++;
+        op->op_length += fh->f_io_array[i].length;
+
+        if (0 == i || offset < start) {
+            start = offset;
+        }
+        if (offset + (off_t) fh->f_io_array[i].length > end) {
+            end = offset + (off_t) fh->f_io_array[i].length;
+        }
+    }
+    data->urd_open_ops = data->urd_op_count;
+
+    ret = (start < end) ? mca_fbtl_uring_lock(data, start, end) : OMPI_SUCCESS;
+    if (OMPI_SUCCESS != ret) {
+        mca_fbtl_uring_request_data_release(data);
+        return ret;
+    }
+
+    *data_out = data;
+
+    return OMPI_SUCCESS;
+}
+
+void mca_fbtl_uring_request_data_release (mca_fbtl_uring_request_data_t *data)
+{
+    mca_fbtl_uring_unlock(data);
+    free(data->urd_ops);
+    free(data->urd_iovecs);
+    free(data);
+}
+
+static void mca_fbtl_uring_prep (mca_fbtl_uring_file_t *ufile, struct io_uring_sqe *sqe,
+                                 mca_fbtl_uring_op_t *op)
+{
+    int fd = ufile->ring_fixed ? 0 : op->op_data->urd_fh->fd;
+
+    if (FBTL_URING_READ == op->op_data->urd_req_type) {
+        io_uring_prep_readv(sqe, fd, op->op_iov, op->op_iovcnt, op->op_offset);
+    } else {
+        io_uring_prep_writev(sqe, fd, op->op_iov, op->op_iovcnt, op->op_offset);
+    }
+    if (ufile->ring_fixed) {
+        io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+    }
+    io_uring_sqe_set_data(sqe, op);
+    op->op_sqe = sqe;
+}
+
+/* hand the queued SQEs to the kernel. SQEs that could not be submitted
+ * because of a transient condition stay queued for the next call. */
+static int mca_fbtl_uring_flush (mca_fbtl_uring_file_t *ufile)
+{
+    int ret;
+
+    do {
+        ret = io_uring_submit(&ufile->ring);
+    } while (-EINTR == ret);
+
+    if (0 > ret && -EAGAIN != ret && -EBUSY != ret) {
+        opal_output(1, "mca_fbtl_uring: error in io_uring_submit(): %s", strerror(-ret));
+        return OMPI_ERROR;
+    }
+
+    return OMPI_SUCCESS;
+}
+
+static void mca_fbtl_uring_op_error (mca_fbtl_uring_op_t *op, int error)
+{
+    if (0 == op->op_data->urd_error) {
+        op->op_data->urd_error = error;
+    }
+    op->op_data->urd_open_ops--;
+}
+
+static void mca_fbtl_uring_resubmit (mca_fbtl_uring_file_t *ufile, mca_fbtl_uring_op_t *op)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&ufile->ring);
+
+    if (NULL == sqe) {
+        (void) mca_fbtl_uring_flush(ufile);
+        sqe = io_uring_get_sqe(&ufile->ring);
+        if (NULL == sqe) {
+            mca_fbtl_uring_op_error(op, -EBUSY);
+            return;
+        }
+    }
+    mca_fbtl_uring_prep(ufile, sqe, op);
+    ufile->inflight++;
+    (void) mca_fbtl_uring_flush(ufile);
+}
+
+static void mca_fbtl_uring_complete (mca_fbtl_uring_file_t *ufile, mca_fbtl_uring_op_t *op, int res)
+{
+    size_t done;
+
+    if (-EAGAIN == res || -EINTR == res) {
+        mca_fbtl_uring_resubmit(ufile, op);
+        return;
+    }
+    if (0 > res) {
+        mca_fbtl_uring_op_error(op, res);
+        return;
+    }
+    if (0 == res && FBTL_URING_WRITE == op->op_data->urd_req_type && 0 < op->op_length) {
+        mca_fbtl_uring_op_error(op, -EIO);
+        return;
+    }
+
+    op->op_data->urd_total_len += res;
+
+    /* a short transfer resubmits the remainder; a read that returns 0 hit
+     * the end of the file and completes the operation */
+    if (0 < res && (size_t) res < op->op_length) {
+        done = (size_t) res;
+        op->op_offset += res;
+        op->op_length -= res;
+        while (done >= op->op_iov->iov_len) {
+            done -= op->op_iov->iov_len;
+            op->op_iov++;
+            op->op_iovcnt--;
+        }
+        op->op_iov->iov_base = (char *) op->op_iov->iov_base + done;
+        op->op_iov->iov_len -= done;
+        mca_fbtl_uring_resubmit(ufile, op);
+        return;
+    }
+
+    op->op_data->urd_open_ops--;
+}
+
+int mca_fbtl_uring_submit (mca_fbtl_uring_request_data_t *data)
+{
+    mca_fbtl_uring_file_t *ufile = (mca_fbtl_uring_file_t *) data->urd_fh->f_fbtl_data;
+    struct io_uring_sqe *sqe;
+    int queued = 0, ret, i;
+
+    OPAL_THREAD_LOCK(&ufile->lock);
+    /* all the ops that fit in the queue go to the kernel in one system call */
+    while (0 == data->urd_error && data->urd_next_op < data->urd_op_count &&
+           ufile->inflight < mca_fbtl_uring_queue_depth) {
+        sqe = io_uring_get_sqe(&ufile->ring);
+        if (NULL == sqe) {
+            break;
+        }
+        mca_fbtl_uring_prep(ufile, sqe, data->urd_ops + data->urd_next_op);
+        data->urd_next_op++;
+        ufile->inflight++;
+        queued++;
+    }
+
+    ret = OMPI_SUCCESS;
+    if (0 < queued) {
+        ret = mca_fbtl_uring_flush(ufile);
+        if (OMPI_SUCCESS != ret) {
+            /* the SQEs are still in the ring and a later submit on this file
+             * hands them to the kernel, after the caller released the ops.
+             * Turn them into NOPs that reap drops, and fail the ops. */
+            for (i = data->urd_next_op - queued; i < data->urd_next_op; i++) {
+                io_uring_prep_nop(data->urd_ops[i].op_sqe);
+                io_uring_sqe_set_flags(data->urd_ops[i].op_sqe, 0);
+                io_uring_sqe_set_data(data->urd_ops[i].op_sqe, NULL);
+            }
+            data->urd_open_ops -= queued;
+            data->urd_error = -EIO;
+        }
+    }
+    OPAL_THREAD_UNLOCK(&ufile->lock);
+
+    return ret;
+}
+
+int mca_fbtl_uring_reap (ompio_file_t *fh, bool wait)
+{
+    mca_fbtl_uring_file_t *ufile = (mca_fbtl_uring_file_t *) fh->f_fbtl_data;
+    struct io_uring_cqe *cqe;
+    mca_fbtl_uring_op_t *op;
+    int count = 0, ret, res;
+
+    if (NULL == ufile) {
+        return 0;
+    }
+
+    OPAL_THREAD_LOCK(&ufile->lock);
+    if (0 < io_uring_sq_ready(&ufile->ring)) {
+        (void) mca_fbtl_uring_flush(ufile);
+    }
+
+    /* completions of all the requests on this file are dispatched here */
+    while (0 < ufile->inflight) {
+        if (wait && 0 == count) {
+            ret = io_uring_wait_cqe(&ufile->ring, &cqe);
+        } else {
+            ret = io_uring_peek_cqe(&ufile->ring, &cqe);
+        }
+        if (-EINTR == ret) {
+            continue;
+        }
+        if (0 > ret) {
+            if (-EAGAIN != ret) {
+                opal_output(1, "mca_fbtl_uring: error in io_uring_wait_cqe(): %s", strerror(-ret));
+                count = OMPI_ERROR;
+            }
+            break;
+        }
+
+        op = (mca_fbtl_uring_op_t *) io_uring_cqe_get_data(cqe);
+        res = cqe->res;
+        io_uring_cqe_seen(&ufile->ring, cqe);
+        ufile->inflight--;
+        count++;
+
+        /* NOP left behind by a failed submit */
+        if (NULL == op) {
+            continue;
+        }
+        mca_fbtl_uring_complete(ufile, op, res);
+    }
+    OPAL_THREAD_UNLOCK(&ufile->lock);
+
+    return count;
+}
+
+bool mca_fbtl_uring_request_test (mca_fbtl_uring_request_data_t *data)
+{
+    /* ops still in the kernel */
+    if (data->urd_open_ops != data->urd_op_count - data->urd_next_op) {
+        return false;
+    }
+
+    /* nothing left to submit, or no point in doing so */
+    return 0 != data->urd_error || data->urd_next_op == data->urd_op_count;
+}
+
+bool mca_fbtl_uring_progress (mca_ompio_request_t *req)
+{
+    mca_fbtl_uring_request_data_t *data = (mca_fbtl_uring_request_data_t *) req->req_data;
+
+    (void) mca_fbtl_uring_reap(data->urd_fh, false);
+    (void) mca_fbtl_uring_submit(data);
+
+    if (!mca_fbtl_uring_request_test(data)) {
+        return false;
+    }
+
+    /* all pending operations are finished for this request */
+    req->req_ompi.req_status.MPI_ERROR = (0 == data->urd_error) ? OMPI_SUCCESS : OMPI_ERROR;
+    req->req_ompi.req_status._ucount = data->urd_total_len;
+    mca_fbtl_uring_unlock(data);
+
+    return true;
+}
+
+void mca_fbtl_uring_request_free (mca_ompio_request_t *req)
+{
+    /* Free the fbtl specific data structures */
+    mca_fbtl_uring_request_data_t *data = (mca_fbtl_uring_request_data_t *) req->req_data;
+
+    if (NULL != data) {
+        mca_fbtl_uring_request_data_release(data);
+        req->req_data = NULL;
+    }
+}
+
+static bool mca_fbtl_uring_check_atomicity (ompio_file_t *file)
+{
+    struct flock lock;
+
+    /* atomicity is provided through fcntl locks, as in the posix fbtl */
+    lock.l_type   = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start  = 0;
+    lock.l_len    = 0;
+    lock.l_pid    = 0;
+
+    return 0 == fcntl(file->fd, F_GETLK, &lock);
+}
@@ -0,0 +1,118 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#ifndef MCA_FBTL_URING_H
+#define MCA_FBTL_URING_H
+
+#include "ompi_config.h"
+
+#include <fcntl.h>
+#include <liburing.h>
+
+#include "opal/mca/threads/mutex.h"
+#include "ompi/mca/mca.h"
+#include "ompi/mca/fbtl/fbtl.h"
+#include "ompi/mca/common/ompio/common_ompio.h"
+#include "ompi/mca/common/ompio/common_ompio_request.h"
+
+extern int mca_fbtl_uring_priority;
+extern int mca_fbtl_uring_queue_depth;
+extern int mca_fbtl_uring_iov_max;
+extern bool mca_fbtl_uring_fixed_files;
+
+#define FBTL_URING_BASE_PRIORITY 5
+#define FBTL_URING_QUEUE_DEPTH   128
+#define FBTL_URING_IOV_MAX       1024
+
+BEGIN_C_DECLS
+
+int mca_fbtl_uring_component_init_query(bool enable_progress_threads,
+                                        bool enable_mpi_threads);
+struct mca_fbtl_base_module_1_0_0_t *
+mca_fbtl_uring_component_file_query (ompio_file_t *file, int *priority);
+int mca_fbtl_uring_component_file_unquery (ompio_file_t *file);
+
+int mca_fbtl_uring_module_init (ompio_file_t *file);
+int mca_fbtl_uring_module_finalize (ompio_file_t *file);
+
+OMPI_DECLSPEC extern mca_fbtl_base_component_2_0_0_t mca_fbtl_uring_component;
+/*
+ * ******************************************************************
+ * ********* functions which are implemented in this module *********
+ * ******************************************************************
+ */
+
+ssize_t mca_fbtl_uring_preadv (ompio_file_t *file );
+ssize_t mca_fbtl_uring_pwritev (ompio_file_t *file );
+ssize_t mca_fbtl_uring_ipreadv (ompio_file_t *file,
+                                ompi_request_t *request);
+ssize_t mca_fbtl_uring_ipwritev (ompio_file_t *file,
+                                 ompi_request_t *request);
+
+bool mca_fbtl_uring_progress     (mca_ompio_request_t *req);
+void mca_fbtl_uring_request_free (mca_ompio_request_t *req);
+
+/* Per-file state, hung off ompio_file_t::f_fbtl_data. The ring is created
+ * on first use since the file is not open yet when the module is selected. */
+struct mca_fbtl_uring_file_t {
+    struct io_uring ring;
+    opal_mutex_t    lock;           /* serializes submission and completion */
+    int             ring_fd;        /* file descriptor the ring was set up for */
+    bool            ring_fixed;     /* ring_fd is registered as fixed file 0 */
+    int             inflight;       /* SQEs queued and not reaped yet */
+};
+typedef struct mca_fbtl_uring_file_t mca_fbtl_uring_file_t;
+
+struct mca_fbtl_uring_request_data_t;
+
+/* One readv/writev SQE: a run of io entries that are contiguous in the file */
+struct mca_fbtl_uring_op_t {
+    struct mca_fbtl_uring_request_data_t *op_data;  /* request this op belongs to */
+    struct iovec  *op_iov;          /* first iovec not completed yet */
+    int            op_iovcnt;
+    off_t          op_offset;
+    size_t         op_length;       /* bytes not completed yet */
+    struct io_uring_sqe *op_sqe;    /* SQE last prepared for this op */
+};
+typedef struct mca_fbtl_uring_op_t mca_fbtl_uring_op_t;
+
+struct mca_fbtl_uring_request_data_t {
+    int                    urd_req_type;    /* read or write */
+    int                    urd_op_count;    /* total number of ops */
+    int                    urd_next_op;     /* first op not submitted yet */
+    int                    urd_open_ops;    /* ops not completed yet */
+    int                    urd_error;       /* first error, as a negative errno */
+    ssize_t                urd_total_len;   /* total amount of data read/written */
+    mca_fbtl_uring_op_t   *urd_ops;
+    struct iovec          *urd_iovecs;      /* copied from the file handle */
+    struct flock           urd_lock;
+    bool                   urd_locked;
+    ompio_file_t          *urd_fh;
+};
+typedef struct mca_fbtl_uring_request_data_t mca_fbtl_uring_request_data_t;
+
+/* define constants for read/write operations */
+#define FBTL_URING_READ  1
+#define FBTL_URING_WRITE 2
+
+int mca_fbtl_uring_request_data_create (ompio_file_t *fh, int io_op,
+                                        mca_fbtl_uring_request_data_t **data);
+void mca_fbtl_uring_request_data_release (mca_fbtl_uring_request_data_t *data);
+bool mca_fbtl_uring_request_test (mca_fbtl_uring_request_data_t *data);
+int mca_fbtl_uring_submit (mca_fbtl_uring_request_data_t *data);
+int mca_fbtl_uring_reap (ompio_file_t *fh, bool wait);
+
+/*
+ * ******************************************************************
+ * ************ functions implemented in this module end ************
+ * ******************************************************************
+ */
+
+END_C_DECLS
+
+#endif /* MCA_FBTL_URING_H */
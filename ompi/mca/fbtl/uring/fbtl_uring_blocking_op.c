@@ -0,0 +1,69 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+#include "fbtl_uring.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/mca/fbtl/fbtl.h"
+
+static ssize_t mca_fbtl_uring_blocking_op (ompio_file_t *fh, int io_op);
+
+ssize_t mca_fbtl_uring_preadv (ompio_file_t *fh)
+{
+    return mca_fbtl_uring_blocking_op(fh, FBTL_URING_READ);
+}
+
+ssize_t mca_fbtl_uring_pwritev (ompio_file_t *fh)
+{
+    return mca_fbtl_uring_blocking_op(fh, FBTL_URING_WRITE);
+}
+
+/* Even a blocking operation keeps up to queue_depth non-contiguous parts
+ * of the request in flight at once. */
+static ssize_t mca_fbtl_uring_blocking_op (ompio_file_t *fh, int io_op)
+{
+    mca_fbtl_uring_request_data_t *data;
+    ssize_t bytes_processed;
+    int ret;
+
+    if (NULL == fh->f_io_array) {
+        return OMPI_ERROR;
+    }
+
+    ret = mca_fbtl_uring_request_data_create(fh, io_op, &data);
+    if (OMPI_SUCCESS != ret) {
+        return ret;
+    }
+
+    (void) mca_fbtl_uring_submit(data);
+    while (!mca_fbtl_uring_request_test(data)) {
+        if (0 > mca_fbtl_uring_reap(fh, true)) {
+            /* the ring is broken, nothing in it will complete anymore */
+            data->urd_error = -EIO;
+            break;
+        }
+        (void) mca_fbtl_uring_submit(data);
+    }
+
+    if (0 != data->urd_error) {
+        opal_output(1, "mca_fbtl_uring_blocking_op: error in %s: %s",
+                    (FBTL_URING_READ == io_op) ? "readv" : "writev",
+                    strerror(-data->urd_error));
+        bytes_processed = OMPI_ERROR;
+    } else {
+        bytes_processed = data->urd_total_len;
+    }
+    mca_fbtl_uring_request_data_release(data);
+
+    return bytes_processed;
+}
@@ -0,0 +1,104 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ * These symbols are in a file by themselves to provide nice linker
+ * semantics.  Since linkers generally pull in symbols by object
+ * files, keeping these symbols as the only symbols in this file
+ * prevents utility programs such as "ompi_info" from having to import
+ * entire components just to query their version and parameters.
+ */
+
+#include "ompi_config.h"
+#include "fbtl_uring.h"
+#include "mpi.h"
+
+int mca_fbtl_uring_priority = FBTL_URING_BASE_PRIORITY;
+int mca_fbtl_uring_queue_depth = FBTL_URING_QUEUE_DEPTH;
+int mca_fbtl_uring_iov_max = FBTL_URING_IOV_MAX;
+bool mca_fbtl_uring_fixed_files = true;
+
+/*
+ * Private functions
+ */
+static int register_component(void);
+
+/*
+ * Public string showing the fbtl uring component version number
+ */
+const char *mca_fbtl_uring_component_version_string =
+  "OMPI/MPI io_uring FBTL MCA component version " OMPI_VERSION;
+
+
+/*
+ * Instantiate the public struct with all of our public information
+ * and pointers to our public functions in it
+ */
+mca_fbtl_base_component_2_0_0_t mca_fbtl_uring_component = {
+
+    /* First, the mca_component_t struct containing meta information
+       about the component itself */
+
+    .fbtlm_version = {
+        MCA_FBTL_BASE_VERSION_2_0_0,
+
+        /* Component name and version */
+        .mca_component_name = "uring",
+        MCA_BASE_MAKE_VERSION(component, OMPI_MAJOR_VERSION, OMPI_MINOR_VERSION,
+                              OMPI_RELEASE_VERSION),
+        .mca_register_component_params = register_component,
+    },
+    .fbtlm_data = {
+        /* This component is checkpointable */
+      MCA_BASE_METADATA_PARAM_CHECKPOINT
+    },
+    .fbtlm_init_query = mca_fbtl_uring_component_init_query,      /* get thread level */
+    .fbtlm_file_query = mca_fbtl_uring_component_file_query,      /* get priority and actions */
+    .fbtlm_file_unquery = mca_fbtl_uring_component_file_unquery,  /* undo what was done by previous function */
+};
+MCA_BASE_COMPONENT_INIT(ompi, fbtl, uring)
+
+static int register_component(void)
+{
+    mca_fbtl_uring_priority = FBTL_URING_BASE_PRIORITY;
+    (void) mca_base_component_var_register(&mca_fbtl_uring_component.fbtlm_version,
+                                           "priority", "Priority of the fbtl uring component. "
+                                           "It is below the one of the posix component by default.",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_fbtl_uring_priority);
+
+    mca_fbtl_uring_queue_depth = FBTL_URING_QUEUE_DEPTH;
+    (void) mca_base_component_var_register(&mca_fbtl_uring_component.fbtlm_version,
+                                           "queue_depth", "Number of entries of the submission queue of "
+                                           "each file, i.e. the maximum number of read/write operations "
+                                           "in flight per file. Default: 128.",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_fbtl_uring_queue_depth);
+
+    mca_fbtl_uring_iov_max = FBTL_URING_IOV_MAX;
+    (void) mca_base_component_var_register(&mca_fbtl_uring_component.fbtlm_version,
+                                           "iov_max", "Maximum number of contiguous io entries that are "
+                                           "aggregated into one vectored read/write operation. Default: 1024.",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_fbtl_uring_iov_max);
+
+    mca_fbtl_uring_fixed_files = true;
+    (void) mca_base_component_var_register(&mca_fbtl_uring_component.fbtlm_version,
+                                           "fixed_files", "Register the file descriptor with the ring, "
+                                           "avoiding a file table lookup per operation. Default: true.",
+                                           MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_fbtl_uring_fixed_files);
+
+    return OMPI_SUCCESS;
+}
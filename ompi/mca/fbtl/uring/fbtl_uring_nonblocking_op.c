@@ -0,0 +1,56 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+#include "fbtl_uring.h"
+
+#include "mpi.h"
+#include "ompi/constants.h"
+#include "ompi/mca/fbtl/fbtl.h"
+
+static ssize_t mca_fbtl_uring_nonblocking_op (ompio_file_t *fh,
+                                              ompi_request_t *request, int io_op);
+
+ssize_t mca_fbtl_uring_ipreadv (ompio_file_t *fh, ompi_request_t *request)
+{
+    return mca_fbtl_uring_nonblocking_op(fh, request, FBTL_URING_READ);
+}
+
+ssize_t mca_fbtl_uring_ipwritev (ompio_file_t *fh, ompi_request_t *request)
+{
+    return mca_fbtl_uring_nonblocking_op(fh, request, FBTL_URING_WRITE);
+}
+
+static ssize_t mca_fbtl_uring_nonblocking_op (ompio_file_t *fh,
+                                              ompi_request_t *request, int io_op)
+{
+    mca_ompio_request_t *req = (mca_ompio_request_t *) request;
+    mca_fbtl_uring_request_data_t *data;
+    int ret;
+
+    ret = mca_fbtl_uring_request_data_create(fh, io_op, &data);
+    if (OMPI_SUCCESS != ret) {
+        opal_output(1, "mca_fbtl_uring_nonblocking_op: could not set up the request");
+        return ret;
+    }
+
+    /* Start as many operations as the ring takes, the remaining ones
+     * are submitted from the progress function as earlier ones complete. */
+    ret = mca_fbtl_uring_submit(data);
+    if (OMPI_SUCCESS != ret && mca_fbtl_uring_request_test(data)) {
+        mca_fbtl_uring_request_data_release(data);
+        return ret;
+    }
+
+    req->req_data = data;
+    req->req_progress_fn = mca_fbtl_uring_progress;
+    req->req_free_fn     = mca_fbtl_uring_request_free;
+    mca_common_ompio_register_progress();
+
+    return OMPI_SUCCESS;
+}
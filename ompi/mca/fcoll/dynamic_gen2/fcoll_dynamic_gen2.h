@@ -41,6 +41,8 @@ BEGIN_C_DECLS
 
 extern int mca_fcoll_dynamic_gen2_priority;
 extern int mca_fcoll_dynamic_gen2_num_groups;
+extern int mca_fcoll_dynamic_gen2_pipeline_depth;
+extern int mca_fcoll_dynamic_gen2_async_io;
 
 OMPI_DECLSPEC extern mca_fcoll_base_component_3_0_0_t mca_fcoll_dynamic_gen2_component;
 
@@ -44,6 +44,8 @@ const char *mca_fcoll_dynamic_gen2_component_version_string =
  */
 int mca_fcoll_dynamic_gen2_priority = 10;
 int mca_fcoll_dynamic_gen2_num_groups = 1;
+int mca_fcoll_dynamic_gen2_pipeline_depth = 2;
+int mca_fcoll_dynamic_gen2_async_io = 0;
 
 /*
  * Local function
@@ -97,5 +99,24 @@ dynamic_gen2_register(void)
                                            OPAL_INFO_LVL_9,
                                            MCA_BASE_VAR_SCOPE_READONLY, &mca_fcoll_dynamic_gen2_num_groups);
 
+    mca_fcoll_dynamic_gen2_pipeline_depth = 2;
+    (void) mca_base_component_var_register(&mca_fcoll_dynamic_gen2_component.fcollm_version,
+                                           "pipeline_depth", "Number of cycles of a collective write that are in flight "
+                                           "at the same time. Each aggregator uses a ring of this many buffers of "
+                                           "1/pipeline_depth of the bytes_per_agg value. 2 (default) overlaps the shuffle "
+                                           "of the next cycle with the write of the current one.",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &mca_fcoll_dynamic_gen2_pipeline_depth);
+
+    mca_fcoll_dynamic_gen2_async_io = 0;
+    (void) mca_base_component_var_register(&mca_fcoll_dynamic_gen2_component.fcollm_version,
+                                           "async_io", "Asynchronous I/O support options. 0: Automatic choice (default), "
+                                           "asynchronous if pipeline_depth is larger than 2. "
+                                           "1: Asynchronous I/O only. 2: Synchronous I/O only.",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &mca_fcoll_dynamic_gen2_async_io);
+
     return OMPI_SUCCESS;
 }
@@ -33,6 +33,7 @@
 #include "ompi/mca/fcoll/base/fcoll_base_coll_array.h"
 #include "ompi/mca/common/ompio/common_ompio.h"
 #include "ompi/mca/io/io.h"
+#include "ompi/mca/common/ompio/common_ompio_request.h"
 #include "math.h"
 #include "ompi/mca/pml/pml.h"
 #include <unistd.h>
@@ -47,6 +48,16 @@ typedef struct mca_io_ompio_local_io_array{
     int                  process_id;
 }mca_io_ompio_local_io_array;
 
+/* State of one slot in the ring of cycles that are in flight at an aggregator */
+typedef struct mca_io_ompio_cycle_data {
+    char *global_buf;
+    ompi_datatype_t **recvtype;
+    mca_common_ompio_io_array_t *io_array;
+    int num_io_entries;
+    int bytes_to_write;
+    ompi_request_t *write_req;
+} mca_io_ompio_cycle_data;
+
 typedef struct mca_io_ompio_aggregator_data {
     int *disp_index, *sorted, n;
     size_t *fview_count;
@@ -54,47 +65,25 @@ typedef struct mca_io_ompio_aggregator_data {
     int **blocklen_per_process;
     MPI_Aint **displs_per_process, total_bytes, bytes_per_cycle, total_bytes_written;
     MPI_Comm comm;
-    char *buf, *global_buf, *prev_global_buf;
-    ompi_datatype_t **recvtype, **prev_recvtype;
+    char *buf;
+    mca_io_ompio_cycle_data *cycle_data;
     struct iovec *global_iov_array;
     int current_index, current_position;
     int bytes_to_write_in_cycle, bytes_remaining, procs_per_group;    
     int *procs_in_group, iov_index;
-    int bytes_sent, prev_bytes_sent;
+    int bytes_sent;
     struct iovec *decoded_iov;
-    int bytes_to_write, prev_bytes_to_write;
-    mca_common_ompio_io_array_t *io_array, *prev_io_array;
-    int num_io_entries, prev_num_io_entries;
 } mca_io_ompio_aggregator_data;
 
 
-#define SWAP_REQUESTS(_r1,_r2) { \
-    ompi_request_t **_t=_r1;     \
-    _r1=_r2;                     \
-    _r2=_t;}
-
-#define SWAP_AGGR_POINTERS(_aggr,_num) {                        \
-    int _i;                                                     \
-    char *_t;                                                   \
-    for (_i=0; _i<_num; _i++ ) {                                \
-        _aggr[_i]->prev_io_array=_aggr[_i]->io_array;             \
-        _aggr[_i]->prev_num_io_entries=_aggr[_i]->num_io_entries; \
-        _aggr[_i]->prev_bytes_sent=_aggr[_i]->bytes_sent;         \
-        _aggr[_i]->prev_bytes_to_write=_aggr[_i]->bytes_to_write; \
-        _t=_aggr[_i]->prev_global_buf;                            \
-        _aggr[_i]->prev_global_buf=_aggr[_i]->global_buf;         \
-        _aggr[_i]->global_buf=_t;                                 \
-        _t=(char *)_aggr[_i]->recvtype;                           \
-        _aggr[_i]->recvtype=_aggr[_i]->prev_recvtype;             \
-        _aggr[_i]->prev_recvtype=(ompi_datatype_t **)_t;          }                                                             \
-}
-
-
 
 static int shuffle_init ( int index, int cycles, int aggregator, int rank, 
                           mca_io_ompio_aggregator_data *data, 
+                          mca_io_ompio_cycle_data *cycle,
                           ompi_request_t **reqs );
-static int write_init (ompio_file_t *fh, int aggregator, mca_io_ompio_aggregator_data *aggr_data );
+static int write_init (ompio_file_t *fh, int aggregator, mca_io_ompio_cycle_data *cycle,
+                       bool async_io );
+static int write_wait (mca_io_ompio_cycle_data *cycle);
 
 int mca_fcoll_dynamic_gen2_break_file_view ( struct iovec *decoded_iov, int iov_count, 
                                         struct iovec *local_iov_array, int local_count, 
@@ -124,14 +113,15 @@ int mca_fcoll_dynamic_gen2_file_write_all (struct ompio_file_t *fh,
 {
     int index = 0;
     int cycles = 0;
-    int ret =0, l, i, j, bytes_per_cycle;
+    int ret =0, l, i, j, bytes_per_cycle, depth, slot;
+    bool async_io = false;
     uint32_t iov_count = 0;
     struct iovec *decoded_iov = NULL;
     struct iovec *local_iov_array=NULL;
     uint32_t total_fview_count = 0;
     int local_count = 0;
-    ompi_request_t **reqs1=NULL,**reqs2=NULL;
-    ompi_request_t **curr_reqs=NULL,**prev_reqs=NULL;
+    ompi_request_t **reqs=NULL;
+    int reqs_per_cycle;
     mca_io_ompio_aggregator_data **aggr_data=NULL;
     
     ptrdiff_t *displs = NULL;
@@ -164,9 +154,30 @@ int mca_fcoll_dynamic_gen2_file_write_all (struct ompio_file_t *fh,
      **************************************************************************/
     bytes_per_cycle = fh->f_bytes_per_agg;
 
-    /* since we want to overlap 2 iterations, define the bytes_per_cycle to be half of what
-       the user requested */
-    bytes_per_cycle =bytes_per_cycle/2;
+    /* since we want to overlap depth iterations, define the bytes_per_cycle to be
+       1/depth of what the user requested */
+    depth = mca_fcoll_dynamic_gen2_pipeline_depth;
+    if ( depth < 2 ) {
+        depth = 2;
+    }
+    /* a cycle holds at least one byte, whatever the depth asked for */
+    if ( depth > bytes_per_cycle && bytes_per_cycle >= 2 ) {
+        depth = bytes_per_cycle;
+    }
+    bytes_per_cycle = bytes_per_cycle/depth;
+    if ( bytes_per_cycle < 1 ) {
+        bytes_per_cycle = 1;
+    }
+
+    if ( (1 == mca_fcoll_dynamic_gen2_async_io) && (NULL == fh->f_fbtl->fbtl_ipwritev) ) {
+        opal_output (1, "dynamic_gen2_write_all: fbtl Does NOT support ipwritev() (asynchronous write) \n");
+        ret = MPI_ERR_UNSUPPORTED_OPERATION;
+        goto exit;
+    }
+    if ( (1 == mca_fcoll_dynamic_gen2_async_io) ||
+         ( (0 == mca_fcoll_dynamic_gen2_async_io) && (NULL != fh->f_fbtl->fbtl_ipwritev) && (2 < depth) ) ) {
+        async_io = true;
+    }
         
     ret =   mca_common_ompio_decode_datatype ((struct ompio_file_t *) fh,
                                               datatype,
@@ -522,27 +533,29 @@ int mca_fcoll_dynamic_gen2_file_write_all (struct ompio_file_t *fh,
                 goto exit;
             }
         
-            
-            aggr_data[i]->global_buf       = (char *) malloc (bytes_per_cycle);
-            aggr_data[i]->prev_global_buf  = (char *) malloc (bytes_per_cycle);
-            if (NULL == aggr_data[i]->global_buf || NULL == aggr_data[i]->prev_global_buf){
-                opal_output(1, "OUT OF MEMORY");
-                ret = OMPI_ERR_OUT_OF_RESOURCE;
-                goto exit;
-            }
-        
-            aggr_data[i]->recvtype = (ompi_datatype_t **) malloc (fh->f_procs_per_group  * 
-                                                                  sizeof(ompi_datatype_t *));
-            aggr_data[i]->prev_recvtype = (ompi_datatype_t **) malloc (fh->f_procs_per_group  * 
-                                                                       sizeof(ompi_datatype_t *));
-            if (NULL == aggr_data[i]->recvtype || NULL == aggr_data[i]->prev_recvtype) {
+
+            /* one receive buffer per cycle in flight */
+            aggr_data[i]->cycle_data = (mca_io_ompio_cycle_data *) calloc (depth, sizeof(mca_io_ompio_cycle_data));
+            if (NULL == aggr_data[i]->cycle_data) {
                 opal_output (1, "OUT OF MEMORY\n");
                 ret = OMPI_ERR_OUT_OF_RESOURCE;
                 goto exit;
             }
-            for(l=0;l<fh->f_procs_per_group;l++){
-                aggr_data[i]->recvtype[l]      = MPI_DATATYPE_NULL;
-                aggr_data[i]->prev_recvtype[l] = MPI_DATATYPE_NULL;
+            for ( slot=0; slot<depth; slot++ ) {
+                mca_io_ompio_cycle_data *cycle = &aggr_data[i]->cycle_data[slot];
+
+                cycle->write_req  = MPI_REQUEST_NULL;
+                cycle->global_buf = (char *) malloc (bytes_per_cycle);
+                cycle->recvtype   = (ompi_datatype_t **) malloc (fh->f_procs_per_group  * 
+                                                                 sizeof(ompi_datatype_t *));
+                if (NULL == cycle->global_buf || NULL == cycle->recvtype) {
+                    opal_output (1, "OUT OF MEMORY\n");
+                    ret = OMPI_ERR_OUT_OF_RESOURCE;
+                    goto exit;
+                }
+                for(l=0;l<fh->f_procs_per_group;l++){
+                    cycle->recvtype[l] = MPI_DATATYPE_NULL;
+                }
             }
         }
     
@@ -551,66 +564,105 @@ int mca_fcoll_dynamic_gen2_file_write_all (struct ompio_file_t *fh,
 #endif
     }    
 
-    reqs1 = (ompi_request_t **)malloc ((fh->f_procs_per_group + 1 )*dynamic_gen2_num_io_procs *sizeof(ompi_request_t *));
-    reqs2 = (ompi_request_t **)malloc ((fh->f_procs_per_group + 1 )*dynamic_gen2_num_io_procs *sizeof(ompi_request_t *));
-    if ( NULL == reqs1 || NULL == reqs2 ) {
+    /* The requests of cycle index are in
+    ** reqs[(index % depth) * reqs_per_cycle ... ((index % depth) + 1) * reqs_per_cycle - 1],
+    ** with fh->f_procs_per_group + 1 requests per aggregator. */
+    reqs_per_cycle = (fh->f_procs_per_group + 1) * dynamic_gen2_num_io_procs;
+    reqs = (ompi_request_t **)malloc (reqs_per_cycle * depth * sizeof(ompi_request_t *));
+    if ( NULL == reqs ) {
         opal_output (1, "OUT OF MEMORY\n");
         ret = OMPI_ERR_OUT_OF_RESOURCE;
         goto exit;
     }
-    for (l=0,i=0; i < dynamic_gen2_num_io_procs; i++ ) {
-        for ( j=0; j< (fh->f_procs_per_group+1); j++ ) {
-            reqs1[l] = MPI_REQUEST_NULL;
-            reqs2[l] = MPI_REQUEST_NULL;
-            l++;
-        }
+    for (l=0; l < reqs_per_cycle * depth; l++ ) {
+        reqs[l] = MPI_REQUEST_NULL;
     }
 
-    curr_reqs = reqs1;
-    prev_reqs = reqs2;
-    
-    /* Initialize communication for iteration 0 */
-    if ( cycles > 0 ) {
+    /* Initialize communication for the first depth-1 iterations */
+    for (index = 0; index < cycles && index < depth - 1; index++) {
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+        start_comm_time = MPI_Wtime();
+#endif
         for ( i=0; i<dynamic_gen2_num_io_procs; i++ ) {
-            ret = shuffle_init ( 0, cycles, aggregators[i], fh->f_rank, aggr_data[i], 
-                                 &curr_reqs[i*(fh->f_procs_per_group + 1)] );
+            ret = shuffle_init ( index, cycles, aggregators[i], fh->f_rank, aggr_data[i], 
+                                 (aggregators[i] == fh->f_rank) ? &aggr_data[i]->cycle_data[index] : NULL,
+                                 &reqs[index * reqs_per_cycle + i*(fh->f_procs_per_group + 1)] );
             if ( OMPI_SUCCESS != ret ) {
                 goto exit;
             }
         }
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+        end_comm_time = MPI_Wtime();
+        comm_time += (end_comm_time - start_comm_time);
+#endif
     }
 
+    for (index = 0; index < cycles; index++) {
+        int next = index + depth - 1;
 
-    for (index = 1; index < cycles; index++) {
-        SWAP_REQUESTS(curr_reqs,prev_reqs);
-        SWAP_AGGR_POINTERS(aggr_data,dynamic_gen2_num_io_procs); 
+        if ( next < cycles ) {
+            slot = next % depth;
 
-        /* Initialize communication for iteration i */
-        for ( i=0; i<dynamic_gen2_num_io_procs; i++ ) {
-            ret = shuffle_init ( index, cycles, aggregators[i], fh->f_rank, aggr_data[i], 
-                                 &curr_reqs[i*(fh->f_procs_per_group + 1)] );
-            if ( OMPI_SUCCESS != ret ) {
-                goto exit;
+            /* The buffer of this slot was last used by iteration index-1, its
+               write has to be finished before data of iteration next arrives */
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+            start_write_time = MPI_Wtime();
+#endif
+            for ( i=0; i<dynamic_gen2_num_io_procs; i++ ) {
+                if (aggregators[i] == fh->f_rank) {
+                    ret = write_wait (&aggr_data[i]->cycle_data[slot]);
+                    if (OMPI_SUCCESS != ret){
+                        goto exit;
+                    }
+                }
             }
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+            end_write_time = MPI_Wtime();
+            write_time += end_write_time - start_write_time;
+            start_comm_time = MPI_Wtime();
+#endif
+            /* Initialize communication for iteration next */
+            for ( i=0; i<dynamic_gen2_num_io_procs; i++ ) {
+                ret = shuffle_init ( next, cycles, aggregators[i], fh->f_rank, aggr_data[i], 
+                                     (aggregators[i] == fh->f_rank) ? &aggr_data[i]->cycle_data[slot] : NULL,
+                                     &reqs[slot * reqs_per_cycle + i*(fh->f_procs_per_group + 1)] );
+                if ( OMPI_SUCCESS != ret ) {
+                    goto exit;
+                }
+            }
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+            end_comm_time = MPI_Wtime();
+            comm_time += (end_comm_time - start_comm_time);
+#endif
         }
 
-        /* Finish communication for iteration i-1 */
-        ret = ompi_request_wait_all ( (fh->f_procs_per_group + 1 )*dynamic_gen2_num_io_procs, 
-                                      prev_reqs, MPI_STATUS_IGNORE);
+        /* Finish communication for iteration index */
+        slot = index % depth;
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+        start_comm_time = MPI_Wtime();
+#endif
+        ret = ompi_request_wait_all ( reqs_per_cycle, &reqs[slot * reqs_per_cycle],
+                                      MPI_STATUS_IGNORE);
         if (OMPI_SUCCESS != ret){
             goto exit;
         }
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+        end_comm_time = MPI_Wtime();
+        comm_time += (end_comm_time - start_comm_time);
+#endif
 
-        
-        /* Write data for iteration i-1 */
+        /* Write data for iteration index. With asynchronous I/O the write
+           proceeds while the following iterations are shuffled */
         for ( i=0; i<dynamic_gen2_num_io_procs; i++ ) {
 #if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
             start_write_time = MPI_Wtime();
 #endif
-            ret = write_init (fh, aggregators[i], aggr_data[i] );
-            if (OMPI_SUCCESS != ret){
-                goto exit;
-            }            
+            if (aggregators[i] == fh->f_rank) {
+                ret = write_init (fh, aggregators[i], &aggr_data[i]->cycle_data[slot], async_io );
+                if (OMPI_SUCCESS != ret){
+                    goto exit;
+                }
+            }
 #if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
             end_write_time = MPI_Wtime();
             write_time += end_write_time - start_write_time;
@@ -619,33 +671,24 @@ int mca_fcoll_dynamic_gen2_file_write_all (struct ompio_file_t *fh,
         
     } /* end  for (index = 0; index < cycles; index++) */
 
-
-    /* Finish communication for iteration i = cycles-1 */
-    if ( cycles > 0 ) {
-        SWAP_REQUESTS(curr_reqs,prev_reqs);
-        SWAP_AGGR_POINTERS(aggr_data,dynamic_gen2_num_io_procs); 
-        
-        ret = ompi_request_wait_all ( (fh->f_procs_per_group + 1 )*dynamic_gen2_num_io_procs, 
-                                      prev_reqs, MPI_STATUS_IGNORE);
-        if (OMPI_SUCCESS != ret){
-            goto exit;
-        }
-        
-        /* Write data for iteration i=cycles-1 */
-        for ( i=0; i<dynamic_gen2_num_io_procs; i++ ) {
+    /* Finish the writes which are still in flight */
 #if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
-            start_write_time = MPI_Wtime();
-#endif
-            ret = write_init (fh, aggregators[i], aggr_data[i] );
-            if (OMPI_SUCCESS != ret){
-                goto exit;
-            }                    
-#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
-            end_write_time = MPI_Wtime();
-            write_time += end_write_time - start_write_time;
+    start_write_time = MPI_Wtime();
 #endif
+    for ( i=0; i<dynamic_gen2_num_io_procs; i++ ) {
+        if (aggregators[i] == fh->f_rank) {
+            for ( slot=0; slot<depth; slot++ ) {
+                ret = write_wait (&aggr_data[i]->cycle_data[slot]);
+                if (OMPI_SUCCESS != ret){
+                    goto exit;
+                }
+            }
         }
     }
+#if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
+    end_write_time = MPI_Wtime();
+    write_time += end_write_time - start_write_time;
+#endif
 
         
 #if OMPIO_FCOLL_WANT_TIME_BREAKDOWN
@@ -673,24 +716,28 @@ exit :
         
         for ( i=0; i< dynamic_gen2_num_io_procs; i++ ) {            
             if (aggregators[i] == fh->f_rank) {
-                if (NULL != aggr_data[i]->recvtype){
-                    for (j =0; j< aggr_data[i]->procs_per_group; j++) {
-                        if ( MPI_DATATYPE_NULL != aggr_data[i]->recvtype[j] ) {
-                            ompi_datatype_destroy(&aggr_data[i]->recvtype[j]);
+                if (NULL != aggr_data[i]->cycle_data) {
+                    for ( slot=0; slot<depth; slot++ ) {
+                        mca_io_ompio_cycle_data *cycle = &aggr_data[i]->cycle_data[slot];
+
+                        /* a write might still access the buffer after an error */
+                        (void) write_wait (cycle);
+                        if (NULL != cycle->recvtype){
+                            for (j =0; j< aggr_data[i]->procs_per_group; j++) {
+                                if ( MPI_DATATYPE_NULL != cycle->recvtype[j] ) {
+                                    ompi_datatype_destroy(&cycle->recvtype[j]);
+                                }
+                            }
+                            free(cycle->recvtype);
                         }
-                        if ( MPI_DATATYPE_NULL != aggr_data[i]->prev_recvtype[j] ) {
-                            ompi_datatype_destroy(&aggr_data[i]->prev_recvtype[j]);
-                        }
-
+                        free (cycle->global_buf);
+                        free (cycle->io_array);
                     }
-                    free(aggr_data[i]->recvtype);
-                    free(aggr_data[i]->prev_recvtype);
+                    free (aggr_data[i]->cycle_data);
                 }
                 
                 free (aggr_data[i]->disp_index);
                 free (aggr_data[i]->max_disp_index);
-                free (aggr_data[i]->global_buf);
-                free (aggr_data[i]->prev_global_buf);
                 for(l=0;l<aggr_data[i]->procs_per_group;l++){
                     free (aggr_data[i]->blocklen_per_process[l]);
                     free (aggr_data[i]->displs_per_process[l]);
@@ -725,8 +772,7 @@ exit :
     free(fh->f_procs_in_group);
     fh->f_procs_in_group=NULL;
     fh->f_procs_per_group=0;
-    free(reqs1);
-    free(reqs2);
+    free(reqs);
     free(result_counts);
 
      
@@ -734,23 +780,88 @@ exit :
 }
 
 
-static int write_init (ompio_file_t *fh, int aggregator, mca_io_ompio_aggregator_data *aggr_data )
+static int write_init (ompio_file_t *fh, int aggregator, mca_io_ompio_cycle_data *cycle,
+                       bool async_io )
 {
     int ret=OMPI_SUCCESS;
     int last_array_pos=0;
     int last_pos=0;
+    mca_ompio_request_t *ompio_req = NULL;
         
 
-    if ( aggregator == fh->f_rank && aggr_data->prev_num_io_entries) {
+    if ( aggregator == fh->f_rank && cycle->num_io_entries) {
+        if ( async_io ) {
+            /* Split the entries at the stripe boundaries as for the blocking
+               writes below, but hand all of them to a single ipwritev. */
+            mca_common_ompio_io_array_t *split_array = NULL, *tmp;
+            int split_entries = 0;
+            ssize_t split_bytes;
+
+            while ( cycle->bytes_to_write > 0 ) {
+                split_bytes = mca_fcoll_dynamic_gen2_split_iov_array (fh, cycle->io_array,
+                                                                      cycle->num_io_entries,
+                                                                      &last_array_pos, &last_pos );
+                tmp = NULL;
+                if ( 0 < split_bytes ) {
+                    tmp = (mca_common_ompio_io_array_t *) realloc ( split_array,
+                                                                    (split_entries + fh->f_num_of_io_entries) *
+                                                                    sizeof(mca_common_ompio_io_array_t));
+                }
+                if ( NULL == tmp ) {
+                    opal_output (1, "dynamic_gen2_write_all: could not split the io array\n");
+                    free ( split_array );
+                    free ( fh->f_io_array );
+                    free ( cycle->io_array );
+                    cycle->io_array = NULL;
+                    ret = OMPI_ERR_OUT_OF_RESOURCE;
+                    goto exit;
+                }
+                split_array = tmp;
+                memcpy ( split_array + split_entries, fh->f_io_array,
+                         fh->f_num_of_io_entries * sizeof(mca_common_ompio_io_array_t));
+                split_entries += fh->f_num_of_io_entries;
+                cycle->bytes_to_write -= split_bytes;
+            }
+            free ( fh->f_io_array );
+
+            /* The fbtl keeps its own copy of the io array, the buffer of this
+               cycle must not be reused until the request completed though.
+               The request is completed from the ompio progress function. */
+            mca_common_ompio_register_progress ();
+            mca_common_ompio_request_alloc ( &ompio_req, MCA_OMPIO_REQUEST_WRITE );
+            fh->f_io_array = split_array;
+            fh->f_num_of_io_entries = split_entries;
+            fh->f_flags |= OMPIO_COLLECTIVE_OP;
+            ret = fh->f_fbtl->fbtl_ipwritev (fh, (ompi_request_t *) ompio_req);
+            fh->f_flags &= ~OMPIO_COLLECTIVE_OP;
+            free ( split_array );
+            if ( 0 > ret ) {
+                opal_output (1, "dynamic_gen2_write_all: fbtl_ipwritev failed\n");
+                ompio_req->req_ompi.req_status.MPI_ERROR = ret;
+                ompio_req->req_ompi.req_status._ucount = 0;
+                ompi_request_complete (&ompio_req->req_ompi, false);
+            }
+            else {
+                ret = OMPI_SUCCESS;
+            }
+            cycle->write_req = (ompi_request_t *) ompio_req;
+            free ( cycle->io_array );
+            cycle->io_array = NULL;
+            goto exit;
+        }
+
         fh->f_flags |= OMPIO_COLLECTIVE_OP;
-        while ( aggr_data->prev_bytes_to_write > 0 ) {
+        while ( cycle->bytes_to_write > 0 ) {
             ssize_t tret;
-            aggr_data->prev_bytes_to_write -= mca_fcoll_dynamic_gen2_split_iov_array (fh, aggr_data->prev_io_array, 
-                                                                                      aggr_data->prev_num_io_entries, 
-                                                                                      &last_array_pos, &last_pos );
+            cycle->bytes_to_write -= mca_fcoll_dynamic_gen2_split_iov_array (fh, cycle->io_array, 
+                                                                             cycle->num_io_entries, 
+                                                                             &last_array_pos, &last_pos );
             tret = fh->f_fbtl->fbtl_pwritev (fh);
             if ( 0 > tret ) {
-                free ( aggr_data->prev_io_array);
+                free ( fh->f_io_array );
+                free ( cycle->io_array);
+                cycle->io_array = NULL;
+                fh->f_flags &= ~OMPIO_COLLECTIVE_OP;            
                 opal_output (1, "dynamic_gen2_write_all: fbtl_pwritev failed\n");
                 ret = OMPI_ERROR;
                 goto exit;
@@ -773,7 +884,8 @@ static int write_init (ompio_file_t *fh, int aggregator, mca_io_ompio_aggregator
         }
         fh->f_flags &= ~OMPIO_COLLECTIVE_OP;            
         free ( fh->f_io_array );
-        free ( aggr_data->prev_io_array);
+        free ( cycle->io_array);
+        cycle->io_array = NULL;
     } 
 
 exit:
@@ -784,7 +896,20 @@ exit:
     return ret;
 }
 
-static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_io_ompio_aggregator_data *data, 
+static int write_wait (mca_io_ompio_cycle_data *cycle)
+{
+    int ret = OMPI_SUCCESS;
+
+    if ( MPI_REQUEST_NULL != cycle->write_req ) {
+        ret = ompi_request_wait (&cycle->write_req, MPI_STATUS_IGNORE);
+        cycle->write_req = MPI_REQUEST_NULL;
+    }
+
+    return ret;
+}
+
+static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_io_ompio_aggregator_data *data,
+                          mca_io_ompio_cycle_data *cycle,
                           ompi_request_t **reqs )
 {
     int bytes_sent = 0;
@@ -802,19 +927,21 @@ static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_i
     int* blocklength_proc=NULL;
     ptrdiff_t* displs_proc=NULL;
 
-    data->num_io_entries = 0;
     data->bytes_sent = 0;
-    data->io_array=NULL;
+    if (NULL != cycle) {
+        cycle->num_io_entries = 0;
+        cycle->io_array=NULL;
+    }
     /**********************************************************************
      ***  7a. Getting ready for next cycle: initializing and freeing buffers
      **********************************************************************/
     if (aggregator == rank) {
         
-        if (NULL != data->recvtype){
+        if (NULL != cycle->recvtype){
             for (i =0; i< data->procs_per_group; i++) {
-                if ( MPI_DATATYPE_NULL != data->recvtype[i] ) {
-                    ompi_datatype_destroy(&data->recvtype[i]);
-                    data->recvtype[i] = MPI_DATATYPE_NULL;
+                if ( MPI_DATATYPE_NULL != cycle->recvtype[i] ) {
+                    ompi_datatype_destroy(&cycle->recvtype[i]);
+                    cycle->recvtype[i] = MPI_DATATYPE_NULL;
                 }
             }
         }
@@ -852,7 +979,9 @@ static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_i
     else {
         data->bytes_to_write_in_cycle = 0;
     }
-    data->bytes_to_write = data->bytes_to_write_in_cycle;
+    if (NULL != cycle) {
+        cycle->bytes_to_write = data->bytes_to_write_in_cycle;
+    }
 
 #if DEBUG_ON
     if (aggregator == rank) {
@@ -1163,14 +1292,14 @@ static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_i
                                                   data->blocklen_per_process[i],
                                                   data->displs_per_process[i],
                                                   MPI_BYTE,
-                                                  &data->recvtype[i]);
-                    ompi_datatype_commit(&data->recvtype[i]);
-                    opal_datatype_type_size(&data->recvtype[i]->super, &datatype_size);
+                                                  &cycle->recvtype[i]);
+                    ompi_datatype_commit(&cycle->recvtype[i]);
+                    opal_datatype_type_size(&cycle->recvtype[i]->super, &datatype_size);
                     
                     if (datatype_size){
-                        ret = MCA_PML_CALL(irecv(data->global_buf,
+                        ret = MCA_PML_CALL(irecv(cycle->global_buf,
                                                  1,
-                                                 data->recvtype[i],
+                                                 cycle->recvtype[i],
                                                  data->procs_in_group[i],
                                                  FCOLL_DYNAMIC_GEN2_SHUFFLE_TAG+index,
                                                  data->comm,
@@ -1269,7 +1398,7 @@ static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_i
         printf("************Cycle: %d,  Aggregator: %d ***************\n",
                index+1,rank);
         for (i=0 ; i<global_count/4 ; i++)
-            printf (" RECV %d \n",((int *)data->global_buf)[i]);
+            printf (" RECV %d \n",((int *)cycle->global_buf)[i]);
     }
 #endif
     
@@ -1284,23 +1413,23 @@ static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_i
     if (aggregator == rank && entries_per_aggregator>0) {
         
         
-        data->io_array = (mca_common_ompio_io_array_t *) malloc
+        cycle->io_array = (mca_common_ompio_io_array_t *) malloc
             (entries_per_aggregator * sizeof (mca_common_ompio_io_array_t));
-        if (NULL == data->io_array) {
+        if (NULL == cycle->io_array) {
             opal_output(1, "OUT OF MEMORY\n");
             ret = OMPI_ERR_OUT_OF_RESOURCE;
             goto exit;
         }
         
-        data->num_io_entries = 0;
+        cycle->num_io_entries = 0;
         /*First entry for every aggregator*/
-        data->io_array[0].offset =
+        cycle->io_array[0].offset =
             (IOVBASE_TYPE *)(intptr_t)file_offsets_for_agg[sorted_file_offsets[0]].offset;
-        data->io_array[0].length =
+        cycle->io_array[0].length =
             file_offsets_for_agg[sorted_file_offsets[0]].length;
-        data->io_array[0].memory_address =
-            data->global_buf+memory_displacements[sorted_file_offsets[0]];
-        data->num_io_entries++;
+        cycle->io_array[0].memory_address =
+            cycle->global_buf+memory_displacements[sorted_file_offsets[0]];
+        cycle->num_io_entries++;
         
         for (i=1;i<entries_per_aggregator;i++){
             /* If the entries are contiguous merge them,
@@ -1308,17 +1437,17 @@ static int shuffle_init ( int index, int cycles, int aggregator, int rank, mca_i
             if (file_offsets_for_agg[sorted_file_offsets[i-1]].offset +
                 file_offsets_for_agg[sorted_file_offsets[i-1]].length ==
                 file_offsets_for_agg[sorted_file_offsets[i]].offset){
-                data->io_array[data->num_io_entries - 1].length +=
+                cycle->io_array[cycle->num_io_entries - 1].length +=
                     file_offsets_for_agg[sorted_file_offsets[i]].length;
             }
             else {
-                data->io_array[data->num_io_entries].offset =
+                cycle->io_array[cycle->num_io_entries].offset =
                     (IOVBASE_TYPE *)(intptr_t)file_offsets_for_agg[sorted_file_offsets[i]].offset;
-                data->io_array[data->num_io_entries].length =
+                cycle->io_array[cycle->num_io_entries].length =
                     file_offsets_for_agg[sorted_file_offsets[i]].length;
-                data->io_array[data->num_io_entries].memory_address =
-                    data->global_buf+memory_displacements[sorted_file_offsets[i]];
-                data->num_io_entries++;
+                cycle->io_array[cycle->num_io_entries].memory_address =
+                    cycle->global_buf+memory_displacements[sorted_file_offsets[i]];
+                cycle->num_io_entries++;
             }
             
         }
@@ -211,6 +211,29 @@ AC_DEFUN([MCA_ompi_op_avx_CONFIG],[
                               MCA_BUILD_OP_AVX2_FLAGS=""
                               AC_MSG_RESULT([no])])
                          CFLAGS="$op_avx_cflags_save"
+                        ])
+                  #
+                  # The short float kernels need the F16C conversions. They are optional, when
+                  # missing the AVX2 flavor leaves short float to the other components.
+                  #
+                  AS_IF([test $op_avx2_support -eq 1],
+                        [AC_MSG_CHECKING([for F16C support (with -mf16c)])
+                         op_avx_cflags_save="$CFLAGS"
+                         CFLAGS="$MCA_BUILD_OP_AVX2_FLAGS -mf16c $CFLAGS"
+                         AC_LINK_IFELSE(
+                             [AC_LANG_PROGRAM([[#include <immintrin.h>]],
+                                      [[
+#if !defined(__F16C__)
+#error "F16C detection macro not available"
+#endif
+    short A[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    __m256 vA = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)&A));
+    __m128i vB = _mm256_cvtps_ph(vA, _MM_FROUND_TO_NEAREST_INT)
+                                      ]])],
+                             [MCA_BUILD_OP_AVX2_FLAGS="$MCA_BUILD_OP_AVX2_FLAGS -mf16c"
+                              AC_MSG_RESULT([yes])],
+                             [AC_MSG_RESULT([no])])
+                         CFLAGS="$op_avx_cflags_save"
                         ])])
            #
            # What about early AVX support? The rest of the logic is slightly different as
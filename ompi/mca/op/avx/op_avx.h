@@ -21,6 +21,7 @@
 
 BEGIN_C_DECLS
 
+#define OMPI_OP_AVX_HAS_F16C_FLAG      0x00000400
 #define OMPI_OP_AVX_HAS_AVX512BW_FLAG  0x00000200
 #define OMPI_OP_AVX_HAS_AVX512F_FLAG   0x00000100
 #define OMPI_OP_AVX_HAS_AVX2_FLAG      0x00000020
@@ -1339,6 +1339,446 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
     // not defined - OP_AVX_FLOAT_FUNC_3(xor)
     // not defined - OP_AVX_DOUBLE_FUNC_3(xor)
 
+/*************************************************************************
+ * Short float (IEEE binary16): max, min and sum
+ *
+ * The values are widened to single precision, combined and rounded back
+ * to nearest. Single precision is wide enough for a single add, min or
+ * max to round exactly like the native half precision operation.
+ *************************************************************************/
+#if defined(HAVE_SHORT_FLOAT) && (2 == SIZEOF_SHORT_FLOAT)
+typedef short float ompi_op_avx_short_float_t;
+#  define OP_AVX_HAVE_SHORT_FLOAT 1
+#elif defined(HAVE_OPAL_SHORT_FLOAT_T) && (2 == SIZEOF_OPAL_SHORT_FLOAT_T)
+typedef opal_short_float_t ompi_op_avx_short_float_t;
+#  define OP_AVX_HAVE_SHORT_FLOAT 1
+#else
+#  define OP_AVX_HAVE_SHORT_FLOAT 0
+#endif
+
+#if OP_AVX_HAVE_SHORT_FLOAT && (defined(GENERATE_AVX512_CODE) || (defined(GENERATE_AVX2_CODE) && defined(__F16C__)))
+#  define OP_AVX_GENERATE_SHORT_FLOAT 1
+#else
+#  define OP_AVX_GENERATE_SHORT_FLOAT 0
+#endif
+
+#if defined(GENERATE_AVX512_CODE) && defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512)
+#if __AVX512F__
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC(op)                              \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(float);                     \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512 vecA = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)in)); \
+            in += types_per_step;                                       \
+            __m512 vecB = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)out)); \
+            __m512 res = _mm512_##op##_ps(vecB, vecA);                  \
+            _mm256_storeu_si256((__m256i*)out,                          \
+                                _mm512_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#error Target architecture lacks AVX512F support needed for _mm512_cvtph_ps and _mm512_cvtps_ph
+#endif  /* __AVX512F__ */
+#else
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512) */
+
+#if defined(GENERATE_AVX2_CODE) && defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__)
+#define OP_AVX_AVX2_SHORT_FLOAT_FUNC(op)                                \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_F16C_FLAG | OMPI_OP_AVX_HAS_AVX_FLAG) ) { \
+        types_per_step = (256 / 8) / sizeof(float);                     \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256 vecA = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)in)); \
+            in += types_per_step;                                       \
+            __m256 vecB = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)out)); \
+            __m256 res = _mm256_##op##_ps(vecB, vecA);                  \
+            _mm_storeu_si128((__m128i*)out,                             \
+                             _mm256_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX2_SHORT_FLOAT_FUNC(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__) */
+
+#define OP_AVX_SHORT_FLOAT_FUNC(op)                                     \
+static void OP_CONCAT(ompi_op_avx_2buff_##op##_short_float, PREPEND)(const void *_in, void *_out, int *count, \
+                                                                   struct ompi_datatype_t **dtype, \
+                                                                   struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    ompi_op_avx_short_float_t *in = (ompi_op_avx_short_float_t*)_in,    \
+        *out = (ompi_op_avx_short_float_t*)_out;                        \
+    OP_AVX_AVX512_SHORT_FLOAT_FUNC(op);                                 \
+    OP_AVX_AVX2_SHORT_FLOAT_FUNC(op);                                   \
+    for (; left_over > 0; left_over--, ++in, ++out) {                   \
+        *out = current_func(*out, *in);                                 \
+    }                                                                   \
+}
+
+#if defined(GENERATE_AVX512_CODE) && defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512)
+#if __AVX512F__
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC_3(op)                            \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(float);                     \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512 vecA = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)in1)); \
+            __m512 vecB = _mm512_cvtph_ps(_mm256_loadu_si256((__m256i*)in2)); \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            __m512 res = _mm512_##op##_ps(vecA, vecB);                  \
+            _mm256_storeu_si256((__m256i*)out,                          \
+                                _mm512_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#error Target architecture lacks AVX512F support needed for _mm512_cvtph_ps and _mm512_cvtps_ph
+#endif  /* __AVX512F__ */
+#else
+#define OP_AVX_AVX512_SHORT_FLOAT_FUNC_3(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512) */
+
+#if defined(GENERATE_AVX2_CODE) && defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__)
+#define OP_AVX_AVX2_SHORT_FLOAT_FUNC_3(op)                              \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_F16C_FLAG | OMPI_OP_AVX_HAS_AVX_FLAG) ) { \
+        types_per_step = (256 / 8) / sizeof(float);                     \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256 vecA = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)in1)); \
+            __m256 vecB = _mm256_cvtph_ps(_mm_loadu_si128((__m128i*)in2)); \
+            in1 += types_per_step;                                      \
+            in2 += types_per_step;                                      \
+            __m256 res = _mm256_##op##_ps(vecA, vecB);                  \
+            _mm_storeu_si128((__m128i*)out,                             \
+                             _mm256_cvtps_ph(res, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)); \
+            out += types_per_step;                                      \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#define OP_AVX_AVX2_SHORT_FLOAT_FUNC_3(op) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) && defined(__F16C__) */
+
+#define OP_AVX_SHORT_FLOAT_FUNC_3(op)                                   \
+static void OP_CONCAT(ompi_op_avx_3buff_##op##_short_float, PREPEND)(const void *_in1, const void *_in2, void *_out, int *count, \
+                                                                   struct ompi_datatype_t **dtype, \
+                                                                   struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    ompi_op_avx_short_float_t *in1 = (ompi_op_avx_short_float_t*)_in1, \
+        *in2 = (ompi_op_avx_short_float_t*)_in2,                        \
+        *out = (ompi_op_avx_short_float_t*)_out;                        \
+    OP_AVX_AVX512_SHORT_FLOAT_FUNC_3(op);                               \
+    OP_AVX_AVX2_SHORT_FLOAT_FUNC_3(op);                                 \
+    for (; left_over > 0; left_over--, ++in1, ++in2, ++out) {           \
+        *out = current_func(*in1, *in2);                                \
+    }                                                                   \
+}
+
+#if OP_AVX_GENERATE_SHORT_FLOAT
+#undef current_func
+#define current_func(a, b) ((a) > (b) ? (a) : (b))
+    OP_AVX_SHORT_FLOAT_FUNC(max)
+    OP_AVX_SHORT_FLOAT_FUNC_3(max)
+#undef current_func
+#define current_func(a, b) ((a) < (b) ? (a) : (b))
+    OP_AVX_SHORT_FLOAT_FUNC(min)
+    OP_AVX_SHORT_FLOAT_FUNC_3(min)
+#undef current_func
+#define current_func(a, b) ((a) + (b))
+    OP_AVX_SHORT_FLOAT_FUNC(add)
+    OP_AVX_SHORT_FLOAT_FUNC_3(add)
+#endif  /* OP_AVX_GENERATE_SHORT_FLOAT */
+
+/*************************************************************************
+ * Maxloc and minloc on the C pair types
+ *
+ * A vector holds whole (value, index) pairs. The value and the index
+ * lanes are compared separately and the results are merged into a single
+ * blend mask, so ties on the value keep the smallest index exactly like
+ * the op/base implementation. Pairs of 8 bytes (2int, float_int,
+ * short_int) and of 16 bytes (double_int, long_int) are handled.
+ *************************************************************************/
+#if defined(GENERATE_AVX2_CODE)
+#  define OP_AVX_GENERATE_LOC 1
+#else
+#  define OP_AVX_GENERATE_LOC 0
+#endif
+
+#if (8 == OPAL_ALIGNMENT_DOUBLE)
+#  define OP_AVX_HAVE_DOUBLE_INT 1
+#else
+#  define OP_AVX_HAVE_DOUBLE_INT 0
+#endif
+#if (8 == SIZEOF_LONG) && (8 == OPAL_ALIGNMENT_LONG)
+#  define OP_AVX_HAVE_LONG_INT 1
+#else
+#  define OP_AVX_HAVE_LONG_INT 0
+#endif
+
+typedef struct { int v; int k; } ompi_op_avx_2int_t;
+typedef struct { float v; int k; } ompi_op_avx_float_int_t;
+typedef struct { short v; int k; } ompi_op_avx_short_int_t;
+typedef struct { double v; int k; } ompi_op_avx_double_int_t;
+typedef struct { long v; int k; } ompi_op_avx_long_int_t;
+
+/* predicates used for the value comparison */
+#define OP_AVX_LOC_CMPINT_maxloc _MM_CMPINT_NLE
+#define OP_AVX_LOC_CMPINT_minloc _MM_CMPINT_LT
+#define OP_AVX_LOC_CMPFP_maxloc  _CMP_GT_OQ
+#define OP_AVX_LOC_CMPFP_minloc  _CMP_LT_OQ
+#define OP_AVX_LOC_OP_maxloc     >
+#define OP_AVX_LOC_OP_minloc     <
+
+/*
+ * AVX512 value comparisons returning one mask bit per 32 bits (8 bytes
+ * pairs) or per 64 bits (16 bytes pairs). Only the bits of the value lanes
+ * are meaningful.
+ */
+#define OP_AVX512_LOC_CMP_2int(A, B, pred)                              \
+    _mm512_cmp_epi32_mask((A), (B), (pred))
+#define OP_AVX512_LOC_CMP_short_int(A, B, pred)                         \
+    _mm512_cmp_epi32_mask(_mm512_slli_epi32((A), 16), _mm512_slli_epi32((B), 16), (pred))
+#define OP_AVX512_LOC_CMP_long_int(A, B, pred)                          \
+    _mm512_cmp_epi64_mask((A), (B), (pred))
+#define OP_AVX512_LOC_CMPFP_float_int(A, B, pred)                       \
+    _mm512_cmp_ps_mask(_mm512_castsi512_ps(A), _mm512_castsi512_ps(B), (pred))
+#define OP_AVX512_LOC_CMPFP_double_int(A, B, pred)                      \
+    _mm512_cmp_pd_mask(_mm512_castsi512_pd(A), _mm512_castsi512_pd(B), (pred))
+
+#define OP_AVX512_LOC_VALUE_INT(type_name, name, A, B, v, e)            \
+    v = OP_AVX512_LOC_CMP_##type_name(A, B, OP_AVX_LOC_CMPINT_##name);  \
+    e = OP_AVX512_LOC_CMP_##type_name(A, B, _MM_CMPINT_EQ)
+#define OP_AVX512_LOC_VALUE_FP(type_name, name, A, B, v, e)             \
+    v = OP_AVX512_LOC_CMPFP_##type_name(A, B, OP_AVX_LOC_CMPFP_##name); \
+    e = OP_AVX512_LOC_CMPFP_##type_name(A, B, _CMP_EQ_OQ)
+
+/*
+ * AVX2 value comparisons returning all ones in the value lanes where the
+ * predicate holds.
+ */
+#define OP_AVX2_LOC_GT_2int(A, B)       _mm256_cmpgt_epi32((A), (B))
+#define OP_AVX2_LOC_EQ_2int(A, B)       _mm256_cmpeq_epi32((A), (B))
+#define OP_AVX2_LOC_GT_short_int(A, B)  _mm256_cmpgt_epi32(_mm256_slli_epi32((A), 16), _mm256_slli_epi32((B), 16))
+#define OP_AVX2_LOC_EQ_short_int(A, B)  _mm256_cmpeq_epi32(_mm256_slli_epi32((A), 16), _mm256_slli_epi32((B), 16))
+#define OP_AVX2_LOC_GT_long_int(A, B)   _mm256_cmpgt_epi64((A), (B))
+#define OP_AVX2_LOC_EQ_long_int(A, B)   _mm256_cmpeq_epi64((A), (B))
+#define OP_AVX2_LOC_CMP_float_int(A, B, pred)                           \
+    _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(A), _mm256_castsi256_ps(B), (pred)))
+#define OP_AVX2_LOC_CMP_double_int(A, B, pred)                          \
+    _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(A), _mm256_castsi256_pd(B), (pred)))
+
+#define OP_AVX2_LOC_VALUE_INT_maxloc(type_name, A, B, v, e)             \
+    v = OP_AVX2_LOC_GT_##type_name(A, B);                               \
+    e = OP_AVX2_LOC_EQ_##type_name(A, B)
+#define OP_AVX2_LOC_VALUE_INT_minloc(type_name, A, B, v, e)             \
+    v = OP_AVX2_LOC_GT_##type_name(B, A);                               \
+    e = OP_AVX2_LOC_EQ_##type_name(A, B)
+#define OP_AVX2_LOC_VALUE_INT(type_name, name, A, B, v, e)              \
+    OP_AVX2_LOC_VALUE_INT_##name(type_name, A, B, v, e)
+#define OP_AVX2_LOC_VALUE_FP(type_name, name, A, B, v, e)               \
+    v = OP_AVX2_LOC_CMP_##type_name(A, B, OP_AVX_LOC_CMPFP_##name);     \
+    e = OP_AVX2_LOC_CMP_##type_name(A, B, _CMP_EQ_OQ)
+
+/*
+ * Selection masks. For the 2 buffers version (A = in, B = out) the pair
+ * from A wins when the values compare, and only the index of A is taken
+ * on a tie when it is strictly smaller. For the 3 buffers version the
+ * value of A (in1) is kept on a tie and its index is taken when it is not
+ * larger than the one of B (in2).
+ */
+#define OP_AVX_LOC_TAKE_V_2buff(v, e)        (v)
+#define OP_AVX_LOC_TAKE_V_3buff(v, e)        ((v) | (e))
+#define OP_AVX512_LOC_KCMP32_2buff           _MM_CMPINT_LT
+#define OP_AVX512_LOC_KCMP32_3buff           _MM_CMPINT_LE
+
+#if defined(GENERATE_AVX512_CODE) && defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512)
+#if __AVX512F__
+#define OP_AVX_AVX512_LOC8(name, type_name, kind, ftype, A_PTR, B_PTR)   \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(ompi_op_avx_##type_name##_t); \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512i vecA = _mm512_loadu_si512((__m512i*)(A_PTR));       \
+            __m512i vecB = _mm512_loadu_si512((__m512i*)(B_PTR));       \
+            __mmask16 v, e, k, sel;                                     \
+            OP_AVX512_LOC_VALUE_##kind(type_name, name, vecA, vecB, v, e); \
+            k = _mm512_cmp_epi32_mask(vecA, vecB, OP_AVX512_LOC_KCMP32_##ftype); \
+            sel = (OP_AVX_LOC_TAKE_V_##ftype(v, e) & 0x5555) |          \
+                  (((v | (e & (k >> 1))) << 1) & 0xAAAA);               \
+            _mm512_storeu_si512((__m512i*)out, _mm512_mask_blend_epi32(sel, vecB, vecA)); \
+            OP_AVX_LOC_ADVANCE_##ftype(types_per_step);                 \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+
+#define OP_AVX_AVX512_LOC16(name, type_name, kind, ftype, A_PTR, B_PTR)  \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX512F_FLAG) ) {         \
+        types_per_step = (512 / 8) / sizeof(ompi_op_avx_##type_name##_t); \
+        for (; left_over >= types_per_step; left_over -= types_per_step) { \
+            __m512i vecA = _mm512_loadu_si512((__m512i*)(A_PTR));       \
+            __m512i vecB = _mm512_loadu_si512((__m512i*)(B_PTR));       \
+            __mmask8 v, e, k, sel;                                      \
+            OP_AVX512_LOC_VALUE_##kind(type_name, name, vecA, vecB, v, e); \
+            k = _mm512_cmp_epi64_mask(_mm512_slli_epi64(vecA, 32),      \
+                                      _mm512_slli_epi64(vecB, 32),      \
+                                      OP_AVX512_LOC_KCMP32_##ftype);    \
+            sel = (OP_AVX_LOC_TAKE_V_##ftype(v, e) & 0x55) |            \
+                  (((v | (e & (k >> 1))) << 1) & 0xAA);                 \
+            _mm512_storeu_si512((__m512i*)out, _mm512_mask_blend_epi64(sel, vecB, vecA)); \
+            OP_AVX_LOC_ADVANCE_##ftype(types_per_step);                 \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#error Target architecture lacks AVX512F support needed for _mm512_mask_blend_epi32 and _mm512_mask_blend_epi64
+#endif  /* __AVX512F__ */
+#else
+#define OP_AVX_AVX512_LOC8(name, type_name, kind, ftype, A_PTR, B_PTR) {}
+#define OP_AVX_AVX512_LOC16(name, type_name, kind, ftype, A_PTR, B_PTR) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX512) && (1 == OMPI_MCA_OP_HAVE_AVX512) */
+
+/* index comparison on AVX2, all ones where the index of A should be taken
+ * on a tie */
+#define OP_AVX2_LOC_KCMP32_2buff(A, B) _mm256_cmpgt_epi32((B), (A))
+#define OP_AVX2_LOC_KCMP32_3buff(A, B)                                  \
+    _mm256_xor_si256(_mm256_cmpgt_epi32((A), (B)), _mm256_set1_epi32(-1))
+#define OP_AVX2_LOC_KCMP64_2buff(A, B) _mm256_cmpgt_epi64((B), (A))
+#define OP_AVX2_LOC_KCMP64_3buff(A, B)                                  \
+    _mm256_xor_si256(_mm256_cmpgt_epi64((A), (B)), _mm256_set1_epi32(-1))
+
+#if defined(GENERATE_AVX2_CODE) && defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2)
+#if __AVX2__
+#define OP_AVX_AVX2_LOC8(name, type_name, kind, ftype, A_PTR, B_PTR)     \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX2_FLAG | OMPI_OP_AVX_HAS_AVX_FLAG) ) { \
+        types_per_step = (256 / 8) / sizeof(ompi_op_avx_##type_name##_t); \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256i vecA = _mm256_loadu_si256((__m256i*)(A_PTR));       \
+            __m256i vecB = _mm256_loadu_si256((__m256i*)(B_PTR));       \
+            __m256i v, e, k, sel;                                       \
+            OP_AVX2_LOC_VALUE_##kind(type_name, name, vecA, vecB, v, e); \
+            k = OP_AVX2_LOC_KCMP32_##ftype(vecA, vecB);                 \
+            k = _mm256_or_si256(v, _mm256_and_si256(e, _mm256_srli_epi64(k, 32))); \
+            sel = _mm256_blend_epi32(OP_AVX2_LOC_TAKE_V_##ftype(v, e),  \
+                                     _mm256_slli_epi64(k, 32), 0xAA);   \
+            _mm256_storeu_si256((__m256i*)out, _mm256_blendv_epi8(vecB, vecA, sel)); \
+            OP_AVX_LOC_ADVANCE_##ftype(types_per_step);                 \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+
+#define OP_AVX_AVX2_LOC16(name, type_name, kind, ftype, A_PTR, B_PTR)    \
+    if( OMPI_OP_AVX_HAS_FLAGS(OMPI_OP_AVX_HAS_AVX2_FLAG | OMPI_OP_AVX_HAS_AVX_FLAG) ) { \
+        types_per_step = (256 / 8) / sizeof(ompi_op_avx_##type_name##_t); \
+        for( ; left_over >= types_per_step; left_over -= types_per_step ) { \
+            __m256i vecA = _mm256_loadu_si256((__m256i*)(A_PTR));       \
+            __m256i vecB = _mm256_loadu_si256((__m256i*)(B_PTR));       \
+            __m256i v, e, k, sel;                                       \
+            OP_AVX2_LOC_VALUE_##kind(type_name, name, vecA, vecB, v, e); \
+            k = OP_AVX2_LOC_KCMP64_##ftype(_mm256_slli_epi64(vecA, 32), \
+                                           _mm256_slli_epi64(vecB, 32)); \
+            k = _mm256_or_si256(v, _mm256_and_si256(e, _mm256_bsrli_epi128(k, 8))); \
+            sel = _mm256_blend_epi32(OP_AVX2_LOC_TAKE_V_##ftype(v, e),  \
+                                     _mm256_bslli_epi128(k, 8), 0xCC);  \
+            _mm256_storeu_si256((__m256i*)out, _mm256_blendv_epi8(vecB, vecA, sel)); \
+            OP_AVX_LOC_ADVANCE_##ftype(types_per_step);                 \
+        }                                                               \
+        if( 0 == left_over ) return;                                    \
+    }
+#else
+#error Target architecture lacks AVX2 support needed for _mm256_blendv_epi8 and _mm256_cmpgt_epi64
+#endif  /* __AVX2__ */
+#else
+#define OP_AVX_AVX2_LOC8(name, type_name, kind, ftype, A_PTR, B_PTR) {}
+#define OP_AVX_AVX2_LOC16(name, type_name, kind, ftype, A_PTR, B_PTR) {}
+#endif  /* defined(OMPI_MCA_OP_HAVE_AVX2) && (1 == OMPI_MCA_OP_HAVE_AVX2) */
+
+#define OP_AVX2_LOC_TAKE_V_2buff(v, e)       (v)
+#define OP_AVX2_LOC_TAKE_V_3buff(v, e)       _mm256_or_si256((v), (e))
+#define OP_AVX_LOC_ADVANCE_2buff(n)          in += (n); out += (n)
+#define OP_AVX_LOC_ADVANCE_3buff(n)          in1 += (n); in2 += (n); out += (n)
+
+/*
+ * name: maxloc or minloc
+ * type_name: the pair type
+ * size: 8 or 16, the size of the pair in bytes
+ * kind: INT or FP, how the values are compared
+ */
+#define OP_AVX_LOC_FUNC(name, type_name, size, kind)                    \
+static void OP_CONCAT(ompi_op_avx_2buff_##name##_##type_name, PREPEND)(const void *_in, void *_out, int *count, \
+                                                                     struct ompi_datatype_t **dtype, \
+                                                                     struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    ompi_op_avx_##type_name##_t *in = (ompi_op_avx_##type_name##_t*)_in, \
+        *out = (ompi_op_avx_##type_name##_t*)_out;                      \
+    OP_AVX_AVX512_LOC##size(name, type_name, kind, 2buff, in, out);     \
+    OP_AVX_AVX2_LOC##size(name, type_name, kind, 2buff, in, out);       \
+    for (; left_over > 0; left_over--, ++in, ++out) {                   \
+        if (in->v OP_AVX_LOC_OP_##name out->v) {                        \
+            out->v = in->v;                                             \
+            out->k = in->k;                                             \
+        } else if (in->v == out->v) {                                   \
+            out->k = (out->k < in->k ? out->k : in->k);                 \
+        }                                                               \
+    }                                                                   \
+}
+
+#define OP_AVX_LOC_FUNC_3(name, type_name, size, kind)                  \
+static void OP_CONCAT(ompi_op_avx_3buff_##name##_##type_name, PREPEND)(const void *_in1, const void *_in2, void *_out, int *count, \
+                                                                     struct ompi_datatype_t **dtype, \
+                                                                     struct ompi_op_base_module_1_0_0_t *module) \
+{                                                                       \
+    int types_per_step, left_over = *count;                             \
+    ompi_op_avx_##type_name##_t *in1 = (ompi_op_avx_##type_name##_t*)_in1, \
+        *in2 = (ompi_op_avx_##type_name##_t*)_in2,                      \
+        *out = (ompi_op_avx_##type_name##_t*)_out;                      \
+    OP_AVX_AVX512_LOC##size(name, type_name, kind, 3buff, in1, in2);    \
+    OP_AVX_AVX2_LOC##size(name, type_name, kind, 3buff, in1, in2);      \
+    for (; left_over > 0; left_over--, ++in1, ++in2, ++out) {           \
+        if (in1->v OP_AVX_LOC_OP_##name in2->v) {                       \
+            out->v = in1->v;                                            \
+            out->k = in1->k;                                            \
+        } else if (in1->v == in2->v) {                                  \
+            out->v = in1->v;                                            \
+            out->k = (in2->k < in1->k ? in2->k : in1->k);               \
+        } else {                                                        \
+            out->v = in2->v;                                            \
+            out->k = in2->k;                                            \
+        }                                                               \
+    }                                                                   \
+}
+
+#if OP_AVX_GENERATE_LOC
+    OP_AVX_LOC_FUNC(maxloc, 2int, 8, INT)
+    OP_AVX_LOC_FUNC(maxloc, short_int, 8, INT)
+    OP_AVX_LOC_FUNC(maxloc, float_int, 8, FP)
+    OP_AVX_LOC_FUNC(minloc, 2int, 8, INT)
+    OP_AVX_LOC_FUNC(minloc, short_int, 8, INT)
+    OP_AVX_LOC_FUNC(minloc, float_int, 8, FP)
+    OP_AVX_LOC_FUNC_3(maxloc, 2int, 8, INT)
+    OP_AVX_LOC_FUNC_3(maxloc, short_int, 8, INT)
+    OP_AVX_LOC_FUNC_3(maxloc, float_int, 8, FP)
+    OP_AVX_LOC_FUNC_3(minloc, 2int, 8, INT)
+    OP_AVX_LOC_FUNC_3(minloc, short_int, 8, INT)
+    OP_AVX_LOC_FUNC_3(minloc, float_int, 8, FP)
+#if OP_AVX_HAVE_DOUBLE_INT
+    OP_AVX_LOC_FUNC(maxloc, double_int, 16, FP)
+    OP_AVX_LOC_FUNC(minloc, double_int, 16, FP)
+    OP_AVX_LOC_FUNC_3(maxloc, double_int, 16, FP)
+    OP_AVX_LOC_FUNC_3(minloc, double_int, 16, FP)
+#endif  /* OP_AVX_HAVE_DOUBLE_INT */
+#if OP_AVX_HAVE_LONG_INT
+    OP_AVX_LOC_FUNC(maxloc, long_int, 16, INT)
+    OP_AVX_LOC_FUNC(minloc, long_int, 16, INT)
+    OP_AVX_LOC_FUNC_3(maxloc, long_int, 16, INT)
+    OP_AVX_LOC_FUNC_3(minloc, long_int, 16, INT)
+#endif  /* OP_AVX_HAVE_LONG_INT */
+#endif  /* OP_AVX_GENERATE_LOC */
+
 /** C integer ***********************************************************/
 #define C_INTEGER_8_16_32(name, ftype)                                                         \
     [OMPI_OP_BASE_TYPE_INT8_T]   = OP_CONCAT(ompi_op_avx_##ftype##_##name##_int8_t,PREPEND),   \
@@ -1367,11 +1807,46 @@ static void OP_CONCAT(ompi_op_avx_3buff_##op##_double,PREPEND)(const void *_in1,
 #define FLOAT(name, ftype) OP_CONCAT(ompi_op_avx_##ftype##_##name##_float,PREPEND)
 #define DOUBLE(name, ftype) OP_CONCAT(ompi_op_avx_##ftype##_##name##_double,PREPEND)
 
+#if OP_AVX_GENERATE_SHORT_FLOAT
+#define SHORT_FLOAT(name, ftype) OP_CONCAT(ompi_op_avx_##ftype##_##name##_short_float,PREPEND)
+#else
+#define SHORT_FLOAT(name, ftype) NULL
+#endif  /* OP_AVX_GENERATE_SHORT_FLOAT */
+
 #define FLOATING_POINT(name, ftype)                                         \
     [OMPI_OP_BASE_TYPE_SHORT_FLOAT] = NULL,                                 \
     [OMPI_OP_BASE_TYPE_FLOAT] = FLOAT(name, ftype),                         \
     [OMPI_OP_BASE_TYPE_DOUBLE] = DOUBLE(name, ftype)
 
+#define FLOATING_POINT_WITH_SHORT(name, ftype)                              \
+    [OMPI_OP_BASE_TYPE_SHORT_FLOAT] = SHORT_FLOAT(name, ftype),             \
+    [OMPI_OP_BASE_TYPE_FLOAT] = FLOAT(name, ftype),                         \
+    [OMPI_OP_BASE_TYPE_DOUBLE] = DOUBLE(name, ftype)
+
+/** Pair types for maxloc and minloc ************************************/
+#if OP_AVX_GENERATE_LOC
+#define LOC_PAIR(name, ftype, type_name) OP_CONCAT(ompi_op_avx_##ftype##_##name##_##type_name,PREPEND)
+#if OP_AVX_HAVE_DOUBLE_INT
+#define LOC_DOUBLE_INT(name, ftype) LOC_PAIR(name, ftype, double_int)
+#else
+#define LOC_DOUBLE_INT(name, ftype) NULL
+#endif  /* OP_AVX_HAVE_DOUBLE_INT */
+#if OP_AVX_HAVE_LONG_INT
+#define LOC_LONG_INT(name, ftype) LOC_PAIR(name, ftype, long_int)
+#else
+#define LOC_LONG_INT(name, ftype) NULL
+#endif  /* OP_AVX_HAVE_LONG_INT */
+
+#define C_PAIR(name, ftype)                                                 \
+    [OMPI_OP_BASE_TYPE_FLOAT_INT] = LOC_PAIR(name, ftype, float_int),       \
+    [OMPI_OP_BASE_TYPE_DOUBLE_INT] = LOC_DOUBLE_INT(name, ftype),           \
+    [OMPI_OP_BASE_TYPE_LONG_INT] = LOC_LONG_INT(name, ftype),               \
+    [OMPI_OP_BASE_TYPE_2INT] = LOC_PAIR(name, ftype, 2int),                 \
+    [OMPI_OP_BASE_TYPE_SHORT_INT] = LOC_PAIR(name, ftype, short_int)
+#else
+#define C_PAIR(name, ftype) NULL
+#endif  /* OP_AVX_GENERATE_LOC */
+
 /*
  * MPI_OP_NULL
  * All types
@@ -1392,17 +1867,17 @@ ompi_op_base_handler_fn_t OP_CONCAT(ompi_op_avx_functions, PREPEND)[OMPI_OP_BASE
     /* Corresponds to MPI_MAX */
     [OMPI_OP_BASE_FORTRAN_MAX] = {
         C_INTEGER_OPTIONAL(max, 2buff),
-        FLOATING_POINT(max, 2buff),
+        FLOATING_POINT_WITH_SHORT(max, 2buff),
     },
     /* Corresponds to MPI_MIN */
     [OMPI_OP_BASE_FORTRAN_MIN] = {
         C_INTEGER_OPTIONAL(min, 2buff),
-        FLOATING_POINT(min, 2buff),
+        FLOATING_POINT_WITH_SHORT(min, 2buff),
     },
     /* Corresponds to MPI_SUM */
     [OMPI_OP_BASE_FORTRAN_SUM] = {
         C_INTEGER(sum, 2buff),
-        FLOATING_POINT(add, 2buff),
+        FLOATING_POINT_WITH_SHORT(add, 2buff),
     },
     /* Corresponds to MPI_PROD */
     [OMPI_OP_BASE_FORTRAN_PROD] = {
@@ -1433,6 +1908,14 @@ ompi_op_base_handler_fn_t OP_CONCAT(ompi_op_avx_functions, PREPEND)[OMPI_OP_BASE
     [OMPI_OP_BASE_FORTRAN_BXOR] = {
         C_INTEGER(bxor, 2buff),
     },
+    /* Corresponds to MPI_MAXLOC */
+    [OMPI_OP_BASE_FORTRAN_MAXLOC] = {
+        C_PAIR(maxloc, 2buff),
+    },
+    /* Corresponds to MPI_MINLOC */
+    [OMPI_OP_BASE_FORTRAN_MINLOC] = {
+        C_PAIR(minloc, 2buff),
+    },
     /* Corresponds to MPI_REPLACE */
     [OMPI_OP_BASE_FORTRAN_REPLACE] = {
         /* (MPI_ACCUMULATE is handled differently than the other
@@ -1455,17 +1938,17 @@ ompi_op_base_3buff_handler_fn_t OP_CONCAT(ompi_op_avx_3buff_functions, PREPEND)[
     /* Corresponds to MPI_MAX */
     [OMPI_OP_BASE_FORTRAN_MAX] = {
         C_INTEGER_OPTIONAL(max, 3buff),
-        FLOATING_POINT(max, 3buff),
+        FLOATING_POINT_WITH_SHORT(max, 3buff),
     },
     /* Corresponds to MPI_MIN */
     [OMPI_OP_BASE_FORTRAN_MIN] = {
         C_INTEGER_OPTIONAL(min, 3buff),
-        FLOATING_POINT(min, 3buff),
+        FLOATING_POINT_WITH_SHORT(min, 3buff),
     },
     /* Corresponds to MPI_SUM */
     [OMPI_OP_BASE_FORTRAN_SUM] = {
         C_INTEGER(sum, 3buff),
-        FLOATING_POINT(add, 3buff),
+        FLOATING_POINT_WITH_SHORT(add, 3buff),
     },
     /* Corresponds to MPI_PROD */
     [OMPI_OP_BASE_FORTRAN_PROD] = {
@@ -1496,6 +1979,14 @@ ompi_op_base_3buff_handler_fn_t OP_CONCAT(ompi_op_avx_3buff_functions, PREPEND)[
     [OMPI_OP_BASE_FORTRAN_BXOR] = {
         C_INTEGER(xor, 3buff),
     },
+    /* Corresponds to MPI_MAXLOC */
+    [OMPI_OP_BASE_FORTRAN_MAXLOC] = {
+        C_PAIR(maxloc, 3buff),
+    },
+    /* Corresponds to MPI_MINLOC */
+    [OMPI_OP_BASE_FORTRAN_MINLOC] = {
+        C_PAIR(minloc, 3buff),
+    },
     /* Corresponds to MPI_REPLACE */
     [OMPI_OP_BASE_FORTRAN_REPLACE] = {
         /* MPI_ACCUMULATE is handled differently than the other
@@ -57,6 +57,9 @@ struct ompi_osc_sm_component_t {
     unsigned int priority;
 
     char *backing_directory;
+
+    /** Use processor atomics for accumulate operations when possible */
+    bool acc_use_amo;
 };
 typedef struct ompi_osc_sm_component_t ompi_osc_sm_component_t;
 OMPI_DECLSPEC extern ompi_osc_sm_component_t mca_osc_sm_component;
@@ -75,6 +78,7 @@ struct ompi_osc_sm_module_t {
     opal_shmem_ds_t seg_ds;
     void *segment_base;
     bool noncontig;
+    bool acc_use_amo;
 
     size_t *sizes;
     void **bases;
@@ -14,12 +14,272 @@
 
 #include "ompi_config.h"
 
+#include "opal/datatype/opal_convertor.h"
+
 #include "ompi/mca/osc/osc.h"
 #include "ompi/mca/osc/base/base.h"
 #include "ompi/mca/osc/base/osc_base_obj_convert.h"
 
 #include "osc_sm.h"
 
+#define OSC_SM_DECODE_MAX 32
+
+/*
+ * Accumulate operations on naturally aligned 4 and 8 byte elements are
+ * done with processor atomics instead of the accumulate lock of the
+ * target. MPI only guarantees atomicity per element of the same
+ * predefined datatype, so whether an element is updated atomically must
+ * only depend on its datatype and its address: all processes then agree
+ * on how a given element is updated. Elements that are not aligned (and
+ * datatypes that do not qualify) still use the accumulate lock.
+ */
+
+static inline ompi_datatype_t *
+ompi_osc_sm_atomic_primitive(ompi_osc_sm_module_t *module, ompi_datatype_t *dt,
+                             ompi_op_t *op, size_t *size)
+{
+    ompi_datatype_t *primitive;
+
+    if (!module->acc_use_amo) {
+        return NULL;
+    }
+
+    if (NULL != op && (!ompi_op_is_intrinsic(op) || OMPI_OP_MAXLOC == op->op_type ||
+                       OMPI_OP_MINLOC == op->op_type)) {
+        return NULL;
+    }
+
+    /* pair types are not predefined at the opal level and are not a single value */
+    primitive = ompi_datatype_get_single_predefined_type_from_args(dt);
+    if (NULL == primitive || !opal_datatype_is_predefined(&primitive->super) ||
+        OMPI_DATATYPE_FLAG_DATA_COMPLEX == (primitive->super.flags & OMPI_DATATYPE_FLAG_DATA_TYPE)) {
+        return NULL;
+    }
+
+    ompi_datatype_type_size(primitive, size);
+    if (sizeof(int32_t) != *size && sizeof(int64_t) != *size) {
+        return NULL;
+    }
+
+    return primitive;
+}
+
+#define OSC_SM_ATOMIC_ELEMENT(bits)                                     \
+static inline int##bits##_t                                             \
+ompi_osc_sm_atomic_element_##bits(opal_atomic_int##bits##_t *addr,     \
+                                  int##bits##_t value, ompi_op_t *op,   \
+                                  ompi_datatype_t *dt)                  \
+{                                                                       \
+    int##bits##_t old_value, new_value;                                 \
+                                                                        \
+    if (&ompi_mpi_op_no_op.op == op) {                                  \
+        return *addr;                                                   \
+    }                                                                   \
+                                                                        \
+    if (&ompi_mpi_op_replace.op == op) {                                \
+        return opal_atomic_swap_##bits(addr, value);                    \
+    }                                                                   \
+                                                                        \
+    if (OMPI_DATATYPE_FLAG_DATA_INT ==                                  \
+        (dt->super.flags & OMPI_DATATYPE_FLAG_DATA_TYPE)) {             \
+        switch (op->op_type) {                                          \
+        case OMPI_OP_SUM:                                               \
+            return opal_atomic_fetch_add_##bits(addr, value);           \
+        case OMPI_OP_BAND:                                              \
+            return opal_atomic_fetch_and_##bits(addr, value);           \
+        case OMPI_OP_BOR:                                               \
+            return opal_atomic_fetch_or_##bits(addr, value);            \
+        case OMPI_OP_BXOR:                                              \
+            return opal_atomic_fetch_xor_##bits(addr, value);           \
+        default:                                                        \
+            break;                                                      \
+        }                                                               \
+    }                                                                   \
+                                                                        \
+    /* everything else is a compare-and-swap loop around the reduction */ \
+    old_value = *addr;                                                  \
+    do {                                                                \
+        new_value = old_value;                                          \
+        ompi_op_reduce(op, &value, &new_value, 1, dt);                  \
+    } while (!opal_atomic_compare_exchange_strong_##bits(addr, &old_value, new_value)); \
+                                                                        \
+    return old_value;                                                   \
+}
+
+OSC_SM_ATOMIC_ELEMENT(32)
+OSC_SM_ATOMIC_ELEMENT(64)
+
+/* apply op to count consecutive elements of the target; origin and result are packed */
+static void
+ompi_osc_sm_atomic_segment(ompi_osc_sm_module_t *module, int target, char *addr,
+                           size_t count, ompi_datatype_t *dt, size_t size,
+                           ompi_op_t *op, const char *origin, char *result)
+{
+    if (!ompi_osc_base_is_atomic_size_supported((uint64_t) (uintptr_t) addr, size)) {
+        opal_atomic_lock(&module->node_states[target].accumulate_lock);
+        if (NULL != result) {
+            memcpy(result, addr, count * size);
+        }
+        if (&ompi_mpi_op_replace.op == op) {
+            memcpy(addr, origin, count * size);
+        } else if (&ompi_mpi_op_no_op.op != op) {
+            ompi_op_reduce(op, (void *) origin, addr, count, dt);
+        }
+        opal_atomic_unlock(&module->node_states[target].accumulate_lock);
+        return;
+    }
+
+    for (size_t i = 0 ; i < count ; ++i, addr += size) {
+        if (sizeof(int32_t) == size) {
+            int32_t value = 0, old_value;
+
+            if (NULL != origin) {
+                memcpy(&value, origin + i * size, size);
+            }
+            old_value = ompi_osc_sm_atomic_element_32((opal_atomic_int32_t *) addr, value, op, dt);
+            if (NULL != result) {
+                memcpy(result + i * size, &old_value, size);
+            }
+        } else {
+            int64_t value = 0, old_value;
+
+            if (NULL != origin) {
+                memcpy(&value, origin + i * size, size);
+            }
+            old_value = ompi_osc_sm_atomic_element_64((opal_atomic_int64_t *) addr, value, op, dt);
+            if (NULL != result) {
+                memcpy(result + i * size, &old_value, size);
+            }
+        }
+    }
+}
+
+/**
+ * Accumulate (and fetch the previous target contents into result_addr, if
+ * not NULL) using processor atomics. Returns OMPI_ERR_NOT_SUPPORTED if the
+ * operation has to go through the accumulate lock of the target instead.
+ */
+static int
+ompi_osc_sm_atomic_accumulate(ompi_osc_sm_module_t *module, int target,
+                              const void *origin_addr, size_t origin_count,
+                              ompi_datatype_t *origin_dt,
+                              void *result_addr, size_t result_count,
+                              ompi_datatype_t *result_dt,
+                              void *remote_address, size_t target_count,
+                              ompi_datatype_t *target_dt, ompi_op_t *op)
+{
+    char *origin = NULL, *result = NULL, *origin_buffer = NULL, *result_buffer = NULL;
+    struct iovec iov[OSC_SM_DECODE_MAX];
+    ompi_datatype_t *primitive;
+    size_t primitive_size, size, count;
+    ptrdiff_t lb, extent;
+    int ret = OMPI_SUCCESS;
+
+    primitive = ompi_osc_sm_atomic_primitive(module, target_dt, op, &primitive_size);
+    if (NULL == primitive) {
+        return OMPI_ERR_NOT_SUPPORTED;
+    }
+
+    ompi_datatype_type_size(target_dt, &size);
+    count = target_count * size / primitive_size;
+
+    if (&ompi_mpi_op_no_op.op != op) {
+        ompi_datatype_type_size(origin_dt, &size);
+        if (primitive != ompi_datatype_get_single_predefined_type_from_args(origin_dt) ||
+            count != origin_count * size / primitive_size) {
+            return OMPI_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    if (NULL != result_addr) {
+        ompi_datatype_type_size(result_dt, &size);
+        if (primitive != ompi_datatype_get_single_predefined_type_from_args(result_dt) ||
+            count != result_count * size / primitive_size) {
+            return OMPI_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    if (0 == count) {
+        return OMPI_SUCCESS;
+    }
+
+    /* origin and result are accessed as packed arrays of the primitive */
+    if (&ompi_mpi_op_no_op.op != op) {
+        if (ompi_datatype_is_contiguous_memory_layout(origin_dt, origin_count)) {
+            ompi_datatype_get_true_extent(origin_dt, &lb, &extent);
+            origin = (char *) origin_addr + lb;
+        } else {
+            origin = origin_buffer = malloc(count * primitive_size);
+            if (OPAL_UNLIKELY(NULL == origin_buffer)) {
+                return OMPI_ERR_OUT_OF_RESOURCE;
+            }
+            ret = ompi_datatype_sndrcv(origin_addr, origin_count, origin_dt,
+                                       origin_buffer, count, primitive);
+            if (OMPI_SUCCESS != ret) {
+                goto done;
+            }
+        }
+    }
+
+    if (NULL != result_addr) {
+        if (ompi_datatype_is_contiguous_memory_layout(result_dt, result_count)) {
+            ompi_datatype_get_true_extent(result_dt, &lb, &extent);
+            result = (char *) result_addr + lb;
+        } else {
+            result = result_buffer = malloc(count * primitive_size);
+            if (OPAL_UNLIKELY(NULL == result_buffer)) {
+                ret = OMPI_ERR_OUT_OF_RESOURCE;
+                goto done;
+            }
+        }
+    }
+
+    if (ompi_datatype_is_contiguous_memory_layout(target_dt, target_count)) {
+        ompi_datatype_get_true_extent(target_dt, &lb, &extent);
+        ompi_osc_sm_atomic_segment(module, target, (char *) remote_address + lb, count,
+                                   primitive, primitive_size, op, origin, result);
+    } else {
+        opal_convertor_t convertor;
+        uint32_t iov_count;
+        bool done;
+
+        OBJ_CONSTRUCT(&convertor, opal_convertor_t);
+        opal_convertor_copy_and_prepare_for_recv(ompi_mpi_local_convertor, &target_dt->super,
+                                                 target_count, remote_address, 0, &convertor);
+        do {
+            iov_count = OSC_SM_DECODE_MAX;
+            done = opal_convertor_raw(&convertor, iov, &iov_count, &size);
+
+            for (uint32_t i = 0 ; i < iov_count ; ++i) {
+                count = iov[i].iov_len / primitive_size;
+                ompi_osc_sm_atomic_segment(module, target, (char *) iov[i].iov_base, count,
+                                           primitive, primitive_size, op, origin, result);
+                if (NULL != origin) {
+                    origin += iov[i].iov_len;
+                }
+                if (NULL != result) {
+                    result += iov[i].iov_len;
+                }
+            }
+        } while (!done);
+
+        opal_convertor_cleanup(&convertor);
+        OBJ_DESTRUCT(&convertor);
+    }
+
+    if (NULL != result_buffer) {
+        ompi_datatype_type_size(target_dt, &size);
+        ret = ompi_datatype_sndrcv(result_buffer, target_count * size / primitive_size, primitive,
+                                   result_addr, result_count, result_dt);
+    }
+
+ done:
+    free(origin_buffer);
+    free(result_buffer);
+
+    return ret;
+}
+
 int
 ompi_osc_sm_rput(const void *origin_addr,
                  size_t origin_count,
@@ -127,6 +387,13 @@ ompi_osc_sm_raccumulate(const void *origin_addr,
 
     remote_address = ((char*) (module->bases[target])) + module->disp_units[target] * target_disp;
 
+    ret = ompi_osc_sm_atomic_accumulate(module, target, origin_addr, origin_count, origin_dt,
+                                        NULL, 0, NULL, remote_address, target_count, target_dt, op);
+    if (OMPI_ERR_NOT_SUPPORTED != ret) {
+        *ompi_req = &ompi_request_empty;
+        return ret;
+    }
+
     opal_atomic_lock(&module->node_states[target].accumulate_lock);
     if (op == &ompi_mpi_op_replace.op) {
         ret = ompi_datatype_sndrcv((void *)origin_addr, origin_count, origin_dt,
@@ -178,6 +445,14 @@ ompi_osc_sm_rget_accumulate(const void *origin_addr,
 
     remote_address = ((char*) (module->bases[target])) + module->disp_units[target] * target_disp;
 
+    ret = ompi_osc_sm_atomic_accumulate(module, target, origin_addr, origin_count, origin_dt,
+                                        result_addr, result_count, result_dt, remote_address,
+                                        target_count, target_dt, op);
+    if (OMPI_ERR_NOT_SUPPORTED != ret) {
+        *ompi_req = &ompi_request_empty;
+        return ret;
+    }
+
     opal_atomic_lock(&module->node_states[target].accumulate_lock);
 
     ret = ompi_datatype_sndrcv(remote_address, target_count, target_dt,
@@ -293,6 +568,12 @@ ompi_osc_sm_accumulate(const void *origin_addr,
 
     remote_address = ((char*) (module->bases[target])) + module->disp_units[target] * target_disp;
 
+    ret = ompi_osc_sm_atomic_accumulate(module, target, origin_addr, origin_count, origin_dt,
+                                        NULL, 0, NULL, remote_address, target_count, target_dt, op);
+    if (OMPI_ERR_NOT_SUPPORTED != ret) {
+        return ret;
+    }
+
     opal_atomic_lock(&module->node_states[target].accumulate_lock);
     if (op == &ompi_mpi_op_replace.op) {
         ret = ompi_datatype_sndrcv((void *)origin_addr, origin_count, origin_dt,
@@ -337,6 +618,13 @@ ompi_osc_sm_get_accumulate(const void *origin_addr,
 
     remote_address = ((char*) (module->bases[target])) + module->disp_units[target] * target_disp;
 
+    ret = ompi_osc_sm_atomic_accumulate(module, target, origin_addr, origin_count, origin_dt,
+                                        result_addr, result_count, result_dt, remote_address,
+                                        target_count, target_dt, op);
+    if (OMPI_ERR_NOT_SUPPORTED != ret) {
+        return ret;
+    }
+
     opal_atomic_lock(&module->node_states[target].accumulate_lock);
 
     ret = ompi_datatype_sndrcv(remote_address, target_count, target_dt,
@@ -381,6 +669,30 @@ ompi_osc_sm_compare_and_swap(const void *origin_addr,
 
     remote_address = ((char*) (module->bases[target])) + module->disp_units[target] * target_disp;
 
+    if (NULL != ompi_osc_sm_atomic_primitive(module, dt, NULL, &size) &&
+        ompi_osc_base_is_atomic_size_supported((uint64_t) (uintptr_t) remote_address, size)) {
+        /* the comparison is bitwise, as in the locked path below */
+        if (sizeof(int32_t) == size) {
+            int32_t compare, value;
+
+            memcpy(&compare, compare_addr, size);
+            memcpy(&value, origin_addr, size);
+            (void) opal_atomic_compare_exchange_strong_32((opal_atomic_int32_t *) remote_address,
+                                                          &compare, value);
+            memcpy(result_addr, &compare, size);
+        } else {
+            int64_t compare, value;
+
+            memcpy(&compare, compare_addr, size);
+            memcpy(&value, origin_addr, size);
+            (void) opal_atomic_compare_exchange_strong_64((opal_atomic_int64_t *) remote_address,
+                                                          &compare, value);
+            memcpy(result_addr, &compare, size);
+        }
+
+        return OMPI_SUCCESS;
+    }
+
     ompi_datatype_type_size(dt, &size);
 
     opal_atomic_lock(&module->node_states[target].accumulate_lock);
@@ -411,6 +723,7 @@ ompi_osc_sm_fetch_and_op(const void *origin_addr,
     ompi_osc_sm_module_t *module =
         (ompi_osc_sm_module_t*) win->w_osc_module;
     void *remote_address;
+    int ret;
 
     OPAL_OUTPUT_VERBOSE((50, ompi_osc_base_framework.framework_output,
                          "fetch_and_op: 0x%lx, %s, %d, %d, %s, 0x%lx",
@@ -421,6 +734,12 @@ ompi_osc_sm_fetch_and_op(const void *origin_addr,
 
     remote_address = ((char*) (module->bases[target])) + module->disp_units[target] * target_disp;
 
+    ret = ompi_osc_sm_atomic_accumulate(module, target, origin_addr, 1, dt, result_addr, 1, dt,
+                                        remote_address, 1, dt, op);
+    if (OMPI_ERR_NOT_SUPPORTED != ret) {
+        return ret;
+    }
+
     opal_atomic_lock(&module->node_states[target].accumulate_lock);
 
     /* fetch */
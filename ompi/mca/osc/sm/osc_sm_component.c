@@ -138,6 +138,18 @@ static int component_register (void)
                                           &mca_osc_sm_component.priority);
     free(description_str);
 
+    mca_osc_sm_component.acc_use_amo = true;
+    opal_asprintf(&description_str, "Use processor atomic operations instead of the accumulate "
+                  "lock of the target for accumulate, fetch-and-op and compare-and-swap "
+                  "operations on aligned 4 and 8 byte predefined datatypes (default: %s)",
+                  mca_osc_sm_component.acc_use_amo ? "true" : "false");
+    (void)mca_base_component_var_register(&mca_osc_sm_component.super.osc_version,
+                                          "acc_use_amo", description_str,
+                                          MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0,
+                                          OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_GROUP,
+                                          &mca_osc_sm_component.acc_use_amo);
+    free(description_str);
+
     return OPAL_SUCCESS;
 }
 
@@ -230,6 +242,7 @@ component_select(struct ompi_win_t *win, void **base, size_t size, ptrdiff_t dis
     if (OMPI_SUCCESS != ret) goto error;
 
     module->flavor = flavor;
+    module->acc_use_amo = mca_osc_sm_component.acc_use_amo;
 
     /* create the segment */
     if (1 == comm_size) {
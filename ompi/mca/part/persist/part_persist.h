@@ -29,6 +29,7 @@
 #endif
 
 #include<math.h>
+#include <stdlib.h>
 
 #include "ompi_config.h"
 #include "ompi/request/request.h"
@@ -36,6 +37,7 @@
 #include "ompi/mca/part/base/base.h"
 #include "ompi/datatype/ompi_datatype.h"
 #include "ompi/communicator/communicator.h"
+#include "ompi/info/info.h"
 #include "ompi/request/request.h"
 #include "opal/sys/atomic.h"
 
@@ -60,6 +62,7 @@ struct ompi_part_persist_t {
     int                    free_list_num;
     int                    free_list_max;
     int                    free_list_inc;
+    size_t                 aggregation_size; /* default size of the transfers of aggregated partitions */
     opal_list_t           *progress_list;
 
     int32_t next_send_tag;                /**< This is a counter for send tags for the actual data transfer. */
@@ -101,6 +104,7 @@ mca_part_persist_free_req(struct mca_part_persist_request_t* req)
     }
     free(req->persist_reqs);
     free(req->flags);
+    free((void *) req->aggr_ready);
 
     if( MCA_PART_PERSIST_REQUEST_PRECV == req->req_type ) {
         MCA_PART_PERSIST_PRECV_REQUEST_RETURN(req);
@@ -375,6 +379,8 @@ mca_part_persist_precv_init(void *buf,
     req->first_send  = true; 
     req->flag_post_setup_recv = false;
     req->flags = NULL;
+    req->aggr_parts = 1;
+    req->aggr_ready = NULL;
     /* Non-blocking receive on setup info */
     err	= MCA_PML_CALL(irecv(&req->setup_info[1], sizeof(struct ompi_mca_persist_setup_t), MPI_BYTE, src, tag, comm, &req->setup_req[1])); 
     if(OMPI_SUCCESS != err) return OMPI_ERROR;
@@ -404,6 +410,39 @@ mca_part_persist_precv_init(void *buf,
     return err;
 }
 
+/**
+ * Number of user partitions sent in one transfer: as many as fit in the aggregation size
+ * given by the "part_persist_aggregation_size" info key or the MCA parameter, rounded down
+ * to a divisor of the number of partitions so that all transfers have the same size.
+ */
+static inline size_t
+mca_part_persist_aggr_parts(size_t parts, size_t part_bytes, struct ompi_info_t *info)
+{
+    size_t aggregation_size = ompi_part_persist.aggregation_size;
+    size_t aggr_parts;
+    opal_cstring_t *value;
+    int flag;
+
+    if (NULL != info && OMPI_SUCCESS == ompi_info_get(info, "part_persist_aggregation_size", &value, &flag) && flag) {
+        aggregation_size = strtoull(value->string, NULL, 0);
+        OBJ_RELEASE(value);
+    }
+
+    if (0 == parts || 0 == part_bytes || aggregation_size < 2 * part_bytes) {
+        return 1;
+    }
+
+    aggr_parts = aggregation_size / part_bytes;
+    if (aggr_parts > parts) {
+        aggr_parts = parts;
+    }
+    while (0 != parts % aggr_parts) {
+        aggr_parts--;
+    }
+
+    return aggr_parts;
+}
+
 __opal_attribute_always_inline__ static inline int
 mca_part_persist_psend_init(const void* buf,
                         size_t parts,
@@ -445,16 +484,24 @@ mca_part_persist_psend_init(const void* buf,
     dt_size = (dt_size_ > (size_t) UINT_MAX) ? MPI_UNDEFINED : (uint32_t) dt_size_;
     req->req_bytes = parts * count * dt_size;
 
+    /* Group the partitions into transfers of the same size. The receiver maps its
+     * partitions onto the transfers, so it does not need to know about it. */
+    req->aggr_parts = mca_part_persist_aggr_parts(parts, count * dt_size, info);
+    req->real_parts = parts / req->aggr_parts;
+    req->real_count = count * req->aggr_parts;
+    req->aggr_ready = NULL;
+    if (1 < req->aggr_parts) {
+        req->aggr_ready = (opal_atomic_int32_t*) calloc(req->real_parts, sizeof(opal_atomic_int32_t));
+    }
+
     /* non-blocking send set-up data */
     req->setup_info[0].world_rank = ompi_comm_rank(&ompi_mpi_comm_world.comm);
-    req->setup_info[0].start_tag = ompi_part_persist.next_send_tag; ompi_part_persist.next_send_tag += parts; 
+    req->setup_info[0].start_tag = ompi_part_persist.next_send_tag; ompi_part_persist.next_send_tag += req->real_parts; 
     req->my_send_tag = req->setup_info[0].start_tag;
     req->setup_info[0].setup_tag = ompi_part_persist.next_recv_tag; ompi_part_persist.next_recv_tag++;
     req->my_recv_tag = req->setup_info[0].setup_tag;
-    req->setup_info[0].num_parts = parts;
-    req->real_parts = parts;
-    req->setup_info[0].count = count;
-    req->real_count = count;
+    req->setup_info[0].num_parts = req->real_parts;
+    req->setup_info[0].count = req->real_count;
     req->setup_info[0].dt_size = dt_size;
 
     req->flags = (int*) calloc(req->real_parts, sizeof(int));
@@ -495,7 +542,7 @@ mca_part_persist_start(size_t count, ompi_request_t** requests)
 {
     int err = OMPI_SUCCESS;
     size_t _count = count;
-    size_t i;
+    size_t i, p;
 
     for(i = 0; i < _count && OMPI_SUCCESS == err; i++) {
         mca_part_persist_request_t *req = (mca_part_persist_request_t *)(requests[i]);
@@ -504,7 +551,10 @@ mca_part_persist_start(size_t count, ompi_request_t** requests)
         {
             if(MCA_PART_PERSIST_REQUEST_PSEND == req->req_type) {
                 req->done_count = 0;
-                memset((void*)req->flags,0,sizeof(uint32_t)*req->real_parts);
+                /* Partitions are not tested before they are marked ready */
+                for(p = 0; p < req->real_parts; p++) {
+                    req->flags[p] = -1;
+                }
             } else {
                 req->done_count = 0;
                 err = req->persist_reqs[0]->req_start(req->real_parts, req->persist_reqs);
@@ -513,13 +563,16 @@ mca_part_persist_start(size_t count, ompi_request_t** requests)
         } else {
             if(MCA_PART_PERSIST_REQUEST_PSEND == req->req_type) {
                 req->done_count = 0;
-                for(i = 0; i < req->real_parts && OMPI_SUCCESS == err; i++) {
-                    req->flags[i] = -1;
+                for(p = 0; p < req->real_parts; p++) {
+                    req->flags[p] = -1;
                 }
             } else {
                 req->done_count = 0;
             } 
         } 
+        if(NULL != req->aggr_ready) {
+            memset((void*)req->aggr_ready,0,sizeof(opal_atomic_int32_t)*req->real_parts);
+        }
         req->req_ompi.req_state = OMPI_REQUEST_ACTIVE;    
         req->req_ompi.req_status.MPI_TAG = MPI_ANY_TAG;
         req->req_ompi.req_status.MPI_ERROR = OMPI_SUCCESS;
@@ -532,15 +585,18 @@ mca_part_persist_start(size_t count, ompi_request_t** requests)
     return err;
 }
 
+/**
+ * Start the internal partitions min_part to max_part, or queue them for the progress
+ * function if the request is not initialized yet.
+ */
 __opal_attribute_always_inline__ static inline int
-mca_part_persist_pready(size_t min_part,
-                    size_t max_part,
-                    ompi_request_t* request)
+mca_part_persist_start_parts(size_t min_part,
+                         size_t max_part,
+                         mca_part_persist_request_t* req)
 {
     int err = OMPI_SUCCESS;
     size_t i;
 
-    mca_part_persist_request_t *req = (mca_part_persist_request_t *)(request);
     if(true == req->initialized)
     {
         err = req->persist_reqs[min_part]->req_start(max_part-min_part+1, (&(req->persist_reqs[min_part])));
@@ -557,6 +613,41 @@ mca_part_persist_pready(size_t min_part,
     return err;
 }
 
+__opal_attribute_always_inline__ static inline int
+mca_part_persist_pready(size_t min_part,
+                    size_t max_part,
+                    ompi_request_t* request)
+{
+    int err = OMPI_SUCCESS;
+    size_t first, last, lo, hi, i, run = 0;
+
+    mca_part_persist_request_t *req = (mca_part_persist_request_t *)(request);
+    if(1 == req->aggr_parts) {
+        return mca_part_persist_start_parts(min_part, max_part, req);
+    }
+
+    /* An internal partition is sent by the thread that marks its last user partition
+     * ready. Adjacent internal partitions completed by this call are started together. */
+    first = min_part / req->aggr_parts;
+    last = max_part / req->aggr_parts;
+    for(i = first; i <= last && OMPI_SUCCESS == err; i++) {
+        lo = (i == first) ? min_part : i * req->aggr_parts;
+        hi = (i == last) ? max_part : (i + 1) * req->aggr_parts - 1;
+        if((size_t) opal_atomic_add_fetch_32(&req->aggr_ready[i], (int32_t) (hi - lo + 1)) == req->aggr_parts) {
+            run++;
+            continue;
+        }
+        if(0 < run) {
+            err = mca_part_persist_start_parts(i - run, i - 1, req);
+            run = 0;
+        }
+    }
+    if(0 < run && OMPI_SUCCESS == err) {
+        err = mca_part_persist_start_parts(last + 1 - run, last, req);
+    }
+    return err;
+}
+
 __opal_attribute_always_inline__ static inline int
 mca_part_persist_parrived(size_t min_part,
                       size_t max_part,
@@ -575,9 +666,9 @@ mca_part_persist_parrived(size_t min_part,
                 _flag = _flag && req->flags[i];            
             }
         } else {
-            float convert = ((float)req->real_parts) / ((float)req->req_parts);
-            size_t _min = floor(convert * min_part);
-            size_t _max = ceil(convert * max_part);
+            /* the sender's partitions covering our partitions min_part to max_part */
+            size_t _min = (min_part * req->real_parts) / req->req_parts;
+            size_t _max = ((max_part + 1) * req->real_parts - 1) / req->req_parts;
             for(i = _min; i <= _max; i++) {
                 _flag = _flag && req->flags[i];
             }
@@ -85,6 +85,16 @@ mca_part_persist_component_register(void)
                                            MCA_BASE_VAR_SCOPE_READONLY,
                                            &ompi_part_persist.free_list_inc);
 
+    ompi_part_persist.aggregation_size = 0;
+    (void) mca_base_component_var_register(&mca_part_persist_component.partm_version, "aggregation_size",
+                                           "Send adjacent partitions of a partitioned send together, in transfers of "
+                                           "up to this many bytes, once all of them are marked ready. Can be set for "
+                                           "a single request with the \"part_persist_aggregation_size\" info key "
+                                           "(default: 0, every partition is sent on its own)",
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0,
+                                           OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &ompi_part_persist.aggregation_size);
 
     return OPAL_SUCCESS;
 }
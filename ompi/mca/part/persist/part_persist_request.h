@@ -71,6 +71,7 @@ struct mca_part_persist_request_t {
     size_t  req_bytes;                    /**< bytes for completion status */
 
     size_t real_parts;                   /**< internal number of partitions */
+    size_t aggr_parts;                   /**< user partitions per internal partition (send side) */
     size_t real_count;
     size_t real_dt_size;                 /**< receiver needs to know how large the sender's datatype is. */
     size_t part_size; 
@@ -93,6 +94,7 @@ struct mca_part_persist_request_t {
     size_t done_count;             /**< counter for the number of partitions marked ready */
 
     int32_t *flags;               /**< array of flags to determine whether a partition has arrived */
+    opal_atomic_int32_t *aggr_ready; /**< number of user partitions marked ready per internal partition */
 
     struct ompi_mca_persist_setup_t setup_info[2]; /**< Setup info to send during initialization. */
   
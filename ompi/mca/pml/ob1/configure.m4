@@ -22,10 +22,13 @@ AC_DEFUN([MCA_ompi_pml_ob1_POST_CONFIG], [
 # ------------------------------------------------
 # We can always build, unless we were explicitly disabled.
 AC_DEFUN([MCA_ompi_pml_ob1_CONFIG],[
-    OPAL_VAR_SCOPE_PUSH([pml_ob1_matching_engine])
+    OPAL_VAR_SCOPE_PUSH([pml_ob1_matching_engine pml_ob1_check_simd pml_ob1_cflags_save pml_ob1_avx2_support pml_ob1_avx512_support])
     AC_ARG_WITH([pml-ob1-matching], [AS_HELP_STRING([--with-pml-ob1-matching=type],
-                                                    [Configure pml/ob1 to use an alternate matching engine. Only valid on x86_64 systems.
-                                                     Valid values are: none, default, arrays, fuzzy-byte, fuzzy-short, fuzzy-word, vector (default: none)])])
+                                                    [Default matching engine of pml/ob1 (can be changed at run time with
+                                                     the pml_ob1_matching_engine MCA parameter). The vector and fuzzy engines
+                                                     are only available on x86_64 systems.
+                                                     Valid values are: none, default, arrays, fuzzy-byte, fuzzy-short, fuzzy-word,
+                                                     vector, vector-avx2, auto (default: none)])])
 
     pml_ob1_matching_engine=MCA_PML_OB1_CUSTOM_MATCHING_NONE
 
@@ -52,14 +55,114 @@ AC_DEFUN([MCA_ompi_pml_ob1_CONFIG],[
             vector)
                 pml_ob1_matching_engine=MCA_PML_OB1_CUSTOM_MATCHING_VECTOR
                 ;;
+            vector-avx2)
+                pml_ob1_matching_engine=MCA_PML_OB1_CUSTOM_MATCHING_VECTOR_AVX2
+                ;;
+            auto)
+                pml_ob1_matching_engine=MCA_PML_OB1_CUSTOM_MATCHING_AUTO
+                ;;
             *)
                 AC_MSG_ERROR([invalid matching type specified for --pml-ob1-matching: $with_pml_ob1_matching])
                 ;;
         esac
     fi
 
-    AC_DEFINE_UNQUOTED([MCA_PML_OB1_CUSTOM_MATCHING], [$pml_ob1_matching_engine], [Custom matching engine to use in pml/ob1])
+    AC_DEFINE_UNQUOTED([MCA_PML_OB1_CUSTOM_MATCHING], [$pml_ob1_matching_engine], [Default custom matching engine to use in pml/ob1])
+
+    #
+    # The vector engines are built with the flags needed for their
+    # instruction set and only used when the processor supports it.
+    #
+    MCA_BUILD_PML_OB1_AVX2_FLAGS=""
+    MCA_BUILD_PML_OB1_AVX512_FLAGS=""
+    pml_ob1_avx2_support=0
+    pml_ob1_avx512_support=0
+
+    case "${host}" in
+        x86_64-*x32|i?86-*|x86_64*|amd64*)
+            pml_ob1_check_simd="yes";;
+        *)
+            pml_ob1_check_simd="no";;
+    esac
+    AS_IF([test "$pml_ob1_check_simd" = "yes"],
+          [AC_LANG_PUSH([C])
+           AC_MSG_CHECKING([for AVX512 matching support (no additional flags)])
+           AC_LINK_IFELSE(
+               [AC_LANG_PROGRAM([[#include <immintrin.h>]],
+                                [[
+#if defined(__ICC) && !defined(__AVX512BW__)
+#error "icc needs the -m flags to provide the AVX* detection macros"
+#endif
+    __m512i vA = _mm512_set1_epi32(1), vB = _mm512_set1_epi16(2);
+    return (int)(_mm512_cmpeq_epi32_mask(vA, vB) + _mm512_cmpeq_epi16_mask(vA, vB))
+                                ]])],
+               [pml_ob1_avx512_support=1
+                AC_MSG_RESULT([yes])],
+               [AC_MSG_RESULT([no])])
+           AS_IF([test $pml_ob1_avx512_support -eq 0],
+                 [AC_MSG_CHECKING([for AVX512 matching support (with -mavx512f -mavx512bw)])
+                  pml_ob1_cflags_save="$CFLAGS"
+                  CFLAGS="-mavx512f -mavx512bw $CFLAGS"
+                  AC_LINK_IFELSE(
+                      [AC_LANG_PROGRAM([[#include <immintrin.h>]],
+                                       [[
+#if defined(__ICC) && !defined(__AVX512BW__)
+#error "icc needs the -m flags to provide the AVX* detection macros"
+#endif
+    __m512i vA = _mm512_set1_epi32(1), vB = _mm512_set1_epi16(2);
+    return (int)(_mm512_cmpeq_epi32_mask(vA, vB) + _mm512_cmpeq_epi16_mask(vA, vB))
+                                       ]])],
+                      [pml_ob1_avx512_support=1
+                       MCA_BUILD_PML_OB1_AVX512_FLAGS="-mavx512f -mavx512bw"
+                       AC_MSG_RESULT([yes])],
+                      [AC_MSG_RESULT([no])])
+                  CFLAGS="$pml_ob1_cflags_save"])
+
+           AC_MSG_CHECKING([for AVX2 matching support (no additional flags)])
+           AC_LINK_IFELSE(
+               [AC_LANG_PROGRAM([[#include <immintrin.h>]],
+                                [[
+#if defined(__ICC) && !defined(__AVX2__)
+#error "icc needs the -m flags to provide the AVX* detection macros"
+#endif
+    __m256i vA = _mm256_set1_epi32(1), vB = _mm256_set1_epi32(2);
+    return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(vA, vB)))
+                                ]])],
+               [pml_ob1_avx2_support=1
+                AC_MSG_RESULT([yes])],
+               [AC_MSG_RESULT([no])])
+           AS_IF([test $pml_ob1_avx2_support -eq 0],
+                 [AC_MSG_CHECKING([for AVX2 matching support (with -mavx2)])
+                  pml_ob1_cflags_save="$CFLAGS"
+                  CFLAGS="-mavx2 $CFLAGS"
+                  AC_LINK_IFELSE(
+                      [AC_LANG_PROGRAM([[#include <immintrin.h>]],
+                                       [[
+#if defined(__ICC) && !defined(__AVX2__)
+#error "icc needs the -m flags to provide the AVX* detection macros"
+#endif
+    __m256i vA = _mm256_set1_epi32(1), vB = _mm256_set1_epi32(2);
+    return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(vA, vB)))
+                                       ]])],
+                      [pml_ob1_avx2_support=1
+                       MCA_BUILD_PML_OB1_AVX2_FLAGS="-mavx2"
+                       AC_MSG_RESULT([yes])],
+                      [AC_MSG_RESULT([no])])
+                  CFLAGS="$pml_ob1_cflags_save"])
+           AC_LANG_POP([C])])
+
+    AC_DEFINE_UNQUOTED([OMPI_PML_OB1_HAVE_AVX512], [$pml_ob1_avx512_support],
+                       [Whether the AVX512 matching engines of pml/ob1 are built])
+    AC_DEFINE_UNQUOTED([OMPI_PML_OB1_HAVE_AVX2], [$pml_ob1_avx2_support],
+                       [Whether the AVX2 matching engine of pml/ob1 is built])
+    AM_CONDITIONAL([MCA_BUILD_ompi_pml_ob1_has_avx512_support],
+                   [test "$pml_ob1_avx512_support" = "1"])
+    AM_CONDITIONAL([MCA_BUILD_ompi_pml_ob1_has_avx2_support],
+                   [test "$pml_ob1_avx2_support" = "1"])
+    AC_SUBST(MCA_BUILD_PML_OB1_AVX512_FLAGS)
+    AC_SUBST(MCA_BUILD_PML_OB1_AVX2_FLAGS)
 
     AC_CONFIG_FILES([ompi/mca/pml/ob1/Makefile])
+    OPAL_VAR_SCOPE_POP
     [$1]
 ])dnl
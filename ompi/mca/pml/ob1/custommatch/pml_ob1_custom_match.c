@@ -0,0 +1,202 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include <stdint.h>
+
+#include "opal/util/output.h"
+#include "opal/util/show_help.h"
+#include "opal/util/proc.h"
+
+#include "pml_ob1_custom_match.h"
+
+#define MCA_PML_OB1_MATCH_HAS_AVX2_FLAG     0x1
+#define MCA_PML_OB1_MATCH_HAS_AVX512F_FLAG  0x2
+#define MCA_PML_OB1_MATCH_HAS_AVX512BW_FLAG 0x4
+
+extern const mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_linkedlist_ops;
+extern const mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_arrays_ops;
+#if OMPI_PML_OB1_HAVE_AVX2
+extern const mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_vector_avx2_ops;
+#endif
+#if OMPI_PML_OB1_HAVE_AVX512
+extern const mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_fuzzy_byte_ops;
+extern const mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_fuzzy_short_ops;
+extern const mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_fuzzy_word_ops;
+extern const mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_vector_ops;
+#endif
+
+typedef struct mca_pml_ob1_custom_match_engine_t {
+    int type;
+    const char *name;
+    /** processor features the engine needs */
+    uint32_t flags;
+    /** NULL if the engine was not compiled in */
+    const mca_pml_ob1_custom_match_ops_t *ops;
+} mca_pml_ob1_custom_match_engine_t;
+
+static const mca_pml_ob1_custom_match_engine_t mca_pml_ob1_custom_match_engines[] = {
+    {MCA_PML_OB1_CUSTOM_MATCHING_LINKEDLIST, "linkedlist", 0, &mca_pml_ob1_custom_match_linkedlist_ops},
+    {MCA_PML_OB1_CUSTOM_MATCHING_ARRAYS, "arrays", 0, &mca_pml_ob1_custom_match_arrays_ops},
+#if OMPI_PML_OB1_HAVE_AVX512
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_BYTE, "fuzzy-byte",
+     MCA_PML_OB1_MATCH_HAS_AVX512F_FLAG | MCA_PML_OB1_MATCH_HAS_AVX512BW_FLAG,
+     &mca_pml_ob1_custom_match_fuzzy_byte_ops},
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_SHORT, "fuzzy-short",
+     MCA_PML_OB1_MATCH_HAS_AVX512F_FLAG | MCA_PML_OB1_MATCH_HAS_AVX512BW_FLAG,
+     &mca_pml_ob1_custom_match_fuzzy_short_ops},
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_WORD, "fuzzy-word", MCA_PML_OB1_MATCH_HAS_AVX512F_FLAG,
+     &mca_pml_ob1_custom_match_fuzzy_word_ops},
+    {MCA_PML_OB1_CUSTOM_MATCHING_VECTOR, "vector", MCA_PML_OB1_MATCH_HAS_AVX512F_FLAG,
+     &mca_pml_ob1_custom_match_vector_ops},
+#else
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_BYTE, "fuzzy-byte", 0, NULL},
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_SHORT, "fuzzy-short", 0, NULL},
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_WORD, "fuzzy-word", 0, NULL},
+    {MCA_PML_OB1_CUSTOM_MATCHING_VECTOR, "vector", 0, NULL},
+#endif
+#if OMPI_PML_OB1_HAVE_AVX2
+    {MCA_PML_OB1_CUSTOM_MATCHING_VECTOR_AVX2, "vector-avx2", MCA_PML_OB1_MATCH_HAS_AVX2_FLAG,
+     &mca_pml_ob1_custom_match_vector_avx2_ops},
+#else
+    {MCA_PML_OB1_CUSTOM_MATCHING_VECTOR_AVX2, "vector-avx2", 0, NULL},
+#endif
+    {MCA_PML_OB1_CUSTOM_MATCHING_NONE, NULL, 0, NULL},
+};
+
+/* engines tried, in order, by the auto selection */
+static const int mca_pml_ob1_custom_match_auto[] = {
+    MCA_PML_OB1_CUSTOM_MATCHING_VECTOR,
+    MCA_PML_OB1_CUSTOM_MATCHING_VECTOR_AVX2,
+    MCA_PML_OB1_CUSTOM_MATCHING_NONE,
+};
+
+#if OMPI_PML_OB1_HAVE_AVX2 || OMPI_PML_OB1_HAVE_AVX512
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static void run_cpuid(uint32_t eax, uint32_t ecx, uint32_t* abcd)
+{
+#if defined(_MSC_VER)
+    __cpuidex(abcd, eax, ecx);
+#else
+    uint32_t ebx = 0, edx = 0;
+#if defined( __i386__ ) && defined ( __PIC__ )
+    /* in case of PIC under 32-bit EBX cannot be clobbered */
+    __asm__ ( "movl %%ebx, %%edi \n\t cpuid \n\t xchgl %%ebx, %%edi" : "=D" (ebx),
+#else
+    __asm__ ( "cpuid" : "+b" (ebx),
+#endif  /* defined( __i386__ ) && defined ( __PIC__ ) */
+              "+a" (eax), "+c" (ecx), "=d" (edx) );
+    abcd[0] = eax; abcd[1] = ebx; abcd[2] = ecx; abcd[3] = edx;
+#endif
+}
+
+static uint32_t mca_pml_ob1_custom_match_cpu_flags(void)
+{
+    const uint32_t avx512f_mask   = (1U << 16);  // AVX512F   (EAX = 7, ECX = 0) : EBX
+    const uint32_t avx512_bw_mask = (1U << 30);  // AVX512BW  (EAX = 7, ECX = 0) : EBX
+    const uint32_t avx2_mask      = (1U << 5);   // AVX2      (EAX = 7, ECX = 0) : EBX
+    const uint32_t osxsave_mask   = (1U << 27);  // OSXSAVE   (EAX = 1, ECX = 0) : ECX
+    uint32_t flags = 0, abcd[4];
+
+    run_cpuid( 0, 0, abcd );
+    if (abcd[0] < 7) {
+        return 0;
+    }
+
+    /* the OS has to save the extended registers across context switches */
+    run_cpuid( 1, 0, abcd );
+    if (!(abcd[2] & osxsave_mask)) {
+        return 0;
+    }
+
+    run_cpuid( 7, 0, abcd );
+    flags |= (abcd[1] & avx512f_mask)   ? MCA_PML_OB1_MATCH_HAS_AVX512F_FLAG  : 0;
+    flags |= (abcd[1] & avx512_bw_mask) ? MCA_PML_OB1_MATCH_HAS_AVX512BW_FLAG : 0;
+    flags |= (abcd[1] & avx2_mask)      ? MCA_PML_OB1_MATCH_HAS_AVX2_FLAG     : 0;
+    return flags;
+}
+
+#else
+
+static uint32_t mca_pml_ob1_custom_match_cpu_flags(void)
+{
+    return 0;
+}
+
+#endif  /* OMPI_PML_OB1_HAVE_AVX2 || OMPI_PML_OB1_HAVE_AVX512 */
+
+static const mca_pml_ob1_custom_match_engine_t *mca_pml_ob1_custom_match_lookup (int type)
+{
+    for (int i = 0 ; NULL != mca_pml_ob1_custom_match_engines[i].name ; ++i) {
+        if (type == mca_pml_ob1_custom_match_engines[i].type) {
+            return mca_pml_ob1_custom_match_engines + i;
+        }
+    }
+
+    return NULL;
+}
+
+static bool mca_pml_ob1_custom_match_usable (const mca_pml_ob1_custom_match_engine_t *engine, uint32_t cpu_flags)
+{
+    return NULL != engine && NULL != engine->ops && (engine->flags & cpu_flags) == engine->flags;
+}
+
+const mca_pml_ob1_custom_match_ops_t *mca_pml_ob1_custom_match_select (int type)
+{
+    const mca_pml_ob1_custom_match_engine_t *engine;
+    uint32_t cpu_flags;
+
+    if (MCA_PML_OB1_CUSTOM_MATCHING_NONE == type) {
+        return NULL;
+    }
+
+    cpu_flags = mca_pml_ob1_custom_match_cpu_flags ();
+
+    if (MCA_PML_OB1_CUSTOM_MATCHING_AUTO == type) {
+        for (int i = 0 ; MCA_PML_OB1_CUSTOM_MATCHING_NONE != mca_pml_ob1_custom_match_auto[i] ; ++i) {
+            engine = mca_pml_ob1_custom_match_lookup (mca_pml_ob1_custom_match_auto[i]);
+            if (mca_pml_ob1_custom_match_usable (engine, cpu_flags)) {
+                return engine->ops;
+            }
+        }
+
+        return NULL;
+    }
+
+    engine = mca_pml_ob1_custom_match_lookup (type);
+    if (!mca_pml_ob1_custom_match_usable (engine, cpu_flags)) {
+        opal_show_help ("help-mpi-pml-ob1.txt", "matching_engine_unavailable", true,
+                        opal_process_info.nodename, NULL != engine ? engine->name : "unknown",
+                        (NULL != engine && NULL == engine->ops) ? "was not compiled in" :
+                        "needs instructions that this processor does not support");
+        return NULL;
+    }
+
+    return engine->ops;
+}
+
+const char *mca_pml_ob1_custom_match_name (const mca_pml_ob1_custom_match_ops_t *ops)
+{
+    if (NULL == ops) {
+        return "none";
+    }
+
+    for (int i = 0 ; NULL != mca_pml_ob1_custom_match_engines[i].name ; ++i) {
+        if (ops == mca_pml_ob1_custom_match_engines[i].ops) {
+            return mca_pml_ob1_custom_match_engines[i].name;
+        }
+    }
+
+    return "unknown";
+}
@@ -15,13 +15,12 @@
 #define PML_OB1_CUSTOM_MATCH_H
 
 #include "ompi_config.h"
-#include "ompi/mca/pml/ob1/pml_ob1.h"
 
-#define CUSTOM_MATCH_DEBUG         1
-#define CUSTOM_MATCH_DEBUG_VERBOSE 1
+#define CUSTOM_MATCH_DEBUG         0
+#define CUSTOM_MATCH_DEBUG_VERBOSE 0
 
 /**
- * Custom match types
+ * Custom match types (values of the pml_ob1_matching_engine MCA parameter)
  */
 #define MCA_PML_OB1_CUSTOM_MATCHING_NONE        0
 #define MCA_PML_OB1_CUSTOM_MATCHING_LINKEDLIST  1
@@ -30,29 +29,69 @@
 #define MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_SHORT 4
 #define MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_WORD  5
 #define MCA_PML_OB1_CUSTOM_MATCHING_VECTOR      6
+#define MCA_PML_OB1_CUSTOM_MATCHING_VECTOR_AVX2 7
+#define MCA_PML_OB1_CUSTOM_MATCHING_AUTO        8
 
-#if MCA_PML_OB1_CUSTOM_MATCHING != MCA_PML_OB1_CUSTOM_MATCHING_NONE
-
-#define MCA_PML_OB1_CUSTOM_MATCH 1
-
-#if MCA_PML_OB1_CUSTOM_MATCHING == MCA_PML_OB1_CUSTOM_MATCHING_LINKEDLIST
-#include "pml_ob1_custom_match_linkedlist.h"
-#elif MCA_PML_OB1_CUSTOM_MATCHING == MCA_PML_OB1_CUSTOM_MATCHING_ARRAYS
-#include "pml_ob1_custom_match_arrays.h"
-#elif MCA_PML_OB1_CUSTOM_MATCHING == MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_BYTE
-#include "pml_ob1_custom_match_fuzzy512-byte.h"
-#elif MCA_PML_OB1_CUSTOM_MATCHING == MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_SHORT
-#include "pml_ob1_custom_match_fuzzy512-short.h"
-#elif MCA_PML_OB1_CUSTOM_MATCHING == MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_WORD
-#include "pml_ob1_custom_match_fuzzy512-word.h"
-#elif MCA_PML_OB1_CUSTOM_MATCHING == MCA_PML_OB1_CUSTOM_MATCHING_VECTOR
-#include "pml_ob1_custom_match_vectors.h"
-#endif
+BEGIN_C_DECLS
+
+/**
+ * Position of a fragment found in the unexpected queue. It is filled by
+ * umq_find_verify_hold and handed back to umq_remove_hold once the
+ * fragment has been consumed.
+ */
+struct mca_pml_ob1_custom_match_hold_t {
+    void *prev;
+    void *elem;
+    int index;
+};
+typedef struct mca_pml_ob1_custom_match_hold_t mca_pml_ob1_custom_match_hold_t;
 
-#else
+/**
+ * Matching engine interface. The posted receive queue (prq) holds
+ * receive requests and the unexpected message queue (umq) holds receive
+ * fragments; both are kept per communicator and are only accessed with
+ * the communicator matching lock held.
+ */
+struct mca_pml_ob1_custom_match_ops_t {
+    void *(*prq_init) (void);
+    void (*prq_destroy) (void *prq);
+    int (*prq_cancel) (void *prq, void *req);
+    void *(*prq_find_dequeue_verify) (void *prq, int tag, int peer);
+    void (*prq_append) (void *prq, void *req, int tag, int source);
+    int (*prq_size) (void *prq);
+    void (*prq_dump) (void *prq);
 
-#define MCA_PML_OB1_CUSTOM_MATCH 0
+    void *(*umq_init) (void);
+    void (*umq_destroy) (void *umq);
+    void *(*umq_find_verify_hold) (void *umq, int tag, int peer, mca_pml_ob1_custom_match_hold_t *hold);
+    void (*umq_remove_hold) (void *umq, mca_pml_ob1_custom_match_hold_t *hold);
+    void (*umq_append) (void *umq, int tag, int source, void *frag);
+    int (*umq_size) (void *umq);
+    /** remove the fragments for which purge returns true, in queue order */
+    void (*umq_purge) (void *umq, int (*purge) (void *frag, void *ctx), void *ctx);
+    void (*umq_dump) (void *umq);
+};
+typedef struct mca_pml_ob1_custom_match_ops_t mca_pml_ob1_custom_match_ops_t;
 
-#endif
+/**
+ * Select the matching engine to use.
+ *
+ * @param engine  one of the MCA_PML_OB1_CUSTOM_MATCHING_* values
+ *
+ * @returns the ops of the selected engine or NULL if the native ob1
+ *          matching lists should be used
+ *
+ * Engines that were not compiled in, or that need instructions the
+ * processor does not provide, are never returned. The AUTO value picks
+ * the widest vector engine the processor supports.
+ */
+const mca_pml_ob1_custom_match_ops_t *mca_pml_ob1_custom_match_select (int engine);
+
+/**
+ * Name of a matching engine (for output)
+ */
+const char *mca_pml_ob1_custom_match_name (const mca_pml_ob1_custom_match_ops_t *ops);
+
+END_C_DECLS
 
 #endif
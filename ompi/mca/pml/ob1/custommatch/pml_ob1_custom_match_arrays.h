@@ -14,8 +14,6 @@
 #ifndef PML_OB1_CUSTOM_MATCH_ARRAYS_H
 #define PML_OB1_CUSTOM_MATCH_ARRAYS_H
 
-#include <immintrin.h>
-
 #include "../pml_ob1_recvreq.h"
 #include "../pml_ob1_recvfrag.h"
 
@@ -193,7 +191,9 @@ static inline void custom_match_prq_append(custom_match_prq* list, void* payload
     }
     if(tag == OMPI_ANY_TAG)
     {
-        mask_tag = 0;
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        mask_tag = INT32_MIN;
+        tag = 0;
     }
     else
     {
@@ -390,7 +390,9 @@ static inline void* custom_match_umq_find_verify_hold(custom_match_umq* list, in
 
     if(tag == OMPI_ANY_TAG)
     {
-        tmask = 0;
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        tmask = INT32_MIN;
+        tag = 0;
     }
 
 
@@ -550,6 +552,32 @@ static inline int custom_match_umq_size(custom_match_umq* list)
     return list->size;
 }
 
+/* remove the fragments for which purge returns true, in queue order */
+static inline void custom_match_umq_purge(custom_match_umq* list, int (*purge)(void*, void*), void* ctx)
+{
+    custom_match_umq_node* prev = 0;
+    custom_match_umq_node* elem = list->head;
+    custom_match_umq_node* next;
+    int i;
+    while(elem)
+    {
+        next = elem->next;
+        for(i = elem->start; i <= elem->end; i++)
+        {
+            if(elem->value[i] && purge(elem->value[i], ctx))
+            {
+                custom_match_umq_remove_hold(list, prev, elem, i);
+            }
+        }
+        /* a node emptied by the removals went back to the pool */
+        if(elem->start <= elem->end)
+        {
+            prev = elem;
+        }
+        elem = next;
+    }
+}
+
 static inline void custom_match_umq_dump(custom_match_umq* list)
 {
     char cpeer[64], ctag[64];
@@ -0,0 +1,125 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Instantiate the ops table of one matching engine. All engines use the
+ * same custom_match_* names so each one is built in its own translation
+ * unit: include the engine header, define MCA_PML_OB1_CUSTOM_MATCH_ENGINE
+ * to the engine name and include this file. The table is exported as
+ * mca_pml_ob1_custom_match_<engine>_ops.
+ */
+
+#ifndef MCA_PML_OB1_CUSTOM_MATCH_ENGINE
+#error "MCA_PML_OB1_CUSTOM_MATCH_ENGINE must be defined before including this file"
+#endif
+
+#define MCA_PML_OB1_CUSTOM_MATCH_OPS_NAME2(engine) mca_pml_ob1_custom_match_ ## engine ## _ops
+#define MCA_PML_OB1_CUSTOM_MATCH_OPS_NAME(engine) MCA_PML_OB1_CUSTOM_MATCH_OPS_NAME2(engine)
+
+static void *engine_prq_init (void)
+{
+    return (void *) custom_match_prq_init ();
+}
+
+static void engine_prq_destroy (void *prq)
+{
+    custom_match_prq_destroy ((custom_match_prq *) prq);
+}
+
+static int engine_prq_cancel (void *prq, void *req)
+{
+    return custom_match_prq_cancel ((custom_match_prq *) prq, req);
+}
+
+static void *engine_prq_find_dequeue_verify (void *prq, int tag, int peer)
+{
+    return custom_match_prq_find_dequeue_verify ((custom_match_prq *) prq, tag, peer);
+}
+
+static void engine_prq_append (void *prq, void *req, int tag, int source)
+{
+    custom_match_prq_append ((custom_match_prq *) prq, req, tag, source);
+}
+
+static int engine_prq_size (void *prq)
+{
+    return custom_match_prq_size ((custom_match_prq *) prq);
+}
+
+static void engine_prq_dump (void *prq)
+{
+    custom_match_prq_dump ((custom_match_prq *) prq);
+}
+
+static void *engine_umq_init (void)
+{
+    return (void *) custom_match_umq_init ();
+}
+
+static void engine_umq_destroy (void *umq)
+{
+    custom_match_umq_destroy ((custom_match_umq *) umq);
+}
+
+static void *engine_umq_find_verify_hold (void *umq, int tag, int peer, mca_pml_ob1_custom_match_hold_t *hold)
+{
+    custom_match_umq_node *prev = NULL, *elem = NULL;
+    void *frag;
+
+    frag = custom_match_umq_find_verify_hold ((custom_match_umq *) umq, tag, peer, &prev, &elem,
+                                              &hold->index);
+    hold->prev = (void *) prev;
+    hold->elem = (void *) elem;
+
+    return frag;
+}
+
+static void engine_umq_remove_hold (void *umq, mca_pml_ob1_custom_match_hold_t *hold)
+{
+    custom_match_umq_remove_hold ((custom_match_umq *) umq, (custom_match_umq_node *) hold->prev,
+                                  (custom_match_umq_node *) hold->elem, hold->index);
+}
+
+static void engine_umq_append (void *umq, int tag, int source, void *frag)
+{
+    custom_match_umq_append ((custom_match_umq *) umq, tag, source, frag);
+}
+
+static int engine_umq_size (void *umq)
+{
+    return custom_match_umq_size ((custom_match_umq *) umq);
+}
+
+static void engine_umq_purge (void *umq, int (*purge) (void *frag, void *ctx), void *ctx)
+{
+    custom_match_umq_purge ((custom_match_umq *) umq, purge, ctx);
+}
+
+static void engine_umq_dump (void *umq)
+{
+    custom_match_umq_dump ((custom_match_umq *) umq);
+}
+
+const mca_pml_ob1_custom_match_ops_t MCA_PML_OB1_CUSTOM_MATCH_OPS_NAME(MCA_PML_OB1_CUSTOM_MATCH_ENGINE) = {
+    .prq_init = engine_prq_init,
+    .prq_destroy = engine_prq_destroy,
+    .prq_cancel = engine_prq_cancel,
+    .prq_find_dequeue_verify = engine_prq_find_dequeue_verify,
+    .prq_append = engine_prq_append,
+    .prq_size = engine_prq_size,
+    .prq_dump = engine_prq_dump,
+    .umq_init = engine_umq_init,
+    .umq_destroy = engine_umq_destroy,
+    .umq_find_verify_hold = engine_umq_find_verify_hold,
+    .umq_remove_hold = engine_umq_remove_hold,
+    .umq_append = engine_umq_append,
+    .umq_size = engine_umq_size,
+    .umq_purge = engine_umq_purge,
+    .umq_dump = engine_umq_dump,
+};
@@ -109,7 +109,7 @@ static inline void* custom_match_prq_find_verify(custom_match_prq* list, int tag
                 if((0x1 << i & result) && elem->value[i])
                 {
                     mca_pml_base_request_t *req = (mca_pml_base_request_t *)elem->value[i];
-                    if((req->req_peer == peer || req->req_peer == OMPI_ANY_SOURCE) && (req->req_tag == tag || req->req_tag == OMPI_ANY_TAG))
+                    if((req->req_peer == peer || req->req_peer == OMPI_ANY_SOURCE) && (req->req_tag == tag || (req->req_tag == OMPI_ANY_TAG && tag >= 0)))
                     {
 #if CUSTOM_MATCH_DEBUG_VERBOSE
                         printf("Found list: %x tag: %x peer: %x\n", list, req->req_tag, req->req_peer);
@@ -150,7 +150,7 @@ static inline void* custom_match_prq_find_dequeue_verify(custom_match_prq* list,
             for(i = elem->start; i <= elem->end; i++)
             {
                 mca_pml_base_request_t *req = (mca_pml_base_request_t *)elem->value[i];
-                if((0x1 << i & result) && req && ((req->req_peer == peer || req->req_peer == OMPI_ANY_SOURCE) && (req->req_tag == tag || req->req_tag == OMPI_ANY_TAG)))
+                if((0x1 << i & result) && req && ((req->req_peer == peer || req->req_peer == OMPI_ANY_SOURCE) && (req->req_tag == tag || (req->req_tag == OMPI_ANY_TAG && tag >= 0))))
                 {
                     void* payload = elem->value[i];
                     ((int*)(&(elem->keys)))[i] = ~0;
@@ -417,7 +417,7 @@ static inline void* custom_match_umq_find_verify_hold(custom_match_umq* list, in
                 if((0x1 << i & result) && elem->value[i])
                 {
                     mca_pml_ob1_recv_frag_t *req = (mca_pml_ob1_recv_frag_t *)elem->value[i];
-                    if((req->hdr.hdr_match.hdr_src == peer || peer == OMPI_ANY_SOURCE) && (req->hdr.hdr_match.hdr_tag == tag || tag == OMPI_ANY_TAG))
+                    if((req->hdr.hdr_match.hdr_src == peer || peer == OMPI_ANY_SOURCE) && (req->hdr.hdr_match.hdr_tag == tag || (tag == OMPI_ANY_TAG && req->hdr.hdr_match.hdr_tag >= 0)))
                     {
 #if CUSTOM_MATCH_DEBUG_VERBOSE
                         printf("Found list: %x tag: %x peer: %x\n", list, req->hdr.hdr_match.hdr_tag, req->hdr.hdr_match.hdr_src);
@@ -568,6 +568,32 @@ static inline int custom_match_umq_size(custom_match_umq* list)
     return list->size;
 }
 
+/* remove the fragments for which purge returns true, in queue order */
+static inline void custom_match_umq_purge(custom_match_umq* list, int (*purge)(void*, void*), void* ctx)
+{
+    custom_match_umq_node* prev = 0;
+    custom_match_umq_node* elem = list->head;
+    custom_match_umq_node* next;
+    int i;
+    while(elem)
+    {
+        next = elem->next;
+        for(i = elem->start; i <= elem->end; i++)
+        {
+            if(elem->value[i] && purge(elem->value[i], ctx))
+            {
+                custom_match_umq_remove_hold(list, prev, elem, i);
+            }
+        }
+        /* a node emptied by the removals went back to the pool */
+        if(elem->start <= elem->end)
+        {
+            prev = elem;
+        }
+        elem = next;
+    }
+}
+
 static inline void custom_match_umq_dump(custom_match_umq* list)
 {
     char cpeer[64], ctag[64];
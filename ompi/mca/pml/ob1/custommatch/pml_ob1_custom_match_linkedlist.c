@@ -0,0 +1,16 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "ompi_config.h"
+
+#include "pml_ob1_custom_match.h"
+#include "pml_ob1_custom_match_linkedlist.h"
+
+#define MCA_PML_OB1_CUSTOM_MATCH_ENGINE linkedlist
+#include "pml_ob1_custom_match_engine.h"
@@ -162,7 +162,9 @@ static inline void custom_match_prq_append(custom_match_prq* list, void* payload
     }
     if(tag == OMPI_ANY_TAG)
     {
-        mask_tag = 0;
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        mask_tag = INT32_MIN;
+        tag = 0;
     }
     else
     {
@@ -342,7 +344,9 @@ static inline void* custom_match_umq_find_verify_hold(custom_match_umq* list, in
 
     if(tag == OMPI_ANY_TAG)
     {
-        tmask = 0;
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        tmask = INT32_MIN;
+        tag = 0;
     }
 
     tag = tag & tmask;
@@ -490,6 +494,27 @@ static inline int custom_match_umq_size(custom_match_umq* list)
     return list->size;
 }
 
+/* remove the fragments for which purge returns true, in queue order */
+static inline void custom_match_umq_purge(custom_match_umq* list, int (*purge)(void*, void*), void* ctx)
+{
+    custom_match_umq_node* prev = 0;
+    custom_match_umq_node* elem = list->head;
+    custom_match_umq_node* next;
+    while(elem)
+    {
+        next = elem->next;
+        if(purge(elem->value, ctx))
+        {
+            custom_match_umq_remove_hold(list, prev, elem, 0);
+        }
+        else
+        {
+            prev = elem;
+        }
+        elem = next;
+    }
+}
+
 static inline void custom_match_umq_dump(custom_match_umq* list)
 {
     char cpeer[64], ctag[64];
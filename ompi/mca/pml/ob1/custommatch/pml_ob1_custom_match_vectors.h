@@ -152,7 +152,7 @@ static inline void* custom_match_prq_find_dequeue_verify(custom_match_prq* list,
             for(i = elem->start; i <= elem->end; i++)
             {
                 mca_pml_base_request_t *req = (mca_pml_base_request_t *)elem->value[i];
-                if((0x1 << i & result) && req && ((req->req_peer == peer || req->req_peer == OMPI_ANY_SOURCE) && (req->req_tag == tag || req->req_tag == OMPI_ANY_TAG)))
+                if((0x1 << i & result) && req && ((req->req_peer == peer || req->req_peer == OMPI_ANY_SOURCE) && (req->req_tag == tag || (req->req_tag == OMPI_ANY_TAG && tag >= 0))))
                 {
                     void* payload = elem->value[i];
                     ((int*)(&(elem->tags)))[i] = ~0;
@@ -210,7 +210,9 @@ static inline void custom_match_prq_append(custom_match_prq* list, void* payload
     }
     if(tag == OMPI_ANY_TAG)
     {
-        mask_tag = 0;
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        mask_tag = INT32_MIN;
+        tag = 0;
     }
     else
     {
@@ -394,8 +396,6 @@ static inline void* custom_match_umq_find_verify_hold(custom_match_umq* list, in
     custom_match_umq_node* prev = 0;
     custom_match_umq_node* elem = list->head;
     int i;
-    __m512i tsearch = _mm512_set1_epi32(tag);
-    __m512i ssearch = _mm512_set1_epi32(peer);
 
     int tmask = ~0;
     int smask = ~0;
@@ -406,14 +406,15 @@ static inline void* custom_match_umq_find_verify_hold(custom_match_umq* list, in
 
     if(tag == OMPI_ANY_TAG)
     {
-        tmask = 0;
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        tmask = INT32_MIN;
+        tag = 0;
     }
 
     __m512i tmasks = _mm512_set1_epi32(tmask);
     __m512i smasks = _mm512_set1_epi32(smask);
-
-    tsearch = _mm512_and_epi32(tsearch, tmasks);
-    ssearch = _mm512_and_epi32(ssearch, smasks);
+    __m512i tsearch = _mm512_and_epi32(_mm512_set1_epi32(tag), tmasks);
+    __m512i ssearch = _mm512_and_epi32(_mm512_set1_epi32(peer), smasks);
 
     while(elem)
     {
@@ -564,6 +565,32 @@ static inline int custom_match_umq_size(custom_match_umq* list)
     return list->size;
 }
 
+/* remove the fragments for which purge returns true, in queue order */
+static inline void custom_match_umq_purge(custom_match_umq* list, int (*purge)(void*, void*), void* ctx)
+{
+    custom_match_umq_node* prev = 0;
+    custom_match_umq_node* elem = list->head;
+    custom_match_umq_node* next;
+    int i;
+    while(elem)
+    {
+        next = elem->next;
+        for(i = elem->start; i <= elem->end; i++)
+        {
+            if(elem->value[i] && purge(elem->value[i], ctx))
+            {
+                custom_match_umq_remove_hold(list, prev, elem, i);
+            }
+        }
+        /* a node emptied by the removals went back to the pool */
+        if(elem->start <= elem->end)
+        {
+            prev = elem;
+        }
+        elem = next;
+    }
+}
+
 static inline void custom_match_umq_dump(custom_match_umq* list)
 {
     char cpeer[64], ctag[64];
@@ -0,0 +1,501 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * AVX2 version of the vectors matching engine: each queue node holds 8
+ * tag/source pairs (and their wildcard masks) that are compared with the
+ * searched envelope in a single pass.
+ */
+
+#ifndef PML_OB1_CUSTOM_MATCH_VECTORS256_H
+#define PML_OB1_CUSTOM_MATCH_VECTORS256_H
+
+#include <immintrin.h>
+
+#include "../pml_ob1_recvreq.h"
+#include "../pml_ob1_recvfrag.h"
+
+#define CUSTOM_MATCH_VECTORS256_WIDTH 8
+
+typedef struct custom_match_prq_node
+{
+    __m256i tags;
+    __m256i tmask;
+    __m256i srcs;
+    __m256i smask;
+    struct custom_match_prq_node* next;
+    int start, end;
+    void* value[CUSTOM_MATCH_VECTORS256_WIDTH];
+} custom_match_prq_node;
+
+typedef struct custom_match_prq
+{
+    custom_match_prq_node* head;
+    custom_match_prq_node* tail;
+    custom_match_prq_node* pool;
+    int size;
+} custom_match_prq;
+
+/* bit i of the result is set if lane i of a matches lane i of b */
+static inline int custom_match_vectors256_cmpeq(__m256i a, __m256i b)
+{
+    return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+}
+
+static inline void custom_match_prq_unlink(custom_match_prq* list, custom_match_prq_node* prev,
+                                           custom_match_prq_node* elem, int i)
+{
+    ((int*)(&(elem->tags)))[i] = ~0;
+    ((int*)(&(elem->tmask)))[i] = ~0;
+    ((int*)(&(elem->srcs)))[i] = ~0;
+    ((int*)(&(elem->smask)))[i] = ~0;
+    elem->value[i] = 0;
+    if(i == elem->start || i == elem->end)
+    {
+        while((elem->start <= elem->end) && (!(elem->value[elem->start]))) elem->start++;
+        while((elem->start <= elem->end) && (!(elem->value[elem->end])))   elem->end--;
+        if(elem->start > elem->end)
+        {
+            if(prev)
+            {
+                prev->next = elem->next;
+            }
+            else
+            {
+                list->head = elem->next;
+            }
+            if(!elem->next)
+            {
+                list->tail = prev;
+            }
+            elem->next = list->pool;
+            list->pool = elem;
+        }
+    }
+    list->size--;
+}
+
+static inline int custom_match_prq_cancel(custom_match_prq* list, void* req)
+{
+    custom_match_prq_node* prev = 0;
+    custom_match_prq_node* elem = list->head;
+    int i;
+
+    while(elem)
+    {
+        for(i = elem->start; i <= elem->end; i++)
+        {
+            if(elem->value[i] == req)
+            {
+                custom_match_prq_unlink(list, prev, elem, i);
+                return 1;
+            }
+        }
+        prev = elem;
+        elem = elem->next;
+    }
+    return 0;
+}
+
+static inline void* custom_match_prq_find_verify(custom_match_prq* list, int tag, int peer)
+{
+    custom_match_prq_node* elem = list->head;
+    __m256i tsearch = _mm256_set1_epi32(tag);
+    __m256i ssearch = _mm256_set1_epi32(peer);
+    int result, i;
+
+    while(elem)
+    {
+        result = custom_match_vectors256_cmpeq(_mm256_and_si256(elem->tags, elem->tmask),
+                                               _mm256_and_si256(tsearch, elem->tmask)) &
+            custom_match_vectors256_cmpeq(_mm256_and_si256(elem->srcs, elem->smask),
+                                          _mm256_and_si256(ssearch, elem->smask));
+        if(result)
+        {
+            for(i = elem->start; i <= elem->end; i++)
+            {
+                if((0x1 << i & result) && elem->value[i])
+                {
+                    return elem->value[i];
+                }
+            }
+        }
+        elem = elem->next;
+    }
+    return 0;
+}
+
+static inline void* custom_match_prq_find_dequeue_verify(custom_match_prq* list, int tag, int peer)
+{
+    custom_match_prq_node* prev = 0;
+    custom_match_prq_node* elem = list->head;
+    __m256i tsearch = _mm256_set1_epi32(tag);
+    __m256i ssearch = _mm256_set1_epi32(peer);
+    int result, i;
+
+    while(elem)
+    {
+        result = custom_match_vectors256_cmpeq(_mm256_and_si256(elem->tags, elem->tmask),
+                                               _mm256_and_si256(tsearch, elem->tmask)) &
+            custom_match_vectors256_cmpeq(_mm256_and_si256(elem->srcs, elem->smask),
+                                          _mm256_and_si256(ssearch, elem->smask));
+        if(result)
+        {
+            for(i = elem->start; i <= elem->end; i++)
+            {
+                if((0x1 << i & result) && elem->value[i])
+                {
+                    void* payload = elem->value[i];
+                    custom_match_prq_unlink(list, prev, elem, i);
+                    return payload;
+                }
+            }
+        }
+        prev = elem;
+        elem = elem->next;
+    }
+    return 0;
+}
+
+static inline void custom_match_prq_append(custom_match_prq* list, void* payload, int tag, int source)
+{
+    int32_t mask_tag = ~0, mask_src = ~0;
+    custom_match_prq_node* elem;
+    int i;
+
+    if(source == OMPI_ANY_SOURCE)
+    {
+        mask_src = 0;
+    }
+    if(tag == OMPI_ANY_TAG)
+    {
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        mask_tag = INT32_MIN;
+        tag = 0;
+    }
+
+    if((!list->tail) || list->tail->end == CUSTOM_MATCH_VECTORS256_WIDTH - 1)
+    {
+        if(list->pool)
+        {
+            elem = list->pool;
+            list->pool = list->pool->next;
+        }
+        else
+        {
+            elem = _mm_malloc(sizeof(custom_match_prq_node), 32);
+        }
+        elem->tags = _mm256_set1_epi32(~0);
+        elem->tmask = _mm256_set1_epi32(~0);
+        elem->srcs = _mm256_set1_epi32(~0);
+        elem->smask = _mm256_set1_epi32(~0);
+        elem->next = 0;
+        elem->start = 0;
+        elem->end = -1; // we don't have an element yet
+        for(i = 0; i < CUSTOM_MATCH_VECTORS256_WIDTH; i++) elem->value[i] = 0;
+        if(list->tail)
+        {
+            list->tail->next = elem;
+            list->tail = elem;
+        }
+        else
+        {
+            list->head = elem;
+            list->tail = elem;
+        }
+    }
+
+    elem = list->tail;
+    elem->end++;
+    ((int*)(&(elem->tags)))[elem->end] = tag;
+    ((int*)(&(elem->tmask)))[elem->end] = mask_tag;
+    ((int*)(&(elem->srcs)))[elem->end] = source;
+    ((int*)(&(elem->smask)))[elem->end] = mask_src;
+    elem->value[elem->end] = payload;
+    list->size++;
+}
+
+static inline int custom_match_prq_size(custom_match_prq* list)
+{
+    return list->size;
+}
+
+static inline custom_match_prq* custom_match_prq_init(void)
+{
+    custom_match_prq* list = malloc(sizeof(custom_match_prq));
+    list->head = 0;
+    list->tail = 0;
+    list->pool = 0;
+    list->size = 0;
+    return list;
+}
+
+static inline void custom_match_prq_destroy(custom_match_prq* list)
+{
+    custom_match_prq_node* elem;
+
+    while(list->head)
+    {
+        elem = list->head;
+        list->head = list->head->next;
+        _mm_free(elem);
+    }
+    while(list->pool)
+    {
+        elem = list->pool;
+        list->pool = list->pool->next;
+        _mm_free(elem);
+    }
+    free(list);
+}
+
+static inline void custom_match_prq_dump(custom_match_prq* list)
+{
+    char cpeer[64], ctag[64];
+
+    for(custom_match_prq_node* elem = list->head; elem; elem = elem->next)
+    {
+        for(int j = elem->start; j <= elem->end; j++)
+        {
+            if(elem->value[j])
+            {
+                mca_pml_base_request_t *req = (mca_pml_base_request_t *)elem->value[j];
+                if( OMPI_ANY_SOURCE == req->req_peer ) snprintf(cpeer, 64, "%s", "ANY_SOURCE");
+                else snprintf(cpeer, 64, "%d", req->req_peer);
+                if( OMPI_ANY_TAG == req->req_tag ) snprintf(ctag, 64, "%s", "ANY_TAG");
+                else snprintf(ctag, 64, "%d", req->req_tag);
+                opal_output(0, "req %p peer %s tag %s addr %p count %lu datatype %s [%p] [%s %s] req_seq %" PRIu64,
+                            (void*) req, cpeer, ctag,
+                            (void*) req->req_addr, req->req_count,
+                            (0 != req->req_count ? req->req_datatype->name : "N/A"),
+                            (void*) req->req_datatype,
+                            (req->req_pml_complete ? "pml_complete" : ""),
+                            (req->req_free_called ? "freed" : ""),
+                            req->req_sequence);
+            }
+        }
+    }
+}
+
+
+// UMQ below.
+
+typedef struct custom_match_umq_node
+{
+    __m256i tags;
+    __m256i srcs;
+    struct custom_match_umq_node* next;
+    int start, end;
+    void* value[CUSTOM_MATCH_VECTORS256_WIDTH];
+} custom_match_umq_node;
+
+typedef struct custom_match_umq
+{
+    custom_match_umq_node* head;
+    custom_match_umq_node* tail;
+    custom_match_umq_node* pool;
+    int size;
+} custom_match_umq;
+
+static inline void* custom_match_umq_find_verify_hold(custom_match_umq* list, int tag, int peer, custom_match_umq_node** hold_prev, custom_match_umq_node** hold_elem, int* hold_index)
+{
+    custom_match_umq_node* prev = 0;
+    custom_match_umq_node* elem = list->head;
+    int tmask = ~0, smask = ~0;
+    int result, i;
+
+    if(peer == OMPI_ANY_SOURCE)
+    {
+        smask = 0;
+    }
+    if(tag == OMPI_ANY_TAG)
+    {
+        /* MPI_ANY_TAG never matches the negative (internal) tags */
+        tmask = INT32_MIN;
+        tag = 0;
+    }
+
+    __m256i tmasks = _mm256_set1_epi32(tmask);
+    __m256i smasks = _mm256_set1_epi32(smask);
+    __m256i tsearch = _mm256_set1_epi32(tag & tmask);
+    __m256i ssearch = _mm256_set1_epi32(peer & smask);
+
+    while(elem)
+    {
+        result = custom_match_vectors256_cmpeq(_mm256_and_si256(elem->tags, tmasks), tsearch) &
+            custom_match_vectors256_cmpeq(_mm256_and_si256(elem->srcs, smasks), ssearch);
+        if(result)
+        {
+            for(i = elem->start; i <= elem->end; i++)
+            {
+                if((0x1 << i & result) && elem->value[i])
+                {
+                    *hold_prev = prev;
+                    *hold_elem = elem;
+                    *hold_index = i;
+                    return elem->value[i];
+                }
+            }
+        }
+        prev = elem;
+        elem = elem->next;
+    }
+    return 0;
+}
+
+static inline void custom_match_umq_remove_hold(custom_match_umq* list, custom_match_umq_node* prev, custom_match_umq_node* elem, int i)
+{
+    ((int*)(&(elem->tags)))[i] = ~0;
+    ((int*)(&(elem->srcs)))[i] = ~0;
+    elem->value[i] = 0;
+    if(i == elem->start || i == elem->end)
+    {
+        while((elem->start <= elem->end) && (!(elem->value[elem->start]))) elem->start++;
+        while((elem->start <= elem->end) && (!(elem->value[elem->end])))   elem->end--;
+        if(elem->start > elem->end)
+        {
+            if(prev)
+            {
+                prev->next = elem->next;
+            }
+            else
+            {
+                list->head = elem->next;
+            }
+            if(!elem->next)
+            {
+                list->tail = prev;
+            }
+            elem->next = list->pool;
+            list->pool = elem;
+        }
+    }
+    list->size--;
+}
+
+static inline void custom_match_umq_append(custom_match_umq* list, int tag, int source, void* payload)
+{
+    custom_match_umq_node* elem;
+    int i;
+
+    list->size++;
+    if((!list->tail) || list->tail->end == CUSTOM_MATCH_VECTORS256_WIDTH - 1)
+    {
+        if(list->pool)
+        {
+            elem = list->pool;
+            list->pool = list->pool->next;
+        }
+        else
+        {
+            elem = _mm_malloc(sizeof(custom_match_umq_node), 32);
+        }
+        elem->tags = _mm256_set1_epi32(~0);
+        elem->srcs = _mm256_set1_epi32(~0);
+        elem->next = 0;
+        elem->start = 0;
+        elem->end = -1; // we don't have an element yet
+        for(i = 0; i < CUSTOM_MATCH_VECTORS256_WIDTH; i++) elem->value[i] = 0;
+        if(list->tail)
+        {
+            list->tail->next = elem;
+            list->tail = elem;
+        }
+        else
+        {
+            list->head = elem;
+            list->tail = elem;
+        }
+    }
+
+    elem = list->tail;
+    elem->end++;
+    ((int*)(&(elem->tags)))[elem->end] = tag;
+    ((int*)(&(elem->srcs)))[elem->end] = source;
+    elem->value[elem->end] = payload;
+}
+
+static inline custom_match_umq* custom_match_umq_init(void)
+{
+    custom_match_umq* list = malloc(sizeof(custom_match_umq));
+    list->head = 0;
+    list->tail = 0;
+    list->pool = 0;
+    list->size = 0;
+    return list;
+}
+
+static inline void custom_match_umq_destroy(custom_match_umq* list)
+{
+    custom_match_umq_node* elem;
+
+    while(list->head)
+    {
+        elem = list->head;
+        list->head = list->head->next;
+        _mm_free(elem);
+    }
+    while(list->pool)
+    {
+        elem = list->pool;
+        list->pool = list->pool->next;
+        _mm_free(elem);
+    }
+    free(list);
+}
+
+static inline int custom_match_umq_size(custom_match_umq* list)
+{
+    return list->size;
+}
+
+/* remove the fragments for which purge returns true, in queue order */
+static inline void custom_match_umq_purge(custom_match_umq* list, int (*purge)(void*, void*), void* ctx)
+{
+    custom_match_umq_node* prev = 0;
+    custom_match_umq_node* elem = list->head;
+    custom_match_umq_node* next;
+    int i;
+    while(elem)
+    {
+        next = elem->next;
+        for(i = elem->start; i <= elem->end; i++)
+        {
+            if(elem->value[i] && purge(elem->value[i], ctx))
+            {
+                custom_match_umq_remove_hold(list, prev, elem, i);
+            }
+        }
+        /* a node emptied by the removals went back to the pool */
+        if(elem->start <= elem->end)
+        {
+            prev = elem;
+        }
+        elem = next;
+    }
+}
+
+static inline void custom_match_umq_dump(custom_match_umq* list)
+{
+    for(custom_match_umq_node* elem = list->head; elem; elem = elem->next)
+    {
+        for(int j = elem->start; j <= elem->end; j++)
+        {
+            if(elem->value[j])
+            {
+                mca_pml_ob1_recv_frag_t *frag = (mca_pml_ob1_recv_frag_t *)elem->value[j];
+                opal_output(0, "frag %p peer %d tag %d seq %d", (void*) frag,
+                            frag->hdr.hdr_match.hdr_src, frag->hdr.hdr_match.hdr_tag,
+                            (int) frag->hdr.hdr_match.hdr_seq);
+            }
+        }
+    }
+}
+
+#endif
@@ -44,6 +44,7 @@
 #include "ompi/proc/proc.h"
 #include "opal/mca/allocator/base/base.h"
 #include "ompi/runtime/mpiruntime.h"
+#include "custommatch/pml_ob1_custom_match.h"
 
 BEGIN_C_DECLS
 
@@ -88,6 +89,10 @@ struct mca_pml_ob1_t {
     unsigned int unexpected_limit;
     /* Accelerator support initialized */
     bool accelerator_enabled;
+    /* requested matching engine (MCA_PML_OB1_CUSTOM_MATCHING_*) */
+    int matching_engine;
+    /* selected matching engine, NULL when the ob1 matching lists are used */
+    const mca_pml_ob1_custom_match_ops_t *match_ops;
 };
 typedef struct mca_pml_ob1_t mca_pml_ob1_t;
 
@@ -39,20 +39,16 @@ static void mca_pml_ob1_comm_proc_construct(mca_pml_ob1_comm_proc_t* proc)
     proc->frags_cant_match = NULL;
     /* don't know the index of this communicator yet */
     proc->comm_index = -1;
-#if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_CONSTRUCT(&proc->specific_receives, opal_list_t);
     OBJ_CONSTRUCT(&proc->unexpected_frags, opal_list_t);
-#endif
 }
 
 
 static void mca_pml_ob1_comm_proc_destruct(mca_pml_ob1_comm_proc_t* proc)
 {
     assert(NULL == proc->frags_cant_match);
-#if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_DESTRUCT(&proc->specific_receives);
     OBJ_DESTRUCT(&proc->unexpected_frags);
-#endif
     if (proc->ompi_proc) {
         OBJ_RELEASE(proc->ompi_proc);
     }
@@ -66,12 +62,14 @@ OBJ_CLASS_INSTANCE(mca_pml_ob1_comm_proc_t, opal_object_t,
 
 static void mca_pml_ob1_comm_construct(mca_pml_ob1_comm_t* comm)
 {
-#if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_CONSTRUCT(&comm->wild_receives, opal_list_t);
-#else
-    comm->prq = custom_match_prq_init();
-    comm->umq = custom_match_umq_init();
-#endif
+    if (NULL != mca_pml_ob1.match_ops) {
+        comm->prq = mca_pml_ob1.match_ops->prq_init();
+        comm->umq = mca_pml_ob1.match_ops->umq_init();
+    } else {
+        comm->prq = NULL;
+        comm->umq = NULL;
+    }
     OBJ_CONSTRUCT(&comm->matching_lock, opal_mutex_t);
     OBJ_CONSTRUCT(&comm->proc_lock, opal_mutex_t);
     comm->recv_sequence = 0;
@@ -93,12 +91,13 @@ static void mca_pml_ob1_comm_destruct(mca_pml_ob1_comm_t* comm)
         free ((void *) comm->procs);
     }
 
-#if !MCA_PML_OB1_CUSTOM_MATCH
     OBJ_DESTRUCT(&comm->wild_receives);
-#else
-    custom_match_prq_destroy(comm->prq);
-    custom_match_umq_destroy(comm->umq);
-#endif
+    if (NULL != comm->prq) {
+        mca_pml_ob1.match_ops->prq_destroy(comm->prq);
+    }
+    if (NULL != comm->umq) {
+        mca_pml_ob1.match_ops->umq_destroy(comm->umq);
+    }
     OBJ_DESTRUCT(&comm->matching_lock);
     OBJ_DESTRUCT(&comm->proc_lock);
 }
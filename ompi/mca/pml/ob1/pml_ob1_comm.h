@@ -31,14 +31,9 @@
 #include "ompi/proc/proc.h"
 #include "ompi/communicator/communicator.h"
 
-/* NTH: at some point we need to untangle the headers. this declaration is needed
- * for headers included by the custom match code. */
-typedef struct mca_pml_ob1_comm_proc_t mca_pml_ob1_comm_proc_t;
-
-#include "custommatch/pml_ob1_custom_match.h"
-
 BEGIN_C_DECLS
 
+typedef struct mca_pml_ob1_comm_proc_t mca_pml_ob1_comm_proc_t;
 
 struct mca_pml_ob1_comm_proc_t {
     opal_object_t super;
@@ -47,10 +42,8 @@ struct mca_pml_ob1_comm_proc_t {
     int16_t comm_index;           /**< index of this communicator on the receiver size (-1 - not set) */
     opal_atomic_int32_t send_sequence; /**< send side sequence number */
     struct mca_pml_ob1_recv_frag_t* frags_cant_match;  /**< out-of-order fragment queues */
-#if !MCA_PML_OB1_CUSTOM_MATCH
-    opal_list_t specific_receives; /**< queues of unmatched specific receives */
-    opal_list_t unexpected_frags;  /**< unexpected fragment queues */
-#endif
+    opal_list_t specific_receives; /**< queues of unmatched specific receives (unused with a custom matching engine) */
+    opal_list_t unexpected_frags;  /**< unexpected fragment queues (unused with a custom matching engine) */
 };
 
 OBJ_CLASS_DECLARATION(mca_pml_ob1_comm_proc_t);
@@ -65,17 +58,13 @@ struct mca_pml_comm_t {
     opal_object_t super;
     volatile uint32_t recv_sequence;  /**< recv request sequence number - receiver side */
     opal_mutex_t matching_lock;   /**< matching lock */
-#if !MCA_PML_OB1_CUSTOM_MATCH
     opal_list_t wild_receives;    /**< queue of unmatched wild (source process not specified) receives */
-#endif
     opal_mutex_t proc_lock;
     mca_pml_ob1_comm_proc_t * volatile * procs;
     size_t num_procs;
     size_t last_probed;
-#if MCA_PML_OB1_CUSTOM_MATCH
-    custom_match_prq* prq;
-    custom_match_umq* umq;
-#endif
+    void *prq;                    /**< posted receive queue of the custom matching engine */
+    void *umq;                    /**< unexpected message queue of the custom matching engine */
 };
 typedef struct mca_pml_comm_t mca_pml_ob1_comm_t;
 
@@ -156,12 +156,12 @@ static int mca_pml_ob1_get_unex_msgq_size (const struct mca_base_pvar_t *pvar, v
     for (i = 0 ; i < comm_size ; ++i) {
         pml_proc = pml_comm->procs[i];
         if (pml_proc) {
-#if MCA_PML_OB1_CUSTOM_MATCH
-            values[i] = custom_match_umq_size(pml_comm->umq); // TODO: given the structure of custom match this does not make sense,
-                                                     //       as we only have one set of queues.
-#else
-            values[i] = opal_list_get_size (&pml_proc->unexpected_frags);
-#endif
+            if (NULL != mca_pml_ob1.match_ops) {
+                values[i] = mca_pml_ob1.match_ops->umq_size(pml_comm->umq); // TODO: given the structure of custom match this does not make sense,
+                                                                            //       as we only have one set of queues.
+            } else {
+                values[i] = opal_list_get_size (&pml_proc->unexpected_frags);
+            }
         } else {
             values[i] = 0;
         }
@@ -183,12 +183,12 @@ static int mca_pml_ob1_get_posted_recvq_size (const struct mca_base_pvar_t *pvar
         pml_proc = pml_comm->procs[i];
 
         if (pml_proc) {
-#if MCA_PML_OB1_CUSTOM_MATCH
-            values[i] = custom_match_prq_size(pml_comm->prq); // TODO: given the structure of custom match this does not make sense,
-                                                     //       as we only have one set of queues.
-#else
-            values[i] = opal_list_get_size (&pml_proc->specific_receives);
-#endif
+            if (NULL != mca_pml_ob1.match_ops) {
+                values[i] = mca_pml_ob1.match_ops->prq_size(pml_comm->prq); // TODO: given the structure of custom match this does not make sense,
+                                                                            //       as we only have one set of queues.
+            } else {
+                values[i] = opal_list_get_size (&pml_proc->specific_receives);
+            }
         } else {
             values[i] = 0;
         }
@@ -197,8 +197,23 @@ static int mca_pml_ob1_get_posted_recvq_size (const struct mca_base_pvar_t *pvar
     return OMPI_SUCCESS;
 }
 
+static mca_base_var_enum_value_t mca_pml_ob1_matching_engines[] = {
+    {MCA_PML_OB1_CUSTOM_MATCHING_NONE, "none"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_LINKEDLIST, "linkedlist"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_ARRAYS, "arrays"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_BYTE, "fuzzy-byte"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_SHORT, "fuzzy-short"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_FUZZY_WORD, "fuzzy-word"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_VECTOR, "vector"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_VECTOR_AVX2, "vector-avx2"},
+    {MCA_PML_OB1_CUSTOM_MATCHING_AUTO, "auto"},
+    {0, NULL}
+};
+
 static int mca_pml_ob1_component_register(void)
 {
+    mca_base_var_enum_t *new_enum;
+
     mca_pml_ob1_param_register_int("verbose", 0, &mca_pml_ob1_verbose);
 
     mca_pml_ob1_param_register_int("free_list_num", 4, &mca_pml_ob1.free_list_num);
@@ -250,6 +265,20 @@ static int mca_pml_ob1_component_register(void)
                                            MCA_BASE_VAR_TYPE_INT, NULL, 0, 0, OPAL_INFO_LVL_5,
                                            MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1_accelerator_events_max);
 
+    mca_pml_ob1.matching_engine = MCA_PML_OB1_CUSTOM_MATCHING;
+    (void) mca_base_var_enum_create("pml_ob1_matching_engines", mca_pml_ob1_matching_engines, &new_enum);
+    (void) mca_base_component_var_register(&mca_pml_ob1_component.pmlm_version, "matching_engine",
+                                           "Engine used to match incoming messages with posted receives. \"none\" "
+                                           "uses the ob1 per-peer lists, which are the fastest with short queues. "
+                                           "The vector engines compare several entries per instruction (AVX-512 "
+                                           "for \"vector\" and the fuzzy engines, AVX2 for \"vector-avx2\") and "
+                                           "scale better with thousands of posted or unexpected messages. \"auto\" "
+                                           "selects the widest vector engine supported by the processor. Engines "
+                                           "that cannot run on this processor fall back to \"none\"",
+                                           MCA_BASE_VAR_TYPE_INT, new_enum, 0, 0, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_READONLY, &mca_pml_ob1.matching_engine);
+    OBJ_RELEASE(new_enum);
+
     return OMPI_SUCCESS;
 }
 
@@ -326,6 +355,10 @@ mca_pml_ob1_component_init( int* priority,
     /** this pml supports the extended CID space */
     mca_pml_ob1.super.pml_flags |= MCA_PML_BASE_FLAG_SUPPORTS_EXT_CID;
 
+    mca_pml_ob1.match_ops = mca_pml_ob1_custom_match_select(mca_pml_ob1.matching_engine);
+    opal_output_verbose( 10, mca_pml_ob1_output, "in ob1, using the %s matching engine",
+                         mca_pml_ob1_custom_match_name(mca_pml_ob1.match_ops));
+
     return &mca_pml_ob1.super;
 }
 
@@ -88,10 +88,8 @@ append_frag_to_list(opal_list_t *queue, mca_btl_base_module_t *btl,
     opal_list_append(queue, (opal_list_item_t*)frag);
 }
 
-#if MCA_PML_OB1_CUSTOM_MATCH
-
 static void
-append_frag_to_umq(custom_match_umq *queue, mca_btl_base_module_t *btl,
+append_frag_to_umq(void *queue, mca_btl_base_module_t *btl,
                    const mca_pml_ob1_match_hdr_t *hdr, const mca_btl_base_segment_t *segments,
                    size_t num_segments, mca_pml_ob1_recv_frag_t* frag)
 {
@@ -99,11 +97,9 @@ append_frag_to_umq(custom_match_umq *queue, mca_btl_base_module_t *btl,
     MCA_PML_OB1_RECV_FRAG_ALLOC(frag);
     MCA_PML_OB1_RECV_FRAG_INIT(frag, hdr, segments, num_segments, btl);
   }
-  custom_match_umq_append(queue, hdr->hdr_tag, hdr->hdr_src, frag);
+  mca_pml_ob1.match_ops->umq_append(queue, hdr->hdr_tag, hdr->hdr_src, frag);
 }
 
-#endif
-
 
 /**
  * Append an unexpected descriptor to an ordered queue.
@@ -336,6 +332,24 @@ static inline int pml_ob1_frag_is_revoked(ompi_communicator_t* ompi_comm, mca_pm
          || (ompi_comm_coll_revoked(ompi_comm) && ompi_request_tag_is_collective(hdr->hdr_match.hdr_tag)));
 }
 
+struct pml_ob1_revoke_purge_t {
+    struct ompi_communicator_t* ompi_comm;
+    opal_list_t* nack_list;
+};
+
+/* umq_purge callback of the custom matching engines */
+static int pml_ob1_revoke_purge_frag(void* item, void* ctx)
+{
+    struct pml_ob1_revoke_purge_t* purge = (struct pml_ob1_revoke_purge_t*)ctx;
+    mca_pml_ob1_recv_frag_t* frag = (mca_pml_ob1_recv_frag_t*)item;
+
+    if( !pml_ob1_frag_is_revoked(purge->ompi_comm, frag) ) {
+        return 0;
+    }
+    opal_list_append(purge->nack_list, &frag->super.super);
+    return 1;
+}
+
 int mca_pml_ob1_revoke_comm( struct ompi_communicator_t* ompi_comm, bool coll_only )
 {
     mca_pml_ob1_comm_t* comm = ompi_comm->c_pml_comm;
@@ -363,6 +377,13 @@ int mca_pml_ob1_revoke_comm( struct ompi_communicator_t* ompi_comm, bool coll_on
     }
 #endif /* OPAL_ENABLE_DEBUG */
 
+    /* the custom matching engines keep the unexpected frags of all the
+     * procs in one queue */
+    if( NULL != mca_pml_ob1.match_ops ) {
+        struct pml_ob1_revoke_purge_t purge = { .ompi_comm = ompi_comm, .nack_list = &nack_list };
+        mca_pml_ob1.match_ops->umq_purge(comm->umq, pml_ob1_revoke_purge_frag, &purge);
+    }
+
     /* loop over all procs in that comm */
     for (i = 0; i < comm->num_procs; i++) {
         proc = comm->procs[i];
@@ -864,7 +885,6 @@ static mca_pml_ob1_recv_request_t *match_incomming(const mca_pml_ob1_match_hdr_t
                                                    mca_pml_ob1_comm_t *comm,
                                                    mca_pml_ob1_comm_proc_t *proc)
 {
-#if !MCA_PML_OB1_CUSTOM_MATCH
     mca_pml_ob1_recv_request_t *specific_recv, *wild_recv;
     mca_pml_sequence_t wild_recv_seq, specific_recv_seq;
     int tag = hdr->hdr_tag;
@@ -907,12 +927,8 @@ static mca_pml_ob1_recv_request_t *match_incomming(const mca_pml_ob1_match_hdr_t
     }
 
     return NULL;
-#else
-    return custom_match_prq_find_dequeue_verify(comm->prq, hdr->hdr_tag, hdr->hdr_src);
-#endif
 }
 
-#if !MCA_PML_OB1_CUSTOM_MATCH
 static mca_pml_ob1_recv_request_t *match_incomming_no_any_source (const mca_pml_ob1_match_hdr_t *hdr,
                                                                   mca_pml_ob1_comm_t *comm,
                                                                   mca_pml_ob1_comm_proc_t *proc)
@@ -933,7 +949,6 @@ static mca_pml_ob1_recv_request_t *match_incomming_no_any_source (const mca_pml_
 
     return NULL;
 }
-#endif
 
 static mca_pml_ob1_recv_request_t *match_one (mca_btl_base_module_t *btl,
                                               const mca_pml_ob1_match_hdr_t *hdr,
@@ -949,17 +964,16 @@ static mca_pml_ob1_recv_request_t *match_one (mca_btl_base_module_t *btl,
 
     mca_pml_ob1_recv_request_t *match;
     mca_pml_ob1_comm_t *comm = (mca_pml_ob1_comm_t *)comm_ptr->c_pml_comm;
+    const mca_pml_ob1_custom_match_ops_t *match_ops = mca_pml_ob1.match_ops;
 
     do {
-#if MCA_PML_OB1_CUSTOM_MATCH
-        match = match_incomming(hdr, comm, proc);
-#else
-        if (!OMPI_COMM_CHECK_ASSERT_NO_ANY_SOURCE (comm_ptr)) {
+        if (NULL != match_ops) {
+            match = match_ops->prq_find_dequeue_verify(comm->prq, hdr->hdr_tag, hdr->hdr_src);
+        } else if (!OMPI_COMM_CHECK_ASSERT_NO_ANY_SOURCE (comm_ptr)) {
             match = match_incomming(hdr, comm, proc);
         } else {
             match = match_incomming_no_any_source (hdr, comm, proc);
         }
-#endif
 
         /* if match found, process data */
         if(OPAL_LIKELY(NULL != match)) {
@@ -999,13 +1013,13 @@ static mca_pml_ob1_recv_request_t *match_one (mca_btl_base_module_t *btl,
         }
 
         /* if no match found, place on unexpected queue */
-#if MCA_PML_OB1_CUSTOM_MATCH
-        append_frag_to_umq(comm->umq, btl, hdr, segments,
-                            num_segments, frag);
-#else
-        append_frag_to_list(&proc->unexpected_frags, btl, hdr, segments,
-                            num_segments, frag);
-#endif
+        if (NULL != match_ops) {
+            append_frag_to_umq(comm->umq, btl, hdr, segments,
+                               num_segments, frag);
+        } else {
+            append_frag_to_list(&proc->unexpected_frags, btl, hdr, segments,
+                                num_segments, frag);
+        }
         SPC_RECORD(OMPI_SPC_UNEXPECTED, 1);
         SPC_RECORD(OMPI_SPC_UNEXPECTED_IN_QUEUE, 1);
         SPC_UPDATE_WATERMARK(OMPI_SPC_MAX_UNEXPECTED_IN_QUEUE, OMPI_SPC_UNEXPECTED_IN_QUEUE);
@@ -108,16 +108,14 @@ static int mca_pml_ob1_recv_request_cancel(struct ompi_request_t* ompi_request,
     }
     if( !request->req_match_received ) { /* the match has not been already done */
         assert( OMPI_ANY_TAG == ompi_request->req_status.MPI_TAG ); /* not matched isn't it */
-#if MCA_PML_OB1_CUSTOM_MATCH
-        custom_match_prq_cancel(ob1_comm->prq, request);
-#else
-        if( request->req_recv.req_base.req_peer == OMPI_ANY_SOURCE ) {
+        if (NULL != mca_pml_ob1.match_ops) {
+            mca_pml_ob1.match_ops->prq_cancel(ob1_comm->prq, request);
+        } else if( request->req_recv.req_base.req_peer == OMPI_ANY_SOURCE ) {
             opal_list_remove_item( &ob1_comm->wild_receives, (opal_list_item_t*)request );
         } else {
             mca_pml_ob1_comm_proc_t* proc = mca_pml_ob1_peer_lookup (comm, request->req_recv.req_base.req_peer);
             opal_list_remove_item(&proc->specific_receives, (opal_list_item_t*)request);
         }
-#endif
         PERUSE_TRACE_COMM_EVENT( PERUSE_COMM_REQ_REMOVE_FROM_POSTED_Q,
                                 &(request->req_recv.req_base), PERUSE_RECV );
         OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
@@ -1134,24 +1132,22 @@ static inline void append_recv_req_to_queue(opal_list_t *queue,
  *  function has to be called with the communicator matching lock held.
 */
 
-#if MCA_PML_OB1_CUSTOM_MATCH
 static mca_pml_ob1_recv_frag_t*
 recv_req_match_specific_proc( const mca_pml_ob1_recv_request_t *req,
                               mca_pml_ob1_comm_proc_t *proc,
-                              custom_match_umq_node** hold_prev,
-                              custom_match_umq_node** hold_elem,
-                              int* hold_index)
-#else
-static mca_pml_ob1_recv_frag_t*
-recv_req_match_specific_proc( const mca_pml_ob1_recv_request_t *req,
-                              mca_pml_ob1_comm_proc_t *proc )
-#endif
+                              mca_pml_ob1_custom_match_hold_t *hold )
 {
     if (NULL == proc) {
         return NULL;
     }
 
-#if !MCA_PML_OB1_CUSTOM_MATCH
+    if (NULL != mca_pml_ob1.match_ops) {
+        return mca_pml_ob1.match_ops->umq_find_verify_hold(req->req_recv.req_base.req_comm->c_pml_comm->umq,
+                                                           req->req_recv.req_base.req_tag,
+                                                           req->req_recv.req_base.req_peer,
+                                                           hold);
+    }
+
     int tag = req->req_recv.req_base.req_tag;
     opal_list_t* unexpected_frags = &proc->unexpected_frags;
     mca_pml_ob1_recv_frag_t* frag;
@@ -1172,50 +1168,35 @@ recv_req_match_specific_proc( const mca_pml_ob1_recv_request_t *req,
         }
     }
     return NULL;
-#else
-    return custom_match_umq_find_verify_hold(req->req_recv.req_base.req_comm->c_pml_comm->umq,
-                                             req->req_recv.req_base.req_tag,
-                                             req->req_recv.req_base.req_peer,
-                                             hold_prev, hold_elem, hold_index);
-#endif
 }
 
 /*
  * this routine is used to try and match a wild posted receive - where
  * wild is determined by the value assigned to the source process
 */
-#if MCA_PML_OB1_CUSTOM_MATCH
 static mca_pml_ob1_recv_frag_t*
 recv_req_match_wild( mca_pml_ob1_recv_request_t* req,
                      mca_pml_ob1_comm_proc_t **p,
-                     custom_match_umq_node** hold_prev,
-                     custom_match_umq_node** hold_elem,
-                     int* hold_index)
-#else
-static mca_pml_ob1_recv_frag_t*
-recv_req_match_wild( mca_pml_ob1_recv_request_t* req,
-                     mca_pml_ob1_comm_proc_t **p)
-#endif
+                     mca_pml_ob1_custom_match_hold_t *hold )
 {
     mca_pml_ob1_comm_t *comm = (mca_pml_ob1_comm_t *) req->req_recv.req_base.req_comm->c_pml_comm;
     mca_pml_ob1_comm_proc_t **procp = (mca_pml_ob1_comm_proc_t **) comm->procs;
 
-#if MCA_PML_OB1_CUSTOM_MATCH
-    mca_pml_ob1_recv_frag_t* frag;
-    frag = custom_match_umq_find_verify_hold (comm->umq, req->req_recv.req_base.req_tag,
-                                              req->req_recv.req_base.req_peer,
-                                              hold_prev, hold_elem, hold_index);
+    if (NULL != mca_pml_ob1.match_ops) {
+        mca_pml_ob1_recv_frag_t* frag;
+        frag = mca_pml_ob1.match_ops->umq_find_verify_hold (comm->umq, req->req_recv.req_base.req_tag,
+                                                            req->req_recv.req_base.req_peer, hold);
 
-    if (frag) {
-        *p = procp[frag->hdr.hdr_match.hdr_src];
-        req->req_recv.req_base.req_proc = procp[frag->hdr.hdr_match.hdr_src]->ompi_proc;
-        prepare_recv_req_converter(req);
-    } else {
-        *p = NULL;
-    }
+        if (frag) {
+            *p = procp[frag->hdr.hdr_match.hdr_src];
+            req->req_recv.req_base.req_proc = procp[frag->hdr.hdr_match.hdr_src]->ompi_proc;
+            prepare_recv_req_converter(req);
+        } else {
+            *p = NULL;
+        }
 
-    return frag;
-#else
+        return frag;
+    }
 
     /*
      * Loop over all the outstanding messages to find one that matches.
@@ -1229,7 +1210,7 @@ recv_req_match_wild( mca_pml_ob1_recv_request_t* req,
         mca_pml_ob1_recv_frag_t* frag;
 
         /* loop over messages from the current proc */
-        if((frag = recv_req_match_specific_proc(req, procp[i]))) {
+        if((frag = recv_req_match_specific_proc(req, procp[i], NULL))) {
             *p = procp[i];
             comm->last_probed = i;
             req->req_recv.req_base.req_proc = procp[i]->ompi_proc;
@@ -1241,7 +1222,7 @@ recv_req_match_wild( mca_pml_ob1_recv_request_t* req,
         mca_pml_ob1_recv_frag_t* frag;
 
         /* loop over messages from the current proc */
-        if((frag = recv_req_match_specific_proc(req, procp[i]))) {
+        if((frag = recv_req_match_specific_proc(req, procp[i], NULL))) {
             *p = procp[i];
             comm->last_probed = i;
             req->req_recv.req_base.req_proc = procp[i]->ompi_proc;
@@ -1252,7 +1233,6 @@ recv_req_match_wild( mca_pml_ob1_recv_request_t* req,
 
     *p = NULL;
     return NULL;
-#endif
 }
 
 
@@ -1263,13 +1243,8 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
     mca_pml_ob1_comm_proc_t* proc;
     mca_pml_ob1_recv_frag_t* frag;
     mca_pml_ob1_hdr_t* hdr;
-#if MCA_PML_OB1_CUSTOM_MATCH
-    custom_match_umq_node* hold_prev;
-    custom_match_umq_node* hold_elem;
-    int hold_index;
-#else
+    mca_pml_ob1_custom_match_hold_t hold;
     opal_list_t *queue;
-#endif
 
     /* init/re-init the request */
     req->req_lock = 0;
@@ -1317,12 +1292,8 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
 
     /* attempt to match posted recv */
     if(req->req_recv.req_base.req_peer == OMPI_ANY_SOURCE) {
-#if MCA_PML_OB1_CUSTOM_MATCH
-        frag = recv_req_match_wild(req, &proc, &hold_prev, &hold_elem, &hold_index);
-#else
-        frag = recv_req_match_wild(req, &proc);
+        frag = recv_req_match_wild(req, &proc, &hold);
         queue = &ob1_comm->wild_receives;
-#endif
 #if !OPAL_ENABLE_HETEROGENEOUS_SUPPORT
         /* As we are in a homogeneous environment we know that all remote
          * architectures are exactly the same as the local one. Therefore,
@@ -1337,12 +1308,8 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
     } else {
         proc = mca_pml_ob1_peer_lookup (comm, req->req_recv.req_base.req_peer);
         req->req_recv.req_base.req_proc = proc->ompi_proc;
-#if MCA_PML_OB1_CUSTOM_MATCH
-        frag = recv_req_match_specific_proc(req, proc, &hold_prev, &hold_elem, &hold_index);
-#else
-        frag = recv_req_match_specific_proc(req, proc);
+        frag = recv_req_match_specific_proc(req, proc, &hold);
         queue = &proc->specific_receives;
-#endif
         /* wildcard recv will be prepared on match */
         prepare_recv_req_converter(req);
     }
@@ -1353,14 +1320,15 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
         /* We didn't find any matches.  Record this irecv so we can match
            it when the message comes in. */
         if(OPAL_LIKELY(req->req_recv.req_base.req_type != MCA_PML_REQUEST_IPROBE &&
-                       req->req_recv.req_base.req_type != MCA_PML_REQUEST_IMPROBE))
-#if MCA_PML_OB1_CUSTOM_MATCH
-            custom_match_prq_append(ob1_comm->prq, req,
-                                    req->req_recv.req_base.req_tag,
-                                    req->req_recv.req_base.req_peer);
-#else
-            append_recv_req_to_queue(queue, req);
-#endif
+                       req->req_recv.req_base.req_type != MCA_PML_REQUEST_IMPROBE)) {
+            if (NULL != mca_pml_ob1.match_ops) {
+                mca_pml_ob1.match_ops->prq_append(ob1_comm->prq, req,
+                                                  req->req_recv.req_base.req_tag,
+                                                  req->req_recv.req_base.req_peer);
+            } else {
+                append_recv_req_to_queue(queue, req);
+            }
+        }
         req->req_match_received = false;
         OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
     } else {
@@ -1378,12 +1346,12 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
             PERUSE_TRACE_COMM_EVENT(PERUSE_COMM_SEARCH_UNEX_Q_END,
                                     &(req->req_recv.req_base), PERUSE_RECV);
 
-#if MCA_PML_OB1_CUSTOM_MATCH
-            custom_match_umq_remove_hold(req->req_recv.req_base.req_comm->c_pml_comm->umq, hold_prev, hold_elem, hold_index);
-#else
-            opal_list_remove_item(&proc->unexpected_frags,
-                                  (opal_list_item_t*)frag);
-#endif
+            if (NULL != mca_pml_ob1.match_ops) {
+                mca_pml_ob1.match_ops->umq_remove_hold(ob1_comm->umq, &hold);
+            } else {
+                opal_list_remove_item(&proc->unexpected_frags,
+                                      (opal_list_item_t*)frag);
+            }
             SPC_RECORD(OMPI_SPC_UNEXPECTED_IN_QUEUE, -1);
             OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
 
@@ -1414,12 +1382,12 @@ void mca_pml_ob1_recv_req_start(mca_pml_ob1_recv_request_t *req)
                "recreated" as a receive request, and the frag will be
                restarted with this request during mrecv */
 
-#if MCA_PML_OB1_CUSTOM_MATCH
-            custom_match_umq_remove_hold(req->req_recv.req_base.req_comm->c_pml_comm->umq, hold_prev, hold_elem, hold_index);
-#else
-            opal_list_remove_item(&proc->unexpected_frags,
-                                  (opal_list_item_t*)frag);
-#endif
+            if (NULL != mca_pml_ob1.match_ops) {
+                mca_pml_ob1.match_ops->umq_remove_hold(ob1_comm->umq, &hold);
+            } else {
+                opal_list_remove_item(&proc->unexpected_frags,
+                                      (opal_list_item_t*)frag);
+            }
             SPC_RECORD(OMPI_SPC_UNEXPECTED_IN_QUEUE, -1);
             OB1_MATCHING_UNLOCK(&ob1_comm->matching_lock);
 
@@ -27,6 +27,7 @@
 #define MCA_SHAREDFP_sm_H
 
 #include "ompi_config.h"
+#include "opal/sys/atomic.h"
 #include "ompi/mca/mca.h"
 #include "ompi/mca/sharedfp/sharedfp.h"
 #include "ompi/mca/common/ompio/common_ompio.h"
@@ -106,9 +107,19 @@ int mca_sharedfp_sm_iwrite (ompio_file_t *fh,
 /*--------------------------------------------------------------*
  *Structures and definitions only for this component
  *--------------------------------------------------------------*/
+
+/* The shared file pointer is updated with an atomic fetch-and-add if
+ * 64-bit atomics are lock-free, and thus work on memory shared between
+ * processes. Otherwise the offset is protected by the semaphore. */
+#if defined(__GCC_ATOMIC_LLONG_LOCK_FREE) && (2 == __GCC_ATOMIC_LLONG_LOCK_FREE)
+#define SHAREDFP_SM_ATOMIC_OFFSET 1
+#else
+#define SHAREDFP_SM_ATOMIC_OFFSET 0
+#endif
+
 struct mca_sharedfp_sm_offset{
     sem_t mutex;      /* the mutex: a POSIX memory-based unnamed semaphore */
-    long long offset;  /* and the shared file pointer offset */
+    opal_atomic_int64_t offset;  /* and the shared file pointer offset */
 };
 
 /*This structure will hang off of the mca_sharedfp_base_data_t's
@@ -132,6 +143,8 @@ typedef struct mca_sharedfp_sm_data sm_data_global;
 int mca_sharedfp_sm_request_position (ompio_file_t *fh,
                                       long long bytes_requested,
                                       OMPI_MPI_OFFSET_TYPE * offset);
+void mca_sharedfp_sm_set_position (struct mca_sharedfp_sm_data *sm_data,
+                                   OMPI_MPI_OFFSET_TYPE offset);
 /*
  * ******************************************************************
  * ************ functions implemented in this module end ************
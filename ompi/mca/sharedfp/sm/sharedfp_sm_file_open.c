@@ -209,11 +209,7 @@ int mca_sharedfp_sm_file_open (struct ompi_communicator_t *comm,
 
         /*write initial zero*/
         if(fh->f_rank==0){
-            MPI_Offset position=0;
-
-            sem_wait(sm_data->mutex);
-            sm_offset_ptr->offset=position;
-            sem_post(sm_data->mutex);
+            mca_sharedfp_sm_set_position(sm_data, 0);
         }
     }else{
         free(sm_filename);
@@ -29,7 +29,7 @@
 #include "ompi/mca/sharedfp/sharedfp.h"
 #include "ompi/mca/sharedfp/base/base.h"
 
-/*use a semaphore to lock the shared memory*/
+/*use a semaphore to lock the shared memory if atomics can not be used*/
 #include <semaphore.h>
 
 int mca_sharedfp_sm_request_position(ompio_file_t *fh, 
@@ -37,7 +37,6 @@ int mca_sharedfp_sm_request_position(ompio_file_t *fh,
                                      OMPI_MPI_OFFSET_TYPE *offset)
 {
     int ret = OMPI_SUCCESS;
-    OMPI_MPI_OFFSET_TYPE position = 0;
     OMPI_MPI_OFFSET_TYPE old_offset;
     struct mca_sharedfp_sm_data * sm_data = NULL;
     struct mca_sharedfp_sm_offset * sm_offset_ptr = NULL;
@@ -47,13 +46,17 @@ int mca_sharedfp_sm_request_position(ompio_file_t *fh,
     sm_data = sh->selected_module_data;
 
     *offset = 0;
+    sm_offset_ptr = sm_data->sm_offset_ptr;
+
+#if SHAREDFP_SM_ATOMIC_OFFSET
+    /* No lock needed, the update is a single atomic operation */
+    old_offset = opal_atomic_fetch_add_64(&sm_offset_ptr->offset, bytes_requested);
+#else
     if ( mca_sharedfp_sm_verbose ) {
         opal_output(ompi_sharedfp_base_framework.framework_output,
                     "Acquiring lock, rank=%d...",fh->f_rank);
     }
 
-    sm_offset_ptr = sm_data->sm_offset_ptr;
-
     /* Acquire an exclusive lock */
 
     sem_wait(sm_data->mutex);
@@ -64,31 +67,39 @@ int mca_sharedfp_sm_request_position(ompio_file_t *fh,
     }
 
     old_offset=sm_offset_ptr->offset;
-    if ( mca_sharedfp_sm_verbose ) {
-        opal_output(ompi_sharedfp_base_framework.framework_output,
-                    "Read last_offset=%lld!\n",old_offset);
-    }
+    sm_offset_ptr->offset=old_offset + bytes_requested;
 
-    position = old_offset + bytes_requested;
     if ( mca_sharedfp_sm_verbose ) {
         opal_output(ompi_sharedfp_base_framework.framework_output,
-                    "old_offset=%lld, bytes_requested=%lld, new offset=%lld!\n",old_offset,bytes_requested,position);
+                    "Releasing sm lock...rank=%d",fh->f_rank);
     }
-    sm_offset_ptr->offset=position;
-
 
+    sem_post(sm_data->mutex);
     if ( mca_sharedfp_sm_verbose ) {
         opal_output(ompi_sharedfp_base_framework.framework_output,
-                    "Releasing sm lock...rank=%d",fh->f_rank);
+                    "Released lock! released lock.for rank=%d\n",fh->f_rank);
     }
+#endif
 
-    sem_post(sm_data->mutex);
     if ( mca_sharedfp_sm_verbose ) {
         opal_output(ompi_sharedfp_base_framework.framework_output,
-                    "Released lock! released lock.for rank=%d\n",fh->f_rank);
+                    "old_offset=%lld, bytes_requested=%lld, new offset=%lld!\n",
+                    (long long) old_offset, bytes_requested, (long long) (old_offset + bytes_requested));
     }
 
     *offset = old_offset;
 
     return ret;
 }
+
+void mca_sharedfp_sm_set_position (struct mca_sharedfp_sm_data *sm_data,
+                                   OMPI_MPI_OFFSET_TYPE offset)
+{
+#if SHAREDFP_SM_ATOMIC_OFFSET
+    (void) opal_atomic_swap_64(&sm_data->sm_offset_ptr->offset, offset);
+#else
+    sem_wait(sm_data->mutex);
+    sm_data->sm_offset_ptr->offset=offset;
+    sem_post(sm_data->mutex);
+#endif
+}
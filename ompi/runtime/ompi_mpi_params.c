@@ -87,6 +87,7 @@ bool ompi_mpi_compat_mpi3 = true;
 
 char *ompi_mpi_spc_attach_string = NULL;
 bool ompi_mpi_spc_dump_enabled = false;
+int ompi_mpi_spc_shards = 16;
 uint32_t ompi_pmix_connect_timeout = 0;
 
 bool ompi_enable_timing = false;
@@ -106,6 +107,7 @@ bool ompi_ftmpi_enabled = false;
 static int ompi_stream_buffering_mode = -1;
 static int ompi_mpi_ft_verbose = 0;
 int ompi_comm_verbose_level = 0;
+int ompi_comm_split_cache_size = 8;
 
 int ompi_mpi_register_params(void)
 {
@@ -387,6 +389,15 @@ int ompi_mpi_register_params(void)
                                  OPAL_INFO_LVL_4,
                                  MCA_BASE_VAR_SCOPE_READONLY,
                                  &ompi_mpi_spc_dump_enabled);
+
+    ompi_mpi_spc_shards = 16;
+    (void) mca_base_var_register("ompi", "mpi", NULL, "spc_shards",
+                                 "Number of threads that update a private copy of the SPC counters, which is summed over all copies when read. "
+                                 "Later threads share one more copy and update it atomically (maximum 64).",
+                                 MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                 OPAL_INFO_LVL_4,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &ompi_mpi_spc_shards);
 #endif // SPC_ENABLE
 
     ompi_pmix_connect_timeout = 0; /* infinite timeout - see PMIx standard */
@@ -451,6 +462,16 @@ int ompi_mpi_register_params(void)
                                   MCA_BASE_VAR_TYPE_INT, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
                                   OPAL_INFO_LVL_8, MCA_BASE_VAR_SCOPE_LOCAL, &ompi_comm_verbose_level);
 
+    ompi_comm_split_cache_size = 8;
+    (void) mca_base_var_register ("ompi", "mpi", "comm", "split_cache_size",
+                                  "Number of communicators kept per parent communicator for splits "
+                                  "that set the ompi_comm_split_cache info key. An identical split of "
+                                  "the same parent reuses a freed one instead of creating a new "
+                                  "communicator (0 disables the cache)",
+                                  MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                  OPAL_INFO_LVL_6, MCA_BASE_VAR_SCOPE_READONLY,
+                                  &ompi_comm_split_cache_size);
+
     return OMPI_SUCCESS;
 }
 
@@ -19,6 +19,8 @@
 
 #include "ompi_config.h"
 
+#include <assert.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,6 +34,7 @@
 #include "opal/mca/timer/timer.h"
 #include "opal/mca/base/mca_base_pvar.h"
 #include "opal/util/argv.h"
+#include "opal/util/bit_ops.h"
 #include "opal/util/show_help.h"
 #include "opal/util/output.h"
 
@@ -51,11 +54,15 @@ typedef struct ompi_spc_event_t {
     const char* counter_description;
     bool is_high_watermark;
     bool is_timer_event;
+    bool is_histogram;
 } ompi_spc_event_t;
 
 #define SET_COUNTER_ARRAY(NAME, DESC, HWM, ITE)   [NAME] = { .counter_name = #NAME, .counter_description = DESC, \
                                                              .is_high_watermark = HWM, .is_timer_event = ITE }
 
+#define SET_HISTOGRAM_ARRAY(NAME, DESC)   [NAME] = { .counter_name = #NAME, .counter_description = DESC, \
+                                                     .is_timer_event = true, .is_histogram = true }
+
 static const ompi_spc_event_t ompi_spc_events_desc[OMPI_SPC_NUM_COUNTERS] = {
     SET_COUNTER_ARRAY(OMPI_SPC_SEND, "The number of times MPI_Send was called.", false, false),
     SET_COUNTER_ARRAY(OMPI_SPC_BSEND, "The number of times MPI_Bsend was called.", false, false),
@@ -171,11 +178,90 @@ static const ompi_spc_event_t ompi_spc_events_desc[OMPI_SPC_NUM_COUNTERS] = {
     SET_COUNTER_ARRAY(OMPI_SPC_ISENDRECV_REPLACE, "The number of times MPI_Isendrecv_replace was called.", false, false),
     SET_COUNTER_ARRAY(OMPI_SPC_PARRIVED, "The number of times MPI_Parrived was called.", false, false),
     SET_COUNTER_ARRAY(OMPI_SPC_PREADY, "The number of times MPI_Pready (or similar functions) was called.", false, false),
+    SET_HISTOGRAM_ARRAY(OMPI_SPC_P2P_LATENCY, "Histogram of the time spent in MPI_Send and MPI_Recv. Bucket 0 counts the calls that took less than 1ns, "
+                                              "bucket i the calls that took between 2^(i-1) and 2^i ns, the last bucket also counts all longer calls."),
+    SET_HISTOGRAM_ARRAY(OMPI_SPC_COLL_LATENCY, "Histogram of the time spent in MPI_Barrier, MPI_Bcast, MPI_Reduce and MPI_Allreduce. Bucket 0 counts the calls that took less than 1ns, "
+                                               "bucket i the calls that took between 2^(i-1) and 2^i ns, the last bucket also counts all longer calls."),
 };
 
 /* An array of event structures to store the event data (value, attachments, flags) */
 ompi_spc_t ompi_spc_events[OMPI_SPC_NUM_COUNTERS];
 
+/* The shards of the first ompi_mpi_spc_shards threads, followed by the one shared
+ * by all later threads */
+ompi_spc_shard_t ompi_spc_shards[OMPI_SPC_MAX_SHARDS + 1];
+static opal_atomic_int32_t ompi_spc_thread_count = 0;
+
+#if OPAL_HAVE_THREAD_LOCAL
+opal_thread_local int ompi_spc_thread_shard = -1;
+opal_thread_local bool ompi_spc_thread_shared = false;
+#endif
+
+/* Hands out the shards in the order in which the threads record their first event */
+int ompi_spc_thread_attach(void)
+{
+    int thread = OPAL_THREAD_FETCH_ADD32(&ompi_spc_thread_count, 1);
+
+    if( thread < ompi_mpi_spc_shards ) {
+        return thread;
+    }
+
+#if OPAL_HAVE_THREAD_LOCAL
+    ompi_spc_thread_shared = true;
+#endif
+    return ompi_mpi_spc_shards;
+}
+
+/* Number of shards that may have been written to */
+static inline int ompi_spc_shards_used(void)
+{
+    int count = ompi_spc_thread_count;
+
+#if !OPAL_HAVE_THREAD_LOCAL
+    count = 1;
+#endif
+    return (count > ompi_mpi_spc_shards) ? ompi_mpi_spc_shards + 1 : count;
+}
+
+/* The value of a counter, summed over the shards */
+ompi_spc_value_t ompi_spc_value(unsigned int event_id)
+{
+    int i, nshards = ompi_spc_shards_used();
+    ompi_spc_value_t value = 0;
+
+    if( ompi_spc_events[event_id].is_global ) {
+        return ompi_spc_events[event_id].value;
+    }
+    for(i = 0; i < nshards; i++) {
+        value += ompi_spc_shards[i].values[event_id];
+    }
+    return value;
+}
+
+/* The high watermark of a counter. The watermark is restarted from 0
+ * after it is read if reset is set. */
+ompi_spc_value_t ompi_spc_watermark(unsigned int event_id, bool reset)
+{
+    if( reset ) {
+        return OPAL_THREAD_SWAP_64(&ompi_spc_events[event_id].value, 0);
+    }
+    return ompi_spc_events[event_id].value;
+}
+
+/* Counts a duration in its bucket of a histogram */
+void ompi_spc_histogram_record(unsigned int event_id, opal_timer_t cycles)
+{
+    opal_timer_t nsecs = cycles * 1000 / sys_clock_freq_mhz;
+    int bucket;
+
+    if( nsecs > INT_MAX ) {
+        nsecs = INT_MAX;
+    }
+    bucket = opal_hibit((int)nsecs, 31) + 1;
+
+    ompi_spc_shard_add(&ompi_spc_thread_shard_get()->histograms[ompi_spc_events[event_id].histogram][bucket], 1);
+}
+
 /* ##############################################################
  * ################# Begin MPI_T Functions ######################
  * ##############################################################
@@ -192,11 +278,11 @@ static int ompi_spc_notify(mca_base_pvar_t *pvar, mca_base_pvar_event_t event, v
     index = (int)(uintptr_t)pvar->ctx;  /* Convert from MPI_T pvar index to SPC index */
 
     /* For this event, we need to set count to the number of long long type
-     * values for this counter.  All SPC counters are one long long, so we
-     * always set count to 1.
+     * values for this counter.  All SPC counters are one long long, except
+     * for the histograms which have one per bucket.
      */
     if(MCA_BASE_PVAR_HANDLE_BIND == event) {
-        *count = 1;
+        *count = (ompi_spc_events[index].histogram >= 0) ? OMPI_SPC_HISTOGRAM_BUCKETS : 1;
     }
     /* For this event, we need to turn on the counter */
     else if(MCA_BASE_PVAR_HANDLE_START == event) {
@@ -224,24 +310,40 @@ static int ompi_spc_get_count(const struct mca_base_pvar_t *pvar, void *value, v
 {
     long long *counter_value_ptr = (long long*)value;
     long long counter_value;
+    int i, j, nshards;
+
+    /* Convert from MPI_T pvar index to SPC index */
+    int index = (int)(uintptr_t)pvar->ctx;
+
+    if( ompi_spc_events[index].histogram >= 0 ) {
+        int histogram = ompi_spc_events[index].histogram;
+
+        nshards = mpi_t_enabled ? ompi_spc_shards_used() : 0;
+        for(j = 0; j < OMPI_SPC_HISTOGRAM_BUCKETS; j++) {
+            counter_value_ptr[j] = 0;
+            for(i = 0; i < nshards; i++) {
+                counter_value_ptr[j] += ompi_spc_shards[i].histograms[histogram][j];
+            }
+        }
+        return MPI_SUCCESS;
+    }
 
     if(OPAL_LIKELY(!mpi_t_enabled)) {
         *counter_value_ptr = 0;
         return MPI_SUCCESS;
     }
 
-    /* Convert from MPI_T pvar index to SPC index */
-    int index = (int)(uintptr_t)pvar->ctx;
-    /* Set the counter value to the current SPC value */
-    counter_value = (long long)ompi_spc_events[index].value;
+    /* If this is a high watermark counter, reset it after it has been read */
+    if(ompi_spc_events[index].is_high_watermark) {
+        counter_value = (long long)ompi_spc_watermark(index, true);
+    } else {
+        /* Set the counter value to the current SPC value */
+        counter_value = (long long)ompi_spc_value(index);
+    }
     /* If this is a timer-based counter, convert from cycles to microseconds */
     if( ompi_spc_events[index].is_timer_event ) {
         counter_value /= sys_clock_freq_mhz;
     }
-    /* If this is a high watermark counter, reset it after it has been read */
-    if(ompi_spc_events[index].is_high_watermark) {
-        ompi_spc_events[index].value = 0;
-    }
 
     *counter_value_ptr = counter_value;
 
@@ -251,7 +353,7 @@ static int ompi_spc_get_count(const struct mca_base_pvar_t *pvar, void *value, v
 /* Allocate and initializes the events data structure. */
 static void ompi_spc_events_init(void)
 {
-    int i;
+    int i, histogram = 0;
 
     /* Initialize all of the counters with an initial count of 0.
      * Also copy over the flags for faster access later.
@@ -261,7 +363,20 @@ static void ompi_spc_events_init(void)
         ompi_spc_events[i].num_attached = 0;
         ompi_spc_events[i].is_high_watermark = ompi_spc_events_desc[i].is_high_watermark;
         ompi_spc_events[i].is_timer_event = ompi_spc_events_desc[i].is_timer_event;
+        /* the queue depths are compared with their high watermarks */
+        ompi_spc_events[i].is_global = ompi_spc_events_desc[i].is_high_watermark ||
+                                       OMPI_SPC_UNEXPECTED_IN_QUEUE == i ||
+                                       OMPI_SPC_OOS_IN_QUEUE == i;
+        ompi_spc_events[i].histogram = ompi_spc_events_desc[i].is_histogram ? histogram++ : -1;
     }
+    assert(OMPI_SPC_NUM_HISTOGRAMS == histogram);
+
+    if (ompi_mpi_spc_shards < 0) {
+        ompi_mpi_spc_shards = 0;
+    } else if (ompi_mpi_spc_shards > OMPI_SPC_MAX_SHARDS) {
+        ompi_mpi_spc_shards = OMPI_SPC_MAX_SHARDS;
+    }
+    memset(ompi_spc_shards, 0, sizeof(ompi_spc_shards));
 
     if (ompi_mpi_spc_dump_enabled) {
         ompi_comm_dup(&ompi_mpi_comm_world.comm, &ompi_spc_comm);
@@ -316,7 +431,8 @@ void ompi_spc_init(void)
 
         /* Registers the current counter as an MPI_T pvar regardless of whether it's been turned on or not */
         ret = mca_base_pvar_register("ompi", "runtime", "spc", ompi_spc_events_desc[i].counter_name, ompi_spc_events_desc[i].counter_description,
-                                     OPAL_INFO_LVL_4, MPI_T_PVAR_CLASS_SIZE,
+                                     OPAL_INFO_LVL_4,
+                                     ompi_spc_events_desc[i].is_histogram ? MPI_T_PVAR_CLASS_COUNTER : MPI_T_PVAR_CLASS_SIZE,
                                      MCA_BASE_VAR_TYPE_UNSIGNED_LONG_LONG, NULL, MPI_T_BIND_NO_OBJECT,
                                      MCA_BASE_PVAR_FLAG_READONLY,
                                      ompi_spc_get_count, NULL, ompi_spc_notify, (void*)(uintptr_t)i);
@@ -341,13 +457,6 @@ static void ompi_spc_dump(void)
     int rank = ompi_comm_rank(ompi_spc_comm);
     world_size = ompi_comm_size(ompi_spc_comm);
 
-    /* Convert from cycles to usecs before sending */
-    for(i = 0; i < OMPI_SPC_NUM_COUNTERS; i++) {
-        if( ompi_spc_events[i].is_timer_event ) {
-            ompi_spc_events[i].value = ompi_spc_cycles_to_usecs_internal(ompi_spc_events[i].value);
-        }
-    }
-
     /* Aggregate all of the information on rank 0 using MPI_Gather on MPI_COMM_WORLD */
     send_buffer = (long long*)malloc(OMPI_SPC_NUM_COUNTERS * sizeof(long long));
     if (NULL == send_buffer) {
@@ -356,7 +465,23 @@ static void ompi_spc_dump(void)
         return;
     }
     for(i = 0; i < OMPI_SPC_NUM_COUNTERS; i++) {
-        send_buffer[i] = (long long)ompi_spc_events[i].value;
+        if( ompi_spc_events[i].histogram >= 0 ) {
+            /* Only the number of calls is shown for histograms */
+            send_buffer[i] = 0;
+            for(j = 0; j < ompi_spc_shards_used(); j++) {
+                for(offset = 0; offset < OMPI_SPC_HISTOGRAM_BUCKETS; offset++) {
+                    send_buffer[i] += ompi_spc_shards[j].histograms[ompi_spc_events[i].histogram][offset];
+                }
+            }
+        } else if( ompi_spc_events[i].is_high_watermark ) {
+            send_buffer[i] = (long long)ompi_spc_watermark(i, false);
+        } else {
+            send_buffer[i] = (long long)ompi_spc_value(i);
+        }
+        /* Convert from cycles to usecs before sending */
+        if( ompi_spc_events[i].is_timer_event && ompi_spc_events[i].histogram < 0 ) {
+            send_buffer[i] = ompi_spc_cycles_to_usecs_internal(send_buffer[i]);
+        }
     }
     if( 0 == rank ) {
         recv_buffer = (long long*)malloc(world_size * OMPI_SPC_NUM_COUNTERS * sizeof(long long));
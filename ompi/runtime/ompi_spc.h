@@ -40,6 +40,10 @@
  *     SPC_TIMER_START and SPC_TIMER_STOP macros to record
  *     the time in cycles to then be converted to microseconds later
  *     in the ompi_spc_get_count function when requested by MPI_T
+ * 5.) A latency histogram is added like a timer-based counter, with
+ *     SET_HISTOGRAM_ARRAY in step 2 and OMPI_SPC_NUM_HISTOGRAMS
+ *     incremented. SPC_TIMER_STOP then counts the duration in its
+ *     bucket instead of adding it up.
  */
 
 /* This enumeration serves as event ids for the various events */
@@ -156,22 +160,49 @@ typedef enum ompi_spc_counters {
     OMPI_SPC_ISENDRECV_REPLACE,
     OMPI_SPC_PARRIVED,
     OMPI_SPC_PREADY,
+    OMPI_SPC_P2P_LATENCY,
+    OMPI_SPC_COLL_LATENCY,
     OMPI_SPC_NUM_COUNTERS /* This serves as the number of counters.  It must be last. */
 } ompi_spc_counters_t;
 
+/* Number of counters that are latency histograms */
+#define OMPI_SPC_NUM_HISTOGRAMS 2
+
+/* Bucket 0 of a histogram counts the operations that took less than 1ns,
+ * bucket i the ones that took between 2^(i-1) and 2^i ns, and the last
+ * bucket everything longer */
+#define OMPI_SPC_HISTOGRAM_BUCKETS 32
+
+/* Upper limit of the mpi_spc_shards parameter */
+#define OMPI_SPC_MAX_SHARDS 64
+
 /* There is currently no support for atomics on long long values so we will default to
  * size_t for now until support for such atomics is implemented.
  */
 typedef long long ompi_spc_value_t;
 
-/* A structure for storing the event data */
+/* A structure for storing the event data. The values of the counters are
+ * kept in the shards below, except for the queue depths and their high
+ * watermarks: a queue grows in the thread that progresses and shrinks in
+ * the thread that posts, so their value is only meaningful as a whole and
+ * is kept here. */
 typedef struct ompi_spc_s{
-    opal_atomic_int64_t value;
+    opal_atomic_int64_t value;            /* value of the counters that are not sharded */
     opal_atomic_int32_t num_attached;
     bool is_high_watermark;
     bool is_timer_event;
+    bool is_global;                       /* not sharded, kept in value */
+    int8_t histogram;                     /* index of the histogram in the shards, -1 if none */
 } ompi_spc_t;
 
+/* The counters updated by a group of threads. Each shard fills whole
+ * cache lines so that threads do not write to the lines of others.
+ */
+typedef struct ompi_spc_shard_s {
+    int64_t values[OMPI_SPC_NUM_COUNTERS];
+    int64_t histograms[OMPI_SPC_NUM_HISTOGRAMS][OMPI_SPC_HISTOGRAM_BUCKETS];
+} __opal_attribute_aligned__(64) ompi_spc_shard_t;
+
 /* Definitions for using the SPC utility functions throughout the codebase.
  * If SPC_ENABLE is not 1, the macros become no-ops.
  */
@@ -181,6 +212,10 @@ typedef struct ompi_spc_s{
 void ompi_spc_init(void);
 void ompi_spc_fini(void);
 void ompi_spc_cycles_to_usecs(opal_timer_t *cycles);
+OMPI_DECLSPEC int ompi_spc_thread_attach(void);
+OMPI_DECLSPEC ompi_spc_value_t ompi_spc_value(unsigned int event_id);
+OMPI_DECLSPEC ompi_spc_value_t ompi_spc_watermark(unsigned int event_id, bool reset);
+OMPI_DECLSPEC void ompi_spc_histogram_record(unsigned int event_id, opal_timer_t cycles);
 
 /* An array of event structures to store the event data value, attachments, flags)
  * The memory is statically allocated to reduce the number of loads required.
@@ -188,6 +223,20 @@ void ompi_spc_cycles_to_usecs(opal_timer_t *cycles);
 OPAL_DECLSPEC extern
 ompi_spc_t ompi_spc_events[OMPI_SPC_NUM_COUNTERS] __opal_attribute_aligned__(sizeof(ompi_spc_t));
 
+/* The counter values, summed over the shards in use when they are read */
+OMPI_DECLSPEC extern ompi_spc_shard_t ompi_spc_shards[OMPI_SPC_MAX_SHARDS + 1];
+
+/* The shard of the calling thread (-1 until its first event) and whether
+ * other threads update it as well. The first mpi_spc_shards threads get
+ * a shard of their own, later threads share them. */
+#if OPAL_HAVE_THREAD_LOCAL
+OMPI_DECLSPEC extern opal_thread_local int ompi_spc_thread_shard;
+OMPI_DECLSPEC extern opal_thread_local bool ompi_spc_thread_shared;
+#else
+#define ompi_spc_thread_shard 0
+#define ompi_spc_thread_shared true
+#endif
+
 #define SPC_INIT()  \
     ompi_spc_init()
 
@@ -213,13 +262,40 @@ ompi_spc_t ompi_spc_events[OMPI_SPC_NUM_COUNTERS] __opal_attribute_aligned__(siz
     ompi_spc_update_watermark(watermark_enum, value_enum)
 
 
-/* Records an update to a counter using an atomic add operation. */
+/* Adds to a counter in the shard of the calling thread, with an atomic add
+ * only if the shard is shared with other threads. */
+static inline
+void ompi_spc_shard_add(int64_t *counter, ompi_spc_value_t value)
+{
+    if( OPAL_UNLIKELY(ompi_spc_thread_shared) ) {
+        OPAL_THREAD_ADD_FETCH64((opal_atomic_int64_t *) counter, value);
+    } else {
+        *counter += value;
+    }
+}
+
+static inline
+ompi_spc_shard_t *ompi_spc_thread_shard_get(void)
+{
+#if OPAL_HAVE_THREAD_LOCAL
+    if( OPAL_UNLIKELY(ompi_spc_thread_shard < 0) ) {
+        ompi_spc_thread_shard = ompi_spc_thread_attach();
+    }
+#endif
+    return &ompi_spc_shards[ompi_spc_thread_shard];
+}
+
+/* Records an update to a counter in the shard of the calling thread. */
 static inline
 void ompi_spc_record(unsigned int event_id, ompi_spc_value_t value)
 {
     /* Denoted unlikely because counters will often be turned off. */
     if( ompi_spc_events[event_id].num_attached > 0 ) {
-        OPAL_THREAD_ADD_FETCH64(&(ompi_spc_events[event_id].value), value);
+        if( OPAL_UNLIKELY(ompi_spc_events[event_id].is_global) ) {
+            OPAL_THREAD_ADD_FETCH64(&ompi_spc_events[event_id].value, value);
+        } else {
+            ompi_spc_shard_add(&ompi_spc_thread_shard_get()->values[event_id], value);
+        }
     }
 }
 
@@ -234,7 +310,7 @@ void ompi_spc_user_or_mpi(int tag, ompi_spc_value_t value, unsigned int user_enu
 
 /* Checks whether the counter denoted by value_enum exceeds the current value of the
  * counter denoted by watermark_enum, and if so sets the watermark_enum counter to the
- * value of the value_enum counter.
+ * value of the value_enum counter. Both counters are global, not sharded.
  */
 static inline
 void ompi_spc_update_watermark(unsigned int watermark_enum, unsigned int value_enum)
@@ -245,7 +321,7 @@ void ompi_spc_update_watermark(unsigned int watermark_enum, unsigned int value_e
     if( watermark_event->num_attached &&
         value_event->num_attached ) {
         int64_t watermark = watermark_event->value;
-        int64_t value = watermark_event->value;
+        int64_t value = value_event->value;
         /* Try to atomically replace the watermark while the value is larger
          * (i.e, while no thread has replaced it with a larger value, including this thread) */
         while (value > watermark &&
@@ -273,14 +349,18 @@ void ompi_spc_timer_start(unsigned int event_id, opal_timer_t *cycles)
 
 /* Stops a cycle-precision timer and calculates the total elapsed time
  * based on the starting time in 'cycles' and stores the result in the
- * 'cycles' argument.
+ * 'cycles' argument. Histograms count the elapsed time in its bucket.
  */
 static inline
 void ompi_spc_timer_stop(unsigned int event_id, opal_timer_t *cycles)
 {
     if( ompi_spc_events[event_id].num_attached > 0 && *cycles > 0 ) {
         *cycles = opal_timer_base_get_cycles() - *cycles;
-        OPAL_THREAD_ADD_FETCH64(&ompi_spc_events[event_id].value, *cycles);
+        if( ompi_spc_events[event_id].histogram >= 0 ) {
+            ompi_spc_histogram_record(event_id, *cycles);
+        } else {
+            ompi_spc_shard_add(&ompi_spc_thread_shard_get()->values[event_id], *cycles);
+        }
     }
 }
 
@@ -177,6 +177,12 @@ OMPI_DECLSPEC extern char * ompi_mpi_spc_attach_string;
  */
 OMPI_DECLSPEC extern bool ompi_mpi_spc_dump_enabled;
 
+/**
+ * Number of threads that keep the SPC counters in a shard of their own.
+ * Later threads share one more shard.
+ */
+OMPI_DECLSPEC extern int ompi_mpi_spc_shards;
+
 /**
  * Timeout for calls to PMIx_Connect(default 0, no timeout)
  */
@@ -197,6 +203,12 @@ OMPI_DECLSPEC extern bool ompi_mpi_yield_when_idle;
  */
 OMPI_DECLSPEC extern int ompi_comm_verbose_level;
 
+/**
+ * Number of split communicators cached per parent communicator when
+ * the ompi_comm_split_cache info key is set.
+ */
+OMPI_DECLSPEC extern int ompi_comm_split_cache_size;
+
 /**
  * Register MCA parameters used by the MPI layer.
  *
@@ -432,6 +432,11 @@ int32_t opal_convertor_set_position_nocheck(opal_convertor_t *convertor, size_t
     if (OPAL_LIKELY(convertor->flags & OPAL_DATATYPE_FLAG_CONTIGUOUS)) {
         rc = opal_convertor_create_stack_with_pos_contig(convertor, (*position),
                                                          opal_datatype_local_sizes);
+    } else if (convertor->flags & CONVERTOR_PLAN) {
+        /* the compiled plans only rely on the position */
+        convertor->bConverted = *position;
+        convertor->partial_length = 0;
+        rc = OPAL_SUCCESS;
     } else {
         if ((0 == (*position)) || ((*position) < convertor->bConverted)) {
             rc = opal_convertor_create_stack_at_begining(convertor, opal_datatype_local_sizes);
@@ -598,6 +603,9 @@ int32_t opal_convertor_prepare_for_recv(opal_convertor_t *convertor,
         } else {
             if (convertor->pDesc->flags & OPAL_DATATYPE_FLAG_CONTIGUOUS) {
                 convertor->fAdvance = opal_unpack_homogeneous_contig;
+            } else if ((NULL != datatype->plan) && !(convertor->flags & CONVERTOR_ACCELERATOR)) {
+                convertor->flags |= CONVERTOR_PLAN;
+                convertor->fAdvance = opal_unpack_plan;
             } else {
                 convertor->fAdvance = opal_generic_simple_unpack;
             }
@@ -649,6 +657,9 @@ int32_t opal_convertor_prepare_for_send(opal_convertor_t *convertor,
                 } else {
                     convertor->fAdvance = opal_pack_homogeneous_contig_with_gaps;
                 }
+            } else if ((NULL != datatype->plan) && !(convertor->flags & CONVERTOR_ACCELERATOR)) {
+                convertor->flags |= CONVERTOR_PLAN;
+                convertor->fAdvance = opal_pack_plan;
             } else {
                 convertor->fAdvance = opal_generic_simple_pack;
             }
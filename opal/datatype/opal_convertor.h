@@ -59,6 +59,7 @@ BEGIN_C_DECLS
 #define CONVERTOR_ACCELERATOR_UNIFIED    0x10000000
 #define CONVERTOR_HAS_REMOTE_SIZE        0x20000000
 #define CONVERTOR_SKIP_ACCELERATOR_INIT  0x40000000
+#define CONVERTOR_PLAN                   0x80000000
 
 union dt_elem_desc;
 typedef struct opal_convertor_t opal_convertor_t;
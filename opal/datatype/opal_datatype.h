@@ -141,10 +141,13 @@ struct opal_datatype_t {
                          all language interfaces (because Fortran is not known at the OPAL
                          layer). This field should never be initialized in homogeneous
                          environments */
-    /* --- cacheline 5 boundary (320 bytes) was 32-36 bytes ago --- */
+    struct opal_datatype_plan_t *plan; /**< compiled pack plan of a committed datatype, built
+                                            by opal_datatype_commit. NULL when the generic
+                                            pack/unpack functions must be used */
+    /* --- cacheline 5 boundary (320 bytes) was 40-44 bytes ago --- */
 
-    /* size: 352, cachelines: 6, members: 15 */
-    /* last cacheline: 28-32 bytes */
+    /* size: 360, cachelines: 6, members: 16 */
+    /* last cacheline: 36-40 bytes */
 };
 
 typedef struct opal_datatype_t opal_datatype_t;
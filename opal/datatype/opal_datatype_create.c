@@ -55,10 +55,12 @@ static void opal_datatype_construct(opal_datatype_t *pData)
 
     pData->ptypes = NULL;
     pData->loops = 0;
+    pData->plan = NULL;
 }
 
 static void opal_datatype_destruct(opal_datatype_t *datatype)
 {
+    opal_datatype_plan_release(datatype);
     /**
      * As the default description and the optimized description might point to the
      * same data description we should start by cleaning the optimized description.
@@ -302,6 +302,38 @@ OPAL_DECLSPEC int opal_datatype_dump_data_flags(unsigned short usflags, char *pt
 OPAL_DECLSPEC int opal_datatype_dump_data_desc(union dt_elem_desc *pDesc, int nbElems, char *ptr,
                                                size_t length);
 
+/**
+ * One contiguous piece of a committed datatype, as stored in its compiled
+ * pack plan.
+ */
+struct opal_datatype_plan_run_t {
+    ptrdiff_t disp;  /**< displacement of the run in the user buffer */
+    size_t length;   /**< length of the run in bytes */
+    size_t position; /**< offset of the run in the packed representation of the datatype */
+};
+typedef struct opal_datatype_plan_run_t opal_datatype_plan_run_t;
+
+/**
+ * The compiled pack plan of a committed datatype: the flattened list of the
+ * (displacement, length) runs of one instance of the datatype, in packing
+ * order. When all the runs have the same length and are separated by the
+ * same stride (vector and 2D subarray like datatypes) the list is not kept,
+ * the runs are computed from the first one.
+ */
+struct opal_datatype_plan_t {
+    size_t nb_runs;                 /**< number of runs in one instance of the datatype */
+    ptrdiff_t disp;                 /**< displacement of the first run */
+    size_t length;                  /**< length of each run, for vector plans */
+    ptrdiff_t stride;               /**< distance between two runs, for vector plans */
+    opal_datatype_plan_run_t *runs; /**< the runs, NULL for vector plans */
+};
+typedef struct opal_datatype_plan_t opal_datatype_plan_t;
+
+int32_t opal_datatype_plan_build(struct opal_datatype_t *pData);
+void opal_datatype_plan_release(struct opal_datatype_t *pData);
+
+OPAL_DECLSPEC extern unsigned int opal_datatype_plan_max_runs;
+
 extern bool opal_ddt_position_debug;
 extern bool opal_ddt_copy_debug;
 extern bool opal_ddt_unpack_debug;
@@ -35,6 +35,7 @@
 #include "opal/datatype/opal_convertor_internal.h"
 #include "opal/datatype/opal_datatype.h"
 #include "opal/datatype/opal_datatype_constructors.h"
+#include "opal/datatype/opal_datatype_internal.h"
 #include "opal/mca/base/mca_base_var.h"
 #include "opal/runtime/opal.h"
 #include "opal/util/arch.h"
@@ -179,9 +180,20 @@ OPAL_DECLSPEC const opal_datatype_t *opal_datatype_basicDatatypes[OPAL_DATATYPE_
 
 int opal_datatype_register_params(void)
 {
-#if OPAL_ENABLE_DEBUG
     int ret;
 
+    ret = mca_base_var_register(
+        "opal", "mpi", NULL, "ddt_plan_max_runs",
+        "Maximum number of contiguous runs kept in the compiled pack plan of a committed "
+        "datatype. Datatypes with more runs are packed with the generic functions, unless all "
+        "their runs have the same length and stride (0 = never use compiled plans)",
+        MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+        MCA_BASE_VAR_SCOPE_LOCAL, &opal_datatype_plan_max_runs);
+    if (0 > ret) {
+        return ret;
+    }
+
+#if OPAL_ENABLE_DEBUG
     ret = mca_base_var_register(
         "opal", "mpi", NULL, "ddt_unpack_debug",
         "Whether to output debugging information in the ddt unpack functions (nonzero = enabled)",
@@ -342,5 +342,7 @@ int32_t opal_datatype_commit(opal_datatype_t *pData)
         pLast->first_elem_disp = first_elem_disp;
         pLast->size = pData->size;
     }
+    /* without a plan pack and unpack fall back on the generic functions */
+    (void) opal_datatype_plan_build(pData);
     return OPAL_SUCCESS;
 }
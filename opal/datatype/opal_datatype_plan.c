@@ -0,0 +1,432 @@
+/* -*- Mode: C; c-basic-offset:4 ; -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Compiled pack plans. When a datatype is committed its optimized
+ * description is flattened once into the list of contiguous runs of one
+ * instance of the datatype. Homogeneous pack and unpack of non contiguous
+ * datatypes then walk this list instead of going through the description
+ * stack machine, and the position in the data is always retrieved from
+ * pConv->bConverted. Datatypes with a constant run length and stride (most
+ * vectors and 2D subarrays) do not even store the list.
+ */
+
+#include "opal_config.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "opal/datatype/opal_convertor_internal.h"
+#include "opal/datatype/opal_datatype_internal.h"
+#include "opal/datatype/opal_datatype_memcpy.h"
+#include "opal/datatype/opal_datatype_prototypes.h"
+
+/* Largest number of runs kept in the plan of a non vector datatype */
+unsigned int opal_datatype_plan_max_runs = 4096;
+
+typedef struct {
+    opal_datatype_plan_t *plan;
+    size_t allocated;  /* number of entries allocated in plan->runs */
+    size_t packed;     /* packed size of the runs committed so far */
+    ptrdiff_t last;    /* displacement of the last committed run */
+    bool vector;       /* all the runs committed so far follow the same pattern */
+    bool has_stride;
+    bool has_pending;
+    opal_datatype_plan_run_t pending; /* last run, still open to merging */
+} opal_datatype_plan_builder_t;
+
+/* Add count runs of the same length, extent bytes apart */
+static int32_t opal_datatype_plan_commit_runs(opal_datatype_plan_builder_t *builder,
+                                              ptrdiff_t disp, size_t length, ptrdiff_t extent,
+                                              size_t count)
+{
+    opal_datatype_plan_t *plan = builder->plan;
+    size_t i;
+
+    if (0 == plan->nb_runs) {
+        plan->disp = disp;
+        plan->length = length;
+    } else if (builder->vector) {
+        if (length != plan->length) {
+            builder->vector = false;
+        } else if (!builder->has_stride) {
+            plan->stride = disp - builder->last;
+            builder->has_stride = true;
+        } else if ((disp - builder->last) != plan->stride) {
+            builder->vector = false;
+        }
+    }
+    if (builder->vector && (count > 1)) {
+        if (!builder->has_stride) {
+            plan->stride = extent;
+            builder->has_stride = true;
+        } else if (extent != plan->stride) {
+            builder->vector = false;
+        }
+    }
+
+    /* keep the list as long as it is small enough, it will be dropped if the
+     * datatype turns out to be a vector */
+    for (i = 0; (i < count) && ((plan->nb_runs + i) < opal_datatype_plan_max_runs); i++) {
+        if ((plan->nb_runs + i) == builder->allocated) {
+            opal_datatype_plan_run_t *runs;
+
+            builder->allocated = (0 == builder->allocated) ? 16 : 2 * builder->allocated;
+            if (builder->allocated > opal_datatype_plan_max_runs) {
+                builder->allocated = opal_datatype_plan_max_runs;
+            }
+            runs = (opal_datatype_plan_run_t *) realloc(plan->runs, builder->allocated
+                                                                        * sizeof(*runs));
+            if (NULL == runs) {
+                return OPAL_ERR_OUT_OF_RESOURCE;
+            }
+            plan->runs = runs;
+        }
+        plan->runs[plan->nb_runs + i].disp = disp + (ptrdiff_t) i * extent;
+        plan->runs[plan->nb_runs + i].length = length;
+        plan->runs[plan->nb_runs + i].position = builder->packed + i * length;
+    }
+    plan->nb_runs += count;
+    builder->packed += count * length;
+    builder->last = disp + (ptrdiff_t) (count - 1) * extent;
+
+    if (!builder->vector && (plan->nb_runs > opal_datatype_plan_max_runs)) {
+        return OPAL_ERR_NOT_SUPPORTED;
+    }
+    return OPAL_SUCCESS;
+}
+
+static inline int32_t opal_datatype_plan_flush(opal_datatype_plan_builder_t *builder)
+{
+    if (!builder->has_pending) {
+        return OPAL_SUCCESS;
+    }
+    builder->has_pending = false;
+    return opal_datatype_plan_commit_runs(builder, builder->pending.disp, builder->pending.length,
+                                          0, 1);
+}
+
+static inline int32_t opal_datatype_plan_add_run(opal_datatype_plan_builder_t *builder,
+                                                 ptrdiff_t disp, size_t length)
+{
+    int32_t rc;
+
+    if (builder->has_pending
+        && ((builder->pending.disp + (ptrdiff_t) builder->pending.length) == disp)) {
+        builder->pending.length += length;
+        return OPAL_SUCCESS;
+    }
+    rc = opal_datatype_plan_flush(builder);
+    builder->pending.disp = disp;
+    builder->pending.length = length;
+    builder->has_pending = true;
+    return rc;
+}
+
+static int32_t opal_datatype_plan_add_elem(opal_datatype_plan_builder_t *builder,
+                                           const ddt_elem_desc_t *elem, ptrdiff_t base)
+{
+    size_t length = elem->blocklen * opal_datatype_basicDatatypes[elem->common.type]->size;
+    ptrdiff_t disp = base + elem->disp;
+    int32_t rc;
+
+    if ((1 == elem->count) || ((ptrdiff_t) length == elem->extent)) {
+        return opal_datatype_plan_add_run(builder, disp, length * elem->count);
+    }
+    /* the first and the last blocks might be merged with their neighbors */
+    rc = opal_datatype_plan_add_run(builder, disp, length);
+    if (OPAL_SUCCESS != rc) {
+        return rc;
+    }
+    if (elem->count > 2) {
+        rc = opal_datatype_plan_flush(builder);
+        if (OPAL_SUCCESS != rc) {
+            return rc;
+        }
+        rc = opal_datatype_plan_commit_runs(builder, disp + elem->extent, length, elem->extent,
+                                            elem->count - 2);
+        if (OPAL_SUCCESS != rc) {
+            return rc;
+        }
+    }
+    return opal_datatype_plan_add_run(builder, disp + (ptrdiff_t)(elem->count - 1) * elem->extent,
+                                      length);
+}
+
+static int32_t opal_datatype_plan_walk(opal_datatype_plan_builder_t *builder,
+                                       const dt_elem_desc_t *description, uint32_t first,
+                                       uint32_t last, ptrdiff_t base)
+{
+    uint32_t pos_desc = first, i;
+    int32_t rc;
+
+    while (pos_desc < last) {
+        const dt_elem_desc_t *pElem = &description[pos_desc];
+
+        if (OPAL_DATATYPE_LOOP == pElem->elem.common.type) {
+            for (i = 0; i < pElem->loop.loops; i++) {
+                rc = opal_datatype_plan_walk(builder, description, pos_desc + 1,
+                                             pos_desc + pElem->loop.items,
+                                             base + (ptrdiff_t) i * pElem->loop.extent);
+                if (OPAL_SUCCESS != rc) {
+                    return rc;
+                }
+            }
+            pos_desc += pElem->loop.items + 1;
+            continue;
+        }
+        if (pElem->elem.common.flags & OPAL_DATATYPE_FLAG_DATA) {
+            rc = opal_datatype_plan_add_elem(builder, &pElem->elem, base);
+            if (OPAL_SUCCESS != rc) {
+                return rc;
+            }
+        }
+        pos_desc++;
+    }
+    return OPAL_SUCCESS;
+}
+
+int32_t opal_datatype_plan_build(opal_datatype_t *pData)
+{
+    opal_datatype_plan_builder_t builder = {.vector = true};
+    opal_datatype_plan_t *plan;
+    int32_t rc;
+
+    if ((0 == opal_datatype_plan_max_runs) || (0 == pData->opt_desc.used)
+        || (pData->flags & OPAL_DATATYPE_FLAG_CONTIGUOUS)) {
+        return OPAL_SUCCESS;
+    }
+
+    plan = (opal_datatype_plan_t *) calloc(1, sizeof(opal_datatype_plan_t));
+    if (NULL == plan) {
+        return OPAL_ERR_OUT_OF_RESOURCE;
+    }
+    builder.plan = plan;
+
+    rc = opal_datatype_plan_walk(&builder, pData->opt_desc.desc, 0, pData->opt_desc.used, 0);
+    if (OPAL_SUCCESS == rc) {
+        rc = opal_datatype_plan_flush(&builder);
+    }
+    if ((OPAL_SUCCESS != rc) || (builder.packed != pData->size)) {
+        /* fall back on the generic functions */
+        free(plan->runs);
+        free(plan);
+        return (OPAL_ERR_OUT_OF_RESOURCE == rc) ? rc : OPAL_SUCCESS;
+    }
+
+    if (builder.vector) {
+        free(plan->runs);
+        plan->runs = NULL;
+    } else if (builder.allocated > plan->nb_runs) {
+        opal_datatype_plan_run_t *runs = (opal_datatype_plan_run_t *)
+            realloc(plan->runs, plan->nb_runs * sizeof(opal_datatype_plan_run_t));
+        if (NULL != runs) {
+            plan->runs = runs;
+        }
+    }
+    pData->plan = plan;
+    return OPAL_SUCCESS;
+}
+
+void opal_datatype_plan_release(opal_datatype_t *pData)
+{
+    if (NULL != pData->plan) {
+        free(pData->plan->runs);
+        free(pData->plan);
+        pData->plan = NULL;
+    }
+}
+
+/*
+ * Copy count blocks of length bytes. Small blocks are common for vectors of
+ * predefined types, give the compiler a constant size to work with.
+ */
+static inline void opal_datatype_plan_copy_blocks(unsigned char *dst, ptrdiff_t dst_stride,
+                                                  const unsigned char *src, ptrdiff_t src_stride,
+                                                  size_t length, size_t count)
+{
+    size_t i;
+
+    switch (length) {
+    case 4:
+        for (i = 0; i < count; i++, dst += dst_stride, src += src_stride) {
+            MEMCPY(dst, src, 4);
+        }
+        break;
+    case 8:
+        for (i = 0; i < count; i++, dst += dst_stride, src += src_stride) {
+            MEMCPY(dst, src, 8);
+        }
+        break;
+    case 16:
+        for (i = 0; i < count; i++, dst += dst_stride, src += src_stride) {
+            MEMCPY(dst, src, 16);
+        }
+        break;
+    default:
+        for (i = 0; i < count; i++, dst += dst_stride, src += src_stride) {
+            MEMCPY(dst, src, length);
+        }
+    }
+}
+
+static inline void opal_datatype_plan_copy(unsigned char *user, unsigned char *packed,
+                                           size_t length, const bool pack)
+{
+    if (pack) {
+        MEMCPY(packed, user, length);
+    } else {
+        MEMCPY(user, packed, length);
+    }
+}
+
+/* Move length bytes between the packed buffer and the user buffer, starting
+ * at the current position of the convertor, for vector plans.
+ */
+static inline void opal_datatype_plan_vector(const opal_convertor_t *pConv, unsigned char *packed,
+                                             size_t length, const bool pack)
+{
+    const opal_datatype_t *pData = pConv->pDesc;
+    const opal_datatype_plan_t *plan = pData->plan;
+    ptrdiff_t extent = pData->ub - pData->lb;
+    size_t instance = pConv->bConverted / pData->size;
+    size_t offset = pConv->bConverted - instance * pData->size;
+    size_t block = offset / plan->length, skip = offset - block * plan->length, count;
+    unsigned char *base = pConv->pBaseBuf + (ptrdiff_t) instance * extent + plan->disp;
+    unsigned char *user = base + (ptrdiff_t) block * plan->stride;
+
+    while (0 != length) {
+        if (0 != skip || length < plan->length) {
+            /* partial block, either at the beginning or at the end */
+            count = plan->length - skip;
+            if (count > length) {
+                count = length;
+            }
+            opal_datatype_plan_copy(user + skip, packed, count, pack);
+            packed += count;
+            length -= count;
+            if ((skip + count) < plan->length) {
+                break;
+            }
+            skip = 0;
+            block++;
+            user += plan->stride;
+        } else {
+            count = length / plan->length;
+            if (count > (plan->nb_runs - block)) {
+                count = plan->nb_runs - block;
+            }
+            if (pack) {
+                opal_datatype_plan_copy_blocks(packed, plan->length, user, plan->stride,
+                                               plan->length, count);
+            } else {
+                opal_datatype_plan_copy_blocks(user, plan->stride, packed, plan->length,
+                                               plan->length, count);
+            }
+            packed += count * plan->length;
+            length -= count * plan->length;
+            block += count;
+            user += (ptrdiff_t) count * plan->stride;
+        }
+        if (block == plan->nb_runs) {
+            block = 0;
+            base += extent;
+            user = base;
+        }
+    }
+}
+
+/* Same as above for plans with a list of runs */
+static inline void opal_datatype_plan_list(const opal_convertor_t *pConv, unsigned char *packed,
+                                           size_t length, const bool pack)
+{
+    const opal_datatype_t *pData = pConv->pDesc;
+    const opal_datatype_plan_t *plan = pData->plan;
+    ptrdiff_t extent = pData->ub - pData->lb;
+    size_t instance = pConv->bConverted / pData->size;
+    size_t offset = pConv->bConverted - instance * pData->size;
+    const opal_datatype_plan_run_t *run, *end = plan->runs + plan->nb_runs;
+    unsigned char *base = pConv->pBaseBuf + (ptrdiff_t) instance * extent;
+    size_t lo = 0, hi = plan->nb_runs - 1, mid, skip, count;
+
+    /* find the run containing the current position */
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (plan->runs[mid].position <= offset) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    run = plan->runs + lo;
+    skip = offset - run->position;
+
+    while (0 != length) {
+        count = run->length - skip;
+        if (count > length) {
+            count = length;
+        }
+        opal_datatype_plan_copy(base + run->disp + skip, packed, count, pack);
+        packed += count;
+        length -= count;
+        skip = 0;
+        if (++run == end) {
+            run = plan->runs;
+            base += extent;
+        }
+    }
+}
+
+static inline int32_t opal_datatype_plan_advance(opal_convertor_t *pConv, struct iovec *iov,
+                                                 uint32_t *out_size, size_t *max_data,
+                                                 const bool pack)
+{
+    size_t total = 0, length;
+    uint32_t iov_count;
+
+    for (iov_count = 0; iov_count < (*out_size); iov_count++) {
+        length = pConv->local_size - pConv->bConverted;
+        if (0 == length) {
+            break;
+        }
+        if ((size_t) iov[iov_count].iov_len < length) {
+            length = iov[iov_count].iov_len;
+        } else {
+            iov[iov_count].iov_len = length;
+        }
+        if (NULL == pConv->pDesc->plan->runs) {
+            opal_datatype_plan_vector(pConv, (unsigned char *) iov[iov_count].iov_base, length,
+                                      pack);
+        } else {
+            opal_datatype_plan_list(pConv, (unsigned char *) iov[iov_count].iov_base, length,
+                                    pack);
+        }
+        pConv->bConverted += length;
+        total += length;
+    }
+    *max_data = total;
+    *out_size = iov_count;
+    if (pConv->bConverted == pConv->local_size) {
+        pConv->flags |= CONVERTOR_COMPLETED;
+        return 1;
+    }
+    return 0;
+}
+
+int32_t opal_pack_plan(opal_convertor_t *pConv, struct iovec *iov, uint32_t *out_size,
+                       size_t *max_data)
+{
+    return opal_datatype_plan_advance(pConv, iov, out_size, max_data, true);
+}
+
+int32_t opal_unpack_plan(opal_convertor_t *pConv, struct iovec *iov, uint32_t *out_size,
+                         size_t *max_data)
+{
+    return opal_datatype_plan_advance(pConv, iov, out_size, max_data, false);
+}
@@ -52,6 +52,10 @@ int32_t opal_unpack_homogeneous_contig_checksum(opal_convertor_t *pConv, struct
                                                 uint32_t *out_size, size_t *max_data);
 int32_t opal_generic_simple_unpack(opal_convertor_t *pConvertor, struct iovec *iov,
                                    uint32_t *out_size, size_t *max_data);
+int32_t opal_pack_plan(opal_convertor_t *pConv, struct iovec *iov, uint32_t *out_size,
+                       size_t *max_data);
+int32_t opal_unpack_plan(opal_convertor_t *pConv, struct iovec *iov, uint32_t *out_size,
+                         size_t *max_data);
 int32_t opal_generic_simple_unpack_checksum(opal_convertor_t *pConvertor, struct iovec *iov,
                                             uint32_t *out_size, size_t *max_data);
 
@@ -176,7 +176,8 @@ static int mca_btl_sm_component_register(void)
     mca_btl_sm_component.fbox_max = 32;
     (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version, "fbox_max",
                                            "Maximum number of eager send buffers "
-                                           "to allocate (default: 32)",
+                                           "to allocate, counting buffers of all sizes "
+                                           "(default: 32)",
                                            MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0,
                                            MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
                                            MCA_BASE_VAR_SCOPE_LOCAL,
@@ -184,12 +185,58 @@ static int mca_btl_sm_component_register(void)
 
     mca_btl_sm_component.fbox_size = 4096;
     (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version, "fbox_size",
-                                           "Size of per-peer fast transfer buffers. Must be a power of two (default: 4k)",
+                                           "Initial size of per-peer fast transfer buffers. Must be a power of two (default: 4k)",
                                            MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0,
                                            MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
                                            MCA_BASE_VAR_SCOPE_LOCAL,
                                            &mca_btl_sm_component.fbox_size);
 
+    mca_btl_sm_component.fbox_max_size = 65536;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version, "fbox_max_size",
+                                           "Largest size a per-peer fast transfer buffer can grow to "
+                                           "when the peer sends more than fits in it. Must be a power "
+                                           "of two. Set to fbox_size to disable growing (default: 64k)",
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL,
+                                           &mca_btl_sm_component.fbox_max_size);
+
+    mca_btl_sm_component.fbox_adapt_interval = 4096;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "fbox_adapt_interval",
+                                           "Number of progress calls between checks of the traffic "
+                                           "through each fast box. 0 keeps the size of fast boxes "
+                                           "fixed (default: 4096)",
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL,
+                                           &mca_btl_sm_component.fbox_adapt_interval);
+
+    mca_btl_sm_component.fbox_grow_threshold = 16;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "fbox_grow_threshold",
+                                           "Number of sends to a peer that did not fit in its fast box "
+                                           "during one interval before the fast box is doubled in size. "
+                                           "0 disables growing (default: 16)",
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL,
+                                           &mca_btl_sm_component.fbox_grow_threshold);
+
+    mca_btl_sm_component.fbox_idle_intervals = 64;
+    (void) mca_base_component_var_register(&mca_btl_sm_component.super.btl_version,
+                                           "fbox_idle_intervals",
+                                           "Number of consecutive intervals without any send to a peer "
+                                           "before its fast box is halved in size, or reclaimed if it "
+                                           "already has the initial size. 0 disables shrinking "
+                                           "(default: 64)",
+                                           MCA_BASE_VAR_TYPE_UNSIGNED_INT, NULL, 0,
+                                           MCA_BASE_VAR_FLAG_SETTABLE, OPAL_INFO_LVL_5,
+                                           MCA_BASE_VAR_SCOPE_LOCAL,
+                                           &mca_btl_sm_component.fbox_idle_intervals);
+
+    mca_btl_sm_fbox_register_pvars();
+
     if (0 == access("/dev/shm", W_OK)) {
         mca_btl_sm_component.backing_directory = "/dev/shm";
     } else {
@@ -235,7 +282,9 @@ static int mca_btl_sm_component_open(void)
     OBJ_CONSTRUCT(&mca_btl_sm_component.sm_frags_eager, opal_free_list_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.sm_frags_user, opal_free_list_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.sm_frags_max_send, opal_free_list_t);
-    OBJ_CONSTRUCT(&mca_btl_sm_component.sm_fboxes, opal_free_list_t);
+    for (int i = 0; i < MCA_BTL_SM_FBOX_MAX_CLASSES; ++i) {
+        OBJ_CONSTRUCT(&mca_btl_sm_component.sm_fboxes[i], opal_free_list_t);
+    }
     OBJ_CONSTRUCT(&mca_btl_sm_component.lock, opal_mutex_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.pending_endpoints, opal_list_t);
     OBJ_CONSTRUCT(&mca_btl_sm_component.pending_fragments, opal_list_t);
@@ -252,7 +301,9 @@ static int mca_btl_sm_component_close(void)
     OBJ_DESTRUCT(&mca_btl_sm_component.sm_frags_eager);
     OBJ_DESTRUCT(&mca_btl_sm_component.sm_frags_user);
     OBJ_DESTRUCT(&mca_btl_sm_component.sm_frags_max_send);
-    OBJ_DESTRUCT(&mca_btl_sm_component.sm_fboxes);
+    for (int i = 0; i < MCA_BTL_SM_FBOX_MAX_CLASSES; ++i) {
+        OBJ_DESTRUCT(&mca_btl_sm_component.sm_fboxes[i]);
+    }
     OBJ_DESTRUCT(&mca_btl_sm_component.lock);
     OBJ_DESTRUCT(&mca_btl_sm_component.pending_endpoints);
     OBJ_DESTRUCT(&mca_btl_sm_component.pending_fragments);
@@ -336,6 +387,18 @@ mca_btl_sm_component_init(int *num_btls, bool enable_progress_threads, bool enab
         component->fbox_size = opal_next_poweroftwo_inclusive(component->fbox_size);
     }
 
+    /* fast boxes grow by doubling from fbox_size up to fbox_max_size */
+    component->fbox_num_classes = 1;
+    while (component->fbox_num_classes < MCA_BTL_SM_FBOX_MAX_CLASSES
+           && (component->fbox_size << component->fbox_num_classes) <= component->fbox_max_size) {
+        ++component->fbox_num_classes;
+    }
+    component->fbox_max_data = (component->fbox_size << (component->fbox_num_classes - 1)) >> 2;
+    component->fbox_adapt_count = 0;
+    component->fbox_bytes = 0;
+    component->fbox_count = 0;
+    component->fbox_retiring = 0;
+
     if (component->segment_size > (1ul << MCA_BTL_SM_OFFSET_BITS)) {
         component->segment_size = 2ul << MCA_BTL_SM_OFFSET_BITS;
     }
@@ -574,8 +637,19 @@ static int mca_btl_sm_component_progress(void)
         count = mca_btl_sm_check_fboxes();
     }
 
+    /* hand replaced fast boxes back as soon as the receivers let go of them */
+    if (mca_btl_sm_component.fbox_retiring) {
+        mca_btl_sm_fbox_check_retired();
+    }
+
     mca_btl_sm_progress_endpoints();
 
+    if (mca_btl_sm_component.fbox_adapt_interval
+        && ++mca_btl_sm_component.fbox_adapt_count >= mca_btl_sm_component.fbox_adapt_interval) {
+        mca_btl_sm_component.fbox_adapt_count = 0;
+        mca_btl_sm_fbox_adapt();
+    }
+
     if (SM_FIFO_FREE == mca_btl_sm_component.my_fifo->fifo_head) {
         lock = 0;
         return count;
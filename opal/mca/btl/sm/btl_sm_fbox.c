@@ -0,0 +1,337 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "opal_config.h"
+
+#include <stddef.h>
+
+#include "opal/mca/base/mca_base_pvar.h"
+#include "opal/mca/btl/sm/btl_sm.h"
+#include "opal/mca/btl/sm/btl_sm_fbox.h"
+
+static inline size_t mca_btl_sm_fbox_alloc_size(int size_class)
+{
+    return (mca_btl_sm_component.fbox_size << size_class) + sizeof(mca_btl_sm_fbox_metadata_t);
+}
+
+opal_free_list_item_t *mca_btl_sm_fbox_alloc(int size_class)
+{
+    opal_free_list_item_t *fbox;
+
+    if (opal_atomic_add_fetch_32(&mca_btl_sm_component.fbox_count, 1)
+        > (int32_t) mca_btl_sm_component.fbox_max) {
+        opal_atomic_add_fetch_32(&mca_btl_sm_component.fbox_count, -1);
+        return NULL;
+    }
+
+    fbox = opal_free_list_get(&mca_btl_sm_component.sm_fboxes[size_class]);
+    if (NULL == fbox) {
+        opal_atomic_add_fetch_32(&mca_btl_sm_component.fbox_count, -1);
+        return NULL;
+    }
+
+    OPAL_THREAD_ADD_FETCH_SIZE_T(&mca_btl_sm_component.fbox_bytes,
+                                 mca_btl_sm_fbox_alloc_size(size_class));
+    return fbox;
+}
+
+void mca_btl_sm_fbox_free(opal_free_list_item_t *fbox, int size_class)
+{
+    opal_free_list_return(&mca_btl_sm_component.sm_fboxes[size_class], fbox);
+    OPAL_THREAD_SUB_FETCH_SIZE_T(&mca_btl_sm_component.fbox_bytes,
+                                 mca_btl_sm_fbox_alloc_size(size_class));
+    opal_atomic_add_fetch_32(&mca_btl_sm_component.fbox_count, -1);
+}
+
+/**
+ * Replace the send fast box of an endpoint.
+ *
+ * @param ep (IN)          Sm BTL endpoint
+ * @param size_class (IN)  Size class of the new fast box or -1 to reclaim the fast box
+ *
+ * A resize entry is written to the current fast box. The receiver switches to the new fast box
+ * when it reaches this entry and then marks the old one as retired. When reclaiming, the old
+ * fast box stays attached (but does not accept new fragments) until it is retired so that no
+ * fragment can overtake the ones still in it through the fifo.
+ *
+ * Must be called with the endpoint lock held.
+ */
+static bool mca_btl_sm_fbox_replace_locked(mca_btl_base_endpoint_t *ep, int size_class)
+{
+    opal_free_list_item_t *fbox = NULL;
+    fifo_value_t new_base = 0;
+    unsigned char *dst;
+    uint16_t seq;
+
+    if (size_class >= 0) {
+        /* the old fast box stays allocated until it is retired, so this needs room for one more
+         * fast box */
+        fbox = mca_btl_sm_fbox_alloc(size_class);
+        if (NULL == fbox) {
+            return false;
+        }
+
+        memset(fbox->ptr, 0, mca_btl_sm_fbox_alloc_size(size_class));
+        new_base = virtual2relative((char *) fbox->ptr);
+    }
+
+    dst = mca_btl_sm_fbox_reserve_locked(ep, sizeof(new_base));
+    if (NULL == dst) {
+        /* try again in the next interval */
+        if (NULL != fbox) {
+            mca_btl_sm_fbox_free(fbox, size_class);
+        }
+        return false;
+    }
+
+    memcpy(dst + sizeof(mca_btl_sm_fbox_hdr_t), &new_base, sizeof(new_base));
+    seq = ep->fbox_out.seq++;
+
+    ep->fbox_out.retiring = ep->fbox_out.fbox;
+    ep->fbox_out.retiring_class = ep->fbox_out.size_class;
+    opal_atomic_add_fetch_32(&mca_btl_sm_component.fbox_retiring, 1);
+
+    if (NULL != fbox) {
+        mca_btl_sm_endpoint_setup_fbox_send(ep, fbox, size_class);
+    } else {
+        ep->fbox_out.fbox = NULL;
+        ep->fbox_out.max_data = 0;
+    }
+
+    BTL_VERBOSE(("replacing fast box for peer %d. new size: %u", ep->peer_smp_rank,
+                 (NULL != fbox) ? ep->fbox_out.size : 0));
+
+    /* the new fast box is fully initialized at this point */
+    mca_btl_sm_fbox_set_header(MCA_BTL_SM_FBOX_HDR(dst), MCA_BTL_SM_FBOX_TAG_RESIZE, seq,
+                               sizeof(new_base));
+
+    return true;
+}
+
+void mca_btl_sm_fbox_check_retired_locked(mca_btl_base_endpoint_t *ep)
+{
+    opal_free_list_item_t *retiring = ep->fbox_out.retiring;
+
+    if (NULL == retiring || !((mca_btl_sm_fbox_metadata_t *) retiring->ptr)->retired) {
+        return;
+    }
+
+    opal_atomic_rmb();
+
+    ep->fbox_out.retiring = NULL;
+    opal_atomic_add_fetch_32(&mca_btl_sm_component.fbox_retiring, -1);
+    mca_btl_sm_fbox_free(retiring, ep->fbox_out.retiring_class);
+
+    if (NULL == ep->fbox_out.fbox) {
+        /* reclaimed. fragments go through the fifo until the peer is busy enough to get a fast
+         * box again */
+        ep->fbox_out.buffer = NULL;
+        ep->fbox_out.metadata = NULL;
+        ep->fbox_out.size = 0;
+        ep->send_count = 0;
+    }
+}
+
+void mca_btl_sm_fbox_check_retired(void)
+{
+    mca_btl_sm_component_t *component = &mca_btl_sm_component;
+
+    if (NULL == component->endpoints) {
+        return;
+    }
+
+    for (int i = 0; i < (int) (1 + MCA_BTL_SM_NUM_LOCAL_PEERS); ++i) {
+        mca_btl_base_endpoint_t *ep = component->endpoints + i;
+
+        if (NULL == ep->fbox_out.retiring) {
+            continue;
+        }
+
+        /* a sender holding the lock checks the fast box itself */
+        if (OPAL_THREAD_TRYLOCK(&ep->lock)) {
+            continue;
+        }
+        mca_btl_sm_fbox_check_retired_locked(ep);
+        OPAL_THREAD_UNLOCK(&ep->lock);
+    }
+}
+
+void mca_btl_sm_fbox_adapt(void)
+{
+    mca_btl_sm_component_t *component = &mca_btl_sm_component;
+
+    if (NULL == component->endpoints) {
+        return;
+    }
+
+    for (int i = 0; i < (int) (1 + MCA_BTL_SM_NUM_LOCAL_PEERS); ++i) {
+        mca_btl_base_endpoint_t *ep = component->endpoints + i;
+        uint64_t sends, misses;
+        int size_class;
+
+        if (NULL == ep->fbox_out.buffer) {
+            continue;
+        }
+
+        OPAL_THREAD_LOCK(&ep->lock);
+        mca_btl_sm_fbox_check_retired_locked(ep);
+        if (NULL == ep->fbox_out.fbox || NULL != ep->fbox_out.retiring) {
+            /* the receiver has not caught up with the last change yet */
+            OPAL_THREAD_UNLOCK(&ep->lock);
+            continue;
+        }
+
+        sends = ep->fbox_out.stats.sends - ep->fbox_out.last_sends;
+        misses = ep->fbox_out.stats.misses - ep->fbox_out.last_misses;
+        ep->fbox_out.last_sends = ep->fbox_out.stats.sends;
+        ep->fbox_out.last_misses = ep->fbox_out.stats.misses;
+        size_class = ep->fbox_out.size_class;
+
+        if (0 == sends && 0 == misses) {
+            if (component->fbox_idle_intervals
+                && ++ep->fbox_out.idle_intervals >= component->fbox_idle_intervals) {
+                ep->fbox_out.idle_intervals = 0;
+                if (size_class > 0) {
+                    if (mca_btl_sm_fbox_replace_locked(ep, size_class - 1)) {
+                        ++ep->fbox_out.stats.shrinks;
+                    }
+                } else if (mca_btl_sm_fbox_replace_locked(ep, -1)) {
+                    ++ep->fbox_out.stats.reclaims;
+                }
+            }
+        } else {
+            ep->fbox_out.idle_intervals = 0;
+            if (component->fbox_grow_threshold && misses >= component->fbox_grow_threshold
+                && size_class + 1 < (int) component->fbox_num_classes) {
+                if (mca_btl_sm_fbox_replace_locked(ep, size_class + 1)) {
+                    ++ep->fbox_out.stats.grows;
+                }
+            }
+        }
+        OPAL_THREAD_UNLOCK(&ep->lock);
+    }
+}
+
+void mca_btl_sm_fbox_fini_endpoint(mca_btl_base_endpoint_t *ep)
+{
+    if (ep->fbox_out.fbox) {
+        mca_btl_sm_fbox_free(ep->fbox_out.fbox, ep->fbox_out.size_class);
+    }
+
+    if (ep->fbox_out.retiring) {
+        opal_atomic_add_fetch_32(&mca_btl_sm_component.fbox_retiring, -1);
+        mca_btl_sm_fbox_free(ep->fbox_out.retiring, ep->fbox_out.retiring_class);
+    }
+
+    ep->fbox_out.fbox = NULL;
+    ep->fbox_out.retiring = NULL;
+}
+
+/*
+ * MPI_T performance variables. The per-peer variables are arrays indexed by the local rank of
+ * the peer.
+ */
+
+static int mca_btl_sm_fbox_pvar_notify(struct mca_base_pvar_t *pvar, mca_base_pvar_event_t event,
+                                       void *obj, int *count)
+{
+    if (MCA_BASE_PVAR_HANDLE_BIND == event) {
+        *count = 1 + MCA_BTL_SM_NUM_LOCAL_PEERS;
+    }
+
+    return OPAL_SUCCESS;
+}
+
+static int mca_btl_sm_fbox_pvar_read_stat(const struct mca_base_pvar_t *pvar, void *value,
+                                          void *bound_obj)
+{
+    size_t offset = (size_t) pvar->ctx;
+    unsigned long long *array = (unsigned long long *) value;
+
+    for (int i = 0; i < (int) (1 + MCA_BTL_SM_NUM_LOCAL_PEERS); ++i) {
+        array[i] = 0;
+        if (NULL != mca_btl_sm_component.endpoints) {
+            char *base = (char *) &mca_btl_sm_component.endpoints[i].fbox_out.stats;
+            array[i] = *((uint64_t *) (base + offset));
+        }
+    }
+
+    return OPAL_SUCCESS;
+}
+
+static int mca_btl_sm_fbox_pvar_read_size(const struct mca_base_pvar_t *pvar, void *value,
+                                          void *bound_obj)
+{
+    unsigned long long *array = (unsigned long long *) value;
+
+    for (int i = 0; i < (int) (1 + MCA_BTL_SM_NUM_LOCAL_PEERS); ++i) {
+        array[i] = 0;
+        if (NULL != mca_btl_sm_component.endpoints
+            && NULL != mca_btl_sm_component.endpoints[i].fbox_out.fbox) {
+            array[i] = mca_btl_sm_component.endpoints[i].fbox_out.size;
+        }
+    }
+
+    return OPAL_SUCCESS;
+}
+
+static void mca_btl_sm_fbox_register_counter(const char *name, const char *desc, size_t offset)
+{
+    (void) mca_base_component_pvar_register(&mca_btl_sm_component.super.btl_version, name, desc,
+                                            OPAL_INFO_LVL_5, MCA_BASE_PVAR_CLASS_COUNTER,
+                                            MCA_BASE_VAR_TYPE_UNSIGNED_LONG_LONG, NULL,
+                                            MCA_BASE_VAR_BIND_NO_OBJECT,
+                                            MCA_BASE_PVAR_FLAG_READONLY
+                                                | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                            mca_btl_sm_fbox_pvar_read_stat, NULL,
+                                            mca_btl_sm_fbox_pvar_notify, (void *) offset);
+}
+
+void mca_btl_sm_fbox_register_pvars(void)
+{
+    (void) mca_base_component_pvar_register(&mca_btl_sm_component.super.btl_version, "fbox_size",
+                                            "Current size of the send fast box for each local "
+                                            "peer (0 if there is none)",
+                                            OPAL_INFO_LVL_5, MCA_BASE_PVAR_CLASS_SIZE,
+                                            MCA_BASE_VAR_TYPE_UNSIGNED_LONG_LONG, NULL,
+                                            MCA_BASE_VAR_BIND_NO_OBJECT,
+                                            MCA_BASE_PVAR_FLAG_READONLY
+                                                | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                            mca_btl_sm_fbox_pvar_read_size, NULL,
+                                            mca_btl_sm_fbox_pvar_notify, NULL);
+
+    mca_btl_sm_fbox_register_counter("fbox_sends",
+                                     "Number of fragments sent through the fast box of each "
+                                     "local peer",
+                                     offsetof(mca_btl_sm_fbox_stats_t, sends));
+    mca_btl_sm_fbox_register_counter("fbox_misses",
+                                     "Number of fragments that did not fit in the fast box of "
+                                     "each local peer",
+                                     offsetof(mca_btl_sm_fbox_stats_t, misses));
+    mca_btl_sm_fbox_register_counter("fbox_grows",
+                                     "Number of times the fast box of each local peer was grown",
+                                     offsetof(mca_btl_sm_fbox_stats_t, grows));
+    mca_btl_sm_fbox_register_counter("fbox_shrinks",
+                                     "Number of times the fast box of each local peer was shrunk",
+                                     offsetof(mca_btl_sm_fbox_stats_t, shrinks));
+    mca_btl_sm_fbox_register_counter("fbox_reclaims",
+                                     "Number of times the fast box of each local peer was "
+                                     "reclaimed because the peer was idle",
+                                     offsetof(mca_btl_sm_fbox_stats_t, reclaims));
+
+    (void) mca_base_component_pvar_register(&mca_btl_sm_component.super.btl_version, "fbox_bytes",
+                                            "Shared memory currently used by send fast boxes",
+                                            OPAL_INFO_LVL_5, MCA_BASE_PVAR_CLASS_SIZE,
+                                            MCA_BASE_VAR_TYPE_UNSIGNED_LONG, NULL,
+                                            MCA_BASE_VAR_BIND_NO_OBJECT,
+                                            MCA_BASE_PVAR_FLAG_READONLY
+                                                | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                            NULL, NULL, NULL,
+                                            (void *) &mca_btl_sm_component.fbox_bytes);
+}
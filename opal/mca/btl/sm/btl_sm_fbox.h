@@ -23,6 +23,12 @@
 #define MCA_BTL_SM_FBOX_ALIGNMENT      32
 #define MCA_BTL_SM_FBOX_ALIGNMENT_MASK (MCA_BTL_SM_FBOX_ALIGNMENT - 1)
 
+/* tags reserved for fast box control entries. 0xff: skip to the end of the buffer, 0xfe: fragment
+ * header, 0xfd: the sender replaced (or reclaimed) the fast box */
+#define MCA_BTL_SM_FBOX_TAG_RESIZE 0xfd
+#define MCA_BTL_SM_FBOX_TAG_FRAG   0xfe
+#define MCA_BTL_SM_FBOX_TAG_SKIP   0xff
+
 typedef union mca_btl_sm_fbox_hdr_t {
     struct {
         /* NTH: on 32-bit platforms loading/unloading the header may be completed
@@ -54,12 +60,13 @@ static inline void mca_btl_sm_endpoint_setup_fbox_recv(struct mca_btl_base_endpo
 {
     endpoint->fbox_in.metadata = (mca_btl_sm_fbox_metadata_t *) base;
     endpoint->fbox_in.start = endpoint->fbox_in.metadata->start;
+    endpoint->fbox_in.size = endpoint->fbox_in.metadata->size;
     endpoint->fbox_in.seq = 0;
     endpoint->fbox_in.buffer = (unsigned char *)(endpoint->fbox_in.metadata + 1);
 }
 
 static inline void mca_btl_sm_endpoint_setup_fbox_send(struct mca_btl_base_endpoint_t *endpoint,
-                                                       opal_free_list_item_t *fbox)
+                                                       opal_free_list_item_t *fbox, int size_class)
 {
     void *base = fbox->ptr;
 
@@ -67,9 +74,16 @@ static inline void mca_btl_sm_endpoint_setup_fbox_send(struct mca_btl_base_endpo
     endpoint->fbox_out.end = 0;
     endpoint->fbox_out.seq = 0;
     endpoint->fbox_out.fbox = fbox;
+    endpoint->fbox_out.size_class = size_class;
+    endpoint->fbox_out.size = mca_btl_sm_component.fbox_size << size_class;
+    /* don't try to use the per-peer buffer for messages that will fill up more than 25% of the
+     * buffer */
+    endpoint->fbox_out.max_data = endpoint->fbox_out.size >> 2;
 
     endpoint->fbox_out.metadata = (mca_btl_sm_fbox_metadata_t *) base;
     endpoint->fbox_out.metadata->start = 0;
+    endpoint->fbox_out.metadata->size = endpoint->fbox_out.size;
+    endpoint->fbox_out.metadata->retired = 0;
 
     endpoint->fbox_out.buffer = (unsigned char *)(endpoint->fbox_out.metadata + 1);
 
@@ -122,15 +136,13 @@ static inline unsigned int mca_btl_sm_fbox_align(unsigned int size) {
 }
 
 static inline unsigned char *mca_btl_sm_fbox_reserve_locked(mca_btl_base_endpoint_t *ep, unsigned int data_size) {
-    const unsigned int fbox_size = mca_btl_sm_component.fbox_size;
+    const unsigned int fbox_size = ep->fbox_out.size;
     const unsigned int fbox_offset_mask = fbox_size - 1;
     unsigned int buffer_free;
     unsigned char *dst;
     size_t aligned_entry_size;
 
-    /* don't try to use the per-peer buffer for messages that will fill up more than 25% of the
-     * buffer */
-    if (OPAL_UNLIKELY(NULL == ep->fbox_out.buffer || data_size > (fbox_size >> 2))) {
+    if (OPAL_UNLIKELY(NULL == ep->fbox_out.buffer || data_size > ep->fbox_out.max_data)) {
         return NULL;
     }
 
@@ -183,7 +195,8 @@ static inline unsigned char *mca_btl_sm_fbox_reserve_locked(mca_btl_base_endpoin
 
             BTL_VERBOSE(("writing a skip token at offset %u", old_end));
             /* space is available. go ahead and mark remaining space to skip */
-            mca_btl_sm_fbox_set_header(MCA_BTL_SM_FBOX_HDR(dst), 0xff, ep->fbox_out.seq++,
+            mca_btl_sm_fbox_set_header(MCA_BTL_SM_FBOX_HDR(dst), MCA_BTL_SM_FBOX_TAG_SKIP,
+                                       ep->fbox_out.seq++,
                                        remaining - sizeof(mca_btl_sm_fbox_hdr_t));
             dst = ep->fbox_out.buffer;
         }
@@ -208,19 +221,53 @@ static inline unsigned char *mca_btl_sm_fbox_reserve_locked(mca_btl_base_endpoin
     return dst;
 }
 
+/**
+ * Allocate a send fast box of the given size class. Returns NULL once fbox_max send fast boxes
+ * (of all sizes together, including replaced ones not yet retired) are allocated.
+ */
+opal_free_list_item_t *mca_btl_sm_fbox_alloc(int size_class);
+
+/**
+ * Return a send fast box allocated with mca_btl_sm_fbox_alloc().
+ */
+void mca_btl_sm_fbox_free(opal_free_list_item_t *fbox, int size_class);
+
+/**
+ * Return the replaced fast box of an endpoint once the receiver no longer reads from it. Must be
+ * called with the endpoint lock held.
+ */
+void mca_btl_sm_fbox_check_retired_locked(mca_btl_base_endpoint_t *ep);
+
+/**
+ * Return the replaced fast boxes of all endpoints that the receivers no longer read from.
+ */
+void mca_btl_sm_fbox_check_retired(void);
+
 /* attempt to reserve a contiguous segment from the remote ep */
 static inline bool mca_btl_sm_fbox_sendi(mca_btl_base_endpoint_t *ep, unsigned char tag,
                                          void *restrict header, const size_t header_size,
                                          void *restrict payload, const size_t payload_size)
 {
     size_t data_size = header_size + payload_size;
+    uint16_t seq;
 
     OPAL_THREAD_LOCK(&ep->lock);
+    if (OPAL_UNLIKELY(NULL != ep->fbox_out.retiring)) {
+        mca_btl_sm_fbox_check_retired_locked(ep);
+    }
     unsigned char *dst = mca_btl_sm_fbox_reserve_locked(ep, (unsigned int) data_size);
-    OPAL_THREAD_UNLOCK(&ep->lock);
     if (OPAL_UNLIKELY(NULL == dst)) {
+        /* only count the sends a larger fast box could have taken */
+        if (NULL != ep->fbox_out.fbox && data_size <= mca_btl_sm_component.fbox_max_data) {
+            ++ep->fbox_out.stats.misses;
+        }
+        OPAL_THREAD_UNLOCK(&ep->lock);
         return false;
     }
+    /* the sequence number must be taken in reservation order */
+    seq = ep->fbox_out.seq++;
+    ++ep->fbox_out.stats.sends;
+    OPAL_THREAD_UNLOCK(&ep->lock);
 
     unsigned char *data = dst + sizeof(mca_btl_sm_fbox_hdr_t);
 
@@ -232,15 +279,14 @@ static inline bool mca_btl_sm_fbox_sendi(mca_btl_base_endpoint_t *ep, unsigned c
 
     opal_atomic_wmb();
     /* write out part of the header now. the tag will be written when the data is available */
-    mca_btl_sm_fbox_set_header(MCA_BTL_SM_FBOX_HDR(dst), tag, ep->fbox_out.seq++,
-                               (uint32_t) data_size);
+    mca_btl_sm_fbox_set_header(MCA_BTL_SM_FBOX_HDR(dst), tag, seq, (uint32_t) data_size);
 
     return true;
 }
 
 static inline bool mca_btl_sm_poll_fbox(mca_btl_base_endpoint_t *ep)
 {
-    const unsigned int fbox_offset_mask = mca_btl_sm_component.fbox_size - 1;
+    const unsigned int fbox_offset_mask = ep->fbox_in.size - 1;
     unsigned int start_offset = ep->fbox_in.start & fbox_offset_mask;
     const mca_btl_sm_fbox_hdr_t hdr = mca_btl_sm_fbox_read_header(
         MCA_BTL_SM_FBOX_HDR(ep->fbox_in.buffer + start_offset));
@@ -260,7 +306,7 @@ static inline bool mca_btl_sm_poll_fbox(mca_btl_base_endpoint_t *ep)
          ep->peer_smp_rank, hdr.data.tag, hdr.data.size, hdr.data.seq, start_offset));
 
     /* the 0xff tag indicates we should skip the rest of the buffer */
-    if (OPAL_LIKELY((0xfe & hdr.data.tag) != 0xfe)) {
+    if (OPAL_LIKELY(hdr.data.tag < MCA_BTL_SM_FBOX_TAG_RESIZE)) {
         mca_btl_base_segment_t segment;
         const mca_btl_active_message_callback_t *reg = mca_btl_base_active_message_trigger
             + hdr.data.tag;
@@ -280,11 +326,31 @@ static inline bool mca_btl_sm_poll_fbox(mca_btl_base_endpoint_t *ep)
 
         /* call the registered callback function */
         reg->cbfunc(&mca_btl_sm.super, &desc);
-    } else if (OPAL_LIKELY(0xfe == hdr.data.tag)) {
+    } else if (OPAL_LIKELY(MCA_BTL_SM_FBOX_TAG_FRAG == hdr.data.tag)) {
         /* process fragment header */
         fifo_value_t *value = (fifo_value_t *) (ep->fbox_in.buffer + start_offset + sizeof(hdr));
         mca_btl_sm_hdr_t *sm_hdr = relative2virtual(*value);
         mca_btl_sm_poll_handle_frag(sm_hdr, ep);
+    } else if (MCA_BTL_SM_FBOX_TAG_RESIZE == hdr.data.tag) {
+        /* the sender moved to a new fast box. everything it sent before this entry is in the old
+         * fast box and everything after it is in the new one */
+        fifo_value_t *value = (fifo_value_t *) (ep->fbox_in.buffer + start_offset + sizeof(hdr));
+        mca_btl_sm_fbox_metadata_t *old_metadata = ep->fbox_in.metadata;
+
+        if (*value) {
+            mca_btl_sm_endpoint_setup_fbox_recv(ep, relative2virtual(*value));
+        } else {
+            /* reclaimed. mca_btl_sm_check_fboxes drops this endpoint from the poll list */
+            ep->fbox_in.buffer = NULL;
+            ep->fbox_in.metadata = NULL;
+            opal_atomic_add_fetch_32(&mca_btl_sm_component.my_fifo->fbox_available, 1);
+        }
+
+        /* let the sender reuse the old fast box */
+        opal_atomic_mb();
+        old_metadata->retired = 1;
+
+        return NULL != ep->fbox_in.buffer;
     }
 
     ep->fbox_in.start += mca_btl_sm_fbox_align(hdr.data.size + sizeof(hdr));
@@ -307,6 +373,14 @@ static inline int mca_btl_sm_check_fboxes(void)
             ++frag_count;
         }
 
+        if (OPAL_UNLIKELY(NULL == ep->fbox_in.buffer)) {
+            /* the sender reclaimed its fast box. stop polling this endpoint */
+            mca_btl_sm_component.fbox_in_endpoints[i--]
+                = mca_btl_sm_component.fbox_in_endpoints[--mca_btl_sm_component.num_fbox_in_endpoints];
+            total_processed += frag_count;
+            continue;
+        }
+
         if (frag_count) {
             BTL_VERBOSE(("finished processing at offset %x", ep->fbox_in.start));
 
@@ -330,12 +404,12 @@ static inline void mca_btl_sm_try_fbox_setup(mca_btl_base_endpoint_t *ep, mca_bt
 
         /* verify the remote side will accept another fbox */
         if (0 <= opal_atomic_add_fetch_32(&ep->fifo->fbox_available, -1)) {
-            opal_free_list_item_t *fbox = opal_free_list_get(&mca_btl_sm_component.sm_fboxes);
+            opal_free_list_item_t *fbox = mca_btl_sm_fbox_alloc(0);
 
             if (NULL != fbox) {
                 /* zero out the fast box */
                 memset(fbox->ptr, 0, mca_btl_sm_component.fbox_size);
-                mca_btl_sm_endpoint_setup_fbox_send(ep, fbox);
+                mca_btl_sm_endpoint_setup_fbox_send(ep, fbox, 0);
 
                 hdr->flags |= MCA_BTL_SM_FLAG_SETUP_FBOX;
                 hdr->fbox_base = virtual2relative((char *) ep->fbox_out.metadata);
@@ -350,4 +424,20 @@ static inline void mca_btl_sm_try_fbox_setup(mca_btl_base_endpoint_t *ep, mca_bt
     }
 }
 
+/**
+ * Grow, shrink, or reclaim send fast boxes based on the traffic seen since the last call.
+ * Called periodically from the component progress function.
+ */
+void mca_btl_sm_fbox_adapt(void);
+
+/**
+ * Return any fast boxes held by an endpoint that is being destroyed.
+ */
+void mca_btl_sm_fbox_fini_endpoint(mca_btl_base_endpoint_t *ep);
+
+/**
+ * Register the fast box MPI_T performance variables.
+ */
+void mca_btl_sm_fbox_register_pvars(void);
+
 #endif /* MCA_BTL_SM_FBOX_H */
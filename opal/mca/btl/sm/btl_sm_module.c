@@ -91,14 +91,18 @@ static int sm_btl_first_time_init(mca_btl_sm_t *sm_btl, int n)
         return OPAL_ERR_OUT_OF_RESOURCE;
     }
 
-    /* Fast box buffers are prepended with a metadata section. */
-    rc = opal_free_list_init(&component->sm_fboxes, sizeof(opal_free_list_item_t), 8,
-                             OBJ_CLASS(opal_free_list_item_t), mca_btl_sm_component.fbox_size +
-                             sizeof (mca_btl_sm_fbox_metadata_t),
-                             opal_cache_line_size, 0, mca_btl_sm_component.fbox_max, 4,
-                             component->mpool, 0, NULL, NULL, NULL);
-    if (OPAL_SUCCESS != rc) {
-        return rc;
+    /* Fast box buffers are prepended with a metadata section. Larger fast boxes are only
+     * allocated when a peer needs one. */
+    for (unsigned int i = 0; i < component->fbox_num_classes; ++i) {
+        rc = opal_free_list_init(&component->sm_fboxes[i], sizeof(opal_free_list_item_t), 8,
+                                 OBJ_CLASS(opal_free_list_item_t),
+                                 (mca_btl_sm_component.fbox_size << i) +
+                                 sizeof (mca_btl_sm_fbox_metadata_t),
+                                 opal_cache_line_size, 0, mca_btl_sm_component.fbox_max,
+                                 (0 == i) ? 4 : 1, component->mpool, 0, NULL, NULL, NULL);
+        if (OPAL_SUCCESS != rc) {
+            return rc;
+        }
     }
 
     /* initialize fragment descriptor free lists */
@@ -506,6 +510,10 @@ static void mca_btl_sm_endpoint_constructor(mca_btl_sm_endpoint_t *ep)
     OBJ_CONSTRUCT(&ep->pending_frags_lock, opal_mutex_t);
     ep->fifo = NULL;
     ep->fbox_out.fbox = NULL;
+    ep->fbox_out.retiring = NULL;
+    memset(&ep->fbox_out.stats, 0, sizeof(ep->fbox_out.stats));
+    ep->fbox_out.last_sends = ep->fbox_out.last_misses = 0;
+    ep->fbox_out.idle_intervals = 0;
 }
 
 static void mca_btl_sm_endpoint_destructor(mca_btl_sm_endpoint_t *ep)
@@ -527,9 +535,7 @@ static void mca_btl_sm_endpoint_destructor(mca_btl_sm_endpoint_t *ep)
         opal_shmem_segment_detach(&seg_ds);
     }
 
-    if (ep->fbox_out.fbox) {
-        opal_free_list_return(&mca_btl_sm_component.sm_fboxes, ep->fbox_out.fbox);
-    }
+    mca_btl_sm_fbox_fini_endpoint(ep);
 
     if (ep->smsc_endpoint) {
         MCA_SMSC_CALL(return_endpoint, ep->smsc_endpoint);
@@ -49,23 +49,53 @@ struct mca_btl_sm_modex_t {
 
 typedef struct mca_btl_sm_modex_t mca_btl_sm_modex_t;
 
+/** maximum number of fast box sizes (each twice the size of the previous one) */
+#define MCA_BTL_SM_FBOX_MAX_CLASSES 8
+
 typedef struct mca_btl_sm_fbox_metadata {
     uint32_t start;
-    uint8_t  padding[26];
+    /** size of the fast box buffer (power of two) */
+    uint32_t size;
+    /** set by the receiver once it no longer reads from a replaced fast box */
+    volatile uint32_t retired;
+    uint8_t  padding[18];
 } mca_btl_sm_fbox_metadata_t;
 
+/** per-peer fast box statistics (exposed as MPI_T performance variables) */
+typedef struct mca_btl_sm_fbox_stats {
+    uint64_t sends;    /**< fragments sent through the fast box */
+    uint64_t misses;   /**< fragments that did not fit in the fast box */
+    uint64_t grows;    /**< number of times the fast box was grown */
+    uint64_t shrinks;  /**< number of times the fast box was shrunk */
+    uint64_t reclaims; /**< number of times the fast box was reclaimed */
+} mca_btl_sm_fbox_stats_t;
+
 typedef struct mca_btl_sm_fbox_out {
     unsigned char *buffer; /**< starting address of peer's fast box in */
     mca_btl_sm_fbox_metadata_t *metadata;
     unsigned int start, end;
+    unsigned int size;     /**< size of the fast box buffer */
+    unsigned int max_data; /**< largest fragment accepted (0 while the fast box is reclaimed) */
     uint16_t seq;
+    int size_class;              /**< index of the free list the fast box came from */
     opal_free_list_item_t *fbox; /**< fast-box free list item */
+
+    /** fast box that was replaced and is waiting for the receiver to let go of it */
+    opal_free_list_item_t *retiring;
+    int retiring_class;
+
+    /* adaptive sizing state. protected by the endpoint lock */
+    mca_btl_sm_fbox_stats_t stats;
+    uint64_t last_sends;         /**< stats.sends at the start of the current interval */
+    uint64_t last_misses;        /**< stats.misses at the start of the current interval */
+    unsigned int idle_intervals; /**< consecutive intervals without traffic */
 } mca_btl_sm_fbox_out_t;
 
 typedef struct mca_btl_sm_fbox_in {
     unsigned char *buffer; /**< starting address of peer's fast box out */
     mca_btl_sm_fbox_metadata_t *metadata;
     unsigned int start;
+    unsigned int size; /**< size of the fast box buffer */
     uint16_t seq;
 } mca_btl_sm_fbox_in_t;
 
@@ -117,12 +147,23 @@ struct mca_btl_sm_component_t {
     opal_free_list_t sm_frags_eager;    /**< free list of sm send frags */
     opal_free_list_t sm_frags_max_send; /**< free list of sm max send frags (large fragments) */
     opal_free_list_t sm_frags_user;     /**< free list of small inline frags */
-    opal_free_list_t sm_fboxes;         /**< free list of available fast-boxes */
+    opal_free_list_t sm_fboxes[MCA_BTL_SM_FBOX_MAX_CLASSES]; /**< free lists of available
+                                                              *   fast-boxes (one per size) */
 
     unsigned int
         fbox_threshold; /**< number of sends required before we setup a send fast box for a peer */
-    unsigned int fbox_max;  /**< maximum number of send fast boxes to allocate */
-    unsigned int fbox_size; /**< size of each peer fast box allocation */
+    unsigned int fbox_max;  /**< maximum number of send fast boxes to allocate (all sizes) */
+    unsigned int fbox_size; /**< initial size of each peer fast box allocation */
+    unsigned int fbox_max_size;       /**< largest size a fast box may grow to */
+    unsigned int fbox_num_classes;    /**< number of fast box sizes in use */
+    unsigned int fbox_adapt_interval; /**< progress calls between fast box size checks */
+    unsigned int fbox_adapt_count;    /**< progress calls since the last check */
+    unsigned int fbox_grow_threshold; /**< misses per interval that trigger growing a fast box */
+    unsigned int fbox_idle_intervals; /**< idle intervals before shrinking/reclaiming a fast box */
+    opal_atomic_size_t fbox_bytes;    /**< shared memory currently used by send fast boxes */
+    opal_atomic_int32_t fbox_count;   /**< send fast boxes currently allocated (all sizes) */
+    opal_atomic_int32_t fbox_retiring; /**< replaced send fast boxes not yet retired */
+    unsigned int fbox_max_data;       /**< largest message that fits in any fast box */
 
     int single_copy_mechanism; /**< single copy mechanism to use */
 
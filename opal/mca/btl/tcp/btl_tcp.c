@@ -192,6 +192,7 @@ mca_btl_base_descriptor_t *mca_btl_tcp_alloc(struct mca_btl_base_module_t *btl,
     frag->base.des_segment_count = 1;
     frag->base.des_flags = flags;
     frag->base.order = MCA_BTL_NO_ORDER;
+    frag->zerocopy = false;
     frag->btl = (mca_btl_tcp_module_t *) btl;
     return (mca_btl_base_descriptor_t *) frag;
 }
@@ -266,6 +267,7 @@ mca_btl_base_descriptor_t *mca_btl_tcp_prepare_src(struct mca_btl_base_module_t
         }
 
         frag->segments[0].seg_len += max_data;
+        frag->zerocopy = false;
 
     } else {
 
@@ -281,6 +283,9 @@ mca_btl_base_descriptor_t *mca_btl_tcp_prepare_src(struct mca_btl_base_module_t
         frag->segments[1].seg_addr.pval = iov.iov_base;
         frag->segments[1].seg_len = max_data;
         frag->base.des_segment_count = 2;
+        /* the data is sent straight from the user buffer */
+        frag->zerocopy = (0 < mca_btl_tcp_component.tcp_zerocopy_threshold
+                          && max_data >= mca_btl_tcp_component.tcp_zerocopy_threshold);
     }
 
     frag->base.des_segments = frag->segments;
@@ -312,6 +317,7 @@ int mca_btl_tcp_send(struct mca_btl_base_module_t *btl, struct mca_btl_base_endp
     frag->iov_idx = 0;
     frag->iov_cnt = 1;
     frag->iov_ptr = frag->iov;
+    frag->zc_calls = frag->zc_pending = 0;
     frag->iov[0].iov_base = (IOVBASE_TYPE *) &frag->hdr;
     frag->iov[0].iov_len = sizeof(frag->hdr);
     frag->hdr.size = 0;
@@ -404,6 +410,9 @@ int mca_btl_tcp_put(mca_btl_base_module_t *btl, struct mca_btl_base_endpoint_t *
     frag->hdr.base.tag = MCA_BTL_TAG_BTL;
     frag->hdr.type = MCA_BTL_TCP_HDR_TYPE_PUT;
     frag->hdr.count = 1;
+    frag->zerocopy = (0 < mca_btl_tcp_component.tcp_zerocopy_threshold
+                      && size >= mca_btl_tcp_component.tcp_zerocopy_threshold);
+    frag->zc_calls = frag->zc_pending = 0;
     if (endpoint->endpoint_nbo) {
         MCA_BTL_TCP_HDR_HTON(frag->hdr);
     }
@@ -469,6 +478,8 @@ int mca_btl_tcp_get(mca_btl_base_module_t *btl, struct mca_btl_base_endpoint_t *
     frag->hdr.base.tag = MCA_BTL_TAG_BTL;
     frag->hdr.type = MCA_BTL_TCP_HDR_TYPE_GET;
     frag->hdr.count = 1;
+    frag->zerocopy = false;
+    frag->zc_calls = frag->zc_pending = 0;
     if (endpoint->endpoint_nbo) {
         MCA_BTL_TCP_HDR_HTON(frag->hdr);
     }
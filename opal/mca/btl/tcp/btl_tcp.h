@@ -42,6 +42,9 @@
 #ifdef HAVE_UNISTD_H
 #    include <unistd.h>
 #endif
+#ifdef HAVE_LINUX_ERRQUEUE_H
+#    include <linux/errqueue.h>
+#endif
 
 /* Open MPI includes */
 #include "opal/class/opal_free_list.h"
@@ -53,6 +56,17 @@
 #include "opal/util/fd.h"
 
 #define MCA_BTL_TCP_STATISTICS 0
+
+/* Zero-copy sends: MSG_ZEROCOPY, with completions on the socket error queue */
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#    define MCA_BTL_TCP_HAVE_ZEROCOPY 1
+#else
+#    define MCA_BTL_TCP_HAVE_ZEROCOPY 0
+#endif
+/* How long (ms) closing a socket waits for outstanding zero-copy
+ * notifications, and the poll interval while doing so */
+#define MCA_BTL_TCP_ZEROCOPY_CLOSE_TIMEOUT 100
+#define MCA_BTL_TCP_ZEROCOPY_CLOSE_POLL    10
 BEGIN_C_DECLS
 
 extern opal_event_base_t *mca_btl_tcp_event_base;
@@ -151,6 +165,9 @@ struct mca_btl_tcp_component_t {
      * that are not found?
      */
     bool report_all_unfound_interfaces;
+
+    /* minimum user data in a fragment to send it with MSG_ZEROCOPY (0: never) */
+    size_t tcp_zerocopy_threshold;
 };
 typedef struct mca_btl_tcp_component_t mca_btl_tcp_component_t;
 
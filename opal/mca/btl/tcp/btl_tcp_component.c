@@ -384,6 +384,16 @@ static int mca_btl_tcp_component_register(void)
         "Issue a warning for all unfound interfaces included in if_exclude", MCA_BASE_VAR_TYPE_BOOL,
         NULL, 0, 0, OPAL_INFO_LVL_2, MCA_BASE_VAR_SCOPE_READONLY,
         &mca_btl_tcp_component.report_all_unfound_interfaces);
+    mca_btl_tcp_component.tcp_zerocopy_threshold = 0;
+    (void) mca_base_component_var_register(
+        &mca_btl_tcp_component.super.btl_version, "zerocopy_threshold",
+        "Send fragments carrying at least this many bytes of user data with MSG_ZEROCOPY, "
+        "avoiding the copy into the socket buffer (Linux 4.14 or later; other systems, or "
+        "sockets that refuse it, keep using regular sends). The fragment completes once the "
+        "kernel reports through the socket error queue that it released the data. 0 means "
+        "zero-copy sends are never used",
+        MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, 0, OPAL_INFO_LVL_4, MCA_BASE_VAR_SCOPE_READONLY,
+        &mca_btl_tcp_component.tcp_zerocopy_threshold);
 
     mca_btl_tcp_module.super.btl_exclusivity = MCA_BTL_EXCLUSIVITY_LOW + 100;
     mca_btl_tcp_module.super.btl_eager_limit = 64 * 1024;
@@ -52,9 +52,13 @@
 #    include <sys/time.h>
 #endif /* HAVE_SYS_TIME_H */
 #include <time.h>
+#ifdef HAVE_POLL_H
+#    include <poll.h>
+#endif
 
 #include "opal/mca/btl/base/btl_base_error.h"
 #include "opal/util/event.h"
+#include "opal/util/minmax.h"
 #include "opal/util/net.h"
 #include "opal/util/printf.h"
 #include "opal/util/proc.h"
@@ -89,12 +93,16 @@ static void mca_btl_tcp_endpoint_construct(mca_btl_tcp_endpoint_t *endpoint)
     endpoint->endpoint_state = MCA_BTL_TCP_CLOSED;
     endpoint->endpoint_retries = 0;
     endpoint->endpoint_nbo = false;
+    endpoint->endpoint_zerocopy = false;
+    endpoint->endpoint_zc_next = 0;
+    endpoint->endpoint_zc_outstanding = 0;
 #if MCA_BTL_TCP_ENDPOINT_CACHE
     endpoint->endpoint_cache = NULL;
     endpoint->endpoint_cache_pos = NULL;
     endpoint->endpoint_cache_length = 0;
 #endif /* MCA_BTL_TCP_ENDPOINT_CACHE */
     OBJ_CONSTRUCT(&endpoint->endpoint_frags, opal_list_t);
+    OBJ_CONSTRUCT(&endpoint->endpoint_zc_frags, opal_list_t);
     OBJ_CONSTRUCT(&endpoint->endpoint_send_lock, opal_mutex_t);
     OBJ_CONSTRUCT(&endpoint->endpoint_recv_lock, opal_mutex_t);
 }
@@ -108,6 +116,7 @@ static void mca_btl_tcp_endpoint_destruct(mca_btl_tcp_endpoint_t *endpoint)
     mca_btl_tcp_endpoint_close(endpoint);
     mca_btl_tcp_proc_remove(endpoint->endpoint_proc, endpoint);
     OBJ_DESTRUCT(&endpoint->endpoint_frags);
+    OBJ_DESTRUCT(&endpoint->endpoint_zc_frags);
     OBJ_DESTRUCT(&endpoint->endpoint_send_lock);
     OBJ_DESTRUCT(&endpoint->endpoint_recv_lock);
 }
@@ -121,6 +130,9 @@ static int mca_btl_tcp_endpoint_start_connect(mca_btl_base_endpoint_t *);
 static void mca_btl_tcp_endpoint_connected(mca_btl_base_endpoint_t *);
 static void mca_btl_tcp_endpoint_recv_handler(int sd, short flags, void *user);
 static void mca_btl_tcp_endpoint_send_handler(int sd, short flags, void *user);
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+static void mca_btl_tcp_endpoint_zerocopy_progress(mca_btl_base_endpoint_t *btl_endpoint);
+#endif
 
 /*
  * diagnostics
@@ -338,6 +350,169 @@ static inline void mca_btl_tcp_endpoint_event_init(mca_btl_base_endpoint_t *btl_
                    mca_btl_tcp_endpoint_send_handler, btl_endpoint);
 }
 
+/*
+ * A fragment sent with MSG_ZEROCOPY is complete only once the kernel has
+ * released its pages, which is reported on the socket error queue. Park it
+ * until then; the completion callback is invoked from
+ * mca_btl_tcp_endpoint_zerocopy_progress(). Called with the send lock held.
+ */
+static inline bool mca_btl_tcp_endpoint_zerocopy_defer(mca_btl_base_endpoint_t *btl_endpoint,
+                                                       mca_btl_tcp_frag_t *frag)
+{
+    if (0 == frag->zc_pending) {
+        return false;
+    }
+    frag->base.des_flags |= MCA_BTL_DES_SEND_ALWAYS_CALLBACK;
+    opal_list_append(&btl_endpoint->endpoint_zc_frags, (opal_list_item_t *) frag);
+    return true;
+}
+
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+/*
+ * Number of the notification ids [lo, lo + count) (modulo 2^32) that belong
+ * to the fragment.
+ */
+static inline uint32_t mca_btl_tcp_frag_zerocopy_acked(mca_btl_tcp_frag_t *frag, uint32_t lo,
+                                                       uint32_t count)
+{
+    uint32_t start = lo - frag->zc_first;
+
+    if (start < frag->zc_calls) {
+        return opal_min(count, frag->zc_calls - start);
+    }
+    start = frag->zc_first - lo;
+    return (start < count ? opal_min(count - start, frag->zc_calls) : 0);
+}
+
+/*
+ * Account for the notification ids [lo, hi] and move the fragments they
+ * complete to the done list. Notifications usually arrive in order, but
+ * the kernel does not guarantee it. Called with the send lock held.
+ */
+static void mca_btl_tcp_endpoint_zerocopy_ack(mca_btl_base_endpoint_t *btl_endpoint, uint32_t lo,
+                                              uint32_t hi, opal_list_t *done)
+{
+    uint32_t count = hi - lo + 1;
+    mca_btl_tcp_frag_t *frag, *next;
+
+    btl_endpoint->endpoint_zc_outstanding -= count;
+
+    /* the fragment being sent may already have some of its ids notified */
+    frag = btl_endpoint->endpoint_send_frag;
+    if (NULL != frag) {
+        frag->zc_pending -= mca_btl_tcp_frag_zerocopy_acked(frag, lo, count);
+    }
+
+    OPAL_LIST_FOREACH_SAFE (frag, next, &btl_endpoint->endpoint_zc_frags, mca_btl_tcp_frag_t) {
+        frag->zc_pending -= mca_btl_tcp_frag_zerocopy_acked(frag, lo, count);
+        if (0 == frag->zc_pending) {
+            opal_list_remove_item(&btl_endpoint->endpoint_zc_frags, (opal_list_item_t *) frag);
+            opal_list_append(done, (opal_list_item_t *) frag);
+        }
+    }
+}
+
+/*
+ * Read the zero-copy notifications queued on the socket error queue and
+ * move the fragments they complete to the done list. Called with the send
+ * lock held, or from close when the endpoint is no longer in the event set.
+ */
+static void mca_btl_tcp_endpoint_zerocopy_read(mca_btl_base_endpoint_t *btl_endpoint,
+                                               opal_list_t *done)
+{
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_storage))];
+    struct sock_extended_err *serr;
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+
+    while (btl_endpoint->endpoint_sd >= 0 && 0 != btl_endpoint->endpoint_zc_outstanding) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(btl_endpoint->endpoint_sd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+        for (cmsg = CMSG_FIRSTHDR(&msg); NULL != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!(IPPROTO_IP == cmsg->cmsg_level && IP_RECVERR == cmsg->cmsg_type)
+                && !(IPPROTO_IPV6 == cmsg->cmsg_level && IPV6_RECVERR == cmsg->cmsg_type)) {
+                continue;
+            }
+            serr = (struct sock_extended_err *) CMSG_DATA(cmsg);
+            if (SO_EE_ORIGIN_ZEROCOPY != serr->ee_origin || 0 != serr->ee_errno) {
+                continue;
+            }
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                /* the kernel copied the data after all (e.g. loopback, or a
+                 * device without scatter-gather): zero-copy only adds the
+                 * notification overhead on this socket */
+                btl_endpoint->endpoint_zerocopy = false;
+            }
+            mca_btl_tcp_endpoint_zerocopy_ack(btl_endpoint, serr->ee_info, serr->ee_data, done);
+        }
+    }
+}
+
+/*
+ * Drain the zero-copy notifications from the socket error queue and
+ * complete the fragments whose data the kernel no longer references.
+ */
+static void mca_btl_tcp_endpoint_zerocopy_progress(mca_btl_base_endpoint_t *btl_endpoint)
+{
+    mca_btl_tcp_frag_t *frag;
+    opal_list_t done;
+
+    if (0 == btl_endpoint->endpoint_zc_outstanding) {
+        return;
+    }
+    /* if another thread is sending, the notifications are still there for
+     * the next time the socket wakes us up */
+    if (OPAL_THREAD_TRYLOCK(&btl_endpoint->endpoint_send_lock)) {
+        return;
+    }
+
+    OBJ_CONSTRUCT(&done, opal_list_t);
+    mca_btl_tcp_endpoint_zerocopy_read(btl_endpoint, &done);
+    OPAL_THREAD_UNLOCK(&btl_endpoint->endpoint_send_lock);
+
+    while (NULL != (frag = (mca_btl_tcp_frag_t *) opal_list_remove_first(&done))) {
+        MCA_BTL_TCP_COMPLETE_FRAG_SEND(frag);
+    }
+    OBJ_DESTRUCT(&done);
+}
+
+/*
+ * The socket is about to be closed: the notifications still to come are
+ * lost with it, while the kernel may still reference the pages of the
+ * parked fragments until the peer acknowledges the data. Wait a bounded
+ * time for the outstanding notifications. The fragments still parked
+ * afterwards are failed by the caller, their buffers cannot be handed back
+ * as sent.
+ */
+static void mca_btl_tcp_endpoint_zerocopy_drain(mca_btl_base_endpoint_t *btl_endpoint)
+{
+    struct pollfd pfd = {.fd = btl_endpoint->endpoint_sd, .events = 0};
+    int timeout = MCA_BTL_TCP_ZEROCOPY_CLOSE_TIMEOUT;
+    mca_btl_tcp_frag_t *frag;
+    opal_list_t done;
+
+    OBJ_CONSTRUCT(&done, opal_list_t);
+    mca_btl_tcp_endpoint_zerocopy_read(btl_endpoint, &done);
+    /* a pending error queue reports POLLERR */
+    for (; 0 != btl_endpoint->endpoint_zc_outstanding && timeout > 0;
+         timeout -= MCA_BTL_TCP_ZEROCOPY_CLOSE_POLL) {
+        if (poll(&pfd, 1, MCA_BTL_TCP_ZEROCOPY_CLOSE_POLL) < 0 && EINTR != opal_socket_errno) {
+            break;
+        }
+        mca_btl_tcp_endpoint_zerocopy_read(btl_endpoint, &done);
+    }
+
+    while (NULL != (frag = (mca_btl_tcp_frag_t *) opal_list_remove_first(&done))) {
+        MCA_BTL_TCP_COMPLETE_FRAG_SEND(frag);
+    }
+    OBJ_DESTRUCT(&done);
+}
+#endif
+
 /*
  * Attempt to send a fragment using a given endpoint. If the endpoint is not connected,
  * queue the fragment and start the connection as required.
@@ -367,6 +542,9 @@ int mca_btl_tcp_endpoint_send(mca_btl_base_endpoint_t *btl_endpoint, mca_btl_tcp
                 && mca_btl_tcp_frag_send(frag, btl_endpoint->endpoint_sd)) {
                 int btl_ownership = (frag->base.des_flags & MCA_BTL_DES_FLAGS_BTL_OWNERSHIP);
 
+                if (mca_btl_tcp_endpoint_zerocopy_defer(btl_endpoint, frag)) {
+                    break;
+                }
                 OPAL_THREAD_UNLOCK(&btl_endpoint->endpoint_send_lock);
                 if (frag->base.des_flags & MCA_BTL_DES_SEND_ALWAYS_CALLBACK) {
                     frag->base.des_cbfunc(&frag->btl->super, frag->endpoint, &frag->base, frag->rc);
@@ -561,6 +739,11 @@ void mca_btl_tcp_endpoint_close(mca_btl_base_endpoint_t *btl_endpoint)
         };
         mca_btl_tcp_endpoint_send_blocking(btl_endpoint, &fin_msg, sizeof(fin_msg));
     }
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+    if (btl_endpoint->endpoint_sd >= 0 && 0 != btl_endpoint->endpoint_zc_outstanding) {
+        mca_btl_tcp_endpoint_zerocopy_drain(btl_endpoint);
+    }
+#endif
 
     CLOSE_THE_SOCKET(btl_endpoint->endpoint_sd);
     btl_endpoint->endpoint_sd = -1;
@@ -583,6 +766,14 @@ void mca_btl_tcp_endpoint_close(mca_btl_base_endpoint_t *btl_endpoint)
             frag = (mca_btl_tcp_frag_t *) opal_list_remove_first(&btl_endpoint->endpoint_frags);
         }
         btl_endpoint->endpoint_send_frag = NULL;
+        while (NULL
+               != (frag = (mca_btl_tcp_frag_t *) opal_list_remove_first(
+                       &btl_endpoint->endpoint_zc_frags))) {
+            frag->base.des_cbfunc(&frag->btl->super, frag->endpoint, &frag->base, OPAL_ERR_UNREACH);
+            if (frag->base.des_flags & MCA_BTL_DES_FLAGS_BTL_OWNERSHIP) {
+                MCA_BTL_TCP_FRAG_RETURN(frag);
+            }
+        }
         /* Let's report the error upstream */
         if (NULL != btl_endpoint->endpoint_btl->tcp_error_cb) {
             btl_endpoint->endpoint_btl
@@ -590,8 +781,23 @@ void mca_btl_tcp_endpoint_close(mca_btl_base_endpoint_t *btl_endpoint)
                                btl_endpoint->endpoint_proc->proc_opal, "Socket closed");
         }
     } else {
+        mca_btl_tcp_frag_t *frag;
+
         btl_endpoint->endpoint_state = MCA_BTL_TCP_CLOSED;
+        /* the kernel did not release the pages of these zero-copy fragments
+         * before the socket went away: whether the peer got the data is not
+         * known, and the buffers may still be referenced */
+        while (NULL
+               != (frag = (mca_btl_tcp_frag_t *) opal_list_remove_first(
+                       &btl_endpoint->endpoint_zc_frags))) {
+            frag->base.des_cbfunc(&frag->btl->super, frag->endpoint, &frag->base, OPAL_ERR_UNREACH);
+            if (frag->base.des_flags & MCA_BTL_DES_FLAGS_BTL_OWNERSHIP) {
+                MCA_BTL_TCP_FRAG_RETURN(frag);
+            }
+        }
     }
+    btl_endpoint->endpoint_zerocopy = false;
+    btl_endpoint->endpoint_zc_outstanding = 0;
 }
 
 /*
@@ -608,6 +814,20 @@ static void mca_btl_tcp_endpoint_connected(mca_btl_base_endpoint_t *btl_endpoint
     btl_endpoint->endpoint_retries = 0;
     MCA_BTL_TCP_ENDPOINT_DUMP(1, btl_endpoint, true, "READY [endpoint_connected]");
 
+    /* notification ids restart with every socket */
+    btl_endpoint->endpoint_zc_next = 0;
+    btl_endpoint->endpoint_zc_outstanding = 0;
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+    if (0 < mca_btl_tcp_component.tcp_zerocopy_threshold) {
+        int optval = 0;
+        opal_socklen_t optlen = sizeof(optval);
+
+        btl_endpoint->endpoint_zerocopy = (0 == getsockopt(btl_endpoint->endpoint_sd, SOL_SOCKET,
+                                                           SO_ZEROCOPY, (char *) &optval, &optlen)
+                                           && 0 != optval);
+    }
+#endif
+
     if (opal_list_get_size(&btl_endpoint->endpoint_frags) > 0) {
         if (NULL == btl_endpoint->endpoint_send_frag) {
             btl_endpoint->endpoint_send_frag = (mca_btl_tcp_frag_t *) opal_list_remove_first(
@@ -714,6 +934,18 @@ void mca_btl_tcp_set_socket_options(int sd)
                    opal_socket_errno));
     }
 #endif
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+    /* Set on the listen socket as well: accepted sockets inherit it, and
+     * older kernels refuse to change it once the socket is connected. A
+     * kernel without support simply keeps this socket on regular sends. */
+    if (0 < mca_btl_tcp_component.tcp_zerocopy_threshold) {
+        int optval3 = 1;
+        if (setsockopt(sd, SOL_SOCKET, SO_ZEROCOPY, (char *) &optval3, sizeof(optval3)) < 0) {
+            BTL_VERBOSE(("setsockopt(SO_ZEROCOPY) failed: %s (%d)", strerror(opal_socket_errno),
+                         opal_socket_errno));
+        }
+    }
+#endif
 }
 
 /*
@@ -951,6 +1183,11 @@ static void mca_btl_tcp_endpoint_recv_handler(int sd, short flags, void *user)
         return;
     }
 
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+    /* zero-copy notifications wake us up as socket errors */
+    mca_btl_tcp_endpoint_zerocopy_progress(btl_endpoint);
+#endif
+
     /**
      * There is an extremely rare race condition here, that can only be
      * triggered during the initialization. If the two processes start their
@@ -1110,6 +1347,9 @@ static void mca_btl_tcp_endpoint_send_handler(int sd, short flags, void *user)
             /* progress any pending sends */
             btl_endpoint->endpoint_send_frag = (mca_btl_tcp_frag_t *) opal_list_remove_first(
                 &btl_endpoint->endpoint_frags);
+            if (mca_btl_tcp_endpoint_zerocopy_defer(btl_endpoint, frag)) {
+                continue;
+            }
 
             /* if required - update request status and release fragment */
             OPAL_THREAD_UNLOCK(&btl_endpoint->endpoint_send_lock);
@@ -1149,4 +1389,7 @@ static void mca_btl_tcp_endpoint_send_handler(int sd, short flags, void *user)
         break;
     }
     OPAL_THREAD_UNLOCK(&btl_endpoint->endpoint_send_lock);
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+    mca_btl_tcp_endpoint_zerocopy_progress(btl_endpoint);
+#endif
 }
@@ -72,6 +72,10 @@ struct mca_btl_base_endpoint_t {
     opal_event_t endpoint_send_event;   /**< event for async processing of send frags */
     opal_event_t endpoint_recv_event;   /**< event for async processing of recv frags */
     bool endpoint_nbo;                  /**< convert headers to network byte order? */
+    bool endpoint_zerocopy;             /**< socket accepts MSG_ZEROCOPY sends */
+    uint32_t endpoint_zc_next;          /**< notification id of the next zero-copy sendmsg */
+    uint32_t endpoint_zc_outstanding;   /**< zero-copy sendmsg calls not yet notified */
+    opal_list_t endpoint_zc_frags; /**< sent frags waiting for the kernel to release their data */
 };
 
 typedef struct mca_btl_base_endpoint_t mca_btl_base_endpoint_t;
@@ -110,6 +110,12 @@ bool mca_btl_tcp_frag_send(mca_btl_tcp_frag_t *frag, int sd)
                      .msg_iovlen = frag->iov_cnt };
     int msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
 
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+    if (frag->zerocopy && frag->endpoint->endpoint_zerocopy) {
+        msg_flags |= MSG_ZEROCOPY;
+    }
+#endif
+
     /* non-blocking write, continue if interrupted */
     do {
         /* Use sendmsg to avoid issues with SIGPIPE as described in
@@ -130,6 +136,15 @@ bool mca_btl_tcp_frag_send(mca_btl_tcp_frag_t *frag, int sd)
                 frag->endpoint->endpoint_state = MCA_BTL_TCP_FAILED;
                 mca_btl_tcp_endpoint_close(frag->endpoint);
                 return false;
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+            case ENOBUFS:
+                if (msg_flags & MSG_ZEROCOPY) {
+                    /* out of memory to pin the pages: copy this part */
+                    msg_flags &= ~MSG_ZEROCOPY;
+                    continue;
+                }
+                /* fall through */
+#endif
             default:
                 BTL_PEER_ERROR(frag->endpoint->endpoint_proc->proc_opal,
                                ("mca_btl_tcp_frag_send: sendmsg failed: %s (%d)",
@@ -142,6 +157,21 @@ bool mca_btl_tcp_frag_send(mca_btl_tcp_frag_t *frag, int sd)
         }
     } while (cnt < 0);
 
+#if MCA_BTL_TCP_HAVE_ZEROCOPY
+    /* every successful zero-copy sendmsg is assigned the next notification
+     * id of the socket; the fragment is only complete once all of its ids
+     * have been reported on the error queue */
+    if (msg_flags & MSG_ZEROCOPY) {
+        if (0 == frag->zc_calls) {
+            frag->zc_first = frag->endpoint->endpoint_zc_next;
+        }
+        frag->endpoint->endpoint_zc_next++;
+        frag->endpoint->endpoint_zc_outstanding++;
+        frag->zc_calls++;
+        frag->zc_pending++;
+    }
+#endif
+
     /* if the write didn't complete - update the iovec state */
     num_vecs = frag->iov_cnt;
     for (i = 0; i < num_vecs; i++) {
@@ -57,6 +57,10 @@ struct mca_btl_tcp_frag_t {
     size_t size;
     uint16_t next_step;
     int rc;
+    bool zerocopy;       /**< send the user data with MSG_ZEROCOPY, if the socket allows it */
+    uint32_t zc_first;   /**< notification id of the first zero-copy sendmsg */
+    uint32_t zc_calls;   /**< number of zero-copy sendmsg calls */
+    uint32_t zc_pending; /**< zero-copy notifications not yet received */
     opal_free_list_t *my_list;
     /* fake rdma completion */
     struct {
@@ -37,7 +37,7 @@ AC_DEFUN([MCA_opal_btl_tcp_CONFIG],[
 #include <netinet/in.h>
 #endif
 		   ])
-    AC_CHECK_HEADERS([sys/ucred.h sys/socket.h])
+    AC_CHECK_HEADERS([sys/ucred.h sys/socket.h linux/errqueue.h])
     AC_CHECK_DECLS([getpeereid],
                    [AC_DEFINE(HAVE_GETPEEREID, 1, [Define to 1 if you have the `getpeereid' function.])],
                     ,[
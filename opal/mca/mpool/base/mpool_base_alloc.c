@@ -28,15 +28,52 @@
 #include "mpool_base_tree.h"
 #include "opal/align.h"
 #include "opal/mca/mpool/mpool.h"
+#include "opal/mca/rcache/base/base.h"
 #include "opal/mca/threads/mutex.h"
 #include "opal/util/info.h"
 #include <stdint.h>
 #include <string.h>
 
+/* register the memory with every registration cache (up to MCA_MPOOL_BASE_TREE_MAX), the
+ * registrations stay in the caches and are found by the first transfers */
+static void register_tree_item(mca_mpool_base_tree_item_t *mpool_tree_item, void *mem,
+                               size_t size)
+{
+    mca_rcache_base_selected_module_t *sm;
+    mca_rcache_base_registration_t *reg;
+    mca_rcache_base_module_t *rcache;
+    int rc;
+
+    OPAL_LIST_FOREACH (sm, &mca_rcache_base_modules, mca_rcache_base_selected_module_t) {
+        if (MCA_MPOOL_BASE_TREE_MAX == mpool_tree_item->count) {
+            break;
+        }
+
+        rcache = sm->rcache_module;
+        if (NULL == rcache->rcache_register) {
+            continue;
+        }
+
+        rc = rcache->rcache_register(rcache, mem, size, 0, MCA_RCACHE_ACCESS_ANY, &reg);
+        if (OPAL_SUCCESS != rc) {
+            /* registration caches that fail to register the region are ignored */
+            continue;
+        }
+
+        mpool_tree_item->rcaches[mpool_tree_item->count] = rcache;
+        mpool_tree_item->regs[mpool_tree_item->count++] = reg;
+    }
+}
+
 static void unregister_tree_item(mca_mpool_base_tree_item_t *mpool_tree_item)
 {
     mca_mpool_base_module_t *mpool;
 
+    for (int i = 0; i < mpool_tree_item->count; ++i) {
+        mca_rcache_base_module_t *rcache = mpool_tree_item->rcaches[i];
+        rcache->rcache_deregister(rcache, mpool_tree_item->regs[i]);
+    }
+
     mpool = mpool_tree_item->mpool;
     mpool->mpool_free(mpool, mpool_tree_item->key);
 }
@@ -49,7 +86,9 @@ static void unregister_tree_item(mca_mpool_base_tree_item_t *mpool_tree_item)
  * the memory with the optionally named mpool or malloc and try to register the
  * pointer with as many registration caches as possible. Registration caches that
  * fail to register the region will be ignored. The mpool name can optionally be
- * specified in the info object.
+ * specified in the info object. The registration is done when the memory is
+ * allocated if the "mpool_preregister" info key or the mpool_base_preregister
+ * parameter is true.
  *
  * @param size the size of the memory area to allocate
  * @param info an info object which tells us what kind of memory to allocate
@@ -64,6 +103,7 @@ void *mca_mpool_base_alloc(size_t size, opal_info_t *info, const char *hints)
     void *mem = NULL;
     opal_cstring_t *align_info_str;
     long long memory_alignment = OPAL_ALIGN_MIN;
+    bool preregister = mca_mpool_base_preregister;
 
     mpool_tree_item = mca_mpool_base_tree_item_get();
     if (!mpool_tree_item) {
@@ -82,6 +122,8 @@ void *mca_mpool_base_alloc(size_t size, opal_info_t *info, const char *hints)
                 memory_alignment = tmp_align;
             }
         }
+
+        (void) opal_info_get_bool(info, "mpool_preregister", &preregister, &flag);
     }
 
     mpool_tree_item->num_bytes = size;
@@ -94,16 +136,22 @@ void *mca_mpool_base_alloc(size_t size, opal_info_t *info, const char *hints)
 
     if (NULL == mem) {
         /* fall back to default mpool */
-        mem = mca_mpool_base_default_module->mpool_alloc(mca_mpool_base_default_module,
-                                                         size, memory_alignment, 0);
+        mpool = mca_mpool_base_default_module;
+        mem = mpool->mpool_alloc(mpool, size, memory_alignment, 0);
+        if (NULL == mem || !preregister) {
+            mca_mpool_base_tree_item_put(mpool_tree_item);
+            return mem;
+        }
+    }
 
-        mca_mpool_base_tree_item_put(mpool_tree_item);
-    } else {
-        mpool_tree_item->mpool = mpool;
-        mpool_tree_item->key = mem;
-        mca_mpool_base_tree_insert(mpool_tree_item);
+    if (preregister) {
+        register_tree_item(mpool_tree_item, mem, size);
     }
 
+    mpool_tree_item->mpool = mpool;
+    mpool_tree_item->key = mem;
+    mca_mpool_base_tree_insert(mpool_tree_item);
+
     return mem;
 }
 
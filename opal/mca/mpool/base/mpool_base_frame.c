@@ -53,6 +53,7 @@ opal_list_t mca_mpool_base_modules = {{0}};
 static char *mca_mpool_base_default_hints;
 
 int mca_mpool_base_default_priority = 50;
+bool mca_mpool_base_preregister = false;
 
 OBJ_CLASS_INSTANCE(mca_mpool_base_selected_module_t, opal_list_item_t, NULL, NULL);
 
@@ -71,6 +72,16 @@ static int mca_mpool_base_register(mca_base_register_flag_t flags)
                                  NULL, 0, MCA_BASE_VAR_FLAG_INTERNAL, OPAL_INFO_LVL_9,
                                  MCA_BASE_VAR_SCOPE_LOCAL, &mca_mpool_base_default_priority);
 
+    mca_mpool_base_preregister = false;
+    (void) mca_base_var_register("opal", "mpool", "base", "preregister",
+                                 "Register memory from MPI_Alloc_mem with the registration caches "
+                                 "of the network transports when it is allocated, so the first "
+                                 "transfers from it do not pay for the registration. Can be set "
+                                 "for a single allocation with the \"mpool_preregister\" info key "
+                                 "(default: false)",
+                                 MCA_BASE_VAR_TYPE_BOOL, NULL, 0, 0, OPAL_INFO_LVL_5,
+                                 MCA_BASE_VAR_SCOPE_LOCAL, &mca_mpool_base_preregister);
+
     return OPAL_SUCCESS;
 }
 
@@ -57,6 +57,11 @@ struct mca_rcache_grdma_component_t {
     char *rcache_name;
     bool print_stats;
     int leave_pinned;
+    /* statistics of all modules, exposed as performance variables */
+    opal_atomic_size_t cache_hits;
+    opal_atomic_size_t cache_misses;
+    opal_atomic_size_t cache_evictions;
+    opal_atomic_size_t bytes_registered;
 };
 typedef struct mca_rcache_grdma_component_t mca_rcache_grdma_component_t;
 
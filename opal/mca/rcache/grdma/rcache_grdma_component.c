@@ -25,6 +25,7 @@
 #define OPAL_DISABLE_ENABLE_MEM_DEBUG 1
 #include "opal_config.h"
 #include "opal/mca/base/base.h"
+#include "opal/mca/base/mca_base_pvar.h"
 #include "opal/runtime/opal_params.h"
 #include "rcache_grdma.h"
 #ifdef HAVE_UNISTD_H
@@ -83,6 +84,39 @@ static int grdma_register(void)
         NULL, 0, 0, OPAL_INFO_LVL_9, MCA_BASE_VAR_SCOPE_READONLY,
         &mca_rcache_grdma_component.print_stats);
 
+    mca_rcache_grdma_component.cache_hits = 0;
+    (void) mca_base_component_pvar_register(
+        &mca_rcache_grdma_component.super.rcache_version, "cache_hits",
+        "Number of registrations found in the registration cache", OPAL_INFO_LVL_5,
+        MCA_BASE_PVAR_CLASS_COUNTER, MCA_BASE_VAR_TYPE_UNSIGNED_LONG, NULL,
+        MCA_BASE_VAR_BIND_NO_OBJECT, MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+        NULL, NULL, NULL, (void *) &mca_rcache_grdma_component.cache_hits);
+
+    mca_rcache_grdma_component.cache_misses = 0;
+    (void) mca_base_component_pvar_register(
+        &mca_rcache_grdma_component.super.rcache_version, "cache_misses",
+        "Number of registrations not found in the registration cache", OPAL_INFO_LVL_5,
+        MCA_BASE_PVAR_CLASS_COUNTER, MCA_BASE_VAR_TYPE_UNSIGNED_LONG, NULL,
+        MCA_BASE_VAR_BIND_NO_OBJECT, MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+        NULL, NULL, NULL, (void *) &mca_rcache_grdma_component.cache_misses);
+
+    mca_rcache_grdma_component.cache_evictions = 0;
+    (void) mca_base_component_pvar_register(
+        &mca_rcache_grdma_component.super.rcache_version, "cache_evictions",
+        "Number of unused registrations evicted from the registration cache to make room "
+        "for new ones", OPAL_INFO_LVL_5,
+        MCA_BASE_PVAR_CLASS_COUNTER, MCA_BASE_VAR_TYPE_UNSIGNED_LONG, NULL,
+        MCA_BASE_VAR_BIND_NO_OBJECT, MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+        NULL, NULL, NULL, (void *) &mca_rcache_grdma_component.cache_evictions);
+
+    mca_rcache_grdma_component.bytes_registered = 0;
+    (void) mca_base_component_pvar_register(
+        &mca_rcache_grdma_component.super.rcache_version, "bytes_registered",
+        "Number of bytes currently registered through the registration cache", OPAL_INFO_LVL_5,
+        MCA_BASE_PVAR_CLASS_SIZE, MCA_BASE_VAR_TYPE_UNSIGNED_LONG, NULL,
+        MCA_BASE_VAR_BIND_NO_OBJECT, MCA_BASE_PVAR_FLAG_READONLY | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+        NULL, NULL, NULL, (void *) &mca_rcache_grdma_component.bytes_registered);
+
     return OPAL_SUCCESS;
 }
 
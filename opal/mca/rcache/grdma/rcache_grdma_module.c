@@ -141,6 +141,8 @@ static inline int dereg_mem(mca_rcache_base_registration_t *reg)
 
     rc = rcache_grdma->resources.deregister_mem(rcache_grdma->resources.reg_data, reg);
     if (OPAL_LIKELY(OPAL_SUCCESS == rc)) {
+        (void) opal_atomic_fetch_add_size_t(&mca_rcache_grdma_component.bytes_registered,
+                                            -(size_t) (reg->bound - reg->base + 1));
         opal_free_list_return_mt(&rcache_grdma->reg_list, (opal_free_list_item_t *) reg);
     }
 
@@ -215,6 +217,7 @@ static inline bool mca_rcache_grdma_evict_lru_local(mca_rcache_grdma_cache_t *ca
 
     (void) dereg_mem(old_reg);
     rcache_grdma->stat_evicted++;
+    (void) opal_atomic_fetch_add_size_t(&mca_rcache_grdma_component.cache_evictions, 1);
 
     return true;
 }
@@ -295,6 +298,7 @@ static int mca_rcache_grdma_check_cached(mca_rcache_base_registration_t *grdma_r
 
     /* This segment fits fully within an existing segment. */
     (void) opal_atomic_fetch_add_32((opal_atomic_int32_t *) &rcache_grdma->stat_cache_hit, 1);
+    (void) opal_atomic_fetch_add_size_t(&mca_rcache_grdma_component.cache_hits, 1);
     OPAL_OUTPUT_VERBOSE((MCA_BASE_VERBOSE_TRACE, opal_rcache_base_framework.framework_output,
                          "returning existing registration %p. references %d", (void *) grdma_reg,
                          ref_cnt));
@@ -357,6 +361,7 @@ static int mca_rcache_grdma_register(mca_rcache_base_module_t *rcache, void *add
         access_flags = find_args.access_flags;
 
         OPAL_THREAD_ADD_FETCH32((opal_atomic_int32_t *) &rcache_grdma->stat_cache_miss, 1);
+        (void) opal_atomic_fetch_add_size_t(&mca_rcache_grdma_component.cache_misses, 1);
     }
 
     item = opal_free_list_get_mt(&rcache_grdma->reg_list);
@@ -407,6 +412,8 @@ static int mca_rcache_grdma_register(mca_rcache_base_module_t *rcache, void *add
                          "created new registration %p for region {%p, %p} with flags 0x%x",
                          (void *) grdma_reg, (void *) base, (void *) bound, grdma_reg->flags));
 
+    (void) opal_atomic_fetch_add_size_t(&mca_rcache_grdma_component.bytes_registered,
+                                        bound - base + 1);
     *reg = grdma_reg;
 
     return OPAL_SUCCESS;
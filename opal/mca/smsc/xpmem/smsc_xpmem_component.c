@@ -11,6 +11,7 @@
  */
 #include "opal_config.h"
 
+#include "opal/mca/base/mca_base_pvar.h"
 #include "opal/mca/smsc/base/base.h"
 #include "opal/mca/smsc/xpmem/smsc_xpmem_internal.h"
 #include "opal/util/minmax.h"
@@ -46,6 +47,19 @@ mca_smsc_xpmem_component_t mca_smsc_xpmem_component = {
 };
 MCA_BASE_COMPONENT_INIT(opal, smsc, xpmem)
 
+static void mca_smsc_xpmem_register_counter(const char *name, const char *desc,
+                                            unsigned long long *counter)
+{
+    *counter = 0;
+    (void) mca_base_component_pvar_register(&mca_smsc_xpmem_component.super.smsc_version, name,
+                                            desc, OPAL_INFO_LVL_5, MCA_BASE_PVAR_CLASS_COUNTER,
+                                            MCA_BASE_VAR_TYPE_UNSIGNED_LONG_LONG, NULL,
+                                            MCA_BASE_VAR_BIND_NO_OBJECT,
+                                            MCA_BASE_PVAR_FLAG_READONLY
+                                                | MCA_BASE_PVAR_FLAG_CONTINUOUS,
+                                            NULL, NULL, NULL, (void *) counter);
+}
+
 static int mca_smsc_xpmem_component_register(void)
 {
     mca_smsc_xpmem_component.log_attach_align = 23;
@@ -66,6 +80,28 @@ static int mca_smsc_xpmem_component_register(void)
         MCA_BASE_VAR_TYPE_UINT64_T, /*enumerator=*/NULL, /*bind=*/0, MCA_BASE_VAR_FLAG_SETTABLE,
         OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_LOCAL, &mca_smsc_xpmem_component.memcpy_chunk_size);
 
+    mca_smsc_xpmem_component.cache_max_entries = 1024;
+    (void) mca_base_component_var_register(
+        &mca_smsc_xpmem_component.super.smsc_version, "cache_max_entries",
+        "Maximum number of persistent attachments kept for each peer. When a new attachment would "
+        "exceed it the least recently used one that is not in use is detached. 0 means no limit "
+        "(default: 1024)",
+        MCA_BASE_VAR_TYPE_UNSIGNED_INT, /*enumerator=*/NULL, /*bind=*/0, MCA_BASE_VAR_FLAG_SETTABLE,
+        OPAL_INFO_LVL_5, MCA_BASE_VAR_SCOPE_LOCAL, &mca_smsc_xpmem_component.cache_max_entries);
+
+    mca_smsc_xpmem_register_counter("cache_hits",
+                                    "Number of lookups of a peer region that found an existing "
+                                    "xpmem attachment",
+                                    &mca_smsc_xpmem_component.cache_hits);
+    mca_smsc_xpmem_register_counter("cache_misses",
+                                    "Number of lookups of a peer region that had to create a new "
+                                    "xpmem attachment",
+                                    &mca_smsc_xpmem_component.cache_misses);
+    mca_smsc_xpmem_register_counter("cache_evictions",
+                                    "Number of xpmem attachments detached because the cache of a "
+                                    "peer was full",
+                                    &mca_smsc_xpmem_component.cache_evictions);
+
     mca_smsc_base_register_default_params(&mca_smsc_xpmem_component.super,
                                           mca_smsc_xpmem_default_priority);
     return OPAL_SUCCESS;
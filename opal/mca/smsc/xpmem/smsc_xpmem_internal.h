@@ -15,7 +15,9 @@
 
 #include "opal/mca/smsc/xpmem/smsc_xpmem.h"
 
+#include "opal/class/opal_list.h"
 #include "opal/mca/rcache/base/rcache_base_vma.h"
+#include "opal/mca/threads/mutex.h"
 #if defined(HAVE_XPMEM_H)
 #    include <xpmem.h>
 
@@ -46,12 +48,30 @@ struct mca_smsc_xpmem_endpoint_t {
     uintptr_t address_max;
     /** cache of xpmem attachments created using this endpoint */
     mca_rcache_base_vma_module_t *vma_module;
+    /** persistent attachments in the cache, bounded by cache_max_entries */
+    opal_list_t lru;
+    /** protects the lru list */
+    opal_mutex_t lru_lock;
+    /** lookup counter used to order the attachments by last use */
+    uint64_t clock;
 };
 
 typedef struct mca_smsc_xpmem_endpoint_t mca_smsc_xpmem_endpoint_t;
 
 OBJ_CLASS_DECLARATION(mca_smsc_xpmem_endpoint_t);
 
+struct mca_smsc_xpmem_reg_t {
+    mca_rcache_base_registration_t super;
+    /** endpoint clock at the last lookup of this attachment */
+    uint64_t last_use;
+    /** attachment is on the lru list of its endpoint */
+    bool in_lru;
+};
+
+typedef struct mca_smsc_xpmem_reg_t mca_smsc_xpmem_reg_t;
+
+OBJ_CLASS_DECLARATION(mca_smsc_xpmem_reg_t);
+
 struct mca_smsc_xpmem_component_t {
     mca_smsc_component_t super;
 
@@ -65,6 +85,14 @@ struct mca_smsc_xpmem_component_t {
     /** maximum size that will be used with a single memcpy call. on some systems we see better
      * performance if we chunk the copy into multiple memcpy calls. */
     uint64_t memcpy_chunk_size;
+    /** maximum number of persistent attachments cached per peer (0: no limit). the least recently
+     * used idle attachment is detached when a new one would exceed it. */
+    unsigned int cache_max_entries;
+
+    /** performance variables */
+    unsigned long long cache_hits;
+    unsigned long long cache_misses;
+    unsigned long long cache_evictions;
 };
 
 typedef struct mca_smsc_xpmem_component_t mca_smsc_xpmem_component_t;
@@ -27,7 +27,99 @@
 #include "opal/util/minmax.h"
 #include "opal/util/sys_limits.h"
 
-OBJ_CLASS_INSTANCE(mca_smsc_xpmem_endpoint_t, opal_object_t, NULL, NULL);
+/* largest number of existing attachments merged into a new one */
+#define MCA_SMSC_XPMEM_MAX_MERGE 16
+
+static void mca_smsc_xpmem_endpoint_construct(mca_smsc_xpmem_endpoint_t *endpoint)
+{
+    OBJ_CONSTRUCT(&endpoint->lru, opal_list_t);
+    OBJ_CONSTRUCT(&endpoint->lru_lock, opal_mutex_t);
+    endpoint->clock = 0;
+}
+
+static void mca_smsc_xpmem_endpoint_destruct(mca_smsc_xpmem_endpoint_t *endpoint)
+{
+    OBJ_DESTRUCT(&endpoint->lru);
+    OBJ_DESTRUCT(&endpoint->lru_lock);
+}
+
+OBJ_CLASS_INSTANCE(mca_smsc_xpmem_endpoint_t, opal_object_t, mca_smsc_xpmem_endpoint_construct,
+                   mca_smsc_xpmem_endpoint_destruct);
+
+static void mca_smsc_xpmem_reg_construct(mca_smsc_xpmem_reg_t *reg)
+{
+    reg->last_use = 0;
+    reg->in_lru = false;
+}
+
+OBJ_CLASS_INSTANCE(mca_smsc_xpmem_reg_t, mca_rcache_base_registration_t,
+                   mca_smsc_xpmem_reg_construct, NULL);
+
+static void mca_smsc_xpmem_lru_remove(mca_smsc_xpmem_endpoint_t *endpoint,
+                                      mca_smsc_xpmem_reg_t *reg)
+{
+    OPAL_THREAD_LOCK(&endpoint->lru_lock);
+    if (reg->in_lru) {
+        opal_list_remove_item(&endpoint->lru, &reg->super.super.super);
+        reg->in_lru = false;
+    }
+    OPAL_THREAD_UNLOCK(&endpoint->lru_lock);
+}
+
+/* Add a new persistent attachment to the cache of the endpoint and detach the least recently
+ * used idle attachments above the limit. Hits only update last_use (without atomics, so the
+ * order is approximate with threads) and the list stays in insertion order: the lookup does not
+ * need the lock, and the scan for a victim only happens when a new attachment is made. */
+static void mca_smsc_xpmem_lru_insert(mca_smsc_xpmem_endpoint_t *endpoint,
+                                      mca_smsc_xpmem_reg_t *reg)
+{
+    size_t max_entries = mca_smsc_xpmem_component.cache_max_entries;
+    mca_smsc_xpmem_reg_t *item, *victim;
+    opal_list_t victims;
+
+    OBJ_CONSTRUCT(&victims, opal_list_t);
+
+    OPAL_THREAD_LOCK(&endpoint->lru_lock);
+    opal_list_append(&endpoint->lru, &reg->super.super.super);
+    reg->in_lru = true;
+
+    while (0 < max_entries && opal_list_get_size(&endpoint->lru) > max_entries) {
+        victim = NULL;
+        OPAL_LIST_FOREACH (item, &endpoint->lru, mca_smsc_xpmem_reg_t) {
+            /* only the persistent reference left: nobody is using it */
+            if (item != reg && 1 == item->super.ref_count
+                && (NULL == victim || item->last_use < victim->last_use)) {
+                victim = item;
+            }
+        }
+
+        if (NULL == victim) {
+            break;
+        }
+
+        opal_list_remove_item(&endpoint->lru, &victim->super.super.super);
+        victim->in_lru = false;
+
+        /* if another thread already invalidated it, that thread drops the persistent reference */
+        uint32_t old_flags = opal_atomic_fetch_or_32(
+            (volatile opal_atomic_int32_t *) &victim->super.flags, MCA_RCACHE_FLAGS_INVALID);
+        if (!(old_flags & MCA_RCACHE_FLAGS_INVALID)) {
+            opal_list_append(&victims, &victim->super.super.super);
+        }
+    }
+    OPAL_THREAD_UNLOCK(&endpoint->lru_lock);
+
+    while (NULL != (victim = (mca_smsc_xpmem_reg_t *) opal_list_remove_first(&victims))) {
+        opal_output_verbose(MCA_BASE_VERBOSE_INFO, opal_smsc_base_framework.framework_output,
+                            "mca_smsc_xpmem_lru_insert: evicting region mapping for endpoint %p "
+                            "address range %p-%p",
+                            (void *) endpoint, victim->super.base, victim->super.bound);
+        ++mca_smsc_xpmem_component.cache_evictions;
+        mca_smsc_xpmem_unmap_peer_region(&victim->super);
+    }
+
+    OBJ_DESTRUCT(&victims);
+}
 
 mca_smsc_endpoint_t *mca_smsc_xpmem_get_endpoint(opal_proc_t *peer_proc)
 {
@@ -95,67 +187,67 @@ void *mca_smsc_xpmem_map_peer_region(mca_smsc_endpoint_t *endpoint, uint64_t fla
             /* Registration is being deleted by another thread
              * in mca_smsc_xpmem_unmap_peer_region, ignore it. */
             reg = NULL;
+        } else {
+            ((mca_smsc_xpmem_reg_t *) reg)->last_use = ++xpmem_endpoint->clock;
+            ++mca_smsc_xpmem_component.cache_hits;
         }
     } else {
         /* If there is a registration that overlaps with the requested range, but
          * does not fully cover it, we destroy it and make in its place a new one
          * that covers both the existing and the new range. */
 
-        /* The search settings below will also match areas that would be right next to the
-         * new one, which aren't technically overlapping, but are uniteable under a single
-         * area. Whether we want this is debatable, as re-establishing an XPMEM attachment
-         * can incur significant overhead. The current choice matches legacy behaviour. */
-
-        /* Ideally, we would want a find() method capable of partial matching */
-
-        uintptr_t find_base[4] = {base, bound};
-        int n_find_bases = 2;
-        if(base > 0) {
-            find_base[n_find_bases++] = base - 1;
-        }
-        if(bound < (uintptr_t) -1) {
-            find_base[n_find_bases++] = bound + 1;
-        }
-
-        for (int i = 0; i < n_find_bases; i++) {
-            mca_rcache_base_registration_t *ov_reg = NULL;
-
-            rc = mca_rcache_base_vma_find(vma_module, (void *) find_base[i], 1, &ov_reg);
-            assert(OPAL_SUCCESS == rc);
-
-            if (ov_reg) {
-                /* Found an overlapping area. Set the invalid flag, to mark the deletion
-                 * of this old registration (will eventually take place in unmap_peer_region).
-                 * If another thread has already marked deletion, do nothing. */
-
-                uint32_t old_flags = opal_atomic_fetch_or_32(
-                    (volatile opal_atomic_int32_t *) &ov_reg->flags, MCA_RCACHE_FLAGS_INVALID);
-
-                if (!(old_flags & MCA_RCACHE_FLAGS_INVALID)) {
-                    base = opal_min(base, (uintptr_t) ov_reg->base);
-                    bound = opal_max(bound, (uintptr_t) ov_reg->bound);
-
-                    /* unmap_peer_region will decrement the ref count and dealloc the attachment
-                     * if it drops to 0. But we didn't increment the ref count when we found the
-                     * reg as is customary. If PERSIST was set, there is superfluous ref present
-                     * from when we initialized ref_count to 2 instead of 1, so we good. If not,
-                     * manually add the missing reference here; otherwise the count would drop to
-                     * -1, or the reg might be deleted while still in use elsewhere. */
-                    if (!(MCA_RCACHE_FLAGS_PERSIST & ov_reg->flags))
-                        opal_atomic_add(&ov_reg->ref_count, 1);
-
-                    mca_smsc_xpmem_unmap_peer_region(ov_reg);
-                }
+        /* The search below also matches areas that are right next to the new one, which
+         * aren't technically overlapping, but are uniteable under a single area. Merging them
+         * keeps the number of attachments low, at the cost of re-establishing an XPMEM
+         * attachment. This matches legacy behaviour. */
+        mca_rcache_base_registration_t *ov_regs[MCA_SMSC_XPMEM_MAX_MERGE];
+        uintptr_t find_base = (base > 0) ? base - 1 : base;
+        uintptr_t find_bound = (bound < (uintptr_t) -1) ? bound + 1 : bound;
+        int n_ov_regs;
+
+        n_ov_regs = mca_rcache_base_vma_find_all(vma_module, (void *) find_base,
+                                                 find_bound - find_base + 1, ov_regs,
+                                                 MCA_SMSC_XPMEM_MAX_MERGE);
+
+        for (int i = 0; i < n_ov_regs; i++) {
+            mca_rcache_base_registration_t *ov_reg = ov_regs[i];
+
+            /* Found an overlapping area. Set the invalid flag, to mark the deletion
+             * of this old registration (will eventually take place in unmap_peer_region).
+             * If another thread has already marked deletion, do nothing. */
+
+            uint32_t old_flags = opal_atomic_fetch_or_32(
+                (volatile opal_atomic_int32_t *) &ov_reg->flags, MCA_RCACHE_FLAGS_INVALID);
+
+            if (!(old_flags & MCA_RCACHE_FLAGS_INVALID)) {
+                base = opal_min(base, (uintptr_t) ov_reg->base);
+                bound = opal_max(bound, (uintptr_t) ov_reg->bound);
+
+                mca_smsc_xpmem_lru_remove(xpmem_endpoint, (mca_smsc_xpmem_reg_t *) ov_reg);
+
+                /* unmap_peer_region will decrement the ref count and dealloc the attachment
+                 * if it drops to 0. But we didn't increment the ref count when we found the
+                 * reg as is customary. If PERSIST was set, there is superfluous ref present
+                 * from when we initialized ref_count to 2 instead of 1, so we good. If not,
+                 * manually add the missing reference here; otherwise the count would drop to
+                 * -1, or the reg might be deleted while still in use elsewhere. */
+                if (!(MCA_RCACHE_FLAGS_PERSIST & ov_reg->flags))
+                    opal_atomic_add(&ov_reg->ref_count, 1);
+
+                mca_smsc_xpmem_unmap_peer_region(ov_reg);
             }
         }
     }
 
     if (NULL == reg) {
-        reg = OBJ_NEW(mca_rcache_base_registration_t);
+        reg = (mca_rcache_base_registration_t *) OBJ_NEW(mca_smsc_xpmem_reg_t);
         if (OPAL_LIKELY(NULL == reg)) {
             return NULL;
         }
 
+        ++mca_smsc_xpmem_component.cache_misses;
+        ((mca_smsc_xpmem_reg_t *) reg)->last_use = ++xpmem_endpoint->clock;
+
         // PERSIST is implemented by keeping an extra reference around
         reg->ref_count = ((flags & MCA_RCACHE_FLAGS_PERSIST)
             && !(flags & MCA_RCACHE_FLAGS_CACHE_BYPASS) ? 2 : 1);
@@ -206,6 +298,8 @@ void *mca_smsc_xpmem_map_peer_region(mca_smsc_endpoint_t *endpoint, uint64_t fla
 
             if (OPAL_SUCCESS != rc) {
                 reg->flags |= MCA_RCACHE_FLAGS_CACHE_BYPASS;
+            } else if (reg->flags & MCA_RCACHE_FLAGS_PERSIST) {
+                mca_smsc_xpmem_lru_insert(xpmem_endpoint, (mca_smsc_xpmem_reg_t *) reg);
             }
         }
     }
@@ -230,6 +324,10 @@ void mca_smsc_xpmem_unmap_peer_region(void *ctx)
                             "endpoint %p address range %p-%p",
                             (void *) endpoint, reg->base, reg->bound);
 
+        if (reg->flags & MCA_RCACHE_FLAGS_PERSIST) {
+            mca_smsc_xpmem_lru_remove(endpoint, (mca_smsc_xpmem_reg_t *) reg);
+        }
+
         if (!(reg->flags & MCA_RCACHE_FLAGS_CACHE_BYPASS)) {
             int ret = mca_rcache_base_vma_delete(endpoint->vma_module, reg);
             assert(OPAL_SUCCESS == ret);
@@ -261,6 +359,14 @@ static void mca_smsc_xpmem_cleanup_endpoint(mca_smsc_xpmem_endpoint_t *endpoint)
 
     OBJ_CONSTRUCT(&registrations, opal_list_t);
 
+    /* the list items are reused below */
+    OPAL_THREAD_LOCK(&endpoint->lru_lock);
+    while (NULL != (reg = (mca_rcache_base_registration_t *)
+            opal_list_remove_first(&endpoint->lru))) {
+        ((mca_smsc_xpmem_reg_t *) reg)->in_lru = false;
+    }
+    OPAL_THREAD_UNLOCK(&endpoint->lru_lock);
+
     /* clean out the registration cache */
     (void) mca_rcache_base_vma_iterate(endpoint->vma_module, NULL, (size_t) -1, true,
                                        mca_smsc_xpmem_endpoint_rcache_entry_cleanup,
@@ -67,9 +67,10 @@ int opal_register_params(void)
 
     opal_register_done = true;
 
+    int ret1;
+
 #if defined(HAVE_SCHED_YIELD)
     opal_progress_yield_when_idle = false;
-    int ret1;
     ret1 = mca_base_var_register("opal", "opal", "progress", "yield_when_idle",
                                 "Yield the processor when waiting on progress",
                                 MCA_BASE_VAR_TYPE_BOOL, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
@@ -80,6 +81,19 @@ int opal_register_params(void)
     }
 #endif
 
+    opal_progress_shards = 0;
+    ret1 = mca_base_var_register("opal", "opal", "progress", "shards",
+                                 "Number of progress shards. When non-zero each high priority progress "
+                                 "callback is assigned to a shard, each thread in opal_progress() polls "
+                                 "only its own shard and steals from the other shards when it is idle. "
+                                 "0 (default) lets every thread poll every callback",
+                                 MCA_BASE_VAR_TYPE_INT, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                 OPAL_INFO_LVL_8, MCA_BASE_VAR_SCOPE_LOCAL,
+                                 &opal_progress_shards);
+    if (ret1 < 0) {
+        return ret1;
+    }
+
 #if OPAL_ENABLE_DEBUG
     opal_progress_debug = false;
     int ret;
@@ -49,6 +49,7 @@ bool opal_progress_debug = false;
  */
 static int opal_progress_event_flag = OPAL_EVLOOP_ONCE | OPAL_EVLOOP_NONBLOCK;
 int opal_progress_spin_count = 10000;
+int opal_progress_shards = 0;
 
 /*
  * Local variables
@@ -59,6 +60,8 @@ static opal_atomic_lock_t progress_lock;
 static volatile opal_progress_callback_t *callbacks = NULL;
 static size_t callbacks_len = 0;
 static size_t callbacks_size = 0;
+/* shard of each high priority callback, moved along with it */
+static volatile int *callbacks_shard = NULL;
 
 static volatile opal_progress_callback_t *callbacks_lp = NULL;
 static size_t callbacks_lp_len = 0;
@@ -84,6 +87,42 @@ static opal_atomic_int32_t num_event_users = 0;
 static int debug_output = -1;
 #endif
 
+/*
+ * Sharded progress. High priority callbacks are dealt to the shards in
+ * the order they are registered, and keep their shard until they are
+ * unregistered, so each callback (usually one per BTL or other
+ * progressing component) is only polled by one thread at a time.
+ * Each shard is guarded by a try-lock: a thread that finds its own shard
+ * idle or already being progressed moves on to the other shards instead
+ * of waiting, which is how idle threads steal work. Shards without a
+ * thread of their own are also visited by busy threads, one every
+ * OPAL_PROGRESS_SHARD_VISIT calls in turn.
+ */
+#define OPAL_PROGRESS_MAX_SHARDS 64
+#define OPAL_PROGRESS_SHARD_VISIT 8
+
+typedef struct opal_progress_shard_t {
+    opal_atomic_int32_t busy;
+    /* keep every shard on its own cache line */
+    char padding[64 - sizeof(opal_atomic_int32_t)];
+} opal_progress_shard_t;
+
+static opal_progress_shard_t progress_shards[OPAL_PROGRESS_MAX_SHARDS];
+
+/* shard of the next registered callback */
+static int progress_next_shard = 0;
+
+/* threads are spread over the shards in the order they first progress */
+static opal_atomic_int32_t progress_thread_count = 0;
+#if OPAL_HAVE_THREAD_LOCAL
+static opal_thread_local int progress_thread_index = -1;
+static opal_thread_local unsigned int progress_thread_calls = 0;
+#else
+/* sharding is disabled without thread local storage */
+static int progress_thread_index = 0;
+static unsigned int progress_thread_calls = 0;
+#endif
+
 /**
  * Fake callback used for threading purposes when one thread
  * progresses callbacks while another unregisters some. The root
@@ -99,7 +138,7 @@ static int fake_cb(void)
 
 static int _opal_progress_unregister(opal_progress_callback_t cb,
                                      volatile opal_progress_callback_t *callback_array,
-                                     size_t *callback_array_len);
+                                     volatile int *shard_array, size_t *callback_array_len);
 
 static void opal_progress_finalize(void)
 {
@@ -110,6 +149,8 @@ static void opal_progress_finalize(void)
     callbacks_size = 0;
     free((void *) callbacks);
     callbacks = NULL;
+    free((void *) callbacks_shard);
+    callbacks_shard = NULL;
 
     callbacks_lp_len = 0;
     callbacks_lp_size = 0;
@@ -128,6 +169,20 @@ int opal_progress_init(void)
     /* set the event tick rate */
     opal_progress_set_event_poll_rate(10000);
 
+    if (opal_progress_shards < 0) {
+        opal_progress_shards = 0;
+    } else if (opal_progress_shards > OPAL_PROGRESS_MAX_SHARDS) {
+        opal_progress_shards = OPAL_PROGRESS_MAX_SHARDS;
+    }
+#if !OPAL_HAVE_THREAD_LOCAL
+    if (opal_progress_shards > 0) {
+        /* every thread would map to the same shard */
+        opal_output(0, "progress: opal_progress_shards needs thread local storage, "
+                       "sharded progress is disabled");
+        opal_progress_shards = 0;
+    }
+#endif
+
 #if OPAL_ENABLE_DEBUG
     if (opal_progress_debug) {
         debug_output = opal_output_open(NULL);
@@ -137,18 +192,22 @@ int opal_progress_init(void)
     callbacks_size = callbacks_lp_size = 8;
 
     callbacks = malloc(callbacks_size * sizeof(callbacks[0]));
+    callbacks_shard = malloc(callbacks_size * sizeof(callbacks_shard[0]));
     callbacks_lp = malloc(callbacks_lp_size * sizeof(callbacks_lp[0]));
 
-    if (NULL == callbacks || NULL == callbacks_lp) {
+    if (NULL == callbacks || NULL == callbacks_shard || NULL == callbacks_lp) {
         free((void *) callbacks);
+        free((void *) callbacks_shard);
         free((void *) callbacks_lp);
         callbacks_size = callbacks_lp_size = 0;
         callbacks = callbacks_lp = NULL;
+        callbacks_shard = NULL;
         return OPAL_ERR_OUT_OF_RESOURCE;
     }
 
     for (size_t i = 0; i < callbacks_size; ++i) {
         callbacks[i] = fake_cb;
+        callbacks_shard[i] = 0;
     }
 
     for (size_t i = 0; i < callbacks_lp_size; ++i) {
@@ -162,6 +221,7 @@ int opal_progress_init(void)
     OPAL_OUTPUT((debug_output, "progress: initialized num users to: %d", num_event_users));
     OPAL_OUTPUT(
         (debug_output, "progress: initialized poll rate to: %ld", (long) event_progress_delta));
+    OPAL_OUTPUT((debug_output, "progress: initialized shards to: %d", opal_progress_shards));
 
     opal_finalize_register_cleanup(opal_progress_finalize);
 
@@ -202,6 +262,58 @@ static int opal_progress_events(void)
     return events;
 }
 
+/*
+ * Progress the callbacks of one shard if no other thread is already
+ * doing it. Returns false if the shard was busy.
+ */
+static bool opal_progress_shard(int shard, int *events)
+{
+    if (OPAL_THREAD_SWAP_32(&progress_shards[shard].busy, 1)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < callbacks_len; ++i) {
+        if (shard == callbacks_shard[i]) {
+            *events += (callbacks[i])();
+        }
+    }
+
+    opal_atomic_wmb();
+    progress_shards[shard].busy = 0;
+
+    return true;
+}
+
+static int opal_progress_sharded(void)
+{
+    int nshards = opal_progress_shards, shard, events = 0;
+
+#if OPAL_HAVE_THREAD_LOCAL
+    if (OPAL_UNLIKELY(progress_thread_index < 0)) {
+        progress_thread_index = OPAL_THREAD_FETCH_ADD32(&progress_thread_count, 1);
+    }
+#endif
+    shard = progress_thread_index % nshards;
+
+    if (opal_progress_shard(shard, &events) && events > 0) {
+        /* a busy thread still visits the other shards in turn, so that
+         * those no thread owns are not starved */
+        if (nshards > 1 && 0 == (++progress_thread_calls % OPAL_PROGRESS_SHARD_VISIT)) {
+            int visit = progress_thread_calls / OPAL_PROGRESS_SHARD_VISIT % (nshards - 1);
+            (void) opal_progress_shard((shard + 1 + visit) % nshards, &events);
+        }
+        return events;
+    }
+
+    /* nothing to do on our own shard: steal from the others until one of
+     * them makes progress */
+    for (int i = 1; i < nshards && events <= 0; ++i) {
+        (void) opal_progress_shard((shard + i) % nshards, &events);
+    }
+
+    return events;
+}
+
 /*
  * Progress the event library and any functions that have registered to
  * be called.  We don't propagate errors from the progress functions,
@@ -219,9 +331,14 @@ int opal_progress(void)
     size_t i;
     int events = 0;
 
-    /* progress all registered callbacks */
-    for (i = 0; i < callbacks_len; ++i) {
-        events += (callbacks[i])();
+    if (opal_progress_shards > 0) {
+        /* progress the callbacks of our shard (or steal) */
+        events = opal_progress_sharded();
+    } else {
+        /* progress all registered callbacks */
+        for (i = 0; i < callbacks_len; ++i) {
+            events += (callbacks[i])();
+        }
     }
 
     /* Run low priority callbacks and events once every 8 calls to opal_progress().
@@ -366,7 +483,8 @@ static int opal_progress_find_cb(opal_progress_callback_t cb,
 }
 
 static int _opal_progress_register(opal_progress_callback_t cb,
-                                   volatile opal_progress_callback_t **cbs, size_t *cbs_size,
+                                   volatile opal_progress_callback_t **cbs,
+                                   volatile int **shards, size_t *cbs_size,
                                    size_t *cbs_len)
 {
     int ret = OPAL_SUCCESS;
@@ -379,6 +497,25 @@ static int _opal_progress_register(opal_progress_callback_t cb,
     if (*cbs_len + 1 > *cbs_size) {
         opal_progress_callback_t *tmp, *old;
 
+        if (NULL != shards) {
+            int *tmp_shards, *old_shards;
+
+            tmp_shards = (int *) malloc(sizeof(tmp_shards[0]) * 2 * *cbs_size);
+            if (NULL == tmp_shards) {
+                return OPAL_ERR_TEMP_OUT_OF_RESOURCE;
+            }
+            memcpy(tmp_shards, (void *) *shards, sizeof(tmp_shards[0]) * *cbs_size);
+            for (size_t i = *cbs_len; i < 2 * *cbs_size; ++i) {
+                tmp_shards[i] = 0;
+            }
+
+            opal_atomic_wmb();
+
+            old_shards = (int *) opal_atomic_swap_ptr((opal_atomic_intptr_t *) shards,
+                                                      (intptr_t) tmp_shards);
+            free(old_shards);
+        }
+
         tmp = (opal_progress_callback_t *) malloc(sizeof(tmp[0]) * 2 * *cbs_size);
         if (tmp == NULL) {
             return OPAL_ERR_TEMP_OUT_OF_RESOURCE;
@@ -405,6 +542,12 @@ static int _opal_progress_register(opal_progress_callback_t cb,
         *cbs_size *= 2;
     }
 
+    if (NULL != shards) {
+        shards[0][*cbs_len] = progress_next_shard;
+        if (opal_progress_shards > 0) {
+            progress_next_shard = (progress_next_shard + 1) % opal_progress_shards;
+        }
+    }
     cbs[0][*cbs_len] = cb;
     ++*cbs_len;
 
@@ -419,9 +562,10 @@ int opal_progress_register(opal_progress_callback_t cb)
 
     opal_atomic_lock(&progress_lock);
 
-    (void) _opal_progress_unregister(cb, callbacks_lp, &callbacks_lp_len);
+    (void) _opal_progress_unregister(cb, callbacks_lp, NULL, &callbacks_lp_len);
 
-    ret = _opal_progress_register(cb, &callbacks, &callbacks_size, &callbacks_len);
+    ret = _opal_progress_register(cb, &callbacks, &callbacks_shard, &callbacks_size,
+                                  &callbacks_len);
 
     opal_atomic_unlock(&progress_lock);
 
@@ -434,9 +578,26 @@ int opal_progress_register_lp(opal_progress_callback_t cb)
 
     opal_atomic_lock(&progress_lock);
 
-    (void) _opal_progress_unregister(cb, callbacks, &callbacks_len);
+    (void) _opal_progress_unregister(cb, callbacks, callbacks_shard, &callbacks_len);
+
+    ret = _opal_progress_register(cb, &callbacks_lp, NULL, &callbacks_lp_size,
+                                  &callbacks_lp_len);
+
+    opal_atomic_unlock(&progress_lock);
+
+    return ret;
+}
+
+int opal_progress_callback_shard(opal_progress_callback_t cb)
+{
+    int ret;
 
-    ret = _opal_progress_register(cb, &callbacks_lp, &callbacks_lp_size, &callbacks_lp_len);
+    opal_atomic_lock(&progress_lock);
+
+    ret = opal_progress_find_cb(cb, callbacks, callbacks_len);
+    if (ret >= 0) {
+        ret = callbacks_shard[ret];
+    }
 
     opal_atomic_unlock(&progress_lock);
 
@@ -445,7 +606,7 @@ int opal_progress_register_lp(opal_progress_callback_t cb)
 
 static int _opal_progress_unregister(opal_progress_callback_t cb,
                                      volatile opal_progress_callback_t *callback_array,
-                                     size_t *callback_array_len)
+                                     volatile int *shard_array, size_t *callback_array_len)
 {
     int ret = opal_progress_find_cb(cb, callback_array, *callback_array_len);
     if (OPAL_ERR_NOT_FOUND == ret) {
@@ -458,7 +619,10 @@ static int _opal_progress_unregister(opal_progress_callback_t cb,
        do any repacking. */
     for (size_t i = (size_t) ret; i < *callback_array_len - 1; ++i) {
         /* copy callbacks atomically since another thread may be in
-         * opal_progress(). */
+         * opal_progress(). The shard moves with the callback. */
+        if (NULL != shard_array) {
+            shard_array[i] = shard_array[i + 1];
+        }
         (void) opal_atomic_swap_ptr((opal_atomic_intptr_t *) (callback_array + i),
                                     (intptr_t) callback_array[i + 1]);
     }
@@ -475,12 +639,12 @@ int opal_progress_unregister(opal_progress_callback_t cb)
 
     opal_atomic_lock(&progress_lock);
 
-    ret = _opal_progress_unregister(cb, callbacks, &callbacks_len);
+    ret = _opal_progress_unregister(cb, callbacks, callbacks_shard, &callbacks_len);
 
     if (OPAL_SUCCESS != ret) {
         /* if not in the high-priority array try to remove from the lp array.
          * a callback will never be in both. */
-        ret = _opal_progress_unregister(cb, callbacks_lp, &callbacks_lp_len);
+        ret = _opal_progress_unregister(cb, callbacks_lp, NULL, &callbacks_lp_len);
     }
 
     opal_atomic_unlock(&progress_lock);
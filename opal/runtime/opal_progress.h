@@ -169,12 +169,22 @@ OPAL_DECLSPEC int opal_progress_register_lp(opal_progress_callback_t cb);
  */
 OPAL_DECLSPEC int opal_progress_unregister(opal_progress_callback_t cb);
 
+/**
+ * Shard of a registered high priority callback
+ *
+ * @return shard the callback is progressed from, or OPAL_ERR_NOT_FOUND
+ */
+OPAL_DECLSPEC int opal_progress_callback_shard(opal_progress_callback_t cb);
+
 #if OPAL_ENABLE_DEBUG
 OPAL_DECLSPEC extern bool opal_progress_debug;
 #endif
 
 OPAL_DECLSPEC extern int opal_progress_spin_count;
 
+/* number of progress shards (0: every thread polls every callback) */
+OPAL_DECLSPEC extern int opal_progress_shards;
+
 /* do we want to call sched_yield() if nothing happened */
 OPAL_DECLSPEC extern bool opal_progress_yield_when_idle;
 
@@ -0,0 +1,46 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#ifndef MCA_ATOMIC_SM_H
+#define MCA_ATOMIC_SM_H
+
+#include "oshmem_config.h"
+
+#include "opal/mca/mca.h"
+#include "oshmem/mca/atomic/atomic.h"
+#include "oshmem/util/oshmem_util.h"
+
+/* This component does uses SPML:SM */
+#include "oshmem/mca/spml/sm/spml_sm.h"
+
+BEGIN_C_DECLS
+
+/* Globally exported variables */
+
+OSHMEM_DECLSPEC extern mca_atomic_base_component_1_0_0_t
+mca_atomic_sm_component;
+
+/* this component works with spml:sm only */
+extern mca_spml_sm_t *mca_atomic_sm_spml_self;
+
+/* API functions */
+
+int mca_atomic_sm_startup(bool enable_progress_threads, bool enable_threads);
+int mca_atomic_sm_finalize(void);
+mca_atomic_base_module_t*
+mca_atomic_sm_query(int *priority);
+
+struct mca_atomic_sm_module_t {
+    mca_atomic_base_module_t super;
+};
+typedef struct mca_atomic_sm_module_t mca_atomic_sm_module_t;
+OBJ_CLASS_DECLARATION(mca_atomic_sm_module_t);
+
+END_C_DECLS
+
+#endif /* MCA_ATOMIC_SM_H */
@@ -0,0 +1,335 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "opal/sys/atomic.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/mca/atomic/atomic.h"
+#include "oshmem/mca/atomic/base/base.h"
+#include "oshmem/mca/spml/spml.h"
+#include "oshmem/mca/memheap/memheap.h"
+#include "oshmem/mca/memheap/base/base.h"
+#include "oshmem/runtime/runtime.h"
+#include "oshmem/proc/proc.h"
+#include "atomic_sm.h"
+
+/*
+ * Initial query function that is invoked during initialization, allowing
+ * this module to indicate what level of thread support it provides.
+ */
+int mca_atomic_sm_startup(bool enable_progress_threads, bool enable_threads)
+{
+    return OSHMEM_SUCCESS;
+}
+
+int mca_atomic_sm_finalize(void)
+{
+    return OSHMEM_SUCCESS;
+}
+
+/* The symmetric heaps of all PEs are mapped into this process, so every
+ * operation is a processor atomic on the mapped address. */
+static inline void *mca_atomic_sm_ptr(shmem_ctx_t ctx, void *target, size_t size, int pe)
+{
+    void *ptr;
+
+    assert((8 == size) || (4 == size));
+
+    ptr = mca_spml_sm_local_ptr(ctx, pe, target);
+    if (OPAL_UNLIKELY(NULL == ptr)) {
+        ATOMIC_ERROR("[#%d] %p on PE %d is not mapped", oshmem_my_proc_id(),
+                     target, pe);
+    }
+
+    return ptr;
+}
+
+#define MCA_ATOMIC_SM_FOP(name)                                                 \
+static int mca_atomic_sm_f##name(shmem_ctx_t ctx,                               \
+                                 void *target,                                  \
+                                 void *prev,                                    \
+                                 uint64_t value,                                \
+                                 size_t size,                                   \
+                                 int pe)                                        \
+{                                                                               \
+    void *ptr = mca_atomic_sm_ptr(ctx, target, size, pe);                       \
+    uint64_t result;                                                            \
+                                                                                \
+    if (OPAL_UNLIKELY(NULL == ptr)) {                                           \
+        return OSHMEM_ERROR;                                                    \
+    }                                                                           \
+                                                                                \
+    if (8 == size) {                                                            \
+        result = (uint64_t) opal_atomic_fetch_##name##_64(                      \
+                     (opal_atomic_int64_t *) ptr, (int64_t) value);             \
+        if (NULL != prev) {                                                     \
+            *(uint64_t *) prev = result;                                        \
+        }                                                                       \
+    } else {                                                                    \
+        result = (uint32_t) opal_atomic_fetch_##name##_32(                      \
+                     (opal_atomic_int32_t *) ptr, (int32_t) value);             \
+        if (NULL != prev) {                                                     \
+            *(uint32_t *) prev = (uint32_t) result;                             \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    return OSHMEM_SUCCESS;                                                      \
+}                                                                               \
+                                                                                \
+static int mca_atomic_sm_##name(shmem_ctx_t ctx,                                \
+                                void *target,                                   \
+                                uint64_t value,                                 \
+                                size_t size,                                    \
+                                int pe)                                         \
+{                                                                               \
+    return mca_atomic_sm_f##name(ctx, target, NULL, value, size, pe);           \
+}                                                                               \
+                                                                                \
+static int mca_atomic_sm_f##name##_nb(shmem_ctx_t ctx,                          \
+                                      void *fetch,                              \
+                                      void *target,                             \
+                                      void *prev,                               \
+                                      uint64_t value,                           \
+                                      size_t size,                              \
+                                      int pe)                                   \
+{                                                                               \
+    int rc;                                                                     \
+                                                                                \
+    /* completes immediately, the value is available in fetch on return */     \
+    rc = mca_atomic_sm_f##name(ctx, target, prev, value, size, pe);             \
+    if (OPAL_LIKELY(OSHMEM_SUCCESS == rc)) {                                    \
+        memcpy(fetch, prev, size);                                              \
+    }                                                                           \
+    return rc;                                                                  \
+}
+
+MCA_ATOMIC_SM_FOP(add)
+MCA_ATOMIC_SM_FOP(and)
+MCA_ATOMIC_SM_FOP(or)
+MCA_ATOMIC_SM_FOP(xor)
+
+static int mca_atomic_sm_swap(shmem_ctx_t ctx,
+                              void *target,
+                              void *prev,
+                              uint64_t value,
+                              size_t size,
+                              int pe)
+{
+    void *ptr = mca_atomic_sm_ptr(ctx, target, size, pe);
+
+    if (OPAL_UNLIKELY(NULL == ptr)) {
+        return OSHMEM_ERROR;
+    }
+
+    if (8 == size) {
+        *(int64_t *) prev = opal_atomic_swap_64((opal_atomic_int64_t *) ptr,
+                                                (int64_t) value);
+    } else {
+        *(int32_t *) prev = opal_atomic_swap_32((opal_atomic_int32_t *) ptr,
+                                                (int32_t) value);
+    }
+
+    return OSHMEM_SUCCESS;
+}
+
+static int mca_atomic_sm_cswap(shmem_ctx_t ctx,
+                               void *target,
+                               uint64_t *prev,
+                               uint64_t cond,
+                               uint64_t value,
+                               size_t size,
+                               int pe)
+{
+    void *ptr = mca_atomic_sm_ptr(ctx, target, size, pe);
+    int64_t old64;
+    int32_t old32;
+
+    assert(NULL != prev);
+
+    if (OPAL_UNLIKELY(NULL == ptr)) {
+        return OSHMEM_ERROR;
+    }
+
+    /* on failure the compare value is replaced with the current one, in
+     * either case it ends up holding the value before the operation */
+    if (8 == size) {
+        old64 = (int64_t) cond;
+        (void) opal_atomic_compare_exchange_strong_64((opal_atomic_int64_t *) ptr,
+                                                      &old64, (int64_t) value);
+        *prev = (uint64_t) old64;
+    } else {
+        old32 = (int32_t) cond;
+        (void) opal_atomic_compare_exchange_strong_32((opal_atomic_int32_t *) ptr,
+                                                      &old32, (int32_t) value);
+        *(uint32_t *) prev = (uint32_t) old32;
+    }
+
+    return OSHMEM_SUCCESS;
+}
+
+static int mca_atomic_sm_swap_nb(shmem_ctx_t ctx,
+                                 void *fetch,
+                                 void *target,
+                                 void *prev,
+                                 uint64_t value,
+                                 size_t size,
+                                 int pe)
+{
+    int rc;
+
+    rc = mca_atomic_sm_swap(ctx, target, prev, value, size, pe);
+    if (OPAL_LIKELY(OSHMEM_SUCCESS == rc)) {
+        memcpy(fetch, prev, size);
+    }
+    return rc;
+}
+
+static int mca_atomic_sm_cswap_nb(shmem_ctx_t ctx,
+                                  void *fetch,
+                                  void *target,
+                                  uint64_t *prev,
+                                  uint64_t cond,
+                                  uint64_t value,
+                                  size_t size,
+                                  int pe)
+{
+    int rc;
+
+    rc = mca_atomic_sm_cswap(ctx, target, prev, cond, value, size, pe);
+    if (OPAL_LIKELY(OSHMEM_SUCCESS == rc)) {
+        memcpy(fetch, prev, size);
+    }
+    return rc;
+}
+
+static int mca_atomic_sm_set(shmem_ctx_t ctx,
+                             void *target,
+                             uint64_t value,
+                             size_t size,
+                             int pe)
+{
+    uint64_t prev;
+
+    return mca_atomic_sm_swap(ctx, target, &prev, value, size, pe);
+}
+
+/*
+ * Check that every PE can map the segments of every other PE. The remote
+ * keys are only unpacked after the atomic component is selected, so try
+ * the mappings here. The answer must be the same on all PEs: mixing
+ * processor atomics with atomic/basic on the same target is not atomic.
+ */
+static bool mca_atomic_sm_can_map_all(void)
+{
+    int nprocs = oshmem_num_procs();
+    int nsegs  = mca_memheap_base_map.n_segments;
+    map_base_segment_t *local, *segs;
+    int *mapped;
+    int ok, i, pe;
+    void *map_ctx;
+    void *local_base;
+    bool result = false;
+
+    local = (map_base_segment_t *) calloc(nsegs, sizeof(*local));
+    segs  = (map_base_segment_t *) calloc((size_t) nprocs * nsegs, sizeof(*segs));
+    mapped = (int *) calloc(nprocs, sizeof(*mapped));
+    if (NULL == local || NULL == segs || NULL == mapped) {
+        /* the other PEs wait in the exchange below, do not leave them */
+        ATOMIC_ERROR("[#%d] out of memory", oshmem_my_proc_id());
+        oshmem_shmem_abort(-1);
+    }
+
+    for (i = 0; i < nsegs; i++) {
+        local[i] = mca_memheap_base_map.mem_segs[i].super;
+    }
+
+    if (OSHMEM_SUCCESS != oshmem_shmem_allgather(local, segs, nsegs * sizeof(*local))) {
+        goto out;
+    }
+
+    ok = mca_atomic_sm_spml_self->can_map ? 1 : 0;
+    for (pe = 0; ok && pe < nprocs; pe++) {
+        if (pe == oshmem_my_proc_id()) {
+            continue;
+        }
+        for (i = 0; ok && i < nsegs; i++) {
+            map_base_segment_t *s = &segs[pe * nsegs + i];
+
+            map_ctx = MCA_SMSC_CALL(map_peer_region, mca_atomic_sm_spml_self->endpoints[pe], 0,
+                                    s->va_base, (uintptr_t) s->va_end - (uintptr_t) s->va_base,
+                                    &local_base);
+            if (NULL == map_ctx) {
+                ATOMIC_VERBOSE(5, "[#%d] segment %d of PE %d can not be mapped",
+                               oshmem_my_proc_id(), i, pe);
+                ok = 0;
+                break;
+            }
+            MCA_SMSC_CALL(unmap_peer_region, map_ctx);
+        }
+    }
+
+    if (OSHMEM_SUCCESS != oshmem_shmem_allgather(&ok, mapped, sizeof(ok))) {
+        goto out;
+    }
+
+    result = true;
+    for (pe = 0; pe < nprocs; pe++) {
+        if (!mapped[pe]) {
+            result = false;
+            break;
+        }
+    }
+
+out:
+    free(mapped);
+    free(segs);
+    free(local);
+    return result;
+}
+
+mca_atomic_base_module_t *
+mca_atomic_sm_query(int *priority)
+{
+    mca_atomic_sm_module_t *module;
+
+    /* without a mapping of the peers' heaps atomics go through atomic/basic */
+    if (NULL == mca_atomic_sm_spml_self || !mca_atomic_sm_can_map_all()) {
+        ATOMIC_VERBOSE(5, "Can not use atomic/sm, peer memory is not mapped");
+        return NULL;
+    }
+
+    *priority = mca_atomic_sm_component.priority;
+
+    module = OBJ_NEW(mca_atomic_sm_module_t);
+    if (module) {
+        module->super.atomic_add   = mca_atomic_sm_add;
+        module->super.atomic_and   = mca_atomic_sm_and;
+        module->super.atomic_or    = mca_atomic_sm_or;
+        module->super.atomic_xor   = mca_atomic_sm_xor;
+        module->super.atomic_fadd  = mca_atomic_sm_fadd;
+        module->super.atomic_fand  = mca_atomic_sm_fand;
+        module->super.atomic_for   = mca_atomic_sm_for;
+        module->super.atomic_fxor  = mca_atomic_sm_fxor;
+        module->super.atomic_swap  = mca_atomic_sm_swap;
+        module->super.atomic_cswap = mca_atomic_sm_cswap;
+        module->super.atomic_fadd_nb  = mca_atomic_sm_fadd_nb;
+        module->super.atomic_fand_nb  = mca_atomic_sm_fand_nb;
+        module->super.atomic_for_nb   = mca_atomic_sm_for_nb;
+        module->super.atomic_fxor_nb  = mca_atomic_sm_fxor_nb;
+        module->super.atomic_swap_nb  = mca_atomic_sm_swap_nb;
+        module->super.atomic_cswap_nb = mca_atomic_sm_cswap_nb;
+        module->super.atomic_set      = mca_atomic_sm_set;
+        return &(module->super);
+    }
+
+    return NULL ;
+}
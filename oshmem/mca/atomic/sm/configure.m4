@@ -0,0 +1,25 @@
+# -*- shell-script -*-
+#
+# $COPYRIGHT$
+#
+# Additional copyrights may follow
+#
+# $HEADER$
+#
+
+# MCA_oshmem_atomic_sm_CONFIG([action-if-can-compile],
+#                             [action-if-cant-compile])
+# ------------------------------------------------
+AC_DEFUN([MCA_oshmem_atomic_sm_CONFIG],[
+    AC_CONFIG_FILES([oshmem/mca/atomic/sm/Makefile])
+
+    # same condition as spml/sm, the component is only used together with it
+    case "$host" in
+        *linux*)
+            $1
+            ;;
+        *)
+            $2
+            ;;
+    esac
+])dnl
@@ -0,0 +1,650 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+#include "oshmem/proc/proc.h"
+#include "oshmem/mca/spml/spml.h"
+#include "oshmem/mca/memheap/memheap.h"
+#include "oshmem/mca/memheap/slab/memheap_slab.h"
+#include "oshmem/mca/memheap/slab/memheap_slab_component.h"
+#include "oshmem/mca/memheap/base/base.h"
+#include "opal/class/opal_object.h"
+
+mca_memheap_slab_module_t memheap_slab = {
+    {
+        &mca_memheap_slab_component,
+        mca_memheap_slab_finalize,
+        mca_memheap_slab_alloc,
+        mca_memheap_slab_align,
+        mca_memheap_slab_realloc,
+        mca_memheap_slab_free,
+
+        mca_memheap_slab_private_alloc,
+        mca_memheap_slab_private_free,
+
+        mca_memheap_base_get_mkey,
+        mca_memheap_base_is_symmetric_addr,
+        mca_memheap_modex_recv_all,
+
+        0
+    },
+    50,         /* priority */
+    1UL << 16,  /* slab size */
+    4096        /* max object size */
+};
+
+/* log2 of the smallest power of two >= size */
+static inline unsigned slab_order_of(size_t size)
+{
+    unsigned order = 0;
+
+    while (((size_t) 1 << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+static inline uint32_t slab_units(unsigned order)
+{
+    return (uint32_t) 1 << (order - MEMHEAP_SLAB_UNIT_ORDER);
+}
+
+/*
+ * Block allocator
+ */
+
+static inline void block_push(mca_memheap_slab_heap_t *heap, uint32_t unit, unsigned order)
+{
+    uint32_t head = heap->free_head[order];
+
+    heap->units[unit] = MEMHEAP_SLAB_UNIT(MEMHEAP_SLAB_UNIT_FREE, order);
+    heap->unit_prev[unit] = MEMHEAP_SLAB_NONE;
+    heap->unit_next[unit] = head;
+    if (MEMHEAP_SLAB_NONE != head) {
+        heap->unit_prev[head] = unit;
+    }
+    heap->free_head[order] = unit;
+}
+
+static inline void block_remove(mca_memheap_slab_heap_t *heap, uint32_t unit, unsigned order)
+{
+    uint32_t prev = heap->unit_prev[unit];
+    uint32_t next = heap->unit_next[unit];
+
+    if (MEMHEAP_SLAB_NONE != prev) {
+        heap->unit_next[prev] = next;
+    } else {
+        heap->free_head[order] = next;
+    }
+    if (MEMHEAP_SLAB_NONE != next) {
+        heap->unit_prev[next] = prev;
+    }
+    heap->units[unit] = MEMHEAP_SLAB_UNIT(MEMHEAP_SLAB_UNIT_INNER, 0);
+}
+
+/* Returns the first unit of a free block of the given order, or NONE. The
+ * caller holds the heap lock. */
+static uint32_t block_alloc(mca_memheap_slab_heap_t *heap, unsigned order, int kind)
+{
+    unsigned o;
+    uint32_t unit;
+
+    for (o = order; o <= heap->max_order; ++o) {
+        if (MEMHEAP_SLAB_NONE != heap->free_head[o]) {
+            break;
+        }
+    }
+    if (o > heap->max_order) {
+        return MEMHEAP_SLAB_NONE;
+    }
+
+    unit = heap->free_head[o];
+    block_remove(heap, unit, o);
+
+    /* split, keeping the lower half */
+    while (o > order) {
+        --o;
+        block_push(heap, unit + slab_units(o), o);
+    }
+
+    heap->units[unit] = MEMHEAP_SLAB_UNIT(kind, order);
+    return unit;
+}
+
+static void block_free(mca_memheap_slab_heap_t *heap, uint32_t unit, unsigned order)
+{
+    uint32_t buddy;
+
+    while (order < heap->max_order) {
+        buddy = unit ^ slab_units(order);
+        if (buddy + slab_units(order) > heap->n_units ||
+            MEMHEAP_SLAB_UNIT(MEMHEAP_SLAB_UNIT_FREE, order) != heap->units[buddy]) {
+            break;
+        }
+        block_remove(heap, buddy, order);
+        heap->units[unit] = MEMHEAP_SLAB_UNIT(MEMHEAP_SLAB_UNIT_INNER, 0);
+        unit = (unit < buddy) ? unit : buddy;
+        ++order;
+    }
+
+    block_push(heap, unit, order);
+}
+
+/*
+ * Slabs
+ */
+
+static mca_memheap_slab_t *slab_new(mca_memheap_slab_heap_t *heap, int class_idx)
+{
+    mca_memheap_slab_t *slab;
+    uint32_t unit;
+
+    slab = (mca_memheap_slab_t *) calloc(1, sizeof(*slab));
+    if (NULL == slab) {
+        return NULL;
+    }
+
+    OPAL_THREAD_LOCK(&heap->lock);
+    unit = block_alloc(heap, heap->slab_order, MEMHEAP_SLAB_UNIT_SLAB);
+    if (MEMHEAP_SLAB_NONE != unit) {
+        heap->slabs[((size_t) unit << MEMHEAP_SLAB_UNIT_ORDER) >> heap->slab_order] = slab;
+    }
+    OPAL_THREAD_UNLOCK(&heap->lock);
+
+    if (MEMHEAP_SLAB_NONE == unit) {
+        free(slab);
+        return NULL;
+    }
+
+    slab->base = heap->base + ((size_t) unit << MEMHEAP_SLAB_UNIT_ORDER);
+    slab->n_objs = (uint32_t) (((size_t) 1 << heap->slab_order) /
+                               heap->classes[class_idx].obj_size);
+    slab->class_idx = class_idx;
+
+    MEMHEAP_VERBOSE(20, "new slab %p for %d byte objects", (void *) slab->base,
+                    (int) heap->classes[class_idx].obj_size);
+    return slab;
+}
+
+static void slab_release(mca_memheap_slab_heap_t *heap, mca_memheap_slab_t *slab)
+{
+    size_t offset = slab->base - heap->base;
+
+    OPAL_THREAD_LOCK(&heap->lock);
+    heap->slabs[offset >> heap->slab_order] = NULL;
+    block_free(heap, (uint32_t) (offset >> MEMHEAP_SLAB_UNIT_ORDER), heap->slab_order);
+    OPAL_THREAD_UNLOCK(&heap->lock);
+
+    free(slab);
+}
+
+static inline void slab_link(mca_memheap_slab_class_t *cls, mca_memheap_slab_t *slab)
+{
+    slab->prev = NULL;
+    slab->next = cls->partial;
+    if (NULL != cls->partial) {
+        cls->partial->prev = slab;
+    }
+    cls->partial = slab;
+}
+
+static inline void slab_unlink(mca_memheap_slab_class_t *cls, mca_memheap_slab_t *slab)
+{
+    if (NULL != slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        cls->partial = slab->next;
+    }
+    if (NULL != slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = slab->prev = NULL;
+}
+
+static void *slab_obj_alloc(mca_memheap_slab_heap_t *heap, int class_idx)
+{
+    mca_memheap_slab_class_t *cls = &heap->classes[class_idx];
+    mca_memheap_slab_t *slab;
+    void *obj;
+
+    OPAL_THREAD_LOCK(&cls->lock);
+    slab = cls->partial;
+    if (NULL == slab) {
+        slab = slab_new(heap, class_idx);
+        if (NULL == slab) {
+            OPAL_THREAD_UNLOCK(&cls->lock);
+            return NULL;
+        }
+        slab_link(cls, slab);
+    }
+
+    if (NULL != slab->free_objs) {
+        obj = slab->free_objs;
+        slab->free_objs = *(void **) obj;
+    } else {
+        obj = slab->base + (size_t) slab->next_unused * cls->obj_size;
+        slab->next_unused++;
+    }
+
+    if (++slab->n_used == slab->n_objs) {
+        slab_unlink(cls, slab);
+    }
+    OPAL_THREAD_UNLOCK(&cls->lock);
+
+    return obj;
+}
+
+static int slab_obj_free(mca_memheap_slab_heap_t *heap, mca_memheap_slab_t *slab, void *obj)
+{
+    mca_memheap_slab_class_t *cls = &heap->classes[slab->class_idx];
+    size_t offset = (char *) obj - slab->base;
+
+    /* next_unused moves under the class lock in slab_obj_alloc */
+    OPAL_THREAD_LOCK(&cls->lock);
+    if (0 != offset % cls->obj_size || offset / cls->obj_size >= slab->next_unused) {
+        OPAL_THREAD_UNLOCK(&cls->lock);
+        return OSHMEM_ERROR;
+    }
+
+    if (slab->n_used-- == slab->n_objs) {
+        slab_link(cls, slab);
+    }
+    *(void **) obj = slab->free_objs;
+    slab->free_objs = obj;
+
+    /* keep one empty slab per class to avoid bouncing on alloc/free pairs */
+    if (0 == slab->n_used && (cls->partial != slab || NULL != slab->next)) {
+        slab_unlink(cls, slab);
+        slab_release(heap, slab);
+    }
+    OPAL_THREAD_UNLOCK(&cls->lock);
+
+    return OSHMEM_SUCCESS;
+}
+
+/*
+ * Heap
+ */
+
+static inline int slab_size_class(mca_memheap_slab_heap_t *heap, size_t size)
+{
+    if (size <= MEMHEAP_SLAB_MIN_OBJECT_SIZE) {
+        return 0;
+    }
+    if (size > heap->max_object_size) {
+        return -1;
+    }
+    return heap->size_class[(size + MEMHEAP_SLAB_ALIGN - 1) / MEMHEAP_SLAB_ALIGN];
+}
+
+/* Size classes: 8, then multiples of 16 up to 128, then four classes per
+ * power of two. All classes above 8 bytes keep 16 byte alignment. */
+static int slab_classes_init(mca_memheap_slab_heap_t *heap, size_t max_object_size)
+{
+    size_t size, step, idx;
+    int n = 0, c;
+
+    heap->classes = (mca_memheap_slab_class_t *) calloc(64, sizeof(*heap->classes));
+    if (NULL == heap->classes) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+
+    size = MEMHEAP_SLAB_MIN_OBJECT_SIZE;
+    while (size <= max_object_size && n < 64) {
+        heap->classes[n].obj_size = size;
+        heap->classes[n].obj_align = size & ~(size - 1);
+        heap->classes[n].partial = NULL;
+        OBJ_CONSTRUCT(&heap->classes[n].lock, opal_mutex_t);
+        n++;
+
+        if (size < 128) {
+            size = (size + MEMHEAP_SLAB_ALIGN) & ~(size_t) (MEMHEAP_SLAB_ALIGN - 1);
+        } else {
+            step = ((size_t) 1 << (slab_order_of(size + 1) - 1)) / 4;
+            size += step;
+        }
+    }
+    heap->n_classes = n;
+    if (0 == n) {
+        MEMHEAP_ERROR("no slab size class fits in %llu bytes",
+                      (unsigned long long) max_object_size);
+        return OSHMEM_ERR_BAD_PARAM;
+    }
+    heap->max_object_size = heap->classes[n - 1].obj_size;
+
+    heap->size_class = (uint8_t *) malloc(heap->max_object_size / MEMHEAP_SLAB_ALIGN + 1);
+    if (NULL == heap->size_class) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+    for (idx = 0, c = 0; idx <= heap->max_object_size / MEMHEAP_SLAB_ALIGN; ++idx) {
+        while (heap->classes[c].obj_size < idx * MEMHEAP_SLAB_ALIGN) {
+            c++;
+        }
+        heap->size_class[idx] = (uint8_t) c;
+    }
+
+    return OSHMEM_SUCCESS;
+}
+
+static int slab_heap_init(mca_memheap_slab_heap_t *heap, void *base, size_t size,
+                          size_t slab_size, size_t max_object_size)
+{
+    uint32_t unit;
+    unsigned order;
+    int rc;
+
+    memset(heap, 0, sizeof(*heap));
+    OBJ_CONSTRUCT(&heap->lock, opal_mutex_t);
+
+    heap->base = (char *) base;
+    heap->size = size;
+    heap->n_units = (uint32_t) (size >> MEMHEAP_SLAB_UNIT_ORDER);
+    heap->slab_order = slab_order_of(slab_size);
+    if (heap->slab_order < MEMHEAP_SLAB_UNIT_ORDER) {
+        heap->slab_order = MEMHEAP_SLAB_UNIT_ORDER;
+    }
+
+    heap->max_order = MEMHEAP_SLAB_UNIT_ORDER;
+    while (heap->max_order < MEMHEAP_SLAB_MAX_ORDER &&
+           ((size_t) 1 << (heap->max_order + 1)) <= size) {
+        heap->max_order++;
+    }
+    if (0 == heap->n_units || heap->slab_order > heap->max_order) {
+        MEMHEAP_ERROR("symmetric heap of %llu bytes is too small for slabs of %llu bytes",
+                      (unsigned long long) size, (unsigned long long) slab_size);
+        return OSHMEM_ERR_BAD_PARAM;
+    }
+
+    /* a slab has to hold at least 8 objects of the largest class */
+    if (max_object_size > ((size_t) 1 << heap->slab_order) / 8) {
+        max_object_size = ((size_t) 1 << heap->slab_order) / 8;
+    }
+
+    heap->units = (uint8_t *) calloc(heap->n_units, sizeof(*heap->units));
+    heap->unit_next = (uint32_t *) malloc(heap->n_units * sizeof(*heap->unit_next));
+    heap->unit_prev = (uint32_t *) malloc(heap->n_units * sizeof(*heap->unit_prev));
+    heap->slabs = (mca_memheap_slab_t **) calloc((size >> heap->slab_order) + 1,
+                                                 sizeof(*heap->slabs));
+    if (NULL == heap->units || NULL == heap->unit_next ||
+        NULL == heap->unit_prev || NULL == heap->slabs) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+
+    for (order = 0; order <= MEMHEAP_SLAB_MAX_ORDER; ++order) {
+        heap->free_head[order] = MEMHEAP_SLAB_NONE;
+    }
+
+    /* cover the heap with the largest aligned blocks that fit */
+    for (unit = 0; unit < heap->n_units; unit += slab_units(order)) {
+        order = heap->max_order;
+        while (order > MEMHEAP_SLAB_UNIT_ORDER &&
+               ((unit & (slab_units(order) - 1)) || unit + slab_units(order) > heap->n_units)) {
+            order--;
+        }
+        block_push(heap, unit, order);
+    }
+
+    rc = slab_classes_init(heap, max_object_size);
+    if (OSHMEM_SUCCESS != rc) {
+        return rc;
+    }
+
+    MEMHEAP_VERBOSE(5, "slab heap %p: %llu bytes, %d classes up to %llu bytes, "
+                    "%llu byte slabs", base, (unsigned long long) size, heap->n_classes,
+                    (unsigned long long) heap->max_object_size,
+                    (unsigned long long) 1 << heap->slab_order);
+    return OSHMEM_SUCCESS;
+}
+
+static void slab_heap_cleanup(mca_memheap_slab_heap_t *heap)
+{
+    size_t i;
+    int c;
+
+    if (NULL == heap->base) {
+        return;
+    }
+
+    if (NULL != heap->slabs) {
+        for (i = 0; i <= (heap->size >> heap->slab_order); ++i) {
+            free(heap->slabs[i]);
+        }
+        free(heap->slabs);
+    }
+    if (NULL != heap->classes) {
+        for (c = 0; c < heap->n_classes; ++c) {
+            OBJ_DESTRUCT(&heap->classes[c].lock);
+        }
+        free(heap->classes);
+    }
+    free(heap->size_class);
+    free(heap->units);
+    free(heap->unit_next);
+    free(heap->unit_prev);
+    OBJ_DESTRUCT(&heap->lock);
+    memset(heap, 0, sizeof(*heap));
+}
+
+/* Returns the usable size of an allocated object, 0 if ptr was not
+ * returned by an allocation on this heap. */
+static size_t slab_heap_usable_size(mca_memheap_slab_heap_t *heap, void *ptr,
+                                    mca_memheap_slab_t **slab)
+{
+    size_t offset;
+    uint32_t unit, slab_unit;
+    uint8_t state;
+
+    *slab = NULL;
+    if ((char *) ptr < heap->base || (char *) ptr >= heap->base + heap->size) {
+        return 0;
+    }
+
+    offset = (char *) ptr - heap->base;
+    slab_unit = (uint32_t) (((offset >> heap->slab_order) << heap->slab_order) >>
+                            MEMHEAP_SLAB_UNIT_ORDER);
+    if (MEMHEAP_SLAB_UNIT_SLAB == MEMHEAP_SLAB_UNIT_KIND(heap->units[slab_unit])) {
+        *slab = heap->slabs[offset >> heap->slab_order];
+        return heap->classes[(*slab)->class_idx].obj_size;
+    }
+
+    unit = (uint32_t) (offset >> MEMHEAP_SLAB_UNIT_ORDER);
+    state = heap->units[unit];
+    if (0 != (offset & (((size_t) 1 << MEMHEAP_SLAB_UNIT_ORDER) - 1)) ||
+        MEMHEAP_SLAB_UNIT_USED != MEMHEAP_SLAB_UNIT_KIND(state)) {
+        return 0;
+    }
+    return (size_t) 1 << MEMHEAP_SLAB_UNIT_ORDER_OF(state);
+}
+
+static int slab_heap_alloc(mca_memheap_slab_heap_t *heap, size_t align, size_t size,
+                           void **p_buff)
+{
+    unsigned order;
+    uint32_t unit;
+    int class_idx;
+
+    *p_buff = NULL;
+
+    class_idx = slab_size_class(heap, size);
+    if (class_idx >= 0 && align <= heap->classes[class_idx].obj_align) {
+        *p_buff = slab_obj_alloc(heap, class_idx);
+        if (NULL == *p_buff) {
+            MEMHEAP_VERBOSE(5, "no slab left for %llu bytes", (unsigned long long) size);
+            return OSHMEM_ERROR;
+        }
+        MCA_SPML_CALL(memuse_hook(*p_buff, heap->classes[class_idx].obj_size));
+        return OSHMEM_SUCCESS;
+    }
+
+    order = slab_order_of(size > align ? size : align);
+    if (order < MEMHEAP_SLAB_UNIT_ORDER) {
+        order = MEMHEAP_SLAB_UNIT_ORDER;
+    }
+    if (order > heap->max_order) {
+        MEMHEAP_VERBOSE(5, "Allocation overflow of symmetric heap size");
+        return OSHMEM_ERROR;
+    }
+
+    OPAL_THREAD_LOCK(&heap->lock);
+    unit = block_alloc(heap, order, MEMHEAP_SLAB_UNIT_USED);
+    OPAL_THREAD_UNLOCK(&heap->lock);
+
+    if (MEMHEAP_SLAB_NONE == unit) {
+        MEMHEAP_VERBOSE(5, "no free block of order %u", order);
+        return OSHMEM_ERROR;
+    }
+
+    *p_buff = heap->base + ((size_t) unit << MEMHEAP_SLAB_UNIT_ORDER);
+    MCA_SPML_CALL(memuse_hook(*p_buff, (size_t) 1 << order));
+    return OSHMEM_SUCCESS;
+}
+
+static int slab_heap_free(mca_memheap_slab_heap_t *heap, void *ptr)
+{
+    mca_memheap_slab_t *slab;
+    size_t size;
+    uint32_t unit;
+
+    if (NULL == ptr) {
+        return OSHMEM_SUCCESS;
+    }
+
+    size = slab_heap_usable_size(heap, ptr, &slab);
+    if (0 == size) {
+        return OSHMEM_ERROR;
+    }
+
+    if (NULL != slab) {
+        return slab_obj_free(heap, slab, ptr);
+    }
+
+    unit = (uint32_t) (((char *) ptr - heap->base) >> MEMHEAP_SLAB_UNIT_ORDER);
+    OPAL_THREAD_LOCK(&heap->lock);
+    block_free(heap, unit, slab_order_of(size));
+    OPAL_THREAD_UNLOCK(&heap->lock);
+
+    return OSHMEM_SUCCESS;
+}
+
+/**
+ * Initialize the Memory Heap
+ */
+int mca_memheap_slab_module_init(memheap_context_t *context)
+{
+    int rc;
+
+    if (!context || !context->user_size || !context->private_size) {
+        return OSHMEM_ERR_BAD_PARAM;
+    }
+
+    rc = slab_heap_init(&memheap_slab.heap, context->user_base_addr,
+                        context->user_size, memheap_slab.slab_size,
+                        memheap_slab.max_object_size);
+    if (OSHMEM_SUCCESS == rc) {
+        rc = slab_heap_init(&memheap_slab.private_heap, context->private_base_addr,
+                            context->private_size, memheap_slab.slab_size,
+                            memheap_slab.max_object_size);
+    }
+    if (OSHMEM_SUCCESS != rc) {
+        MEMHEAP_ERROR("Failed to setup MEMHEAP slab allocator");
+        mca_memheap_slab_finalize();
+        return OSHMEM_ERROR;
+    }
+
+    memheap_slab.super.memheap_size = context->user_size;
+
+    MEMHEAP_VERBOSE(1,
+                    "symmetric heap memory (user+private): %llu bytes",
+                    (unsigned long long)(context->user_size + context->private_size));
+    return OSHMEM_SUCCESS;
+}
+
+int mca_memheap_slab_alloc(size_t size, void** p_buff)
+{
+    return slab_heap_alloc(&memheap_slab.heap, 0, size, p_buff);
+}
+
+int mca_memheap_slab_private_alloc(size_t size, void** p_buff)
+{
+    int rc;
+
+    rc = slab_heap_alloc(&memheap_slab.private_heap, 0, size, p_buff);
+    MEMHEAP_VERBOSE(20, "private alloc addr: %p", *p_buff);
+
+    return rc;
+}
+
+int mca_memheap_slab_private_free(void* ptr)
+{
+    return slab_heap_free(&memheap_slab.private_heap, ptr);
+}
+
+int mca_memheap_slab_align(size_t align, size_t size, void **p_buff)
+{
+    /* check that align is power of 2 */
+    if (align == 0 || (align & (align - 1))) {
+        *p_buff = 0;
+        return OSHMEM_ERROR;
+    }
+
+    return slab_heap_alloc(&memheap_slab.heap, align, size, p_buff);
+}
+
+int mca_memheap_slab_realloc(size_t new_size, void *p_buff, void **p_new_buff)
+{
+    mca_memheap_slab_t *slab;
+    size_t old_size;
+    int rc;
+
+    /* equiv to alloc if old ptr is null */
+    if (NULL == p_buff) {
+        return mca_memheap_slab_alloc(new_size, p_new_buff);
+    }
+
+    old_size = slab_heap_usable_size(&memheap_slab.heap, p_buff, &slab);
+    if (0 == old_size) {
+        *p_new_buff = NULL;
+        return OSHMEM_ERROR;
+    }
+
+    /* equiv to free if new_size is 0 */
+    if (0 == new_size) {
+        *p_new_buff = NULL;
+        return mca_memheap_slab_free(p_buff);
+    }
+
+    /* do nothing if new size is less then current size */
+    if (new_size <= old_size) {
+        *p_new_buff = p_buff;
+        return OSHMEM_SUCCESS;
+    }
+
+    rc = mca_memheap_slab_alloc(new_size, p_new_buff);
+    if (OSHMEM_SUCCESS != rc) {
+        *p_new_buff = NULL;
+        return rc;
+    }
+
+    memcpy(*p_new_buff, p_buff, old_size);
+    return mca_memheap_slab_free(p_buff);
+}
+
+int mca_memheap_slab_free(void* ptr)
+{
+    return slab_heap_free(&memheap_slab.heap, ptr);
+}
+
+int mca_memheap_slab_finalize(void)
+{
+    MEMHEAP_VERBOSE(5, "deregistering symmetric heap");
+
+    slab_heap_cleanup(&memheap_slab.heap);
+    slab_heap_cleanup(&memheap_slab.private_heap);
+
+    return OSHMEM_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ * @file
+ *
+ * Symmetric heap allocator that serves small objects from per size class
+ * slabs and larger ones from a buddy allocator.
+ *
+ * The heap is divided into units of 2^MEMHEAP_SLAB_UNIT_ORDER bytes. The
+ * buddy allocator hands out power of two blocks of units and keeps a free
+ * list per order, linked through arrays indexed by unit. A slab is a block
+ * of slab_size bytes carved into objects of one size class; freed objects
+ * are chained through their first word.
+ *
+ * shmem_malloc/shmem_free are collective and every PE runs the same
+ * deterministic algorithm on an identical heap, so an object gets the same
+ * address on all PEs.
+ */
+#ifndef MCA_MEMHEAP_SLAB_H
+#define MCA_MEMHEAP_SLAB_H
+
+#include "oshmem_config.h"
+#include "oshmem/mca/mca.h"
+#include "opal/mca/threads/mutex.h"
+#include "oshmem/mca/memheap/memheap.h"
+#include "oshmem/mca/memheap/base/base.h"
+#include "oshmem/mca/spml/spml.h"
+#include "oshmem/util/oshmem_util.h"
+
+BEGIN_C_DECLS
+
+#define MEMHEAP_SLAB_UNIT_ORDER          12   /* granularity of the block allocator */
+#define MEMHEAP_SLAB_MAX_ORDER           63
+#define MEMHEAP_SLAB_NONE                UINT32_MAX
+#define MEMHEAP_SLAB_MIN_OBJECT_SIZE     8
+#define MEMHEAP_SLAB_ALIGN               16   /* alignment of all classes above the smallest */
+
+/* unit states: kind in the top two bits, block order in the others */
+#define MEMHEAP_SLAB_UNIT_INNER          0    /* not the head of a block */
+#define MEMHEAP_SLAB_UNIT_FREE           1
+#define MEMHEAP_SLAB_UNIT_USED           2
+#define MEMHEAP_SLAB_UNIT_SLAB           3
+#define MEMHEAP_SLAB_UNIT(kind, order)   ((uint8_t) (((kind) << 6) | (order)))
+#define MEMHEAP_SLAB_UNIT_KIND(state)    ((state) >> 6)
+#define MEMHEAP_SLAB_UNIT_ORDER_OF(state) ((state) & 0x3f)
+
+/* one slab: a block of slab_size bytes holding objects of one size class */
+struct mca_memheap_slab_t {
+    struct mca_memheap_slab_t *next;   /* partial slabs of the class */
+    struct mca_memheap_slab_t *prev;
+    char *base;
+    void *free_objs;                   /* freed objects, linked through their first word */
+    uint32_t next_unused;              /* objects from here on were never handed out */
+    uint32_t n_objs;
+    uint32_t n_used;
+    uint32_t class_idx;
+};
+typedef struct mca_memheap_slab_t mca_memheap_slab_t;
+
+struct mca_memheap_slab_class_t {
+    size_t obj_size;
+    size_t obj_align;                  /* alignment every object of the class has */
+    mca_memheap_slab_t *partial;       /* slabs with at least one free object */
+    opal_mutex_t lock;
+};
+typedef struct mca_memheap_slab_class_t mca_memheap_slab_class_t;
+
+struct mca_memheap_slab_heap_t {
+    char *base;
+    size_t size;
+    uint32_t n_units;
+    unsigned max_order;
+    uint8_t *units;                    /* state of every unit */
+    uint32_t *unit_next;               /* free list links of free block heads */
+    uint32_t *unit_prev;
+    uint32_t free_head[MEMHEAP_SLAB_MAX_ORDER + 1];
+    opal_mutex_t lock;                 /* protects the block allocator */
+
+    unsigned slab_order;
+    mca_memheap_slab_t **slabs;        /* indexed by offset >> slab_order */
+    mca_memheap_slab_class_t *classes;
+    int n_classes;
+    uint8_t *size_class;               /* (size + 15) / 16 to class index */
+    size_t max_object_size;            /* largest size served from slabs */
+};
+typedef struct mca_memheap_slab_heap_t mca_memheap_slab_heap_t;
+
+/* Structure for managing shmem symmetric heap */
+struct mca_memheap_slab_module_t {
+    mca_memheap_base_module_t super;
+
+    int priority; /** Module's Priority */
+    size_t slab_size;
+    size_t max_object_size;
+    mca_memheap_slab_heap_t heap;
+    mca_memheap_slab_heap_t private_heap;
+};
+typedef struct mca_memheap_slab_module_t mca_memheap_slab_module_t;
+OSHMEM_DECLSPEC extern mca_memheap_slab_module_t memheap_slab;
+
+OSHMEM_DECLSPEC extern int mca_memheap_slab_module_init(memheap_context_t *);
+OSHMEM_DECLSPEC extern int mca_memheap_slab_alloc(size_t, void**);
+OSHMEM_DECLSPEC extern int mca_memheap_slab_realloc(size_t, void*, void **);
+OSHMEM_DECLSPEC extern int mca_memheap_slab_align(size_t, size_t, void**);
+OSHMEM_DECLSPEC extern int mca_memheap_slab_free(void*);
+OSHMEM_DECLSPEC extern int mca_memheap_slab_finalize(void);
+
+/* private alloc/free functions */
+OSHMEM_DECLSPEC extern int mca_memheap_slab_private_alloc(size_t, void**);
+OSHMEM_DECLSPEC extern int mca_memheap_slab_private_free(void*);
+
+END_C_DECLS
+
+#endif /* MCA_MEMHEAP_SLAB_H */
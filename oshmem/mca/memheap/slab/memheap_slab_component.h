@@ -0,0 +1,24 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ *  @file
+ */
+
+#ifndef MCA_MEMHEAP_SLAB_COMPONENT_H
+#define MCA_MEMHEAP_SLAB_COMPONENT_H
+
+BEGIN_C_DECLS
+
+/*
+ * MEMHEAP module functions.
+ */
+OSHMEM_DECLSPEC extern mca_memheap_base_component_2_0_0_t mca_memheap_slab_component;
+
+END_C_DECLS
+
+#endif
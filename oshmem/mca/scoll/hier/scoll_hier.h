@@ -0,0 +1,281 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#ifndef MCA_SCOLL_HIER_H
+#define MCA_SCOLL_HIER_H
+
+#include "oshmem_config.h"
+
+#include <string.h>
+
+#include "opal/runtime/opal_progress.h"
+#include "opal/sys/atomic.h"
+
+#include "oshmem/mca/mca.h"
+#include "oshmem/mca/scoll/scoll.h"
+#include "oshmem/mca/spml/spml.h"
+#include "oshmem/mca/memheap/memheap.h"
+#include "oshmem/mca/memheap/base/base.h"
+#include "oshmem/proc/proc.h"
+#include "oshmem/runtime/runtime.h"
+#include "oshmem/util/oshmem_util.h"
+
+BEGIN_C_DECLS
+
+/* The collectives run in two levels: the PEs of a node synchronize with
+ * a leader PE of the node through shared memory, and only the leaders
+ * (or the node of the root, for broadcasts) talk to the other nodes.
+ *
+ * Synchronization uses sequence numbers instead of the user's pSync: every
+ * collective run by this component takes the next number on all PEs, and a
+ * flag is reached once it holds that number or a later one. The flags live
+ * in the private heap and are shared by all groups spanning every PE, which
+ * are the only groups the component serves.
+ *
+ * A flag is only written once its owner is known to have entered the
+ * collective, or always by the same PE, so a PE that is already in the
+ * next collective can not satisfy a wait of the current one or overwrite
+ * its value with a smaller one. */
+
+#define SCOLL_HIER_MAX_ROUNDS   32
+
+typedef struct mca_scoll_hier_sync_t {
+    /** Written by the leader of the node when the PE may leave */
+    long release;
+    /** Written by the parent node when the data arrived */
+    long down;
+    /** Set by the PE itself when it entered a broadcast */
+    long entered;
+    /** Barrier rounds, written by the leader 2^i nodes before */
+    long round[SCOLL_HIER_MAX_ROUNDS];
+    /** Reduction tree, written by the child node 2^i after */
+    long child[SCOLL_HIER_MAX_ROUNDS];
+    /** On the leader: max_local_size arrival flags, then as many
+     * completion flags */
+    long local[];
+} mca_scoll_hier_sync_t;
+
+struct mca_scoll_hier_component_t {
+    mca_scoll_base_component_1_0_0_t super;
+
+    /** MCA parameter: priority of the component */
+    int priority;
+    /** MCA parameter: use the component only if a node runs that many PEs */
+    int min_local_size;
+    /** MCA parameter: larger reductions use the previous component */
+    size_t reduce_max_size;
+    /** MCA parameter: broadcasts of this size are pulled by the local PEs */
+    size_t bcast_pull_size;
+
+    /** Number of nodes and the leader (lowest PE) of each */
+    int node_count;
+    int *node_leader;
+    /** Node index of every PE */
+    int *pe_node;
+    /** PEs of my node in ascending order, and my index among them */
+    int *local_pes;
+    int local_size;
+    int local_rank;
+    /** Index of my node */
+    int node_rank;
+    /** Largest number of PEs on one node */
+    int max_local_size;
+
+    /** Synchronization flags in the private heap */
+    mca_scoll_hier_sync_t *sync;
+    /** Sequence number of the last collective */
+    long seq;
+    /** Receive buffer of reduce_max_size bytes */
+    void *tmp;
+};
+typedef struct mca_scoll_hier_component_t mca_scoll_hier_component_t;
+
+OSHMEM_DECLSPEC extern mca_scoll_hier_component_t mca_scoll_hier_component;
+
+struct mca_scoll_hier_module_t {
+    mca_scoll_base_module_t super;
+
+    /* Saved handlers - for the cases the component does not handle */
+    mca_scoll_base_module_broadcast_fn_t previous_broadcast;
+    mca_scoll_base_module_t *previous_broadcast_module;
+    mca_scoll_base_module_reduce_fn_t previous_reduce;
+    mca_scoll_base_module_t *previous_reduce_module;
+};
+typedef struct mca_scoll_hier_module_t mca_scoll_hier_module_t;
+OBJ_CLASS_DECLARATION(mca_scoll_hier_module_t);
+
+/* API functions */
+
+int mca_scoll_hier_init(bool enable_progress_threads, bool enable_threads);
+mca_scoll_base_module_t *
+mca_scoll_hier_query(struct oshmem_group_t *group, int *priority);
+void mca_scoll_hier_cleanup(void);
+
+int mca_scoll_hier_barrier(struct oshmem_group_t *group, long *pSync, int alg);
+int mca_scoll_hier_broadcast(struct oshmem_group_t *group,
+                             int PE_root,
+                             void *target,
+                             const void *source,
+                             size_t nlong,
+                             long *pSync,
+                             bool nlong_type,
+                             int alg);
+int mca_scoll_hier_reduce(struct oshmem_group_t *group,
+                          struct oshmem_op_t *op,
+                          void *target,
+                          const void *source,
+                          size_t nlong,
+                          long *pSync,
+                          void *pWrk,
+                          int alg);
+
+/* Shared helpers */
+
+static inline long *mca_scoll_hier_arrive(int local_rank)
+{
+    return &mca_scoll_hier_component.sync->local[local_rank];
+}
+
+static inline long *mca_scoll_hier_done(int local_rank)
+{
+    return &mca_scoll_hier_component.sync->local[mca_scoll_hier_component.max_local_size +
+                                                 local_rank];
+}
+
+/**
+ * Address of a symmetric object of a PE on this node in our address
+ * space, NULL if it is not mapped.
+ */
+static inline void *mca_scoll_hier_ptr(const void *va, int pe)
+{
+    sshmem_mkey_t *mkey;
+    void *rva;
+    int i;
+
+    if (pe == oshmem_my_proc_id()) {
+        return (void *) va;
+    }
+
+    if (!oshmem_proc_on_local_node(pe)) {
+        return NULL;
+    }
+
+    for (i = 0; i < mca_memheap_base_num_transports(); i++) {
+        mkey = mca_memheap_base_get_cached_mkey(oshmem_ctx_default, pe, (void *) va, i, &rva);
+        if (NULL == mkey) {
+            continue;
+        }
+
+        if (mca_memheap_base_mkey_is_shm(mkey)) {
+            return rva;
+        }
+
+        rva = MCA_SPML_CALL(rmkey_ptr(va, mkey, pe));
+        if (NULL != rva) {
+            return rva;
+        }
+    }
+
+    return NULL;
+}
+
+/** Set a flag of another PE, after the data sent to it before */
+static inline int mca_scoll_hier_signal(long *flag, long value, int pe)
+{
+    long *ptr = mca_scoll_hier_ptr(flag, pe);
+
+    opal_atomic_wmb();
+    if (NULL != ptr) {
+        *(volatile long *) ptr = value;
+        return OSHMEM_SUCCESS;
+    }
+
+    MCA_SPML_CALL(fence(oshmem_ctx_default));
+    return MCA_SPML_CALL(put(oshmem_ctx_default, (void *) flag, sizeof(value),
+                             (void *) &value, pe));
+}
+
+/** Wait until one of our flags reached a sequence number */
+static inline int mca_scoll_hier_wait(long *flag, long value)
+{
+    int rc;
+
+    rc = MCA_SPML_CALL(wait((void *) flag, SHMEM_CMP_GE, (void *) &value, SHMEM_LONG));
+    opal_atomic_rmb();
+    return rc;
+}
+
+/** Wait until a flag of another PE reached a sequence number */
+static inline int mca_scoll_hier_poll(long *flag, long value, int pe)
+{
+    volatile long *ptr = mca_scoll_hier_ptr(flag, pe);
+    long remote;
+    int rc;
+
+    if (NULL != ptr) {
+        while (*ptr < value) {
+            opal_progress();
+        }
+        opal_atomic_rmb();
+        return OSHMEM_SUCCESS;
+    }
+
+    do {
+        rc = MCA_SPML_CALL(get(oshmem_ctx_default, (void *) flag, sizeof(remote),
+                               (void *) &remote, pe));
+    } while ((OSHMEM_SUCCESS == rc) && (remote < value));
+
+    return rc;
+}
+
+static inline int mca_scoll_hier_put(void *target, const void *source, size_t len, int pe)
+{
+    void *ptr = mca_scoll_hier_ptr(target, pe);
+
+    if (NULL != ptr) {
+        memcpy(ptr, source, len);
+        return OSHMEM_SUCCESS;
+    }
+
+    return MCA_SPML_CALL(put(oshmem_ctx_default, target, len, (void *) source, pe));
+}
+
+static inline int mca_scoll_hier_get(void *target, const void *source, size_t len, int pe)
+{
+    void *ptr = mca_scoll_hier_ptr(source, pe);
+
+    if (NULL != ptr) {
+        memcpy(target, ptr, len);
+        return OSHMEM_SUCCESS;
+    }
+
+    return MCA_SPML_CALL(get(oshmem_ctx_default, (void *) source, len, target, pe));
+}
+
+/** Lowest set bit of a node rank in a tree of node_count nodes, the root
+ * owns the whole tree */
+static inline int mca_scoll_hier_subtree(int vrank)
+{
+    int mask = 1;
+
+    if (0 == vrank) {
+        while (mask < mca_scoll_hier_component.node_count) {
+            mask <<= 1;
+        }
+        return mask;
+    }
+
+    while (!(vrank & mask)) {
+        mask <<= 1;
+    }
+    return mask;
+}
+
+END_C_DECLS
+
+#endif /* MCA_SCOLL_HIER_H */
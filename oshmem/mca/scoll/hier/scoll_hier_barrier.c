@@ -0,0 +1,66 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/mca/scoll/scoll.h"
+#include "oshmem/mca/scoll/base/base.h"
+#include "scoll_hier.h"
+
+/*
+ * The PEs of a node report to their leader through shared memory, the
+ * leaders run a dissemination barrier and then release their PEs. Only
+ * log2(nodes) messages per node cross the network.
+ */
+int mca_scoll_hier_barrier(struct oshmem_group_t *group, long *pSync, int alg)
+{
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+    mca_scoll_hier_sync_t *sync = cm->sync;
+    long seq = ++cm->seq;
+    int rc = OSHMEM_SUCCESS;
+    int dist;
+    int i;
+
+    SCOLL_VERBOSE(12, "[#%d] Barrier algorithm: Hierarchical", group->my_pe);
+
+    /* all outstanding puts must be completed */
+    MCA_SPML_CALL(quiet(oshmem_ctx_default));
+
+    if (0 != cm->local_rank) {
+        rc = mca_scoll_hier_signal(mca_scoll_hier_arrive(cm->local_rank), seq,
+                                   cm->local_pes[0]);
+        if (OSHMEM_SUCCESS != rc) {
+            return rc;
+        }
+
+        return mca_scoll_hier_wait(&sync->release, seq);
+    }
+
+    for (i = 1; (OSHMEM_SUCCESS == rc) && (i < cm->local_size); i++) {
+        rc = mca_scoll_hier_wait(mca_scoll_hier_arrive(i), seq);
+    }
+
+    for (i = 0, dist = 1; (OSHMEM_SUCCESS == rc) && (dist < cm->node_count);
+         i++, dist <<= 1) {
+        SCOLL_VERBOSE(14, "[#%d] round %d: signal node %d", group->my_pe, i,
+                      (cm->node_rank + dist) % cm->node_count);
+        rc = mca_scoll_hier_signal(&sync->round[i], seq,
+                                   cm->node_leader[(cm->node_rank + dist) % cm->node_count]);
+        if (OSHMEM_SUCCESS == rc) {
+            rc = mca_scoll_hier_wait(&sync->round[i], seq);
+        }
+    }
+
+    for (i = 1; (OSHMEM_SUCCESS == rc) && (i < cm->local_size); i++) {
+        rc = mca_scoll_hier_signal(&sync->release, seq, cm->local_pes[i]);
+    }
+
+    return rc;
+}
@@ -0,0 +1,136 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/mca/scoll/scoll.h"
+#include "oshmem/mca/scoll/base/base.h"
+#include "scoll_hier.h"
+
+/*
+ * The root sends the data along a binomial tree of nodes to the leader
+ * of every other node, then the PE holding the data on every node (the
+ * root on its own node) writes it to the other PEs of the node. Large
+ * messages are instead read by every PE of the node, so that the copies
+ * run in parallel.
+ */
+int mca_scoll_hier_broadcast(struct oshmem_group_t *group,
+                             int PE_root,
+                             void *target,
+                             const void *source,
+                             size_t nlong,
+                             long *pSync,
+                             bool nlong_type,
+                             int alg)
+{
+    mca_scoll_hier_module_t *module =
+        (mca_scoll_hier_module_t *) group->g_scoll.scoll_broadcast_module;
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+    mca_scoll_hier_sync_t *sync = cm->sync;
+    int rc = OSHMEM_SUCCESS;
+    int me = group->my_pe;
+    int root_node;
+    int vrank;
+    int mask;
+    int peer;
+    int rep;
+    int i;
+    bool pull;
+    const void *buf;
+    long seq;
+
+    /* Only the root knows the size otherwise */
+    if (!nlong_type) {
+        if (NULL == module->previous_broadcast) {
+            return OSHMEM_ERR_NOT_SUPPORTED;
+        }
+        return module->previous_broadcast(group, PE_root, target, source, nlong,
+                                          pSync, nlong_type, alg);
+    }
+
+    /* Do nothing on zero-length request */
+    if (OPAL_UNLIKELY(!nlong)) {
+        return OSHMEM_SUCCESS;
+    }
+
+    SCOLL_VERBOSE(12, "[#%d] Broadcast algorithm: Hierarchical", me);
+    seq = ++cm->seq;
+    pull = (nlong >= cm->bcast_pull_size);
+
+    /* Our target may be written from now on */
+    opal_atomic_wmb();
+    sync->entered = seq;
+
+    root_node = cm->pe_node[PE_root];
+    rep = (cm->node_rank == root_node) ? PE_root : cm->node_leader[cm->node_rank];
+    buf = (rep == PE_root) ? source : target;
+
+    if (me != rep) {
+        rc = mca_scoll_hier_signal(mca_scoll_hier_arrive(cm->local_rank), seq, rep);
+        if (OSHMEM_SUCCESS == rc) {
+            rc = mca_scoll_hier_wait(&sync->release, seq);
+        }
+        if ((OSHMEM_SUCCESS == rc) && pull) {
+            rc = mca_scoll_hier_get(target, buf, nlong, rep);
+            if (OSHMEM_SUCCESS == rc) {
+                rc = mca_scoll_hier_signal(mca_scoll_hier_done(cm->local_rank), seq, rep);
+            }
+        }
+        return rc;
+    }
+
+    /* Receive from the parent node */
+    vrank = (cm->node_rank - root_node + cm->node_count) % cm->node_count;
+    if (0 != vrank) {
+        rc = mca_scoll_hier_wait(&sync->down, seq);
+    }
+
+    /* Send to the children nodes, largest subtree first */
+    for (mask = mca_scoll_hier_subtree(vrank) >> 1; (OSHMEM_SUCCESS == rc) && (mask > 0);
+         mask >>= 1) {
+        if (vrank + mask >= cm->node_count) {
+            continue;
+        }
+
+        peer = cm->node_leader[(vrank + mask + root_node) % cm->node_count];
+        SCOLL_VERBOSE(14, "[#%d] send data to #%d", me, peer);
+        rc = mca_scoll_hier_poll(&sync->entered, seq, peer);
+        if (OSHMEM_SUCCESS == rc) {
+            rc = mca_scoll_hier_put(target, buf, nlong, peer);
+        }
+        if (OSHMEM_SUCCESS == rc) {
+            rc = mca_scoll_hier_signal(&sync->down, seq, peer);
+        }
+    }
+
+    /* Hand the data to the node */
+    for (i = 0; (OSHMEM_SUCCESS == rc) && (i < cm->local_size); i++) {
+        if (cm->local_pes[i] == me) {
+            continue;
+        }
+
+        rc = mca_scoll_hier_wait(mca_scoll_hier_arrive(i), seq);
+        if ((OSHMEM_SUCCESS == rc) && !pull) {
+            rc = mca_scoll_hier_put(target, buf, nlong, cm->local_pes[i]);
+        }
+        if (OSHMEM_SUCCESS == rc) {
+            rc = mca_scoll_hier_signal(&sync->release, seq, cm->local_pes[i]);
+        }
+    }
+
+    /* Our buffer is read until every PE is done */
+    for (i = 0; (OSHMEM_SUCCESS == rc) && pull && (i < cm->local_size); i++) {
+        if (cm->local_pes[i] != me) {
+            rc = mca_scoll_hier_wait(mca_scoll_hier_done(i), seq);
+        }
+    }
+
+    return rc;
+}
@@ -0,0 +1,118 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/mca/scoll/scoll.h"
+#include "oshmem/mca/scoll/base/base.h"
+#include "scoll_hier.h"
+
+/*
+ * Public string showing the scoll hier component version number
+ */
+const char *mca_scoll_hier_component_version_string =
+"Open SHMEM hierarchical collective MCA component version " OSHMEM_VERSION;
+
+/*
+ * Local function
+ */
+static int hier_register(void);
+static int hier_open(void);
+static int hier_close(void);
+
+/*
+ * Instantiate the public struct with all of our public information
+ * and pointers to our public functions in it
+ */
+
+mca_scoll_hier_component_t mca_scoll_hier_component = {
+    .super = {
+        /* First, the mca_component_t struct containing meta information
+           about the component itself */
+
+        .scoll_version = {
+            MCA_SCOLL_BASE_VERSION_2_0_0,
+
+            /* Component name and version */
+            .mca_component_name = "hier",
+            MCA_BASE_MAKE_VERSION(component, OSHMEM_MAJOR_VERSION, OSHMEM_MINOR_VERSION,
+                                  OSHMEM_RELEASE_VERSION),
+
+            /* Component open and close functions */
+            .mca_open_component = hier_open,
+            .mca_close_component = hier_close,
+            .mca_register_component_params = hier_register,
+        },
+        .scoll_data = {
+            /* The component is checkpoint ready */
+            MCA_BASE_METADATA_PARAM_CHECKPOINT
+        },
+
+        /* Initialization / querying functions */
+
+        .scoll_init = mca_scoll_hier_init,
+        .scoll_query = mca_scoll_hier_query,
+    },
+};
+MCA_BASE_COMPONENT_INIT(oshmem, scoll, hier)
+
+static int hier_register(void)
+{
+    mca_base_component_t *comp = &mca_scoll_hier_component.super.scoll_version;
+
+    mca_scoll_hier_component.priority = 80;
+    (void) mca_base_component_var_register(comp,
+                                           "priority",
+                                           "Priority of the scoll:hier component",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_scoll_hier_component.priority);
+
+    mca_scoll_hier_component.min_local_size = 4;
+    (void) mca_base_component_var_register(comp,
+                                           "min_local_size",
+                                           "Use the hierarchical collectives only if at least one node runs this many PEs",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_scoll_hier_component.min_local_size);
+
+    mca_scoll_hier_component.reduce_max_size = 16384;
+    (void) mca_base_component_var_register(comp,
+                                           "reduce_max_size",
+                                           "Largest reduction in bytes done by the hierarchical algorithm, larger ones use the next scoll component",
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_scoll_hier_component.reduce_max_size);
+
+    mca_scoll_hier_component.bcast_pull_size = 8192;
+    (void) mca_base_component_var_register(comp,
+                                           "bcast_pull_size",
+                                           "Broadcasts of at least this many bytes are copied by every PE of a node from the PE that holds the data, smaller ones are written by that PE",
+                                           MCA_BASE_VAR_TYPE_SIZE_T, NULL, 0, MCA_BASE_VAR_FLAG_SETTABLE,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_scoll_hier_component.bcast_pull_size);
+
+    return OSHMEM_SUCCESS;
+}
+
+static int hier_open(void)
+{
+    return OSHMEM_SUCCESS;
+}
+
+static int hier_close(void)
+{
+    mca_scoll_hier_cleanup();
+    return OSHMEM_SUCCESS;
+}
@@ -0,0 +1,282 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "opal/class/opal_hash_table.h"
+#include "opal/mca/pmix/pmix-internal.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/mca/scoll/scoll.h"
+#include "oshmem/mca/scoll/base/base.h"
+#include "oshmem/proc/proc.h"
+#include "scoll_hier.h"
+
+static void mca_scoll_hier_module_construct(mca_scoll_hier_module_t *module)
+{
+    module->previous_broadcast = NULL;
+    module->previous_broadcast_module = NULL;
+    module->previous_reduce = NULL;
+    module->previous_reduce_module = NULL;
+}
+
+static void mca_scoll_hier_module_destruct(mca_scoll_hier_module_t *module)
+{
+    if (NULL != module->previous_broadcast_module) {
+        OBJ_RELEASE(module->previous_broadcast_module);
+    }
+    if (NULL != module->previous_reduce_module) {
+        OBJ_RELEASE(module->previous_reduce_module);
+    }
+}
+
+OBJ_CLASS_INSTANCE(mca_scoll_hier_module_t,
+                   mca_scoll_base_module_t,
+                   mca_scoll_hier_module_construct,
+                   mca_scoll_hier_module_destruct);
+
+#define HIER_SAVE_PREV_SCOLL_API(__api) do {\
+    module->previous_ ## __api            = group->g_scoll.scoll_ ## __api;\
+    module->previous_ ## __api ## _module = group->g_scoll.scoll_ ## __api ## _module;\
+    if (NULL != module->previous_ ## __api ## _module) {\
+        OBJ_RETAIN(module->previous_ ## __api ## _module);\
+    }\
+} while(0)
+
+/*
+ * Keep the functions of the lower priority components for the calls
+ * the hierarchical algorithms do not handle
+ */
+static int mca_scoll_hier_module_enable(mca_scoll_base_module_t *super,
+                                        struct oshmem_group_t *group)
+{
+    mca_scoll_hier_module_t *module = (mca_scoll_hier_module_t *) super;
+
+    HIER_SAVE_PREV_SCOLL_API(broadcast);
+    HIER_SAVE_PREV_SCOLL_API(reduce);
+
+    return OSHMEM_SUCCESS;
+}
+
+int mca_scoll_hier_init(bool enable_progress_threads, bool enable_threads)
+{
+    return OSHMEM_SUCCESS;
+}
+
+static bool mca_scoll_hier_group_is_all(struct oshmem_group_t *group)
+{
+    int i;
+
+    if (group->proc_count != oshmem_num_procs()) {
+        return false;
+    }
+
+    for (i = 0; i < group->proc_count; i++) {
+        if (oshmem_proc_pe_vpid(group, i) != i) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Find the node of every PE. Nodes are numbered in the order of their
+ * lowest PE, which is also their leader, so that all PEs agree on it.
+ */
+static int mca_scoll_hier_topology(void)
+{
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+    opal_process_name_t name;
+    opal_hash_table_t nodes;
+    int npes = oshmem_num_procs();
+    int me = oshmem_my_proc_id();
+    int *node_size = NULL;
+    uint32_t val, *pval;
+    void *index;
+    int pe, rc;
+
+    cm->pe_node = malloc(npes * sizeof(*cm->pe_node));
+    cm->node_leader = malloc(npes * sizeof(*cm->node_leader));
+    node_size = calloc(npes, sizeof(*node_size));
+    if ((NULL == cm->pe_node) || (NULL == cm->node_leader) || (NULL == node_size)) {
+        free(node_size);
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+
+    OBJ_CONSTRUCT(&nodes, opal_hash_table_t);
+    opal_hash_table_init(&nodes, 64);
+
+    cm->node_count = 0;
+    name.jobid = OMPI_PROC_MY_NAME->jobid;
+    for (pe = 0; pe < npes; pe++) {
+        name.vpid = pe;
+        pval = &val;
+        OPAL_MODEX_RECV_VALUE(rc, PMIX_NODEID, &name, &pval, PMIX_UINT32);
+        if (PMIX_SUCCESS != rc) {
+            SCOLL_VERBOSE(5, "no node id for PE %d, disqualifying myself", pe);
+            OBJ_DESTRUCT(&nodes);
+            free(node_size);
+            return OSHMEM_ERR_NOT_AVAILABLE;
+        }
+
+        if (OPAL_SUCCESS != opal_hash_table_get_value_uint32(&nodes, val, &index)) {
+            index = (void *) (intptr_t) cm->node_count;
+            opal_hash_table_set_value_uint32(&nodes, val, index);
+            cm->node_leader[cm->node_count++] = pe;
+        }
+        cm->pe_node[pe] = (int) (intptr_t) index;
+        node_size[cm->pe_node[pe]]++;
+    }
+    OBJ_DESTRUCT(&nodes);
+
+    cm->node_rank = cm->pe_node[me];
+    cm->local_size = node_size[cm->node_rank];
+    cm->max_local_size = 0;
+    for (pe = 0; pe < cm->node_count; pe++) {
+        if (node_size[pe] > cm->max_local_size) {
+            cm->max_local_size = node_size[pe];
+        }
+    }
+    free(node_size);
+
+    cm->local_pes = malloc(cm->local_size * sizeof(*cm->local_pes));
+    if (NULL == cm->local_pes) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+
+    cm->local_size = 0;
+    for (pe = 0; pe < npes; pe++) {
+        if (cm->pe_node[pe] == cm->node_rank) {
+            if (pe == me) {
+                cm->local_rank = cm->local_size;
+            }
+            cm->local_pes[cm->local_size++] = pe;
+        }
+    }
+
+    return OSHMEM_SUCCESS;
+}
+
+/*
+ * Allocate the flags once for all groups spanning every PE. All PEs
+ * come here for the first such group and take the same decision.
+ */
+static int mca_scoll_hier_setup(void)
+{
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+    size_t size;
+    void *ptr = NULL;
+    int rc;
+
+    rc = mca_scoll_hier_topology();
+    if (OSHMEM_SUCCESS != rc) {
+        return rc;
+    }
+
+    if ((cm->max_local_size < cm->min_local_size) || (cm->max_local_size < 2)) {
+        SCOLL_VERBOSE(5, "at most %d PEs per node, disqualifying myself",
+                      cm->max_local_size);
+        return OSHMEM_ERR_NOT_AVAILABLE;
+    }
+
+    if (cm->node_count > (1 << (SCOLL_HIER_MAX_ROUNDS - 1))) {
+        return OSHMEM_ERR_NOT_AVAILABLE;
+    }
+
+    cm->tmp = malloc(cm->reduce_max_size);
+    if (NULL == cm->tmp) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+
+    size = sizeof(*cm->sync) + 2 * cm->max_local_size * sizeof(long);
+    rc = MCA_MEMHEAP_CALL(private_alloc(size, &ptr));
+    if ((OSHMEM_SUCCESS != rc) || (NULL == ptr)) {
+        SCOLL_ERROR("failed to allocate %zu bytes of synchronization flags", size);
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+
+    memset(ptr, 0, size);
+    cm->sync = ptr;
+    cm->seq = 0;
+
+    SCOLL_VERBOSE(5, "%d nodes, %d of %d PEs on node %d",
+                  cm->node_count, cm->local_rank, cm->local_size, cm->node_rank);
+
+    return OSHMEM_SUCCESS;
+}
+
+void mca_scoll_hier_cleanup(void)
+{
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+
+    if (NULL != cm->sync) {
+        MCA_MEMHEAP_CALL(private_free(cm->sync));
+        cm->sync = NULL;
+    }
+
+    free(cm->tmp);
+    free(cm->local_pes);
+    free(cm->pe_node);
+    free(cm->node_leader);
+    cm->tmp = NULL;
+    cm->local_pes = NULL;
+    cm->pe_node = NULL;
+    cm->node_leader = NULL;
+}
+
+/*
+ * Invoked when there's a new group that has been created.
+ * Look at the group and decide which set of functions and
+ * priority we want to return.
+ */
+mca_scoll_base_module_t *
+mca_scoll_hier_query(struct oshmem_group_t *group, int *priority)
+{
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+    static bool checked = false;
+    mca_scoll_hier_module_t *module;
+
+    *priority = cm->priority;
+
+    /* The flags come from the private heap, which is not ready
+     * yet when the first group is created */
+    if ((group->proc_count < 2) || (NULL == mca_scoll_sync_array) ||
+        !mca_scoll_hier_group_is_all(group)) {
+        return NULL;
+    }
+
+    if (!checked) {
+        checked = true;
+        if (OSHMEM_SUCCESS != mca_scoll_hier_setup()) {
+            mca_scoll_hier_cleanup();
+        }
+    }
+
+    if (NULL == cm->sync) {
+        return NULL;
+    }
+
+    module = OBJ_NEW(mca_scoll_hier_module_t);
+    if (NULL == module) {
+        return NULL;
+    }
+
+    module->super.scoll_module_enable = mca_scoll_hier_module_enable;
+    module->super.scoll_barrier = mca_scoll_hier_barrier;
+    module->super.scoll_broadcast = mca_scoll_hier_broadcast;
+    module->super.scoll_collect = NULL;
+    module->super.scoll_reduce = mca_scoll_hier_reduce;
+    module->super.scoll_alltoall = NULL;
+
+    return &(module->super);
+}
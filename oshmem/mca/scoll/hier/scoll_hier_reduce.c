@@ -0,0 +1,138 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil -*- */
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/op/op.h"
+#include "oshmem/mca/scoll/scoll.h"
+#include "oshmem/mca/scoll/base/base.h"
+#include "scoll_hier.h"
+
+/* Combine the buffer of another PE into ours, in place if it is mapped */
+static int _reduce_from(struct oshmem_op_t *op, void *target, const void *peer_buf,
+                        size_t nlong, int pe)
+{
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+    void *in = mca_scoll_hier_ptr(peer_buf, pe);
+    int rc;
+
+    if (NULL == in) {
+        rc = MCA_SPML_CALL(get(oshmem_ctx_default, (void *) peer_buf, nlong, cm->tmp, pe));
+        if (OSHMEM_SUCCESS != rc) {
+            return rc;
+        }
+        in = cm->tmp;
+    }
+
+    op->o_func.c_fn(in, target, (int) (nlong / op->dt_size));
+    return OSHMEM_SUCCESS;
+}
+
+/*
+ * The leader of every node combines the sources of its PEs, the leaders
+ * combine their results along a binomial tree rooted at node 0 and send
+ * the result back down the same tree, and every leader hands it to its
+ * PEs. Large reductions are bandwidth bound and are left to the next
+ * component.
+ */
+int mca_scoll_hier_reduce(struct oshmem_group_t *group,
+                          struct oshmem_op_t *op,
+                          void *target,
+                          const void *source,
+                          size_t nlong,
+                          long *pSync,
+                          void *pWrk,
+                          int alg)
+{
+    mca_scoll_hier_module_t *module =
+        (mca_scoll_hier_module_t *) group->g_scoll.scoll_reduce_module;
+    mca_scoll_hier_component_t *cm = &mca_scoll_hier_component;
+    mca_scoll_hier_sync_t *sync = cm->sync;
+    int rc = OSHMEM_SUCCESS;
+    int node = cm->node_rank;
+    int mask;
+    int top;
+    int i;
+    long seq;
+
+    if ((nlong > cm->reduce_max_size) || (0 == nlong)) {
+        if (NULL == module->previous_reduce) {
+            return OSHMEM_ERR_NOT_SUPPORTED;
+        }
+        SCOLL_VERBOSE(12, "[#%d] Reduce of %zu bytes: next component",
+                      group->my_pe, nlong);
+        return module->previous_reduce(group, op, target, source, nlong, pSync,
+                                       pWrk, alg);
+    }
+
+    SCOLL_VERBOSE(12, "[#%d] Reduce algorithm: Hierarchical", group->my_pe);
+    seq = ++cm->seq;
+
+    if (0 != cm->local_rank) {
+        rc = mca_scoll_hier_signal(mca_scoll_hier_arrive(cm->local_rank), seq,
+                                   cm->local_pes[0]);
+        if (OSHMEM_SUCCESS != rc) {
+            return rc;
+        }
+
+        return mca_scoll_hier_wait(&sync->release, seq);
+    }
+
+    /* Combine the node */
+    if (target != source) {
+        memcpy(target, source, nlong);
+    }
+    for (i = 1; (OSHMEM_SUCCESS == rc) && (i < cm->local_size); i++) {
+        rc = mca_scoll_hier_wait(mca_scoll_hier_arrive(i), seq);
+        if (OSHMEM_SUCCESS == rc) {
+            rc = _reduce_from(op, target, source, nlong, cm->local_pes[i]);
+        }
+    }
+
+    /* Combine the children nodes, then pass the result to the parent */
+    for (i = 0, mask = 1; (OSHMEM_SUCCESS == rc) && (mask < cm->node_count);
+         i++, mask <<= 1) {
+        if (node & mask) {
+            rc = mca_scoll_hier_signal(&sync->child[i], seq, cm->node_leader[node - mask]);
+            if (OSHMEM_SUCCESS == rc) {
+                rc = mca_scoll_hier_wait(&sync->down, seq);
+            }
+            break;
+        }
+
+        if (node + mask < cm->node_count) {
+            rc = mca_scoll_hier_wait(&sync->child[i], seq);
+            if (OSHMEM_SUCCESS == rc) {
+                rc = _reduce_from(op, target, target, nlong, cm->node_leader[node + mask]);
+            }
+        }
+    }
+    top = mask;
+
+    /* Send the result to the children nodes */
+    for (mask = top >> 1; (OSHMEM_SUCCESS == rc) && (mask > 0); mask >>= 1) {
+        if (node + mask < cm->node_count) {
+            rc = mca_scoll_hier_put(target, target, nlong, cm->node_leader[node + mask]);
+            if (OSHMEM_SUCCESS == rc) {
+                rc = mca_scoll_hier_signal(&sync->down, seq, cm->node_leader[node + mask]);
+            }
+        }
+    }
+
+    /* And to the node */
+    for (i = 1; (OSHMEM_SUCCESS == rc) && (i < cm->local_size); i++) {
+        rc = mca_scoll_hier_put(target, target, nlong, cm->local_pes[i]);
+        if (OSHMEM_SUCCESS == rc) {
+            rc = mca_scoll_hier_signal(&sync->release, seq, cm->local_pes[i]);
+        }
+    }
+
+    return rc;
+}
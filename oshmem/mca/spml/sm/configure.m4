@@ -0,0 +1,26 @@
+# -*- shell-script -*-
+#
+# $COPYRIGHT$
+#
+# Additional copyrights may follow
+#
+# $HEADER$
+#
+
+# MCA_oshmem_spml_sm_CONFIG([action-if-can-compile],
+#                    [action-if-cant-compile])
+# ------------------------------------------------
+# The component only depends on the smsc framework, which decides at run
+# time whether XPMEM or CMA is available.
+AC_DEFUN([MCA_oshmem_spml_sm_CONFIG],[
+    AC_CONFIG_FILES([oshmem/mca/spml/sm/Makefile])
+
+    case "$host" in
+        *linux*)
+            $1
+            ;;
+        *)
+            $2
+            ;;
+    esac
+])dnl
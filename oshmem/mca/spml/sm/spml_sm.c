@@ -0,0 +1,674 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+
+#include <string.h>
+
+#include "opal/sys/atomic.h"
+#include "ompi/mca/pml/pml.h"
+#include "ompi/datatype/ompi_datatype.h"
+#include "ompi/communicator/communicator.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/include/shmem.h"
+#include "oshmem/mca/atomic/atomic.h"
+#include "oshmem/mca/spml/base/base.h"
+
+#include "spml_sm.h"
+
+mca_spml_sm_t mca_spml_sm = {
+    .super = {
+        /* Init mca_spml_base_module_t */
+        .spml_add_procs     = mca_spml_sm_add_procs,
+        .spml_del_procs     = mca_spml_sm_del_procs,
+        .spml_enable        = mca_spml_sm_enable,
+        .spml_register      = mca_spml_sm_register,
+        .spml_deregister    = mca_spml_sm_deregister,
+        .spml_oob_get_mkeys = mca_spml_base_oob_get_mkeys,
+        .spml_ctx_create    = mca_spml_sm_ctx_create,
+        .spml_ctx_destroy   = mca_spml_sm_ctx_destroy,
+        .spml_put           = mca_spml_sm_put,
+        .spml_put_nb        = mca_spml_sm_put_nb,
+        .spml_put_signal    = mca_spml_sm_put_signal,
+        .spml_put_signal_nb = mca_spml_sm_put_signal_nb,
+        .spml_get           = mca_spml_sm_get,
+        .spml_get_nb        = mca_spml_sm_get_nb,
+        .spml_recv          = mca_spml_sm_recv,
+        .spml_send          = mca_spml_sm_send,
+        .spml_fence         = mca_spml_sm_fence,
+        .spml_quiet         = mca_spml_sm_quiet,
+        .spml_rmkey_unpack  = mca_spml_sm_rmkey_unpack,
+        .spml_rmkey_free    = mca_spml_sm_rmkey_free,
+        .spml_rmkey_ptr     = mca_spml_sm_rmkey_ptr,
+        .spml_memuse_hook   = mca_spml_base_memuse_hook,
+        .spml_put_all_nb    = mca_spml_base_put_all_nb,
+        .spml_wait                      = mca_spml_base_wait,
+        .spml_wait_nb                   = mca_spml_base_wait_nb,
+        .spml_wait_until_all            = mca_spml_sm_wait_until_all,
+        .spml_wait_until_any            = mca_spml_sm_wait_until_any,
+        .spml_wait_until_some           = mca_spml_sm_wait_until_some,
+        .spml_wait_until_all_vector     = mca_spml_sm_wait_until_all_vector,
+        .spml_wait_until_any_vector     = mca_spml_sm_wait_until_any_vector,
+        .spml_wait_until_some_vector    = mca_spml_sm_wait_until_some_vector,
+        .spml_test                      = mca_spml_base_test,
+        .spml_test_all                  = mca_spml_sm_test_all,
+        .spml_test_any                  = mca_spml_sm_test_any,
+        .spml_test_some                 = mca_spml_sm_test_some,
+        .spml_test_all_vector           = mca_spml_sm_test_all_vector,
+        .spml_test_any_vector           = mca_spml_sm_test_any_vector,
+        .spml_test_some_vector          = mca_spml_sm_test_some_vector,
+        .spml_team_sync                 = mca_spml_sm_team_sync,
+        .spml_team_my_pe                = mca_spml_sm_team_my_pe,
+        .spml_team_n_pes                = mca_spml_sm_team_n_pes,
+        .spml_team_get_config           = mca_spml_sm_team_get_config,
+        .spml_team_translate_pe         = mca_spml_sm_team_translate_pe,
+        .spml_team_split_strided        = mca_spml_sm_team_split_strided,
+        .spml_team_split_2d             = mca_spml_sm_team_split_2d,
+        .spml_team_destroy              = mca_spml_sm_team_destroy,
+        .spml_team_get                  = mca_spml_sm_team_get,
+        .spml_team_create_ctx           = mca_spml_sm_team_create_ctx,
+        .spml_team_alltoall             = mca_spml_sm_team_alltoall,
+        .spml_team_alltoalls            = mca_spml_sm_team_alltoalls,
+        .spml_team_broadcast            = mca_spml_sm_team_broadcast,
+        .spml_team_collect              = mca_spml_sm_team_collect,
+        .spml_team_fcollect             = mca_spml_sm_team_fcollect,
+        .spml_team_reduce               = mca_spml_sm_team_reduce,
+        .self                           = (void*)&mca_spml_sm
+    },
+
+    .enabled     = false,
+    .can_map     = false,
+    .endpoints   = NULL,
+    .n_endpoints = 0
+};
+
+mca_spml_sm_ctx_t mca_spml_sm_ctx_default = {
+    .options = 0
+};
+
+int mca_spml_sm_enable(bool enable)
+{
+    SPML_VERBOSE(50, "*** sm ENABLED ****");
+    if (false == enable) {
+        return OSHMEM_SUCCESS;
+    }
+
+    mca_spml_sm.enabled = true;
+
+    return OSHMEM_SUCCESS;
+}
+
+int mca_spml_sm_add_procs(oshmem_group_t* group, size_t nprocs)
+{
+    int my_pe = oshmem_my_proc_id();
+    ompi_proc_t *proc;
+    size_t pe;
+
+    mca_spml_sm.endpoints = (mca_smsc_endpoint_t **) calloc(nprocs, sizeof(mca_smsc_endpoint_t *));
+    if (NULL == mca_spml_sm.endpoints) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+    mca_spml_sm.n_endpoints = nprocs;
+
+    for (pe = 0; pe < nprocs; pe++) {
+        if ((int) pe == my_pe) {
+            continue;
+        }
+
+        if (!oshmem_proc_on_local_node(pe)) {
+            SPML_ERROR("PE %d is not on the local node, spml/sm only supports "
+                       "jobs running on a single node", (int) pe);
+            goto error;
+        }
+
+        proc = oshmem_proc_find(pe);
+        if (NULL == proc) {
+            goto error;
+        }
+
+        mca_spml_sm.endpoints[pe] = MCA_SMSC_CALL(get_endpoint, &proc->super);
+        if (NULL == mca_spml_sm.endpoints[pe]) {
+            SPML_ERROR("failed to get an smsc endpoint for PE %d", (int) pe);
+            goto error;
+        }
+    }
+
+    SPML_VERBOSE(50, "*** sm added %d procs (map: %d) ***", (int) nprocs,
+                 (int) mca_spml_sm.can_map);
+
+    return OSHMEM_SUCCESS;
+
+error:
+    mca_spml_sm_del_procs(group, nprocs);
+    return OSHMEM_ERROR;
+}
+
+int mca_spml_sm_del_procs(oshmem_group_t* group, size_t nprocs)
+{
+    size_t pe;
+
+    if (NULL == mca_spml_sm.endpoints) {
+        return OSHMEM_SUCCESS;
+    }
+
+    for (pe = 0; pe < mca_spml_sm.n_endpoints; pe++) {
+        if (NULL != mca_spml_sm.endpoints[pe]) {
+            MCA_SMSC_CALL(return_endpoint, mca_spml_sm.endpoints[pe]);
+        }
+    }
+
+    free(mca_spml_sm.endpoints);
+    mca_spml_sm.endpoints   = NULL;
+    mca_spml_sm.n_endpoints = 0;
+
+    return OSHMEM_SUCCESS;
+}
+
+int mca_spml_sm_ctx_create(long options, shmem_ctx_t *ctx)
+{
+    mca_spml_sm_ctx_t *sm_ctx;
+
+    /* All operations complete before they return, so a context only keeps
+     * its options. */
+    sm_ctx = (mca_spml_sm_ctx_t *) malloc(sizeof(*sm_ctx));
+    if (NULL == sm_ctx) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+    sm_ctx->options = options;
+
+    *ctx = (shmem_ctx_t) sm_ctx;
+    return OSHMEM_SUCCESS;
+}
+
+void mca_spml_sm_ctx_destroy(shmem_ctx_t ctx)
+{
+    MCA_SPML_CALL(quiet(ctx));
+
+    if (ctx != (shmem_ctx_t) &mca_spml_sm_ctx_default) {
+        free(ctx);
+    }
+}
+
+sshmem_mkey_t *mca_spml_sm_register(void* addr,
+                                    size_t size,
+                                    uint64_t shmid,
+                                    int *count)
+{
+    sshmem_mkey_t *mkeys;
+    uint64_t *seg_size;
+
+    *count = 0;
+    mkeys = (sshmem_mkey_t *) calloc(SPML_SM_TRANSP_CNT, sizeof(*mkeys));
+    if (NULL == mkeys) {
+        return NULL;
+    }
+
+    /* Peers attach to the segment by its address, the key only carries the
+     * segment size. A non-empty key also makes memheap call rmkey_free. */
+    seg_size = (uint64_t *) malloc(sizeof(*seg_size));
+    if (NULL == seg_size) {
+        free(mkeys);
+        return NULL;
+    }
+    *seg_size = size;
+
+    mkeys[SPML_SM_TRANSP_IDX].va_base = addr;
+    mkeys[SPML_SM_TRANSP_IDX].len     = sizeof(*seg_size);
+    mkeys[SPML_SM_TRANSP_IDX].u.data  = seg_size;
+    *count = SPML_SM_TRANSP_CNT;
+
+    return mkeys;
+}
+
+int mca_spml_sm_deregister(sshmem_mkey_t *mkeys)
+{
+    MCA_SPML_CALL(quiet(oshmem_ctx_default));
+    if (!mkeys) {
+        return OSHMEM_SUCCESS;
+    }
+
+    free(mkeys[SPML_SM_TRANSP_IDX].u.data);
+    free(mkeys);
+
+    return OSHMEM_SUCCESS;
+}
+
+void mca_spml_sm_rmkey_unpack(shmem_ctx_t ctx, sshmem_mkey_t *mkey,
+                              uint32_t segno, int pe, int tr_id)
+{
+    mca_spml_sm_mkey_t *sm_mkey;
+    size_t size;
+
+    if (NULL != mkey->spml_context) {
+        return;
+    }
+
+    if ((size_t) pe >= mca_spml_sm.n_endpoints || NULL == mca_spml_sm.endpoints[pe] ||
+        sizeof(uint64_t) != mkey->len) {
+        SPML_ERROR("invalid remote key for PE %d segment %d", pe, (int) segno);
+        goto error_fatal;
+    }
+
+    sm_mkey = (mca_spml_sm_mkey_t *) calloc(1, sizeof(*sm_mkey));
+    if (NULL == sm_mkey) {
+        goto error_fatal;
+    }
+
+    mkey_segment_init(&sm_mkey->super, mkey, segno);
+    sm_mkey->endpoint = mca_spml_sm.endpoints[pe];
+
+    if (mca_spml_sm.can_map) {
+        size = (size_t) *(uint64_t *) mkey->u.data;
+        sm_mkey->map_ctx = MCA_SMSC_CALL(map_peer_region, sm_mkey->endpoint, 0,
+                                         mkey->va_base, size, &sm_mkey->local_base);
+        if (NULL == sm_mkey->map_ctx) {
+            /* fall back to copies through the endpoint */
+            SPML_VERBOSE(5, "could not map segment %d of PE %d", (int) segno, pe);
+            sm_mkey->local_base = NULL;
+        }
+    }
+
+    mkey->spml_context = sm_mkey;
+    return;
+
+error_fatal:
+    oshmem_shmem_abort(-1);
+}
+
+void mca_spml_sm_rmkey_free(sshmem_mkey_t *mkey, int pe)
+{
+    mca_spml_sm_mkey_t *sm_mkey = (mca_spml_sm_mkey_t *) mkey->spml_context;
+
+    if (NULL == sm_mkey) {
+        return;
+    }
+
+    if (NULL != sm_mkey->map_ctx) {
+        MCA_SMSC_CALL(unmap_peer_region, sm_mkey->map_ctx);
+    }
+
+    free(sm_mkey);
+    mkey->spml_context = NULL;
+}
+
+void *mca_spml_sm_rmkey_ptr(const void *dst_addr, sshmem_mkey_t *mkey, int pe)
+{
+    mca_spml_sm_mkey_t *sm_mkey = (mca_spml_sm_mkey_t *) mkey->spml_context;
+
+    if (NULL == sm_mkey || NULL == sm_mkey->local_base) {
+        return NULL;
+    }
+
+    return (char *) sm_mkey->local_base +
+           ((uintptr_t) dst_addr - (uintptr_t) sm_mkey->super.super.va_base);
+}
+
+/* Find the local mapping of va on pe, or the remote address and the
+ * endpoint to copy through if the segment is not mapped. */
+static inline int mca_spml_sm_lookup(shmem_ctx_t ctx, int pe, void *va,
+                                     void **local_ptr, void **rva,
+                                     mca_smsc_endpoint_t **endpoint)
+{
+    sshmem_mkey_t *mkey;
+    mca_spml_sm_mkey_t *sm_mkey;
+
+    mkey = mca_memheap_base_get_cached_mkey(ctx, pe, va, SPML_SM_TRANSP_IDX, rva);
+    if (OPAL_UNLIKELY(NULL == mkey)) {
+        SPML_ERROR("pe=%d: %p is not address of symmetric variable", pe, va);
+        oshmem_shmem_abort(-1);
+        return OSHMEM_ERROR;
+    }
+
+    if (pe == oshmem_my_proc_id()) {
+        *local_ptr = *rva;
+        return OSHMEM_SUCCESS;
+    }
+
+    sm_mkey = (mca_spml_sm_mkey_t *) mkey->spml_context;
+    if (NULL != sm_mkey->local_base) {
+        *local_ptr = (char *) sm_mkey->local_base +
+                     ((uintptr_t) va - (uintptr_t) sm_mkey->super.super.va_base);
+    } else {
+        *local_ptr = NULL;
+        *endpoint  = sm_mkey->endpoint;
+    }
+
+    return OSHMEM_SUCCESS;
+}
+
+int mca_spml_sm_put(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                    void* src_addr, int dst)
+{
+    mca_smsc_endpoint_t *endpoint = NULL;
+    void *local_ptr, *rva;
+    int rc;
+
+    rc = mca_spml_sm_lookup(ctx, dst, dst_addr, &local_ptr, &rva, &endpoint);
+    if (OPAL_UNLIKELY(OSHMEM_SUCCESS != rc)) {
+        return rc;
+    }
+
+    if (OPAL_LIKELY(NULL != local_ptr)) {
+        memcpy(local_ptr, src_addr, size);
+        return OSHMEM_SUCCESS;
+    }
+
+    return MCA_SMSC_CALL(copy_to, endpoint, src_addr, rva, size, NULL);
+}
+
+int mca_spml_sm_put_nb(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                       void* src_addr, int dst, void **handle)
+{
+    /* the copy is complete when put returns */
+    return mca_spml_sm_put(ctx, dst_addr, size, src_addr, dst);
+}
+
+int mca_spml_sm_get(shmem_ctx_t ctx, void *src_addr, size_t size,
+                    void *dst_addr, int src)
+{
+    mca_smsc_endpoint_t *endpoint = NULL;
+    void *local_ptr, *rva;
+    int rc;
+
+    rc = mca_spml_sm_lookup(ctx, src, src_addr, &local_ptr, &rva, &endpoint);
+    if (OPAL_UNLIKELY(OSHMEM_SUCCESS != rc)) {
+        return rc;
+    }
+
+    if (OPAL_LIKELY(NULL != local_ptr)) {
+        memcpy(dst_addr, local_ptr, size);
+        return OSHMEM_SUCCESS;
+    }
+
+    return MCA_SMSC_CALL(copy_from, endpoint, dst_addr, rva, size, NULL);
+}
+
+int mca_spml_sm_get_nb(shmem_ctx_t ctx, void *src_addr, size_t size,
+                       void *dst_addr, int src, void **handle)
+{
+    return mca_spml_sm_get(ctx, src_addr, size, dst_addr, src);
+}
+
+static inline int mca_spml_sm_signal(shmem_ctx_t ctx, uint64_t *sig_addr,
+                                     uint64_t signal, int sig_op, int dst)
+{
+    if (sig_op == SHMEM_SIGNAL_SET) {
+        return MCA_ATOMIC_CALL(set(ctx, (void*)sig_addr, signal,
+                                   sizeof(uint64_t), dst));
+    } else if (sig_op == SHMEM_SIGNAL_ADD) {
+        return MCA_ATOMIC_CALL(add(ctx, (void*)sig_addr, signal,
+                                   sizeof(uint64_t), dst));
+    }
+
+    SPML_ERROR("Invalid signal operation: %d", sig_op);
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_put_signal(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                           void* src_addr, uint64_t *sig_addr,
+                           uint64_t signal, int sig_op, int dst)
+{
+    int res;
+
+    res = mca_spml_sm_put(ctx, dst_addr, size, src_addr, dst);
+    if (OPAL_UNLIKELY(OSHMEM_SUCCESS != res)) {
+        return res;
+    }
+
+    /* the data has to be visible before the signal */
+    opal_atomic_wmb();
+
+    return mca_spml_sm_signal(ctx, sig_addr, signal, sig_op, dst);
+}
+
+int mca_spml_sm_put_signal_nb(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                              void* src_addr, uint64_t *sig_addr,
+                              uint64_t signal, int sig_op, int dst)
+{
+    return mca_spml_sm_put_signal(ctx, dst_addr, size, src_addr, sig_addr,
+                                  signal, sig_op, dst);
+}
+
+int mca_spml_sm_fence(shmem_ctx_t ctx)
+{
+    opal_atomic_wmb();
+    return OSHMEM_SUCCESS;
+}
+
+int mca_spml_sm_quiet(shmem_ctx_t ctx)
+{
+    opal_atomic_mb();
+    return OSHMEM_SUCCESS;
+}
+
+/* blocking receive */
+int mca_spml_sm_recv(void* buf, size_t size, int src)
+{
+    return MCA_PML_CALL(recv(buf,
+                size,
+                &(ompi_mpi_unsigned_char.dt),
+                src,
+                0,
+                &(ompi_mpi_comm_world.comm),
+                NULL));
+}
+
+/* for now only do blocking copy send */
+int mca_spml_sm_send(void* buf,
+                     size_t size,
+                     int dst,
+                     mca_spml_base_put_mode_t mode)
+{
+    return MCA_PML_CALL(send(buf,
+                size,
+                &(ompi_mpi_unsigned_char.dt),
+                dst,
+                0,
+                (mca_pml_base_send_mode_t)mode,
+                &(ompi_mpi_comm_world.comm)));
+}
+
+/* This routine is not implemented */
+void mca_spml_sm_wait_until_all(void *ivars, int cmp, void *cmp_value,
+                                size_t nelems, const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT();
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_wait_until_any(void *ivars, int cmp, void *cmp_value,
+                                  size_t nelems, const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_wait_until_some(void *ivars, int cmp, void *cmp_value,
+                                   size_t nelems, size_t *indices,
+                                   const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* This routine is not implemented */
+void mca_spml_sm_wait_until_all_vector(void *ivars, int cmp, void *cmp_values,
+                                       size_t nelems, const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT();
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_wait_until_any_vector(void *ivars, int cmp, void *cmp_values,
+                                         size_t nelems, const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_wait_until_some_vector(void *ivars, int cmp, void *cmp_values,
+                                          size_t nelems, size_t *indices,
+                                          const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* This routine is not implemented */
+int mca_spml_sm_test_all(void *ivars, int cmp, void *cmp_value,
+                         size_t nelems, const int *status, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_test_any(void *ivars, int cmp, void *cmp_value,
+                            size_t nelems, const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_test_some(void *ivars, int cmp, void *cmp_value,
+                             size_t nelems, size_t *indices,
+                             const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* This routine is not implemented */
+int mca_spml_sm_test_all_vector(void *ivars, int cmp, void *cmp_values,
+                                size_t nelems, const int *status, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_test_any_vector(void *ivars, int cmp, void *cmp_values,
+                                   size_t nelems, const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* This routine is not implemented */
+size_t mca_spml_sm_test_some_vector(void *ivars, int cmp, void *cmp_values,
+                                    size_t nelems, size_t *indices,
+                                    const int *status, int datatype)
+{
+    RUNTIME_SHMEM_NOT_IMPLEMENTED_API_ABORT_RET_SIZE_T();
+}
+
+/* Only SHMEM_TEAM_WORLD is supported */
+int mca_spml_sm_team_sync(shmem_team_t team)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_my_pe(shmem_team_t team)
+{
+    if (team == SHMEM_TEAM_WORLD) {
+        return shmem_my_pe();
+    }
+
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_n_pes(shmem_team_t team)
+{
+    if (team == SHMEM_TEAM_WORLD) {
+        return shmem_n_pes();
+    }
+
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_get_config(shmem_team_t team, long config_mask,
+                                shmem_team_config_t *config)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_translate_pe(shmem_team_t src_team, int src_pe,
+                                  shmem_team_t dest_team)
+{
+    if (src_team == dest_team) {
+        return src_pe;
+    }
+
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_split_strided(shmem_team_t parent_team, int start,
+                                   int stride, int size,
+                                   const shmem_team_config_t *config,
+                                   long config_mask, shmem_team_t *new_team)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_split_2d(shmem_team_t parent_team, int xrange,
+                              const shmem_team_config_t *xaxis_config,
+                              long xaxis_mask, shmem_team_t *xaxis_team,
+                              const shmem_team_config_t *yaxis_config,
+                              long yaxis_mask, shmem_team_t *yaxis_team)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_destroy(shmem_team_t team)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_get(shmem_ctx_t ctx, shmem_team_t *team)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_create_ctx(shmem_team_t team, long options, shmem_ctx_t *ctx)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_alltoall(shmem_team_t team, void *dest,
+                              const void *source, size_t nelems, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_alltoalls(shmem_team_t team, void *dest,
+                               const void *source, ptrdiff_t dst, ptrdiff_t sst,
+                               size_t nelems, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_broadcast(shmem_team_t team, void *dest,
+                               const void *source, size_t nelems,
+                               int PE_root, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_collect(shmem_team_t team, void *dest,
+                             const void *source, size_t nelems, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_fcollect(shmem_team_t team, void *dest,
+                              const void *source, size_t nelems, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
+
+int mca_spml_sm_team_reduce(shmem_team_t team, void *dest,
+                            const void *source, size_t nreduce,
+                            int operation, int datatype)
+{
+    return OSHMEM_ERR_NOT_IMPLEMENTED;
+}
@@ -0,0 +1,198 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ *  @file
+ *
+ * Shared-memory SPML for jobs that run on a single node. Remote symmetric
+ * segments are reached through the smsc framework: with XPMEM they are
+ * mapped into the address space and put/get become plain copies, with CMA
+ * every operation is a process_vm_readv/writev call.
+ */
+
+#ifndef MCA_SPML_SM_H
+#define MCA_SPML_SM_H
+
+#include "oshmem_config.h"
+#include "oshmem/mca/spml/base/base.h"
+#include "oshmem/mca/spml/spml.h"
+#include "oshmem/proc/proc.h"
+#include "oshmem/runtime/runtime.h"
+
+#include "oshmem/mca/memheap/memheap.h"
+#include "oshmem/mca/memheap/base/base.h"
+
+#include "opal/mca/smsc/smsc.h"
+
+BEGIN_C_DECLS
+
+#define SPML_SM_TRANSP_IDX 0
+#define SPML_SM_TRANSP_CNT 1
+
+/* Per peer and segment state, attached to the remote mkey */
+struct mca_spml_sm_mkey {
+    mkey_segment_t        super;       /* local segment bounds and remote base */
+    void                 *local_base;  /* remote segment mapped locally, or NULL */
+    void                 *map_ctx;     /* smsc mapping handle */
+    mca_smsc_endpoint_t  *endpoint;
+};
+typedef struct mca_spml_sm_mkey mca_spml_sm_mkey_t;
+
+struct mca_spml_sm_ctx {
+    long options;
+};
+typedef struct mca_spml_sm_ctx mca_spml_sm_ctx_t;
+
+extern mca_spml_sm_ctx_t mca_spml_sm_ctx_default;
+
+struct mca_spml_sm {
+    mca_spml_base_module_t   super;
+    int                      priority;
+    bool                     enabled;
+    bool                     can_map;     /* smsc can map peer memory */
+    mca_smsc_endpoint_t    **endpoints;   /* indexed by pe */
+    size_t                   n_endpoints;
+};
+typedef struct mca_spml_sm mca_spml_sm_t;
+
+extern mca_spml_sm_t mca_spml_sm;
+
+extern int mca_spml_sm_enable(bool enable);
+extern int mca_spml_sm_add_procs(oshmem_group_t* group, size_t nprocs);
+extern int mca_spml_sm_del_procs(oshmem_group_t* group, size_t nprocs);
+extern int mca_spml_sm_ctx_create(long options, shmem_ctx_t *ctx);
+extern void mca_spml_sm_ctx_destroy(shmem_ctx_t ctx);
+
+extern sshmem_mkey_t *mca_spml_sm_register(void* addr,
+                                           size_t size,
+                                           uint64_t shmid,
+                                           int *count);
+extern int mca_spml_sm_deregister(sshmem_mkey_t *mkeys);
+extern void mca_spml_sm_rmkey_unpack(shmem_ctx_t ctx, sshmem_mkey_t *mkey,
+                                     uint32_t segno, int pe, int tr_id);
+extern void mca_spml_sm_rmkey_free(sshmem_mkey_t *mkey, int pe);
+extern void *mca_spml_sm_rmkey_ptr(const void *dst_addr, sshmem_mkey_t *mkey, int pe);
+
+extern int mca_spml_sm_put(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                           void* src_addr, int dst);
+extern int mca_spml_sm_put_nb(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                              void* src_addr, int dst, void **handle);
+extern int mca_spml_sm_put_signal(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                                  void* src_addr, uint64_t *sig_addr,
+                                  uint64_t signal, int sig_op, int dst);
+extern int mca_spml_sm_put_signal_nb(shmem_ctx_t ctx, void* dst_addr, size_t size,
+                                     void* src_addr, uint64_t *sig_addr,
+                                     uint64_t signal, int sig_op, int dst);
+extern int mca_spml_sm_get(shmem_ctx_t ctx, void *src_addr, size_t size,
+                           void *dst_addr, int src);
+extern int mca_spml_sm_get_nb(shmem_ctx_t ctx, void *src_addr, size_t size,
+                              void *dst_addr, int src, void **handle);
+
+extern int mca_spml_sm_recv(void* buf, size_t size, int src);
+extern int mca_spml_sm_send(void* buf, size_t size, int dst,
+                            mca_spml_base_put_mode_t mode);
+
+extern int mca_spml_sm_fence(shmem_ctx_t ctx);
+extern int mca_spml_sm_quiet(shmem_ctx_t ctx);
+
+extern void mca_spml_sm_wait_until_all(void *ivars, int cmp, void *cmp_value,
+                                       size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_wait_until_any(void *ivars, int cmp, void *cmp_value,
+                                         size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_wait_until_some(void *ivars, int cmp, void *cmp_value,
+                                          size_t nelems, size_t *indices,
+                                          const int *status, int datatype);
+extern void mca_spml_sm_wait_until_all_vector(void *ivars, int cmp, void *cmp_values,
+                                              size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_wait_until_any_vector(void *ivars, int cmp, void *cmp_values,
+                                                size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_wait_until_some_vector(void *ivars, int cmp, void *cmp_values,
+                                                 size_t nelems, size_t *indices,
+                                                 const int *status, int datatype);
+extern int mca_spml_sm_test_all(void *ivars, int cmp, void *cmp_value,
+                                size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_test_any(void *ivars, int cmp, void *cmp_value,
+                                   size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_test_some(void *ivars, int cmp, void *cmp_value,
+                                    size_t nelems, size_t *indices,
+                                    const int *status, int datatype);
+extern int mca_spml_sm_test_all_vector(void *ivars, int cmp, void *cmp_values,
+                                       size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_test_any_vector(void *ivars, int cmp, void *cmp_values,
+                                          size_t nelems, const int *status, int datatype);
+extern size_t mca_spml_sm_test_some_vector(void *ivars, int cmp, void *cmp_values,
+                                           size_t nelems, size_t *indices,
+                                           const int *status, int datatype);
+
+extern int mca_spml_sm_team_sync(shmem_team_t team);
+extern int mca_spml_sm_team_my_pe(shmem_team_t team);
+extern int mca_spml_sm_team_n_pes(shmem_team_t team);
+extern int mca_spml_sm_team_get_config(shmem_team_t team, long config_mask,
+                                       shmem_team_config_t *config);
+extern int mca_spml_sm_team_translate_pe(shmem_team_t src_team, int src_pe,
+                                         shmem_team_t dest_team);
+extern int mca_spml_sm_team_split_strided(shmem_team_t parent_team, int start,
+                                          int stride, int size,
+                                          const shmem_team_config_t *config,
+                                          long config_mask, shmem_team_t *new_team);
+extern int mca_spml_sm_team_split_2d(shmem_team_t parent_team, int xrange,
+                                     const shmem_team_config_t *xaxis_config,
+                                     long xaxis_mask, shmem_team_t *xaxis_team,
+                                     const shmem_team_config_t *yaxis_config,
+                                     long yaxis_mask, shmem_team_t *yaxis_team);
+extern int mca_spml_sm_team_destroy(shmem_team_t team);
+extern int mca_spml_sm_team_get(shmem_ctx_t ctx, shmem_team_t *team);
+extern int mca_spml_sm_team_create_ctx(shmem_team_t team, long options, shmem_ctx_t *ctx);
+extern int mca_spml_sm_team_alltoall(shmem_team_t team, void *dest,
+                                     const void *source, size_t nelems, int datatype);
+extern int mca_spml_sm_team_alltoalls(shmem_team_t team, void *dest,
+                                      const void *source, ptrdiff_t dst, ptrdiff_t sst,
+                                      size_t nelems, int datatype);
+extern int mca_spml_sm_team_broadcast(shmem_team_t team, void *dest,
+                                      const void *source, size_t nelems,
+                                      int PE_root, int datatype);
+extern int mca_spml_sm_team_collect(shmem_team_t team, void *dest,
+                                    const void *source, size_t nelems, int datatype);
+extern int mca_spml_sm_team_fcollect(shmem_team_t team, void *dest,
+                                     const void *source, size_t nelems, int datatype);
+extern int mca_spml_sm_team_reduce(shmem_team_t team, void *dest,
+                                   const void *source, size_t nreduce,
+                                   int operation, int datatype);
+
+/**
+ * Translate the symmetric address va of pe into an address that can be
+ * accessed with loads and stores by this process. Returns NULL if the
+ * segment of pe is not mapped (e.g. smsc/cma is used).
+ */
+static inline void *mca_spml_sm_local_ptr(shmem_ctx_t ctx, int pe, const void *va)
+{
+    sshmem_mkey_t *mkey;
+    mca_spml_sm_mkey_t *sm_mkey;
+    void *rva;
+
+    mkey = mca_memheap_base_get_cached_mkey(ctx, pe, (void *) va,
+                                            SPML_SM_TRANSP_IDX, &rva);
+    if (OPAL_UNLIKELY(NULL == mkey)) {
+        return NULL;
+    }
+
+    if (pe == oshmem_my_proc_id()) {
+        return rva;
+    }
+
+    sm_mkey = (mca_spml_sm_mkey_t *) mkey->spml_context;
+    if (OPAL_UNLIKELY(NULL == sm_mkey || NULL == sm_mkey->local_base)) {
+        return NULL;
+    }
+
+    return (char *) sm_mkey->local_base +
+           ((uintptr_t) va - (uintptr_t) sm_mkey->super.super.va_base);
+}
+
+END_C_DECLS
+
+#endif
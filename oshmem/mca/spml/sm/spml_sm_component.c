@@ -0,0 +1,123 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+#include "shmem.h"
+#include "oshmem/mca/spml/spml.h"
+#include "oshmem/mca/spml/base/base.h"
+#include "spml_sm_component.h"
+#include "oshmem/mca/spml/sm/spml_sm.h"
+
+#include "opal/util/proc.h"
+#include "opal/mca/smsc/smsc.h"
+
+static int mca_spml_sm_component_register(void);
+static int mca_spml_sm_component_open(void);
+static int mca_spml_sm_component_close(void);
+static mca_spml_base_module_t*
+mca_spml_sm_component_init(int* priority,
+                           bool enable_progress_threads,
+                           bool enable_mpi_threads);
+static int mca_spml_sm_component_fini(void);
+mca_spml_base_component_2_0_0_t mca_spml_sm_component = {
+
+    /* First, the mca_base_component_t struct containing meta
+       information about the component itself */
+
+    .spmlm_version = {
+        MCA_SPML_BASE_VERSION_2_0_0,
+
+        .mca_component_name            = "sm",
+        .mca_component_major_version   = OSHMEM_MAJOR_VERSION,
+        .mca_component_minor_version   = OSHMEM_MINOR_VERSION,
+        .mca_component_release_version = OSHMEM_RELEASE_VERSION,
+        .mca_open_component            = mca_spml_sm_component_open,
+        .mca_close_component           = mca_spml_sm_component_close,
+        .mca_query_component           = NULL,
+        .mca_register_component_params = mca_spml_sm_component_register
+    },
+    .spmlm_data = {
+        /* The component is checkpoint ready */
+        .param_field                   = MCA_BASE_METADATA_PARAM_CHECKPOINT
+    },
+
+    .spmlm_init                        = mca_spml_sm_component_init,
+    .spmlm_finalize                    = mca_spml_sm_component_fini
+};
+MCA_BASE_COMPONENT_INIT(oshmem, spml, sm)
+
+static int mca_spml_sm_component_register(void)
+{
+    /* below ucx, so that ucx stays the default where it is available */
+    mca_spml_sm.priority = 10;
+    (void) mca_base_component_var_register(&mca_spml_sm_component.spmlm_version,
+                                           "priority",
+                                           "[integer] sm priority",
+                                           MCA_BASE_VAR_TYPE_INT, NULL, 0, 0,
+                                           OPAL_INFO_LVL_9,
+                                           MCA_BASE_VAR_SCOPE_READONLY,
+                                           &mca_spml_sm.priority);
+
+    return OSHMEM_SUCCESS;
+}
+
+static int mca_spml_sm_component_open(void)
+{
+    return OSHMEM_SUCCESS;
+}
+
+static int mca_spml_sm_component_close(void)
+{
+    return OSHMEM_SUCCESS;
+}
+
+static mca_spml_base_module_t*
+mca_spml_sm_component_init(int* priority,
+                           bool enable_progress_threads,
+                           bool enable_mpi_threads)
+{
+    SPML_VERBOSE(10, "in sm, my priority is %d\n", mca_spml_sm.priority);
+
+    if ((*priority) > mca_spml_sm.priority) {
+        *priority = mca_spml_sm.priority;
+        return NULL;
+    }
+
+    /* all PEs have to share the node */
+    if (opal_process_info.num_local_peers + 1 < opal_process_info.num_procs) {
+        SPML_VERBOSE(5, "sm: job spans more than one node");
+        return NULL;
+    }
+
+    /* the symmetric heap is private memory, it can only be reached through
+     * a single-copy mechanism that does not need a registration step */
+    if (NULL == mca_smsc ||
+        mca_smsc_base_has_feature(MCA_SMSC_FEATURE_REQUIRE_REGISTRATION)) {
+        SPML_VERBOSE(5, "sm: no usable single-copy mechanism");
+        return NULL;
+    }
+
+    *priority = mca_spml_sm.priority;
+
+    mca_spml_sm.can_map = mca_smsc_base_has_feature(MCA_SMSC_FEATURE_CAN_MAP);
+    oshmem_ctx_default = (shmem_ctx_t) &mca_spml_sm_ctx_default;
+
+    SPML_VERBOSE(50, "*** sm initialized (map: %d) ****", (int) mca_spml_sm.can_map);
+
+    return &mca_spml_sm.super;
+}
+
+static int mca_spml_sm_component_fini(void)
+{
+    if (!mca_spml_sm.enabled) {
+        return OSHMEM_SUCCESS; /* never selected.. return success.. */
+    }
+
+    mca_spml_sm.enabled = false;
+    return OSHMEM_SUCCESS;
+}
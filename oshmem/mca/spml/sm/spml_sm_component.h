@@ -0,0 +1,23 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+/**
+ *  @file
+ */
+
+#ifndef MCA_SPML_SM_COMPONENT_H
+#define MCA_SPML_SM_COMPONENT_H
+
+BEGIN_C_DECLS
+
+/*
+ * SPML module functions.
+ */
+OSHMEM_DECLSPEC extern mca_spml_base_component_2_0_0_t mca_spml_sm_component;
+END_C_DECLS
+
+#endif
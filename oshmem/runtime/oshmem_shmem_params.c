@@ -20,6 +20,9 @@
 int oshmem_shmem_lock_recursive   = 0;
 int oshmem_shmem_api_verbose      = 0;
 int oshmem_shmem_enable_mcs_locks = 1;
+int oshmem_shmem_lock_cohort      = 0;
+int oshmem_shmem_lock_cohort_handoffs = 64;
+int oshmem_shmem_lock_cohort_slots = 1024;
 int oshmem_preconnect_all         = 0;
 
 int oshmem_shmem_register_params(void)
@@ -52,6 +55,49 @@ int oshmem_shmem_register_params(void)
                                  MCA_BASE_VAR_SCOPE_READONLY,
                                  &oshmem_shmem_enable_mcs_locks);
 
+    (void) mca_base_var_register("oshmem",
+                                 "oshmem",
+                                 NULL,
+                                 "lock_cohort",
+                                 "Use node-aware cohort locks: the PEs of a node queue locally "
+                                 "and pass the lock among themselves, only one PE per node waits "
+                                 "for the MCS lock (default = no)",
+                                 MCA_BASE_VAR_TYPE_INT,
+                                 NULL,
+                                 0,
+                                 MCA_BASE_VAR_FLAG_SETTABLE,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &oshmem_shmem_lock_cohort);
+
+    (void) mca_base_var_register("oshmem",
+                                 "oshmem",
+                                 NULL,
+                                 "lock_cohort_max_handoffs",
+                                 "Number of times a cohort lock is passed between the PEs of a node "
+                                 "before it is released to the other nodes (default = 64)",
+                                 MCA_BASE_VAR_TYPE_INT,
+                                 NULL,
+                                 0,
+                                 MCA_BASE_VAR_FLAG_SETTABLE,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &oshmem_shmem_lock_cohort_handoffs);
+
+    (void) mca_base_var_register("oshmem",
+                                 "oshmem",
+                                 NULL,
+                                 "lock_cohort_slots",
+                                 "Number of locks per node that can use the cohort lock, "
+                                 "further locks use the MCS lock (default = 1024)",
+                                 MCA_BASE_VAR_TYPE_INT,
+                                 NULL,
+                                 0,
+                                 MCA_BASE_VAR_FLAG_SETTABLE,
+                                 OPAL_INFO_LVL_9,
+                                 MCA_BASE_VAR_SCOPE_READONLY,
+                                 &oshmem_shmem_lock_cohort_slots);
+
     (void) mca_base_var_register("oshmem",
                                  "oshmem",
                                  NULL,
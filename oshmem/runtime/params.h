@@ -44,6 +44,15 @@ OSHMEM_DECLSPEC extern int oshmem_preconnect_all;
  */
 OSHMEM_DECLSPEC extern int oshmem_shmem_enable_mcs_locks;
 
+/**
+ * Whether to use node-aware cohort locks for shmem_locks,
+ * how often a cohort passes the lock locally before releasing it
+ * and how many locks per node can be cohort locks
+ */
+OSHMEM_DECLSPEC extern int oshmem_shmem_lock_cohort;
+OSHMEM_DECLSPEC extern int oshmem_shmem_lock_cohort_handoffs;
+OSHMEM_DECLSPEC extern int oshmem_shmem_lock_cohort_slots;
+
 END_C_DECLS
 
 #endif /* OSHMEM_RUNTIME_PARAMS_H */
@@ -30,7 +30,10 @@
 
 void shmem_clear_lock(volatile long *lock)
 {
-    if (oshmem_shmem_enable_mcs_locks) {
+    if (oshmem_shmem_lock_cohort) {
+        SHMEM_API_VERBOSE(10, "Clear Lock with Cohort Lock implementation");
+        _shmem_cohort_clear_lock((long *)lock);
+    } else if (oshmem_shmem_enable_mcs_locks) {
         SHMEM_API_VERBOSE(10, "Clear Lock with MCS Lock implementation");
         _shmem_mcs_clear_lock((long *)lock);
     } else {
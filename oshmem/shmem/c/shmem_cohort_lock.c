@@ -0,0 +1,409 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "oshmem_config.h"
+
+#include "oshmem/constants.h"
+#include "oshmem/include/shmem.h"
+#include "oshmem/runtime/params.h"
+#include "oshmem/runtime/runtime.h"
+#include <stdlib.h>
+#include <memory.h>
+
+#include "opal/class/opal_hash_table.h"
+
+#include "oshmem/shmem/shmem_api_logger.h"
+#include "oshmem/shmem/shmem_lock.h"
+#include "oshmem/proc/proc.h"
+#include "oshmem/mca/memheap/memheap.h"
+#include "oshmem/mca/memheap/base/base.h"
+#include "oshmem/mca/atomic/atomic.h"
+
+/**
+ * Cohort lock: the PEs of a node queue for a lock in a local MCS queue
+ * and pass the lock to each other up to oshmem_shmem_lock_cohort_handoffs
+ * times in a row. Only the head of the local queue takes the MCS lock
+ * stored in the user's lock word, so the lock moves between nodes once
+ * per cohort instead of once per critical section.
+ *
+ * The user's lock word is fully used by the MCS lock, the local queue
+ * lives in a table of slots in the private heap. A lock is assigned the
+ * same slot on all PEs of a node: the node leader (its lowest PE) holds
+ * the lock address and the local queue tail of the slot, every PE holds
+ * its successor and the handoff word. Locks that do not find a slot on
+ * their node use the plain MCS lock, which stays compatible with the
+ * cohorts of the other nodes.
+ */
+struct shmem_cohort_slot {
+    /** Lock the slot belongs to, has meaning only on the node leader */
+    uint64_t lock;
+    /** Written by the local predecessor on handoff, see below */
+    uint64_t grant;
+    /** Local queue tail as local rank + 1, only on the node leader */
+    int tail;
+    /** Local successor as local rank + 1, 0 if none */
+    int next;
+    /** PE whose MCS node holds the global lock for the cohort */
+    int holder;
+    /** Local handoffs since the cohort took the global lock */
+    int handoffs;
+};
+typedef struct shmem_cohort_slot shmem_cohort_slot_t;
+
+/** Predecessor did not release the lock yet */
+#define SHMEM_COHORT_GRANT_WAIT         0
+/** Local lock passed, the global lock has to be taken */
+#define SHMEM_COHORT_GRANT_GLOBAL       1
+/** Local and global lock passed, the global lock is held by holder */
+#define SHMEM_COHORT_GRANT(holder, n)   (((uint64_t)(n) << 32) | ((uint64_t)(holder) + 2))
+#define SHMEM_COHORT_GRANT_HOLDER(g)    ((int)((g) & 0xFFFFFFFFU) - 2)
+#define SHMEM_COHORT_GRANT_HANDOFFS(g)  ((int)((g) >> 32))
+
+/** Cached lookup result of a lock without a slot */
+#define SHMEM_COHORT_NO_SLOT            ((void *) -1)
+
+static shmem_cohort_slot_t *cohort_slots;
+static opal_hash_table_t cohort_slot_cache;
+static int *cohort_local_pes;
+static int cohort_local_size;
+static int cohort_local_rank;
+
+int shmem_cohort_lock_init(void)
+{
+    size_t size = oshmem_shmem_lock_cohort_slots * sizeof(shmem_cohort_slot_t);
+    void *ptr = NULL;
+    int pe;
+
+    if (0 >= oshmem_shmem_lock_cohort_slots) {
+        SHMEM_API_ERROR("lock_cohort_slots has to be positive");
+        return OSHMEM_ERROR;
+    }
+
+    cohort_local_pes = malloc(shmem_n_pes() * sizeof(*cohort_local_pes));
+    if (NULL == cohort_local_pes) {
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+
+    cohort_local_size = 0;
+    for (pe = 0; pe < shmem_n_pes(); pe++) {
+        if (pe == shmem_my_pe()) {
+            cohort_local_rank = cohort_local_size;
+        }
+        if (pe == shmem_my_pe() || oshmem_proc_on_local_node(pe)) {
+            cohort_local_pes[cohort_local_size++] = pe;
+        }
+    }
+
+    /* the private heap has to stay symmetric, allocate on all PEs even if
+     * this node has nobody to share the lock with */
+    MCA_MEMHEAP_CALL(private_alloc(size, &ptr));
+    if (NULL == ptr) {
+        free(cohort_local_pes);
+        cohort_local_pes = NULL;
+        return OSHMEM_ERR_OUT_OF_RESOURCE;
+    }
+    cohort_slots = (shmem_cohort_slot_t *) ptr;
+    memset(cohort_slots, 0, size);
+
+    OBJ_CONSTRUCT(&cohort_slot_cache, opal_hash_table_t);
+    if (OPAL_SUCCESS != opal_hash_table_init(&cohort_slot_cache,
+                                             oshmem_shmem_lock_cohort_slots)) {
+        return OSHMEM_ERROR;
+    }
+
+    SHMEM_API_VERBOSE(5, "cohort locks: %d local PEs, leader PE %d, %d slots",
+                      cohort_local_size, cohort_local_pes[0],
+                      oshmem_shmem_lock_cohort_slots);
+    return OSHMEM_SUCCESS;
+}
+
+void shmem_cohort_lock_finalize(void)
+{
+    if (NULL == cohort_slots) {
+        return;
+    }
+
+    MCA_MEMHEAP_CALL(private_free(cohort_slots));
+    OBJ_DESTRUCT(&cohort_slot_cache);
+    free(cohort_local_pes);
+
+    cohort_slots = NULL;
+    cohort_local_pes = NULL;
+}
+
+/**
+ * Find the slot of a lock, claiming a free one on the node leader on first
+ * use. Slots are never given back, so all PEs of a node agree on the slot
+ * of a lock or on the lack of one. Returns NULL if the lock has to use the
+ * plain MCS lock.
+ */
+static shmem_cohort_slot_t *shmem_cohort_slot(long *lockp)
+{
+    uint64_t key = (uint64_t) (uintptr_t) lockp;
+    int leader = cohort_local_pes[0];
+    shmem_cohort_slot_t *slot;
+    uint64_t prev;
+    void *value;
+    int first;
+    int retv;
+    int i;
+
+    if (1 >= cohort_local_size) {
+        return NULL;
+    }
+
+    if (OPAL_SUCCESS == opal_hash_table_get_value_uint64(&cohort_slot_cache,
+                                                         key, &value)) {
+        return (SHMEM_COHORT_NO_SLOT == value) ? NULL : value;
+    }
+
+    value = SHMEM_COHORT_NO_SLOT;
+    first = ((uintptr_t) lockp / sizeof(long)) % oshmem_shmem_lock_cohort_slots;
+    for (i = 0; i < oshmem_shmem_lock_cohort_slots; i++) {
+        slot = &cohort_slots[(first + i) % oshmem_shmem_lock_cohort_slots];
+        prev = 0;
+        retv = MCA_ATOMIC_CALL(cswap(oshmem_ctx_default, (void *)&slot->lock,
+                                     &prev, 0, key, sizeof(uint64_t), leader));
+        RUNTIME_CHECK_RC(retv);
+        if ((0 == prev) || (key == prev)) {
+            value = slot;
+            break;
+        }
+    }
+
+    if (SHMEM_COHORT_NO_SLOT == value) {
+        SHMEM_API_VERBOSE(5, "no cohort slot left for lock %p, using MCS lock",
+                          (void *)lockp);
+    }
+
+    opal_hash_table_set_value_uint64(&cohort_slot_cache, key, value);
+    return (SHMEM_COHORT_NO_SLOT == value) ? NULL : value;
+}
+
+/** Wait until the local successor linked itself behind us */
+static int shmem_cohort_wait_next(shmem_cohort_slot_t *slot)
+{
+    int my_pe = shmem_my_pe();
+    int next  = 0;
+    int zero  = 0;
+    int retv;
+
+    retv = MCA_ATOMIC_CALL(fadd(oshmem_ctx_default, (void *)&slot->next,
+                                (void *)&next, 0, sizeof(int), my_pe));
+    RUNTIME_CHECK_RC(retv);
+
+    while (0 == next) {
+        retv = MCA_SPML_CALL(wait((void *)&slot->next, SHMEM_CMP_NE,
+                                  (void *)&zero, SHMEM_INT));
+        RUNTIME_CHECK_RC(retv);
+        retv = MCA_ATOMIC_CALL(fadd(oshmem_ctx_default, (void *)&slot->next,
+                                    (void *)&next, 0, sizeof(int), my_pe));
+        RUNTIME_CHECK_RC(retv);
+    }
+
+    return next;
+}
+
+/** Pass the local lock to the local successor */
+static void shmem_cohort_grant(shmem_cohort_slot_t *slot, int next,
+                               uint64_t grant)
+{
+    uint64_t prev = 0;
+    int retv;
+
+    /* the puts of the critical section complete before the successor
+     * may enter it */
+    MCA_SPML_CALL(quiet(oshmem_ctx_default));
+    retv = MCA_ATOMIC_CALL(swap(oshmem_ctx_default, (void *)&slot->grant,
+                                (void *)&prev, grant, sizeof(uint64_t),
+                                cohort_local_pes[next - 1]));
+    RUNTIME_CHECK_RC(retv);
+}
+
+/**
+ * Give up the local lock while the cohort does not hold the global lock,
+ * a successor has to take the global lock itself.
+ */
+static void shmem_cohort_release_local(shmem_cohort_slot_t *slot)
+{
+    int leader = cohort_local_pes[0];
+    int prev   = 0;
+    int me     = cohort_local_rank + 1;
+    int retv;
+
+    retv = MCA_ATOMIC_CALL(cswap(oshmem_ctx_default, (void *)&slot->tail,
+                                 (uint64_t *)&prev, me, 0, sizeof(int), leader));
+    RUNTIME_CHECK_RC(retv);
+    if (prev == me) {
+        return;
+    }
+
+    shmem_cohort_grant(slot, shmem_cohort_wait_next(slot),
+                       SHMEM_COHORT_GRANT_GLOBAL);
+}
+
+/** Reset our queue node and append it to the local queue */
+static int shmem_cohort_enqueue(shmem_cohort_slot_t *slot, int *prev_tail,
+                                int try_only)
+{
+    int leader = cohort_local_pes[0];
+    int my_pe  = shmem_my_pe();
+    int me     = cohort_local_rank + 1;
+    uint64_t grant_prev = 0;
+    int next_prev = 0;
+    int retv;
+
+    retv = MCA_ATOMIC_CALL(swap(oshmem_ctx_default, (void *)&slot->next,
+                                (void *)&next_prev, 0, sizeof(int), my_pe));
+    RUNTIME_CHECK_RC(retv);
+    retv = MCA_ATOMIC_CALL(swap(oshmem_ctx_default, (void *)&slot->grant,
+                                (void *)&grant_prev, SHMEM_COHORT_GRANT_WAIT,
+                                sizeof(uint64_t), my_pe));
+    RUNTIME_CHECK_RC(retv);
+    MCA_SPML_CALL(quiet(oshmem_ctx_default));
+
+    *prev_tail = 0;
+    if (try_only) {
+        retv = MCA_ATOMIC_CALL(cswap(oshmem_ctx_default, (void *)&slot->tail,
+                                     (uint64_t *)prev_tail, 0, me, sizeof(int), leader));
+    } else {
+        retv = MCA_ATOMIC_CALL(swap(oshmem_ctx_default, (void *)&slot->tail,
+                                    (void *)prev_tail, me, sizeof(int), leader));
+    }
+
+    return retv;
+}
+
+void
+_shmem_cohort_set_lock(long *lockp)
+{
+    shmem_cohort_slot_t *slot;
+    int prev_tail      = 0;
+    uint64_t wait_val  = SHMEM_COHORT_GRANT_WAIT;
+    uint64_t grant     = SHMEM_COHORT_GRANT_WAIT;
+    int next_prev      = 0;
+    int my_pe          = shmem_my_pe();
+    int retv           = 0;
+
+    RUNTIME_CHECK_INIT();
+
+    slot = shmem_cohort_slot(lockp);
+    if (NULL == slot) {
+        _shmem_mcs_set_lock(lockp);
+        return;
+    }
+
+    retv = shmem_cohort_enqueue(slot, &prev_tail, 0);
+    RUNTIME_CHECK_RC(retv);
+
+    if (0 != prev_tail) {
+        /** Link behind the local predecessor and wait for the handoff */
+        retv = MCA_ATOMIC_CALL(swap(oshmem_ctx_default, (void *)&slot->next,
+                                    (void *)&next_prev, cohort_local_rank + 1,
+                                    sizeof(int),
+                                    cohort_local_pes[prev_tail - 1]));
+        RUNTIME_CHECK_RC(retv);
+        MCA_SPML_CALL(quiet(oshmem_ctx_default));
+
+        retv = MCA_ATOMIC_CALL(fadd(oshmem_ctx_default, (void *)&slot->grant,
+                                    (void *)&grant, 0, sizeof(uint64_t),
+                                    my_pe));
+        RUNTIME_CHECK_RC(retv);
+        while (SHMEM_COHORT_GRANT_WAIT == grant) {
+            retv = MCA_SPML_CALL(wait((void *)&slot->grant, SHMEM_CMP_NE,
+                                      (void *)&wait_val, SHMEM_UINT64_T));
+            RUNTIME_CHECK_RC(retv);
+            retv = MCA_ATOMIC_CALL(fadd(oshmem_ctx_default, (void *)&slot->grant,
+                                        (void *)&grant, 0, sizeof(uint64_t),
+                                        my_pe));
+            RUNTIME_CHECK_RC(retv);
+        }
+
+        if (SHMEM_COHORT_GRANT_GLOBAL != grant) {
+            /** The cohort keeps the global lock */
+            slot->holder   = SHMEM_COHORT_GRANT_HOLDER(grant);
+            slot->handoffs = SHMEM_COHORT_GRANT_HANDOFFS(grant);
+            return;
+        }
+    }
+
+    /** Head of the local queue: the cohort joins the global queue */
+    _shmem_mcs_set_lock(lockp);
+    slot->holder   = my_pe;
+    slot->handoffs = 0;
+}
+
+void
+_shmem_cohort_clear_lock(long *lockp)
+{
+    shmem_cohort_slot_t *slot;
+    int next_value = 0;
+    int retv       = 0;
+
+    slot = shmem_cohort_slot(lockp);
+    if (NULL == slot) {
+        _shmem_mcs_clear_lock(lockp);
+        return;
+    }
+
+    retv = MCA_ATOMIC_CALL(fadd(oshmem_ctx_default, (void *)&slot->next,
+                                (void *)&next_value, 0, sizeof(int),
+                                shmem_my_pe()));
+    RUNTIME_CHECK_RC(retv);
+
+    if ((0 != next_value) &&
+        (slot->handoffs < oshmem_shmem_lock_cohort_handoffs)) {
+        /** Pass both locks to the local successor */
+        shmem_cohort_grant(slot, next_value,
+                           SHMEM_COHORT_GRANT(slot->holder, slot->handoffs + 1));
+        return;
+    }
+
+    /**
+     * No local waiter or the fairness bound is reached. The global lock
+     * is released first: once the local lock is free, the PE whose MCS
+     * node is in use may take the global lock again.
+     */
+    _shmem_mcs_clear_lock_pe(lockp, slot->holder);
+
+    if (0 != next_value) {
+        shmem_cohort_grant(slot, next_value, SHMEM_COHORT_GRANT_GLOBAL);
+    } else {
+        shmem_cohort_release_local(slot);
+    }
+}
+
+int
+_shmem_cohort_test_lock(long *lockp)
+{
+    shmem_cohort_slot_t *slot;
+    int prev_tail      = 0;
+    int retv           = 0;
+
+    slot = shmem_cohort_slot(lockp);
+    if (NULL == slot) {
+        return _shmem_mcs_test_lock(lockp);
+    }
+
+    retv = shmem_cohort_enqueue(slot, &prev_tail, 1);
+    RUNTIME_CHECK_RC(retv);
+    if (0 != prev_tail) {
+        /** Another PE of the node holds or waits for the lock */
+        return 1;
+    }
+
+    if (0 != _shmem_mcs_test_lock(lockp)) {
+        /** Another node holds the lock */
+        shmem_cohort_release_local(slot);
+        return 1;
+    }
+
+    slot->holder   = shmem_my_pe();
+    slot->handoffs = 0;
+    return 0;
+}
@@ -128,6 +128,10 @@ int shmem_lock_init()
     lock_counter_head = 0;
     lock_prev_pe_container_head = 0;
 
+    if (oshmem_shmem_lock_cohort) {
+        return shmem_cohort_lock_init();
+    }
+
     return OSHMEM_SUCCESS;
 }
 
@@ -137,6 +141,8 @@ int shmem_lock_finalize()
     oshmem_lock_prev_pe_container_t *current_pe_container =
             lock_prev_pe_container_head;
 
+    shmem_cohort_lock_finalize();
+
     if (0 != lock_turn) {
         MCA_MEMHEAP_CALL(private_free(lock_turn));
     }
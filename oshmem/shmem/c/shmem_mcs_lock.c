@@ -142,12 +142,23 @@ _shmem_mcs_set_lock(long *lockp)
 
 void
 _shmem_mcs_clear_lock(long *lockp)
+{
+    _shmem_mcs_clear_lock_pe(lockp, shmem_my_pe());
+}
+
+/**
+ * Release the lock acquired by PE holder. The cohort lock releases the
+ * global lock from whichever PE of the node holds it last, through the
+ * MCS node of the PE that acquired it.
+ */
+void
+_shmem_mcs_clear_lock_pe(long *lockp, int holder)
 {
     shmem_mcs_lock_t *lock = (shmem_mcs_lock_t *) lockp;
     int mcs_tail_owner     = SHMEM_MCSL_TAIL_OWNER(lock);
     int *tail              = &(lock->tail);
     int *next              = &(lock->next);
-    int my_pe              = shmem_my_pe();
+    int my_pe              = holder;
     int next_value         = 0;
     int swap_cond          = 0;
     int prev_value         = 0;
@@ -188,9 +199,12 @@ _shmem_mcs_clear_lock(long *lockp)
          */
         nmask = SHMEM_MCSL_NEXT_MASK;
         while(next_value == nmask) {
-            retv = MCA_SPML_CALL(wait((void*)next, SHMEM_CMP_NE,
-                                      (void*)&nmask, SHMEM_INT));
-            RUNTIME_CHECK_RC(retv);
+            /** Only our own next pointer can be waited on, poll otherwise */
+            if (my_pe == shmem_my_pe()) {
+                retv = MCA_SPML_CALL(wait((void*)next, SHMEM_CMP_NE,
+                                          (void*)&nmask, SHMEM_INT));
+                RUNTIME_CHECK_RC(retv);
+            }
             retv = MCA_ATOMIC_CALL(fadd(oshmem_ctx_default, (void*)next,
                                         (void*)&next_value, tval,
                                         sizeof(int), my_pe));
@@ -31,7 +31,10 @@
 
 int shmem_test_lock(volatile long *lock)
 {
-    if (oshmem_shmem_enable_mcs_locks) {
+    if (oshmem_shmem_lock_cohort) {
+        SHMEM_API_VERBOSE(10, "Test lock using Cohort Lock implementation");
+        return _shmem_cohort_test_lock((long *)lock);
+    } else if (oshmem_shmem_enable_mcs_locks) {
         SHMEM_API_VERBOSE(10, "Test lock using MCS Lock implementation");
         return _shmem_mcs_test_lock((long *)lock);
     } else {
@@ -24,6 +24,13 @@ void _shmem_clear_lock(void *lock, int lock_size);
 
 void _shmem_mcs_set_lock(long *lock);
 void _shmem_mcs_clear_lock(long *lock);
+void _shmem_mcs_clear_lock_pe(long *lock, int holder);
 int  _shmem_mcs_test_lock(long *lock);
 
+int  shmem_cohort_lock_init(void);
+void shmem_cohort_lock_finalize(void);
+void _shmem_cohort_set_lock(long *lock);
+void _shmem_cohort_clear_lock(long *lock);
+int  _shmem_cohort_test_lock(long *lock);
+
 #endif /*SHMEM_LOCK_H*/
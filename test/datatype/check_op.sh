@@ -2,7 +2,7 @@
 
 set -u
 
-echo "ompi version with AVX512 -- Usage: arg1: count of elements, args2: 'i'|'u'|'f'|'d' : datatype: signed, unsigned, float, double. args3 size of type. args4 operation"
+echo "ompi version with AVX512 -- Usage: arg1: count of elements, args2: 'i'|'u'|'f'|'d'|'h'|'p'|'q' : datatype: signed, unsigned, float, double, short float, integer pairs, floating point pairs. args3 size of type. args4 operation"
 mpirun="mpirun --mca pml ob1 --mca btl vader,self"
 # For SVE-architecture
 # echo "$mpirun -mca op_sve_hardware_available 0 -mca op_avx_hardware_available 0 -n 1 Reduce_local_float 1048576  i 8 max"
@@ -79,3 +79,29 @@ for op in max min sum prod; do
     done
 done
 
+
+echo "========Short float type max, min and sum========="
+echo ""
+for op in max min sum; do
+    for size in 1024 127 130; do
+        foo=$((1024 * 1024 + $size))
+        echo -e "Test $Yellow __mm512 instruction for loop $NC Total_num_bits = $foo * 16"
+        cmd="$mpirun -n 1 reduce_local -l $foo -u $foo -t h -s 16 -o $op"
+        if test $verbose -eq 1 ; then echo $cmd; fi
+        eval $cmd
+    done
+done
+
+echo "========Pair types maxloc and minloc========="
+echo ""
+for op in maxloc minloc; do
+    for type_size in 16 32 64; do
+        for size in 1024 127 130; do
+            foo=$((1024 * 1024 + $size))
+            echo -e "Test $Yellow __mm512 instruction for loop $NC Total_num_bits = $foo * 2 * $type_size"
+            cmd="$mpirun -n 1 reduce_local -l $foo -u $foo -t pq -s $type_size -o $op"
+            if test $verbose -eq 1 ; then echo $cmd; fi
+            eval $cmd
+        done
+    done
+done
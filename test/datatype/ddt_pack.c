@@ -27,13 +27,19 @@
 #include "ompi/datatype/ompi_datatype.h"
 #include "ompi/proc/proc.h"
 #include "opal/datatype/opal_convertor.h"
+#include "opal/datatype/opal_datatype_internal.h"
 #include "opal/runtime/opal.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include <poll.h>
 
+#define PLAN_ITERATIONS 50
+/* not a multiple of the predefined types, to split them between fragments */
+#define PLAN_FRAGMENT 8191
+
 static int get_extents(ompi_datatype_t *type, ptrdiff_t *lb, ptrdiff_t *extent, ptrdiff_t *true_lb,
                        ptrdiff_t *true_extent)
 {
@@ -49,6 +55,72 @@ static int get_extents(ompi_datatype_t *type, ptrdiff_t *lb, ptrdiff_t *extent,
     return 0;
 }
 
+/* Pack and unpack count elements of type through fragments of PLAN_FRAGMENT
+ * bytes, check the result against ompi_datatype_copy_content_same_ddt and
+ * return the time of PLAN_ITERATIONS round trips.
+ */
+static int pack_unpack(ompi_datatype_t *type, int count, long *usec)
+{
+    ptrdiff_t lb, extent, true_lb, true_extent;
+    size_t length, max_data, position;
+    char *src, *dst, *ref, *packed;
+    opal_convertor_t *convertor;
+    struct timeval start, end;
+    struct iovec iov;
+    uint32_t iov_count;
+    int ret, i;
+
+    ret = get_extents(type, &lb, &extent, &true_lb, &true_extent);
+    if (ret != 0)
+        return ret;
+    length = true_extent + (count - 1) * extent;
+    src = malloc(length);
+    dst = calloc(1, length);
+    ref = calloc(1, length);
+    packed = malloc(count * type->super.size);
+    for (size_t j = 0; j < length; j++) {
+        src[j] = (char) j;
+    }
+
+    ompi_datatype_copy_content_same_ddt(type, count, ref - true_lb, src - true_lb);
+
+    convertor = opal_convertor_create(opal_local_arch, 0);
+    gettimeofday(&start, NULL);
+    for (i = 0; i < PLAN_ITERATIONS; i++) {
+        opal_convertor_cleanup(convertor);
+        opal_convertor_prepare_for_send(convertor, &type->super, count, src - true_lb);
+        position = 0;
+        do {
+            iov.iov_base = packed + position;
+            iov.iov_len = PLAN_FRAGMENT;
+            iov_count = 1;
+            ret = opal_convertor_pack(convertor, &iov, &iov_count, &max_data);
+            position += max_data;
+        } while (0 == ret);
+
+        opal_convertor_cleanup(convertor);
+        opal_convertor_prepare_for_recv(convertor, &type->super, count, dst - true_lb);
+        position = 0;
+        do {
+            iov.iov_base = packed + position;
+            iov.iov_len = PLAN_FRAGMENT;
+            iov_count = 1;
+            ret = opal_convertor_unpack(convertor, &iov, &iov_count, &max_data);
+            position += max_data;
+        } while (0 == ret);
+    }
+    gettimeofday(&end, NULL);
+    OBJ_RELEASE(convertor);
+    *usec = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec);
+
+    ret = memcmp(dst, ref, length) ? 1 : 0;
+    free(src);
+    free(dst);
+    free(ref);
+    free(packed);
+    return ret;
+}
+
 int main(int argc, char *argv[])
 {
     size_t packed_ddt_len;
@@ -499,6 +571,40 @@ int main(int argc, char *argv[])
     }
     ompi_datatype_destroy(&dup_type);
 
+    /**
+     *
+     *                 TEST 8
+     *
+     */
+    printf("---> Pack/unpack of vector and subarray with and without compiled plans\n");
+    {
+        int sizes[3] = {64, 64, 64}, subsizes[3] = {62, 62, 62}, starts[3] = {1, 1, 1};
+        unsigned int max_runs = opal_datatype_plan_max_runs;
+        ompi_datatype_t *plan_types[2];
+        long usec[2];
+
+        for (int with_plans = 1; with_plans >= 0; with_plans--) {
+            /* the plans are built when the datatypes are committed */
+            opal_datatype_plan_max_runs = with_plans ? max_runs : 0;
+            ompi_datatype_create_vector(4096, 3, 8, &ompi_mpi_double.dt, &plan_types[0]);
+            ompi_datatype_create_subarray(3, sizes, subsizes, starts, MPI_ORDER_C,
+                                          &ompi_mpi_double.dt, &plan_types[1]);
+            for (int j = 0; j < 2; j++) {
+                ompi_datatype_commit(&plan_types[j]);
+                ret = pack_unpack(plan_types[j], 2, &usec[j]);
+                if (ret != 0) {
+                    printf("\tFAILED: unpacked data doesn't match\n");
+                    goto cleanup;
+                }
+                ompi_datatype_destroy(&plan_types[j]);
+            }
+            printf("\t%s plans: vector %ld usec, subarray %ld usec\n",
+                   with_plans ? "with" : "without", usec[0], usec[1]);
+        }
+        opal_datatype_plan_max_runs = max_runs;
+        printf("\tPASSED\n");
+    }
+
 cleanup:
     opal_finalize_util();
 
@@ -34,6 +34,17 @@
 #include "ompi/datatype/ompi_datatype.h"
 #include "ompi/runtime/mpiruntime.h"
 
+#if defined(HAVE_SHORT_FLOAT) || defined(HAVE_OPAL_SHORT_FLOAT_T)
+#    define HAVE_TEST_SHORT_FLOAT 1
+#    if defined(HAVE_SHORT_FLOAT)
+typedef short float test_short_float_t;
+#    else
+typedef opal_short_float_t test_short_float_t;
+#    endif
+/* MPIX_SHORT_FLOAT is only exposed through the shortfloat extension */
+OMPI_DECLSPEC extern struct ompi_predefined_datatype_t ompi_mpi_short_float;
+#endif
+
 typedef struct op_name_s {
     char *name;
     char *mpi_op_name;
@@ -50,10 +61,12 @@ static op_name_t array_of_ops[] = {
     {"bor", "MPI_BOR", MPI_BOR},
     {"lxor", "MPI_LXOR", MPI_LXOR},
     {"bxor", "MPI_BXOR", MPI_BXOR},
+    {"maxloc", "MPI_MAXLOC", MPI_MAXLOC},
+    {"minloc", "MPI_MINLOC", MPI_MINLOC},
     {"replace", "MPI_REPLACE", MPI_REPLACE},
     {NULL, "MPI_OP_NULL", MPI_OP_NULL},
 };
-static int do_ops[12] = {
+static int do_ops[14] = {
     -1,
 }; /* index of the ops to do. Size +1 larger than the array_of_ops */
 static int verbose = 0;
@@ -63,6 +76,44 @@ static int total_errors = 0;
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
+#define plus(a, b) ((a) + (b))
+
+/* the (value, index) pairs used by MPI_MAXLOC and MPI_MINLOC */
+typedef struct {
+    short v;
+    int k;
+} test_short_int_t;
+typedef struct {
+    int v;
+    int k;
+} test_2int_t;
+typedef struct {
+    long v;
+    int k;
+} test_long_int_t;
+typedef struct {
+    float v;
+    int k;
+} test_float_int_t;
+typedef struct {
+    double v;
+    int k;
+} test_double_int_t;
+
+/* all the tested types fit in this many bytes */
+#define MAX_TYPE_EXTENT (2 * sizeof(double))
+
+/* mix of larger, smaller and equal values, with different indexes on ties */
+#define LOC_INIT(IN, INOUT, CHECK, COUNT)              \
+    do {                                               \
+        for (i = 0; i < (COUNT); i++) {                \
+            (IN)[i].v = i % 5;                         \
+            (IN)[i].k = i % 7;                         \
+            (INOUT)[i].v = (CHECK)[i].v = i % 3 + 1;   \
+            (INOUT)[i].k = (CHECK)[i].k = i % 4;       \
+        }                                              \
+    } while (0)
+
 static void print_status(char *op, char *type, int type_size, int count, int max_shift,
                          double *duration, int repeats, int correct)
 {
@@ -180,6 +231,74 @@ do { \
     } \
     goto check_and_continue; \
 } while (0)
+
+/* OPNAME is > for MPI_MAXLOC and < for MPI_MINLOC. On equal values the
+ * smallest index wins. */
+#define MPI_LOC_TEST(OPNAME, MPIOP, MPITYPE, TYPE, INBUF, INOUT_BUF, CHECK_BUF, COUNT) \
+do { \
+    const TYPE *_p1 = ((TYPE*)(INBUF)), *_p3 = ((TYPE*)(CHECK_BUF)); \
+    TYPE *_p2 = ((TYPE*)(INOUT_BUF)); \
+    skip_op_type = 0; \
+    int min_count = min((COUNT), max_shift); \
+    for(int _k = 0; _k < min_count; +_k++ ) { \
+        duration[_k] = 0.0; \
+        for(int _r = repeats; _r > 0; _r--) { \
+            memcpy(_p2, _p3, sizeof(TYPE) * (COUNT)); \
+            tstart = MPI_Wtime(); \
+            MPI_Reduce_local(_p1+_k, _p2+_k, (COUNT)-_k, (MPITYPE), (MPIOP)); \
+            tend = MPI_Wtime(); \
+            duration[_k] += (tend - tstart); \
+            if( check ) { \
+                for( i = 0; i < (COUNT)-_k; i++ ) { \
+                    TYPE _v1 = (_p1+_k)[i], _v2 = (_p2+_k)[i], _v3 = (_p3+_k)[i]; \
+                    if( (_v1.v OPNAME _v3.v) ? ((_v2.v == _v1.v) && (_v2.k == _v1.k)) : \
+                        (_v1.v == _v3.v) ? ((_v2.v == _v3.v) && (_v2.k == min(_v1.k, _v3.k))) : \
+                        ((_v2.v == _v3.v) && (_v2.k == _v3.k)) ) \
+                        continue; \
+                    printf("First error at alignment %d position %d ((%g, %d) %s (%g, %d) gives (%g, %d))\n", \
+                           _k, i, (double)_v1.v, _v1.k, (#OPNAME), (double)_v3.v, _v3.k, \
+                           (double)_v2.v, _v2.k); \
+                    correctness = 0; \
+                    break; \
+                } \
+            } \
+        } \
+    } \
+    goto check_and_continue; \
+} while (0)
+
+/* The expected value is computed in the precision of TYPE, and the values
+ * are printed as double as some short types are not promoted by varargs. */
+#define MPI_OP_FLOAT_TEST(OPNAME, MPIOP, MPITYPE, TYPE, INBUF, INOUT_BUF, CHECK_BUF, COUNT) \
+do { \
+    const TYPE *_p1 = ((TYPE*)(INBUF)), *_p3 = ((TYPE*)(CHECK_BUF)); \
+    TYPE *_p2 = ((TYPE*)(INOUT_BUF)); \
+    skip_op_type = 0; \
+    int min_count = min((COUNT), max_shift); \
+    for(int _k = 0; _k < min_count; +_k++ ) { \
+        duration[_k] = 0.0; \
+        for(int _r = repeats; _r > 0; _r--) { \
+            memcpy(_p2, _p3, sizeof(TYPE) * (COUNT)); \
+            tstart = MPI_Wtime(); \
+            MPI_Reduce_local(_p1+_k, _p2+_k, (COUNT)-_k, (MPITYPE), (MPIOP)); \
+            tend = MPI_Wtime(); \
+            duration[_k] += (tend - tstart); \
+            if( check ) { \
+                for( i = 0; i < (COUNT)-_k; i++ ) { \
+                    TYPE _v1 = (_p1+_k)[i], _v2 = (_p2+_k)[i], _v3 = (_p3+_k)[i]; \
+                    TYPE _expected = (TYPE) OPNAME(_v3, _v1); \
+                    if(_v2 == _expected) \
+                        continue; \
+                    printf("First error at alignment %d position %d (%s(%g, %g) = %g != %g)\n", \
+                           _k, i, (#OPNAME), (double)_v3, (double)_v1, (double)_expected, (double)_v2); \
+                    correctness = 0; \
+                    break; \
+                } \
+            } \
+        } \
+    } \
+    goto check_and_continue; \
+} while (0)
 /* clang-format on */
 
 int main(int argc, char **argv)
@@ -190,7 +309,7 @@ int main(int argc, char **argv)
     int max_shift = 4;
     double *duration, tstart, tend;
     bool check = true;
-    char type[5] = "uifd", *op = "sum", *mpi_type;
+    char type[9] = "uifdhpq", *op = "sum", *mpi_type;
     int lower = 1, upper = 16*1024*1024, skip_op_type;
     MPI_Op mpi_op;
 
@@ -232,15 +351,14 @@ int main(int argc, char **argv)
             break;
         case 't':
             for (i = 0; i < (int) strlen(optarg); i++) {
-                if (!(('i' == optarg[i]) || ('u' == optarg[i]) || ('f' == optarg[i])
-                      || ('d' == optarg[i]))) {
-                    fprintf(
-                        stderr,
-                        "type must be i (signed int), u (unsigned int), f (float) or d (double)\n");
+                if (NULL == strchr("uifdhpq", optarg[i])) {
+                    fprintf(stderr,
+                            "type must be i (signed int), u (unsigned int), f (float), d (double),\n"
+                            "h (short float), p (integer, int) or q (floating point, int) pairs\n");
                     exit(-1);
                 }
             }
-            strncpy(type, optarg, 4);
+            strncpy(type, optarg, 8);
             break;
         case 'o':
             build_do_ops(optarg, do_ops);
@@ -274,10 +392,13 @@ int main(int argc, char **argv)
                     " -l <number> : lower number of elements\n"
                     " -u <number> : upper number of elements\n"
                     " -s <type_size> : 8, 16, 32 or 64 bits elements\n"
-                    " -t [i,u,f,d] : type of the elements to apply the operations on\n"
+                    " -t [i,u,f,d,h,p,q] : type of the elements to apply the operations on\n"
+                    "                h: short float (16 bits)\n"
+                    "                p: short_int, 2int or long_int pairs (-s 16, 32 or 64)\n"
+                    "                q: float_int or double_int pairs (-s 32 or 64)\n"
                     " -r <number> : number of repetitions for each test\n"
                     " -o <op> : comma separated list of operations to execute among\n"
-                    "           sum, min, max, prod, bor, bxor, band\n"
+                    "           sum, min, max, prod, bor, bxor, band, maxloc, minloc\n"
                     " -i <number> : shift on all buffers to check alignment\n"
                     " -1 <number> : (mis)alignment in elements for the first op\n"
                     " -2 <number> : (mis)alignment in elements for the result\n"
@@ -292,9 +413,9 @@ int main(int argc, char **argv)
     if (!do_ops_built) { /* not yet done, take the default */
         build_do_ops("all", do_ops);
     }
-    posix_memalign(&in_buf, 64, (upper + op1_alignment) * sizeof(double));
-    posix_memalign(&inout_buf, 64, (upper + res_alignment) * sizeof(double));
-    posix_memalign(&inout_check_buf, 64, upper * sizeof(double));
+    posix_memalign(&in_buf, 64, (upper + op1_alignment) * MAX_TYPE_EXTENT);
+    posix_memalign(&inout_buf, 64, (upper + res_alignment) * MAX_TYPE_EXTENT);
+    posix_memalign(&inout_check_buf, 64, upper * MAX_TYPE_EXTENT);
     duration = (double *) malloc(max_shift * sizeof(double));
 
     ompi_mpi_init(argc, argv, MPI_THREAD_SERIALIZED, &provided, false);
@@ -705,6 +826,134 @@ int main(int argc, char **argv)
                                            inout_double_for_check, count, "f");
                     }
                 }
+#if defined(HAVE_TEST_SHORT_FLOAT)
+                if ('h' == type[type_idx]) {
+                    test_short_float_t *in_short_float = (test_short_float_t *) ((char *) in_buf
+                                                             + op1_alignment * sizeof(test_short_float_t)),
+                                       *inout_short_float = (test_short_float_t *) ((char *) inout_buf
+                                                                + res_alignment * sizeof(test_short_float_t)),
+                                       *inout_short_float_for_check = (test_short_float_t *) inout_check_buf;
+                    /* values that are not exactly representable, to check the rounding */
+                    for (i = 0; i < count; i++) {
+                        in_short_float[i] = (test_short_float_t) ((i % 97) * 0.37f);
+                        inout_short_float[i] = inout_short_float_for_check[i]
+                            = (test_short_float_t) (7.0f - (i % 53) * 1.13f);
+                    }
+                    mpi_type = "MPIX_SHORT_FLOAT";
+
+                    if (0 == strcmp(op, "sum")) {
+                        MPI_OP_FLOAT_TEST(plus, mpi_op, &ompi_mpi_short_float.dt, test_short_float_t,
+                                          in_short_float, inout_short_float,
+                                          inout_short_float_for_check, count);
+                    }
+                    if (0 == strcmp(op, "max")) {
+                        MPI_OP_FLOAT_TEST(max, mpi_op, &ompi_mpi_short_float.dt, test_short_float_t,
+                                          in_short_float, inout_short_float,
+                                          inout_short_float_for_check, count);
+                    }
+                    if (0 == strcmp(op, "min")) {
+                        MPI_OP_FLOAT_TEST(min, mpi_op, &ompi_mpi_short_float.dt, test_short_float_t,
+                                          in_short_float, inout_short_float,
+                                          inout_short_float_for_check, count);
+                    }
+                }
+#endif  /* defined(HAVE_TEST_SHORT_FLOAT) */
+
+                if ('p' == type[type_idx]) {
+                    if (16 == type_size) {
+                        test_short_int_t *in_short_int = (test_short_int_t *) ((char *) in_buf
+                                                  + op1_alignment * sizeof(test_short_int_t)),
+                            *inout_short_int = (test_short_int_t *) ((char *) inout_buf
+                                                       + res_alignment * sizeof(test_short_int_t)),
+                            *inout_short_int_for_check = (test_short_int_t *) inout_check_buf;
+                        LOC_INIT(in_short_int, inout_short_int, inout_short_int_for_check, count);
+                        mpi_type = "MPI_SHORT_INT";
+
+                        if (0 == strcmp(op, "maxloc")) {
+                            MPI_LOC_TEST(>, mpi_op, MPI_SHORT_INT, test_short_int_t, in_short_int, inout_short_int,
+                                         inout_short_int_for_check, count);
+                        }
+                        if (0 == strcmp(op, "minloc")) {
+                            MPI_LOC_TEST(<, mpi_op, MPI_SHORT_INT, test_short_int_t, in_short_int, inout_short_int,
+                                         inout_short_int_for_check, count);
+                        }
+                    }
+                    if (32 == type_size) {
+                        test_2int_t *in_2int = (test_2int_t *) ((char *) in_buf
+                                                  + op1_alignment * sizeof(test_2int_t)),
+                            *inout_2int = (test_2int_t *) ((char *) inout_buf
+                                                       + res_alignment * sizeof(test_2int_t)),
+                            *inout_2int_for_check = (test_2int_t *) inout_check_buf;
+                        LOC_INIT(in_2int, inout_2int, inout_2int_for_check, count);
+                        mpi_type = "MPI_2INT";
+
+                        if (0 == strcmp(op, "maxloc")) {
+                            MPI_LOC_TEST(>, mpi_op, MPI_2INT, test_2int_t, in_2int, inout_2int,
+                                         inout_2int_for_check, count);
+                        }
+                        if (0 == strcmp(op, "minloc")) {
+                            MPI_LOC_TEST(<, mpi_op, MPI_2INT, test_2int_t, in_2int, inout_2int,
+                                         inout_2int_for_check, count);
+                        }
+                    }
+                    if (64 == type_size) {
+                        test_long_int_t *in_long_int = (test_long_int_t *) ((char *) in_buf
+                                                  + op1_alignment * sizeof(test_long_int_t)),
+                            *inout_long_int = (test_long_int_t *) ((char *) inout_buf
+                                                       + res_alignment * sizeof(test_long_int_t)),
+                            *inout_long_int_for_check = (test_long_int_t *) inout_check_buf;
+                        LOC_INIT(in_long_int, inout_long_int, inout_long_int_for_check, count);
+                        mpi_type = "MPI_LONG_INT";
+
+                        if (0 == strcmp(op, "maxloc")) {
+                            MPI_LOC_TEST(>, mpi_op, MPI_LONG_INT, test_long_int_t, in_long_int, inout_long_int,
+                                         inout_long_int_for_check, count);
+                        }
+                        if (0 == strcmp(op, "minloc")) {
+                            MPI_LOC_TEST(<, mpi_op, MPI_LONG_INT, test_long_int_t, in_long_int, inout_long_int,
+                                         inout_long_int_for_check, count);
+                        }
+                    }
+                }
+
+                if ('q' == type[type_idx]) {
+                    if (32 == type_size) {
+                        test_float_int_t *in_float_int = (test_float_int_t *) ((char *) in_buf
+                                                  + op1_alignment * sizeof(test_float_int_t)),
+                            *inout_float_int = (test_float_int_t *) ((char *) inout_buf
+                                                       + res_alignment * sizeof(test_float_int_t)),
+                            *inout_float_int_for_check = (test_float_int_t *) inout_check_buf;
+                        LOC_INIT(in_float_int, inout_float_int, inout_float_int_for_check, count);
+                        mpi_type = "MPI_FLOAT_INT";
+
+                        if (0 == strcmp(op, "maxloc")) {
+                            MPI_LOC_TEST(>, mpi_op, MPI_FLOAT_INT, test_float_int_t, in_float_int, inout_float_int,
+                                         inout_float_int_for_check, count);
+                        }
+                        if (0 == strcmp(op, "minloc")) {
+                            MPI_LOC_TEST(<, mpi_op, MPI_FLOAT_INT, test_float_int_t, in_float_int, inout_float_int,
+                                         inout_float_int_for_check, count);
+                        }
+                    }
+                    if (64 == type_size) {
+                        test_double_int_t *in_double_int = (test_double_int_t *) ((char *) in_buf
+                                                  + op1_alignment * sizeof(test_double_int_t)),
+                            *inout_double_int = (test_double_int_t *) ((char *) inout_buf
+                                                       + res_alignment * sizeof(test_double_int_t)),
+                            *inout_double_int_for_check = (test_double_int_t *) inout_check_buf;
+                        LOC_INIT(in_double_int, inout_double_int, inout_double_int_for_check, count);
+                        mpi_type = "MPI_DOUBLE_INT";
+
+                        if (0 == strcmp(op, "maxloc")) {
+                            MPI_LOC_TEST(>, mpi_op, MPI_DOUBLE_INT, test_double_int_t, in_double_int, inout_double_int,
+                                         inout_double_int_for_check, count);
+                        }
+                        if (0 == strcmp(op, "minloc")) {
+                            MPI_LOC_TEST(<, mpi_op, MPI_DOUBLE_INT, test_double_int_t, in_double_int, inout_double_int,
+                                         inout_double_int_for_check, count);
+                        }
+                    }
+                }
             check_and_continue:
                 if (!skip_op_type)
                     print_status(array_of_ops[do_ops[op_idx]].mpi_op_name, mpi_type, type_size,
@@ -0,0 +1,82 @@
+/*
+ * Measure the cost of splitting the same parent the same way again and
+ * again, as a library does when it creates and frees a node communicator
+ * around each call. Each round splits MPI_COMM_WORLD by node, uses the
+ * result once and frees it, first without and then with the
+ * ompi_comm_split_cache info key:
+ *
+ *   mpirun -np 16 ./comm_split_cache [iters]
+ *
+ * Times are the average per split on rank 0 in microseconds. The size
+ * and rank of every new communicator are checked against the first
+ * split.
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int check(MPI_Comm comm, int size, int rank)
+{
+    int s, r;
+
+    MPI_Comm_size(comm, &s);
+    MPI_Comm_rank(comm, &r);
+    return s != size || r != rank;
+}
+
+int main(int argc, char *argv[])
+{
+    int rank, size, iters = 1000, errors = 0, cached, iter, sum;
+    int node_size, node_rank;
+    MPI_Comm comm;
+    MPI_Info info;
+    double t;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+    }
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &comm);
+    MPI_Comm_size(comm, &node_size);
+    MPI_Comm_rank(comm, &node_rank);
+    MPI_Comm_free(&comm);
+
+    if (0 == rank) {
+        printf("%d ranks, %d per node\n%-8s %12s\n", size, node_size, "cache", "usec");
+    }
+
+    for (cached = 0; cached < 2; cached++) {
+        MPI_Info_create(&info);
+        if (cached) {
+            MPI_Info_set(info, "ompi_comm_split_cache", "true");
+        }
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        t = MPI_Wtime();
+        for (iter = 0; iter < iters; iter++) {
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, info, &comm);
+            errors += check(comm, node_size, node_rank);
+            MPI_Allreduce(&rank, &sum, 1, MPI_INT, MPI_SUM, comm);
+            MPI_Comm_free(&comm);
+        }
+        t = MPI_Wtime() - t;
+
+        MPI_Info_free(&info);
+        if (0 == rank) {
+            printf("%-8s %12.2f\n", cached ? "on" : "off", 1e6 * t / iters);
+        }
+    }
+
+    if (errors) {
+        fprintf(stderr, "rank %d: %d splits with a wrong size or rank\n", rank, errors);
+    }
+
+    MPI_Finalize();
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Measure the cost of message matching as the posted receive queue and
+ * the unexpected message queue grow. Each process keeps <depth> entries
+ * that never match in one of the queues while the two processes
+ * ping-pong, so every message has to be matched past them. Compare the
+ * ob1 matching engines:
+ *
+ *   mpirun -np 2 --mca pml ob1 --mca pml_ob1_matching_engine none ./match_depth
+ *   mpirun -np 2 --mca pml ob1 --mca pml_ob1_matching_engine auto ./match_depth
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PING_TAG   1
+#define POSTED_TAG 2
+#define UNEXP_TAG  3
+#define MARKER_TAG 4
+
+static double pingpong(int peer, int rank, int iters)
+{
+    double start;
+    int i, buf = 0;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (i = 0; i < iters; ++i) {
+        if (0 == rank) {
+            MPI_Send(&buf, 1, MPI_INT, peer, PING_TAG, MPI_COMM_WORLD);
+            MPI_Recv(&buf, 1, MPI_INT, peer, PING_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        } else {
+            MPI_Recv(&buf, 1, MPI_INT, peer, PING_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            MPI_Send(&buf, 1, MPI_INT, peer, PING_TAG, MPI_COMM_WORLD);
+        }
+    }
+    return (MPI_Wtime() - start) * 1e6 / (2 * iters);
+}
+
+/* incoming messages are matched past <depth> posted wildcard receives */
+static double posted_depth(int peer, int rank, int depth, int iters, MPI_Request *reqs, int *bufs)
+{
+    double t;
+    int i;
+
+    for (i = 0; i < depth; ++i) {
+        MPI_Irecv(bufs + i, 1, MPI_INT, MPI_ANY_SOURCE, POSTED_TAG, MPI_COMM_WORLD, reqs + i);
+    }
+
+    t = pingpong(peer, rank, iters);
+
+    /* satisfy the receives posted by the peer */
+    for (i = 0; i < depth; ++i) {
+        MPI_Isend(bufs + depth + i, 1, MPI_INT, peer, POSTED_TAG, MPI_COMM_WORLD, reqs + depth + i);
+    }
+    MPI_Waitall(2 * depth, reqs, MPI_STATUSES_IGNORE);
+
+    return t;
+}
+
+/* posted receives are matched past <depth> unexpected messages */
+static double unexpected_depth(int peer, int rank, int depth, int iters, MPI_Request *reqs, int *bufs)
+{
+    double t;
+    int i;
+
+    for (i = 0; i < depth; ++i) {
+        MPI_Isend(bufs + i, 1, MPI_INT, peer, UNEXP_TAG, MPI_COMM_WORLD, reqs + i);
+    }
+    /* messages are matched in order: once the marker arrived all the
+     * dummy messages are in the unexpected queue */
+    MPI_Send(bufs, 1, MPI_INT, peer, MARKER_TAG, MPI_COMM_WORLD);
+    MPI_Recv(bufs, 1, MPI_INT, peer, MARKER_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    t = pingpong(peer, rank, iters);
+
+    for (i = 0; i < depth; ++i) {
+        MPI_Recv(bufs + depth + i, 1, MPI_INT, peer, UNEXP_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    MPI_Waitall(depth, reqs, MPI_STATUSES_IGNORE);
+
+    return t;
+}
+
+int main(int argc, char *argv[])
+{
+    double prq, umq, prq0 = 0.0, umq0 = 0.0;
+    int rank, size, peer, depth, iters = 2000, max_depth = 4096;
+    MPI_Request *reqs;
+    int *bufs;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (2 != size) {
+        if (0 == rank) {
+            fprintf(stderr, "match_depth needs exactly 2 processes\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        max_depth = atoi(argv[2]);
+    }
+
+    peer = 1 - rank;
+    reqs = malloc((2 * max_depth + 1) * sizeof(MPI_Request));
+    bufs = calloc(2 * max_depth + 1, sizeof(int));
+
+    /* warm up the connection */
+    pingpong(peer, rank, 100);
+
+    if (0 == rank) {
+        printf("%8s %14s %14s %16s %16s\n", "depth", "posted usec", "unexp usec",
+               "posted ns/entry", "unexp ns/entry");
+    }
+
+    for (depth = 0 ; depth <= max_depth ; depth = depth ? depth * 4 : 1) {
+        prq = posted_depth(peer, rank, depth, iters, reqs, bufs);
+        umq = unexpected_depth(peer, rank, depth, iters, reqs, bufs);
+        if (0 == depth) {
+            prq0 = prq;
+            umq0 = umq;
+        }
+        if (0 == rank) {
+            printf("%8d %14.3f %14.3f %16.2f %16.2f\n", depth, prq, umq,
+                   depth ? (prq - prq0) * 1e3 / depth : 0.0,
+                   depth ? (umq - umq0) * 1e3 / depth : 0.0);
+        }
+    }
+
+    free(reqs);
+    free(bufs);
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ * Measure the per-call cost of small nonblocking collectives. Compare
+ * the libnbc schedule cache on and off:
+ *
+ *   mpirun -np 4 --mca coll_libnbc_priority 100 \
+ *          --mca coll_libnbc_schedule_cache_size 0  ./nbc_sched_cache
+ *   mpirun -np 4 --mca coll_libnbc_priority 100 \
+ *          --mca coll_libnbc_schedule_cache_size 16 ./nbc_sched_cache
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define COUNT 8
+
+static double run_iallreduce(int iters, double *sbuf, double *rbuf)
+{
+    MPI_Request req;
+    double start;
+    int i;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (i = 0; i < iters; ++i) {
+        MPI_Iallreduce(sbuf, rbuf, COUNT, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+    }
+    return MPI_Wtime() - start;
+}
+
+static double run_ialltoall(int iters, int *sbuf, int *rbuf)
+{
+    MPI_Request req;
+    double start;
+    int i;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (i = 0; i < iters; ++i) {
+        MPI_Ialltoall(sbuf, 1, MPI_INT, rbuf, 1, MPI_INT, MPI_COMM_WORLD, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+    }
+    return MPI_Wtime() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    double dsbuf[COUNT], drbuf[COUNT], t, tmax;
+    int *isbuf, *irbuf;
+    int rank, size, i, iters = 100000;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+    }
+
+    for (i = 0; i < COUNT; ++i) {
+        dsbuf[i] = rank + i;
+    }
+    isbuf = malloc(size * sizeof(int));
+    irbuf = malloc(size * sizeof(int));
+    for (i = 0; i < size; ++i) {
+        isbuf[i] = rank * size + i;
+    }
+
+    /* warm up connections and the schedule cache */
+    run_iallreduce(100, dsbuf, drbuf);
+    run_ialltoall(100, isbuf, irbuf);
+
+    t = run_iallreduce(iters, dsbuf, drbuf);
+    MPI_Reduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (0 == rank) {
+        printf("MPI_Iallreduce(%d doubles) + MPI_Wait: %.3f usec/call\n", COUNT, tmax * 1e6 / iters);
+    }
+
+    t = run_ialltoall(iters, isbuf, irbuf);
+    MPI_Reduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (0 == rank) {
+        printf("MPI_Ialltoall(1 int) + MPI_Wait: %.3f usec/call\n", tmax * 1e6 / iters);
+    }
+
+    free(isbuf);
+    free(irbuf);
+    MPI_Finalize();
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Check MPI_Neighbor_alltoallv on an irregular distributed graph: the
+ * ranks have different degrees (some none at all), and most have several
+ * edges to the same peer, each with a block of a different size. The
+ * k-th block from a rank to a peer must land in the k-th receive slot
+ * for that rank, whichever path it takes. Run across several nodes to
+ * cover the message combining of the shared memory component:
+ *
+ *   mpirun -np 16 ./neighbor_irregular [iters]
+ *   mpirun -np 16 --mca coll_nbrsm_priority 40 ./neighbor_irregular
+ *   mpirun -np 16 --mca coll_nbrsm_priority 40 --mca coll_nbrsm_persistent_plans 1 ./neighbor_irregular
+ *   mpirun -np 16 --map-by ppr:4:node --mca coll_nbrsm_priority 40 --mca coll_nbrsm_aggregate 1 ./neighbor_irregular
+ *
+ * Blocking, non-blocking and persistent calls are checked at every
+ * iteration. A persistent call is only waited for after an exchange with
+ * the ring neighbours, which a plan that blocks in MPI_Start would hang.
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_DEGREE 8
+
+enum { BLOCKING, NONBLOCKING, PERSISTENT, NMODES };
+static const char *mode_names[NMODES] = {"blocking", "nonblocking", "persistent"};
+
+/* out-edges of a rank: none for every fifth rank, otherwise a few distinct
+ * peers with the next rank repeated */
+static int out_edges(int rank, int size, int *peers)
+{
+    int degree = 0;
+
+    if (4 == rank % 5) {
+        return 0;
+    }
+    for (int k = 0; k < 1 + rank % 3; k++) {
+        peers[degree++] = (rank + 1) % size;
+    }
+    for (int k = 1; k <= rank % 4; k++) {
+        peers[degree++] = (rank + k * k + 2) % size;
+    }
+    return degree;
+}
+
+/* the block of out-edge e of a rank: its size and contents differ per edge */
+static int block_count(int src, int e)
+{
+    return 1 + (3 * src + 5 * e) % 7;
+}
+
+static int block_value(int src, int e, int i, int iter)
+{
+    return ((src * MAX_DEGREE + e) * 16 + i) * 8 + iter % 8;
+}
+
+int main(int argc, char *argv[])
+{
+    int rank, size, iters = 10, errors = 0, iter, mode, token;
+    int outdeg, indeg = 0, peers[MAX_DEGREE];
+    int *sources, *src_edge, *scounts, *sdispls, *rcounts, *rdispls, *sbuf, *rbuf;
+    int stotal = 0, rtotal = 0;
+    MPI_Comm graph;
+    MPI_Request request;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+    }
+
+    /* the in-edges from a rank follow the order of its out-edges to us,
+     * and the sources are listed in rank order */
+    sources = malloc(size * MAX_DEGREE * sizeof(int));
+    src_edge = malloc(size * MAX_DEGREE * sizeof(int));
+    for (int src = 0; src < size; src++) {
+        int n = out_edges(src, size, peers);
+
+        for (int e = 0; e < n; e++) {
+            if (peers[e] == rank) {
+                sources[indeg] = src;
+                src_edge[indeg++] = e;
+            }
+        }
+    }
+    outdeg = out_edges(rank, size, peers);
+
+    scounts = malloc((outdeg + 1) * sizeof(int));
+    sdispls = malloc((outdeg + 1) * sizeof(int));
+    rcounts = malloc((indeg + 1) * sizeof(int));
+    rdispls = malloc((indeg + 1) * sizeof(int));
+    for (int e = 0; e < outdeg; e++) {
+        scounts[e] = block_count(rank, e);
+        sdispls[e] = stotal;
+        stotal += scounts[e];
+    }
+    for (int j = 0; j < indeg; j++) {
+        rcounts[j] = block_count(sources[j], src_edge[j]);
+        rdispls[j] = rtotal;
+        rtotal += rcounts[j];
+    }
+    sbuf = malloc((stotal + 1) * sizeof(int));
+    rbuf = malloc((rtotal + 1) * sizeof(int));
+
+    MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD, indeg, sources, MPI_UNWEIGHTED, outdeg, peers,
+                                   MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &graph);
+
+    for (mode = 0; mode < NMODES; mode++) {
+        int mode_errors = 0;
+
+        if (PERSISTENT == mode) {
+            MPI_Neighbor_alltoallv_init(sbuf, scounts, sdispls, MPI_INT, rbuf, rcounts, rdispls,
+                                        MPI_INT, graph, MPI_INFO_NULL, &request);
+        }
+
+        for (iter = 0; iter < iters; iter++) {
+            for (int e = 0; e < outdeg; e++) {
+                for (int i = 0; i < scounts[e]; i++) {
+                    sbuf[sdispls[e] + i] = block_value(rank, e, i, iter);
+                }
+            }
+            for (int i = 0; i < rtotal; i++) {
+                rbuf[i] = -1;
+            }
+
+            switch (mode) {
+            case BLOCKING:
+                MPI_Neighbor_alltoallv(sbuf, scounts, sdispls, MPI_INT, rbuf, rcounts, rdispls,
+                                       MPI_INT, graph);
+                break;
+            case NONBLOCKING:
+                MPI_Ineighbor_alltoallv(sbuf, scounts, sdispls, MPI_INT, rbuf, rcounts, rdispls,
+                                        MPI_INT, graph, &request);
+                MPI_Wait(&request, MPI_STATUS_IGNORE);
+                break;
+            case PERSISTENT:
+                MPI_Start(&request);
+                MPI_Sendrecv(&iter, 1, MPI_INT, (rank + 1) % size, 0, &token, 1, MPI_INT,
+                             (rank + size - 1) % size, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                MPI_Wait(&request, MPI_STATUS_IGNORE);
+                break;
+            }
+
+            for (int j = 0; j < indeg; j++) {
+                for (int i = 0; i < rcounts[j]; i++) {
+                    if (rbuf[rdispls[j] + i] != block_value(sources[j], src_edge[j], i, iter)) {
+                        ++mode_errors;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (PERSISTENT == mode) {
+            MPI_Request_free(&request);
+        }
+        if (mode_errors) {
+            fprintf(stderr, "rank %d: %s: %d blocks with wrong data\n", rank, mode_names[mode],
+                    mode_errors);
+            errors += mode_errors;
+        }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (0 == rank) {
+        printf("%d ranks: %s\n", size, errors ? "FAILED" : "passed");
+    }
+
+    free(sources);
+    free(src_edge);
+    free(scounts);
+    free(sdispls);
+    free(rcounts);
+    free(rdispls);
+    free(sbuf);
+    free(rbuf);
+    MPI_Comm_free(&graph);
+    MPI_Finalize();
+
+    return errors ? 1 : 0;
+}
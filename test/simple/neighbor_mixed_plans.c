@@ -0,0 +1,133 @@
+/*
+ * Check persistent neighborhood collectives on a communicator where some
+ * nodes aggregate their off-node blocks and others do not. The leaders
+ * of the first two nodes are neighbours, so with message combining those
+ * nodes leave their plans to the component below, while on the other
+ * nodes every rank only has neighbours on its own node and takes the
+ * shared memory plans. Several plans are created on the communicator and
+ * started together, and a non-blocking allreduce runs after them: both
+ * hang if the two kinds of nodes draw different tags. Run on at least
+ * three nodes:
+ *
+ *   mpirun -np 12 --map-by ppr:4:node ./neighbor_mixed_plans [iters]
+ *   mpirun -np 12 --map-by ppr:4:node --mca coll_nbrsm_priority 40 \
+ *          --mca coll_nbrsm_persistent_plans 1 --mca coll_nbrsm_aggregate 1 ./neighbor_mixed_plans
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NPLANS 3
+
+int main(int argc, char *argv[])
+{
+    int rank, size, node_rank, node_size, node, nnodes, iters = 10, errors = 0;
+    int degree = 0, neighbors[3], *node_ranks, sum;
+    MPI_Comm node_comm, leader_comm, graph;
+    MPI_Request reqs[NPLANS], req;
+    int *sbuf[NPLANS], *rbuf[NPLANS];
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+    }
+
+    /* number the nodes in the order of their first rank */
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_size(node_comm, &node_size);
+    MPI_Comm_split(MPI_COMM_WORLD, 0 == node_rank ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+    if (0 == node_rank) {
+        MPI_Comm_rank(leader_comm, &node);
+        MPI_Comm_size(leader_comm, &nnodes);
+        MPI_Comm_free(&leader_comm);
+    }
+    MPI_Bcast(&node, 1, MPI_INT, 0, node_comm);
+    MPI_Bcast(&nnodes, 1, MPI_INT, 0, node_comm);
+    if (0 == rank && nnodes < 3) {
+        printf("only %d node(s): every node takes the same path\n", nnodes);
+    }
+
+    node_ranks = malloc(node_size * sizeof(int));
+    MPI_Allgather(&rank, 1, MPI_INT, node_ranks, 1, MPI_INT, node_comm);
+
+    /* a ring on every node, and an edge between the leaders of the first
+     * two nodes; the graph is symmetric */
+    if (node_size > 1) {
+        neighbors[degree++] = node_ranks[(node_rank + 1) % node_size];
+    }
+    if (node_size > 2) {
+        neighbors[degree++] = node_ranks[(node_rank + node_size - 1) % node_size];
+    }
+    /* the leaders of the first two nodes learn each other's rank */
+    sum = (0 == node_rank && node < 2) ? rank : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (0 == node_rank && node < 2 && nnodes > 1) {
+        neighbors[degree++] = sum - rank;
+    }
+
+    MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD, degree, neighbors, MPI_UNWEIGHTED, degree,
+                                   neighbors, MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &graph);
+
+    /* plan p exchanges blocks of p + 1 elements */
+    for (int p = 0; p < NPLANS; p++) {
+        sbuf[p] = malloc((degree + 1) * (p + 1) * sizeof(int));
+        rbuf[p] = malloc((degree + 1) * (p + 1) * sizeof(int));
+        MPI_Neighbor_alltoall_init(sbuf[p], p + 1, MPI_INT, rbuf[p], p + 1, MPI_INT, graph,
+                                   MPI_INFO_NULL, &reqs[p]);
+    }
+
+    for (int iter = 0; iter < iters; iter++) {
+        for (int p = 0; p < NPLANS; p++) {
+            for (int i = 0; i < degree * (p + 1); i++) {
+                sbuf[p][i] = rank * NPLANS + p + iter;
+                rbuf[p][i] = -1;
+            }
+        }
+
+        MPI_Startall(NPLANS, reqs);
+        MPI_Waitall(NPLANS, reqs, MPI_STATUSES_IGNORE);
+
+        for (int p = 0; p < NPLANS; p++) {
+            for (int i = 0; i < degree * (p + 1); i++) {
+                if (rbuf[p][i] != neighbors[i / (p + 1)] * NPLANS + p + iter) {
+                    fprintf(stderr, "rank %d: iteration %d: plan %d: wrong element %d\n", rank,
+                            iter, p, i);
+                    ++errors;
+                    break;
+                }
+            }
+        }
+
+        /* every rank has to draw the same tag for this one */
+        sum = rank + iter;
+        MPI_Iallreduce(MPI_IN_PLACE, &sum, 1, MPI_INT, MPI_SUM, graph, &req);
+        MPI_Wait(&req, MPI_STATUS_IGNORE);
+        if (sum != size * (size - 1) / 2 + size * iter) {
+            fprintf(stderr, "rank %d: iteration %d: wrong sum %d\n", rank, iter, sum);
+            ++errors;
+        }
+    }
+
+    for (int p = 0; p < NPLANS; p++) {
+        MPI_Request_free(&reqs[p]);
+        free(sbuf[p]);
+        free(rbuf[p]);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (0 == rank) {
+        printf("%d ranks on %d nodes: %s\n", size, nnodes, errors ? "FAILED" : "passed");
+    }
+
+    free(node_ranks);
+    MPI_Comm_free(&graph);
+    MPI_Comm_free(&node_comm);
+    MPI_Finalize();
+
+    return errors ? 1 : 0;
+}
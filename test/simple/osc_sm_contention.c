@@ -0,0 +1,126 @@
+/*
+ * Measure accumulate throughput when all processes target the same
+ * window location of rank 0, with a shared-memory window. Run with and
+ * without processor atomics in osc/sm:
+ *
+ *   mpirun -np 8 --mca osc sm --mca osc_sm_acc_use_amo 1 ./osc_sm_contention
+ *   mpirun -np 8 --mca osc sm --mca osc_sm_acc_use_amo 0 ./osc_sm_contention
+ */
+
+#include <mpi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ELEMENTS 64
+
+typedef enum {
+    BENCH_FETCH_AND_OP,
+    BENCH_ACCUMULATE,
+    BENCH_ACCUMULATE_VECTOR,
+    BENCH_COMPARE_AND_SWAP,
+} bench_t;
+
+static const char *bench_names[] = {"fetch_and_op", "accumulate", "accumulate x64",
+                                    "compare_and_swap"};
+
+static double run(bench_t bench, MPI_Win win, int iters, int64_t *local)
+{
+    int64_t one = 1, value, result, compare;
+    double start;
+    int i;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (i = 0; i < iters; ++i) {
+        switch (bench) {
+        case BENCH_FETCH_AND_OP:
+            MPI_Fetch_and_op(&one, &result, MPI_INT64_T, 0, 0, MPI_SUM, win);
+            break;
+        case BENCH_ACCUMULATE:
+            MPI_Accumulate(&one, 1, MPI_INT64_T, 0, 0, 1, MPI_INT64_T, MPI_SUM, win);
+            break;
+        case BENCH_ACCUMULATE_VECTOR:
+            MPI_Accumulate(local, ELEMENTS, MPI_INT64_T, 0, 0, ELEMENTS, MPI_INT64_T,
+                           MPI_SUM, win);
+            break;
+        case BENCH_COMPARE_AND_SWAP:
+            /* increment through a compare-and-swap, retrying on conflicts */
+            MPI_Fetch_and_op(NULL, &compare, MPI_INT64_T, 0, 0, MPI_NO_OP, win);
+            do {
+                value = compare + 1;
+                MPI_Compare_and_swap(&value, &compare, &result, MPI_INT64_T, 0, 0, win);
+                if (result == compare) {
+                    break;
+                }
+                compare = result;
+            } while (1);
+            break;
+        }
+    }
+    MPI_Win_flush(0, win);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    return MPI_Wtime() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    int rank, size, i, errors = 0, iters = 100000;
+    int64_t *base, local[ELEMENTS], expected;
+    MPI_Aint win_size;
+    MPI_Win win;
+    double t;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+    }
+
+    for (i = 0; i < ELEMENTS; ++i) {
+        local[i] = 1;
+    }
+
+    win_size = (0 == rank) ? ELEMENTS * sizeof(int64_t) : 0;
+    MPI_Win_allocate_shared(win_size, sizeof(int64_t), MPI_INFO_NULL, MPI_COMM_WORLD,
+                            &base, &win);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+    if (0 == rank) {
+        printf("%-18s %14s %12s\n", "operation", "ops/s", "usec/op");
+    }
+
+    for (bench_t bench = BENCH_FETCH_AND_OP; bench <= BENCH_COMPARE_AND_SWAP; ++bench) {
+        if (0 == rank) {
+            for (i = 0; i < ELEMENTS; ++i) {
+                base[i] = 0;
+            }
+        }
+        MPI_Win_sync(win);
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        t = run(bench, win, iters, local);
+
+        MPI_Win_sync(win);
+        if (0 == rank) {
+            expected = (int64_t) iters * size;
+            if (base[0] != expected ||
+                (BENCH_ACCUMULATE_VECTOR == bench && base[ELEMENTS - 1] != expected)) {
+                fprintf(stderr, "%s: found %lld, expected %lld\n", bench_names[bench],
+                        (long long) base[0], (long long) expected);
+                ++errors;
+            }
+            printf("%-18s %14.0f %12.3f\n", bench_names[bench], (double) iters * size / t,
+                   t * 1e6 / iters);
+        }
+    }
+
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+    MPI_Finalize();
+
+    return errors ? 1 : 0;
+}
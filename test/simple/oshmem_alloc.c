@@ -0,0 +1,188 @@
+/*
+ * Measure the symmetric heap allocator: allocation rate, free rate and
+ * fragmentation for several size distributions. Compare the memheap
+ * components with
+ *
+ *   oshrun -np 2 -x SHMEM_SYMMETRIC_SIZE=1G --mca memheap slab ./oshmem_alloc
+ *   oshrun -np 2 -x SHMEM_SYMMETRIC_SIZE=1G --mca memheap ptmalloc ./oshmem_alloc
+ *   oshrun -np 2 -x SHMEM_SYMMETRIC_SIZE=1G --mca memheap buddy ./oshmem_alloc
+ *
+ * Footprint is the address range covered by the live objects, usage is
+ * the requested bytes divided by the footprint. "churn" frees every
+ * other object and allocates new ones with different sizes before
+ * measuring again. The program also checks that all PEs got the same
+ * addresses.
+ */
+
+#include <shmem.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+typedef enum {
+    DIST_TINY,
+    DIST_SMALL,
+    DIST_MIXED,
+    DIST_LARGE,
+} dist_t;
+
+static const char *dist_names[] = {"8-64", "8-1024", "mixed", "4K-256K"};
+
+static long addr_hash[4];
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/* same sequence on all PEs, allocations are collective */
+static uint64_t rnd(uint64_t *state)
+{
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+static size_t draw(dist_t dist, uint64_t *state)
+{
+    uint64_t r;
+
+    switch (dist) {
+    case DIST_TINY:
+        return 8 + rnd(state) % 57;
+    case DIST_SMALL:
+        return 8 + rnd(state) % 1017;
+    case DIST_MIXED:
+        r = rnd(state) % 100;
+        if (r < 70) {
+            return 8 + rnd(state) % 57;
+        } else if (r < 95) {
+            return 65 + rnd(state) % 4032;
+        }
+        return 4097 + rnd(state) % 61440;
+    case DIST_LARGE:
+    default:
+        return 4096 + rnd(state) % (256 * 1024 - 4096);
+    }
+}
+
+static double footprint(char **ptrs, size_t *sizes, int n, size_t *requested)
+{
+    char *lo = NULL, *hi = NULL;
+    int i;
+
+    *requested = 0;
+    for (i = 0; i < n; ++i) {
+        if (NULL == ptrs[i]) {
+            continue;
+        }
+        if (NULL == lo || ptrs[i] < lo) {
+            lo = ptrs[i];
+        }
+        if (NULL == hi || ptrs[i] + sizes[i] > hi) {
+            hi = ptrs[i] + sizes[i];
+        }
+        *requested += sizes[i];
+    }
+
+    return (double) (hi - lo);
+}
+
+int main(int argc, char *argv[])
+{
+    int me, i, n, count = 50000, errors = 0;
+    size_t requested, churn_requested;
+    double t_alloc, t_free, t_churn, span, churn_span;
+    uint64_t state;
+    long hash;
+    size_t *sizes;
+    char **ptrs;
+
+    shmem_init();
+    me = shmem_my_pe();
+
+    if (argc > 1) {
+        count = atoi(argv[1]);
+    }
+
+    ptrs = calloc(count, sizeof(*ptrs));
+    sizes = calloc(count, sizeof(*sizes));
+    if (NULL == ptrs || NULL == sizes) {
+        shmem_global_exit(1);
+    }
+
+    if (0 == me) {
+        printf("%-8s %8s %12s %12s %12s %8s %8s\n", "sizes", "objects", "alloc/s",
+               "free/s", "churn/s", "usage", "churn");
+    }
+
+    for (dist_t dist = DIST_TINY; dist <= DIST_LARGE; ++dist) {
+        state = 42 + dist;
+        hash = 0;
+
+        /* fill */
+        shmem_barrier_all();
+        t_alloc = now();
+        for (n = 0; n < count; ++n) {
+            sizes[n] = draw(dist, &state);
+            ptrs[n] = shmem_malloc(sizes[n]);
+            if (NULL == ptrs[n]) {
+                break;
+            }
+        }
+        t_alloc = now() - t_alloc;
+        span = footprint(ptrs, sizes, n, &requested);
+        for (i = 0; i < n; ++i) {
+            hash = hash * 31 + (long) (uintptr_t) ptrs[i];
+        }
+
+        /* free every other object and allocate new sizes into the holes */
+        t_churn = now();
+        for (i = 0; i < n; i += 2) {
+            shmem_free(ptrs[i]);
+            ptrs[i] = NULL;
+        }
+        for (i = 0; i < n; i += 2) {
+            sizes[i] = draw(dist, &state);
+            ptrs[i] = shmem_malloc(sizes[i]);
+        }
+        t_churn = now() - t_churn;
+        churn_span = footprint(ptrs, sizes, n, &churn_requested);
+        for (i = 0; i < n; i += 2) {
+            hash = hash * 31 + (long) (uintptr_t) ptrs[i];
+        }
+
+        t_free = now();
+        for (i = 0; i < n; ++i) {
+            shmem_free(ptrs[i]);
+        }
+        t_free = now() - t_free;
+
+        /* every PE has to see the same addresses */
+        if (0 == me) {
+            addr_hash[dist] = hash;
+        }
+        shmem_barrier_all();
+        if (shmem_long_g(&addr_hash[dist], 0) != hash) {
+            fprintf(stderr, "PE %d: %s: addresses differ from PE 0\n", me, dist_names[dist]);
+            ++errors;
+        }
+        if (0 == me) {
+            printf("%-8s %8d %12.0f %12.0f %12.0f %7.1f%% %7.1f%%\n", dist_names[dist], n,
+                   n / t_alloc, n / t_free, n / t_churn, 100.0 * requested / span,
+                   100.0 * churn_requested / churn_span);
+            if (n < count) {
+                printf("%-8s heap full after %d objects\n", "", n);
+            }
+        }
+    }
+
+    free(ptrs);
+    free(sizes);
+    shmem_finalize();
+
+    return errors ? 1 : 0;
+}
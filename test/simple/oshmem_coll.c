@@ -0,0 +1,119 @@
+/*
+ * Measure the latency of shmem_barrier_all, shmem_long_sum_to_all and
+ * shmem_broadcast64 over all PEs and check the results. Compare the
+ * hierarchical collectives with the flat ones on nodes with many PEs:
+ *
+ *   oshrun -np 256 --map-by ppr:64:node ./oshmem_coll
+ *   oshrun -np 256 --map-by ppr:64:node --mca scoll ^hier ./oshmem_coll
+ *
+ * Times are the average per call on PE 0 in microseconds; every
+ * reduction and broadcast is followed by a barrier so that pSync can be
+ * reused.
+ */
+
+#include <shmem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define MAX_COUNT (64 * 1024)
+
+static long pSync[SHMEM_REDUCE_SYNC_SIZE];
+static long pWrk[SHMEM_REDUCE_MIN_WRKDATA_SIZE > MAX_COUNT / 2 + 1 ?
+                 SHMEM_REDUCE_MIN_WRKDATA_SIZE : MAX_COUNT / 2 + 1];
+static long source[MAX_COUNT];
+static long target[MAX_COUNT];
+
+static double now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+int main(int argc, char *argv[])
+{
+    int me, npes, i, iter, count, errors = 0, iters = 1000;
+    double t;
+
+    shmem_init();
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+    }
+
+    for (i = 0; i < SHMEM_REDUCE_SYNC_SIZE; i++) {
+        pSync[i] = SHMEM_SYNC_VALUE;
+    }
+    shmem_barrier_all();
+
+    for (i = 0; i < 10; i++) {
+        shmem_barrier_all();
+    }
+    t = now();
+    for (iter = 0; iter < iters; iter++) {
+        shmem_barrier_all();
+    }
+    t = now() - t;
+    if (0 == me) {
+        printf("%-12s %8s %10.2f\n", "barrier_all", "-", 1e6 * t / iters);
+    }
+
+    for (count = 1; count <= MAX_COUNT; count *= 8) {
+        for (i = 0; i < count; i++) {
+            source[i] = me + i;
+        }
+        shmem_barrier_all();
+        t = now();
+        for (iter = 0; iter < iters; iter++) {
+            shmem_long_sum_to_all(target, source, count, 0, 0, npes, pWrk, pSync);
+            shmem_barrier_all();
+        }
+        t = now() - t;
+        for (i = 0; i < count; i++) {
+            if (target[i] != (long) npes * (npes - 1) / 2 + (long) npes * i) {
+                fprintf(stderr, "PE %d: sum_to_all of %d: target[%d] = %ld\n", me, count, i,
+                        target[i]);
+                ++errors;
+                break;
+            }
+        }
+        if (0 == me) {
+            printf("%-12s %8zu %10.2f\n", "sum_to_all", count * sizeof(long),
+                   1e6 * t / iters);
+        }
+    }
+
+    for (count = 1; count <= MAX_COUNT; count *= 8) {
+        for (i = 0; i < count; i++) {
+            source[i] = (0 == me) ? i : -1;
+            target[i] = -1;
+        }
+        shmem_barrier_all();
+        t = now();
+        for (iter = 0; iter < iters; iter++) {
+            shmem_broadcast64(target, source, count, 0, 0, 0, npes, pSync);
+            shmem_barrier_all();
+        }
+        t = now() - t;
+        for (i = 0; me != 0 && i < count; i++) {
+            if (target[i] != i) {
+                fprintf(stderr, "PE %d: broadcast of %d: target[%d] = %ld\n", me, count, i,
+                        target[i]);
+                ++errors;
+                break;
+            }
+        }
+        if (0 == me) {
+            printf("%-12s %8zu %10.2f\n", "broadcast", count * sizeof(long),
+                   1e6 * t / iters);
+        }
+    }
+
+    shmem_finalize();
+
+    return errors ? 1 : 0;
+}
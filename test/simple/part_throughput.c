@@ -0,0 +1,134 @@
+/*
+ * Measure the throughput of a partitioned send from rank 0 to rank 1
+ * when many threads mark small partitions ready, as in a loop over
+ * tiles parallelized with threads. Compare sending every partition on
+ * its own with sending them in larger transfers:
+ *
+ *   mpirun -np 2 ./part_throughput [threads] [partitions] [bytes] [iters]
+ *   mpirun -np 2 --mca part_persist_aggregation_size 65536 ./part_throughput
+ *
+ * Every thread marks a contiguous block of partitions ready one at a
+ * time. Rank 1 checks the data of every partition with MPI_Parrived.
+ */
+
+#include <mpi.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static MPI_Request request;
+static int nthreads = 8;
+static int partitions = 4096;
+static int part_bytes = 64;
+
+static void *mark_ready(void *arg)
+{
+    int id = (int) (intptr_t) arg;
+    int per_thread = partitions / nthreads;
+    int i;
+
+    for (i = id * per_thread; i < (id + 1) * per_thread; i++) {
+        MPI_Pready(i, request);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t *threads;
+    int rank, size, provided, iters = 100, iter, i, errors = 0, flag;
+    double start, t;
+    char *buf;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        nthreads = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        partitions = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        part_bytes = atoi(argv[3]);
+    }
+    if (argc > 4) {
+        iters = atoi(argv[4]);
+    }
+
+    if (size < 2 || provided < MPI_THREAD_MULTIPLE || partitions % nthreads) {
+        if (0 == rank) {
+            fprintf(stderr, "need 2 processes, MPI_THREAD_MULTIPLE and partitions divisible "
+                            "by threads\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    buf = malloc((size_t) partitions * part_bytes);
+    threads = malloc(nthreads * sizeof(*threads));
+
+    if (0 == rank) {
+        MPI_Psend_init(buf, partitions, part_bytes, MPI_BYTE, 1, 0, MPI_COMM_WORLD,
+                       MPI_INFO_NULL, &request);
+    } else if (1 == rank) {
+        MPI_Precv_init(buf, partitions, part_bytes, MPI_BYTE, 0, 0, MPI_COMM_WORLD,
+                       MPI_INFO_NULL, &request);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+    for (iter = 0; iter < iters && rank < 2; iter++) {
+        if (0 == rank) {
+            for (i = 0; i < partitions; i++) {
+                memset(buf + (size_t) i * part_bytes, (i + iter) & 0xff, part_bytes);
+            }
+        }
+
+        MPI_Start(&request);
+
+        if (0 == rank) {
+            for (i = 0; i < nthreads; i++) {
+                pthread_create(&threads[i], NULL, mark_ready, (void *) (intptr_t) i);
+            }
+            for (i = 0; i < nthreads; i++) {
+                pthread_join(threads[i], NULL);
+            }
+        } else {
+            /* check the partitions in reverse order, the last ones arrive last */
+            for (i = partitions - 1; i >= 0; i--) {
+                do {
+                    MPI_Parrived(request, i, &flag);
+                } while (!flag);
+                if (buf[(size_t) i * part_bytes + part_bytes - 1] != (char) ((i + iter) & 0xff)) {
+                    ++errors;
+                }
+            }
+        }
+
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }
+    t = MPI_Wtime() - start;
+
+    if (0 == rank) {
+        printf("%d threads, %d partitions of %d bytes: %.2f us per iteration, %.2f MB/s\n",
+               nthreads, partitions, part_bytes, 1e6 * t / iters,
+               (double) partitions * part_bytes * iters / t / 1e6);
+    } else if (1 == rank && errors) {
+        fprintf(stderr, "%d partitions with wrong data\n", errors);
+    }
+
+    if (rank < 2) {
+        MPI_Request_free(&request);
+    }
+    free(threads);
+    free(buf);
+
+    MPI_Finalize();
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Check that persistent collectives progress outside MPI_Start: every
+ * iteration starts MPI_Allreduce_init, MPI_Bcast_init and MPI_Reduce_init
+ * requests, exchanges with the ring neighbours (which may still be
+ * starting theirs) and only then waits for the collectives. A plan that
+ * runs inside MPI_Start hangs here.
+ *
+ *   mpirun -np 8 ./persistent_overlap [count] [iters]
+ *   mpirun -np 8 --mca coll_tuned_persistent_plans 1 ./persistent_overlap 100000
+ *   mpirun -np 8 --mca coll_tuned_persistent_plans 1 --mca coll_tuned_use_dynamic_rules 1 \
+ *          --mca coll_tuned_allreduce_algorithm 4 --mca coll_tuned_bcast_algorithm 6 \
+ *          --mca coll_tuned_reduce_algorithm 2 ./persistent_overlap
+ *   mpirun -np 8 --map-by ppr:4:node --mca coll_han_persistent_plans 1 ./persistent_overlap
+ */
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[])
+{
+    int rank, size, count = 1000, iters = 10, errors = 0, root;
+    int *sbuf, *abuf, *bbuf, *rbuf, token, left_token;
+    MPI_Request reqs[3];
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        iters = atoi(argv[2]);
+    }
+
+    sbuf = malloc(count * sizeof(int));
+    abuf = malloc(count * sizeof(int));
+    bbuf = malloc(count * sizeof(int));
+    rbuf = malloc(count * sizeof(int));
+
+    root = size / 2;
+    MPI_Allreduce_init(sbuf, abuf, count, MPI_INT, MPI_SUM, MPI_COMM_WORLD, MPI_INFO_NULL, &reqs[0]);
+    MPI_Bcast_init(bbuf, count, MPI_INT, root, MPI_COMM_WORLD, MPI_INFO_NULL, &reqs[1]);
+    MPI_Reduce_init(sbuf, rbuf, count, MPI_INT, MPI_SUM, root, MPI_COMM_WORLD, MPI_INFO_NULL,
+                    &reqs[2]);
+
+    for (int iter = 0; iter < iters; iter++) {
+        for (int i = 0; i < count; i++) {
+            sbuf[i] = rank + i + iter;
+            abuf[i] = rbuf[i] = -1;
+            bbuf[i] = (rank == root) ? i * 3 + iter : -1;
+        }
+
+        MPI_Startall(3, reqs);
+        /* the neighbours only reach their sendrecv once their own starts
+         * returned */
+        token = rank + iter;
+        MPI_Sendrecv(&token, 1, MPI_INT, (rank + 1) % size, 0, &left_token, 1, MPI_INT,
+                     (rank + size - 1) % size, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Waitall(3, reqs, MPI_STATUSES_IGNORE);
+
+        if (left_token != (rank + size - 1) % size + iter) {
+            ++errors;
+        }
+        for (int i = 0; i < count; i++) {
+            int sum = size * (size - 1) / 2 + size * (i + iter);
+
+            if (abuf[i] != sum || bbuf[i] != i * 3 + iter || (rank == root && rbuf[i] != sum)) {
+                fprintf(stderr, "rank %d: iteration %d: wrong element %d\n", rank, iter, i);
+                ++errors;
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        MPI_Request_free(&reqs[i]);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (0 == rank) {
+        printf("%d ranks: %s\n", size, errors ? "FAILED" : "passed");
+    }
+
+    free(sbuf);
+    free(abuf);
+    free(bbuf);
+    free(rbuf);
+    MPI_Finalize();
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Measure MPI_File_write_shared throughput when all processes append
+ * small records to the same file, as done when logging to a shared
+ * file. Each record carries the writer's rank and a sequence number,
+ * which are verified after the run:
+ *
+ *   mpirun -np 8 --mca sharedfp sm ./sharedfp_contention [file] [records] [record size]
+ */
+
+#include <mpi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char *argv[])
+{
+    const char *filename = "sharedfp_contention.out";
+    int rank, size, i, errors = 0, records = 10000, record_size = 64;
+    MPI_Offset file_size, expected;
+    MPI_File fh;
+    int32_t *record;
+    char *data;
+    int *count;
+    double t;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    if (argc > 1) {
+        filename = argv[1];
+    }
+    if (argc > 2) {
+        records = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        record_size = atoi(argv[3]);
+    }
+    if (record_size < (int) (2 * sizeof(int32_t))) {
+        record_size = 2 * sizeof(int32_t);
+    }
+
+    record = malloc(record_size);
+    memset(record, 0, record_size);
+
+    if (0 == rank) {
+        MPI_File_delete(filename, MPI_INFO_NULL);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_CREATE | MPI_MODE_RDWR, MPI_INFO_NULL, &fh);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    t = MPI_Wtime();
+    for (i = 0; i < records; ++i) {
+        record[0] = rank;
+        record[1] = i;
+        MPI_File_write_shared(fh, record, record_size, MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    t = MPI_Wtime() - t;
+
+    MPI_File_get_size(fh, &file_size);
+    expected = (MPI_Offset) records * record_size * size;
+    if (file_size != expected) {
+        fprintf(stderr, "%d: file size %lld, expected %lld\n", rank, (long long) file_size,
+                (long long) expected);
+        ++errors;
+    }
+
+    if (0 == rank) {
+        printf("%d processes, %d records of %d bytes each: %.0f records/s, %.3f usec/record\n",
+               size, records, record_size, (double) records * size / t, t * 1e6 / records);
+
+        /* every record must be in the file exactly once, in order per rank */
+        data = malloc(file_size);
+        count = calloc(size, sizeof(int));
+        MPI_File_read_at(fh, 0, data, (int) file_size, MPI_BYTE, MPI_STATUS_IGNORE);
+        for (MPI_Offset pos = 0; pos + record_size <= file_size; pos += record_size) {
+            memcpy(record, data + pos, 2 * sizeof(int32_t));
+            if (record[0] < 0 || record[0] >= size || record[1] != count[record[0]]) {
+                fprintf(stderr, "bad record at offset %lld: rank %d, sequence %d\n",
+                        (long long) pos, record[0], record[1]);
+                ++errors;
+                break;
+            }
+            count[record[0]]++;
+        }
+        free(count);
+        free(data);
+    }
+
+    MPI_File_close(&fh);
+    if (0 == rank && 0 == errors) {
+        MPI_File_delete(filename, MPI_INFO_NULL);
+    }
+    free(record);
+    MPI_Finalize();
+
+    return errors ? 1 : 0;
+}
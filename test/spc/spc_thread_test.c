@@ -0,0 +1,130 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ *
+ * Check that the SPC counters updated by many threads add up, and that
+ * the latency histograms count every call. Rank 0 sends from several
+ * threads at once, rank 1 receives from as many threads.
+ */
+
+#include "mpi.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_THREADS 8
+#define NUM_MESSAGES 1000
+#define NUM_BUCKETS 32
+
+static void *exchange(void *arg)
+{
+    int tag = (int) (intptr_t) arg, rank, i;
+    char data = 0;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    for (i = 0; i < NUM_MESSAGES; i++) {
+        if (0 == rank) {
+            MPI_Send(&data, 1, MPI_BYTE, 1, tag, MPI_COMM_WORLD);
+        } else {
+            MPI_Recv(&data, 1, MPI_BYTE, 0, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+    }
+
+    return NULL;
+}
+
+static int find_pvar(const char *pvar_name)
+{
+    int i, num, name_len, desc_len, verbosity, bind, var_class, readonly, continuous, atomic;
+    char name[256], description[1024];
+    MPI_Datatype datatype;
+    MPI_T_enum enumtype;
+
+    MPI_T_pvar_get_num(&num);
+    for (i = 0; i < num; i++) {
+        name_len = sizeof(name);
+        desc_len = sizeof(description);
+        if (MPI_SUCCESS != MPI_T_pvar_get_info(i, name, &name_len, &verbosity, &var_class,
+                                               &datatype, &enumtype, description, &desc_len,
+                                               &bind, &readonly, &continuous, &atomic)) {
+            continue;
+        }
+        if (0 == strcmp(name, pvar_name)) {
+            return i;
+        }
+    }
+
+    fprintf(stderr, "ERROR: Couldn't find %s in the MPI_T pvars.\n", pvar_name);
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *counter_names[] = {"runtime_spc_OMPI_SPC_SEND", "runtime_spc_OMPI_SPC_RECV"};
+    long long value, histogram[NUM_BUCKETS], total = 0;
+    pthread_t threads[NUM_THREADS];
+    MPI_T_pvar_handle handle, histogram_handle;
+    MPI_T_pvar_session session;
+    int i, rank, size, provided, count, errors = 0;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    MPI_T_init_thread(MPI_THREAD_MULTIPLE, &provided);
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    if (2 != size || MPI_THREAD_MULTIPLE != provided) {
+        fprintf(stderr, "ERROR: This test should be run with two MPI processes and "
+                        "MPI_THREAD_MULTIPLE.\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    MPI_T_pvar_session_create(&session);
+    MPI_T_pvar_handle_alloc(session, find_pvar(counter_names[rank]), NULL, &handle, &count);
+    MPI_T_pvar_handle_alloc(session, find_pvar("runtime_spc_OMPI_SPC_P2P_LATENCY"), NULL,
+                            &histogram_handle, &count);
+    if (NUM_BUCKETS != count) {
+        fprintf(stderr, "[%d] The histogram has %d buckets instead of %d\n", rank, count,
+                NUM_BUCKETS);
+        MPI_Abort(MPI_COMM_WORLD, MPI_ERR_OTHER);
+    }
+    MPI_T_pvar_start(session, handle);
+    MPI_T_pvar_start(session, histogram_handle);
+
+    for (i = 0; i < NUM_THREADS; i++) {
+        pthread_create(&threads[i], NULL, exchange, (void *) (intptr_t) i);
+    }
+    for (i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    MPI_T_pvar_read(session, handle, &value);
+    MPI_T_pvar_read(session, histogram_handle, histogram);
+    for (i = 0; i < NUM_BUCKETS; i++) {
+        total += histogram[i];
+    }
+
+    printf("[%d] %s: %lld, calls in the latency histogram: %lld\n", rank, counter_names[rank],
+           value, total);
+    if (NUM_THREADS * NUM_MESSAGES != value || NUM_THREADS * NUM_MESSAGES != total) {
+        fprintf(stderr, "[%d] The counters are inaccurate! They should be %d\n", rank,
+                NUM_THREADS * NUM_MESSAGES);
+        errors = 1;
+    }
+
+    MPI_T_pvar_stop(session, handle);
+    MPI_T_pvar_stop(session, histogram_handle);
+    MPI_T_pvar_handle_free(session, &handle);
+    MPI_T_pvar_handle_free(session, &histogram_handle);
+    MPI_T_pvar_session_free(&session);
+    MPI_T_finalize();
+
+    MPI_Finalize();
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
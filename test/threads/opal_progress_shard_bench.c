@@ -0,0 +1,245 @@
+/*
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Threaded ping-pong and message rate through opal_progress(), with and
+ * without progress shards. Each thread owns a channel that stands in for
+ * a BTL: messages are posted to the channel of the peer and are only
+ * delivered when the channel's progress callback runs, under the channel
+ * lock. Without shards every thread polls (and locks) every channel.
+ */
+
+#include "opal_config.h"
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "opal/constants.h"
+#include "opal/mca/threads/mutex.h"
+#include "opal/mca/threads/threads.h"
+#include "opal/runtime/opal.h"
+#include "opal/runtime/opal_progress.h"
+#include "opal/sys/atomic.h"
+#include "support.h"
+
+#define OPAL_TEST_THREAD_COUNT 4
+#define PINGPONG_ITERATIONS    20000
+#define RATE_ITERATIONS        2000
+#define RATE_WINDOW            64
+/* cost of polling an idle channel, in loop iterations */
+#define POLL_COST              64
+
+typedef struct channel_t {
+    opal_mutex_t lock;
+    opal_atomic_int64_t posted;
+    volatile int64_t delivered;
+} channel_t;
+
+static channel_t channels[OPAL_TEST_THREAD_COUNT];
+static opal_atomic_int32_t barrier_count = 0;
+static volatile int32_t barrier_phase = 0;
+
+static int channel_progress(channel_t *channel)
+{
+    volatile int cost = 0;
+    int events = 0;
+
+    opal_mutex_lock(&channel->lock);
+    for (int i = 0; i < POLL_COST; ++i) {
+        ++cost;
+    }
+    if (channel->posted > channel->delivered) {
+        events = (int) (channel->posted - channel->delivered);
+        opal_atomic_wmb();
+        channel->delivered = channel->posted;
+    }
+    opal_mutex_unlock(&channel->lock);
+
+    return events;
+}
+
+#define CHANNEL_CB(n)                           \
+    static int channel_cb_##n(void)             \
+    {                                           \
+        return channel_progress(channels + n);  \
+    }
+
+CHANNEL_CB(0)
+CHANNEL_CB(1)
+CHANNEL_CB(2)
+CHANNEL_CB(3)
+
+static opal_progress_callback_t channel_cbs[OPAL_TEST_THREAD_COUNT] = {
+    channel_cb_0, channel_cb_1, channel_cb_2, channel_cb_3,
+};
+
+static void thread_barrier(void)
+{
+    int32_t phase = barrier_phase;
+
+    if (OPAL_TEST_THREAD_COUNT == opal_atomic_add_fetch_32(&barrier_count, 1)) {
+        barrier_count = 0;
+        opal_atomic_wmb();
+        barrier_phase = phase + 1;
+    } else {
+        while (phase == barrier_phase) {
+            opal_atomic_rmb();
+        }
+    }
+}
+
+static void post(int peer, int64_t count)
+{
+    (void) opal_atomic_fetch_add_64(&channels[peer].posted, count);
+}
+
+static void wait_for(int self, int64_t delivered)
+{
+    while (channels[self].delivered < delivered) {
+        opal_progress();
+    }
+}
+
+static double elapsed(struct timeval *start)
+{
+    struct timeval stop;
+
+    gettimeofday(&stop, NULL);
+    return (double) (stop.tv_sec - start->tv_sec) + (double) (stop.tv_usec - start->tv_usec) * 1e-6;
+}
+
+static double pingpong_time[OPAL_TEST_THREAD_COUNT];
+static double rate_time[OPAL_TEST_THREAD_COUNT];
+
+static void *thread_run(opal_object_t *obj)
+{
+    opal_thread_t *thread = (opal_thread_t *) obj;
+    int self = (int) (intptr_t) thread->t_arg, peer = self ^ 1;
+    int64_t expected = channels[self].delivered;
+    struct timeval start;
+
+    /* ping-pong between pairs of threads */
+    thread_barrier();
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < PINGPONG_ITERATIONS; ++i) {
+        if (0 == (self & 1)) {
+            post(peer, 1);
+            wait_for(self, ++expected);
+        } else {
+            wait_for(self, ++expected);
+            post(peer, 1);
+        }
+    }
+    pingpong_time[self] = elapsed(&start);
+
+    /* message rate: windows of messages in both directions */
+    thread_barrier();
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < RATE_ITERATIONS; ++i) {
+        for (int j = 0; j < RATE_WINDOW; ++j) {
+            post(peer, 1);
+        }
+        expected += RATE_WINDOW;
+        wait_for(self, expected);
+    }
+    rate_time[self] = elapsed(&start);
+    thread_barrier();
+
+    return NULL;
+}
+
+static void run(int shards)
+{
+    opal_thread_t threads[OPAL_TEST_THREAD_COUNT];
+    double pingpong = 0.0, rate = 0.0;
+    int64_t delivered[OPAL_TEST_THREAD_COUNT];
+    int rc;
+
+    /* callbacks are dealt to the shards when they are registered */
+    opal_progress_shards = shards;
+    for (int i = 0; i < OPAL_TEST_THREAD_COUNT; ++i) {
+        rc = opal_progress_register(channel_cbs[i]);
+        test_verify_int(OPAL_SUCCESS, rc);
+    }
+
+    /* with one shard per channel, no two channels share a shard */
+    for (int i = 0; shards >= OPAL_TEST_THREAD_COUNT && i < OPAL_TEST_THREAD_COUNT; ++i) {
+        int shard = opal_progress_callback_shard(channel_cbs[i]);
+
+        test_verify("channel callback has no shard", shard >= 0 && shard < shards);
+        for (int j = 0; j < i; ++j) {
+            test_verify("channels share a shard",
+                        shard != opal_progress_callback_shard(channel_cbs[j]));
+        }
+    }
+
+    for (int i = 0; i < OPAL_TEST_THREAD_COUNT; ++i) {
+        delivered[i] = channels[i].delivered;
+        OBJ_CONSTRUCT(threads + i, opal_thread_t);
+        threads[i].t_run = thread_run;
+        threads[i].t_arg = (void *) (intptr_t) i;
+    }
+
+    for (int i = 0; i < OPAL_TEST_THREAD_COUNT; ++i) {
+        rc = opal_thread_start(threads + i);
+        test_verify_int(OPAL_SUCCESS, rc);
+    }
+
+    for (int i = 0; i < OPAL_TEST_THREAD_COUNT; ++i) {
+        rc = opal_thread_join(threads + i, NULL);
+        test_verify_int(OPAL_SUCCESS, rc);
+        OBJ_DESTRUCT(threads + i);
+
+        test_verify_int64_t(delivered[i] + PINGPONG_ITERATIONS + RATE_ITERATIONS * RATE_WINDOW,
+                            channels[i].delivered);
+        pingpong += pingpong_time[i];
+        rate += (double) (RATE_ITERATIONS * RATE_WINDOW) / rate_time[i];
+    }
+
+    for (int i = 0; i < OPAL_TEST_THREAD_COUNT; ++i) {
+        (void) opal_progress_unregister(channel_cbs[i]);
+    }
+
+    printf("shards %2d: ping-pong %8.3f usec, message rate %12.0f msg/s\n", shards,
+           pingpong * 1e6 / (OPAL_TEST_THREAD_COUNT * PINGPONG_ITERATIONS), rate);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    int rc;
+
+    test_init("opal_progress shards");
+
+    rc = opal_init(&argc, &argv);
+    test_verify_int(OPAL_SUCCESS, rc);
+    if (OPAL_SUCCESS != rc) {
+        test_finalize();
+        exit(1);
+    }
+    opal_set_using_threads(true);
+
+    for (int i = 0; i < OPAL_TEST_THREAD_COUNT; ++i) {
+        OBJ_CONSTRUCT(&channels[i].lock, opal_mutex_t);
+        channels[i].posted = channels[i].delivered = 0;
+    }
+
+    /* every thread polls every channel */
+    run(0);
+    /* each thread polls its own shard and steals when idle */
+    run(OPAL_TEST_THREAD_COUNT);
+
+    for (int i = 0; i < OPAL_TEST_THREAD_COUNT; ++i) {
+        OBJ_DESTRUCT(&channels[i].lock);
+    }
+
+    opal_progress_shards = 0;
+    opal_finalize();
+
+    return test_finalize();
+}